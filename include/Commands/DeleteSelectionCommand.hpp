@@ -4,6 +4,8 @@
 #include "../Core/ICommand.hpp"
 #include "raylib.h"
 #include "../Core/RaylibWrappers.hpp"
+#include "../Core/SlotMap.hpp"
+#include "../Core/SelectionMask.hpp"
 #include <memory>
 
 namespace EpiGimp {
@@ -20,10 +22,11 @@ class Canvas;
 class DeleteSelectionCommand : public ICommand {
 private:
     Canvas* canvas_;                             // Target canvas
-    size_t targetLayerIndex_;                    // Index of the layer that was modified
+    LayerHandle targetLayer_;                    // Layer that was modified
     std::unique_ptr<Image> beforeState_;         // Layer state before the deletion
     std::unique_ptr<Image> afterState_;          // Layer state after the deletion
     Rectangle selectionRect_;                    // The selection rectangle that was deleted
+    SelectionMask selectionMask_;                // The selected pixels, selectionRect_ is their bounds
     std::string description_;                    // Description of the delete action
     
 public:
@@ -4,6 +4,7 @@
 #include "../Core/ICommand.hpp"
 #include "raylib.h"
 #include "../Core/RaylibWrappers.hpp"
+#include "../Core/SlotMap.hpp"
 #include <memory>
 #include <vector>
 
@@ -15,13 +16,14 @@ class Canvas;
 /**
  * @brief Command for drawing operations that can be undone/redone
  * 
- * This command captures the state of the active layer before a drawing action
- * and can restore it for undo operations.
+ * This command captures the state of the layer that is selected when it is created
+ * and can restore it for undo operations. The layer is tracked by handle, so undo
+ * still hits the right layer after the stack has been reordered.
  */
 class DrawCommand : public ICommand {
 private:
     Canvas* canvas_;                             // Target canvas
-    size_t targetLayerIndex_;                    // Index of the layer that was modified
+    LayerHandle targetLayer_;                    // Layer that was modified
     std::unique_ptr<Image> beforeState_;         // Layer state before the action
     std::unique_ptr<Image> afterState_;          // Layer state after the action
     std::string description_;                    // Description of the drawing action
@@ -59,17 +61,17 @@ public:
     
 private:
     /**
-     * @brief Copy the current active layer to an Image
+     * @brief Copy the target layer to an Image
      * @return Unique pointer to the copied image, or nullptr if failed
      */
-    std::unique_ptr<Image> copyActiveLayerToImage() const;
+    std::unique_ptr<Image> copyTargetLayerToImage() const;
     
     /**
-     * @brief Restore the active layer from an Image
+     * @brief Restore the target layer from an Image
      * @param image The image to restore from
      * @return true if restoration was successful, false otherwise
      */
-    bool restoreActiveLayerFromImage(const std::unique_ptr<Image>& image);
+    bool restoreTargetLayerFromImage(const std::unique_ptr<Image>& image);
 };
 
 /**
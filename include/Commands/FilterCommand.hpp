@@ -0,0 +1,70 @@
+#ifndef FILTER_COMMAND_HPP
+#define FILTER_COMMAND_HPP
+
+#include "../Core/ICommand.hpp"
+#include "raylib.h"
+#include "../Core/SlotMap.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace EpiGimp {
+
+// Forward declaration
+class Canvas;
+
+/**
+ * @brief Command for a filter applied to one layer, keeping only the tiles it changed
+ * 
+ * The layer before and after the filter are compared TILE_SIZE tile by tile; tiles that
+ * came out the same (outside the selection, flat areas a sharpen leaves alone) are not
+ * stored. Undo and redo write the stored tiles straight into the layer texture, so a
+ * filter on a small part of a large layer costs that part, not two copies of the layer.
+ */
+class FilterCommand : public ICommand {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+private:
+    struct Tile {
+        Rectangle rect;                          // Texture pixels
+        std::vector<uint8_t> before;             // RGBA8 rows of rect, texture order
+        std::vector<uint8_t> after;
+    };
+
+    Canvas* canvas_;                             // Target canvas
+    LayerHandle targetLayer_;                    // Layer that was filtered
+    std::string description_;
+    std::vector<Tile> tiles_;
+    bool showingAfter_ = true;                   // The layer holds the filtered pixels
+
+    bool writeTiles(bool after);
+
+public:
+    /**
+     * @brief Construct a Filter Command for a layer that already holds the filtered pixels
+     * @param canvas Target canvas
+     * @param layer Layer the filter was applied to
+     * @param description Name of the filter
+     */
+    FilterCommand(Canvas* canvas, LayerHandle layer, const std::string& description);
+    
+    /**
+     * @brief Keep the tiles of region that differ between before and after
+     * @param before, after RGBA8 layer pixels in texture order, the same size
+     * @param region Texture pixels the filter may have touched
+     */
+    void recordChanges(const Image& before, const Image& after, Rectangle region);
+    
+    // ICommand interface
+    bool execute() override;                     // Redo: put the filtered tiles back
+    bool undo() override;
+    std::string getDescription() const override { return description_; }
+    
+    size_t getTileCount() const { return tiles_.size(); }
+    size_t getStoredBytes() const;
+};
+
+} // namespace EpiGimp
+
+#endif // FILTER_COMMAND_HPP
@@ -4,6 +4,8 @@
 #include "../Core/ICommand.hpp"
 #include "raylib.h"
 #include "../Core/RaylibWrappers.hpp"
+#include "../Core/SlotMap.hpp"
+#include "../Core/SelectionMask.hpp"
 #include <memory>
 
 namespace EpiGimp {
@@ -20,10 +22,11 @@ class Canvas;
 class FlipSelectionCommand : public ICommand {
 protected:
     Canvas* canvas_;                             // Target canvas
-    size_t targetLayerIndex_;                    // Index of the layer that was modified
+    LayerHandle targetLayer_;                    // Layer that was modified
     std::unique_ptr<Image> beforeState_;         // Layer state before the flip
     std::unique_ptr<Image> afterState_;          // Layer state after the flip
     Rectangle selectionRect_;                    // The selection rectangle that was flipped
+    SelectionMask selectionMask_;                // The selected pixels before the flip
     std::string description_;                    // Description of the flip action
     
     /**
@@ -10,12 +10,17 @@ namespace EpiGimp {
 
 /**
  * @brief Command for creating a new layer
+ *
+ * All layer commands keep a LayerHandle rather than a stack index, so they still
+ * target the right layer after other commands reorder, insert or remove layers.
  */
 class CreateLayerCommand : public ICommand {
 private:
     LayerManager* layerManager_;
     std::string layerName_;
+    LayerHandle createdLayer_;
     size_t createdLayerIndex_;
+    std::unique_ptr<Layer> removedLayer_;  // Held between undo and redo
     std::string description_;
 
 public:
@@ -33,6 +38,7 @@ public:
 class DeleteLayerCommand : public ICommand {
 private:
     LayerManager* layerManager_;
+    LayerHandle layerHandle_;
     size_t layerIndex_;
     std::unique_ptr<Layer> deletedLayer_;  // Store the deleted layer for undo
     std::string description_;
@@ -52,6 +58,7 @@ public:
 class MoveLayerCommand : public ICommand {
 private:
     LayerManager* layerManager_;
+    LayerHandle layerHandle_;
     size_t fromIndex_;
     size_t toIndex_;
     std::string description_;
@@ -71,7 +78,7 @@ public:
 class ToggleLayerVisibilityCommand : public ICommand {
 private:
     LayerManager* layerManager_;
-    size_t layerIndex_;
+    LayerHandle layerHandle_;
     bool previousVisibility_;
     std::string description_;
 
@@ -90,7 +97,7 @@ public:
 class SetLayerOpacityCommand : public ICommand {
 private:
     LayerManager* layerManager_;
-    size_t layerIndex_;
+    LayerHandle layerHandle_;
     float newOpacity_;
     float previousOpacity_;
     std::string description_;
@@ -110,8 +117,10 @@ public:
 class DuplicateLayerCommand : public ICommand {
 private:
     LayerManager* layerManager_;
-    size_t sourceLayerIndex_;
+    LayerHandle sourceLayer_;
+    LayerHandle createdLayer_;
     size_t createdLayerIndex_;
+    std::unique_ptr<Layer> removedLayer_;  // Held between undo and redo
     std::string description_;
 
 public:
@@ -14,6 +14,8 @@ namespace EpiGimp {
 
 // Forward declarations
 class SimpleLayerPanel;
+class Autosaver;
+class ControlServer;
 
 // Application configuration
 struct AppConfig {
@@ -22,6 +24,12 @@ struct AppConfig {
     std::string windowTitle = "EpiGimp - Modern Paint Interface";
     int targetFPS = 60;
     std::string initialImagePath;
+    std::string autosaveDirectory;      // Empty for the per-user state directory
+    float autosaveInterval = 30.0f;     // Seconds, 0 disables autosave
+    int pngCompressionLevel = 6;        // zlib level for PNG export, 0-9
+    std::string saveExtension = ".png"; // Format offered first in the save dialog
+    bool rawTileRle = true;             // Run-length encode .ert tiles
+    std::string controlSocketPath;      // JSON-RPC control socket, empty disables it
 };
 
 // Main application class
@@ -36,6 +44,8 @@ private:
     std::unique_ptr<IInputHandler> inputHandler_;
     std::unique_ptr<HistoryManager> historyManager_;
     std::unique_ptr<SimpleLayerPanel> layerPanel_;
+    std::unique_ptr<Autosaver> autosaver_;
+    std::unique_ptr<ControlServer> controlServer_;
     
     AppConfig config_;
     bool running_;
@@ -70,6 +80,8 @@ private:
     void handleEvents();
     void setupEventHandlers();
     void createComponents();
+    void setupAutosave();
+    void setupControlServer();
     
     void onLoadImageRequest();
     void onImageSaveRequest(const ImageSaveRequestEvent& event);
@@ -0,0 +1,70 @@
+//Immutable copy of the document for off-thread consumers
+#ifndef DOCUMENT_SNAPSHOT_HPP
+#define DOCUMENT_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+// Read-only CPU pixels shared between snapshots; the image is unloaded with the last reference
+using SharedPixels = std::shared_ptr<const Image>;
+
+/**
+ * @brief Take ownership of an image so several snapshots can share it
+ */
+SharedPixels makeSharedPixels(Image image);
+
+struct LayerSnapshot {
+    SharedPixels pixels;          // RGBA8, top-down
+    bool flippedVertical = false;
+    bool flippedHorizontal = false;
+    bool visible = true;
+    std::string name;
+    uint64_t id = 0;              // Stable identity across snapshots, 0 if unknown
+    
+    explicit LayerSnapshot(SharedPixels layerPixels = nullptr) : pixels(std::move(layerPixels)) {}
+};
+
+/**
+ * @brief Frozen view of the layer stack
+ *
+ * Pixel buffers are never written once they are in a snapshot, so a snapshot can be
+ * handed to a worker thread while the canvas keeps changing. Layers that did not change
+ * between two snapshots share the same buffer.
+ */
+class DocumentSnapshot {
+private:
+    int width_;
+    int height_;
+    SharedPixels background_;              // Optional, drawn below every layer
+    bool backgroundVisible_;
+    std::vector<LayerSnapshot> layers_;    // Bottom to top
+
+public:
+    DocumentSnapshot(int width = 0, int height = 0) : width_(width), height_(height), backgroundVisible_(true) {}
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    bool isEmpty() const { return !background_ && layers_.empty(); }
+    bool hasVisibleContent() const;
+
+    void setBackground(SharedPixels pixels, bool visible = true) { background_ = std::move(pixels); backgroundVisible_ = visible; }
+    const SharedPixels& getBackground() const { return background_; }
+    bool isBackgroundVisible() const { return background_ && backgroundVisible_; }
+    void addLayer(LayerSnapshot layer) { layers_.push_back(std::move(layer)); }
+    const std::vector<LayerSnapshot>& getLayers() const { return layers_; }
+
+    /**
+     * @brief Flatten the visible parts of the snapshot with source-over alpha blending
+     * @return RGBA8 image owned by the caller, Image{} if nothing is visible
+     */
+    Image composite() const;
+};
+
+} // namespace EpiGimp
+
+#endif // DOCUMENT_SNAPSHOT_HPP
@@ -2,13 +2,15 @@
 #ifndef EVENT_SYSTEM_HPP
 #define EVENT_SYSTEM_HPP
 
+#include <cstdint>
 #include <functional>
-#include <unordered_map>
 #include <vector>
 #include <memory>
-#include <typeindex>
-#include <any>
+#include <thread>
+#include <type_traits>
 #include <string>
+#include "raylib.h"
+#include "MpscQueue.hpp"
 
 namespace EpiGimp {
 
@@ -27,6 +29,15 @@ public:
     explicit ImageLoadedEvent(std::string path) : filePath(std::move(path)) {}
 };
 
+class ImageLoadProgressEvent : public Event {
+public:
+    std::string filePath;
+    std::string stage;
+    float progress;   // 0..1
+    ImageLoadProgressEvent(std::string path, std::string stageName, float value)
+        : filePath(std::move(path)), stage(std::move(stageName)), progress(value) {}
+};
+
 class ImageSaveRequestEvent : public Event {
 public:
     std::string filePath;
@@ -74,32 +85,181 @@ public:
     explicit ErrorEvent(std::string msg) : message(std::move(msg)) {}
 };
 
+/**
+ * @brief Per-type options for queued delivery
+ *
+ * Coalescing types only deliver the newest of their queued events per dispatch:
+ * a colour slider dragged across a hundred values in one frame is one event.
+ */
+template<typename EventType>
+struct EventTraits {
+    static constexpr bool coalesce = false;
+};
+
+template<> struct EventTraits<ColorChangedEvent> { static constexpr bool coalesce = true; };
+template<> struct EventTraits<PrimaryColorChangedEvent> { static constexpr bool coalesce = true; };
+template<> struct EventTraits<SecondaryColorChangedEvent> { static constexpr bool coalesce = true; };
+
 // Event handler interface
 template<typename EventType>
 using EventHandler = std::function<void(const EventType&)>;
 
-// Event dispatcher
-class EventDispatcher {
+namespace detail {
+
+size_t nextEventTypeId();
+
+/**
+ * @brief Dense index of EventType, fixed the first time the type is used
+ *
+ * Channels live in a vector at this index, so publish<T> never hashes.
+ */
+template<typename EventType>
+size_t eventTypeId() {
+    static const size_t id = nextEventTypeId();
+    return id;
+}
+
+// One heap-held callable and a plain function pointer that knows its type: a single
+// indirect call per handler, no std::function layers
+struct HandlerSlot {
+    uint64_t id;
+    std::unique_ptr<void, void(*)(void*)> target;
+    void (*invoke)(void* target, const Event& event);
+    bool active;
+};
+
+template<typename EventType, typename Handler>
+HandlerSlot makeHandlerSlot(Handler&& handler) {
+    using Stored = std::decay_t<Handler>;
+    return HandlerSlot{
+        0,
+        std::unique_ptr<void, void(*)(void*)>(new Stored(std::forward<Handler>(handler)),
+                                              [](void* target) { delete static_cast<Stored*>(target); }),
+        [](void* target, const Event& event) { (*static_cast<Stored*>(target))(static_cast<const EventType&>(event)); },
+        true
+    };
+}
+
+struct HandlerChannel {
+    std::vector<HandlerSlot> slots;
+    std::vector<HandlerSlot> added;   // Subscribed while publishing, joins afterwards
+};
+
+struct HandlerRegistry {
+    std::vector<std::unique_ptr<HandlerChannel>> channels;   // By eventTypeId, null until subscribed
+    uint64_t nextId = 1;
+    int publishing = 0;               // Nesting depth of publish calls
+    bool needsCompaction = false;
+
+    HandlerChannel* find(size_t type) const { return type < channels.size() ? channels[type].get() : nullptr; }
+    HandlerChannel& channel(size_t type);
+    uint64_t add(size_t type, HandlerSlot slot);   // Returns the id it assigned
+    void unsubscribe(size_t type, uint64_t id);
+    void compact();
+};
+
+} // namespace detail
+
+/**
+ * @brief Unsubscribes its handler when destroyed
+ *
+ * Safe to outlive the dispatcher. Owners that capture this in a handler keep the
+ * tokens as members, so the handler never runs on a destroyed object.
+ */
+class Subscription {
 private:
-    std::unordered_map<std::type_index, std::vector<std::function<void(const Event&)>>> handlers_;
+    std::weak_ptr<detail::HandlerRegistry> registry_;
+    size_t type_;
+    uint64_t id_;
 
 public:
+    Subscription() : type_(0), id_(0) {}
+    Subscription(std::weak_ptr<detail::HandlerRegistry> registry, size_t type, uint64_t id)
+        : registry_(std::move(registry)), type_(type), id_(id) {}
+    ~Subscription() { reset(); }
+
+    Subscription(const Subscription&) = delete;
+    Subscription& operator=(const Subscription&) = delete;
+
+    Subscription(Subscription&& other) noexcept;
+    Subscription& operator=(Subscription&& other) noexcept;
+
+    void reset();
+    bool isActive() const { return id_ != 0 && !registry_.expired(); }
+};
+
+/**
+ * @brief Typed publish/subscribe hub
+ *
+ * publish() and emit() run the handlers right away on the calling thread. post() may be
+ * called from any thread: the event goes into a lock-free queue and is delivered by
+ * dispatchQueued(), which the delivery thread (the one that created the dispatcher, the
+ * UI thread) calls once per frame. Subscribing, unsubscribing and publishing belong to
+ * the delivery thread; handlers may subscribe and unsubscribe while being called.
+ */
+class EventDispatcher {
+private:
+    struct QueuedEvent {
+        const void* coalesceKey = nullptr;   // Shared by every event of a coalescing type
+        virtual ~QueuedEvent() = default;
+        virtual void deliver(EventDispatcher& dispatcher) = 0;
+    };
+
     template<typename EventType>
-    void subscribe(EventHandler<EventType> handler) {
-        auto wrapper = [handler](const Event& event) {
-            handler(static_cast<const EventType&>(event));
-        };
-        handlers_[std::type_index(typeid(EventType))].push_back(wrapper);
+    struct QueuedEventOf : QueuedEvent {
+        EventType event;
+        explicit QueuedEventOf(EventType e) : event(std::move(e)) {
+            static const char key = 0;
+            if (EventTraits<EventType>::coalesce)
+                coalesceKey = &key;
+        }
+        void deliver(EventDispatcher& dispatcher) override { dispatcher.publish(event); }
+    };
+
+    std::shared_ptr<detail::HandlerRegistry> registry_;
+    MpscQueue<std::unique_ptr<QueuedEvent>> queue_;
+    std::thread::id deliveryThread_;
+
+public:
+    EventDispatcher();
+
+    EventDispatcher(const EventDispatcher&) = delete;
+    EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+    /**
+     * @brief Register a handler until the returned token is destroyed
+     */
+    template<typename EventType, typename Handler>
+    [[nodiscard]] Subscription subscribeScoped(Handler&& handler) {
+        const size_t type = detail::eventTypeId<EventType>();
+        const uint64_t id = registry_->add(type, detail::makeHandlerSlot<EventType>(std::forward<Handler>(handler)));
+        return Subscription(registry_, type, id);
+    }
+
+    /**
+     * @brief Register a handler for the dispatcher's whole lifetime
+     */
+    template<typename EventType, typename Handler>
+    void subscribe(Handler&& handler) {
+        registry_->add(detail::eventTypeId<EventType>(), detail::makeHandlerSlot<EventType>(std::forward<Handler>(handler)));
     }
 
     template<typename EventType>
     void publish(const EventType& event) {
-        auto it = handlers_.find(std::type_index(typeid(EventType)));
-        if (it != handlers_.end()) {
-            for (const auto& handler : it->second) {
-                handler(event);
-            }
+        detail::HandlerChannel* channel = registry_->find(detail::eventTypeId<EventType>());
+        if (!channel || channel->slots.empty())
+            return;
+
+        // Handlers subscribed meanwhile wait in added, unsubscribed ones are only flagged,
+        // so the slots stay put while they run
+        registry_->publishing++;
+        auto& slots = channel->slots;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].active)
+                slots[i].invoke(slots[i].target.get(), event);
         }
+        if (--registry_->publishing == 0 && registry_->needsCompaction)
+            registry_->compact();
     }
 
     template<typename EventType, typename... Args>
@@ -107,6 +267,26 @@ public:
         EventType event(std::forward<Args>(args)...);
         publish(event);
     }
+
+    /**
+     * @brief Queue an event for the next dispatchQueued(); any thread
+     */
+    template<typename EventType>
+    void post(EventType event) {
+        queue_.push(std::make_unique<QueuedEventOf<EventType>>(std::move(event)));
+    }
+
+    /**
+     * @brief Deliver queued events in posting order; delivery thread only
+     * @param maxEvents Events taken off the queue at most, coalesced ones included
+     * @return Number of events delivered
+     */
+    size_t dispatchQueued(size_t maxEvents = static_cast<size_t>(-1));
+
+    size_t getQueuedCount() const { return queue_.size(); }
+
+    // Hand delivery over to the calling thread, e.g. a dispatcher built before the UI thread
+    void bindToCurrentThread() { deliveryThread_ = std::this_thread::get_id(); }
 };
 
 } // namespace EpiGimp
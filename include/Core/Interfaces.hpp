@@ -23,7 +23,11 @@ enum class DrawingTool {
     Dodge,
     Select,
     Mirror,
-    Eyedropper
+    Eyedropper,
+    Fill,
+    MagicWand,
+    Lasso,
+    Polygon
 };
 
 class IUIComponent {
@@ -0,0 +1,133 @@
+//Work-stealing thread pool shared by every CPU-heavy subsystem
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace EpiGimp {
+
+/**
+ * @brief One pool of worker threads for encoding, compositing, filters and thumbnails
+ *
+ * Each worker owns a deque: jobs it submits go to the back and it pops from the back,
+ * idle workers steal from the front of the others. Jobs submitted from outside the pool
+ * (the UI thread) go to a shared queue. A job can depend on other jobs and only runs
+ * once they have finished.
+ *
+ * Workers that wait (for a handle or a nested parallelFor) run other jobs meanwhile, so
+ * nesting cannot deadlock. Threads outside the pool never run foreign jobs while they
+ * wait, so the UI thread is never stuck behind a long thumbnail decode.
+ *
+ * raylib and GL calls must stay on the main thread: jobs hand such work back with
+ * postToMain(), and the application runs it once per frame.
+ */
+class JobSystem {
+public:
+    using Task = std::function<void()>;
+    using RangeTask = std::function<void(size_t begin, size_t end)>;
+
+private:
+    struct Job {
+        Task task;
+        std::atomic<int> pending{1};                  // Unfinished dependencies, +1 until submitted
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;                            // Guarded by mutex
+        std::vector<std::shared_ptr<Job>> dependents; // Guarded by mutex
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Job>> jobs;        // Guarded by mutex: owner uses the back, thieves the front
+    };
+
+public:
+    class Handle {
+    private:
+        std::shared_ptr<Job> job_;
+        friend class JobSystem;
+
+    public:
+        Handle() = default;
+        bool isValid() const { return static_cast<bool>(job_); }
+        bool isDone() const;
+    };
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wakeWorkers_;
+    bool stopping_;                                   // Guarded by mutex_
+    std::deque<std::shared_ptr<Job>> injected_;       // Guarded by mutex_: jobs from outside the pool
+    std::atomic<size_t> queued_;                      // Jobs waiting in any queue
+
+    std::mutex mainMutex_;
+    std::deque<Task> mainTasks_;                      // Guarded by mainMutex_
+
+    void workerLoop(size_t index);
+    void schedule(std::shared_ptr<Job> job);
+    bool runOne();                                    // Run a queued job on this worker, false if none
+    std::shared_ptr<Job> take(size_t index);
+    void run(const std::shared_ptr<Job>& job);
+    bool isWorkerThread() const;
+
+public:
+    /**
+     * @param workers Pool threads, 0 for one less than the number of cores (the caller of
+     *        parallelFor is the extra one)
+     */
+    explicit JobSystem(unsigned workers = 0);
+    ~JobSystem();                                     // Runs what is queued, then joins
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief The process-wide pool every subsystem shares
+     */
+    static JobSystem& shared();
+
+    unsigned getWorkerCount() const { return static_cast<unsigned>(threads_.size()); }
+    unsigned getConcurrency() const { return getWorkerCount() + 1; }   // Workers plus the caller
+
+    /**
+     * @brief Queue a job to run once every dependency has finished
+     */
+    Handle submit(Task task, const std::vector<Handle>& dependencies = {});
+
+    void wait(const Handle& handle);
+
+    /**
+     * @brief Run body over [0, count) in chunks of grain, on the caller and the pool
+     * @param maxThreads Upper bound on threads used, caller included (0 = all)
+     *
+     * Returns once every chunk is done. Chunks are claimed in order from a shared counter,
+     * so uneven chunks balance themselves. If body throws, chunks not yet started are
+     * skipped and the first exception is rethrown here once no thread is still in body.
+     */
+    void parallelFor(size_t count, const RangeTask& body, size_t grain = 1, unsigned maxThreads = 0);
+
+    /**
+     * @brief Queue work for the main thread (texture uploads, UI state); any thread
+     */
+    void postToMain(Task task);
+
+    /**
+     * @brief Run queued main-thread work; call once per frame from the main thread
+     * @return Number of tasks run
+     */
+    size_t runMainThreadTasks(size_t maxTasks = static_cast<size_t>(-1));
+};
+
+} // namespace EpiGimp
+
+#endif // JOB_SYSTEM_HPP
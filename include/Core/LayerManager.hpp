@@ -7,6 +7,7 @@
 #include <optional>
 #include "Layer.hpp"
 #include "EventSystem.hpp"
+#include "SlotMap.hpp"
 
 namespace EpiGimp {
 
@@ -14,36 +15,51 @@ namespace EpiGimp {
  * @brief Events for layer system
  */
 struct LayerCreatedEvent : public Event {
+    LayerHandle layerHandle;
     size_t layerIndex;
     std::string layerName;
 };
 
 struct LayerDeletedEvent : public Event {
+    LayerHandle layerHandle;
     size_t layerIndex;
     std::string layerName;
 };
 
 struct LayerVisibilityChangedEvent : public Event {
+    LayerHandle layerHandle;
     size_t layerIndex;
     bool visible;
 };
 
 struct LayerReorderedEvent : public Event {
+    LayerHandle layerHandle;
     size_t fromIndex;
     size_t toIndex;
 };
 
 struct ActiveLayerChangedEvent : public Event {
+    LayerHandle newHandle;
     size_t oldIndex;
     size_t newIndex;
 };
 
 /**
  * @brief Manages a collection of layers for the canvas
+ *
+ * Layers live in a slot map and are addressed either by their position in the
+ * stack or by a LayerHandle. Handles survive reorders and detach/reattach, so
+ * commands can keep referring to the same layer for their whole lifetime.
  */
 class LayerManager {
 private:
-    std::vector<std::unique_ptr<Layer>> layers_;
+    struct LayerSlot {
+        std::unique_ptr<Layer> layer;    // Null while the layer is detached
+        size_t position;                 // Index into order_ while attached
+    };
+
+    SlotMap<LayerSlot, LayerHandleTag> slots_;
+    std::vector<LayerHandle> order_;     // Stack order, bottom to top
     size_t activeLayerIndex_;
     EventDispatcher* eventDispatcher_;
     int canvasWidth_;
@@ -67,9 +83,33 @@ public:
     const Layer* getLayer(size_t index) const;
     Layer* getActiveLayer();
     const Layer* getActiveLayer() const;
-    size_t getLayerCount() const { return layers_.size(); }
+    size_t getLayerCount() const { return order_.size(); }
     size_t getActiveLayerIndex() const { return activeLayerIndex_; }
 
+    /**
+     * @brief Handle based access, stale or detached handles resolve to nullptr / -1
+     */
+    LayerHandle getLayerHandle(size_t index) const;
+    LayerHandle getActiveLayerHandle() const { return getLayerHandle(activeLayerIndex_); }
+    int getLayerIndex(LayerHandle handle) const;
+    Layer* getLayer(LayerHandle handle);
+    const Layer* getLayer(LayerHandle handle) const;
+
+    /**
+     * @brief Remove a layer from the stack while keeping its handle reserved
+     *
+     * Used by undoable commands: the returned layer can later be put back with
+     * reattachLayer() under the same handle, so older history entries that refer
+     * to it keep working.
+     * @return The detached layer, or nullptr if the handle is invalid or it is the last layer
+     */
+    std::unique_ptr<Layer> detachLayer(LayerHandle handle);
+
+    /**
+     * @brief Reinsert a previously detached layer at the given stack position
+     */
+    bool reattachLayer(LayerHandle handle, std::unique_ptr<Layer> layer, size_t index);
+
     bool setActiveLayer(size_t index);
     
     bool setLayerVisibility(size_t index, bool visible);
@@ -87,8 +127,11 @@ public:
 private:
     void ensureDefaultLayer();
     bool isValidIndex(size_t index) const;
+    void reindexFrom(size_t index);
+    void insertAt(size_t index, LayerHandle handle);
+    void removeAt(size_t index);
     void notifyLayerCreated(size_t index);
-    void notifyLayerDeleted(size_t index, const std::string& name);
+    void notifyLayerDeleted(LayerHandle handle, size_t index, const std::string& name);
     void notifyLayerVisibilityChanged(size_t index, bool visible);
     void notifyLayerReordered(size_t fromIndex, size_t toIndex);
     void notifyActiveLayerChanged(size_t oldIndex, size_t newIndex);
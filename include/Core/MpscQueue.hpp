@@ -0,0 +1,74 @@
+//Lock-free multi-producer single-consumer queue
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace EpiGimp {
+
+/**
+ * @brief Unbounded queue any number of threads push to and one thread pops from
+ *
+ * A linked list with a dummy node (Vyukov's MPSC queue): push is a single atomic
+ * exchange and never waits, pop only touches the consumer end. A pop racing a push
+ * that has swapped the head but not linked its node yet sees the queue as empty;
+ * the element shows up on the next pop.
+ */
+template<typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    std::atomic<Node*> head_;      // Last pushed node, producers only
+    Node* tail_;                   // Dummy in front of the next element, consumer only
+    std::atomic<size_t> size_;
+
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load()), size_(0) {}
+
+    ~MpscQueue() {
+        while (tail_) {
+            Node* next = tail_->next.load(std::memory_order_relaxed);
+            delete tail_;
+            tail_ = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node();
+        node->value.emplace(std::move(value));
+        size_.fetch_add(1, std::memory_order_relaxed);
+        Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer thread only
+    bool pop(T& out) {
+        Node* next = tail_->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        out = std::move(*next->value);
+        next->value.reset();   // next becomes the new dummy
+        delete tail_;
+        tail_ = next;
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate while producers are pushing
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+};
+
+} // namespace EpiGimp
+
+#endif // MPSC_QUEUE_HPP
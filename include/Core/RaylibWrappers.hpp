@@ -8,7 +8,11 @@
 #include <filesystem>
 #include <algorithm>
 #include <vector>
+#include <cstdint>
 #include "raylib.h"
+#include "../Utils/PngWriter.hpp"
+#include "../Utils/QoiCodec.hpp"
+#include "../Utils/RawTileFile.hpp"
 
 namespace EpiGimp {
 
@@ -54,6 +58,12 @@ public:
     explicit operator bool() const { return isValid(); }
 };
 
+// Format-specific settings for ImageResource::exportToFile
+struct ExportOptions {
+    int pngCompressionLevel = PngWriter::DEFAULT_COMPRESSION_LEVEL;   // zlib level, 0-9
+    bool rawTileRle = true;                                           // Run-length encode .ert tiles when smaller
+};
+
 class ImageResource {
 private:
     std::unique_ptr<Image, void(*)(Image*)> image_;
@@ -68,8 +78,17 @@ public:
             delete i;
         }) {}
 
+    /**
+     * @brief Decode any supported file; .qoi and .ert use the in-tree codecs, PNG and BMP
+     *        the streaming decoder, the rest raylib
+     * @param maxWidth, maxHeight Shrink to fit, keeping the aspect ratio (0 = full size).
+     *        Streamed files are shrunk while decoding and never exist at full size.
+     * @return Image owned by the caller, Image{} on failure
+     */
+    static Image loadFile(const std::string& path, int maxWidth = 0, int maxHeight = 0);
+
     static std::optional<ImageResource> fromFile(const std::string& path) {
-        Image img = LoadImage(path.c_str());
+        Image img = loadFile(path);
         if (!img.data)
             return std::nullopt;
         return ImageResource(img);
@@ -98,7 +117,7 @@ public:
 
     void resize(int width, int height);
     bool exportToFile(const std::string& path) const;
-    bool exportToFile(const std::string& path, std::string& actualPath) const;
+    bool exportToFile(const std::string& path, std::string& actualPath, const ExportOptions& options = ExportOptions{}) const;
 
 private:
     std::string validateAndFixExtension(const std::string& path) const;
@@ -128,9 +147,10 @@ public:
 class RenderTextureResource {
 private:
     std::unique_ptr<RenderTexture2D, void(*)(RenderTexture2D*)> renderTexture_;
+    mutable uint64_t revision_;   // Unique across all render textures, changes on every write
 
 public:
-    RenderTextureResource() : renderTexture_(nullptr, [](RenderTexture2D*){}) {}
+    RenderTextureResource() : renderTexture_(nullptr, [](RenderTexture2D*){}), revision_(0) {}
     explicit RenderTextureResource(int width, int height);
 
     RenderTextureResource(const RenderTextureResource&) = delete;
@@ -150,6 +170,15 @@ public:
     void beginDrawing() const;
     void endDrawing() const;
     void clear(Color color = BLANK) const;
+
+    // Read back the texture once queued UploadScheduler regions have landed; rows come
+    // back bottom-up like LoadImageFromTexture
+    Image readPixels() const;
+    
+    // Writes through beginDrawing()/clear() bump the revision automatically,
+    // direct uploads (UpdateTexture) must call markModified() themselves
+    void markModified() const;
+    uint64_t getRevision() const { return revision_; }
 };
 
 } // namespace EpiGimp
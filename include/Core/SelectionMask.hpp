@@ -0,0 +1,142 @@
+//Tiled 8-bit selection coverage
+#ifndef SELECTION_MASK_HPP
+#define SELECTION_MASK_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+// How a new shape combines with the current selection
+enum class SelectionMode {
+    Replace,
+    Add,
+    Subtract,
+    Intersect
+};
+
+/**
+ * @brief Per-pixel selection coverage (0 = outside, 255 = fully selected)
+ *
+ * Stored in 64x64 tiles. A tile that holds one value everywhere (the common case: far
+ * outside or deep inside the selection) keeps only that value, so a rectangle or a
+ * select-all costs a handful of bytes plus its edge tiles. Boolean operations decide
+ * whole tiles at once when either side is uniform and run 16 pixels per step with SSE2
+ * otherwise. Pixel operations clip through forEachRun(), which never visits the inside
+ * of an empty tile.
+ *
+ * Coordinates are image pixels, top-down.
+ */
+class SelectionMask {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    // One row segment: values points at the coverage of x0..x1, or is nullptr when the
+    // whole segment has the coverage uniform
+    using RunCallback = std::function<void(int y, int x0, int x1, const uint8_t* values, uint8_t uniform)>;
+
+    // Writes the coverage of one tile's area (width x height at x0, y0) into values, TILE_SIZE per row
+    using TileGenerator = std::function<void(int x0, int y0, int width, int height, uint8_t* values)>;
+
+private:
+    struct Tile {
+        uint8_t value = 0;               // Coverage of the whole tile while pixels is empty
+        std::vector<uint8_t> pixels;     // TILE_SIZE * TILE_SIZE, row-major, once the tile varies
+    };
+
+    int width_;
+    int height_;
+    int tilesX_;
+    int tilesY_;
+    std::vector<Tile> tiles_;
+    mutable std::vector<Vector2> outline_;   // Marching-squares segments, two points each
+    mutable bool outlineValid_ = false;
+
+    Tile* tileAt(int tx, int ty) { return &tiles_[static_cast<size_t>(ty) * tilesX_ + tx]; }
+    const Tile* tileAt(int tx, int ty) const { return &tiles_[static_cast<size_t>(ty) * tilesX_ + tx]; }
+    bool uniformValue(int tx, int ty, uint8_t& value) const;   // Out of range counts as empty
+    void materialize(Tile& tile);
+    void collapse(Tile& tile, int tx, int ty);
+    void buildOutline() const;
+    void restoreRuns(Image& edited, const Image& original, Rectangle region, Rectangle area, bool bottomUp) const;
+
+public:
+    explicit SelectionMask(int width = 0, int height = 0);
+
+    static SelectionMask fromRect(int width, int height, Rectangle rect);
+
+    /**
+     * @brief Build a mask tile by tile on the shared job system
+     *
+     * generate runs concurrently for different tiles, so it must only read shared state.
+     * Tiles that come out uniform keep no pixel storage.
+     */
+    static SelectionMask fromTiles(int width, int height, const TileGenerator& generate);
+
+    /**
+     * @brief Same region with rows counted from the bottom, for texture-order pixel buffers
+     */
+    static Rectangle toBottomUp(Rectangle region, int height);
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    bool isEmpty() const;
+    bool isRectangle() const;            // Non-empty and fully selected exactly on its bounds
+    Rectangle getBounds() const;         // Smallest rectangle holding every selected pixel, zero if empty
+    uint8_t at(int x, int y) const;      // 0 outside the image
+    size_t getStoredTileCount() const;   // Tiles that keep per-pixel data
+
+    void clear() { fill(0); }
+    void fill(uint8_t value);
+    void fillRect(Rectangle rect, uint8_t value);
+    void setSpan(int y, int x0, int x1, uint8_t value);   // Inclusive, clipped; call compact() after a batch
+    void setRegion(Rectangle region, const uint8_t* values, int stride);
+    void compact();                      // Collapse tiles that became uniform back to one value
+
+    void combine(const SelectionMask& other, SelectionMode mode);   // Masks must have the same size
+    void invert();
+
+    /**
+     * @brief Visit the coverage of region row by row, one segment per tile or uniform stretch
+     * @param skipEmpty Leave out segments with no coverage
+     */
+    void forEachRun(Rectangle region, bool skipEmpty, const RunCallback& run) const;
+
+    /**
+     * @brief Scale a coverage buffer of the mask's size by the selection, inside region
+     * @param bottomUp Buffer rows are in texture order
+     */
+    void clipCoverage(uint8_t* coverage, int stride, Rectangle region, bool bottomUp) const;
+
+    /**
+     * @brief Blend edited back toward original wherever the selection is not full, inside region
+     * @param edited RGBA8, same size as the mask
+     * @param original RGBA8, same size as the mask
+     */
+    void restoreOutside(Image& edited, const Image& original, Rectangle region, bool bottomUp) const;
+
+    /**
+     * @brief Same as restoreOutside for two RGBA8 images that only hold region
+     * @param region Whole pixels inside the mask; the images are region-sized
+     */
+    void restoreOutsideRegion(Image& edited, const Image& original, Rectangle region, bool bottomUp) const;
+
+    /**
+     * @brief Fade selected pixels of an RGBA8 image toward transparent by their coverage
+     */
+    void clearCovered(Image& target, bool bottomUp) const;
+
+    /**
+     * @brief Outline between selected (>= 128) and unselected pixels, in image coordinates
+     *
+     * Pairs of points, one pair per segment. Computed on first use after a change, and
+     * only around tiles where the selection actually changes.
+     */
+    const std::vector<Vector2>& getOutline() const;
+};
+
+} // namespace EpiGimp
+
+#endif // SELECTION_MASK_HPP
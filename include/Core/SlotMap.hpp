@@ -0,0 +1,160 @@
+//Generational slot map for stable object handles
+#ifndef SLOT_MAP_HPP
+#define SLOT_MAP_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace EpiGimp {
+
+/**
+ * @brief Generational handle into a SlotMap
+ *
+ * A handle stays valid until the object it refers to is erased. Erasing bumps the
+ * slot generation, so any copy of the old handle is detected as stale instead of
+ * silently aliasing whatever object reuses the slot later.
+ *
+ * @tparam Tag Empty tag type that keeps handles of unrelated maps from mixing
+ */
+template<typename Tag>
+struct GenerationalHandle {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isNull() const { return index == INVALID_INDEX; }
+    explicit operator bool() const { return !isNull(); }
+
+    bool operator==(const GenerationalHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const GenerationalHandle& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Dense-free-list slot map with O(1) insert, erase and lookup
+ *
+ * @tparam T Stored value type (may be move-only)
+ * @tparam Tag Handle tag type
+ */
+template<typename T, typename Tag>
+class SlotMap {
+public:
+    using Handle = GenerationalHandle<Tag>;
+
+private:
+    struct Slot {
+        std::optional<T> value;
+        uint32_t generation = 1;   // Generation 0 is never handed out
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeList_;
+    size_t size_ = 0;
+
+public:
+    SlotMap() = default;
+
+    Handle insert(T value)
+    {
+        uint32_t index;
+        if (!freeList_.empty()) {
+            index = freeList_.back();
+            freeList_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+
+        Slot& slot = slots_[index];
+        slot.value.emplace(std::move(value));
+        ++size_;
+        return Handle{index, slot.generation};
+    }
+
+    bool erase(Handle handle)
+    {
+        return take(handle).has_value();
+    }
+
+    /**
+     * @brief Remove the value and hand it back to the caller
+     * @return The removed value, or nullopt if the handle was stale
+     */
+    std::optional<T> take(Handle handle)
+    {
+        if (!contains(handle))
+            return std::nullopt;
+
+        Slot& slot = slots_[handle.index];
+        std::optional<T> removed(std::move(slot.value));
+        slot.value.reset();
+        ++slot.generation;
+        if (slot.generation == 0)
+            slot.generation = 1;
+        freeList_.push_back(handle.index);
+        --size_;
+        return removed;
+    }
+
+    bool contains(Handle handle) const
+    {
+        return !handle.isNull() && handle.index < slots_.size() &&
+               slots_[handle.index].generation == handle.generation &&
+               slots_[handle.index].value.has_value();
+    }
+
+    T* get(Handle handle)
+    {
+        return contains(handle) ? &*slots_[handle.index].value : nullptr;
+    }
+
+    const T* get(Handle handle) const
+    {
+        return contains(handle) ? &*slots_[handle.index].value : nullptr;
+    }
+
+    void clear()
+    {
+        for (uint32_t i = 0; i < slots_.size(); ++i) {
+            if (slots_[i].value.has_value()) {
+                slots_[i].value.reset();
+                ++slots_[i].generation;
+                if (slots_[i].generation == 0)
+                    slots_[i].generation = 1;
+                freeList_.push_back(i);
+            }
+        }
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+};
+
+struct LayerHandleTag {};
+
+/**
+ * @brief Stable identifier for a layer, independent of its position in the stack
+ */
+using LayerHandle = GenerationalHandle<LayerHandleTag>;
+
+} // namespace EpiGimp
+
+namespace std {
+
+template<typename Tag>
+struct hash<EpiGimp::GenerationalHandle<Tag>> {
+    size_t operator()(const EpiGimp::GenerationalHandle<Tag>& handle) const noexcept {
+        return (static_cast<size_t>(handle.generation) << 32) ^ handle.index;
+    }
+};
+
+} // namespace std
+
+#endif // SLOT_MAP_HPP
@@ -0,0 +1,113 @@
+//Budgeted main-thread texture uploads of dirty regions
+#ifndef UPLOAD_SCHEDULER_HPP
+#define UPLOAD_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "raylib.h"
+#include "DocumentSnapshot.hpp"
+
+namespace EpiGimp {
+
+/**
+ * @brief Collects dirty texture regions from any thread and uploads them on the GL thread
+ *
+ * Producers (tools, filters, loaders) hand over the new pixels of a whole texture, in
+ * texture row order, together with the region that changed. Regions are tracked as
+ * TILE_SIZE tiles, so repeated and overlapping submissions collapse; at upload time
+ * adjacent dirty tiles merge into as few rectangles as possible and go up with
+ * UpdateTextureRec.
+ *
+ * update() runs once per frame and stops when the byte or time budget is spent, rects
+ * overlapping the visible region first. A rect larger than the remaining budget goes up
+ * a band of tile rows at a time, so a full-layer filter result streams in over a few
+ * frames instead of stalling one.
+ *
+ * Render textures flush their pending regions before they are drawn into or read back,
+ * so an older upload never lands on top of newer pixels.
+ */
+class UploadScheduler {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    struct Budget {
+        size_t bytes = 16 * 1024 * 1024;
+        std::chrono::microseconds time{4000};
+    };
+
+    struct Stats {
+        size_t uploads = 0;     // UpdateTextureRec calls
+        size_t bytes = 0;
+    };
+
+private:
+    struct Target {
+        Texture2D texture{};
+        SharedPixels pixels;                 // Newest submitted contents, texture row order
+        int tilesX = 0;
+        int tilesY = 0;
+        std::vector<uint8_t> dirty;          // One flag per tile
+        size_t dirtyCount = 0;
+    };
+
+    struct Candidate {
+        unsigned textureId;
+        Rectangle tiles;                     // In tile units
+        bool visible;
+        float distance;                      // From the centre of the visible region, squared
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<unsigned, Target> targets_;   // Guarded by mutex_, by texture id
+    std::vector<uint8_t> scratch_;                   // Main thread only: gathered rect pixels
+    Stats lastStats_;
+
+    size_t uploadLocked(Target& target, Rectangle tiles, size_t maxBytes);   // Returns bytes sent
+
+public:
+    UploadScheduler() = default;
+    UploadScheduler(const UploadScheduler&) = delete;
+    UploadScheduler& operator=(const UploadScheduler&) = delete;
+
+    /**
+     * @brief The scheduler every texture owner flushes through
+     */
+    static UploadScheduler& shared();
+
+    /**
+     * @brief Mark region of texture dirty with pixels as its new contents; any thread
+     * @param pixels RGBA8, texture-sized, never written again (a snapshot)
+     */
+    void submit(const Texture2D& texture, SharedPixels pixels, Rectangle region);
+
+    /**
+     * @brief Upload pending regions within budget; main thread, once per frame
+     * @param visible Region of interest per texture id, in texture pixels (empty = none)
+     */
+    Stats update(const Budget& budget, const std::unordered_map<unsigned, Rectangle>& visible = {});
+
+    void flush(unsigned textureId);          // Upload everything pending for one texture now
+    void flushAll();
+    void discard(unsigned textureId);        // The texture is being unloaded
+
+    bool hasPending(unsigned textureId) const;
+    bool isIdle() const;
+    size_t getPendingBytes() const;
+    const Stats& getLastStats() const { return lastStats_; }
+
+    /**
+     * @brief Cover the set tiles of a tilesX x tilesY grid with few rectangles
+     *
+     * Runs of dirty tiles in a row are extended downwards while the rows below have the
+     * same run. The result covers every dirty tile exactly once and nothing else.
+     * @return Rects in tile units
+     */
+    static std::vector<Rectangle> mergeTiles(const std::vector<uint8_t>& dirty, int tilesX, int tilesY);
+};
+
+} // namespace EpiGimp
+
+#endif // UPLOAD_SCHEDULER_HPP
@@ -2,6 +2,8 @@
 #ifndef CANVAS_HPP
 #define CANVAS_HPP
 
+#include <array>
+#include <atomic>
 #include <optional>
 #include <string>
 #include <memory>
@@ -10,16 +12,27 @@
 #include "../Core/Interfaces.hpp"
 #include "../Core/RaylibWrappers.hpp"
 #include "../Core/EventSystem.hpp"
+#include "../Core/SlotMap.hpp"
+#include "../Core/DocumentSnapshot.hpp"
+#include "../Core/SelectionMask.hpp"
 #include "../Commands/FlipSelectionCommands.hpp"
+#include "../Utils/AsyncImageLoader.hpp"
+#include "../Utils/BackgroundSaver.hpp"
+#include "../Utils/Filters.hpp"
+#include "../Utils/FloodFill.hpp"
+#include "../Utils/ProjectTileStreamer.hpp"
 
 namespace EpiGimp {
 
 struct DrawingLayer {
+    LayerHandle handle;                                    // Stable identity, assigned by the canvas
     std::optional<RenderTextureResource> texture;
     bool visible;
     bool flippedVertical;
     bool flippedHorizontal;
     std::string name;
+    SharedPixels snapshotPixels;                           // CPU copy reused by snapshots while the texture is unchanged
+    uint64_t snapshotRevision = 0;                         // Texture revision snapshotPixels was read at
     
     DrawingLayer(const std::string& layerName) : visible(true), flippedVertical(false), flippedHorizontal(false), name(layerName) {}
 };
@@ -44,11 +57,20 @@ private:
     Rectangle bounds_;
     std::optional<TextureResource> currentTexture_;        // Background layer (loaded image)
     std::vector<DrawingLayer> drawingLayers_;              // Multiple drawing layers
+    SlotMap<size_t, LayerHandleTag> layerSlots_;           // Layer handle -> position in drawingLayers_
     std::string currentImagePath_;
     float zoomLevel_;
     Vector2 panOffset_;
     EventDispatcher* eventDispatcher_;
+    std::vector<Subscription> subscriptions_;   // Handlers capturing this, dropped with it
     HistoryManager* historyManager_;                       // For undo/redo functionality
+    std::unique_ptr<AsyncImageLoader> imageLoader_;        // Created on first async load
+    std::unique_ptr<BackgroundSaver> imageSaver_;          // Created on first save
+    SharedPixels backgroundPixels_;                        // CPU copy of currentTexture_ for snapshots
+    std::unique_ptr<ProjectTileStreamer> projectStreamer_; // Tiles of an opened project still to upload
+    std::vector<LayerHandle> projectTargets_;              // Project file layer -> canvas layer (null for background)
+    std::optional<TextureResource> tileStaging_;           // Reused upload texture for streamed tiles
+    std::optional<RenderTextureResource> strokeScratch_;   // Region readbacks for clipping strokes to the selection
     
     DrawingTool currentTool_;
     bool isDrawing_;
@@ -57,6 +79,39 @@ private:
     Color secondaryColor_;                                 // Secondary drawing color (right-click)
     Color drawingColor_;                                   // Current drawing color (deprecated, for compatibility)
     bool mirrorModeEnabled_;                               // Enable horizontal mirror drawing
+    FloodFill::Options fillOptions_;                       // Bucket fill tolerance and edge smoothing
+    bool fillSampleMerged_ = false;                        // Bucket fill matches the visible composite, not the layer
+    int wandTolerance_ = 32;                               // Magic wand per-channel tolerance, 0-255
+    bool wandContiguous_ = true;                           // Magic wand grows from the click, or selects the colour everywhere
+    bool wandSampleMerged_ = false;                        // Magic wand matches the visible composite, not the layer
+    std::vector<Vector2> freeformPoints_;                  // Lasso or polygon outline being placed (image coordinates)
+    
+    // Filter preview
+    std::optional<LayerFilter> previewFilter_;             // Filter being previewed on the selected layer
+    LayerHandle previewLayer_;                             // Layer the preview was started on
+    ImageResource previewSource_;                          // That layer at the displayed mip level, texture order
+    int previewLevel_ = 0;                                 // previewSource_ is 1 / 2^level of the layer size
+    std::optional<TextureResource> previewTexture_;        // Filtered visible part of previewSource_
+    Rectangle previewArea_ = {};                           // Texture pixels of previewSource_ covered by previewTexture_
+    float previewZoom_ = 0.0f;                             // View the preview was made for
+    Vector2 previewPan_ = {};
+    bool previewDirty_ = false;
+    size_t previewRow_ = 0;                                // Panel row [ and ] adjust: 0 the amount, then the settings
+    bool previewDragging_ = false;                         // A panel slider follows the mouse
+    std::array<uint32_t, 256> previewHistogram_ = {};      // Luminance of previewSource_, shown for tone filters
+
+    // Whole-layer result of a tone filter preview, worked out on the job system
+    struct PreviewRefinement {
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> finished{false};
+        Image result = {};                                 // Filtered layer, texture order; read once finished
+
+        ~PreviewRefinement() { if (result.data) UnloadImage(result); }
+    };
+    SharedPixels previewFullSource_;                       // Full-size layer, texture order, for tone filters
+    std::shared_ptr<PreviewRefinement> previewRefinement_; // Running for the current values, if any
+    std::optional<TextureResource> previewFullTexture_;    // Finished refinement, drawn instead of previewTexture_
+    bool previewRefined_ = false;                          // previewFullTexture_ matches the current values
     
     // Selection state
     bool isSelecting_;                                     // True when actively making a selection
@@ -64,6 +119,8 @@ private:
     Vector2 selectionStart_;                               // Selection start point (screen coordinates)
     Vector2 selectionEnd_;                                 // Selection end point (screen coordinates)
     Rectangle selectionRect_;                              // Current selection rectangle (image coordinates)
+    SelectionMask selectionMask_;                          // Selected pixels, selectionRect_ is their bounds
+    bool selectionIsRectangle_ = false;                    // Plain rectangle: resize handles and transform apply
     float selectionAnimTime_;                              // For marching ants animation
     
     // Selection resize state
@@ -83,11 +140,13 @@ private:
     bool canvasFlippedVertical_;                          // Global vertical flip state for entire canvas
     bool canvasFlippedHorizontal_;                        // Global horizontal flip state for entire canvas
     int selectedLayerIndex_;                               // Currently selected layer for drawing/editing
+    ExportOptions exportOptions_;                          // PNG level and raw tile RLE used by saveImage
     
     static constexpr float MIN_ZOOM = 0.1f;
     static constexpr float MAX_ZOOM = 5.0f;
     static constexpr float ZOOM_STEP = 0.1f;
     static constexpr float PAN_SPEED = 2.0f;
+    static constexpr size_t PROJECT_UPLOAD_BUDGET = 4 * 1024 * 1024;  // Tile bytes uploaded per frame
 
 public:
     explicit Canvas(Rectangle bounds, EventDispatcher* dispatcher, HistoryManager* historyManager = nullptr, bool autoCreateBlankCanvas = true);
@@ -103,9 +162,27 @@ public:
     Rectangle getBounds() const override { return bounds_; }
 
     void loadImage(const std::string& filePath) override;
+    void loadImageAsync(const std::string& filePath);   // Decode off-thread, current image stays until done
+    bool isLoadingImage() const { return (imageLoader_ && imageLoader_->isBusy()) || projectStreamer_; }
+    float getImageLoadProgress() const;
     void createBlankCanvas(int width = 800, int height = 600, Color backgroundColor = WHITE);
-    bool saveImage(const std::string& filePath) override;
+    bool saveImage(const std::string& filePath) override;  // Queues the save, ImageSavedEvent reports the result
+    bool isSavingImage() const { return imageSaver_ && imageSaver_->isBusy(); }
+    void waitForPendingSaves();                          // Finish queued saves and publish their events
+    void setPngCompressionLevel(int level);              // 0 (fastest) to 9 (smallest)
+    int getPngCompressionLevel() const { return exportOptions_.pngCompressionLevel; }
+    void setRawTileRle(bool enabled);                    // Run-length encode .ert tiles when it helps
+    bool isRawTileRleEnabled() const { return exportOptions_.rawTileRle; }
+    DocumentSnapshot captureSnapshot(bool includeHidden = false); // Copy-on-write snapshot of the document
+    
+    // Native project files (.epg) keep layers, names, visibility and flips
+    bool openProject(const std::string& filePath);       // Maps the file, tiles stream in over the next frames
+    bool saveProject(const std::string& filePath);       // Queued like saveImage
+    bool isStreamingProject() const { return projectStreamer_ != nullptr; }
+    void finishProjectStreaming();                       // Upload every remaining tile now
     bool hasImage() const override;
+    Vector2 getImageSize() const;                        // Document size in pixels, zero without an image
+    const std::string& getImagePath() const { return currentImagePath_; }
     void setZoom(float zoom) override;
     float getZoom() const override { return zoomLevel_; }
     void setPan(Vector2 offset) override;
@@ -121,6 +198,17 @@ public:
     const DrawingLayer* getLayer(int index) const;
     DrawingLayer* getLayer(int index);
     
+    // Handle based access: handles stay valid across reorders, stale ones resolve to nullptr / -1
+    LayerHandle getLayerHandle(int index) const;
+    LayerHandle getSelectedLayerHandle() const { return getLayerHandle(selectedLayerIndex_); }
+    int getLayerIndex(LayerHandle handle) const;
+    const DrawingLayer* getLayer(LayerHandle handle) const;
+    DrawingLayer* getLayer(LayerHandle handle);
+    Image copyLayerImage(LayerHandle handle) const;  // Top-down copy of a layer, Image{} if unavailable
+    bool restoreLayerImage(LayerHandle handle, const Image& image);
+    bool clearLayerRegion(LayerHandle handle, Rectangle region);
+    bool writeLayerPixels(LayerHandle handle, Rectangle region, const void* pixels); // RGBA8 rows of region, texture order
+    
     int addNewDrawingLayer(const std::string& name = "");
     void deleteLayer(int index);
     void clearLayer(int index);
@@ -150,15 +238,50 @@ public:
     void deleteSelectionWithCommand(); // Delete with command pattern (for undo/redo)
     void flipSelectionVertical(); // Flip selected content vertically
     void flipSelectionHorizontal(); // Flip selected content horizontally
+    const SelectionMask& getSelectionMask() const { return selectionMask_; }
+    void setSelectionMask(SelectionMask mask); // Replace the selection, an empty mask clears it
+    void selectShape(const SelectionMask& shape, SelectionMode mode); // Combine a new shape with the selection
+    void invertSelection();
+    bool clearLayerMask(LayerHandle handle, const SelectionMask& mask); // Fade selected pixels to transparent
     
     // Mirror mode
     bool isMirrorModeEnabled() const { return mirrorModeEnabled_; }
     void setMirrorMode(bool enabled) { mirrorModeEnabled_ = enabled; }
     void toggleMirrorMode() { mirrorModeEnabled_ = !mirrorModeEnabled_; }
     
+    // Escape cancels a filter preview or a polygon in progress, or drops the selection; only otherwise may it quit
+    bool usesEscape() const;
+    
     // Color picking / Eyedropper
     Color pickColorAtScreenPosition(Vector2 screenPos) const;
     
+    // Bucket fill
+    bool fillAt(Vector2 imagePos, Color color);          // Fill the region under imagePos on the selected layer
+    void setFillTolerance(int tolerance) { fillOptions_.tolerance = tolerance; }
+    int getFillTolerance() const { return fillOptions_.tolerance; }
+    void setFillAntialias(bool enabled) { fillOptions_.antialias = enabled; }
+    bool isFillAntialiased() const { return fillOptions_.antialias; }
+    void setFillSampleMerged(bool enabled) { fillSampleMerged_ = enabled; }
+    bool isFillSampleMerged() const { return fillSampleMerged_; }
+    
+    // Magic wand
+    bool selectByColorAt(Vector2 imagePos, SelectionMode mode); // Select the colour under imagePos
+    void setWandTolerance(int tolerance) { wandTolerance_ = tolerance; }
+    int getWandTolerance() const { return wandTolerance_; }
+    void setWandContiguous(bool enabled) { wandContiguous_ = enabled; }
+    bool isWandContiguous() const { return wandContiguous_; }
+    void setWandSampleMerged(bool enabled) { wandSampleMerged_ = enabled; }
+    bool isWandSampleMerged() const { return wandSampleMerged_; }
+    
+    // Filters: the preview shows the visible part at display resolution, apply runs at full size
+    bool applyFilter(const LayerFilter& filter);         // Filter the selected layer (within the selection), undoable
+    void beginFilterPreview(LayerFilter filter);
+    void setFilterPreviewAmount(float amount);
+    void setFilterPreviewSetting(size_t index, float value);
+    void commitFilterPreview();                          // Apply at full size
+    void cancelFilterPreview();
+    bool isFilterPreviewActive() const { return previewFilter_.has_value(); }
+    
     // Transform preview
     void drawTransformPreview(Rectangle imageDestRect) const;
 
@@ -170,14 +293,36 @@ private:
     void handleDrawing();  // New method for drawing input
     void handleSelection(); // New method for selection input
     void handleEyedropper(); // Handle eyedropper/color picker input
+    void handleBucketFill(); // Handle bucket fill clicks and its option keys
+    void handleMagicWand(); // Handle magic wand clicks and its option keys
+    void handleFreeformSelection(); // Lasso drags and polygon clicks
+    void finishFreeformSelection(); // Rasterize the placed outline into the selection
+    bool isSelectionTool() const; // Rectangle, lasso, polygon or magic wand
     void drawImage() const;
     void drawPlaceholder() const;
     void drawSelection() const; // Draw selection rectangle with marching ants
+    void drawFreeformPath() const; // Draw the lasso or polygon outline being placed
     void drawZoomIndicator() const; // Draw zoom level indicator
+    void drawToolOptions() const; // Options row of the fill or magic wand tool, with the keys that change them
+    void handleFilterPreview(); // [ and ] or the panel sliders change values, Enter applies, Escape cancels
+    void updateFilterPreview(); // Refilter the visible part after a change of values or view
+    void invalidateFilterPreview(); // Values changed: refilter, and drop the whole-layer result
+    void startFilterRefinement(); // Tone filters: filter the whole layer in the background
+    void setFilterPreviewRow(size_t row, float value); // Row 0 the amount, then the settings
+    size_t filterPanelRowCount() const; // Adjustable values of the previewed filter
+    Rectangle filterPanelBounds() const;
+    Rectangle filterPanelSlider(size_t row) const;
+    int previewLevelForZoom() const; // Mip level the layer is displayed at
+    void drawFilterPreview(Rectangle imageDestRect, bool mirrored, bool rowsReversed) const; // In place of the selected layer
+    void drawFilterPreviewInfo() const; // Panel with the filter's values, histogram and keys
     void drawStroke(Vector2 from, Vector2 to);
     void applyBlurToLayer(DrawingLayer& layer, Vector2 from, Vector2 to); // Apply blur effect to layer texture
     void applyBurnToLayer(DrawingLayer& layer, Vector2 from, Vector2 to); // Apply burn effect to darken pixels
     void applyDodgeToLayer(DrawingLayer& layer, Vector2 from, Vector2 to); // Apply dodge effect to lighten pixels
+    void submitStrokeRegion(DrawingLayer& layer, Image layerImage, Vector2 from, Vector2 to, int reach); // Queue the touched area for upload, takes layerImage
+    void clipStrokeToSelection(DrawingLayer& layer, Image beforeStroke, Rectangle region); // Put back what landed outside the selection, takes region-sized beforeStroke
+    Rectangle layerPixelRect(const DrawingLayer& layer, float left, float top, float right, float bottom) const; // Whole pixels, clamped to the layer
+    Image readLayerRegion(const DrawingLayer& layer, Rectangle region); // Region only, rows bottom-up like readPixels
     
     // Selection resize helpers
     ResizeHandle getResizeHandleAt(Vector2 mousePos) const; // Get resize handle under mouse position
@@ -199,11 +344,20 @@ private:
     Rectangle calculateImageDestRect() const;
     Vector2 getImageCenter() const;
     std::optional<TextureResource> createTextureFromFile(const std::string& filePath);
+    void applyLoadedTexture(TextureResource texture, const std::string& filePath);
+    void updateImageLoading(); // Advance a pending async load
+    SharedPixels snapshotLayerPixels(DrawingLayer& layer); // Reuse or refresh the layer's CPU copy
+    void updateProjectStreaming(); // Upload the next batch of project tiles
+    void updateTextureUploads(); // Send queued layer regions, visible part first
+    void uploadProjectTile(const ProjectTileStreamer::DecodedTile& tile);
     void resetViewTransform();
+    void reindexLayersFrom(int index); // Refresh handle -> position entries after the stack changed
     std::string generateUniqueLayerName() const; // Generate unique layer name
     Vector2 screenToImageCoords(Vector2 screenPos) const; // Convert screen coords to image coords
     Vector2 imageToScreenCoords(Vector2 imagePos) const;  // Convert image coords to screen coords
     Rectangle normalizeRect(Vector2 start, Vector2 end) const; // Create normalized rectangle from two points
+    void setRectangleSelection(Rectangle rect); // Replace the selection with a rectangle (image coordinates)
+    SelectionMode selectionModeFromKeys() const; // Shift adds, Ctrl subtracts, both intersect
     void drawMarchingAnts(Rectangle rect, Color color, float dashLength, float offset) const; // Draw marching ants effect
     void drawDashedLine(Vector2 start, Vector2 end, Color color, float dashLength, float offset) const; // Draw dashed line
 };
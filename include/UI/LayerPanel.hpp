@@ -19,11 +19,12 @@ private:
     Rectangle bounds_;
     LayerManager* layerManager_;
     EventDispatcher* eventDispatcher_;
+    std::vector<Subscription> subscriptions_;   // Handlers capturing this, dropped with it
     
     int scrollOffset_;
-    int selectedLayerIndex_;
+    LayerHandle selectedLayer_;
     bool isDragging_;
-    int dragStartIndex_;
+    LayerHandle draggedLayer_;
     Vector2 dragOffset_;
     
     static constexpr float LAYER_ITEM_HEIGHT = 40.0f;
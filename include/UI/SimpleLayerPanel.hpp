@@ -4,6 +4,7 @@
 #include "raylib.h"
 #include "../Core/Interfaces.hpp"
 #include "../Core/EventSystem.hpp"
+#include "../Core/SlotMap.hpp"
 
 namespace EpiGimp {
 
@@ -29,7 +30,7 @@ private:
     mutable float scrollOffset_;              // For scrolling through layers
     
     mutable bool isDragging_;                 // Whether a layer is being dragged
-    mutable int dragStartIndex_;              // Index of the layer being dragged
+    mutable LayerHandle draggedLayer_;        // Layer being dragged (stable if the stack changes mid-drag)
     mutable Vector2 dragOffset_;              // Offset from mouse to layer item origin
     mutable Vector2 dragStartPos_;            // Mouse position when drag started
     
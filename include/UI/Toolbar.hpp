@@ -5,10 +5,13 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <optional>
 #include <string>
 #include "raylib.h"
 #include "../Core/Interfaces.hpp"
 #include "../Core/EventSystem.hpp"
+#include "../Core/RaylibWrappers.hpp"
+#include "../Utils/ColorSpace.hpp"
 
 namespace EpiGimp {
 
@@ -26,10 +29,12 @@ private:
     static constexpr int SWATCH_SIZE = 20;
     static constexpr int SWATCH_MARGIN = 2;
     static constexpr int PALETTE_PADDING = 5;
+    static constexpr int HSV_SQUARE_TEXELS = 128;   // Saturation-value square, stretched when drawn
 
     Rectangle bounds_;
     std::vector<std::unique_ptr<ColorSwatch>> swatches_;
     EventDispatcher* eventDispatcher_;
+    std::vector<Subscription> subscriptions_;   // Handlers capturing this, dropped with it
     Color selectedColor_;        // For backward compatibility
     Color primaryColor_;         // Primary color (left-click)
     Color secondaryColor_;       // Secondary color (right-click)
@@ -48,7 +53,22 @@ private:
     mutable Rectangle rgbPreviewRect_;
     mutable Rectangle rgbCloseButton_;
 
+    // HSV picker: a saturation-value square for the current hue, and a hue bar beside it
+    bool showHsvPicker_ = false;
+    ColorSpace::Hsv pickerHsv_;
+    int pickerDrag_ = 0;                                // 0 none, 1 square, 2 hue bar
+    float pickerSquareHue_ = -1.0f;                     // Hue pickerSquare_ was filled for
+    std::optional<TextureResource> pickerSquare_;
+    std::optional<TextureResource> pickerHueBar_;
+    Rectangle hsvWindow_{};
+    Rectangle hsvSquareRect_{};
+    Rectangle hsvHueRect_{};
+    Rectangle hsvPreviewRect_{};
+    Rectangle hsvApplyButton_{};
+    Rectangle hsvCloseButton_{};
+
     void initializePalette();
+    void refreshHsvTextures();
 
 public:
     explicit ColorPalette(Rectangle bounds, EventDispatcher* dispatcher);
@@ -67,6 +87,13 @@ public:
     void toggleRgbInput();
     void updateRgbInput();
     void drawRgbInput() const;
+
+    // HSV picker methods
+    void toggleHsvPicker();
+    void updateHsvPicker();
+    void drawHsvPicker() const;
+
+    bool usesEscape() const { return showHsvPicker_ || showRgbInput_; }   // Escape closes the open picker
 };
 
 class Toolbar : public IToolbar {
@@ -120,6 +147,7 @@ private:
     std::vector<std::unique_ptr<DropdownMenu>> dropdownMenus_;
     std::vector<std::unique_ptr<Button>> buttons_;
     EventDispatcher* eventDispatcher_;
+    std::vector<Subscription> subscriptions_;   // Handlers capturing this, dropped with it
     std::unique_ptr<ColorPalette> colorPalette_;
     DrawingTool currentTool_;
     float dropdownCloseCooldown_; // Timer to prevent click-through after dropdown closes
@@ -146,6 +174,9 @@ public:
     
     // Check if toolbar consumed a click this frame (to prevent click-through to other UI)
     bool consumedClickThisFrame() const { return consumedClickThisFrame_; }
+    
+    // A colour picker window is open and Escape closes it
+    bool usesEscape() const { return colorPalette_ && colorPalette_->usesEscape(); }
 
 private:
     void updateButton(Button& button);
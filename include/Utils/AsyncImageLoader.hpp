@@ -0,0 +1,129 @@
+//Background image decoding with incremental texture upload
+#ifndef ASYNC_IMAGE_LOADER_HPP
+#define ASYNC_IMAGE_LOADER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include "raylib.h"
+#include "../Core/RaylibWrappers.hpp"
+#include "../Core/EventSystem.hpp"
+
+namespace EpiGimp {
+
+/**
+ * @brief Loads images without blocking the UI thread
+ *
+ * Decoding, conversion to RGBA8 and fit-to-bounds resizing run on a worker thread.
+ * The GPU upload has to happen on the thread that owns the GL context, so update()
+ * copies the decoded pixels into the texture a band of rows at a time, bounded by a
+ * per-frame byte budget. Progress is published as ImageLoadProgressEvent from update().
+ *
+ * Only the most recent request is honoured: starting a new load supersedes any load
+ * still in flight.
+ */
+class AsyncImageLoader {
+public:
+    struct LoadResult {
+        std::string filePath;
+        std::optional<TextureResource> texture;  // Empty if the load failed
+        std::string error;
+    };
+
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024;  // Bytes uploaded per frame
+
+private:
+    struct Request {
+        uint64_t id;
+        std::string filePath;
+        int maxWidth;
+        int maxHeight;
+    };
+
+    struct DecodeResult {
+        uint64_t id;
+        std::string filePath;
+        Image image;
+        std::string error;
+    };
+
+    struct Upload {
+        uint64_t id;
+        std::string filePath;
+        Image image;
+        Texture2D texture;
+        int nextRow;
+    };
+
+    EventDispatcher* eventDispatcher_;
+    size_t uploadBudget_;
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wakeWorker_;
+    bool stopping_;                                // Guarded by mutex_
+    std::optional<Request> pendingRequest_;        // Guarded by mutex_
+    std::optional<DecodeResult> decoded_;          // Guarded by mutex_
+    std::atomic<uint64_t> latestRequestId_;
+
+    // Written by the worker, read by update() to publish progress
+    std::atomic<uint64_t> progressRequestId_;
+    std::atomic<float> decodeProgress_;
+    std::atomic<int> decodeStage_;
+
+    // Main thread only
+    std::optional<Upload> upload_;
+    std::string currentPath_;
+    float progress_;
+    int lastPublishedStage_;
+    int lastPublishedPercent_;
+
+public:
+    explicit AsyncImageLoader(EventDispatcher* dispatcher, size_t uploadBudget = DEFAULT_UPLOAD_BUDGET);
+    ~AsyncImageLoader();
+
+    AsyncImageLoader(const AsyncImageLoader&) = delete;
+    AsyncImageLoader& operator=(const AsyncImageLoader&) = delete;
+    AsyncImageLoader(AsyncImageLoader&&) = delete;
+    AsyncImageLoader& operator=(AsyncImageLoader&&) = delete;
+
+    /**
+     * @brief Start loading an image, superseding any load in progress
+     * @param maxWidth, maxHeight Images larger than this are scaled down to fit (0 = no limit)
+     */
+    void requestLoad(const std::string& filePath, int maxWidth = 0, int maxHeight = 0);
+
+    /**
+     * @brief Abandon the current load, if any
+     */
+    void cancel();
+
+    /**
+     * @brief Advance the load; call once per frame from the main thread
+     * @return The finished load (successful or not) on the frame it completes
+     */
+    std::optional<LoadResult> update();
+
+    bool isBusy() const;
+    float getProgress() const { return progress_; }
+    const std::string& getCurrentPath() const { return currentPath_; }
+    void setUploadBudget(size_t bytesPerFrame) { uploadBudget_ = bytesPerFrame > 0 ? bytesPerFrame : 1; }
+
+private:
+    void workerLoop();
+    DecodeResult decode(const Request& request);
+    bool isStale(uint64_t requestId) const { return requestId != latestRequestId_.load(); }
+    void reportDecodeProgress(uint64_t requestId, int stage, float progress);
+    void publishProgress(int stage, float progress);
+    bool beginUpload(DecodeResult&& result);
+    bool continueUpload();
+    void discardUpload();
+};
+
+} // namespace EpiGimp
+
+#endif // ASYNC_IMAGE_LOADER_HPP
@@ -0,0 +1,143 @@
+//Periodic autosave: full checkpoints plus a journal of dirty tiles
+#ifndef AUTOSAVER_HPP
+#define AUTOSAVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Core/DocumentSnapshot.hpp"
+#include "ProjectFile.hpp"
+
+namespace EpiGimp {
+
+struct AutosaveSettings {
+    std::string directory;                            // Checkpoints and journals live here
+    float intervalSeconds = 30.0f;
+    size_t maxBytesPerSecond = 8 * 1024 * 1024;       // Disk write rate cap for the worker
+    float checkpointRatio = 0.5f;                     // Start a new checkpoint once the journal outgrows this share of it
+    int tileSize = ProjectFile::DEFAULT_TILE_SIZE;
+};
+
+/**
+ * @brief Autosaves the document without rewriting it every time
+ *
+ * The first autosave writes a full checkpoint (a regular .epg project). Later ones diff the
+ * new snapshot against the last saved one and append only the tiles that changed to a
+ * journal, closed by a commit record. Layers whose pixels are shared with the previous
+ * snapshot are skipped without being compared at all. Once the journal grows past
+ * checkpointRatio of the checkpoint, the next autosave starts a new checkpoint.
+ *
+ * Files are numbered by checkpoint generation (checkpoint-N.epg, journal-N.epj); a new
+ * generation is complete on disk before the previous one is removed, so a crash at any
+ * point leaves something recoverable. recover() replays every committed delta on top of
+ * the newest checkpoint and ignores a torn tail.
+ *
+ * Snapshots are taken on the main thread in update(); diffing, compression and writing
+ * run on a worker thread whose output is throttled to maxBytesPerSecond.
+ */
+class Autosaver {
+public:
+    using SnapshotProvider = std::function<DocumentSnapshot()>;
+
+    struct Stats {
+        size_t checkpoints = 0;
+        size_t deltas = 0;
+        size_t lastTilesWritten = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+private:
+    // Token bucket limiting the worker's write rate
+    class RateLimiter {
+    private:
+        size_t bytesPerSecond_;
+        double tokens_;
+        std::chrono::steady_clock::time_point lastRefill_;
+
+    public:
+        explicit RateLimiter(size_t bytesPerSecond);
+        void consume(size_t bytes);
+    };
+
+    SnapshotProvider provider_;
+    AutosaveSettings settings_;
+    float elapsed_;
+
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    std::condition_variable wakeWorker_;
+    std::condition_variable idle_;
+    bool stopping_;                                // Guarded by mutex_
+    bool saving_;                                  // Guarded by mutex_
+    std::optional<DocumentSnapshot> pending_;      // Guarded by mutex_
+    Stats stats_;                                  // Guarded by mutex_
+
+    // Worker thread only
+    RateLimiter rateLimiter_;
+    std::optional<DocumentSnapshot> lastSaved_;
+    uint64_t generation_;
+    uint64_t checkpointBytes_;
+    uint64_t journalBytes_;
+    uint64_t sequence_;
+    std::FILE* journal_;
+
+public:
+    Autosaver(SnapshotProvider provider, AutosaveSettings settings);
+    ~Autosaver();
+
+    Autosaver(const Autosaver&) = delete;
+    Autosaver& operator=(const Autosaver&) = delete;
+    Autosaver(Autosaver&&) = delete;
+    Autosaver& operator=(Autosaver&&) = delete;
+
+    /**
+     * @brief Count down the interval; call once per frame from the main thread
+     */
+    void update(float deltaTime);
+
+    /**
+     * @brief Take a snapshot and autosave it now (skipped if the previous one is still writing)
+     */
+    void saveNow();
+
+    void waitForIdle();
+    bool isBusy() const;
+    Stats getStats() const;
+
+    /**
+     * @brief Delete every autosave file, e.g. after a clean shutdown
+     */
+    void discard();
+
+    static bool hasRecoverableState(const std::string& directory);
+
+    /**
+     * @brief Rebuild the latest committed state from the newest checkpoint and its journal
+     */
+    static std::optional<DocumentSnapshot> recover(const std::string& directory);
+
+    static std::string checkpointPath(const std::string& directory, uint64_t generation);
+    static std::string journalPath(const std::string& directory, uint64_t generation);
+
+private:
+    void workerLoop();
+    void persist(const DocumentSnapshot& snapshot);
+    bool writeCheckpoint(const DocumentSnapshot& snapshot);
+    bool writeDelta(const DocumentSnapshot& snapshot, size_t& tilesWritten);
+    bool appendRecord(uint32_t type, const std::vector<uint8_t>& payload);
+    void closeJournal();
+    void removeGeneration(uint64_t generation);
+    static std::optional<uint64_t> latestGeneration(const std::string& directory);
+};
+
+} // namespace EpiGimp
+
+#endif // AUTOSAVER_HPP
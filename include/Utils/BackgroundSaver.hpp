@@ -0,0 +1,94 @@
+//Composites and encodes document snapshots on a worker thread
+#ifndef BACKGROUND_SAVER_HPP
+#define BACKGROUND_SAVER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Core/DocumentSnapshot.hpp"
+#include "../Core/EventSystem.hpp"
+#include "../Core/RaylibWrappers.hpp"
+
+namespace EpiGimp {
+
+/**
+ * @brief Saves snapshots without blocking the UI thread
+ *
+ * Saves run one at a time in submission order. Results are collected on the worker and
+ * published as ImageSavedEvent from update(), so handlers always run on the main thread.
+ * Queued saves are finished before the saver is destroyed.
+ */
+class BackgroundSaver {
+public:
+    // Writes a snapshot to disk on the worker thread; actualPath is the path really written
+    using Writer = std::function<bool(const DocumentSnapshot& snapshot, const std::string& filePath, std::string& actualPath)>;
+
+    /**
+     * @brief Default writer: flatten the visible layers and export through raylib
+     */
+    static bool exportFlattened(const DocumentSnapshot& snapshot, const std::string& filePath, std::string& actualPath);
+
+    /**
+     * @brief Same as exportFlattened with format-specific settings
+     */
+    static Writer flattenedWriter(const ExportOptions& options);
+
+private:
+    struct Job {
+        DocumentSnapshot snapshot;
+        std::string filePath;
+        Writer writer;
+    };
+
+    struct Completion {
+        std::string requestedPath;
+        std::string actualPath;
+        bool success;
+    };
+
+    EventDispatcher* eventDispatcher_;
+
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    std::condition_variable wakeWorker_;
+    std::condition_variable idle_;
+    bool stopping_;                       // Guarded by mutex_
+    bool saving_;                         // Guarded by mutex_
+    std::deque<Job> jobs_;                // Guarded by mutex_
+    std::vector<Completion> completed_;   // Guarded by mutex_
+
+public:
+    explicit BackgroundSaver(EventDispatcher* dispatcher);
+    ~BackgroundSaver();
+
+    BackgroundSaver(const BackgroundSaver&) = delete;
+    BackgroundSaver& operator=(const BackgroundSaver&) = delete;
+    BackgroundSaver(BackgroundSaver&&) = delete;
+    BackgroundSaver& operator=(BackgroundSaver&&) = delete;
+
+    void submit(DocumentSnapshot snapshot, const std::string& filePath, Writer writer = exportFlattened);
+
+    /**
+     * @brief Publish finished saves; call once per frame from the main thread
+     */
+    void update();
+
+    bool isBusy() const;
+
+    /**
+     * @brief Block until every queued save has been written (shutdown, tests)
+     */
+    void waitForIdle();
+
+private:
+    void workerLoop();
+    static Completion save(const Job& job);
+};
+
+} // namespace EpiGimp
+
+#endif // BACKGROUND_SAVER_HPP
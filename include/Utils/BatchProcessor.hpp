@@ -0,0 +1,140 @@
+//Headless batch processing: scripted image operations over many files
+#ifndef BATCH_PROCESSOR_HPP
+#define BATCH_PROCESSOR_HPP
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "raylib.h"
+#include "../Core/RaylibWrappers.hpp"
+
+namespace EpiGimp {
+
+struct BatchOperation {
+    enum class Type {
+        Resize,     // width/height in pixels, or scale when percent is set
+        Flip,       // horizontal or vertical
+        Blur,       // Gaussian, radius is the standard deviation in pixels
+        Levels,     // inBlack inWhite gamma outBlack outWhite, applied to RGB
+        Flatten     // Composite over an opaque background colour
+    };
+
+    Type type;
+    int width = 0;
+    int height = 0;
+    float percent = 0.0f;
+    bool horizontal = false;
+    float radius = 0.0f;
+    float inBlack = 0.0f;
+    float inWhite = 255.0f;
+    float gamma = 1.0f;
+    float outBlack = 0.0f;
+    float outWhite = 255.0f;
+    Color background = WHITE;
+};
+
+/**
+ * @brief Parsed operation script
+ *
+ * One operation per line, '#' starts a comment:
+ *
+ *   resize 1024 768 | resize 1024 | resize 50%
+ *   flip horizontal | flip vertical
+ *   blur 2.5
+ *   levels 10 240 1.2 [0 255]
+ *   flatten [r g b]
+ *   export png|qoi|ert|jpg|bmp|tga [level 0-9] [norle]
+ *
+ * Operations run in order on each input; export picks the output format (default png).
+ * blur and levels go through the same filters as the editor's menus, so a script gives
+ * the same pixels as doing it by hand.
+ */
+class BatchScript {
+private:
+    std::vector<BatchOperation> operations_;
+    std::string extension_;
+    ExportOptions exportOptions_;
+
+public:
+    BatchScript() : extension_(".png") {}
+
+    /**
+     * @brief Parse script text
+     * @return std::nullopt on a syntax error, described in error with its line number
+     */
+    static std::optional<BatchScript> parse(const std::string& text, std::string* error = nullptr);
+    static std::optional<BatchScript> load(const std::string& filePath, std::string* error = nullptr);
+
+    const std::vector<BatchOperation>& getOperations() const { return operations_; }
+    const std::string& getExtension() const { return extension_; }
+    const ExportOptions& getExportOptions() const { return exportOptions_; }
+
+    /**
+     * @brief Run every operation on an RGBA8 image; safe to call from several threads
+     */
+    void apply(Image& image) const;
+};
+
+struct BatchFileResult {
+    std::string inputPath;
+    std::string outputPath;
+    bool success = false;
+    std::string error;
+    double loadMs = 0.0;
+    double processMs = 0.0;
+    double saveMs = 0.0;
+};
+
+struct BatchSummary {
+    std::vector<BatchFileResult> files;   // Same order as the inputs
+    size_t succeeded = 0;
+    size_t failed = 0;
+    double wallSeconds = 0.0;
+    unsigned workers = 0;
+
+    void print(std::ostream& out) const;
+    bool writeCsv(const std::string& filePath) const;
+};
+
+/**
+ * @brief Runs a script over many files on a pool of worker threads
+ *
+ * Each worker takes the next input, loads it (images, .qoi, .ert or a flattened .epg
+ * project), applies the script and writes the result into the output directory under the
+ * input's stem. Inputs from different folders can share a stem; the later ones get -2,
+ * -3, ... appended, so no two workers write the same file. Nothing touches the GPU, so no
+ * window is needed.
+ */
+class BatchRunner {
+private:
+    BatchScript script_;
+    std::string outputDirectory_;
+    unsigned workers_;
+
+public:
+    BatchRunner(BatchScript script, std::string outputDirectory, unsigned workers = 0);
+
+    BatchSummary run(const std::vector<std::string>& inputs) const;
+    BatchFileResult processFile(const std::string& inputPath, const std::string& outputPath) const;
+
+    /**
+     * @brief Output file for each input, in the same order, with no name used twice
+     */
+    std::vector<std::string> outputPaths(const std::vector<std::string>& inputs) const;
+
+private:
+    static Image loadInput(const std::string& filePath);
+};
+
+/**
+ * @brief Entry point for `EpiGimp --batch ...`; returns the process exit code
+ *
+ *   --batch --script ops.txt --output DIR [--jobs N] [--inputs list.txt] [files...]
+ */
+int runBatchCommand(const std::vector<std::string>& args);
+
+} // namespace EpiGimp
+
+#endif // BATCH_PROCESSOR_HPP
@@ -0,0 +1,89 @@
+//Conversions between RGB and the HSV, HSL and CIELAB colour spaces
+#ifndef COLOR_SPACE_HPP
+#define COLOR_SPACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Hue is in degrees, [0, 360); saturation, value and lightness are in [0, 1]. Lab is
+ * CIE 1976 L*a*b* against the D65 white sRGB is defined with: L in [0, 100], a and b
+ * roughly within +-128.
+ *
+ * HSV and HSL are taken straight from the stored sRGB values, as colour pickers and
+ * hue tools everywhere do. Lab goes through linear light. sRGB bytes are decoded with a
+ * 256-entry table, and linear values are encoded back with an 8192-entry table, which
+ * is fine enough that every byte survives the round trip.
+ *
+ * Each conversion is written once over "lanes": a single float for the one-colour
+ * functions and the odd pixels at the end of a batch, four (SSE2) or eight (AVX, when
+ * the build enables it) for the rest. Selects take the place of branches, so a lane of
+ * grey pixels and a lane of saturated ones cost the same. The batch functions read and
+ * write RGBA8 pixels and planar floats, one array per component; alpha is never read
+ * and never written.
+ */
+namespace ColorSpace {
+
+constexpr int ENCODE_TABLE_SIZE = 8192;   // Linear to sRGB steps
+
+struct Hsv {
+    float h = 0.0f;
+    float s = 0.0f;
+    float v = 0.0f;
+};
+
+struct Hsl {
+    float h = 0.0f;
+    float s = 0.0f;
+    float l = 0.0f;
+};
+
+struct Lab {
+    float l = 0.0f;
+    float a = 0.0f;
+    float b = 0.0f;
+};
+
+float toLinear(uint8_t value);            // sRGB byte to linear light, [0, 1]
+uint8_t fromLinear(float linear);         // Clamped to [0, 1] first
+
+Hsv toHsv(Color color);
+Color fromHsv(Hsv hsv, unsigned char alpha = 255);
+Hsl toHsl(Color color);
+Color fromHsl(Hsl hsl, unsigned char alpha = 255);
+Lab toLab(Color color);
+Color fromLab(Lab lab, unsigned char alpha = 255);
+
+// count pixels of RGBA8 to and from planar components
+void rgbToHsv(const uint8_t* rgba, size_t count, float* h, float* s, float* v);
+void hsvToRgb(const float* h, const float* s, const float* v, size_t count, uint8_t* rgba);
+void rgbToHsl(const uint8_t* rgba, size_t count, float* h, float* s, float* l);
+void hslToRgb(const float* h, const float* s, const float* l, size_t count, uint8_t* rgba);
+void rgbToLab(const uint8_t* rgba, size_t count, float* l, float* a, float* b);
+void labToRgb(const float* l, const float* a, const float* b, size_t count, uint8_t* rgba);
+
+// Hue / Saturation / Lightness adjustment, in the manner of GIMP's
+struct HslShift {
+    float hue = 0.0f;          // Degrees added to the hue
+    float saturation = 0.0f;   // -1 greys out, 0 keeps, 1 doubles
+    float lightness = 0.0f;    // -1 to black, 0 keeps, 1 to white
+
+    bool isIdentity() const { return hue == 0.0f && saturation == 0.0f && lightness == 0.0f; }
+};
+
+/**
+ * @brief Shift the hue, saturation and lightness of region of an RGBA8 image in place
+ *
+ * One pass per pixel, through HSL and back without leaving registers; rows are split
+ * over the job system.
+ */
+void adjustHsl(Image& image, const HslShift& shift, Rectangle region);
+
+} // namespace ColorSpace
+
+} // namespace EpiGimp
+
+#endif // COLOR_SPACE_HPP
@@ -0,0 +1,180 @@
+//Local JSON-RPC control socket for driving a running instance
+#ifndef CONTROL_SERVER_HPP
+#define CONTROL_SERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Json.hpp"
+
+namespace EpiGimp {
+
+// JSON-RPC 2.0 error codes
+namespace RpcError {
+constexpr int PARSE_ERROR = -32700;
+constexpr int INVALID_REQUEST = -32600;
+constexpr int METHOD_NOT_FOUND = -32601;
+constexpr int INVALID_PARAMS = -32602;
+constexpr int SERVER_ERROR = -32000;
+} // namespace RpcError
+
+/**
+ * @brief Thrown by method handlers (and the client) to report a JSON-RPC error
+ */
+class ControlError : public std::runtime_error {
+private:
+    int code_;
+
+public:
+    ControlError(int code, const std::string& message) : std::runtime_error(message), code_(code) {}
+    int getCode() const { return code_; }
+};
+
+/**
+ * @brief JSON-RPC 2.0 server on a Unix domain socket
+ *
+ * Messages are newline-delimited JSON objects. An I/O thread accepts connections, reads
+ * and parses requests and queues them; processPending() runs the handlers on the calling
+ * (main) thread, so handlers may touch the canvas and the GL context. Clients can pipeline
+ * as many requests as they like; responses come back in request order per connection.
+ * Requests without an id are notifications and get no response.
+ *
+ * When MAX_PENDING requests are queued the I/O thread stops reading, which pushes back on
+ * the clients through the socket buffers. The socket is created owner-only (0600).
+ *
+ * Responses never block the main thread: what a client's socket does not take right away
+ * waits in that connection's outbox for the I/O thread to send. Its requests are not read
+ * while the outbox is backed up, and a client that lets MAX_OUTBOX_BYTES pile up is dropped.
+ */
+class ControlServer {
+public:
+    using Handler = std::function<JsonValue(const JsonValue& params)>;
+
+    static constexpr size_t MAX_PENDING = 4096;
+    static constexpr size_t MAX_MESSAGE_BYTES = 16 * 1024 * 1024;
+    static constexpr size_t MAX_OUTBOX_BYTES = 64 * 1024 * 1024;
+
+private:
+    struct Connection {
+        std::mutex mutex;           // Serialises writes and the close
+        int fd;                     // Guarded by mutex, -1 once closed
+        std::string inbox;          // I/O thread only: bytes of an incomplete message
+        std::string outbox;         // Guarded by mutex: responses the socket has not taken yet
+
+        explicit Connection(int socketFd) : fd(socketFd) {}
+    };
+
+    struct Request {
+        std::shared_ptr<Connection> connection;
+        JsonValue id;
+        bool notification;
+        std::string method;
+        JsonValue params;
+        int errorCode;              // Non-zero for a message that was rejected while parsing
+        std::string errorMessage;
+    };
+
+    std::string socketPath_;
+    int listenFd_;
+    int wakePipe_[2];
+    std::thread ioThread_;
+    std::atomic<bool> stopping_;
+
+    std::mutex mutex_;
+    std::deque<Request> pending_;                          // Guarded by mutex_
+
+    std::map<std::string, Handler> handlers_;              // Main thread only, registered before start()
+    std::atomic<uint64_t> processedCount_;
+
+public:
+    explicit ControlServer(std::string socketPath);
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    void registerMethod(const std::string& name, Handler handler);
+
+    /**
+     * @brief Bind the socket and start accepting; a stale socket file is replaced
+     */
+    bool start();
+    void stop();
+    bool isRunning() const { return ioThread_.joinable(); }
+
+    /**
+     * @brief Run queued requests on this thread until the queue is empty or the budget is spent
+     * @param budgetMs Time budget; at least one request runs per call
+     * @return Number of requests handled
+     */
+    size_t processPending(double budgetMs = 8.0);
+
+    size_t getPendingCount();
+    uint64_t getProcessedCount() const { return processedCount_.load(); }
+    const std::string& getSocketPath() const { return socketPath_; }
+
+private:
+    void ioLoop();
+    void readFrom(const std::shared_ptr<Connection>& connection, std::vector<std::shared_ptr<Connection>>& closed);
+    void queueMessage(const std::shared_ptr<Connection>& connection, const std::string& message);
+    JsonValue dispatch(const Request& request);
+    void sendMessage(Connection& connection, const std::string& message);
+    static bool flushOutbox(Connection& connection);
+    static void closeConnection(Connection& connection);
+    void wake();
+};
+
+/**
+ * @brief Blocking client for the control socket
+ *
+ * call() is a round trip; send()/receive() let a client pipeline requests and collect
+ * the responses afterwards.
+ */
+class ControlClient {
+private:
+    int fd_;
+    int64_t nextId_;
+    std::string inbox_;
+
+public:
+    ControlClient() : fd_(-1), nextId_(1) {}
+    ~ControlClient() { close(); }
+
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    bool connect(const std::string& socketPath);
+    void close();
+    bool isConnected() const { return fd_ >= 0; }
+
+    /**
+     * @brief Send a request and wait for its response
+     * @return The result member; throws ControlError for an error response or a lost connection
+     */
+    JsonValue call(const std::string& method, JsonValue params = JsonValue::object());
+
+    int64_t send(const std::string& method, JsonValue params = JsonValue::object());   // Returns the request id
+    JsonValue receive();                                                                // Next whole response object
+};
+
+/**
+ * @brief Entry point for `EpiGimp --remote ...`; returns the process exit code
+ *
+ *   --remote SOCKET METHOD [PARAMS_JSON] [--repeat N]
+ *
+ * Prints the result as JSON. With --repeat the request is pipelined N times and the
+ * throughput is reported instead, which doubles as a benchmark of a warm instance.
+ */
+int runRemoteCommand(const std::vector<std::string>& args);
+
+} // namespace EpiGimp
+
+#endif // CONTROL_SERVER_HPP
@@ -0,0 +1,65 @@
+//Square-kernel convolution for whole layers
+#ifndef CONVOLUTION_HPP
+#define CONVOLUTION_HPP
+
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Convolution of RGBA8 pixels with any odd square kernel up to MAX_SIZE, applied the way
+ * image editors do (as a correlation: the kernel's top-left weight goes with the pixel
+ * up and to the left). Alpha is left as it was, so sharpening or embossing a shape keeps
+ * its outline.
+ *
+ * A kernel that is the outer product of a column and a row (box blurs, Gaussians, Sobel)
+ * is found by separate() and run as a row pass and a column pass, 2N taps per pixel
+ * instead of N squared.
+ *
+ * Weights are scaled to 16-bit fixed point and pixels widened to 16 bits, so SSE2's
+ * pmaddwd multiplies two taps of four channels and adds them in one instruction. The
+ * row pass of a separable kernel keeps 7 fractional bits in its 16-bit output, which
+ * the column pass reads the same way.
+ *
+ * The region is cut into TILE_SIZE tiles spread over the job system. Every tile reads a
+ * halo of kernel-radius pixels around itself from a copy of the region taken before
+ * any tile is written, so neighbouring tiles never see each other's results; past the
+ * image edge the edge pixel repeats.
+ */
+namespace Convolution {
+
+constexpr int MAX_SIZE = 15;     // Largest kernel side
+constexpr int TILE_SIZE = 64;    // Output tile per job
+
+struct Kernel {
+    int size = 1;                // Odd side length
+    std::vector<float> weights;  // size * size, row by row from the top
+    float bias = 0.0f;           // Added to every result, in 0-255 units
+
+    bool isValid() const;
+};
+
+Kernel identity();
+Kernel sharpen(float amount);    // Unsharp 3x3: the centre against its four neighbours
+Kernel emboss(float depth);      // Relief lit from the top left, on mid grey
+Kernel edgeDetect(float strength);
+Kernel boxBlur(int radius);
+
+/**
+ * @brief Split a kernel that is a column times a row into the two
+ * @return false when no such pair reproduces it to float rounding
+ */
+bool separate(const Kernel& kernel, std::vector<float>& column, std::vector<float>& row);
+
+/**
+ * @brief Convolve region of an RGBA8 image in place, keeping alpha
+ * @param bottomUp Rows are in texture order; the kernel is turned over to match
+ */
+void apply(Image& image, const Kernel& kernel, Rectangle region, bool bottomUp = false);
+
+} // namespace Convolution
+
+} // namespace EpiGimp
+
+#endif // CONVOLUTION_HPP
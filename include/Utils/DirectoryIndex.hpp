@@ -0,0 +1,140 @@
+//Background directory listings cached in memory and kept fresh with inotify
+#ifndef DIRECTORY_INDEX_HPP
+#define DIRECTORY_INDEX_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace EpiGimp {
+
+struct FileEntry {
+    std::string name;
+    std::string fullPath;
+    bool isDirectory;
+    size_t size;
+    int64_t modified;   // Last write time in filesystem clock ticks, 0 if unknown
+};
+
+/**
+ * @brief Directory contents listed on a worker thread and cached per directory
+ *
+ * request() returns at once. The first listing of a directory streams in batch by batch,
+ * so the UI can show the start of a huge or slow (network) directory while the rest is
+ * still being read. Listed directories are watched with inotify; a change marks the
+ * listing stale and the current directory is listed again in the background, with the
+ * old entries kept on screen until the new listing is complete.
+ *
+ * All methods are for the main thread; only the worker touches the filesystem.
+ */
+class DirectoryIndex {
+public:
+    static constexpr size_t DEFAULT_MAX_CACHED = 32;
+    static constexpr size_t BATCH_SIZE = 256;
+    static constexpr std::chrono::milliseconds BATCH_INTERVAL{30};   // Flush partial batches this often
+    static constexpr std::chrono::milliseconds REFRESH_INTERVAL{250}; // At most one relist per change burst
+
+    struct Listing {
+        std::vector<FileEntry> entries;  // Directory order; callers sort and filter
+        bool complete = false;
+        bool stale = false;              // Changed on disk since it was listed
+        std::string error;               // Set if the directory could not be read
+        uint64_t generation = 0;         // Bumped whenever entries, complete or error change
+    };
+
+private:
+    struct State {
+        Listing listing;
+        uint64_t jobId = 0;              // Latest listing job, older batches are ignored
+        bool busy = false;               // A job is queued or running
+        std::vector<FileEntry> incoming; // Relisting a complete directory: swapped in when done
+        int watch = -1;
+        uint64_t lastUsed = 0;
+        std::chrono::steady_clock::time_point lastStarted;
+    };
+
+    struct Job {
+        uint64_t id;
+        std::string path;
+    };
+
+    struct Batch {
+        uint64_t jobId;
+        std::string path;
+        std::vector<FileEntry> entries;
+        bool done;
+        bool cancelled;
+        std::string error;
+    };
+
+    size_t maxCached_;
+    std::unordered_map<std::string, State> states_;
+    std::unordered_map<int, std::vector<std::string>> watches_; // inotify watch descriptor -> paths of that inode
+    std::string current_;
+    uint64_t useClock_;
+    uint64_t nextJobId_;
+    int inotifyFd_;
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wakeWorker_;
+    bool stopping_;                       // Guarded by mutex_
+    std::deque<Job> jobs_;                // Guarded by mutex_
+    std::vector<Batch> batches_;          // Guarded by mutex_
+    std::atomic<uint64_t> cancelBelow_;   // Jobs with a smaller id stop early
+
+    void startListing(const std::string& path, State& state);
+    bool readEvents();
+    void evict();
+    void workerLoop();
+    void list(const Job& job);
+    void post(Batch batch);
+
+public:
+    explicit DirectoryIndex(size_t maxCached = DEFAULT_MAX_CACHED);
+    ~DirectoryIndex();
+
+    DirectoryIndex(const DirectoryIndex&) = delete;
+    DirectoryIndex& operator=(const DirectoryIndex&) = delete;
+
+    /**
+     * @brief Make path the current directory and list it unless a fresh listing is cached
+     */
+    void request(const std::string& path);
+
+    /**
+     * @brief Take streamed entries and change notifications; call once per frame
+     * @return true if any listing changed
+     */
+    bool update();
+
+    const Listing* find(const std::string& path) const;
+    void invalidate(const std::string& path);
+    bool isWatching() const { return inotifyFd_ >= 0; }
+    bool isBusy() const;                  // A listing is queued or running
+    size_t getCachedCount() const { return states_.size(); }
+
+    /**
+     * @brief Subsequence match of pattern in text, case-insensitive
+     * @return Higher for tighter matches (consecutive characters, word starts), nullopt if
+     *         some character of pattern is missing
+     */
+    static std::optional<int> fuzzyScore(const std::string& pattern, const std::string& text);
+
+    /**
+     * @brief Indices of the entries whose name matches pattern, best match first
+     */
+    static std::vector<size_t> fuzzyFilter(const std::string& pattern, const std::vector<FileEntry>& entries);
+};
+
+} // namespace EpiGimp
+
+#endif // DIRECTORY_INDEX_HPP
@@ -2,24 +2,25 @@
 #ifndef FILE_BROWSER_HPP
 #define FILE_BROWSER_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include "DirectoryIndex.hpp"
 
 namespace EpiGimp {
 
-struct FileEntry {
-    std::string name;
-    std::string fullPath;
-    bool isDirectory;
-    size_t size;
-};
+class ThumbnailCache;
 
 class FileBrowser {
 private:
     std::string currentPath_;
-    std::vector<FileEntry> entries_;
+    std::vector<FileEntry> entries_;  // Sorted, filtered view of the current listing
+    DirectoryIndex index_;
+    uint64_t viewGeneration_;         // Listing generation entries_ was built from
+    std::string filterText_;          // Type-ahead filter of the open dialog
     std::vector<std::string> supportedExtensions_;
     std::vector<std::string> tempExtensions_; // Temporary storage for extension filtering
     int selectedIndex_;
@@ -27,6 +28,8 @@ private:
     std::string inputBuffer_;
     std::string saveFileName_;  // Store the filename for save operations
     bool cancelled_;
+    int scrollOffset_;  // First entry shown in the list
+    std::unique_ptr<ThumbnailCache> thumbnails_;  // Created on first use by the open dialog
     
     double lastNavigationTime_;
     static constexpr double CLICK_DELAY_THRESHOLD = 0.3; // 300ms delay
@@ -35,12 +38,17 @@ private:
     static constexpr double BACKSPACE_DELAY_THRESHOLD = 0.1; // 100ms delay
     
     void loadDirectory();
+    void rebuildView();
+    void syncListing();
     bool hasValidExtension(const std::string& filename) const;
     bool canProcessClicks() const;
     bool canProcessBackspace() const;
+    void scrollList(int visibleItems);
+    void setSaveExtension(const std::string& extension);
     
 public:
     FileBrowser();
+    ~FileBrowser();
     
     void setPath(const std::string& path);
     void goUp();
@@ -54,8 +62,13 @@ public:
     bool renderSaveDialog(float x, float y, float width, float height);
     
     std::string getCurrentPath() const { return currentPath_; }
+    const std::vector<FileEntry>& getEntries() const { return entries_; }
+    void setFilter(const std::string& filter);
+    const std::string& getFilter() const { return filterText_; }
+    bool isLoading() const;           // The current directory is still being listed
     std::optional<std::string> getSelectedFile() const;
     std::string getSaveFileName() const;
+    void setDefaultSaveFileName(const std::string& name); // Pre-fills the filename field if it is empty
     
     void reset();
     bool isValidSelection() const;
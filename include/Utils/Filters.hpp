@@ -0,0 +1,72 @@
+//Whole-layer filters offered in the Filters menu
+#ifndef FILTERS_HPP
+#define FILTERS_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "raylib.h"
+#include "ToneLut.hpp"
+
+namespace EpiGimp {
+
+// A further value of a filter beside its amount, e.g. the end points of levels
+struct FilterSetting {
+    std::string name;
+    float value = 0.0f;
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    float step = 1.0f;
+};
+
+/**
+ * @brief A filter the canvas can preview and apply to the selected layer
+ *
+ * apply works in place on RGBA8 pixels in texture order and only needs to touch region.
+ * The canvas previews it on a downscaled copy of the layer; a filter whose amount is a
+ * distance in pixels is scaled down with it, so the preview looks like the result.
+ *
+ * Tone adjustments give a table instead of apply: each pixel depends on itself only, so
+ * the canvas can also refine their preview over the whole layer in the background.
+ */
+struct LayerFilter {
+    std::string name;
+    std::string amountName = "Amount";
+    float amount = 0.0f;                                   // Current strength
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    float step = 1.0f;                                     // Change per [ or ] key press
+    bool amountIsDistance = false;                         // Scale amount with the preview size
+    std::function<void(Image& pixels, Rectangle region, float amount, const std::vector<FilterSetting>& settings)> apply;
+    std::function<int(float amount)> reach;                // How far outside region apply reads, in pixels
+    std::vector<FilterSetting> settings;                   // Shown below the amount while previewing
+    std::function<ToneLut::Table(float amount, const std::vector<FilterSetting>& settings)> table;
+
+    bool isValid() const { return apply || table; }
+};
+
+namespace Filters {
+
+LayerFilter gaussianBlur(float sigma = 5.0f);
+LayerFilter sharpen(float amount = 1.0f);
+LayerFilter emboss(float depth = 1.0f);
+LayerFilter edgeDetect(float strength = 1.0f);
+
+// Tone adjustments
+LayerFilter levels(int black = 0, int white = 255, float gamma = 1.0f, int outBlack = 0, int outWhite = 255);
+LayerFilter curves(float contrast = 32.0f);     // S-curve through the quarter tones
+LayerFilter invert();
+LayerFilter posterize(int levels = 4);
+LayerFilter threshold(int level = 128);
+LayerFilter hueSaturation(float hue = 0.0f, float saturation = 0.0f, float lightness = 0.0f);   // Percentages for the last two
+
+/**
+ * @brief Run filter over region with amount, through its table or its apply
+ */
+void run(const LayerFilter& filter, Image& pixels, Rectangle region, float amount);
+
+} // namespace Filters
+
+} // namespace EpiGimp
+
+#endif // FILTERS_HPP
@@ -0,0 +1,75 @@
+//Scanline flood fill for the bucket tool and magic wand
+#ifndef FLOOD_FILL_HPP
+#define FLOOD_FILL_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "raylib.h"
+#include "../Core/SelectionMask.hpp"
+
+namespace EpiGimp {
+
+/*
+ * Span-based scanline fill: a stack of (row, column range) seeds instead of per-pixel
+ * recursion. A seed scans its row for pixels that match the seed colour, extends each
+ * match to the full run of matching pixels and queues the rows above and below under
+ * that run. Runs are always taken whole, so a run is either entirely filled or not
+ * at all and the visited set only needs checking at a run's first pixel.
+ *
+ * The colour test (every channel within tolerance of the seed colour, alpha included)
+ * runs on four pixels at a time with SSE2 where available.
+ *
+ * The magic wand reuses both: the contiguous variant writes the same runs straight into
+ * a selection mask, the global one thresholds every tile of the image in parallel.
+ */
+namespace FloodFill {
+
+struct Options {
+    int tolerance = 32;       // Largest per-channel difference from the seed colour, 0-255
+    bool antialias = true;    // Soften the rim of the region by one pixel
+};
+
+using SpanCallback = std::function<void(int y, int x0, int x1)>;   // Inclusive columns
+
+/**
+ * @brief Visit the runs of the region connected to (x, y), each pixel exactly once
+ * @param source RGBA8, row-major
+ * @return Number of pixels in the region, 0 if the seed is outside the image
+ */
+size_t forEachSpan(const Image& source, int x, int y, int tolerance, const SpanCallback& span);
+
+/**
+ * @brief Coverage of the region connected to (x, y)
+ * @param bounds Receives the covered area, rim included
+ * @return width * height bytes: 255 inside, partial on the anti-aliased rim, 0 elsewhere;
+ *         empty if the seed is outside the image
+ */
+std::vector<uint8_t> regionMask(const Image& source, int x, int y, const Options& options, Rectangle* bounds = nullptr);
+
+/**
+ * @brief Composite color over target wherever mask covers it, within bounds
+ * @param target RGBA8, same size as the mask
+ */
+void fillMask(Image& target, const std::vector<uint8_t>& mask, Color color, Rectangle bounds);
+
+bool withinTolerance(Color a, Color b, int tolerance);
+
+/**
+ * @brief Magic wand: the region connected to (x, y) as a selection of the source's size
+ * @param x, y Seed in source pixels
+ * @param bottomUp Source rows are in texture order; the mask is always top-down
+ * @return Empty mask if the seed is outside the image
+ */
+SelectionMask selectRegion(const Image& source, int x, int y, int tolerance, bool bottomUp);
+
+/**
+ * @brief Magic wand, global: every pixel within tolerance of the seed colour, connected or not
+ */
+SelectionMask selectSimilar(const Image& source, int x, int y, int tolerance, bool bottomUp);
+
+} // namespace FloodFill
+
+} // namespace EpiGimp
+
+#endif // FLOOD_FILL_HPP
@@ -0,0 +1,57 @@
+//Recursive Gaussian blur for whole layers
+#ifndef GAUSSIAN_BLUR_HPP
+#define GAUSSIAN_BLUR_HPP
+
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Young and van Vliet's recursive Gaussian: a third-order IIR filter run forward then
+ * backward over every row and then every column. Each output costs the same handful of
+ * multiply-adds whatever the sigma, where a convolution kernel grows with it.
+ *
+ * The filter is kept factored, a first-order section for its real pole and a second-
+ * order one for its complex pair, with the poles scaled to sigma as in van Vliet, Young
+ * and Verbeek. Multiplied out into one third-order recursion, the three poles crowd
+ * together near 1 as sigma grows and float rounding wrecks the result well before
+ * sigma 200; each section on its own stays accurate.
+ *
+ * Colours are weighted by alpha (premultiplied) while they are blurred, so transparent
+ * pixels do not bleed black into their neighbours. Rows are independent, and so are
+ * columns, so both passes are split across the shared job system. Each pass filters
+ * several lines side by side, four rows interleaved pixel by pixel or a strip of sixteen
+ * columns, so their recursions overlap in SSE registers (AVX when the build enables it)
+ * instead of waiting on one another.
+ *
+ * The pixels between the passes are kept as premultiplied 8-bit in place, so a 16k layer
+ * needs no float copy of itself.
+ */
+namespace GaussianBlur {
+
+constexpr float MIN_SIGMA = 0.5f;    // Below this the filter is left out: there is nothing to blur
+constexpr float MAX_SIGMA = 500.0f;  // Float sections lose accuracy past this
+
+// r[n] = realGain * x[n] + real * r[n-1], then u[n] = pairGain * r[n] + c1 * u[n-1] + c2 * u[n-2]
+struct Coefficients {
+    float real;
+    float realGain;
+    float c1;
+    float c2;
+    float pairGain;
+};
+
+Coefficients coefficients(float sigma);   // Sigma is clamped to [MIN_SIGMA, MAX_SIGMA]
+
+/**
+ * @brief Blur an RGBA8 image in place
+ * @param region Part to blur, clipped to the image; its edges count as extending outward
+ */
+void blur(Image& image, float sigma, Rectangle region);
+void blur(Image& image, float sigma);
+
+} // namespace GaussianBlur
+
+} // namespace EpiGimp
+
+#endif // GAUSSIAN_BLUR_HPP
@@ -0,0 +1,92 @@
+//Minimal JSON value with a parser and a compact writer
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace EpiGimp {
+
+/**
+ * @brief Just enough JSON for the control protocol
+ *
+ * Numbers are doubles, objects keep their keys sorted so output is deterministic.
+ * Accessors never throw: asking for the wrong type returns the fallback, and looking up
+ * a missing key returns a shared null value.
+ */
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    using Array = std::vector<JsonValue>;
+    using Object = std::map<std::string, JsonValue>;
+
+private:
+    Type type_;
+    bool bool_;
+    double number_;
+    std::string string_;
+    Array array_;
+    Object object_;
+
+public:
+    JsonValue() : type_(Type::Null), bool_(false), number_(0.0) {}
+    JsonValue(bool value) : type_(Type::Bool), bool_(value), number_(0.0) {}
+    JsonValue(int value) : type_(Type::Number), bool_(false), number_(value) {}
+    JsonValue(int64_t value) : type_(Type::Number), bool_(false), number_(static_cast<double>(value)) {}
+    JsonValue(size_t value) : type_(Type::Number), bool_(false), number_(static_cast<double>(value)) {}
+    JsonValue(double value) : type_(Type::Number), bool_(false), number_(value) {}
+    JsonValue(const char* value) : type_(Type::String), bool_(false), number_(0.0), string_(value) {}
+    JsonValue(std::string value) : type_(Type::String), bool_(false), number_(0.0), string_(std::move(value)) {}
+    JsonValue(Array value) : type_(Type::Array), bool_(false), number_(0.0), array_(std::move(value)) {}
+    JsonValue(Object value) : type_(Type::Object), bool_(false), number_(0.0), object_(std::move(value)) {}
+
+    static JsonValue array() { return JsonValue(Array{}); }
+    static JsonValue object() { return JsonValue(Object{}); }
+
+    /**
+     * @brief Parse one complete JSON document
+     * @return std::nullopt on malformed input, described in error
+     */
+    static std::optional<JsonValue> parse(const std::string& text, std::string* error = nullptr);
+
+    // Single-line output, safe to use as a newline-delimited message
+    std::string dump() const;
+
+    Type type() const { return type_; }
+    bool isNull() const { return type_ == Type::Null; }
+    bool isBool() const { return type_ == Type::Bool; }
+    bool isNumber() const { return type_ == Type::Number; }
+    bool isString() const { return type_ == Type::String; }
+    bool isArray() const { return type_ == Type::Array; }
+    bool isObject() const { return type_ == Type::Object; }
+
+    bool asBool(bool fallback = false) const { return isBool() ? bool_ : fallback; }
+    double asNumber(double fallback = 0.0) const { return isNumber() ? number_ : fallback; }
+    int asInt(int fallback = 0) const { return isNumber() ? static_cast<int>(number_) : fallback; }
+    const std::string& asString() const;
+    const Array& asArray() const;
+    const Object& asObject() const;
+
+    bool has(const std::string& key) const { return isObject() && object_.count(key) != 0; }
+    const JsonValue& operator[](const std::string& key) const;
+    const JsonValue& operator[](size_t index) const;
+    size_t size() const { return isArray() ? array_.size() : isObject() ? object_.size() : 0; }
+
+    JsonValue& set(const std::string& key, JsonValue value);   // Turns null into an object
+    JsonValue& push(JsonValue value);                          // Turns null into an array
+
+    bool operator==(const JsonValue& other) const;
+    bool operator!=(const JsonValue& other) const { return !(*this == other); }
+
+private:
+    void dumpTo(std::string& out) const;
+};
+
+} // namespace EpiGimp
+
+#endif // JSON_HPP
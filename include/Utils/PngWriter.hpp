@@ -0,0 +1,45 @@
+//Multi-threaded PNG encoder for large exports
+#ifndef PNG_WRITER_HPP
+#define PNG_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Scanlines are cut into chunks of a few hundred KiB. Each chunk is filtered and deflated
+ * on its own thread as a raw deflate stream primed with the previous chunk's last 32 KiB
+ * (so the ratio barely suffers) and ended with a sync flush, which byte-aligns it. The
+ * chunks are then simply concatenated behind one zlib header, with the Adler-32 of the
+ * whole stream combined from the per-chunk checksums.
+ */
+namespace PngWriter {
+
+constexpr int DEFAULT_COMPRESSION_LEVEL = 6;
+
+struct Options {
+    int compressionLevel = DEFAULT_COMPRESSION_LEVEL;   // zlib level, 0 (store) to 9
+    unsigned threads = 0;                               // 0 uses every core
+    size_t chunkBytes = 256 * 1024;                     // Raw scanline bytes per deflate job
+};
+
+bool isPngPath(const std::string& filePath);
+
+/**
+ * @brief Encode an image as a PNG file in memory
+ *
+ * Images that are not RGBA8 are converted first; 8-bit RGBA is always written.
+ */
+bool encode(const Image& image, std::vector<uint8_t>& png, const Options& options = {});
+
+bool write(const Image& image, const std::string& filePath, const Options& options = {});
+
+} // namespace PngWriter
+
+} // namespace EpiGimp
+
+#endif // PNG_WRITER_HPP
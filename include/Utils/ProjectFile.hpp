@@ -0,0 +1,157 @@
+//Native .epg project format: tiled, compressed layers with an offset index
+#ifndef PROJECT_FILE_HPP
+#define PROJECT_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "raylib.h"
+#include "../Core/DocumentSnapshot.hpp"
+
+namespace EpiGimp {
+
+/*
+ * File layout (little-endian):
+ *
+ *   FileHeader                      magic, version, document size, tile size, table offsets
+ *   tile data                       zlib streams of raw RGBA8 tile rows, top-down
+ *   layer table                     per layer: flags, name length, name bytes
+ *   tile index                      per layer, row-major: TileEntry { offset, size }
+ *
+ * Layers are stored bottom to top; the background, if any, is the first layer and is
+ * flagged as such. Fully transparent tiles are not stored (size 0). The tables are written
+ * last, so the writer can stream tiles without knowing their compressed size up front.
+ */
+namespace ProjectFile {
+
+constexpr const char* EXTENSION = ".epg";
+constexpr uint32_t VERSION = 1;
+constexpr int DEFAULT_TILE_SIZE = 256;
+
+enum LayerFlags : uint32_t {
+    LAYER_VISIBLE = 1u << 0,
+    LAYER_FLIPPED_VERTICAL = 1u << 1,
+    LAYER_FLIPPED_HORIZONTAL = 1u << 2,
+    LAYER_BACKGROUND = 1u << 3
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tileSize;
+    uint32_t layerCount;
+    uint64_t layerTableOffset;
+    uint64_t tileIndexOffset;
+};
+
+struct TileEntry {
+    uint64_t offset;
+    uint32_t size;        // Compressed size, 0 for a fully transparent tile
+    uint32_t reserved;
+};
+
+bool isProjectPath(const std::string& filePath);
+
+/**
+ * @brief Write every layer of the snapshot, hidden ones included
+ *
+ * The file is written next to the target and renamed into place, so an interrupted
+ * save never leaves a truncated project behind.
+ * @param onBytesWritten Called after every chunk written, lets callers throttle the I/O
+ */
+bool write(const DocumentSnapshot& snapshot, const std::string& filePath, int tileSize = DEFAULT_TILE_SIZE,
+           const std::function<void(size_t)>& onBytesWritten = {});
+
+/**
+ * @brief Compress one tile of raw RGBA8 pixels the way project files store them
+ */
+bool compressTile(const std::vector<uint8_t>& pixels, std::vector<uint8_t>& compressed);
+
+/**
+ * @brief Inflate a stored tile, expectedSize is the raw RGBA8 size of the tile
+ */
+bool decompressTile(const uint8_t* data, size_t size, size_t expectedSize, std::vector<uint8_t>& pixels);
+
+} // namespace ProjectFile
+
+/**
+ * @brief Random access to the tiles of a project file
+ *
+ * The file is memory-mapped and only the header and tables are parsed on open; tiles
+ * are inflated on demand. All queries are const and safe to call from several threads.
+ */
+class ProjectReader {
+public:
+    struct LayerInfo {
+        std::string name;
+        bool visible;
+        bool flippedVertical;
+        bool flippedHorizontal;
+        bool isBackground;
+    };
+
+private:
+    int fileDescriptor_;
+    const uint8_t* mapping_;
+    size_t mappedSize_;
+    ProjectFile::FileHeader header_;
+    int tilesX_;
+    int tilesY_;
+    std::vector<LayerInfo> layers_;
+    const ProjectFile::TileEntry* tileIndex_;    // Points into the mapping
+
+    ProjectReader();
+
+public:
+    /**
+     * @brief Map and validate a project file
+     * @return nullptr if the file cannot be opened or is not a valid project, see error
+     */
+    static std::unique_ptr<ProjectReader> open(const std::string& filePath, std::string* error = nullptr);
+    ~ProjectReader();
+
+    ProjectReader(const ProjectReader&) = delete;
+    ProjectReader& operator=(const ProjectReader&) = delete;
+
+    int getWidth() const { return static_cast<int>(header_.width); }
+    int getHeight() const { return static_cast<int>(header_.height); }
+    int getTileSize() const { return static_cast<int>(header_.tileSize); }
+    int getTilesX() const { return tilesX_; }
+    int getTilesY() const { return tilesY_; }
+    size_t getLayerCount() const { return layers_.size(); }
+    const LayerInfo& getLayerInfo(size_t layer) const { return layers_[layer]; }
+    size_t getFileSize() const { return mappedSize_; }
+
+    Rectangle getTileRect(int tileX, int tileY) const;
+    bool isTileEmpty(size_t layer, int tileX, int tileY) const;
+
+    /**
+     * @brief Inflate one tile into RGBA8 rows, top-down, sized to getTileRect()
+     * @return false if the tile data is corrupt; empty tiles decode to transparent pixels
+     */
+    bool decodeTile(size_t layer, int tileX, int tileY, std::vector<uint8_t>& pixels) const;
+
+    /**
+     * @brief Decode a whole layer, mostly for tests and thumbnails
+     * @return RGBA8 image owned by the caller, Image{} on failure
+     */
+    Image decodeLayer(size_t layer) const;
+
+    /**
+     * @brief Flatten the visible layers the way an image export would
+     * @return RGBA8 image owned by the caller, Image{} on failure or if nothing is visible
+     */
+    Image composite() const;
+
+private:
+    const ProjectFile::TileEntry& tileEntry(size_t layer, int tileX, int tileY) const;
+};
+
+} // namespace EpiGimp
+
+#endif // PROJECT_FILE_HPP
@@ -0,0 +1,83 @@
+//Decodes project tiles on a worker thread for incremental upload
+#ifndef PROJECT_TILE_STREAMER_HPP
+#define PROJECT_TILE_STREAMER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ProjectFile.hpp"
+
+namespace EpiGimp {
+
+/**
+ * @brief Streams the tiles of an open project in a caller-chosen order
+ *
+ * The worker inflates tiles ahead of the consumer but stops once maxQueuedBytes of
+ * decoded pixels are waiting, so memory stays bounded no matter how large the file is.
+ * The main thread drains tiles with takeReady() and uploads them.
+ */
+class ProjectTileStreamer {
+public:
+    struct TileRequest {
+        size_t layer;
+        int tileX;
+        int tileY;
+    };
+
+    struct DecodedTile {
+        TileRequest request;
+        Rectangle rect;                  // Document pixels covered by the tile
+        std::vector<uint8_t> pixels;     // RGBA8, top-down
+        bool valid;                      // False if the tile data was corrupt
+    };
+
+    static constexpr size_t DEFAULT_QUEUE_BYTES = 16 * 1024 * 1024;
+
+private:
+    std::shared_ptr<const ProjectReader> reader_;
+    std::vector<TileRequest> order_;
+    size_t maxQueuedBytes_;
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable spaceAvailable_;
+    bool stopping_;                      // Guarded by mutex_
+    std::deque<DecodedTile> ready_;      // Guarded by mutex_
+    size_t queuedBytes_;                 // Guarded by mutex_
+    std::atomic<size_t> delivered_;
+
+public:
+    ProjectTileStreamer(std::shared_ptr<const ProjectReader> reader, std::vector<TileRequest> order,
+                        size_t maxQueuedBytes = DEFAULT_QUEUE_BYTES);
+    ~ProjectTileStreamer();
+
+    ProjectTileStreamer(const ProjectTileStreamer&) = delete;
+    ProjectTileStreamer& operator=(const ProjectTileStreamer&) = delete;
+
+    /**
+     * @brief Take decoded tiles, at least one if available, up to byteBudget pixels bytes
+     */
+    std::vector<DecodedTile> takeReady(size_t byteBudget);
+
+    /**
+     * @brief Block until every remaining tile is decoded and return them
+     */
+    std::vector<DecodedTile> takeAll();
+
+    bool isFinished() const { return delivered_.load() == order_.size(); }
+    size_t getTotalTiles() const { return order_.size(); }
+    float getProgress() const { return order_.empty() ? 1.0f : static_cast<float>(delivered_.load()) / order_.size(); }
+    const ProjectReader& getReader() const { return *reader_; }
+
+private:
+    void workerLoop();
+};
+
+} // namespace EpiGimp
+
+#endif // PROJECT_TILE_STREAMER_HPP
@@ -0,0 +1,47 @@
+//QOI ("Quite OK Image") encoder and decoder for fast scratch saves
+#ifndef QOI_CODEC_HPP
+#define QOI_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Standard QOI streams (https://qoiformat.org), readable by any QOI decoder.
+ *
+ * Encoding is split into horizontal stripes encoded in parallel. Every stripe starts from
+ * the true previous pixel, so runs and diffs work across the seam; only the 64-entry
+ * colour index is unknown there, so a stripe emits index ops only for slots it filled
+ * itself. The decoder's index holds the same values for those slots, which keeps the
+ * concatenated stripes a valid stream. Decoding a QOI stream is inherently sequential.
+ */
+namespace QoiCodec {
+
+constexpr const char* EXTENSION = ".qoi";
+
+bool isQoiPath(const std::string& filePath);
+
+/**
+ * @brief Encode as 4-channel QOI; non-RGBA8 images are converted first
+ * @param threads Worker count, 0 uses every core
+ */
+bool encode(const Image& image, std::vector<uint8_t>& qoi, unsigned threads = 0);
+
+/**
+ * @brief Decode a QOI stream into an RGBA8 image owned by the caller
+ * @return Image{} if the data is not valid QOI
+ */
+Image decode(const uint8_t* data, size_t size);
+
+bool write(const Image& image, const std::string& filePath, unsigned threads = 0);
+Image read(const std::string& filePath);
+
+} // namespace QoiCodec
+
+} // namespace EpiGimp
+
+#endif // QOI_CODEC_HPP
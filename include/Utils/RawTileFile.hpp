@@ -0,0 +1,70 @@
+//Raw tiled image dump (.ert) for fast scratch saves
+#ifndef RAW_TILE_FILE_HPP
+#define RAW_TILE_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * File layout (little-endian):
+ *
+ *   FileHeader                      magic, version, image size, tile size
+ *   TileEntry[tilesX * tilesY]      row-major: offset, stored size, encoding
+ *   tile data                       RGBA8 tile rows, top-down, raw or run-length encoded
+ *
+ * Tiles are independent, so both directions run on every core and the raw path is little
+ * more than a memcpy. With RLE enabled a tile is stored run-length encoded only when that
+ * is smaller; runs are packets of a header byte (high bit set: next pixel repeated
+ * (h & 0x7F) + 1 times, clear: h + 1 literal pixels follow).
+ */
+namespace RawTileFile {
+
+constexpr const char* EXTENSION = ".ert";
+constexpr uint32_t VERSION = 1;
+constexpr int DEFAULT_TILE_SIZE = 256;
+
+enum TileEncoding : uint32_t {
+    TILE_RAW = 0,
+    TILE_RLE = 1
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tileSize;
+    uint32_t reserved;
+};
+
+struct TileEntry {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t encoding;
+};
+
+struct Options {
+    bool rle = true;
+    int tileSize = DEFAULT_TILE_SIZE;
+    unsigned threads = 0;     // 0 uses every core
+};
+
+bool isRawTilePath(const std::string& filePath);
+
+bool write(const Image& image, const std::string& filePath, const Options& options = {});
+
+/**
+ * @brief Read a whole dump back
+ * @return RGBA8 image owned by the caller, Image{} if the file is missing or corrupt
+ */
+Image read(const std::string& filePath, unsigned threads = 0);
+
+} // namespace RawTileFile
+
+} // namespace EpiGimp
+
+#endif // RAW_TILE_FILE_HPP
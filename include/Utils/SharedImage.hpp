@@ -0,0 +1,157 @@
+//Images in POSIX shared memory or memfd buffers for zero-copy exchange between processes
+#ifndef SHARED_IMAGE_HPP
+#define SHARED_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Buffer layout:
+ *
+ *   SharedImageHeader               magic, version, size, stride, format, data offset
+ *   padding                         up to dataOffset (64-byte aligned)
+ *   pixels                          height rows of stride bytes, top-down
+ *
+ * Any process that maps the buffer reads the pixels in place. Buffers are either named
+ * POSIX shared memory objects ("/name", listed under /dev/shm) or anonymous memfds, which
+ * another process of the same user reaches through /proc/<pid>/fd/<fd>.
+ */
+struct SharedImageHeader {
+    char magic[4];          // "EPSH"
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;        // Bytes per row, at least width * 4
+    uint32_t format;        // SharedImageFormat
+    uint64_t dataOffset;    // From the start of the buffer
+    uint64_t generation;    // Bumped by writers after each update, lets readers notice changes
+};
+
+enum SharedImageFormat : uint32_t {
+    SHARED_FORMAT_RGBA8 = 1
+};
+
+/**
+ * @brief A mapped shared image buffer; unmapped (and closed) on destruction
+ *
+ * The header is validated once when the buffer is mapped and every accessor works from
+ * that copy, so a peer rewriting the shared header cannot move the pixels outside the
+ * mapping. refresh() re-reads and re-validates it after the generation changed.
+ */
+class SharedImageBuffer {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t DATA_ALIGNMENT = 64;
+
+private:
+    std::string name_;
+    int fd_;
+    uint8_t* mapping_;
+    size_t size_;
+    bool writable_;
+    SharedImageHeader header_;     // Validated copy, never the live header
+
+    SharedImageBuffer(std::string name, int fd, uint8_t* mapping, size_t size, bool writable,
+                      const SharedImageHeader& header)
+        : name_(std::move(name)), fd_(fd), mapping_(mapping), size_(size), writable_(writable), header_(header) {}
+
+public:
+    ~SharedImageBuffer();
+
+    SharedImageBuffer(const SharedImageBuffer&) = delete;
+    SharedImageBuffer& operator=(const SharedImageBuffer&) = delete;
+
+    /**
+     * @brief Create a named shared memory object ("/name"); fails if it already exists
+     */
+    static std::unique_ptr<SharedImageBuffer> create(const std::string& name, int width, int height,
+                                                     std::string* error = nullptr);
+
+    /**
+     * @brief Create an anonymous memfd buffer; share it through getProcPath() or by passing the fd
+     */
+    static std::unique_ptr<SharedImageBuffer> createAnonymous(int width, int height, std::string* error = nullptr);
+
+    /**
+     * @brief Map an existing buffer
+     * @param name "/name" for a shared memory object, or a filesystem path such as
+     *             /proc/<pid>/fd/<fd> or /dev/shm/<name>
+     */
+    static std::unique_ptr<SharedImageBuffer> open(const std::string& name, bool writable = false,
+                                                   std::string* error = nullptr);
+
+    /**
+     * @brief Remove a named shared memory object; existing mappings stay valid
+     */
+    static bool unlink(const std::string& name);
+
+    const SharedImageHeader& header() const { return header_; }
+    int getWidth() const { return static_cast<int>(header_.width); }
+    int getHeight() const { return static_cast<int>(header_.height); }
+    size_t getStride() const { return header_.stride; }
+    const uint8_t* pixels() const { return mapping_ + header_.dataOffset; }
+    uint8_t* mutablePixels() { return writable_ ? mapping_ + header_.dataOffset : nullptr; }
+    size_t getMappedSize() const { return size_; }
+    const std::string& getName() const { return name_; }
+    int getFd() const { return fd_; }
+    std::string getProcPath() const;     // /proc/<pid>/fd/<fd>, valid while this buffer lives
+
+    /**
+     * @brief Generation currently stored in the shared header, which peers may have bumped
+     */
+    uint64_t liveGeneration() const;
+
+    /**
+     * @brief Re-read the shared header if its generation moved on
+     * @return false if the new header is invalid; the previous one is kept in that case
+     */
+    bool refresh(std::string* error = nullptr);
+
+    /**
+     * @brief Raylib view of the mapped pixels, no copy
+     *
+     * Only valid while the buffer is mapped, and never to be passed to UnloadImage.
+     * Requires rows without padding (stride == width * 4); returns Image{} otherwise.
+     */
+    Image view() const;
+
+    /**
+     * @brief Copy an RGBA8 image into the buffer and bump the generation
+     */
+    bool write(const Image& image);
+
+    /**
+     * @brief Copy the pixels out into an owned RGBA8 image
+     */
+    Image copy() const;
+};
+
+namespace SharedImage {
+
+/**
+ * @brief Publish an image under a shared memory name, replacing an older object of that name
+ */
+std::unique_ptr<SharedImageBuffer> publish(const std::string& name, const Image& image, std::string* error = nullptr);
+
+/**
+ * @brief Entry point for `EpiGimp --shm ...`; returns the process exit code
+ *
+ *   --shm put NAME FILE     load an image file into shared memory
+ *   --shm get NAME FILE     write a shared image to a file
+ *   --shm info NAME         print the header
+ *   --shm remove NAME       unlink a named buffer
+ */
+int runCommand(const std::vector<std::string>& args);
+
+} // namespace SharedImage
+
+} // namespace EpiGimp
+
+#endif // SHARED_IMAGE_HPP
@@ -0,0 +1,100 @@
+//Row-by-row PNG and BMP decoding without a full-size intermediate image
+#ifndef STREAMING_DECODER_HPP
+#define STREAMING_DECODER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/**
+ * @brief Decodes an image file a band of rows at a time, top to bottom, as RGBA8
+ *
+ * Only the file buffer, the zlib window and a row or two of state are kept, so the
+ * caller decides where the pixels go: straight into the final image, into a texture
+ * band or through a RowDownscaler. Supported:
+ *
+ *   PNG  every colour type and bit depth, tRNS transparency; not interlaced
+ *   BMP  1, 4, 8 (palette), 24 and 32 bit, uncompressed or bitfields, either row order
+ *
+ * Anything else makes open() return nullptr, and callers fall back to raylib.
+ */
+class StreamingDecoder {
+public:
+    using ProgressCallback = std::function<bool(float progress)>;   // Return false to abort
+
+    virtual ~StreamingDecoder() = default;
+
+    static bool canStream(const std::string& filePath);    // By extension
+
+    /**
+     * @brief Read the header and prepare to decode
+     * @return nullptr if the file is not a PNG or BMP this decoder handles
+     */
+    static std::unique_ptr<StreamingDecoder> open(const std::string& filePath, std::string* error = nullptr);
+
+    /**
+     * @brief Decode the rest of the image into a new RGBA8 image
+     * @param maxWidth, maxHeight Area-average rows down to fit while decoding (0 = full size)
+     * @return Image owned by the caller, Image{} on error or when onProgress aborts
+     */
+    static Image decode(StreamingDecoder& decoder, int maxWidth = 0, int maxHeight = 0,
+                        const ProgressCallback& onProgress = {});
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    int getRowsRead() const { return rowsRead_; }
+
+    /**
+     * @brief Decode the next count rows into rgba (count * width * 4 bytes)
+     */
+    bool readRows(uint8_t* rgba, int count);
+
+protected:
+    int width_ = 0;
+    int height_ = 0;
+    int rowsRead_ = 0;
+
+    virtual bool readRow(uint8_t* rgba) = 0;
+};
+
+/**
+ * @brief Area-average downscaler fed one source row at a time
+ *
+ * Each source pixel falls in exactly one target box. Colours are weighted by alpha, so
+ * transparent pixels do not darken edges. Finished target rows are written to output
+ * (targetWidth * targetHeight * 4 bytes, owned by the caller) as soon as their last
+ * source row arrives.
+ */
+class RowDownscaler {
+private:
+    int sourceWidth_;
+    int sourceHeight_;
+    int targetWidth_;
+    int targetHeight_;
+    uint8_t* output_;
+    std::vector<int> targetColumn_;      // Source x -> target x
+    std::vector<int> columnCount_;       // Source columns per target column
+    std::vector<uint64_t> sums_;         // r*a, g*a, b*a, a per target column
+    int sourceRow_;
+    int targetRow_;
+    int rowsInBox_;                      // Source rows summed into the current target row
+    int rowEnd_;                         // First source row of the next target row
+
+public:
+    RowDownscaler(int sourceWidth, int sourceHeight, int targetWidth, int targetHeight, uint8_t* output);
+
+    void push(const uint8_t* rows, int count);
+    bool isComplete() const { return targetRow_ >= targetHeight_; }
+
+private:
+    void emitRow();
+};
+
+} // namespace EpiGimp
+
+#endif // STREAMING_DECODER_HPP
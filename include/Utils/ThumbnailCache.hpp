@@ -0,0 +1,140 @@
+//Background-decoded image thumbnails with an on-disk cache
+#ifndef THUMBNAIL_CACHE_HPP
+#define THUMBNAIL_CACHE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "raylib.h"
+#include "../Core/RaylibWrappers.hpp"
+
+namespace EpiGimp {
+
+/**
+ * @brief Thumbnails for file lists, decoded off the UI thread
+ *
+ * request() is called every frame for the rows that are on screen and returns the
+ * texture once it is ready. Misses are queued and decoded on the shared JobSystem, newest
+ * first; a queued request that was not repeated in the previous frame (the row scrolled
+ * away) is dropped before it is decoded. Each thumbnail is downscaled right after decode
+ * and stored as QOI in the cache directory under a hash of path, size and modification
+ * time, so a file is only ever decoded in full once.
+ *
+ * Decoding takes at most half the workers, and each decode job hands its worker back
+ * after a small batch so other jobs are not starved while a large folder is scrolled.
+ * The cache directory is kept under a byte limit: a hit refreshes the file's
+ * modification time and the oldest files are removed first.
+ *
+ * update() uploads a bounded number of finished thumbnails per frame and evicts the
+ * least recently shown textures beyond the capacity. Main thread only, apart from the
+ * decode jobs' own state.
+ */
+class ThumbnailCache {
+public:
+    static constexpr int DEFAULT_SIZE = 96;                 // Longest side in pixels
+    static constexpr size_t DEFAULT_CAPACITY = 512;         // Textures kept on the GPU
+    static constexpr int DEFAULT_UPLOADS_PER_FRAME = 8;
+    static constexpr uint64_t DEFAULT_DISK_LIMIT = 256ull << 20;   // Bytes of QOI files in the cache directory
+    static constexpr size_t DECODE_BATCH = 8;                      // Thumbnails per decode job
+
+private:
+    enum class State { Queued, Ready, Failed };
+
+    struct Entry {
+        State state;
+        uint64_t lastRequested;                      // Frame of the latest request()
+        std::optional<TextureResource> texture;
+    };
+
+    struct Job {
+        std::string key;
+        std::string path;
+    };
+
+    struct Result {
+        std::string key;
+        Image image;                                 // Image{} if the file could not be decoded
+        bool dropped;                                // Scrolled away before decoding started
+    };
+
+    std::string directory_;
+    int size_;
+    size_t capacity_;
+    uint64_t diskLimit_;
+
+    unsigned maxDecoders_;                           // Decode jobs on the JobSystem at once
+    std::mutex mutex_;
+    std::condition_variable decodersDone_;
+    bool stopping_;                                  // Guarded by mutex_
+    std::deque<Job> queue_;                          // Guarded by mutex_, newest at the back
+    std::unordered_map<std::string, uint64_t> wanted_; // Guarded by mutex_: key -> frame last requested
+    std::vector<Result> results_;                    // Guarded by mutex_
+    size_t decoders_;                                // Guarded by mutex_: decode jobs submitted, not finished
+    std::atomic<uint64_t> frame_;
+    std::atomic<uint64_t> diskBytes_;                // Cache directory size, counted up between trims
+    std::atomic<bool> diskMeasured_;                 // First store of the session measures and trims
+    std::atomic<bool> trimming_;
+
+    // Main thread only
+    std::unordered_map<std::string, Entry> entries_;
+    std::deque<Result> uploads_;
+    size_t textureCount_;
+
+public:
+    /**
+     * @param cacheDirectory Where thumbnails are stored, empty for the per-user cache directory
+     * @param workers Thumbnails decoded at once, 0 for half the JobSystem workers
+     * @param diskLimit Bytes the cache directory may hold before the oldest thumbnails are removed
+     */
+    explicit ThumbnailCache(std::string cacheDirectory = "", int size = DEFAULT_SIZE, unsigned workers = 0,
+                            size_t capacity = DEFAULT_CAPACITY, uint64_t diskLimit = DEFAULT_DISK_LIMIT);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    /**
+     * @brief Texture for the file if it is ready, otherwise queue it and return nullptr
+     * @param fileSize, modified Part of the cache key, so edited files get a new thumbnail
+     */
+    const Texture2D* request(const std::string& path, uint64_t fileSize, int64_t modified);
+
+    /**
+     * @brief Upload finished thumbnails and evict old ones; call once per frame
+     */
+    void update(int uploadBudget = DEFAULT_UPLOADS_PER_FRAME);
+
+    bool isIdle();                       // Nothing queued, decoding or waiting for upload
+    bool hasFailed(const std::string& path, uint64_t fileSize, int64_t modified) const;
+    size_t getTextureCount() const { return textureCount_; }
+    int getSize() const { return size_; }
+    unsigned getDecoderLimit() const { return maxDecoders_; }
+    const std::string& getDirectory() const { return directory_; }
+
+    static std::string cacheKey(const std::string& path, uint64_t fileSize, int64_t modified);
+    static std::string defaultDirectory();
+
+    /**
+     * @brief Area-average an RGBA8 image down to fit maxSize, keeping the aspect ratio
+     * @return New image owned by the caller; a copy if it already fits
+     */
+    static Image downscale(const Image& source, int maxSize);
+
+private:
+    void startDecoders();                            // Called with mutex_ held
+    void decodeQueued();
+    Image decode(const Job& job);
+    void store(const Image& thumbnail, const std::string& cachePath);
+    void trimDisk();
+    void evict();
+};
+
+} // namespace EpiGimp
+
+#endif // THUMBNAIL_CACHE_HPP
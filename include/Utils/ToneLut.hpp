@@ -0,0 +1,80 @@
+//Per-channel lookup tables for tone adjustments
+#ifndef TONE_LUT_HPP
+#define TONE_LUT_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "raylib.h"
+
+namespace EpiGimp {
+
+/*
+ * Levels, curves, invert, posterize and threshold all send each 8-bit channel value to
+ * another one, whatever the neighbouring pixels hold. Each is built once as a 256-entry
+ * table per channel, and applying any of them (or a chain of them, see then()) is one
+ * lookup per byte.
+ *
+ * With AVX2 the lookup is a gather: the four tables are widened to 32-bit words already
+ * shifted into their byte lane, so eight pixels take four gathers and three ORs. Without
+ * it a byte lookup per channel is the fastest there is; pshufb only reaches 16 entries
+ * and would need sixteen shuffles and blends per byte to cover 256.
+ *
+ * Rows are split into bands of BAND_ROWS spread over the job system.
+ */
+namespace ToneLut {
+
+constexpr int BAND_ROWS = 64;    // Rows per job
+
+struct Table {
+    std::array<std::array<uint8_t, 256>, 4> channels;   // Red, green, blue, alpha
+
+    bool isIdentity() const;
+};
+
+Table identity();
+
+/**
+ * @brief Stretch black..white to outBlack..outWhite, with gamma bending the mid tones
+ * @param gamma Above 1 brightens, below 1 darkens
+ * @param outBlack,outWhite Output range; swapped, they invert
+ */
+Table levels(int black, int white, float gamma, int outBlack = 0, int outWhite = 255);
+
+/**
+ * @brief Smooth monotone curve through points (x input, y output, both 0-255)
+ *
+ * Points are sorted by x; the curve is flat before the first and after the last one.
+ * Between them it never overshoots, so a curve through rising points keeps rising.
+ */
+Table curves(std::vector<Vector2> points);
+
+Table invert();
+Table posterize(int levels);                 // levels values per channel, 2-255
+Table threshold(int level);                  // Each colour channel to 0 below level, 255 from it
+
+/**
+ * @brief first followed by second, as one table
+ */
+Table then(const Table& first, const Table& second);
+
+/**
+ * @brief Look up region of an RGBA8 image in place
+ */
+void apply(Image& image, const Table& table, Rectangle region);
+
+/**
+ * @brief Look up region of source into the same pixels of destination (same size, RGBA8)
+ */
+void map(const Image& source, Image& destination, const Table& table, Rectangle region);
+
+/**
+ * @brief Luminance histogram of an RGBA8 image
+ */
+std::array<uint32_t, 256> histogram(const Image& image);
+
+} // namespace ToneLut
+
+} // namespace EpiGimp
+
+#endif // TONE_LUT_HPP
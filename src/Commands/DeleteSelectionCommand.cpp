@@ -5,19 +5,20 @@
 namespace EpiGimp {
 
 DeleteSelectionCommand::DeleteSelectionCommand(Canvas* canvas, const std::string& description)
-    : canvas_(canvas), targetLayerIndex_(0), selectionRect_{0, 0, 0, 0}, description_(description)
+    : canvas_(canvas), selectionRect_{0, 0, 0, 0}, description_(description)
 {
     if (!canvas_) {
         throw std::invalid_argument("Canvas cannot be null");
     }
     
-    // Store current layer index and selection rectangle
-    targetLayerIndex_ = canvas_->getSelectedLayerIndex();
+    // Store current layer and selection rectangle
+    targetLayer_ = canvas_->getSelectedLayerHandle();
     if (canvas_->hasSelection()) {
         selectionRect_ = canvas_->getSelectionRect();
+        selectionMask_ = canvas_->getSelectionMask();
     }
     
-    std::cout << "DeleteSelectionCommand: Created for layer " << targetLayerIndex_ 
+    std::cout << "DeleteSelectionCommand: Created for layer " << canvas_->getSelectedLayerIndex() 
               << " with selection (" << selectionRect_.x << "," << selectionRect_.y 
               << ") " << selectionRect_.width << "x" << selectionRect_.height << std::endl;
 }
@@ -37,8 +38,13 @@ bool DeleteSelectionCommand::execute()
         captureBeforeState();
     }
     
-    // Perform the deletion
-    canvas_->deleteSelectionInternal();
+    // Perform the deletion on the recorded layer and region, so redo works after reorders
+    if (!canvas_->clearLayerMask(targetLayer_, selectionMask_)) {
+        std::cout << "DeleteSelectionCommand: Cannot execute - layer not available" << std::endl;
+        return false;
+    }
+    if (canvas_->hasSelection())
+        canvas_->clearSelection();
     
     // Capture after state
     captureAfterState();
@@ -56,26 +62,12 @@ bool DeleteSelectionCommand::undo()
     
     std::cout << "DeleteSelectionCommand: Performing undo..." << std::endl;
     
-    // Get the target layer
-    auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Restore the before state to the layer
+    if (!canvas_->restoreLayerImage(targetLayer_, *beforeState_)) {
         std::cout << "DeleteSelectionCommand: Cannot undo - layer or texture not available" << std::endl;
         return false;
     }
     
-    // Restore the before state to the layer
-    layer->texture->beginDrawing();
-    
-    // Clear the render texture first
-    ClearBackground(Color{0, 0, 0, 0});
-    
-    // Load the before state as a texture and draw it
-    Texture2D beforeTexture = LoadTextureFromImage(*beforeState_);
-    DrawTexture(beforeTexture, 0, 0, WHITE);
-    UnloadTexture(beforeTexture);
-    
-    layer->texture->endDrawing();
-    
     std::cout << "DeleteSelectionCommand: Undo successful" << std::endl;
     return true;
 }
@@ -92,30 +84,18 @@ bool DeleteSelectionCommand::canExecute() const
 
 void DeleteSelectionCommand::captureBeforeState()
 {
-    if (targetLayerIndex_ >= static_cast<size_t>(canvas_->getLayerCount())) {
-        std::cout << "DeleteSelectionCommand: Invalid layer index, cannot capture before state" << std::endl;
-        return;
-    }
-    
     std::cout << "DeleteSelectionCommand: Capturing before state..." << std::endl;
     
-    const auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Get the pixel data of the target layer, already flipped to top-down order
+    Image layerImage = canvas_->copyLayerImage(targetLayer_);
+    if (!layerImage.data) {
         std::cout << "DeleteSelectionCommand: Failed to capture before state - no layer or texture" << std::endl;
         return;
     }
     
-    // Get the pixel data from the render texture
-    Image layerImage = LoadImageFromTexture((**layer->texture).texture);
-    
-    // Flip the image vertically (OpenGL convention)
-    ImageFlipVertical(&layerImage);
-    
-    // Store a copy of the image
-    beforeState_ = std::make_unique<Image>(ImageCopy(layerImage));
-    
-    // Clean up the temporary image
-    UnloadImage(layerImage);
+    if (beforeState_)
+        UnloadImage(*beforeState_);
+    beforeState_ = std::make_unique<Image>(layerImage);
     
     std::cout << "DeleteSelectionCommand: Before state captured (" 
               << beforeState_->width << "x" << beforeState_->height << ")" << std::endl;
@@ -123,30 +103,18 @@ void DeleteSelectionCommand::captureBeforeState()
 
 void DeleteSelectionCommand::captureAfterState()
 {
-    if (targetLayerIndex_ >= static_cast<size_t>(canvas_->getLayerCount())) {
-        std::cout << "DeleteSelectionCommand: Invalid layer index, cannot capture after state" << std::endl;
-        return;
-    }
-    
     std::cout << "DeleteSelectionCommand: Capturing after state..." << std::endl;
     
-    const auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Get the pixel data of the target layer, already flipped to top-down order
+    Image layerImage = canvas_->copyLayerImage(targetLayer_);
+    if (!layerImage.data) {
         std::cout << "DeleteSelectionCommand: Failed to capture after state - no layer or texture" << std::endl;
         return;
     }
     
-    // Get the pixel data from the render texture
-    Image layerImage = LoadImageFromTexture((**layer->texture).texture);
-    
-    // Flip the image vertically (OpenGL convention)
-    ImageFlipVertical(&layerImage);
-    
-    // Store a copy of the image
-    afterState_ = std::make_unique<Image>(ImageCopy(layerImage));
-    
-    // Clean up the temporary image
-    UnloadImage(layerImage);
+    if (afterState_)
+        UnloadImage(*afterState_);
+    afterState_ = std::make_unique<Image>(layerImage);
     
     std::cout << "DeleteSelectionCommand: After state captured (" 
               << afterState_->width << "x" << afterState_->height << ")" << std::endl;
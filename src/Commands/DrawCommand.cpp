@@ -5,12 +5,12 @@
 namespace EpiGimp {
 
 DrawCommand::DrawCommand(Canvas* canvas, const std::string& description)
-    : canvas_(canvas), targetLayerIndex_(0), description_(description)
+    : canvas_(canvas), description_(description)
 {
     if (!canvas_)
         throw std::invalid_argument("Canvas cannot be null");
     
-    targetLayerIndex_ = 0;
+    targetLayer_ = canvas_->getSelectedLayerHandle();
 }
 
 DrawCommand::~DrawCommand()
@@ -24,7 +24,9 @@ DrawCommand::~DrawCommand()
 void DrawCommand::captureBeforeState()
 {
     std::cout << "DrawCommand: Capturing before state..." << std::endl;
-    beforeState_ = copyActiveLayerToImage();
+    if (beforeState_)
+        UnloadImage(*beforeState_);
+    beforeState_ = copyTargetLayerToImage();
     if (!beforeState_) {
         std::cerr << "DrawCommand: Failed to capture before state" << std::endl;
     } else {
@@ -35,7 +37,9 @@ void DrawCommand::captureBeforeState()
 void DrawCommand::captureAfterState()
 {
     std::cout << "DrawCommand: Capturing after state..." << std::endl;
-    afterState_ = copyActiveLayerToImage();
+    if (afterState_)
+        UnloadImage(*afterState_);
+    afterState_ = copyTargetLayerToImage();
     if (!afterState_) {
         std::cerr << "DrawCommand: Failed to capture after state" << std::endl;
     } else {
@@ -50,7 +54,7 @@ bool DrawCommand::execute()
     
     // However, if we have an afterState_ stored, we can restore it (useful for redo operations)
     if (afterState_)
-        return restoreActiveLayerFromImage(afterState_);
+        return restoreTargetLayerFromImage(afterState_);
     
     // If no after state is captured, the command represents the current state
     return true;
@@ -64,7 +68,7 @@ bool DrawCommand::undo()
     }
     
     std::cout << "DrawCommand: Performing undo..." << std::endl;
-    bool result = restoreActiveLayerFromImage(beforeState_);
+    bool result = restoreTargetLayerFromImage(beforeState_);
     if (result) {
         std::cout << "DrawCommand: Undo successful" << std::endl;
     } else {
@@ -73,30 +77,31 @@ bool DrawCommand::undo()
     return result;
 }
 
-std::unique_ptr<Image> DrawCommand::copyActiveLayerToImage() const
+std::unique_ptr<Image> DrawCommand::copyTargetLayerToImage() const
 {
-    if (!canvas_ || !canvas_->hasDrawingTexture())
+    if (!canvas_ || !canvas_->getLayer(targetLayer_))
         return nullptr;
     
-    try {
-        Image copiedImage = canvas_->copyDrawingImage();
-        return std::make_unique<Image>(copiedImage);
-    }
-    catch (const std::exception& e) {
-        std::cerr << "DrawCommand: Failed to copy drawing layer: " << e.what() << std::endl;
+    Image copiedImage = canvas_->copyLayerImage(targetLayer_);
+    if (!copiedImage.data) {
+        std::cerr << "DrawCommand: Failed to copy drawing layer" << std::endl;
         return nullptr;
     }
+    return std::make_unique<Image>(copiedImage);
 }
 
-bool DrawCommand::restoreActiveLayerFromImage(const std::unique_ptr<Image>& image)
+bool DrawCommand::restoreTargetLayerFromImage(const std::unique_ptr<Image>& image)
 {
     if (!image || !canvas_)
         return false;
     
-    // For the simple drawing layer system, we'd need to restore the drawing texture
-    // For now, return true to indicate success (this needs proper implementation)
-    std::cout << "DrawCommand: Restore operation (simplified layer system)" << std::endl;
-    return true;
+    // A layer that no longer exists leaves nothing to restore; keep history usable
+    if (!canvas_->getLayer(targetLayer_)) {
+        std::cout << "DrawCommand: Target layer no longer exists, nothing to restore" << std::endl;
+        return true;
+    }
+    
+    return canvas_->restoreLayerImage(targetLayer_, *image);
 }
 
 std::unique_ptr<DrawCommand> createDrawCommand(Canvas* canvas, const std::string& description)
@@ -0,0 +1,118 @@
+#include "../../include/Commands/FilterCommand.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include "../../include/UI/Canvas.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace EpiGimp {
+
+FilterCommand::FilterCommand(Canvas* canvas, LayerHandle layer, const std::string& description)
+    : canvas_(canvas), targetLayer_(layer), description_(description)
+{
+    if (!canvas_)
+        throw std::invalid_argument("Canvas cannot be null");
+}
+
+void FilterCommand::recordChanges(const Image& before, const Image& after, Rectangle region)
+{
+    tiles_.clear();
+    if (!before.data || !after.data || before.width != after.width || before.height != after.height) {
+        std::cerr << "FilterCommand: Before and after images do not match" << std::endl;
+        return;
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(region.x)) / TILE_SIZE);
+    const int y0 = std::max(0, static_cast<int>(std::floor(region.y)) / TILE_SIZE);
+    const int x1 = std::min((before.width + TILE_SIZE - 1) / TILE_SIZE, static_cast<int>(std::ceil((region.x + region.width) / TILE_SIZE)));
+    const int y1 = std::min((before.height + TILE_SIZE - 1) / TILE_SIZE, static_cast<int>(std::ceil((region.y + region.height) / TILE_SIZE)));
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    // Each row of tiles is compared on its own job, then the rows are joined in order
+    const size_t stride = static_cast<size_t>(before.width) * 4;
+    const auto* beforePixels = static_cast<const uint8_t*>(before.data);
+    const auto* afterPixels = static_cast<const uint8_t*>(after.data);
+    std::vector<std::vector<Tile>> rows(static_cast<size_t>(y1 - y0));
+    JobSystem::shared().parallelFor(rows.size(), [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const int top = (y0 + static_cast<int>(r)) * TILE_SIZE;
+            const int height = std::min(TILE_SIZE, before.height - top);
+            for (int tx = x0; tx < x1; ++tx) {
+                const int left = tx * TILE_SIZE;
+                const size_t rowBytes = static_cast<size_t>(std::min(TILE_SIZE, before.width - left)) * 4;
+                const size_t offset = top * stride + left * 4;
+
+                bool changed = false;
+                for (int y = 0; y < height && !changed; ++y)
+                    changed = std::memcmp(beforePixels + offset + y * stride, afterPixels + offset + y * stride, rowBytes) != 0;
+                if (!changed)
+                    continue;
+
+                Tile tile;
+                tile.rect = Rectangle{static_cast<float>(left), static_cast<float>(top),
+                                      static_cast<float>(rowBytes / 4), static_cast<float>(height)};
+                tile.before.resize(rowBytes * height);
+                tile.after.resize(rowBytes * height);
+                for (int y = 0; y < height; ++y) {
+                    std::memcpy(tile.before.data() + y * rowBytes, beforePixels + offset + y * stride, rowBytes);
+                    std::memcpy(tile.after.data() + y * rowBytes, afterPixels + offset + y * stride, rowBytes);
+                }
+                rows[r].push_back(std::move(tile));
+            }
+        }
+    });
+
+    for (auto& row : rows)
+        for (auto& tile : row)
+            tiles_.push_back(std::move(tile));
+    showingAfter_ = true;
+
+    std::cout << "FilterCommand: Kept " << tiles_.size() << " changed tiles of " << (x1 - x0) * (y1 - y0)
+              << " (" << getStoredBytes() / 1024 << " KB)" << std::endl;
+}
+
+bool FilterCommand::execute()
+{
+    // The filter itself already ran; only a redo has tiles to put back
+    if (showingAfter_)
+        return true;
+    return writeTiles(true);
+}
+
+bool FilterCommand::undo()
+{
+    if (!showingAfter_)
+        return true;
+    return writeTiles(false);
+}
+
+bool FilterCommand::writeTiles(bool after)
+{
+    // A layer that no longer exists leaves nothing to restore; keep history usable
+    if (!canvas_->getLayer(targetLayer_)) {
+        std::cout << "FilterCommand: Target layer no longer exists, nothing to restore" << std::endl;
+        showingAfter_ = after;
+        return true;
+    }
+
+    for (const Tile& tile : tiles_) {
+        if (!canvas_->writeLayerPixels(targetLayer_, tile.rect, after ? tile.after.data() : tile.before.data())) {
+            std::cerr << "FilterCommand: Failed to write tile at " << tile.rect.x << "," << tile.rect.y << std::endl;
+            return false;
+        }
+    }
+    showingAfter_ = after;
+    return true;
+}
+
+size_t FilterCommand::getStoredBytes() const
+{
+    size_t bytes = 0;
+    for (const Tile& tile : tiles_)
+        bytes += tile.before.size() + tile.after.size();
+    return bytes;
+}
+
+} // namespace EpiGimp
@@ -1,24 +1,44 @@
 #include "../../include/Commands/FlipSelectionCommands.hpp"
 #include "../../include/UI/Canvas.hpp"
+#include <cstring>
 #include <iostream>
+#include <vector>
 
 namespace EpiGimp {
 
+namespace {
+
+// Straight-alpha source-over of one RGBA8 pixel
+void blendOver(unsigned char* destination, const unsigned char* source)
+{
+    const unsigned alpha = source[3];
+    if (alpha == 0)
+        return;
+    const unsigned below = destination[3] * (255 - alpha);
+    const unsigned outAlpha = alpha * 255 + below;
+    for (int c = 0; c < 3; ++c)
+        destination[c] = static_cast<unsigned char>((source[c] * alpha * 255 + destination[c] * below + outAlpha / 2) / outAlpha);
+    destination[3] = static_cast<unsigned char>((outAlpha + 127) / 255);
+}
+
+} // namespace
+
 // Base FlipSelectionCommand implementation
 FlipSelectionCommand::FlipSelectionCommand(Canvas* canvas, const std::string& description)
-    : canvas_(canvas), targetLayerIndex_(0), selectionRect_{0, 0, 0, 0}, description_(description)
+    : canvas_(canvas), selectionRect_{0, 0, 0, 0}, description_(description)
 {
     if (!canvas_) {
         throw std::invalid_argument("Canvas cannot be null");
     }
     
-    // Store current layer index and selection rectangle
-    targetLayerIndex_ = canvas_->getSelectedLayerIndex();
+    // Store current layer and selection rectangle
+    targetLayer_ = canvas_->getSelectedLayerHandle();
     if (canvas_->hasSelection()) {
         selectionRect_ = canvas_->getSelectionRect();
+        selectionMask_ = canvas_->getSelectionMask();
     }
     
-    std::cout << "FlipSelectionCommand: Created for layer " << targetLayerIndex_ 
+    std::cout << "FlipSelectionCommand: Created for layer " << canvas_->getSelectedLayerIndex() 
               << " with selection (" << selectionRect_.x << "," << selectionRect_.y 
               << ") " << selectionRect_.width << "x" << selectionRect_.height << std::endl;
 }
@@ -38,89 +58,83 @@ bool FlipSelectionCommand::execute()
         captureBeforeState();
     }
     
-    // Get the target layer
-    auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Top-down copy of the layer; the mask uses the same coordinates
+    Image layerImage = canvas_->copyLayerImage(targetLayer_);
+    if (!layerImage.data) {
         std::cout << "FlipSelectionCommand: Cannot execute - layer or texture not available" << std::endl;
         return false;
     }
-    
-    // Extract current layer content as image
-    Image layerImage = LoadImageFromTexture((**layer->texture).texture);
-    
-    // Flip the image vertically to match the screen coordinate system
-    // (OpenGL textures are upside-down relative to screen coordinates)
-    ImageFlipVertical(&layerImage);
-    
-    // Now we can use the selection rectangle directly - no transformation needed
-    // The coordinates are already in the correct space after the flip
-    Rectangle extractRect = {
-        selectionRect_.x,
-        selectionRect_.y,
-        selectionRect_.width,
-        selectionRect_.height
-    };
-    
-    std::cout << "FlipSelectionCommand: Extracting from (" << extractRect.x << "," << extractRect.y 
-              << ") " << extractRect.width << "x" << extractRect.height << std::endl;
-    
-    // Validate extraction rectangle
-    if (extractRect.x < 0 || extractRect.y < 0 || 
-        extractRect.x + extractRect.width > layerImage.width ||
-        extractRect.y + extractRect.height > layerImage.height) {
-        std::cout << "FlipSelectionCommand: Invalid extraction coordinates" << std::endl;
+    if (layerImage.width != selectionMask_.getWidth() || layerImage.height != selectionMask_.getHeight()) {
+        std::cout << "FlipSelectionCommand: Selection does not match the layer size" << std::endl;
         UnloadImage(layerImage);
         return false;
     }
     
-    // Extract the selection area
-    Image selectionImage = ImageFromImage(layerImage, extractRect);
-    
-    // Check if we extracted any content
-    Color* pixels = LoadImageColors(selectionImage);
+    const Rectangle bounds = selectionMask_.getBounds();
+    const int boundsX = static_cast<int>(bounds.x);
+    const int boundsY = static_cast<int>(bounds.y);
+    const int boundsWidth = static_cast<int>(bounds.width);
+    const int boundsHeight = static_cast<int>(bounds.height);
+    
+    std::cout << "FlipSelectionCommand: Lifting (" << boundsX << "," << boundsY 
+              << ") " << boundsWidth << "x" << boundsHeight << std::endl;
+    
+    // Lift the selected pixels: content keeps their coverage in its alpha, and a second
+    // image carries the coverage itself so the selection can flip with the content
+    Image content = GenImageColor(boundsWidth, boundsHeight, BLANK);
+    Image coverage = GenImageColor(boundsWidth, boundsHeight, BLANK);
+    auto* layerPixels = static_cast<unsigned char*>(layerImage.data);
+    auto* contentPixels = static_cast<unsigned char*>(content.data);
+    auto* coveragePixels = static_cast<unsigned char*>(coverage.data);
     bool hasContent = false;
-    for (int i = 0; i < selectionImage.width * selectionImage.height; i++) {
-        if (pixels[i].a > 0) {
-            hasContent = true;
-            break;
+    selectionMask_.forEachRun(bounds, true, [&](int y, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+        for (int x = x0; x <= x1; ++x) {
+            const unsigned selected = values ? values[x - x0] : uniform;
+            const unsigned char* source = layerPixels + (static_cast<size_t>(y) * layerImage.width + x) * 4;
+            const size_t offset = (static_cast<size_t>(y - boundsY) * boundsWidth + (x - boundsX)) * 4;
+            std::memcpy(contentPixels + offset, source, 3);
+            contentPixels[offset + 3] = static_cast<unsigned char>((source[3] * selected + 127) / 255);
+            coveragePixels[offset + 3] = static_cast<unsigned char>(selected);
+            hasContent = hasContent || contentPixels[offset + 3] > 0;
         }
-    }
-    UnloadImageColors(pixels);
+    });
     
     if (!hasContent) {
         std::cout << "FlipSelectionCommand: No content found in selection area" << std::endl;
-        UnloadImage(selectionImage);
+        UnloadImage(content);
+        UnloadImage(coverage);
         UnloadImage(layerImage);
         return false;
     }
     
     // Perform the flip operation (implemented by derived classes)
-    performFlip(selectionImage);
-    
-    // Now we need to update the layer texture directly
-    // First, clear the selection area (like deleteSelectionInternal does)
-    layer->texture->beginDrawing();
-    
-    // Use scissor test to limit clearing to the selection area
-    BeginScissorMode((int)selectionRect_.x, (int)selectionRect_.y, 
-                     (int)selectionRect_.width, (int)selectionRect_.height);
-    
-    // Clear the background to transparent in the scissored area
-    ClearBackground(Color{0, 0, 0, 0});
-    
-    EndScissorMode();
-    
-    // Now draw the flipped selection back to the texture at the same position
-    // Convert the flipped image back to a texture and draw it
-    Texture2D flippedTexture = LoadTextureFromImage(selectionImage);
-    DrawTexture(flippedTexture, (int)selectionRect_.x, (int)selectionRect_.y, WHITE);
-    UnloadTexture(flippedTexture);
-    
-    layer->texture->endDrawing();
+    performFlip(content);
+    performFlip(coverage);
+    
+    // Anchor the flipped content over what is left of the layer
+    selectionMask_.clearCovered(layerImage, false);
+    std::vector<uint8_t> flippedCoverage(static_cast<size_t>(boundsWidth) * boundsHeight);
+    for (int y = 0; y < boundsHeight; ++y) {
+        for (int x = 0; x < boundsWidth; ++x) {
+            const size_t offset = (static_cast<size_t>(y) * boundsWidth + x) * 4;
+            flippedCoverage[static_cast<size_t>(y) * boundsWidth + x] = coveragePixels[offset + 3];
+            blendOver(layerPixels + (static_cast<size_t>(boundsY + y) * layerImage.width + boundsX + x) * 4, contentPixels + offset);
+        }
+    }
+    UnloadImage(content);
+    UnloadImage(coverage);
     
-    // Clean up
-    UnloadImage(selectionImage);
+    const bool written = canvas_->restoreLayerImage(targetLayer_, layerImage);
     UnloadImage(layerImage);
+    if (!written) {
+        std::cout << "FlipSelectionCommand: Cannot execute - layer or texture not available" << std::endl;
+        return false;
+    }
+    
+    // The selection follows its content
+    SelectionMask flippedMask(selectionMask_.getWidth(), selectionMask_.getHeight());
+    flippedMask.setRegion(bounds, flippedCoverage.data(), boundsWidth);
+    canvas_->setSelectionMask(std::move(flippedMask));
     
     // Capture after state
     captureAfterState();
@@ -138,25 +152,12 @@ bool FlipSelectionCommand::undo()
     
     std::cout << "FlipSelectionCommand: Performing undo..." << std::endl;
     
-    // Get the target layer
-    auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Restore the before state to the layer (same as DeleteSelectionCommand)
+    if (!canvas_->restoreLayerImage(targetLayer_, *beforeState_)) {
         std::cout << "FlipSelectionCommand: Cannot undo - layer or texture not available" << std::endl;
         return false;
     }
-    
-    // Restore the before state to the layer (same as DeleteSelectionCommand)
-    layer->texture->beginDrawing();
-    
-    // Clear the render texture first
-    ClearBackground(Color{0, 0, 0, 0});
-    
-    // Load the before state as a texture and draw it
-    Texture2D beforeTexture = LoadTextureFromImage(*beforeState_);
-    DrawTexture(beforeTexture, 0, 0, WHITE);
-    UnloadTexture(beforeTexture);
-    
-    layer->texture->endDrawing();
+    canvas_->setSelectionMask(selectionMask_);
     
     std::cout << "FlipSelectionCommand: Undo successful" << std::endl;
     return true;
@@ -174,30 +175,18 @@ bool FlipSelectionCommand::canExecute() const
 
 void FlipSelectionCommand::captureBeforeState()
 {
-    if (targetLayerIndex_ >= static_cast<size_t>(canvas_->getLayerCount())) {
-        std::cout << "FlipSelectionCommand: Invalid layer index, cannot capture before state" << std::endl;
-        return;
-    }
-    
     std::cout << "FlipSelectionCommand: Capturing before state..." << std::endl;
     
-    const auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Get the pixel data of the target layer, already flipped to top-down order
+    Image layerImage = canvas_->copyLayerImage(targetLayer_);
+    if (!layerImage.data) {
         std::cout << "FlipSelectionCommand: Failed to capture before state - no layer or texture" << std::endl;
         return;
     }
     
-    // Get the pixel data from the render texture
-    Image layerImage = LoadImageFromTexture((**layer->texture).texture);
-    
-    // Flip the image vertically (OpenGL convention) - same as DeleteSelectionCommand
-    ImageFlipVertical(&layerImage);
-    
-    // Store a copy of the image
-    beforeState_ = std::make_unique<Image>(ImageCopy(layerImage));
-    
-    // Clean up the temporary image
-    UnloadImage(layerImage);
+    if (beforeState_)
+        UnloadImage(*beforeState_);
+    beforeState_ = std::make_unique<Image>(layerImage);
     
     std::cout << "FlipSelectionCommand: Before state captured (" 
               << beforeState_->width << "x" << beforeState_->height << ")" << std::endl;
@@ -205,30 +194,18 @@ void FlipSelectionCommand::captureBeforeState()
 
 void FlipSelectionCommand::captureAfterState()
 {
-    if (targetLayerIndex_ >= static_cast<size_t>(canvas_->getLayerCount())) {
-        std::cout << "FlipSelectionCommand: Invalid layer index, cannot capture after state" << std::endl;
-        return;
-    }
-    
     std::cout << "FlipSelectionCommand: Capturing after state..." << std::endl;
     
-    const auto* layer = canvas_->getLayer(targetLayerIndex_);
-    if (!layer || !layer->texture) {
+    // Get the pixel data of the target layer, already flipped to top-down order
+    Image layerImage = canvas_->copyLayerImage(targetLayer_);
+    if (!layerImage.data) {
         std::cout << "FlipSelectionCommand: Failed to capture after state - no layer or texture" << std::endl;
         return;
     }
     
-    // Get the pixel data from the render texture
-    Image layerImage = LoadImageFromTexture((**layer->texture).texture);
-    
-    // Flip the image vertically (OpenGL convention)
-    ImageFlipVertical(&layerImage);
-    
-    // Store a copy of the image
-    afterState_ = std::make_unique<Image>(ImageCopy(layerImage));
-    
-    // Clean up the temporary image
-    UnloadImage(layerImage);
+    if (afterState_)
+        UnloadImage(*afterState_);
+    afterState_ = std::make_unique<Image>(layerImage);
     
     std::cout << "FlipSelectionCommand: After state captured (" 
               << afterState_->width << "x" << afterState_->height << ")" << std::endl;
@@ -17,7 +17,16 @@ bool CreateLayerCommand::execute()
 {
     if (!layerManager_) return false;
     
+    // Redo: put the same layer back so later commands referring to it stay valid
+    if (removedLayer_) {
+        bool result = layerManager_->reattachLayer(createdLayer_, std::move(removedLayer_), createdLayerIndex_);
+        if (result)
+            std::cout << "CreateLayerCommand: Restored layer '" << layerName_ << "' at index " << createdLayerIndex_ << std::endl;
+        return result;
+    }
+    
     createdLayerIndex_ = layerManager_->createLayer(layerName_);
+    createdLayer_ = layerManager_->getLayerHandle(createdLayerIndex_);
     std::cout << "CreateLayerCommand: Created layer '" << layerName_ << "' at index " << createdLayerIndex_ << std::endl;
     return true;
 }
@@ -26,10 +35,15 @@ bool CreateLayerCommand::undo()
 {
     if (!layerManager_) return false;
     
-    bool result = layerManager_->deleteLayer(createdLayerIndex_);
-    if (result)
-        std::cout << "CreateLayerCommand: Undone - deleted layer at index " << createdLayerIndex_ << std::endl;
-    return result;
+    int index = layerManager_->getLayerIndex(createdLayer_);
+    if (index < 0)
+        return false;
+    
+    createdLayerIndex_ = static_cast<size_t>(index);
+    removedLayer_ = layerManager_->detachLayer(createdLayer_);
+    if (removedLayer_)
+        std::cout << "CreateLayerCommand: Undone - removed layer at index " << createdLayerIndex_ << std::endl;
+    return removedLayer_ != nullptr;
 }
 
 DeleteLayerCommand::DeleteLayerCommand(LayerManager* layerManager, size_t layerIndex)
@@ -40,6 +54,7 @@ DeleteLayerCommand::DeleteLayerCommand(LayerManager* layerManager, size_t layerI
     if (!layerManager_)
         throw std::invalid_argument("LayerManager cannot be null");
     
+    layerHandle_ = layerManager_->getLayerHandle(layerIndex);
     const Layer* layer = layerManager_->getLayer(layerIndex);
     if (layer)
         description_ = "Delete Layer: " + layer->getName();
@@ -50,27 +65,25 @@ bool DeleteLayerCommand::execute()
     if (!layerManager_ || layerManager_->getLayerCount() <= 1)
         return false; // Can't delete the last layer
     
-    // Store the layer before deleting (note: this is a simplified approach)
-    // In a full implementation, we'd need to properly store and restore the layer
-    bool result = layerManager_->deleteLayer(layerIndex_);
-    if (result)
+    int index = layerManager_->getLayerIndex(layerHandle_);
+    if (index < 0)
+        return false;
+    
+    layerIndex_ = static_cast<size_t>(index);
+    deletedLayer_ = layerManager_->detachLayer(layerHandle_);
+    if (deletedLayer_)
         std::cout << "DeleteLayerCommand: Deleted layer at index " << layerIndex_ << std::endl;
-    return result;
+    return deletedLayer_ != nullptr;
 }
 
 bool DeleteLayerCommand::undo()
 {
-    // Note: This is a simplified implementation
-    // A full implementation would need to restore the exact layer state
-    if (!layerManager_) return false;
+    if (!layerManager_ || !deletedLayer_) return false;
     
-    // For now, just create a new layer at the same position
-    // This is not a perfect undo but demonstrates the pattern
-    std::string newName = "Restored Layer";
-    size_t newIndex = layerManager_->createLayer(newName);
-    
-    std::cout << "DeleteLayerCommand: Undo approximated - created new layer at index " << newIndex << std::endl;
-    return true;
+    bool result = layerManager_->reattachLayer(layerHandle_, std::move(deletedLayer_), layerIndex_);
+    if (result)
+        std::cout << "DeleteLayerCommand: Undone - restored layer at index " << layerIndex_ << std::endl;
+    return result;
 }
 
 MoveLayerCommand::MoveLayerCommand(LayerManager* layerManager, size_t fromIndex, size_t toIndex)
@@ -81,15 +94,21 @@ MoveLayerCommand::MoveLayerCommand(LayerManager* layerManager, size_t fromIndex,
     {
     if (!layerManager_)
         throw std::invalid_argument("LayerManager cannot be null");
+    
+    layerHandle_ = layerManager_->getLayerHandle(fromIndex);
 }
 
 bool MoveLayerCommand::execute()
 {
     if (!layerManager_) return false;
     
-    bool result = layerManager_->moveLayer(fromIndex_, toIndex_);
+    int index = layerManager_->getLayerIndex(layerHandle_);
+    if (index < 0)
+        return false;
+    
+    bool result = layerManager_->moveLayer(static_cast<size_t>(index), toIndex_);
     if (result)
-        std::cout << "MoveLayerCommand: Moved layer from " << fromIndex_ << " to " << toIndex_ << std::endl;
+        std::cout << "MoveLayerCommand: Moved layer from " << index << " to " << toIndex_ << std::endl;
     return result;
 }
 
@@ -97,21 +116,25 @@ bool MoveLayerCommand::undo()
 {
     if (!layerManager_) return false;
     
-    bool result = layerManager_->moveLayer(toIndex_, fromIndex_);
+    int index = layerManager_->getLayerIndex(layerHandle_);
+    if (index < 0)
+        return false;
+    
+    bool result = layerManager_->moveLayer(static_cast<size_t>(index), fromIndex_);
     if (result)
-        std::cout << "MoveLayerCommand: Undone - moved layer from " << toIndex_ << " back to " << fromIndex_ << std::endl;
+        std::cout << "MoveLayerCommand: Undone - moved layer from " << index << " back to " << fromIndex_ << std::endl;
     return result;
 }
 
 ToggleLayerVisibilityCommand::ToggleLayerVisibilityCommand(LayerManager* layerManager, size_t layerIndex)
     : layerManager_(layerManager)
-    , layerIndex_(layerIndex)
     , previousVisibility_(true)
     , description_("Toggle Layer Visibility")
 {
     if (!layerManager_)
         throw std::invalid_argument("LayerManager cannot be null");
     
+    layerHandle_ = layerManager_->getLayerHandle(layerIndex);
     const Layer* layer = layerManager_->getLayer(layerIndex);
     if (layer) {
         previousVisibility_ = layer->isVisible();
@@ -123,13 +146,13 @@ bool ToggleLayerVisibilityCommand::execute()
 {
     if (!layerManager_) return false;
     
-    const Layer* layer = layerManager_->getLayer(layerIndex_);
-    if (!layer) return false;
+    int index = layerManager_->getLayerIndex(layerHandle_);
+    if (index < 0) return false;
     
-    bool newVisibility = !layer->isVisible();
-    bool result = layerManager_->setLayerVisibility(layerIndex_, newVisibility);
+    bool newVisibility = !previousVisibility_;
+    bool result = layerManager_->setLayerVisibility(static_cast<size_t>(index), newVisibility);
     if (result)
-        std::cout << "ToggleLayerVisibilityCommand: Set visibility to " << newVisibility << " for layer " << layerIndex_ << std::endl;
+        std::cout << "ToggleLayerVisibilityCommand: Set visibility to " << newVisibility << " for layer " << index << std::endl;
     return result;
 }
 
@@ -137,15 +160,17 @@ bool ToggleLayerVisibilityCommand::undo()
 {
     if (!layerManager_) return false;
     
-    bool result = layerManager_->setLayerVisibility(layerIndex_, previousVisibility_);
+    int index = layerManager_->getLayerIndex(layerHandle_);
+    if (index < 0) return false;
+    
+    bool result = layerManager_->setLayerVisibility(static_cast<size_t>(index), previousVisibility_);
     if (result)
-        std::cout << "ToggleLayerVisibilityCommand: Restored visibility to " << previousVisibility_ << " for layer " << layerIndex_ << std::endl;
+        std::cout << "ToggleLayerVisibilityCommand: Restored visibility to " << previousVisibility_ << " for layer " << index << std::endl;
     return result;
 }
 
 SetLayerOpacityCommand::SetLayerOpacityCommand(LayerManager* layerManager, size_t layerIndex, float opacity)
     : layerManager_(layerManager)
-    , layerIndex_(layerIndex)
     , newOpacity_(opacity)
     , previousOpacity_(1.0f)
     , description_("Set Layer Opacity")
@@ -153,6 +178,7 @@ SetLayerOpacityCommand::SetLayerOpacityCommand(LayerManager* layerManager, size_
     if (!layerManager_)
         throw std::invalid_argument("LayerManager cannot be null");
     
+    layerHandle_ = layerManager_->getLayerHandle(layerIndex);
     const Layer* layer = layerManager_->getLayer(layerIndex);
     if (layer) {
         previousOpacity_ = layer->getOpacity();
@@ -162,33 +188,33 @@ SetLayerOpacityCommand::SetLayerOpacityCommand(LayerManager* layerManager, size_
 
 bool SetLayerOpacityCommand::execute()
 {
-    if (!layerManager_) return false;
+    Layer* layer = layerManager_ ? layerManager_->getLayer(layerHandle_) : nullptr;
+    if (!layer) return false;
     
-    bool result = layerManager_->setLayerOpacity(layerIndex_, newOpacity_);
-    if (result)
-        std::cout << "SetLayerOpacityCommand: Set opacity to " << newOpacity_ << " for layer " << layerIndex_ << std::endl;
-    return result;
+    layer->setOpacity(newOpacity_);
+    std::cout << "SetLayerOpacityCommand: Set opacity to " << newOpacity_ << " for layer " << layer->getName() << std::endl;
+    return true;
 }
 
 bool SetLayerOpacityCommand::undo()
 {
-    if (!layerManager_) return false;
+    Layer* layer = layerManager_ ? layerManager_->getLayer(layerHandle_) : nullptr;
+    if (!layer) return false;
     
-    bool result = layerManager_->setLayerOpacity(layerIndex_, previousOpacity_);
-    if (result)
-        std::cout << "SetLayerOpacityCommand: Restored opacity to " << previousOpacity_ << " for layer " << layerIndex_ << std::endl;
-    return result;
+    layer->setOpacity(previousOpacity_);
+    std::cout << "SetLayerOpacityCommand: Restored opacity to " << previousOpacity_ << " for layer " << layer->getName() << std::endl;
+    return true;
 }
 
 DuplicateLayerCommand::DuplicateLayerCommand(LayerManager* layerManager, size_t sourceLayerIndex)
     : layerManager_(layerManager)
-    , sourceLayerIndex_(sourceLayerIndex)
     , createdLayerIndex_(0)
     , description_("Duplicate Layer")
 {
     if (!layerManager_)
         throw std::invalid_argument("LayerManager cannot be null");
     
+    sourceLayer_ = layerManager_->getLayerHandle(sourceLayerIndex);
     const Layer* layer = layerManager_->getLayer(sourceLayerIndex);
     if (layer)
         description_ = "Duplicate Layer: " + layer->getName();
@@ -198,10 +224,23 @@ bool DuplicateLayerCommand::execute()
 {
     if (!layerManager_) return false;
     
-    bool result = layerManager_->duplicateLayer(sourceLayerIndex_);
+    // Redo: reinsert the copy made the first time instead of duplicating again
+    if (removedLayer_) {
+        bool result = layerManager_->reattachLayer(createdLayer_, std::move(removedLayer_), createdLayerIndex_);
+        if (result)
+            std::cout << "DuplicateLayerCommand: Restored duplicate at " << createdLayerIndex_ << std::endl;
+        return result;
+    }
+    
+    int sourceIndex = layerManager_->getLayerIndex(sourceLayer_);
+    if (sourceIndex < 0)
+        return false;
+    
+    bool result = layerManager_->duplicateLayer(static_cast<size_t>(sourceIndex));
     if (result) {
-        createdLayerIndex_ = sourceLayerIndex_ + 1; // Duplicate is created after the source
-        std::cout << "DuplicateLayerCommand: Duplicated layer " << sourceLayerIndex_ << " to " << createdLayerIndex_ << std::endl;
+        createdLayerIndex_ = static_cast<size_t>(sourceIndex) + 1; // Duplicate is created after the source
+        createdLayer_ = layerManager_->getLayerHandle(createdLayerIndex_);
+        std::cout << "DuplicateLayerCommand: Duplicated layer " << sourceIndex << " to " << createdLayerIndex_ << std::endl;
     }
     return result;
 }
@@ -210,10 +249,15 @@ bool DuplicateLayerCommand::undo()
 {
     if (!layerManager_) return false;
     
-    bool result = layerManager_->deleteLayer(createdLayerIndex_);
-    if (result)
-        std::cout << "DuplicateLayerCommand: Undone - deleted duplicated layer at " << createdLayerIndex_ << std::endl;
-    return result;
+    int index = layerManager_->getLayerIndex(createdLayer_);
+    if (index < 0)
+        return false;
+    
+    createdLayerIndex_ = static_cast<size_t>(index);
+    removedLayer_ = layerManager_->detachLayer(createdLayer_);
+    if (removedLayer_)
+        std::cout << "DuplicateLayerCommand: Undone - removed duplicated layer at " << createdLayerIndex_ << std::endl;
+    return removedLayer_ != nullptr;
 }
 
-} // namespace EpiGimp
\ No newline at end of file
+} // namespace EpiGimp
@@ -0,0 +1,296 @@
+//Application methods exposed over the control socket
+#include "../../include/Core/Application.hpp"
+#include "../../include/UI/Canvas.hpp"
+#include "../../include/Utils/ControlServer.hpp"
+#include "../../include/Utils/BatchProcessor.hpp"
+#include "../../include/Utils/SharedImage.hpp"
+#include "../../include/Commands/DrawCommand.hpp"
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+namespace EpiGimp {
+
+namespace {
+
+const std::string& requireString(const JsonValue& params, const std::string& key)
+{
+    if (!params[key].isString() || params[key].asString().empty())
+        throw ControlError(RpcError::INVALID_PARAMS, "missing string parameter '" + key + "'");
+    return params[key].asString();
+}
+
+// Optional "layer" parameter, defaults to the selected layer
+int layerIndexParam(const Canvas& canvas, const JsonValue& params)
+{
+    const int index = params.has("layer") ? params["layer"].asInt(-1) : canvas.getSelectedLayerIndex();
+    if (index < 0 || index >= canvas.getLayerCount())
+        throw ControlError(RpcError::INVALID_PARAMS, "no layer " + std::to_string(index));
+    return index;
+}
+
+void requireImage(const Canvas& canvas)
+{
+    if (!canvas.hasImage())
+        throw ControlError(RpcError::SERVER_ERROR, "no image loaded");
+}
+
+JsonValue documentInfo(const Canvas& canvas)
+{
+    const Vector2 size = canvas.getImageSize();
+    JsonValue info = JsonValue::object();
+    info.set("width", static_cast<int>(size.x))
+        .set("height", static_cast<int>(size.y))
+        .set("path", canvas.getImagePath())
+        .set("layers", canvas.getLayerCount())
+        .set("selectedLayer", canvas.getSelectedLayerIndex());
+    return info;
+}
+
+} // namespace
+
+void Application::setupControlServer()
+{
+    if (config_.controlSocketPath.empty())
+        return;
+
+    controlServer_ = std::make_unique<ControlServer>(config_.controlSocketPath);
+    Canvas* canvas = static_cast<Canvas*>(canvas_.get());
+    HistoryManager* history = historyManager_.get();
+
+    // Saves finish on the saver thread; their outcome arrives as an event
+    auto saveResults = std::make_shared<std::map<std::string, bool>>();
+    eventDispatcher_->subscribe<ImageSavedEvent>([saveResults](const ImageSavedEvent& event) {
+        (*saveResults)[event.filePath] = event.success;
+    });
+
+    controlServer_->registerMethod("ping", [](const JsonValue&) {
+        return JsonValue::object().set("pong", true);
+    });
+
+    controlServer_->registerMethod("status", [this, canvas, history](const JsonValue&) {
+        JsonValue status = documentInfo(*canvas);
+        status.set("hasImage", canvas->hasImage())
+              .set("loading", canvas->isLoadingImage())
+              .set("saving", canvas->isSavingImage())
+              .set("undo", history->getUndoCount())
+              .set("pendingRequests", controlServer_->getPendingCount());
+        return status;
+    });
+
+    controlServer_->registerMethod("load", [canvas](const JsonValue& params) {
+        const std::string& path = requireString(params, "path");
+        if (!std::filesystem::exists(path))
+            throw ControlError(RpcError::INVALID_PARAMS, "no such file: " + path);
+
+        canvas->loadImage(path);
+        canvas->finishProjectStreaming();
+        if (!canvas->hasImage() || canvas->getImagePath() != path)
+            throw ControlError(RpcError::SERVER_ERROR, "cannot load " + path);
+        return documentInfo(*canvas);
+    });
+
+    controlServer_->registerMethod("new", [canvas](const JsonValue& params) {
+        const int width = params["width"].asInt(800);
+        const int height = params["height"].asInt(600);
+        if (width <= 0 || height <= 0 || width > 65535 || height > 65535)
+            throw ControlError(RpcError::INVALID_PARAMS, "invalid canvas size");
+        canvas->createBlankCanvas(width, height, WHITE);
+        return documentInfo(*canvas);
+    });
+
+    controlServer_->registerMethod("layers", [canvas](const JsonValue&) {
+        JsonValue layers = JsonValue::array();
+        for (int i = 0; i < canvas->getLayerCount(); ++i) {
+            const DrawingLayer* layer = canvas->getLayer(i);
+            JsonValue info = JsonValue::object();
+            info.set("index", i)
+                .set("name", layer->name)
+                .set("visible", layer->visible)
+                .set("flippedVertical", layer->flippedVertical)
+                .set("flippedHorizontal", layer->flippedHorizontal)
+                .set("selected", i == canvas->getSelectedLayerIndex());
+            layers.push(std::move(info));
+        }
+        JsonValue result = documentInfo(*canvas);
+        result.set("backgroundVisible", canvas->isBackgroundVisible()).set("list", std::move(layers));
+        return result;
+    });
+
+    controlServer_->registerMethod("addLayer", [canvas](const JsonValue& params) {
+        requireImage(*canvas);
+        const int index = canvas->addNewDrawingLayer(params["name"].asString());
+        canvas->setSelectedLayerIndex(index);
+        return JsonValue::object().set("index", index).set("name", canvas->getLayerName(index));
+    });
+
+    controlServer_->registerMethod("selectLayer", [canvas](const JsonValue& params) {
+        const int index = layerIndexParam(*canvas, params);
+        canvas->setSelectedLayerIndex(index);
+        return JsonValue::object().set("selectedLayer", index);
+    });
+
+    controlServer_->registerMethod("setLayerVisible", [canvas](const JsonValue& params) {
+        const int index = layerIndexParam(*canvas, params);
+        canvas->setLayerVisible(index, params["visible"].asBool(true));
+        return JsonValue::object().set("index", index).set("visible", canvas->isLayerVisible(index));
+    });
+
+    controlServer_->registerMethod("flip", [canvas](const JsonValue& params) {
+        requireImage(*canvas);
+        const std::string& axis = requireString(params, "axis");
+        if (axis != "vertical" && axis != "horizontal")
+            throw ControlError(RpcError::INVALID_PARAMS, "axis must be vertical or horizontal");
+
+        if (params["canvas"].asBool(false)) {
+            if (axis == "vertical")
+                canvas->flipCanvasVertical();
+            else
+                canvas->flipCanvasHorizontal();
+            return JsonValue::object().set("canvas", true);
+        }
+        const int index = layerIndexParam(*canvas, params);
+        if (axis == "vertical")
+            canvas->flipLayerVertical(index);
+        else
+            canvas->flipLayerHorizontal(index);
+        return JsonValue::object().set("index", index);
+    });
+
+    controlServer_->registerMethod("clearLayer", [canvas](const JsonValue& params) {
+        const int index = layerIndexParam(*canvas, params);
+        canvas->clearLayer(index);
+        return JsonValue::object().set("index", index);
+    });
+
+    // Same operations as --batch scripts, applied to one layer as a single undo step
+    controlServer_->registerMethod("filter", [canvas, history](const JsonValue& params) {
+        requireImage(*canvas);
+        std::string error;
+        auto script = BatchScript::parse(requireString(params, "script"), &error);
+        if (!script)
+            throw ControlError(RpcError::INVALID_PARAMS, error);
+        for (const auto& op : script->getOperations()) {
+            if (op.type == BatchOperation::Type::Resize)
+                throw ControlError(RpcError::INVALID_PARAMS, "resize cannot be applied to a single layer");
+        }
+
+        const int index = layerIndexParam(*canvas, params);
+        canvas->setSelectedLayerIndex(index);
+        const LayerHandle handle = canvas->getLayerHandle(index);
+
+        auto command = createDrawCommand(canvas, "Filter");
+        Image pixels = canvas->copyLayerImage(handle);
+        if (!pixels.data)
+            throw ControlError(RpcError::SERVER_ERROR, "cannot read layer " + std::to_string(index));
+        ImageFormat(&pixels, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        script->apply(pixels);
+        const bool restored = canvas->restoreLayerImage(handle, pixels);
+        UnloadImage(pixels);
+        if (!restored)
+            throw ControlError(RpcError::SERVER_ERROR, "cannot write layer " + std::to_string(index));
+
+        command->captureAfterState();
+        if (history)
+            history->executeCommand(std::move(command));
+        return JsonValue::object().set("index", index).set("operations", script->getOperations().size());
+    });
+
+    // Layers travel through shared memory instead of temporary files
+    controlServer_->registerMethod("exportLayerShared", [canvas](const JsonValue& params) {
+        requireImage(*canvas);
+        const std::string& name = requireString(params, "name");
+        const int index = layerIndexParam(*canvas, params);
+        ImageResource pixels(canvas->copyLayerImage(canvas->getLayerHandle(index)));
+        std::string error;
+        auto buffer = SharedImage::publish(name, *pixels, &error);
+        if (!buffer)
+            throw ControlError(RpcError::SERVER_ERROR, error);
+        return JsonValue::object()
+            .set("name", name)
+            .set("index", index)
+            .set("width", buffer->getWidth())
+            .set("height", buffer->getHeight())
+            .set("stride", buffer->getStride());
+    });
+
+    controlServer_->registerMethod("importLayerShared", [canvas](const JsonValue& params) {
+        requireImage(*canvas);
+        std::string error;
+        auto buffer = SharedImageBuffer::open(requireString(params, "name"), false, &error);
+        if (!buffer)
+            throw ControlError(RpcError::INVALID_PARAMS, error);
+        const Vector2 size = canvas->getImageSize();
+        if (buffer->getWidth() != static_cast<int>(size.x) || buffer->getHeight() != static_cast<int>(size.y))
+            throw ControlError(RpcError::INVALID_PARAMS, "shared image size does not match the canvas");
+
+        // Upload straight from the mapping unless the rows are padded
+        Image pixels = buffer->view();
+        ImageResource copied;
+        if (!pixels.data) {
+            copied = ImageResource(buffer->copy());
+            pixels = *copied;
+        }
+
+        const int index = params.has("layer") ? layerIndexParam(*canvas, params)
+                                              : canvas->addNewDrawingLayer(params["layerName"].asString());
+        if (!canvas->restoreLayerImage(canvas->getLayerHandle(index), pixels))
+            throw ControlError(RpcError::SERVER_ERROR, "cannot write layer " + std::to_string(index));
+        canvas->setSelectedLayerIndex(index);
+        return JsonValue::object().set("index", index).set("generation", static_cast<int64_t>(buffer->header().generation));
+    });
+
+    controlServer_->registerMethod("undo", [history](const JsonValue&) {
+        return JsonValue::object().set("done", history->undo());
+    });
+
+    controlServer_->registerMethod("redo", [history](const JsonValue&) {
+        return JsonValue::object().set("done", history->redo());
+    });
+
+    // Flatten on this thread; with a path the result is written before the reply
+    controlServer_->registerMethod("composite", [canvas](const JsonValue& params) {
+        requireImage(*canvas);
+        ImageResource flattened(canvas->captureSnapshot().composite());
+        if (!flattened.isValid())
+            throw ControlError(RpcError::SERVER_ERROR, "no visible layers");
+
+        JsonValue result = JsonValue::object();
+        result.set("width", flattened->width).set("height", flattened->height);
+        if (params["path"].isString()) {
+            ExportOptions options;
+            options.pngCompressionLevel = canvas->getPngCompressionLevel();
+            options.rawTileRle = canvas->isRawTileRleEnabled();
+            std::string actualPath;
+            if (!flattened.exportToFile(params["path"].asString(), actualPath, options))
+                throw ControlError(RpcError::SERVER_ERROR, "cannot write " + params["path"].asString());
+            result.set("path", actualPath);
+        }
+        return result;
+    });
+
+    controlServer_->registerMethod("save", [canvas, saveResults](const JsonValue& params) {
+        requireImage(*canvas);
+        const std::string& path = requireString(params, "path");
+        saveResults->erase(path);
+        if (!canvas->saveImage(path))
+            throw ControlError(RpcError::SERVER_ERROR, "cannot save " + path);
+
+        // Pipelined clients can skip the wait and poll status instead
+        if (!params["wait"].asBool(true))
+            return JsonValue::object().set("path", path).set("queued", true);
+
+        canvas->waitForPendingSaves();
+        auto result = saveResults->find(path);
+        if (result == saveResults->end() || !result->second)
+            throw ControlError(RpcError::SERVER_ERROR, "saving " + path + " failed");
+        return JsonValue::object().set("path", path).set("saved", true);
+    });
+
+    if (!controlServer_->start()) {
+        std::cerr << "Control socket disabled" << std::endl;
+        controlServer_.reset();
+    }
+}
+
+} // namespace EpiGimp
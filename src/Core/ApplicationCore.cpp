@@ -4,6 +4,10 @@
 #include "../../include/UI/Canvas.hpp"
 #include "../../include/UI/SimpleLayerPanel.hpp"
 #include "../../include/Utils/Implementations.hpp"
+#include "../../include/Utils/Autosaver.hpp"
+#include "../../include/Utils/ControlServer.hpp"
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <stdexcept>
 
@@ -22,6 +26,19 @@ Application::Application(AppConfig config)
 
 Application::~Application() = default;
 
+namespace {
+
+std::string defaultAutosaveDirectory()
+{
+    if (const char* state = std::getenv("XDG_STATE_HOME"); state && *state)
+        return (std::filesystem::path(state) / "epigimp" / "autosave").string();
+    if (const char* home = std::getenv("HOME"); home && *home)
+        return (std::filesystem::path(home) / ".local" / "state" / "epigimp" / "autosave").string();
+    return (std::filesystem::temp_directory_path() / "epigimp-autosave").string();
+}
+
+} // namespace
+
 bool Application::initialize()
 {
     if (initialized_) {
@@ -46,10 +63,8 @@ bool Application::initialize()
         // Create UI components
         createComponents();
         setupEventHandlers();
-
-        // Load initial image if specified
-        if (!config_.initialImagePath.empty())
-            canvas_->loadImage(config_.initialImagePath);
+        setupAutosave();
+        setupControlServer();
 
         initialized_ = true;
         std::cout << "Application initialized successfully" << std::endl;
@@ -61,6 +76,41 @@ bool Application::initialize()
     }
 }
 
+void Application::setupAutosave()
+{
+    Canvas* canvas = static_cast<Canvas*>(canvas_.get());
+    AutosaveSettings settings;
+    settings.directory = config_.autosaveDirectory.empty() ? defaultAutosaveDirectory() : config_.autosaveDirectory;
+    settings.intervalSeconds = config_.autosaveInterval;
+
+    // Bring back the work of a session that did not shut down cleanly
+    const bool recoverable = Autosaver::hasRecoverableState(settings.directory);
+    if (recoverable && config_.initialImagePath.empty()) {
+        const std::string recoveredPath = (std::filesystem::path(settings.directory) / "recovered.epg").string();
+        auto recovered = Autosaver::recover(settings.directory);
+        if (recovered && ProjectFile::write(*recovered, recoveredPath) && canvas->openProject(recoveredPath))
+            std::cout << "Recovered autosaved document from " << recoveredPath << std::endl;
+        else
+            std::cerr << "Warning: Autosave state in " << settings.directory << " could not be recovered" << std::endl;
+    } else if (recoverable) {
+        std::cout << "Warning: Autosave state from a previous session will be replaced" << std::endl;
+    }
+
+    // Load initial image if specified
+    if (!config_.initialImagePath.empty())
+        canvas->loadImageAsync(config_.initialImagePath);
+
+    if (config_.autosaveInterval <= 0.0f)
+        return;
+
+    try {
+        autosaver_ = std::make_unique<Autosaver>([canvas] { return canvas->captureSnapshot(true); }, settings);
+        std::cout << "Autosaving every " << settings.intervalSeconds << "s to " << settings.directory << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Autosave disabled: " << e.what() << std::endl;
+    }
+}
+
 void Application::run()
 {
     if (!initialized_) {
@@ -96,6 +146,13 @@ void Application::shutdown()
     running_ = false;
     std::cout << "Application shutting down..." << std::endl;
     
+    if (controlServer_)
+        controlServer_->stop();
+    
+    // A clean exit leaves nothing to recover
+    if (autosaver_)
+        autosaver_->discard();
+
     // Components will be cleaned up automatically by unique_ptr destructors
     // Window will be closed automatically by WindowResource destructor
     
@@ -70,12 +70,24 @@ void Application::createComponents()
     toolbar->addMenuItemToLastDropdown("Select", [this]() {
         eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Select);
     });
+    toolbar->addMenuItemToLastDropdown("Lasso", [this]() {
+        eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Lasso);
+    });
+    toolbar->addMenuItemToLastDropdown("Polygon Select", [this]() {
+        eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Polygon);
+    });
+    toolbar->addMenuItemToLastDropdown("Magic Wand", [this]() {
+        eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::MagicWand);
+    });
     toolbar->addMenuItemToLastDropdown("Mirror", [this]() {
         eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Mirror);
     });
     toolbar->addMenuItemToLastDropdown("Eyedropper", [this]() {
         eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Eyedropper);
     });
+    toolbar->addMenuItemToLastDropdown("Fill", [this]() {
+        eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Fill);
+    });
     toolbar->addMenuItemToLastDropdown("Blur", [this]() {
         eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Blur);
     });
@@ -99,6 +111,62 @@ void Application::createComponents()
         }
     });
     
+    // Filters preview on the selected layer until Enter applies them
+    toolbar->addDropdownMenu("Filters");
+    toolbar->addMenuItemToLastDropdown("Gaussian Blur", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::gaussianBlur());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Sharpen", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::sharpen());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Emboss", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::emboss());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Edge Detect", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::edgeDetect());
+        }
+    });
+    
+    // Tone adjustments, previewed the same way; Invert has nothing to adjust
+    toolbar->addDropdownMenu("Colors");
+    toolbar->addMenuItemToLastDropdown("Levels", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::levels());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Curves", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::curves());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Hue-Saturation", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::hueSaturation());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Invert", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->applyFilter(Filters::invert());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Posterize", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::posterize());
+        }
+    });
+    toolbar->addMenuItemToLastDropdown("Threshold", [this]() {
+        if (canvas_) {
+            static_cast<Canvas*>(canvas_.get())->beginFilterPreview(Filters::threshold());
+        }
+    });
+    
     // Add basic tool buttons (most commonly used)
     toolbar_->addButton("Crayon", [this]() {
         eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Crayon);
@@ -123,6 +191,8 @@ void Application::createComponents()
         static_cast<float>(config_.windowHeight - toolbar_->getHeight() - 25) // Leave space for status bar
     };
     canvas_ = std::make_unique<Canvas>(canvasBounds, eventDispatcher_.get(), historyManager_.get());
+    static_cast<Canvas*>(canvas_.get())->setPngCompressionLevel(config_.pngCompressionLevel);
+    static_cast<Canvas*>(canvas_.get())->setRawTileRle(config_.rawTileRle);
     
     // Create layer panel on the left
     const Rectangle layerPanelBounds = {
@@ -138,7 +208,7 @@ void Application::createComponents()
 
 void Application::onLoadImageRequest()
 {
-    fileManager_->showOpenDialog("Images (*.png *.jpg *.bmp)");
+    fileManager_->showOpenDialog("Images (*.png *.jpg *.bmp *.qoi *.ert *.epg)");
 }
 
 void Application::onImageSaveRequest(const ImageSaveRequestEvent& /*event*/)
@@ -149,7 +219,7 @@ void Application::onImageSaveRequest(const ImageSaveRequestEvent& /*event*/)
     }
     
     // Show save dialog - actual saving will happen in update loop
-    fileManager_->showSaveDialog("Images (*.png)", "output.png");
+    fileManager_->showSaveDialog("Images (*.png)", "output" + config_.saveExtension);
 }
 
 void Application::onError(const ErrorEvent& event)
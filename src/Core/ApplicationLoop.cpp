@@ -1,22 +1,38 @@
 //Application update and draw loops
 #include "../../include/Core/Application.hpp"
+#include "../../include/Core/JobSystem.hpp"
 #include "../../include/UI/Toolbar.hpp"
+#include "../../include/UI/Canvas.hpp"
 #include "../../include/UI/SimpleLayerPanel.hpp"
 #include "../../include/Utils/Implementations.hpp"
+#include "../../include/Utils/Autosaver.hpp"
+#include "../../include/Utils/ControlServer.hpp"
 #include <iostream>
 
 namespace EpiGimp {
 
+namespace {
+
+constexpr size_t MAX_MAIN_THREAD_TASKS_PER_FRAME = 32;   // The rest waits for the next frame
+
+} // namespace
+
 void Application::update(float deltaTime)
 {
     inputHandler_->update();
     handleEvents();
+
+    // GL uploads and UI changes handed back by background jobs
+    JobSystem::shared().runMainThreadTasks(MAX_MAIN_THREAD_TASKS_PER_FRAME);
+
+    // Events posted since the last frame, from workers or from UI code that queued them
+    eventDispatcher_->dispatchQueued();
     
     auto simpleFileManager = static_cast<SimpleFileManager*>(fileManager_.get());
     
     auto openResult = simpleFileManager->updateOpenDialog();
     if (openResult)
-        canvas_->loadImage(*openResult);
+        static_cast<Canvas*>(canvas_.get())->loadImageAsync(*openResult);
     
     auto saveResult = simpleFileManager->updateSaveDialog();
     if (saveResult)
@@ -33,6 +49,15 @@ void Application::update(float deltaTime)
             if (layerPanel_) layerPanel_->update(deltaTime);
         }
     }
+
+    // Remote requests run between frames, bounded so the UI keeps its frame rate
+    if (controlServer_)
+        controlServer_->processPending();
+
+    // Snapshots of a half-loaded document would autosave missing tiles
+    auto canvas = static_cast<Canvas*>(canvas_.get());
+    if (autosaver_ && canvas->hasImage() && !canvas->isLoadingImage())
+        autosaver_->update(deltaTime);
 }
     
 void Application::draw()
@@ -45,9 +70,12 @@ void Application::draw()
     DrawRectangle(0, statusY, config_.windowWidth, 25, LIGHTGRAY);
     DrawLine(0, statusY, config_.windowWidth, statusY, GRAY);
     
-    const std::string statusText = canvas_->hasImage() 
+    auto* canvas = static_cast<Canvas*>(canvas_.get());
+    std::string statusText = canvas_->hasImage() 
         ? "Canvas ready | Zoom: " + std::to_string(static_cast<int>(canvas_->getZoom() * 100)) + "%"
         : "Initializing canvas...";
+    if (canvas->isLoadingImage())
+        statusText += " | Loading image: " + std::to_string(static_cast<int>(canvas->getImageLoadProgress() * 100)) + "%";
     
     DrawText(statusText.c_str(), 10, statusY + 5, 14, BLACK);
     
@@ -84,8 +112,12 @@ void Application::handleEvents()
         }
     }
     
+    // Runs before the canvas sees the key, so whatever Escape is about to cancel still counts
     auto simpleFileManager = static_cast<SimpleFileManager*>(fileManager_.get());
-    if (inputHandler_->isKeyPressed(KEY_ESCAPE) && !simpleFileManager->isShowingDialog())
+    auto canvas = static_cast<Canvas*>(canvas_.get());
+    auto toolbar = static_cast<Toolbar*>(toolbar_.get());
+    if (inputHandler_->isKeyPressed(KEY_ESCAPE) && !simpleFileManager->isShowingDialog() && !canvas->usesEscape() &&
+        !(toolbar && toolbar->usesEscape()))
         running_ = false;
 }
 
@@ -0,0 +1,102 @@
+//Immutable copy of the document for off-thread consumers
+#include "../../include/Core/DocumentSnapshot.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace EpiGimp {
+
+SharedPixels makeSharedPixels(Image image)
+{
+    return SharedPixels(new Image(image), [](const Image* img) {
+        if (img && img->data)
+            UnloadImage(*img);
+        delete img;
+    });
+}
+
+namespace {
+
+constexpr size_t COMPOSITE_BAND_ROWS = 64;
+
+// Non-premultiplied source-over of one RGBA8 pixel onto another
+inline void blendPixel(uint8_t* dst, const uint8_t* src)
+{
+    const uint32_t sa = src[3];
+    if (sa == 0)
+        return;
+    if (sa == 255) {
+        std::memcpy(dst, src, 4);
+        return;
+    }
+
+    const uint32_t da = dst[3];
+    const uint32_t dstWeight = da * (255 - sa);              // Scaled by 255
+    const uint32_t outAlpha = sa * 255 + dstWeight;          // Scaled by 255
+    for (int c = 0; c < 3; ++c)
+        dst[c] = static_cast<uint8_t>((src[c] * sa * 255 + dst[c] * dstWeight + outAlpha / 2) / outAlpha);
+    dst[3] = static_cast<uint8_t>((outAlpha + 127) / 255);
+}
+
+void blendLayer(Image& target, const LayerSnapshot& layer)
+{
+    const Image& source = *layer.pixels;
+    const int width = std::min(target.width, source.width);
+    const int height = std::min(target.height, source.height);
+    auto* dstPixels = static_cast<uint8_t*>(target.data);
+    const auto* srcPixels = static_cast<const uint8_t*>(source.data);
+
+    // Rows are independent; bands of them go to the job system
+    JobSystem::shared().parallelFor(static_cast<size_t>(std::max(height, 0)), [&](size_t begin, size_t end) {
+        for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y) {
+            const int srcY = layer.flippedVertical ? source.height - 1 - y : y;
+            uint8_t* dstRow = dstPixels + static_cast<size_t>(y) * target.width * 4;
+            const uint8_t* srcRow = srcPixels + static_cast<size_t>(srcY) * source.width * 4;
+
+            for (int x = 0; x < width; ++x) {
+                const int srcX = layer.flippedHorizontal ? source.width - 1 - x : x;
+                blendPixel(dstRow + x * 4, srcRow + srcX * 4);
+            }
+        }
+    }, COMPOSITE_BAND_ROWS);
+}
+
+} // namespace
+
+bool DocumentSnapshot::hasVisibleContent() const
+{
+    if (isBackgroundVisible())
+        return true;
+    return std::any_of(layers_.begin(), layers_.end(), [](const LayerSnapshot& layer) {
+        return layer.visible && layer.pixels;
+    });
+}
+
+Image DocumentSnapshot::composite() const
+{
+    if (!hasVisibleContent() || width_ <= 0 || height_ <= 0)
+        return Image{};
+
+    Image result;
+    if (isBackgroundVisible()) {
+        result = ImageCopy(*background_);
+        if (result.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+            ImageFormat(&result, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        if (result.width != width_ || result.height != height_)
+            ImageResizeCanvas(&result, width_, height_, 0, 0, BLANK);
+    } else {
+        result = GenImageColor(width_, height_, BLANK);
+    }
+    if (!result.data)
+        return Image{};
+
+    for (const auto& layer : layers_) {
+        if (layer.visible && layer.pixels && layer.pixels->data)
+            blendLayer(result, layer);
+    }
+
+    return result;
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,143 @@
+//Event dispatcher queued delivery and subscription bookkeeping
+#include "../../include/Core/EventSystem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <iostream>
+#include <unordered_map>
+
+namespace EpiGimp {
+
+namespace detail {
+
+size_t nextEventTypeId()
+{
+    static std::atomic<size_t> next{0};
+    return next++;
+}
+
+HandlerChannel& HandlerRegistry::channel(size_t type)
+{
+    if (type >= channels.size())
+        channels.resize(type + 1);
+    if (!channels[type])
+        channels[type] = std::make_unique<HandlerChannel>();
+    return *channels[type];
+}
+
+uint64_t HandlerRegistry::add(size_t type, HandlerSlot slot)
+{
+    slot.id = nextId++;
+    const uint64_t id = slot.id;
+    HandlerChannel& target = channel(type);
+    if (publishing > 0) {
+        target.added.push_back(std::move(slot));
+        needsCompaction = true;
+    } else {
+        target.slots.push_back(std::move(slot));
+    }
+    return id;
+}
+
+void HandlerRegistry::unsubscribe(size_t type, uint64_t id)
+{
+    HandlerChannel* channel = find(type);
+    if (!channel)
+        return;
+
+    auto matches = [id](const HandlerSlot& slot) { return slot.id == id; };
+    channel->added.erase(std::remove_if(channel->added.begin(), channel->added.end(), matches), channel->added.end());
+
+    auto slot = std::find_if(channel->slots.begin(), channel->slots.end(), matches);
+    if (slot == channel->slots.end())
+        return;
+    if (publishing > 0) {
+        // It may be the handler running right now; drop it once publishing ends
+        slot->active = false;
+        needsCompaction = true;
+    } else {
+        channel->slots.erase(slot);
+    }
+}
+
+void HandlerRegistry::compact()
+{
+    for (auto& channel : channels) {
+        if (!channel)
+            continue;
+        channel->slots.erase(std::remove_if(channel->slots.begin(), channel->slots.end(),
+                                            [](const HandlerSlot& slot) { return !slot.active; }),
+                             channel->slots.end());
+        std::move(channel->added.begin(), channel->added.end(), std::back_inserter(channel->slots));
+        channel->added.clear();
+    }
+    needsCompaction = false;
+}
+
+} // namespace detail
+
+Subscription::Subscription(Subscription&& other) noexcept
+    : registry_(std::move(other.registry_)), type_(other.type_), id_(other.id_)
+{
+    other.id_ = 0;
+}
+
+Subscription& Subscription::operator=(Subscription&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        registry_ = std::move(other.registry_);
+        type_ = other.type_;
+        id_ = other.id_;
+        other.id_ = 0;
+    }
+    return *this;
+}
+
+void Subscription::reset()
+{
+    if (id_ != 0) {
+        if (auto registry = registry_.lock())
+            registry->unsubscribe(type_, id_);
+    }
+    registry_.reset();
+    id_ = 0;
+}
+
+EventDispatcher::EventDispatcher()
+    : registry_(std::make_shared<detail::HandlerRegistry>()), deliveryThread_(std::this_thread::get_id())
+{
+}
+
+size_t EventDispatcher::dispatchQueued(size_t maxEvents)
+{
+    if (std::this_thread::get_id() != deliveryThread_) {
+        std::cerr << "EventDispatcher: dispatchQueued called off the delivery thread, ignored" << std::endl;
+        return 0;
+    }
+
+    // Only what is queued now: events posted by handlers wait for the next call
+    std::vector<std::unique_ptr<QueuedEvent>> batch;
+    const size_t available = std::min(maxEvents, queue_.size());
+    std::unique_ptr<QueuedEvent> event;
+    while (batch.size() < available && queue_.pop(event))
+        batch.push_back(std::move(event));
+
+    // The newest event of a coalescing type stands in for the older ones
+    std::unordered_map<const void*, size_t> newest;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i]->coalesceKey)
+            newest[batch[i]->coalesceKey] = i;
+    }
+
+    size_t delivered = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i]->coalesceKey && newest[batch[i]->coalesceKey] != i)
+            continue;
+        batch[i]->deliver(*this);
+        delivered++;
+    }
+    return delivered;
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,310 @@
+//Work-stealing thread pool shared by every CPU-heavy subsystem
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+namespace EpiGimp {
+
+namespace {
+
+// Which pool, and which of its workers, the current thread is
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local size_t currentIndex = 0;
+
+// A waiting worker looks for new jobs to help with at least this often
+constexpr std::chrono::milliseconds HELP_INTERVAL{1};
+
+} // namespace
+
+bool JobSystem::Handle::isDone() const
+{
+    if (!job_)
+        return true;
+    std::lock_guard<std::mutex> lock(job_->mutex);
+    return job_->done;
+}
+
+JobSystem::JobSystem(unsigned workers)
+    : stopping_(false), queued_(0)
+{
+    if (workers == 0)
+        workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (unsigned i = 0; i < workers; ++i)
+        workers_.push_back(std::make_unique<Worker>());
+    for (unsigned i = 0; i < workers; ++i)
+        threads_.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeWorkers_.notify_all();
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+JobSystem& JobSystem::shared()
+{
+    static JobSystem system;
+    return system;
+}
+
+JobSystem::Handle JobSystem::submit(Task task, const std::vector<Handle>& dependencies)
+{
+    auto job = std::make_shared<Job>();
+    job->task = std::move(task);
+
+    for (const auto& dependency : dependencies) {
+        if (!dependency.job_)
+            continue;
+        std::lock_guard<std::mutex> lock(dependency.job_->mutex);
+        if (!dependency.job_->done) {
+            dependency.job_->dependents.push_back(job);
+            job->pending++;
+        }
+    }
+
+    Handle handle;
+    handle.job_ = job;
+    // Drop the submission guard; whoever finishes the last dependency schedules it otherwise
+    if (--job->pending == 0)
+        schedule(std::move(job));
+    return handle;
+}
+
+void JobSystem::wait(const Handle& handle)
+{
+    if (!handle.job_)
+        return;
+
+    Job& job = *handle.job_;
+    const bool helping = isWorkerThread();
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (job.done)
+                return;
+        }
+        if (helping && runOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(job.mutex);
+        if (helping)
+            job.finished.wait_for(lock, HELP_INTERVAL, [&job]() { return job.done; });
+        else
+            job.finished.wait(lock, [&job]() { return job.done; });
+    }
+}
+
+void JobSystem::parallelFor(size_t count, const RangeTask& body, size_t grain, unsigned maxThreads)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (count + grain - 1) / grain;
+    size_t participants = std::min<size_t>(chunks, getConcurrency());
+    if (maxThreads > 0)
+        participants = std::min<size_t>(participants, maxThreads);
+    if (participants <= 1) {
+        body(0, count);
+        return;
+    }
+
+    struct Range {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> completed{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;       // First exception thrown by body, guarded by mutex
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto range = std::make_shared<Range>();
+
+    // Helpers that only start after every chunk is claimed return without touching body,
+    // so it is safe for them to outlive this call. A chunk that throws still counts as
+    // completed, and after a failure the remaining chunks are counted without running.
+    const RangeTask* work = &body;
+    auto claim = [range, work, count, grain, chunks]() {
+        for (size_t i = range->next++; i < chunks; i = range->next++) {
+            if (!range->failed.load()) {
+                try {
+                    (*work)(i * grain, std::min(count, (i + 1) * grain));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(range->mutex);
+                    if (!range->error)
+                        range->error = std::current_exception();
+                    range->failed = true;
+                }
+            }
+            if (++range->completed == chunks) {
+                std::lock_guard<std::mutex> lock(range->mutex);
+                range->finished.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 1; i < participants; ++i)
+        submit(claim);
+    claim();
+
+    const bool helping = isWorkerThread();
+    auto finished = [&range, chunks]() { return range->completed.load() == chunks; };
+    while (!finished()) {
+        if (helping && runOne())
+            continue;
+
+        std::unique_lock<std::mutex> lock(range->mutex);
+        if (helping)
+            range->finished.wait_for(lock, HELP_INTERVAL, finished);
+        else
+            range->finished.wait(lock, finished);
+    }
+
+    // Every helper is done with body by now, so the exception can leave this frame
+    if (range->error)
+        std::rethrow_exception(range->error);
+}
+
+void JobSystem::postToMain(Task task)
+{
+    std::lock_guard<std::mutex> lock(mainMutex_);
+    mainTasks_.push_back(std::move(task));
+}
+
+size_t JobSystem::runMainThreadTasks(size_t maxTasks)
+{
+    std::deque<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex_);
+        const size_t count = std::min(maxTasks, mainTasks_.size());
+        tasks.insert(tasks.end(), std::make_move_iterator(mainTasks_.begin()),
+                     std::make_move_iterator(mainTasks_.begin() + static_cast<std::ptrdiff_t>(count)));
+        mainTasks_.erase(mainTasks_.begin(), mainTasks_.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+
+    for (auto& task : tasks)
+        task();
+    return tasks.size();
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+    currentSystem = this;
+    currentIndex = index;
+
+    while (true) {
+        if (auto job = take(index)) {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wakeWorkers_.wait(lock, [this]() { return stopping_ || queued_.load() > 0; });
+        // Queued jobs still run on shutdown; only an empty pool stops
+        if (stopping_ && queued_.load() == 0)
+            return;
+    }
+}
+
+void JobSystem::schedule(std::shared_ptr<Job> job)
+{
+    // Counted before it is visible, so a taker never sees the count go below zero
+    queued_++;
+    if (isWorkerThread()) {
+        Worker& worker = *workers_[currentIndex];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back(std::move(job));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);   // Orders the push before a sleeper's check
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        injected_.push_back(std::move(job));
+    }
+    wakeWorkers_.notify_one();
+}
+
+bool JobSystem::runOne()
+{
+    if (auto job = take(currentIndex)) {
+        run(job);
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<JobSystem::Job> JobSystem::take(size_t index)
+{
+    std::shared_ptr<Job> job;
+
+    // Newest own job first: its data is most likely still in cache
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+
+    if (!job) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!injected_.empty()) {
+            job = std::move(injected_.front());
+            injected_.pop_front();
+        }
+    }
+
+    // Steal the oldest job of another worker, the one its owner would reach last
+    for (size_t i = 1; !job && i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+
+    if (job)
+        queued_--;
+    return job;
+}
+
+void JobSystem::run(const std::shared_ptr<Job>& job)
+{
+    try {
+        job->task();
+    } catch (const std::exception& e) {
+        std::cerr << "JobSystem: Job failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "JobSystem: Job failed with an unknown exception" << std::endl;
+    }
+    job->task = nullptr;   // Release captures before waiters wake up
+
+    std::vector<std::shared_ptr<Job>> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        dependents.swap(job->dependents);
+    }
+    job->finished.notify_all();
+
+    for (auto& dependent : dependents) {
+        if (--dependent->pending == 0)
+            schedule(std::move(dependent));
+    }
+}
+
+bool JobSystem::isWorkerThread() const
+{
+    return currentSystem == this;
+}
+
+} // namespace EpiGimp
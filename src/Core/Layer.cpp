@@ -57,7 +57,7 @@ Image Layer::copyImage() const
     if (!texture_.has_value())
         return GenImageColor(width_, height_, BLANK);
     
-    return LoadImageFromTexture((**texture_).texture);
+    return texture_->readPixels();
 }
 
 bool Layer::restoreImage(const Image& image)
@@ -19,8 +19,9 @@ LayerManager::LayerManager(int width, int height, EventDispatcher* dispatcher)
 size_t LayerManager::createLayer(const std::string& name)
 {
     auto layer = std::make_unique<Layer>(name, canvasWidth_, canvasHeight_);
-    layers_.push_back(std::move(layer));
-    size_t newIndex = layers_.size() - 1;
+    LayerHandle handle = slots_.insert(LayerSlot{std::move(layer), 0});
+    size_t newIndex = order_.size();
+    insertAt(newIndex, handle);
     
     notifyLayerCreated(newIndex);
     return newIndex;
@@ -28,23 +29,15 @@ size_t LayerManager::createLayer(const std::string& name)
 
 bool LayerManager::deleteLayer(size_t index)
 {
-    if (!isValidIndex(index) || layers_.size() <= 1)
+    if (!isValidIndex(index) || order_.size() <= 1)
         return false; // Can't delete the last layer
     
-    std::string layerName = layers_[index]->getName();
-    layers_.erase(layers_.begin() + index);
-
-    if (activeLayerIndex_ >= layers_.size()) {
-        size_t oldIndex = activeLayerIndex_;
-        activeLayerIndex_ = layers_.size() - 1;
-        notifyActiveLayerChanged(oldIndex, activeLayerIndex_);
-    } else if (activeLayerIndex_ > index) {
-        size_t oldIndex = activeLayerIndex_;
-        activeLayerIndex_--;
-        notifyActiveLayerChanged(oldIndex, activeLayerIndex_);
-    }
+    LayerHandle handle = order_[index];
+    std::string layerName = getLayer(index)->getName();
+    removeAt(index);
+    slots_.erase(handle);
     
-    notifyLayerDeleted(index, layerName);
+    notifyLayerDeleted(handle, index, layerName);
     return true;
 }
 
@@ -53,9 +46,10 @@ bool LayerManager::moveLayer(size_t fromIndex, size_t toIndex)
     if (!isValidIndex(fromIndex) || !isValidIndex(toIndex) || fromIndex == toIndex)
         return false;
     
-    auto layer = std::move(layers_[fromIndex]);
-    layers_.erase(layers_.begin() + fromIndex);
-    layers_.insert(layers_.begin() + toIndex, std::move(layer));
+    LayerHandle handle = order_[fromIndex];
+    order_.erase(order_.begin() + fromIndex);
+    order_.insert(order_.begin() + toIndex, handle);
+    reindexFrom(std::min(fromIndex, toIndex));
     
     if (activeLayerIndex_ == fromIndex) {
         size_t oldIndex = activeLayerIndex_;
@@ -80,7 +74,7 @@ bool LayerManager::duplicateLayer(size_t index)
     if (!isValidIndex(index))
         return false;
     
-    const Layer* sourceLayer = layers_[index].get();
+    const Layer* sourceLayer = getLayer(index);
     std::string newName = sourceLayer->getName() + " Copy";
     
     auto newLayer = std::make_unique<Layer>(newName, canvasWidth_, canvasHeight_);
@@ -94,13 +88,8 @@ bool LayerManager::duplicateLayer(size_t index)
         UnloadImage(sourceImage);
     }
     
-    layers_.insert(layers_.begin() + index + 1, std::move(newLayer));
-    
-    if (activeLayerIndex_ > index) {
-        size_t oldIndex = activeLayerIndex_;
-        activeLayerIndex_++;
-        notifyActiveLayerChanged(oldIndex, activeLayerIndex_);
-    }
+    LayerHandle handle = slots_.insert(LayerSlot{std::move(newLayer), 0});
+    insertAt(index + 1, handle);
     
     notifyLayerCreated(index + 1);
     return true;
@@ -108,12 +97,69 @@ bool LayerManager::duplicateLayer(size_t index)
 
 Layer* LayerManager::getLayer(size_t index)
 {
-    return isValidIndex(index) ? layers_[index].get() : nullptr;
+    return isValidIndex(index) ? getLayer(order_[index]) : nullptr;
 }
 
 const Layer* LayerManager::getLayer(size_t index) const
 {
-    return isValidIndex(index) ? layers_[index].get() : nullptr;
+    return isValidIndex(index) ? getLayer(order_[index]) : nullptr;
+}
+
+Layer* LayerManager::getLayer(LayerHandle handle)
+{
+    LayerSlot* slot = slots_.get(handle);
+    return slot ? slot->layer.get() : nullptr;
+}
+
+const Layer* LayerManager::getLayer(LayerHandle handle) const
+{
+    const LayerSlot* slot = slots_.get(handle);
+    return slot ? slot->layer.get() : nullptr;
+}
+
+LayerHandle LayerManager::getLayerHandle(size_t index) const
+{
+    return isValidIndex(index) ? order_[index] : LayerHandle{};
+}
+
+int LayerManager::getLayerIndex(LayerHandle handle) const
+{
+    const LayerSlot* slot = slots_.get(handle);
+    if (!slot || !slot->layer)
+        return -1;
+    return static_cast<int>(slot->position);
+}
+
+std::unique_ptr<Layer> LayerManager::detachLayer(LayerHandle handle)
+{
+    LayerSlot* slot = slots_.get(handle);
+    if (!slot || !slot->layer || order_.size() <= 1)
+        return nullptr;
+    
+    size_t index = slot->position;
+    std::unique_ptr<Layer> layer = std::move(slot->layer);
+    removeAt(index);
+    
+    // The slot itself stays occupied so the handle cannot be recycled for another layer
+    notifyLayerDeleted(handle, index, layer->getName());
+    return layer;
+}
+
+bool LayerManager::reattachLayer(LayerHandle handle, std::unique_ptr<Layer> layer, size_t index)
+{
+    LayerSlot* slot = slots_.get(handle);
+    if (!slot || slot->layer || !layer)
+        return false;
+    
+    if (layer->getWidth() != canvasWidth_ || layer->getHeight() != canvasHeight_)
+        layer->resize(canvasWidth_, canvasHeight_);
+    
+    slot->layer = std::move(layer);
+    index = std::min(index, order_.size());
+    insertAt(index, handle);
+    
+    notifyLayerCreated(index);
+    return true;
 }
 
 Layer* LayerManager::getActiveLayer()
@@ -186,8 +232,8 @@ void LayerManager::resizeAllLayers(int width, int height)
     canvasWidth_ = width;
     canvasHeight_ = height;
     
-    for (auto& layer : layers_) {
-        layer->resize(width, height);
+    for (LayerHandle handle : order_) {
+        getLayer(handle)->resize(width, height);
     }
 }
 
@@ -203,7 +249,8 @@ void LayerManager::renderComposite(RenderTexture2D& compositeTexture) const
     DrawRectangle(300, 300, 100, 100, GREEN);
     
     int visibleLayers = 0;
-    for (const auto& layer : layers_) {
+    for (LayerHandle handle : order_) {
+        const Layer* layer = getLayer(handle);
         if (layer && layer->isVisible()) {
             visibleLayers++;
             if (layer->hasTexture()) {
@@ -228,18 +275,18 @@ void LayerManager::renderComposite(RenderTexture2D& compositeTexture) const
 
 void LayerManager::clear()
 {
-    for (auto& layer : layers_) {
-        layer->clear(BLANK);
+    for (LayerHandle handle : order_) {
+        getLayer(handle)->clear(BLANK);
     }
 }
 
 std::vector<std::string> LayerManager::getLayerNames() const
 {
     std::vector<std::string> names;
-    names.reserve(layers_.size());
+    names.reserve(order_.size());
     
-    for (const auto& layer : layers_) {
-        names.push_back(layer->getName());
+    for (LayerHandle handle : order_) {
+        names.push_back(getLayer(handle)->getName());
     }
     
     return names;
@@ -247,8 +294,8 @@ std::vector<std::string> LayerManager::getLayerNames() const
 
 int LayerManager::findLayerByName(const std::string& name) const
 {
-    for (size_t i = 0; i < layers_.size(); ++i) {
-        if (layers_[i]->getName() == name)
+    for (size_t i = 0; i < order_.size(); ++i) {
+        if (getLayer(i)->getName() == name)
             return static_cast<int>(i);
     }
     return -1;
@@ -256,33 +303,69 @@ int LayerManager::findLayerByName(const std::string& name) const
 
 void LayerManager::ensureDefaultLayer()
 {
-    if (layers_.empty()) {
+    if (order_.empty()) {
         createLayer("Background");
         // Clear the background layer to white
-        if (!layers_.empty())
-            layers_[0]->clear(WHITE);
+        if (!order_.empty())
+            getLayer(static_cast<size_t>(0))->clear(WHITE);
     }
 }
 
 bool LayerManager::isValidIndex(size_t index) const
 {
-    return index < layers_.size();
+    return index < order_.size();
+}
+
+void LayerManager::reindexFrom(size_t index)
+{
+    for (size_t i = index; i < order_.size(); ++i)
+        slots_.get(order_[i])->position = i;
+}
+
+void LayerManager::insertAt(size_t index, LayerHandle handle)
+{
+    order_.insert(order_.begin() + index, handle);
+    reindexFrom(index);
+    
+    if (order_.size() > 1 && activeLayerIndex_ >= index) {
+        size_t oldIndex = activeLayerIndex_;
+        activeLayerIndex_++;
+        notifyActiveLayerChanged(oldIndex, activeLayerIndex_);
+    }
+}
+
+void LayerManager::removeAt(size_t index)
+{
+    order_.erase(order_.begin() + index);
+    reindexFrom(index);
+    
+    if (activeLayerIndex_ >= order_.size()) {
+        size_t oldIndex = activeLayerIndex_;
+        activeLayerIndex_ = order_.size() - 1;
+        notifyActiveLayerChanged(oldIndex, activeLayerIndex_);
+    } else if (activeLayerIndex_ > index) {
+        size_t oldIndex = activeLayerIndex_;
+        activeLayerIndex_--;
+        notifyActiveLayerChanged(oldIndex, activeLayerIndex_);
+    }
 }
 
 void LayerManager::notifyLayerCreated(size_t index)
 {
     if (eventDispatcher_) {
         LayerCreatedEvent event;
+        event.layerHandle = order_[index];
         event.layerIndex = index;
-        event.layerName = layers_[index]->getName();
+        event.layerName = getLayer(index)->getName();
         eventDispatcher_->publish(event);
     }
 }
 
-void LayerManager::notifyLayerDeleted(size_t index, const std::string& name)
+void LayerManager::notifyLayerDeleted(LayerHandle handle, size_t index, const std::string& name)
 {
     if (eventDispatcher_) {
         LayerDeletedEvent event;
+        event.layerHandle = handle;
         event.layerIndex = index;
         event.layerName = name;
         eventDispatcher_->publish(event);
@@ -293,6 +376,7 @@ void LayerManager::notifyLayerVisibilityChanged(size_t index, bool visible)
 {
     if (eventDispatcher_) {
         LayerVisibilityChangedEvent event;
+        event.layerHandle = getLayerHandle(index);
         event.layerIndex = index;
         event.visible = visible;
         eventDispatcher_->publish(event);
@@ -303,6 +387,7 @@ void LayerManager::notifyLayerReordered(size_t fromIndex, size_t toIndex)
 {
     if (eventDispatcher_) {
         LayerReorderedEvent event;
+        event.layerHandle = getLayerHandle(toIndex);
         event.fromIndex = fromIndex;
         event.toIndex = toIndex;
         eventDispatcher_->publish(event);
@@ -313,6 +398,7 @@ void LayerManager::notifyActiveLayerChanged(size_t oldIndex, size_t newIndex)
 {
     if (eventDispatcher_) {
         ActiveLayerChangedEvent event;
+        event.newHandle = getLayerHandle(newIndex);
         event.oldIndex = oldIndex;
         event.newIndex = newIndex;
         eventDispatcher_->publish(event);
@@ -1,5 +1,8 @@
 #include "Core/RaylibWrappers.hpp"
+#include "Core/UploadScheduler.hpp"
+#include "Utils/StreamingDecoder.hpp"
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <cctype>
 
@@ -17,7 +20,33 @@ bool ImageResource::exportToFile(const std::string& path) const
     return exportToFile(path, actualPath);
 }
 
-bool ImageResource::exportToFile(const std::string& path, std::string& actualPath) const
+Image ImageResource::loadFile(const std::string& path, int maxWidth, int maxHeight)
+{
+    // Interlaced PNGs and exotic BMPs are not streamed and go through raylib below
+    if (auto streaming = StreamingDecoder::open(path)) {
+        Image image = StreamingDecoder::decode(*streaming, maxWidth, maxHeight);
+        if (image.data)
+            return image;
+    }
+
+    Image image;
+    if (QoiCodec::isQoiPath(path))
+        image = QoiCodec::read(path);
+    else if (RawTileFile::isRawTilePath(path))
+        image = RawTileFile::read(path);
+    else
+        image = LoadImage(path.c_str());
+
+    if (image.data && maxWidth > 0 && maxHeight > 0 && (image.width > maxWidth || image.height > maxHeight)) {
+        const float scale = std::min(static_cast<float>(maxWidth) / image.width,
+                                     static_cast<float>(maxHeight) / image.height);
+        ImageResize(&image, std::max(1, static_cast<int>(image.width * scale)),
+                    std::max(1, static_cast<int>(image.height * scale)));
+    }
+    return image;
+}
+
+bool ImageResource::exportToFile(const std::string& path, std::string& actualPath, const ExportOptions& options) const
 {
     if (!isValid())
         return false;
@@ -26,6 +55,20 @@ bool ImageResource::exportToFile(const std::string& path, std::string& actualPat
     if (actualPath.empty())
         return false; // Invalid extension and couldn't fix
     
+    // Fast scratch formats and PNG use the in-tree encoders, which spread the work over every core
+    if (PngWriter::isPngPath(actualPath)) {
+        PngWriter::Options pngOptions;
+        pngOptions.compressionLevel = options.pngCompressionLevel;
+        return PngWriter::write(*image_, actualPath, pngOptions);
+    }
+    if (QoiCodec::isQoiPath(actualPath))
+        return QoiCodec::write(*image_, actualPath);
+    if (RawTileFile::isRawTilePath(actualPath)) {
+        RawTileFile::Options rawOptions;
+        rawOptions.rle = options.rawTileRle;
+        return RawTileFile::write(*image_, actualPath, rawOptions);
+    }
+    
     return ExportImage(*image_, actualPath.c_str());
 }
 
@@ -36,7 +79,7 @@ std::string ImageResource::validateAndFixExtension(const std::string& path) cons
     
     std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
     
-    std::vector<std::string> supportedExts = {".png", ".bmp", ".tga", ".jpg", ".jpeg"};
+    std::vector<std::string> supportedExts = {".png", ".bmp", ".tga", ".jpg", ".jpeg", ".qoi", ".ert"};
     
     if (std::find(supportedExts.begin(), supportedExts.end(), extension) != supportedExts.end())
         return path; // Extension is valid, return as-is
@@ -55,6 +98,7 @@ WindowResource::WindowResource(int width, int height, const std::string& title)
     if (IsWindowReady()) {
         initialized_ = true;
         SetTargetFPS(60);
+        SetExitKey(KEY_NULL);   // Escape cancels tools and panels; the application decides when it quits
     }
 }
 
@@ -81,15 +125,24 @@ int WindowResource::getHeight() const
 
 RenderTextureResource::RenderTextureResource(int width, int height) 
     : renderTexture_(new RenderTexture2D(LoadRenderTexture(width, height)), [](RenderTexture2D* rt){
-        if (rt && rt->id > 0)
+        if (rt && rt->id > 0) {
+            // GL hands the id out again; pending uploads must not land on the next owner
+            UploadScheduler::shared().discard(rt->texture.id);
             UnloadRenderTexture(*rt);
+        }
         delete rt;
-    }) {}
+    }), revision_(0)
+{
+    markModified();
+}
 
 void RenderTextureResource::beginDrawing() const
 {
-    if (isValid())
+    if (isValid()) {
+        UploadScheduler::shared().flush(renderTexture_->texture.id);
+        markModified();
         BeginTextureMode(*renderTexture_);
+    }
 }
 
 void RenderTextureResource::endDrawing() const
@@ -107,4 +160,18 @@ void RenderTextureResource::clear(Color color) const
     }
 }
 
+Image RenderTextureResource::readPixels() const
+{
+    if (!isValid())
+        return Image{};
+    UploadScheduler::shared().flush(renderTexture_->texture.id);
+    return LoadImageFromTexture(renderTexture_->texture);
+}
+
+void RenderTextureResource::markModified() const
+{
+    static std::atomic<uint64_t> nextRevision{1};
+    revision_ = nextRevision.fetch_add(1);
+}
+
 } // namespace EpiGimp
\ No newline at end of file
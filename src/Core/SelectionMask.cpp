@@ -0,0 +1,619 @@
+//Tiled 8-bit selection coverage
+#include "../../include/Core/SelectionMask.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr int T = SelectionMask::TILE_SIZE;
+constexpr size_t TILE_PIXELS = static_cast<size_t>(T) * T;
+
+// Integer pixel range covered by region, clipped to the image; false if nothing is left
+bool clipRegion(Rectangle region, int width, int height, int& x0, int& y0, int& x1, int& y1)
+{
+    x0 = std::max(0, static_cast<int>(std::floor(region.x)));
+    y0 = std::max(0, static_cast<int>(std::floor(region.y)));
+    x1 = std::min(width, static_cast<int>(std::ceil(region.x + region.width)));
+    y1 = std::min(height, static_cast<int>(std::ceil(region.y + region.height)));
+    return x0 < x1 && y0 < y1;
+}
+
+uint8_t scale(uint8_t value, uint8_t coverage)
+{
+    return static_cast<uint8_t>((value * coverage + 127) / 255);
+}
+
+void combinePixels(uint8_t* a, const uint8_t* b, size_t count, SelectionMode mode)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i result = vb;
+        if (mode == SelectionMode::Add)
+            result = _mm_max_epu8(va, vb);
+        else if (mode == SelectionMode::Intersect)
+            result = _mm_min_epu8(va, vb);
+        else if (mode == SelectionMode::Subtract)
+            result = _mm_subs_epu8(va, vb);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), result);
+    }
+#endif
+    for (; i < count; ++i) {
+        if (mode == SelectionMode::Add)
+            a[i] = std::max(a[i], b[i]);
+        else if (mode == SelectionMode::Intersect)
+            a[i] = std::min(a[i], b[i]);
+        else if (mode == SelectionMode::Subtract)
+            a[i] = a[i] > b[i] ? static_cast<uint8_t>(a[i] - b[i]) : 0;
+        else
+            a[i] = b[i];
+    }
+}
+
+void invertPixels(uint8_t* pixels, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+    for (; i + 16 <= count; i += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), _mm_xor_si128(value, ones));
+    }
+#endif
+    for (; i < count; ++i)
+        pixels[i] = static_cast<uint8_t>(255 - pixels[i]);
+}
+
+bool isUniform(const uint8_t* pixels, size_t count, uint8_t value)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i expected = _mm_set1_epi8(static_cast<char>(value));
+    for (; i + 16 <= count; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, expected)) != 0xFFFF)
+            return false;
+    }
+#endif
+    for (; i < count; ++i) {
+        if (pixels[i] != value)
+            return false;
+    }
+    return true;
+}
+
+// Only the part of a tile inside the image counts; edge tiles keep unused bytes past it
+bool isUniformTile(const uint8_t* pixels, int visibleWidth, int visibleHeight)
+{
+    for (int row = 0; row < visibleHeight; ++row) {
+        if (!isUniform(pixels + static_cast<size_t>(row) * T, static_cast<size_t>(visibleWidth), pixels[0]))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SelectionMask::SelectionMask(int width, int height)
+    : width_(std::max(0, width)), height_(std::max(0, height)),
+      tilesX_((width_ + T - 1) / T), tilesY_((height_ + T - 1) / T),
+      tiles_(static_cast<size_t>(tilesX_) * tilesY_)
+{
+}
+
+SelectionMask SelectionMask::fromRect(int width, int height, Rectangle rect)
+{
+    SelectionMask mask(width, height);
+    mask.fillRect(rect, 255);
+    return mask;
+}
+
+SelectionMask SelectionMask::fromTiles(int width, int height, const TileGenerator& generate)
+{
+    SelectionMask mask(width, height);
+    JobSystem::shared().parallelFor(mask.tiles_.size(), [&](size_t begin, size_t end) {
+        std::vector<uint8_t> scratch(TILE_PIXELS, 0);
+        for (size_t index = begin; index < end; ++index) {
+            const int tx = static_cast<int>(index % mask.tilesX_);
+            const int ty = static_cast<int>(index / mask.tilesX_);
+            const int tileWidth = std::min(T, mask.width_ - tx * T);
+            const int tileHeight = std::min(T, mask.height_ - ty * T);
+            generate(tx * T, ty * T, tileWidth, tileHeight, scratch.data());
+
+            // Each job owns its tiles, so they can be written without locking; the scratch
+            // buffer is only handed over when the tile really varies
+            Tile& tile = mask.tiles_[index];
+            if (isUniformTile(scratch.data(), tileWidth, tileHeight)) {
+                tile.value = scratch[0];
+            } else {
+                tile.pixels.swap(scratch);
+                scratch.assign(TILE_PIXELS, 0);
+            }
+        }
+    }, 4);
+    return mask;
+}
+
+Rectangle SelectionMask::toBottomUp(Rectangle region, int height)
+{
+    return Rectangle{region.x, static_cast<float>(height) - region.y - region.height, region.width, region.height};
+}
+
+bool SelectionMask::uniformValue(int tx, int ty, uint8_t& value) const
+{
+    if (tx < 0 || ty < 0 || tx >= tilesX_ || ty >= tilesY_) {
+        value = 0;
+        return true;
+    }
+    const Tile* tile = tileAt(tx, ty);
+    value = tile->value;
+    return tile->pixels.empty();
+}
+
+void SelectionMask::materialize(Tile& tile)
+{
+    if (tile.pixels.empty())
+        tile.pixels.assign(TILE_PIXELS, tile.value);
+}
+
+void SelectionMask::collapse(Tile& tile, int tx, int ty)
+{
+    if (tile.pixels.empty())
+        return;
+
+    if (!isUniformTile(tile.pixels.data(), std::min(T, width_ - tx * T), std::min(T, height_ - ty * T)))
+        return;
+    tile.value = tile.pixels[0];
+    std::vector<uint8_t>().swap(tile.pixels);
+}
+
+bool SelectionMask::isEmpty() const
+{
+    for (int ty = 0; ty < tilesY_; ++ty) {
+        for (int tx = 0; tx < tilesX_; ++tx) {
+            const Tile* tile = tileAt(tx, ty);
+            if (tile->pixels.empty()) {
+                if (tile->value != 0)
+                    return false;
+                continue;
+            }
+            const int visibleWidth = std::min(T, width_ - tx * T);
+            const int visibleHeight = std::min(T, height_ - ty * T);
+            for (int row = 0; row < visibleHeight; ++row) {
+                if (!isUniform(tile->pixels.data() + static_cast<size_t>(row) * T, static_cast<size_t>(visibleWidth), 0))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SelectionMask::isRectangle() const
+{
+    const Rectangle bounds = getBounds();
+    if (bounds.width <= 0 || bounds.height <= 0)
+        return false;
+
+    bool full = true;
+    forEachRun(bounds, false, [&full](int, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+        if (!full)
+            return;
+        full = values ? isUniform(values, static_cast<size_t>(x1 - x0 + 1), 255) : uniform == 255;
+    });
+    return full;
+}
+
+Rectangle SelectionMask::getBounds() const
+{
+    int minX = width_, minY = height_, maxX = -1, maxY = -1;
+    for (int ty = 0; ty < tilesY_; ++ty) {
+        for (int tx = 0; tx < tilesX_; ++tx) {
+            const Tile* tile = tileAt(tx, ty);
+            const int visibleWidth = std::min(T, width_ - tx * T);
+            const int visibleHeight = std::min(T, height_ - ty * T);
+            if (tile->pixels.empty()) {
+                if (tile->value == 0)
+                    continue;
+                minX = std::min(minX, tx * T);
+                minY = std::min(minY, ty * T);
+                maxX = std::max(maxX, tx * T + visibleWidth - 1);
+                maxY = std::max(maxY, ty * T + visibleHeight - 1);
+                continue;
+            }
+            for (int row = 0; row < visibleHeight; ++row) {
+                const uint8_t* pixels = tile->pixels.data() + static_cast<size_t>(row) * T;
+                int first = 0;
+                while (first < visibleWidth && pixels[first] == 0)
+                    ++first;
+                if (first == visibleWidth)
+                    continue;
+                int last = visibleWidth - 1;
+                while (pixels[last] == 0)
+                    --last;
+                minX = std::min(minX, tx * T + first);
+                maxX = std::max(maxX, tx * T + last);
+                minY = std::min(minY, ty * T + row);
+                maxY = std::max(maxY, ty * T + row);
+            }
+        }
+    }
+    if (maxX < 0)
+        return Rectangle{0, 0, 0, 0};
+    return Rectangle{static_cast<float>(minX), static_cast<float>(minY),
+                     static_cast<float>(maxX - minX + 1), static_cast<float>(maxY - minY + 1)};
+}
+
+uint8_t SelectionMask::at(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= width_ || y >= height_)
+        return 0;
+    const Tile* tile = tileAt(x / T, y / T);
+    return tile->pixels.empty() ? tile->value : tile->pixels[static_cast<size_t>(y % T) * T + x % T];
+}
+
+size_t SelectionMask::getStoredTileCount() const
+{
+    return static_cast<size_t>(std::count_if(tiles_.begin(), tiles_.end(), [](const Tile& tile) { return !tile.pixels.empty(); }));
+}
+
+void SelectionMask::fill(uint8_t value)
+{
+    for (auto& tile : tiles_) {
+        tile.value = value;
+        std::vector<uint8_t>().swap(tile.pixels);
+    }
+    outlineValid_ = false;
+}
+
+void SelectionMask::fillRect(Rectangle rect, uint8_t value)
+{
+    int x0, y0, x1, y1;
+    if (!clipRegion(rect, width_, height_, x0, y0, x1, y1))
+        return;
+
+    for (int ty = y0 / T; ty <= (y1 - 1) / T; ++ty) {
+        for (int tx = x0 / T; tx <= (x1 - 1) / T; ++tx) {
+            Tile& tile = *tileAt(tx, ty);
+            const int tileX = tx * T, tileY = ty * T;
+            const int sx0 = std::max(x0, tileX), sx1 = std::min(x1, tileX + T);
+            const int sy0 = std::max(y0, tileY), sy1 = std::min(y1, tileY + T);
+
+            // Covering the tile's whole visible area makes it uniform
+            if (sx0 == tileX && sy0 == tileY && sx1 == std::min(width_, tileX + T) && sy1 == std::min(height_, tileY + T)) {
+                tile.value = value;
+                std::vector<uint8_t>().swap(tile.pixels);
+                continue;
+            }
+            if (tile.pixels.empty() && tile.value == value)
+                continue;
+            materialize(tile);
+            for (int y = sy0; y < sy1; ++y)
+                std::memset(tile.pixels.data() + static_cast<size_t>(y - tileY) * T + (sx0 - tileX), value, static_cast<size_t>(sx1 - sx0));
+            collapse(tile, tx, ty);
+        }
+    }
+    outlineValid_ = false;
+}
+
+void SelectionMask::setSpan(int y, int x0, int x1, uint8_t value)
+{
+    if (y < 0 || y >= height_)
+        return;
+    x0 = std::max(0, x0);
+    x1 = std::min(width_ - 1, x1);
+    if (x0 > x1)
+        return;
+
+    const int ty = y / T;
+    for (int tx = x0 / T; tx <= x1 / T; ++tx) {
+        Tile& tile = *tileAt(tx, ty);
+        if (tile.pixels.empty() && tile.value == value)
+            continue;
+        const int sx0 = std::max(x0, tx * T), sx1 = std::min(x1, tx * T + T - 1);
+        materialize(tile);
+        std::memset(tile.pixels.data() + static_cast<size_t>(y - ty * T) * T + (sx0 - tx * T), value, static_cast<size_t>(sx1 - sx0 + 1));
+    }
+    outlineValid_ = false;
+}
+
+void SelectionMask::setRegion(Rectangle region, const uint8_t* values, int stride)
+{
+    const int rx = static_cast<int>(region.x), ry = static_cast<int>(region.y);
+    int x0, y0, x1, y1;
+    if (!values || !clipRegion(Rectangle{static_cast<float>(rx), static_cast<float>(ry), region.width, region.height}, width_, height_, x0, y0, x1, y1))
+        return;
+
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* source = values + static_cast<size_t>(y - ry) * stride + (x0 - rx);
+        const int ty = y / T;
+        for (int tx = x0 / T; tx <= (x1 - 1) / T; ++tx) {
+            const int sx0 = std::max(x0, tx * T), sx1 = std::min(x1, tx * T + T);
+            Tile& tile = *tileAt(tx, ty);
+            if (tile.pixels.empty() && isUniform(source + (sx0 - x0), static_cast<size_t>(sx1 - sx0), tile.value))
+                continue;
+            materialize(tile);
+            std::memcpy(tile.pixels.data() + static_cast<size_t>(y - ty * T) * T + (sx0 - tx * T), source + (sx0 - x0), static_cast<size_t>(sx1 - sx0));
+        }
+    }
+    for (int ty = y0 / T; ty <= (y1 - 1) / T; ++ty) {
+        for (int tx = x0 / T; tx <= (x1 - 1) / T; ++tx)
+            collapse(*tileAt(tx, ty), tx, ty);
+    }
+    outlineValid_ = false;
+}
+
+void SelectionMask::compact()
+{
+    for (int ty = 0; ty < tilesY_; ++ty) {
+        for (int tx = 0; tx < tilesX_; ++tx)
+            collapse(*tileAt(tx, ty), tx, ty);
+    }
+}
+
+void SelectionMask::combine(const SelectionMask& other, SelectionMode mode)
+{
+    if (other.width_ != width_ || other.height_ != height_) {
+        std::cerr << "SelectionMask: Cannot combine a " << other.width_ << "x" << other.height_
+                  << " mask with a " << width_ << "x" << height_ << " one" << std::endl;
+        return;
+    }
+    if (mode == SelectionMode::Replace) {
+        *this = other;
+        outlineValid_ = false;
+        return;
+    }
+
+    std::vector<uint8_t> uniformPixels;
+    for (int ty = 0; ty < tilesY_; ++ty) {
+        for (int tx = 0; tx < tilesX_; ++tx) {
+            Tile& a = *tileAt(tx, ty);
+            const Tile& b = *other.tileAt(tx, ty);
+            const bool aUniform = a.pixels.empty();
+            const bool bUniform = b.pixels.empty();
+
+            // Whole-tile answers: an empty or full tile on either side decides most cases
+            if (mode == SelectionMode::Add) {
+                if ((bUniform && b.value == 0) || (aUniform && a.value == 255))
+                    continue;
+                if ((bUniform && b.value == 255) || (aUniform && a.value == 0)) {
+                    a = b;
+                    continue;
+                }
+            } else if (mode == SelectionMode::Intersect) {
+                if ((bUniform && b.value == 255) || (aUniform && a.value == 0))
+                    continue;
+                if ((bUniform && b.value == 0) || (aUniform && a.value == 255)) {
+                    a = b;
+                    continue;
+                }
+            } else if (mode == SelectionMode::Subtract) {
+                if ((bUniform && b.value == 0) || (aUniform && a.value == 0))
+                    continue;
+                if (bUniform && b.value == 255) {
+                    a = Tile{};
+                    continue;
+                }
+            }
+
+            const uint8_t* source = b.pixels.data();
+            if (bUniform) {
+                uniformPixels.assign(TILE_PIXELS, b.value);
+                source = uniformPixels.data();
+            }
+            materialize(a);
+            combinePixels(a.pixels.data(), source, TILE_PIXELS, mode);
+            collapse(a, tx, ty);
+        }
+    }
+    outlineValid_ = false;
+}
+
+void SelectionMask::invert()
+{
+    for (auto& tile : tiles_) {
+        if (tile.pixels.empty())
+            tile.value = static_cast<uint8_t>(255 - tile.value);
+        else
+            invertPixels(tile.pixels.data(), tile.pixels.size());
+    }
+    outlineValid_ = false;
+}
+
+void SelectionMask::forEachRun(Rectangle region, bool skipEmpty, const RunCallback& run) const
+{
+    int x0, y0, x1, y1;
+    if (!clipRegion(region, width_, height_, x0, y0, x1, y1))
+        return;
+
+    for (int y = y0; y < y1; ++y) {
+        const int ty = y / T;
+        const size_t rowOffset = static_cast<size_t>(y - ty * T) * T;
+
+        // Neighbouring uniform tiles with the same value merge into one segment
+        int pendingStart = -1, pendingEnd = -1;
+        uint8_t pendingValue = 0;
+        auto flush = [&]() {
+            if (pendingStart >= 0 && !(skipEmpty && pendingValue == 0))
+                run(y, pendingStart, pendingEnd, nullptr, pendingValue);
+            pendingStart = -1;
+        };
+
+        for (int tx = x0 / T; tx <= (x1 - 1) / T; ++tx) {
+            const int sx0 = std::max(x0, tx * T), sx1 = std::min(x1, tx * T + T) - 1;
+            const Tile* tile = tileAt(tx, ty);
+            if (tile->pixels.empty()) {
+                if (pendingStart >= 0 && pendingValue == tile->value) {
+                    pendingEnd = sx1;
+                } else {
+                    flush();
+                    pendingStart = sx0;
+                    pendingEnd = sx1;
+                    pendingValue = tile->value;
+                }
+                continue;
+            }
+            flush();
+            run(y, sx0, sx1, tile->pixels.data() + rowOffset + (sx0 - tx * T), 0);
+        }
+        flush();
+    }
+}
+
+void SelectionMask::clipCoverage(uint8_t* coverage, int stride, Rectangle region, bool bottomUp) const
+{
+    if (!coverage)
+        return;
+    forEachRun(region, false, [&](int y, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+        uint8_t* row = coverage + static_cast<size_t>(bottomUp ? height_ - 1 - y : y) * stride;
+        if (!values && uniform == 255)
+            return;
+        if (!values && uniform == 0) {
+            std::memset(row + x0, 0, static_cast<size_t>(x1 - x0 + 1));
+            return;
+        }
+        for (int x = x0; x <= x1; ++x)
+            row[x] = scale(row[x], values ? values[x - x0] : uniform);
+    });
+}
+
+void SelectionMask::restoreOutside(Image& edited, const Image& original, Rectangle region, bool bottomUp) const
+{
+    if (!edited.data || !original.data || edited.width != width_ || edited.height != height_ ||
+        original.width != width_ || original.height != height_ ||
+        edited.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || original.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "SelectionMask: restoreOutside needs two RGBA8 images of the mask's size" << std::endl;
+        return;
+    }
+    restoreRuns(edited, original, region, Rectangle{0, 0, static_cast<float>(width_), static_cast<float>(height_)}, bottomUp);
+}
+
+void SelectionMask::restoreOutsideRegion(Image& edited, const Image& original, Rectangle region, bool bottomUp) const
+{
+    const int width = static_cast<int>(region.width), height = static_cast<int>(region.height);
+    if (!edited.data || !original.data || edited.width != width || edited.height != height ||
+        original.width != width || original.height != height || region.x < 0 || region.y < 0 ||
+        region.x + width > width_ || region.y + height > height_ ||
+        edited.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || original.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "SelectionMask: restoreOutsideRegion needs two RGBA8 images of the region's size" << std::endl;
+        return;
+    }
+    restoreRuns(edited, original, region, region, bottomUp);
+}
+
+void SelectionMask::restoreRuns(Image& edited, const Image& original, Rectangle region, Rectangle area, bool bottomUp) const
+{
+    // area is the part of the mask the images hold
+    const int left = static_cast<int>(area.x), top = static_cast<int>(area.y);
+    const int width = static_cast<int>(area.width), height = static_cast<int>(area.height);
+    auto* target = static_cast<uint8_t*>(edited.data);
+    const auto* source = static_cast<const uint8_t*>(original.data);
+    forEachRun(region, false, [&](int y, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+        if (!values && uniform == 255)
+            return;
+        const int row = bottomUp ? top + height - 1 - y : y - top;
+        const size_t offset = (static_cast<size_t>(row) * width + (x0 - left)) * 4;
+        if (!values && uniform == 0) {
+            std::memcpy(target + offset, source + offset, static_cast<size_t>(x1 - x0 + 1) * 4);
+            return;
+        }
+        for (int x = x0; x <= x1; ++x) {
+            const unsigned coverage = values ? values[x - x0] : uniform;
+            uint8_t* pixel = target + offset + static_cast<size_t>(x - x0) * 4;
+            const uint8_t* before = source + offset + static_cast<size_t>(x - x0) * 4;
+            for (int c = 0; c < 4; ++c)
+                pixel[c] = static_cast<uint8_t>((pixel[c] * coverage + before[c] * (255 - coverage) + 127) / 255);
+        }
+    });
+}
+
+void SelectionMask::clearCovered(Image& target, bool bottomUp) const
+{
+    if (!target.data || target.width != width_ || target.height != height_ || target.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        return;
+
+    auto* pixels = static_cast<uint8_t*>(target.data);
+    forEachRun(getBounds(), true, [&](int y, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+        uint8_t* row = pixels + (static_cast<size_t>(bottomUp ? height_ - 1 - y : y) * width_ + x0) * 4;
+        if (!values && uniform == 255) {
+            std::memset(row, 0, static_cast<size_t>(x1 - x0 + 1) * 4);
+            return;
+        }
+        for (int x = 0; x <= x1 - x0; ++x) {
+            const uint8_t coverage = values ? values[x] : uniform;
+            if (coverage == 255)
+                std::memset(row + x * 4, 0, 4);
+            else
+                row[x * 4 + 3] = scale(row[x * 4 + 3], static_cast<uint8_t>(255 - coverage));
+        }
+    });
+}
+
+const std::vector<Vector2>& SelectionMask::getOutline() const
+{
+    if (!outlineValid_) {
+        buildOutline();
+        outlineValid_ = true;
+    }
+    return outline_;
+}
+
+void SelectionMask::buildOutline() const
+{
+    outline_.clear();
+
+    // Marching squares over cells whose corners are pixel centres; a cell's corners span
+    // up to four tiles, and when those are uniform on the same side there is no edge in it
+    for (int ty = -1; ty < tilesY_; ++ty) {
+        for (int tx = -1; tx < tilesX_; ++tx) {
+            uint8_t v00, v10, v01, v11;
+            const bool uniform = uniformValue(tx, ty, v00) && uniformValue(tx + 1, ty, v10) &&
+                                 uniformValue(tx, ty + 1, v01) && uniformValue(tx + 1, ty + 1, v11);
+            const bool inside = v00 >= 128;
+            if (uniform && (v10 >= 128) == inside && (v01 >= 128) == inside && (v11 >= 128) == inside)
+                continue;
+
+            const int cx0 = std::max(-1, tx * T), cx1 = std::min(width_ - 1, tx * T + T - 1);
+            const int cy0 = std::max(-1, ty * T), cy1 = std::min(height_ - 1, ty * T + T - 1);
+            for (int cy = cy0; cy <= cy1; ++cy) {
+                for (int cx = cx0; cx <= cx1; ++cx) {
+                    const int index = (at(cx, cy) >= 128 ? 8 : 0) | (at(cx + 1, cy) >= 128 ? 4 : 0) |
+                                      (at(cx + 1, cy + 1) >= 128 ? 2 : 0) | (at(cx, cy + 1) >= 128 ? 1 : 0);
+                    if (index == 0 || index == 15)
+                        continue;
+
+                    const float x = static_cast<float>(cx), y = static_cast<float>(cy);
+                    const Vector2 top{x + 1.0f, y + 0.5f}, right{x + 1.5f, y + 1.0f};
+                    const Vector2 bottom{x + 1.0f, y + 1.5f}, left{x + 0.5f, y + 1.0f};
+                    auto segment = [this](Vector2 a, Vector2 b) {
+                        outline_.push_back(a);
+                        outline_.push_back(b);
+                    };
+                    switch (index) {
+                        case 1: case 14: segment(left, bottom); break;
+                        case 2: case 13: segment(bottom, right); break;
+                        case 3: case 12: segment(left, right); break;
+                        case 4: case 11: segment(top, right); break;
+                        case 6: case 9: segment(top, bottom); break;
+                        case 7: case 8: segment(left, top); break;
+                        case 5: segment(top, right); segment(left, bottom); break;
+                        case 10: segment(left, top); segment(bottom, right); break;
+                        default: break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace EpiGimp
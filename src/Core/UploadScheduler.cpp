@@ -0,0 +1,266 @@
+//Budgeted main-thread texture uploads of dirty regions
+#include "../../include/Core/UploadScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace EpiGimp {
+
+namespace {
+
+bool overlaps(const Rectangle& a, const Rectangle& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+} // namespace
+
+UploadScheduler& UploadScheduler::shared()
+{
+    static UploadScheduler scheduler;
+    return scheduler;
+}
+
+void UploadScheduler::submit(const Texture2D& texture, SharedPixels pixels, Rectangle region)
+{
+    if (texture.id == 0 || !pixels || !pixels->data)
+        return;
+    if (pixels->width != texture.width || pixels->height != texture.height ||
+        pixels->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || texture.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "UploadScheduler: Pixels do not match texture " << texture.id << ", ignored" << std::endl;
+        return;
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(region.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(region.y)));
+    const int x1 = std::min(texture.width, static_cast<int>(std::ceil(region.x + region.width)));
+    const int y1 = std::min(texture.height, static_cast<int>(std::ceil(region.y + region.height)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Target& target = targets_[texture.id];
+    if (target.texture.width != texture.width || target.texture.height != texture.height) {
+        target.texture = texture;
+        target.tilesX = (texture.width + TILE_SIZE - 1) / TILE_SIZE;
+        target.tilesY = (texture.height + TILE_SIZE - 1) / TILE_SIZE;
+        target.dirty.assign(static_cast<size_t>(target.tilesX) * target.tilesY, 0);
+        target.dirtyCount = 0;
+    }
+
+    // The newest pixels serve every pending tile, older submissions included
+    target.pixels = std::move(pixels);
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ++ty) {
+        for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; ++tx) {
+            uint8_t& flag = target.dirty[static_cast<size_t>(ty) * target.tilesX + tx];
+            if (!flag) {
+                flag = 1;
+                target.dirtyCount++;
+            }
+        }
+    }
+}
+
+UploadScheduler::Stats UploadScheduler::update(const Budget& budget, const std::unordered_map<unsigned, Rectangle>& visible)
+{
+    const auto start = std::chrono::steady_clock::now();
+    Stats stats;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Candidate> candidates;
+    for (const auto& [id, target] : targets_) {
+        if (target.dirtyCount == 0)
+            continue;
+
+        auto interest = visible.find(id);
+        const bool hasInterest = interest != visible.end() && interest->second.width > 0 && interest->second.height > 0;
+        for (const Rectangle& tiles : mergeTiles(target.dirty, target.tilesX, target.tilesY)) {
+            Candidate candidate{id, tiles, false, 0.0f};
+            if (hasInterest) {
+                const Rectangle area = {tiles.x * TILE_SIZE, tiles.y * TILE_SIZE, tiles.width * TILE_SIZE, tiles.height * TILE_SIZE};
+                const Rectangle& view = interest->second;
+                const float dx = (area.x + area.width / 2) - (view.x + view.width / 2);
+                const float dy = (area.y + area.height / 2) - (view.y + view.height / 2);
+                candidate.visible = overlaps(area, view);
+                candidate.distance = dx * dx + dy * dy;
+            }
+            candidates.push_back(candidate);
+        }
+    }
+
+    // On screen first, then nearest to what is on screen, then top to bottom
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.visible != b.visible)
+            return a.visible;
+        if (a.distance != b.distance)
+            return a.distance < b.distance;
+        if (a.textureId != b.textureId)
+            return a.textureId < b.textureId;
+        return a.tiles.y < b.tiles.y || (a.tiles.y == b.tiles.y && a.tiles.x < b.tiles.x);
+    });
+
+    for (const Candidate& candidate : candidates) {
+        // Something always goes up, so even a tiny budget makes progress
+        const bool spent = stats.bytes >= budget.bytes || std::chrono::steady_clock::now() - start >= budget.time;
+        if (spent && stats.uploads > 0)
+            break;
+
+        Target& target = targets_[candidate.textureId];
+        const size_t remaining = budget.bytes > stats.bytes ? budget.bytes - stats.bytes : 0;
+        stats.bytes += uploadLocked(target, candidate.tiles, remaining);
+        stats.uploads++;
+    }
+
+    for (auto it = targets_.begin(); it != targets_.end();) {
+        if (it->second.dirtyCount == 0)
+            it = targets_.erase(it);
+        else
+            ++it;
+    }
+
+    lastStats_ = stats;
+    return stats;
+}
+
+void UploadScheduler::flush(unsigned textureId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = targets_.find(textureId);
+    if (it == targets_.end())
+        return;
+
+    Target& target = it->second;
+    if (target.dirtyCount > 0) {
+        for (const Rectangle& tiles : mergeTiles(target.dirty, target.tilesX, target.tilesY))
+            uploadLocked(target, tiles, static_cast<size_t>(-1));
+    }
+    targets_.erase(it);
+}
+
+void UploadScheduler::flushAll()
+{
+    std::vector<unsigned> ids;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : targets_)
+            ids.push_back(entry.first);
+    }
+    for (unsigned id : ids)
+        flush(id);
+}
+
+void UploadScheduler::discard(unsigned textureId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    targets_.erase(textureId);
+}
+
+bool UploadScheduler::hasPending(unsigned textureId) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = targets_.find(textureId);
+    return it != targets_.end() && it->second.dirtyCount > 0;
+}
+
+bool UploadScheduler::isIdle() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::all_of(targets_.begin(), targets_.end(), [](const auto& entry) { return entry.second.dirtyCount == 0; });
+}
+
+size_t UploadScheduler::getPendingBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t tiles = 0;
+    for (const auto& entry : targets_)
+        tiles += entry.second.dirtyCount;
+    return tiles * TILE_SIZE * TILE_SIZE * 4;   // Edge tiles counted whole
+}
+
+size_t UploadScheduler::uploadLocked(Target& target, Rectangle tiles, size_t maxBytes)
+{
+    const Texture2D& texture = target.texture;
+    const int x = static_cast<int>(tiles.x) * TILE_SIZE;
+    const int y = static_cast<int>(tiles.y) * TILE_SIZE;
+    const int width = std::min(static_cast<int>(tiles.width) * TILE_SIZE, texture.width - x);
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+
+    // Too big for what is left of the budget: the top band of tile rows now, the rest later
+    int tileRows = static_cast<int>(tiles.height);
+    const size_t tileRowBytes = rowBytes * TILE_SIZE;
+    if (tileRowBytes > 0 && static_cast<size_t>(tileRows) * tileRowBytes > maxBytes)
+        tileRows = std::max(1, static_cast<int>(maxBytes / tileRowBytes));
+    const int height = std::min(tileRows * TILE_SIZE, texture.height - y);
+
+    const auto* source = static_cast<const uint8_t*>(target.pixels->data);
+    const uint8_t* data = source + (static_cast<size_t>(y) * texture.width + x) * 4;
+    if (width != texture.width) {
+        // Rows of a partial-width rect are not contiguous in the source
+        scratch_.resize(rowBytes * height);
+        for (int row = 0; row < height; ++row)
+            std::memcpy(scratch_.data() + row * rowBytes, data + static_cast<size_t>(row) * texture.width * 4, rowBytes);
+        data = scratch_.data();
+    }
+    UpdateTextureRec(texture, Rectangle{static_cast<float>(x), static_cast<float>(y), static_cast<float>(width),
+                                        static_cast<float>(height)}, data);
+
+    for (int ty = static_cast<int>(tiles.y); ty < static_cast<int>(tiles.y) + tileRows; ++ty) {
+        for (int tx = static_cast<int>(tiles.x); tx < static_cast<int>(tiles.x + tiles.width); ++tx) {
+            uint8_t& flag = target.dirty[static_cast<size_t>(ty) * target.tilesX + tx];
+            if (flag) {
+                flag = 0;
+                target.dirtyCount--;
+            }
+        }
+    }
+    if (target.dirtyCount == 0)
+        target.pixels.reset();
+    return rowBytes * height;
+}
+
+std::vector<Rectangle> UploadScheduler::mergeTiles(const std::vector<uint8_t>& dirty, int tilesX, int tilesY)
+{
+    struct Open {
+        int x0, x1, y0;
+    };
+
+    std::vector<Rectangle> rects;
+    std::vector<Open> open;
+    std::vector<Open> next;
+    auto close = [&rects](const Open& run, int y) {
+        rects.push_back(Rectangle{static_cast<float>(run.x0), static_cast<float>(run.y0),
+                                  static_cast<float>(run.x1 - run.x0), static_cast<float>(y - run.y0)});
+    };
+
+    for (int y = 0; y < tilesY; ++y) {
+        next.clear();
+        size_t o = 0;
+        for (int x = 0; x < tilesX;) {
+            if (!dirty[static_cast<size_t>(y) * tilesX + x]) {
+                ++x;
+                continue;
+            }
+            const int x0 = x;
+            while (x < tilesX && dirty[static_cast<size_t>(y) * tilesX + x])
+                ++x;
+
+            // Both lists are ordered by x: close the runs above that end before this one
+            while (o < open.size() && open[o].x0 < x0)
+                close(open[o++], y);
+            if (o < open.size() && open[o].x0 == x0 && open[o].x1 == x)
+                next.push_back(open[o++]);
+            else
+                next.push_back({x0, x, y});
+        }
+        while (o < open.size())
+            close(open[o++], y);
+        open.swap(next);
+    }
+    for (const Open& run : open)
+        close(run, tilesY);
+    return rects;
+}
+
+} // namespace EpiGimp
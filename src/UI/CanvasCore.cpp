@@ -3,9 +3,12 @@
 #include "../../include/Commands/DeleteSelectionCommand.hpp"
 #include "../../include/Commands/FlipSelectionCommands.hpp"
 #include "../../include/Core/HistoryManager.hpp"
+#include "../../include/Core/UploadScheduler.hpp"
 #include "rlgl.h"  // For low-level OpenGL blend functions
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <unordered_map>
 
 namespace EpiGimp {
 
@@ -26,17 +29,17 @@ Canvas::Canvas(Rectangle bounds, EventDispatcher* dispatcher, HistoryManager* hi
         throw std::invalid_argument("EventDispatcher cannot be null");
     
     // Subscribe to color events
-    dispatcher->subscribe<ColorChangedEvent>([this](const ColorChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<ColorChangedEvent>([this](const ColorChangedEvent& event) {
         onColorChanged(event);
-    });
+    }));
     
-    dispatcher->subscribe<PrimaryColorChangedEvent>([this](const PrimaryColorChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<PrimaryColorChangedEvent>([this](const PrimaryColorChangedEvent& event) {
         onPrimaryColorChanged(event);
-    });
+    }));
     
-    dispatcher->subscribe<SecondaryColorChangedEvent>([this](const SecondaryColorChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<SecondaryColorChangedEvent>([this](const SecondaryColorChangedEvent& event) {
         onSecondaryColorChanged(event);
-    });
+    }));
     
     if (autoCreateBlankCanvas)
         createBlankCanvas(800, 600, WHITE);
@@ -48,9 +51,17 @@ Canvas::Canvas(Rectangle bounds, EventDispatcher* dispatcher, HistoryManager* hi
 
 void Canvas::update(float deltaTime)
 {
+    updateImageLoading();
+    updateProjectStreaming();
+    if (imageSaver_)
+        imageSaver_->update();
     handleInput();
-    handleDrawing();
-    handleSelection();
+    if (!previewFilter_) {
+        handleDrawing();
+        handleSelection();
+    }
+    updateFilterPreview();
+    updateTextureUploads();   // After the tools, so this frame's strokes can still make it
     
     // Update selection animation
     selectionAnimTime_ += deltaTime * 2.0f; // Speed up animation
@@ -78,6 +89,9 @@ void Canvas::draw() const
     if (hasSelection_ || isSelecting_) {
         drawSelection();
     }
+    if (!freeformPoints_.empty()) {
+        drawFreeformPath();
+    }
     
     // Draw mirror mode indicator line
     if (mirrorModeEnabled_ && hasImage()) {
@@ -90,6 +104,8 @@ void Canvas::draw() const
     
     EndScissorMode();
     
+    drawFilterPreviewInfo();
+    
     // Draw eyedropper color preview (outside scissor mode so it can extend beyond canvas)
     if (currentTool_ == DrawingTool::Eyedropper && hasImage()) {
         const Vector2 mousePos = GetMousePosition();
@@ -125,6 +141,7 @@ void Canvas::draw() const
     
     // Draw zoom indicator outside scissor mode
     drawZoomIndicator();
+    drawToolOptions();
 }
 
 bool Canvas::hasImage() const
@@ -132,6 +149,13 @@ bool Canvas::hasImage() const
     return currentTexture_.has_value() && currentTexture_->isValid();
 }
 
+Vector2 Canvas::getImageSize() const
+{
+    if (!hasImage())
+        return Vector2{0, 0};
+    return Vector2{static_cast<float>((*currentTexture_)->width), static_cast<float>((*currentTexture_)->height)};
+}
+
 void Canvas::setZoom(float zoom)
 {
     zoomLevel_ = std::clamp(zoom, MIN_ZOOM, MAX_ZOOM);
@@ -183,6 +207,30 @@ Rectangle Canvas::calculateImageDestRect() const
     return Rectangle{imageX, imageY, imageWidth, imageHeight};
 }
 
+void Canvas::updateTextureUploads()
+{
+    // The part of the image inside the canvas, in texture pixels, gets its regions first
+    std::unordered_map<unsigned, Rectangle> visible;
+    const Rectangle dest = calculateImageDestRect();
+    if (currentTexture_ && dest.width > 0 && dest.height > 0) {
+        const float left = std::max(dest.x, bounds_.x);
+        const float top = std::max(dest.y, bounds_.y);
+        const float right = std::min(dest.x + dest.width, bounds_.x + bounds_.width);
+        const float bottom = std::min(dest.y + dest.height, bounds_.y + bounds_.height);
+        if (right > left && bottom > top) {
+            const float height = static_cast<float>((*currentTexture_)->height);
+            Rectangle view = {(left - dest.x) / zoomLevel_, (top - dest.y) / zoomLevel_,
+                              (right - left) / zoomLevel_, (bottom - top) / zoomLevel_};
+            view.y = height - view.y - view.height;   // Render textures are stored bottom-up
+            for (const auto& layer : drawingLayers_) {
+                if (layer.texture)
+                    visible[(**layer.texture).texture.id] = view;
+            }
+        }
+    }
+    UploadScheduler::shared().update(UploadScheduler::Budget{}, visible);
+}
+
 Vector2 Canvas::getImageCenter() const
 {
     return Vector2{bounds_.x + bounds_.width / 2, bounds_.y + bounds_.height / 2};
@@ -194,7 +242,7 @@ Image Canvas::copyDrawingImage() const
         return GenImageColor(1, 1, BLANK);
     
     const DrawingLayer& layer = drawingLayers_[selectedLayerIndex_];
-    Image image = LoadImageFromTexture((**layer.texture).texture);
+    Image image = layer.texture->readPixels();
     
     ImageFlipVertical(&image);
     
@@ -204,6 +252,7 @@ Image Canvas::copyDrawingImage() const
 void Canvas::resetToBackground()
 {
     drawingLayers_.clear();
+    layerSlots_.clear();
     selectedLayerIndex_ = -1;
     backgroundVisible_ = true;
 }
@@ -230,6 +279,112 @@ DrawingLayer* Canvas::getLayer(int index)
     return nullptr;
 }
 
+LayerHandle Canvas::getLayerHandle(int index) const
+{
+    const DrawingLayer* layer = getLayer(index);
+    return layer ? layer->handle : LayerHandle{};
+}
+
+int Canvas::getLayerIndex(LayerHandle handle) const
+{
+    const size_t* position = layerSlots_.get(handle);
+    return position ? static_cast<int>(*position) : -1;
+}
+
+const DrawingLayer* Canvas::getLayer(LayerHandle handle) const
+{
+    return getLayer(getLayerIndex(handle));
+}
+
+DrawingLayer* Canvas::getLayer(LayerHandle handle)
+{
+    return getLayer(getLayerIndex(handle));
+}
+
+Image Canvas::copyLayerImage(LayerHandle handle) const
+{
+    const DrawingLayer* layer = getLayer(handle);
+    if (!layer || !layer->texture)
+        return Image{};
+    
+    Image image = layer->texture->readPixels();
+    ImageFlipVertical(&image);
+    return image;
+}
+
+bool Canvas::restoreLayerImage(LayerHandle handle, const Image& image)
+{
+    DrawingLayer* layer = getLayer(handle);
+    if (!layer || !layer->texture || !image.data)
+        return false;
+    
+    // Replace the whole layer: clear first so transparent pixels in the image stay transparent
+    layer->texture->beginDrawing();
+    ClearBackground(Color{0, 0, 0, 0});
+    Texture2D texture = LoadTextureFromImage(image);
+    DrawTexture(texture, 0, 0, WHITE);
+    layer->texture->endDrawing();
+    UnloadTexture(texture);
+    return true;
+}
+
+bool Canvas::clearLayerRegion(LayerHandle handle, Rectangle region)
+{
+    DrawingLayer* layer = getLayer(handle);
+    if (!layer || !layer->texture || !layer->visible)
+        return false;
+    
+    layer->texture->beginDrawing();
+    BeginScissorMode((int)region.x, (int)region.y, (int)region.width, (int)region.height);
+    ClearBackground(Color{0, 0, 0, 0});
+    EndScissorMode();
+    layer->texture->endDrawing();
+    return true;
+}
+
+bool Canvas::writeLayerPixels(LayerHandle handle, Rectangle region, const void* pixels)
+{
+    DrawingLayer* layer = getLayer(handle);
+    if (!layer || !layer->texture || !pixels)
+        return false;
+    
+    // Queued uploads go first, or they would land on top of these pixels later
+    const Texture2D& texture = (**layer->texture).texture;
+    UploadScheduler::shared().flush(texture.id);
+    UpdateTextureRec(texture, region, pixels);
+    layer->texture->markModified();
+    return true;
+}
+
+bool Canvas::clearLayerMask(LayerHandle handle, const SelectionMask& mask)
+{
+    DrawingLayer* layer = getLayer(handle);
+    if (!layer || !layer->texture || !layer->visible)
+        return false;
+    
+    Image pixels = layer->texture->readPixels();
+    if (pixels.width != mask.getWidth() || pixels.height != mask.getHeight()) {
+        UnloadImage(pixels);
+        return false;
+    }
+    
+    // Texture rows run bottom-up; only the mask's bounds go back up
+    const Rectangle bounds = mask.getBounds();
+    mask.clearCovered(pixels, true);
+    UploadScheduler::shared().submit((**layer->texture).texture, makeSharedPixels(pixels),
+                                     SelectionMask::toBottomUp(bounds, mask.getHeight()));
+    layer->texture->markModified();
+    return true;
+}
+
+void Canvas::reindexLayersFrom(int index)
+{
+    for (size_t i = static_cast<size_t>(std::max(0, index)); i < drawingLayers_.size(); ++i) {
+        if (size_t* position = layerSlots_.get(drawingLayers_[i].handle))
+            *position = i;
+    }
+}
+
 int Canvas::addNewDrawingLayer(const std::string& name)
 {
     if (!hasImage()) {
@@ -242,6 +397,7 @@ int Canvas::addNewDrawingLayer(const std::string& name)
     int newIndex = static_cast<int>(drawingLayers_.size()) - 1;
     
     DrawingLayer& layer = drawingLayers_[newIndex];
+    layer.handle = layerSlots_.insert(static_cast<size_t>(newIndex));
     const int width = (*currentTexture_)->width;
     const int height = (*currentTexture_)->height;
     layer.texture = RenderTextureResource(width, height);
@@ -257,7 +413,9 @@ void Canvas::deleteLayer(int index)
 {
     if (index >= 0 && index < static_cast<int>(drawingLayers_.size())) {
         std::string layerName = drawingLayers_[index].name;
+        layerSlots_.erase(drawingLayers_[index].handle);
         drawingLayers_.erase(drawingLayers_.begin() + index);
+        reindexLayersFrom(index);
         
         // Adjust selected layer index
         if (selectedLayerIndex_ == index) {
@@ -290,6 +448,7 @@ void Canvas::moveLayer(int fromIndex, int toIndex)
         DrawingLayer layer = std::move(drawingLayers_[fromIndex]);
         drawingLayers_.erase(drawingLayers_.begin() + fromIndex);
         drawingLayers_.insert(drawingLayers_.begin() + toIndex, std::move(layer));
+        reindexLayersFrom(std::min(fromIndex, toIndex));
         
         // Adjust selected layer index
         if (selectedLayerIndex_ == fromIndex) {
@@ -371,6 +530,8 @@ void Canvas::clearSelection()
     isResizingSelection_ = false;
     resizeHandle_ = ResizeHandle::None;
     selectionRect_ = Rectangle{0, 0, 0, 0};
+    selectionMask_.clear();
+    selectionIsRectangle_ = false;
     std::cout << "Selection cleared" << std::endl;
 }
 
@@ -378,9 +539,8 @@ void Canvas::selectAll()
 {
     if (!hasImage()) return;
     
-    hasSelection_ = true;
     isSelecting_ = false;
-    selectionRect_ = Rectangle{0, 0, static_cast<float>((*currentTexture_)->width), static_cast<float>((*currentTexture_)->height)};
+    setRectangleSelection(Rectangle{0, 0, static_cast<float>((*currentTexture_)->width), static_cast<float>((*currentTexture_)->height)});
     std::cout << "Selected all (" << selectionRect_.width << "x" << selectionRect_.height << ")" << std::endl;
 }
 
@@ -457,19 +617,8 @@ void Canvas::deleteSelectionInternal()
         return;
     }
     
-    // Clear the selection area by drawing a transparent rectangle with proper clearing
-    layer.texture->beginDrawing();
-    
-    // Use scissor test to limit clearing to the selection area
-    BeginScissorMode((int)selectionRect_.x, (int)selectionRect_.y, 
-                     (int)selectionRect_.width, (int)selectionRect_.height);
-    
-    // Clear the background to transparent in the scissored area
-    ClearBackground(Color{0, 0, 0, 0});
-    
-    EndScissorMode();
-    
-    layer.texture->endDrawing();
+    // Clear the selected pixels to transparent
+    clearLayerMask(layer.handle, selectionMask_);
     
     std::cout << "Deleted selection area: (" << selectionRect_.x << "," << selectionRect_.y 
               << ") " << selectionRect_.width << "x" << selectionRect_.height 
@@ -542,4 +691,34 @@ void Canvas::drawZoomIndicator() const
     DrawTextEx(GetFontDefault(), zoomText, textPos, 12, 1, WHITE);
 }
 
+void Canvas::drawToolOptions() const
+{
+    if (!hasImage() || previewFilter_) return;
+
+    // Bottom-left, opposite the zoom indicator
+    char text[128];
+    const char* keys = nullptr;
+    if (currentTool_ == DrawingTool::Fill) {
+        snprintf(text, sizeof(text), "Fill   tolerance %d   antialias %s   sample merged %s",
+                 getFillTolerance(), isFillAntialiased() ? "on" : "off", isFillSampleMerged() ? "on" : "off");
+        keys = "[ ] tolerance (Shift x4)   A antialias   S sample merged";
+    } else if (currentTool_ == DrawingTool::MagicWand) {
+        snprintf(text, sizeof(text), "Magic Wand   tolerance %d   %s   sample merged %s",
+                 getWandTolerance(), isWandContiguous() ? "contiguous" : "all matching pixels",
+                 isWandSampleMerged() ? "on" : "off");
+        keys = "[ ] tolerance (Shift x4)   C contiguous   S sample merged";
+    } else {
+        return;
+    }
+
+    const Font font = GetFontDefault();
+    const float margin = 10.0f;
+    const float width = std::max(MeasureTextEx(font, text, 12, 1).x, MeasureTextEx(font, keys, 10, 1).x) + 16.0f;
+    const Rectangle row = {bounds_.x + margin, bounds_.y + bounds_.height - 40.0f - margin, width, 40.0f};
+    DrawRectangleRec(row, Color{0, 0, 0, 150});
+    DrawRectangleLinesEx(row, 1.0f, LIGHTGRAY);
+    DrawTextEx(font, text, Vector2{row.x + 8.0f, row.y + 6.0f}, 12, 1, WHITE);
+    DrawTextEx(font, keys, Vector2{row.x + 8.0f, row.y + 24.0f}, 10, 1, LIGHTGRAY);
+}
+
 } // namespace EpiGimp
\ No newline at end of file
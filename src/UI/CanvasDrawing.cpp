@@ -2,6 +2,9 @@
 #include "../../include/UI/Canvas.hpp"
 #include "../../include/Commands/DrawCommand.hpp"
 #include "../../include/Core/HistoryManager.hpp"
+#include "../../include/Core/UploadScheduler.hpp"
+#include "rlgl.h"  // Blend factors for exact region copies
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 
@@ -69,8 +72,6 @@ void Canvas::drawStroke(Vector2 from, Vector2 to)
     std::cout << "Drawing stroke from (" << imageFrom.x << "," << imageFrom.y 
               << ") to (" << imageTo.x << "," << imageTo.y << ") on layer: " << layer.name << std::endl;
     
-    layer.texture->beginDrawing();
-    
     // Calculate mirrored positions if mirror mode is enabled
     Vector2 mirroredFrom = imageFrom;
     Vector2 mirroredTo = imageTo;
@@ -85,6 +86,32 @@ void Canvas::drawStroke(Vector2 from, Vector2 to)
                   << ") to (" << mirroredTo.x << "," << mirroredTo.y << ")" << std::endl;
     }
     
+    // With a selection, a plain rectangle clips the GPU tools with a scissor. Anything else
+    // (and the tools that edit pixels on the CPU) keeps the pixels under the stroke, read back
+    // for its bounding box only, to put back what lands outside the selection.
+    const bool clipping = hasSelection_ && selectionMask_.getWidth() == (**layer.texture).texture.width &&
+                          selectionMask_.getHeight() == (**layer.texture).texture.height;
+    const bool editsOnCpu = currentTool_ == DrawingTool::Blur || currentTool_ == DrawingTool::Burn ||
+                            currentTool_ == DrawingTool::Dodge;
+    const bool scissor = clipping && selectionIsRectangle_ && !editsOnCpu;
+    Rectangle strokeRegion = {};
+    Image beforeStroke = {};
+    if (clipping && !scissor) {
+        const float reach = 32.0f;   // Widest brush footprint, airbrush included
+        strokeRegion = layerPixelRect(layer, std::min({imageFrom.x, imageTo.x, mirroredFrom.x, mirroredTo.x}) - reach,
+                                      std::min({imageFrom.y, imageTo.y, mirroredFrom.y, mirroredTo.y}) - reach,
+                                      std::max({imageFrom.x, imageTo.x, mirroredFrom.x, mirroredTo.x}) + reach,
+                                      std::max({imageFrom.y, imageTo.y, mirroredFrom.y, mirroredTo.y}) + reach);
+        beforeStroke = readLayerRegion(layer, strokeRegion);
+    }
+    
+    layer.texture->beginDrawing();
+    if (scissor) {
+        const Rectangle bounds = selectionMask_.getBounds();
+        BeginScissorMode(static_cast<int>(bounds.x), static_cast<int>(bounds.y),
+                         static_cast<int>(bounds.width), static_cast<int>(bounds.height));
+    }
+    
     // Lambda function to draw a stroke (used for both original and mirrored)
     auto drawSingleStroke = [&](const Vector2& from, const Vector2& to) {
         switch (currentTool_) {
@@ -213,6 +240,8 @@ void Canvas::drawStroke(Vector2 from, Vector2 to)
         drawSingleStroke(mirroredFrom, mirroredTo);
     }
     
+    if (scissor)
+        EndScissorMode();
     layer.texture->endDrawing();
     
     // Apply blur effect if using blur tool
@@ -230,6 +259,9 @@ void Canvas::drawStroke(Vector2 from, Vector2 to)
         applyDodgeToLayer(layer, imageFrom, imageTo);
     }
     
+    if (beforeStroke.data)
+        clipStrokeToSelection(layer, beforeStroke, strokeRegion);
+    
     std::cout << "Stroke drawn successfully with tool: " << static_cast<int>(currentTool_) << std::endl;
 }
 
@@ -237,8 +269,8 @@ void Canvas::handleDrawing()
 {
     if (!hasImage()) return;
     
-    // Skip drawing logic for selection tool and eyedropper tool
-    if (currentTool_ == DrawingTool::Select || currentTool_ == DrawingTool::Eyedropper) return;
+    // Skip drawing logic for selection, eyedropper and fill tools
+    if (isSelectionTool() || currentTool_ == DrawingTool::Eyedropper || currentTool_ == DrawingTool::Fill) return;
     
     // Mirror tool automatically enables mirror mode
     if (currentTool_ == DrawingTool::Mirror) {
@@ -374,7 +406,7 @@ void Canvas::applyBlurToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
     const int blurKernelSize = 2;
     
     // Load the layer texture as an image
-    Image layerImage = LoadImageFromTexture((**layer.texture).texture);
+    Image layerImage = layer.texture->readPixels();
     Image originalImage = ImageCopy(layerImage);
     
     std::cout << "Blur from (" << from.x << "," << from.y << ") to (" << to.x << "," << to.y << ")" << std::endl;
@@ -445,11 +477,8 @@ void Canvas::applyBlurToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
         }
     }
     
-    // Update the layer texture
-    UpdateTexture((**layer.texture).texture, layerImage.data);
-    
+    submitStrokeRegion(layer, layerImage, flippedFrom, flippedTo, static_cast<int>(blurRadius));
     UnloadImage(originalImage);
-    UnloadImage(layerImage);
 }
 
 void Canvas::applyBurnToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
@@ -458,7 +487,7 @@ void Canvas::applyBurnToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
     const float burnAmount = 15.0f; // How much to darken per pass (0-255 scale)
     
     // Load the layer texture as an image
-    Image layerImage = LoadImageFromTexture((**layer.texture).texture);
+    Image layerImage = layer.texture->readPixels();
     
     std::cout << "Burn from (" << from.x << "," << from.y << ") to (" << to.x << "," << to.y << ")" << std::endl;
     
@@ -517,10 +546,7 @@ void Canvas::applyBurnToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
         }
     }
     
-    // Update the layer texture
-    UpdateTexture((**layer.texture).texture, layerImage.data);
-    
-    UnloadImage(layerImage);
+    submitStrokeRegion(layer, layerImage, flippedFrom, flippedTo, static_cast<int>(burnRadius));
 }
 
 void Canvas::applyDodgeToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
@@ -529,7 +555,7 @@ void Canvas::applyDodgeToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
     const float dodgeAmount = 15.0f; // How much to lighten per pass (0-255 scale)
     
     // Load the layer texture as an image
-    Image layerImage = LoadImageFromTexture((**layer.texture).texture);
+    Image layerImage = layer.texture->readPixels();
     
     std::cout << "Dodge from (" << from.x << "," << from.y << ") to (" << to.x << "," << to.y << ")" << std::endl;
     
@@ -588,10 +614,133 @@ void Canvas::applyDodgeToLayer(DrawingLayer& layer, Vector2 from, Vector2 to)
         }
     }
     
-    // Update the layer texture
-    UpdateTexture((**layer.texture).texture, layerImage.data);
+    submitStrokeRegion(layer, layerImage, flippedFrom, flippedTo, static_cast<int>(dodgeRadius));
+}
+
+bool Canvas::fillAt(Vector2 imagePos, Color color)
+{
+    if (!hasDrawingTexture()) return false;
+    
+    DrawingLayer& layer = drawingLayers_[selectedLayerIndex_];
+    if (!layer.visible) return false;
+    
+    Image layerImage = layer.texture->readPixels();
+    if (layerImage.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&layerImage, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    
+    // Same orientation rules as strokes: undo the canvas flips, then texture rows run bottom-up
+    int x = static_cast<int>(std::floor(imagePos.x));
+    int y = static_cast<int>(std::floor(imagePos.y));
+    if (canvasFlippedHorizontal_) x = layerImage.width - 1 - x;
+    if (!canvasFlippedVertical_) y = layerImage.height - 1 - y;
+    
+    // Sample merged: match colors on what is visible, still paint the selected layer
+    Image merged = {};
+    if (fillSampleMerged_) {
+        merged = captureSnapshot().composite();
+        if (merged.data && merged.width == layerImage.width && merged.height == layerImage.height) {
+            ImageFlipVertical(&merged);
+        } else if (merged.data) {
+            UnloadImage(merged);
+            merged = {};
+        }
+    }
+    
+    Rectangle bounds = {};
+    std::vector<uint8_t> mask = FloodFill::regionMask(merged.data ? merged : layerImage, x, y, fillOptions_, &bounds);
+    if (merged.data)
+        UnloadImage(merged);
+    if (mask.empty()) {
+        UnloadImage(layerImage);
+        return false;
+    }
     
-    UnloadImage(layerImage);
+    // Only the selected part of the region is painted
+    if (hasSelection_)
+        selectionMask_.clipCoverage(mask.data(), layerImage.width,
+                                    SelectionMask::toBottomUp(bounds, layerImage.height), true);
+    FloodFill::fillMask(layerImage, mask, color, bounds);
+    UploadScheduler::shared().submit((**layer.texture).texture, makeSharedPixels(layerImage), bounds);
+    layer.texture->markModified();
+    
+    std::cout << "Bucket fill at (" << x << "," << y << "): " << bounds.width << "x" << bounds.height
+              << " area, tolerance " << fillOptions_.tolerance << std::endl;
+    return true;
+}
+
+void Canvas::clipStrokeToSelection(DrawingLayer& layer, Image beforeStroke, Rectangle region)
+{
+    Image afterStroke = readLayerRegion(layer, region);
+    if (!afterStroke.data || afterStroke.width != beforeStroke.width || afterStroke.height != beforeStroke.height) {
+        UnloadImage(beforeStroke);
+        UnloadImage(afterStroke);
+        return;
+    }
+    
+    // Empty tiles copy back whole rows, full tiles are left alone
+    selectionMask_.restoreOutsideRegion(afterStroke, beforeStroke, region, true);
+    UnloadImage(beforeStroke);
+    const Texture2D& texture = (**layer.texture).texture;
+    UpdateTextureRec(texture, SelectionMask::toBottomUp(region, texture.height), afterStroke.data);
+    UnloadImage(afterStroke);
+    layer.texture->markModified();
+}
+
+Rectangle Canvas::layerPixelRect(const DrawingLayer& layer, float left, float top, float right, float bottom) const
+{
+    const Texture2D& texture = (**layer.texture).texture;
+    const int x0 = std::clamp(static_cast<int>(std::floor(left)), 0, texture.width);
+    const int y0 = std::clamp(static_cast<int>(std::floor(top)), 0, texture.height);
+    const int x1 = std::clamp(static_cast<int>(std::ceil(right)), x0, texture.width);
+    const int y1 = std::clamp(static_cast<int>(std::ceil(bottom)), y0, texture.height);
+    return Rectangle{static_cast<float>(x0), static_cast<float>(y0), static_cast<float>(x1 - x0), static_cast<float>(y1 - y0)};
+}
+
+Image Canvas::readLayerRegion(const DrawingLayer& layer, Rectangle region)
+{
+    const int width = static_cast<int>(region.width);
+    const int height = static_cast<int>(region.height);
+    if (width <= 0 || height <= 0)
+        return Image{};
+    
+    // Copy the region into a small render texture and read that back, not the whole layer
+    if (!strokeScratch_ || (**strokeScratch_).texture.width < width || (**strokeScratch_).texture.height < height) {
+        const int scratchWidth = std::max(width, strokeScratch_ ? (**strokeScratch_).texture.width : 0);
+        const int scratchHeight = std::max(height, strokeScratch_ ? (**strokeScratch_).texture.height : 0);
+        strokeScratch_.emplace(scratchWidth, scratchHeight);
+    }
+    
+    // Render textures are stored upside down: the region's rows start at height - bottom,
+    // and a negative source height draws them the right way up at the scratch's top-left
+    const Texture2D& source = (**layer.texture).texture;
+    const Rectangle rows = SelectionMask::toBottomUp(region, source.height);
+    UploadScheduler::shared().flush(source.id);
+    strokeScratch_->beginDrawing();
+    rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);   // Copy, alpha included
+    BeginBlendMode(BLEND_CUSTOM);
+    DrawTextureRec(source, Rectangle{rows.x, rows.y, rows.width, -rows.height}, Vector2{0, 0}, WHITE);
+    EndBlendMode();
+    strokeScratch_->endDrawing();
+    
+    // The scratch reads back bottom-up too, so its top-left region is its last rows
+    Image scratch = strokeScratch_->readPixels();
+    if (scratch.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&scratch, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    ImageCrop(&scratch, Rectangle{0, static_cast<float>(scratch.height - height), static_cast<float>(width), static_cast<float>(height)});
+    return scratch;
+}
+
+void Canvas::submitStrokeRegion(DrawingLayer& layer, Image layerImage, Vector2 from, Vector2 to, int reach)
+{
+    // Only the stroke's bounding box goes up, and within the frame budget
+    const Rectangle region = {
+        std::min(from.x, to.x) - reach - 1,
+        std::min(from.y, to.y) - reach - 1,
+        std::fabs(to.x - from.x) + 2.0f * reach + 3,
+        std::fabs(to.y - from.y) + 2.0f * reach + 3
+    };
+    UploadScheduler::shared().submit((**layer.texture).texture, makeSharedPixels(layerImage), region);
+    layer.texture->markModified();
 }
 
 } // namespace EpiGimp
\ No newline at end of file
@@ -0,0 +1,523 @@
+//Canvas filter application and live preview
+#include "../../include/UI/Canvas.hpp"
+#include "../../include/Commands/FilterCommand.hpp"
+#include "../../include/Core/HistoryManager.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include "../../include/Core/UploadScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace EpiGimp {
+
+namespace {
+
+// Filter panel layout, in screen pixels
+constexpr float PANEL_WIDTH = 330.0f;
+constexpr float PANEL_HEADER = 22.0f;
+constexpr float PANEL_HISTOGRAM = 64.0f;     // Tone filters only
+constexpr float PANEL_ROW = 20.0f;
+constexpr float PANEL_FOOTER = 20.0f;
+constexpr float PANEL_LABEL = 72.0f;         // Label column, then the slider
+constexpr float PANEL_SLIDER = 180.0f;
+
+constexpr int REFINE_ROWS = 256;             // Rows per step of a background refinement, between checks for a change
+
+// Row 0 of the panel is the amount, the rest are the settings
+FilterSetting panelRow(const LayerFilter& filter, size_t row)
+{
+    if (row == 0)
+        return FilterSetting{filter.amountName, filter.amount, filter.minimum, filter.maximum, filter.step};
+    return filter.settings[row - 1];
+}
+
+// Box-filtered copy at 1 / 2^level of the size, so the preview sees the pixels it stands for
+Image downscaleImage(const Image& source, int level)
+{
+    const int factor = 1 << level;
+    const int width = std::max(1, source.width / factor);
+    const int height = std::max(1, source.height / factor);
+    Image result = GenImageColor(width, height, BLANK);
+    if (level == 0) {
+        std::memcpy(result.data, source.data, static_cast<size_t>(width) * height * 4);
+        return result;
+    }
+
+    const auto* in = static_cast<const uint8_t*>(source.data);
+    auto* out = static_cast<uint8_t*>(result.data);
+    const int count = factor * factor;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int sums[4] = {0, 0, 0, 0};
+            for (int sy = 0; sy < factor; ++sy) {
+                const uint8_t* row = in + (static_cast<size_t>(y * factor + sy) * source.width + x * factor) * 4;
+                for (int i = 0; i < factor * 4; ++i)
+                    sums[i & 3] += row[i];
+            }
+            for (int ch = 0; ch < 4; ++ch)
+                out[(static_cast<size_t>(y) * width + x) * 4 + ch] = static_cast<uint8_t>((sums[ch] + count / 2) / count);
+        }
+    }
+    return result;
+}
+
+// Copy of region (whole pixels inside the image)
+Image cropImage(const Image& source, Rectangle region)
+{
+    const int x0 = static_cast<int>(region.x);
+    const int y0 = static_cast<int>(region.y);
+    const int width = static_cast<int>(region.width);
+    const int height = static_cast<int>(region.height);
+    Image result = GenImageColor(width, height, BLANK);
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(static_cast<uint8_t*>(result.data) + static_cast<size_t>(y) * width * 4,
+                    static_cast<const uint8_t*>(source.data) + (static_cast<size_t>(y0 + y) * source.width + x0) * 4,
+                    static_cast<size_t>(width) * 4);
+    }
+    return result;
+}
+
+// region grown by margin on every side, clipped to width x height, on whole pixels
+Rectangle expandRegion(Rectangle region, float margin, int width, int height)
+{
+    const float x0 = std::max(0.0f, std::floor(region.x - margin));
+    const float y0 = std::max(0.0f, std::floor(region.y - margin));
+    const float x1 = std::min(static_cast<float>(width), std::ceil(region.x + region.width + margin));
+    const float y1 = std::min(static_cast<float>(height), std::ceil(region.y + region.height + margin));
+    return Rectangle{x0, y0, std::max(0.0f, x1 - x0), std::max(0.0f, y1 - y0)};
+}
+
+} // namespace
+
+bool Canvas::applyFilter(const LayerFilter& filter)
+{
+    if (!hasDrawingTexture() || !filter.isValid()) return false;
+
+    DrawingLayer& layer = drawingLayers_[selectedLayerIndex_];
+    if (!layer.visible) return false;
+
+    Image layerImage = layer.texture->readPixels();
+    if (layerImage.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&layerImage, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    const bool clipped = hasSelection_ && selectionMask_.getWidth() == layerImage.width &&
+                         selectionMask_.getHeight() == layerImage.height;
+    Rectangle region = {0, 0, static_cast<float>(layerImage.width), static_cast<float>(layerImage.height)};
+    if (clipped) {
+        // Filter a margin around the selection too, so its edge pixels still see their neighbours
+        const Rectangle bounds = SelectionMask::toBottomUp(selectionRect_, layerImage.height);
+        const float reach = filter.reach ? static_cast<float>(filter.reach(filter.amount)) : 0.0f;
+        region = expandRegion(bounds, reach, layerImage.width, layerImage.height);
+    }
+
+    Image original = ImageCopy(layerImage);
+    Filters::run(filter, layerImage, region, filter.amount);
+
+    if (clipped) {
+        selectionMask_.restoreOutside(layerImage, original, selectionRect_, true);
+        region = SelectionMask::toBottomUp(selectionRect_, layerImage.height);
+    }
+    
+    // Only the tiles the filter changed go into the history
+    std::unique_ptr<FilterCommand> command;
+    if (historyManager_) {
+        command = std::make_unique<FilterCommand>(this, layer.handle, filter.name);
+        command->recordChanges(original, layerImage, region);
+    }
+    UnloadImage(original);
+    UploadScheduler::shared().submit((**layer.texture).texture, makeSharedPixels(layerImage), region);
+    layer.texture->markModified();
+    if (command)
+        historyManager_->executeCommand(std::move(command));
+
+    std::cout << "Applied " << filter.name << " (" << filter.amount << ") to layer: " << layer.name << std::endl;
+    return true;
+}
+
+void Canvas::beginFilterPreview(LayerFilter filter)
+{
+    cancelFilterPreview();
+    if (!hasDrawingTexture() || !filter.isValid()) return;
+
+    filter.amount = std::clamp(filter.amount, filter.minimum, filter.maximum);
+    previewFilter_ = std::move(filter);
+    previewLayer_ = getSelectedLayerHandle();
+    previewLevel_ = -1;   // Source is read on the first update
+    previewRow_ = 0;
+    previewDirty_ = true;
+    std::cout << "Previewing " << previewFilter_->name << ": [ and ] adjust, Tab next value, Enter applies, Escape cancels" << std::endl;
+}
+
+void Canvas::setFilterPreviewAmount(float amount)
+{
+    if (!previewFilter_) return;
+
+    amount = std::clamp(amount, previewFilter_->minimum, previewFilter_->maximum);
+    if (amount != previewFilter_->amount) {
+        previewFilter_->amount = amount;
+        invalidateFilterPreview();
+    }
+}
+
+void Canvas::setFilterPreviewSetting(size_t index, float value)
+{
+    if (!previewFilter_ || index >= previewFilter_->settings.size()) return;
+
+    FilterSetting& setting = previewFilter_->settings[index];
+    value = std::clamp(value, setting.minimum, setting.maximum);
+    if (value != setting.value) {
+        setting.value = value;
+        invalidateFilterPreview();
+    }
+}
+
+void Canvas::setFilterPreviewRow(size_t row, float value)
+{
+    if (row == 0)
+        setFilterPreviewAmount(value);
+    else
+        setFilterPreviewSetting(row - 1, value);
+}
+
+void Canvas::invalidateFilterPreview()
+{
+    previewDirty_ = true;
+    previewRefined_ = false;
+    if (previewRefinement_) {
+        previewRefinement_->cancelled = true;
+        previewRefinement_.reset();
+    }
+}
+
+void Canvas::commitFilterPreview()
+{
+    if (!previewFilter_) return;
+
+    const LayerFilter filter = *previewFilter_;
+    cancelFilterPreview();
+    if (!(getSelectedLayerHandle() == previewLayer_)) return;
+
+    applyFilter(filter);
+}
+
+void Canvas::cancelFilterPreview()
+{
+    invalidateFilterPreview();
+    previewFilter_.reset();
+    previewSource_ = ImageResource();
+    previewTexture_.reset();
+    previewArea_ = {};
+    previewDirty_ = false;
+    previewDragging_ = false;
+    previewFullSource_.reset();
+    previewFullTexture_.reset();
+}
+
+void Canvas::handleFilterPreview()
+{
+    if (!previewFilter_) return;
+
+    // Shift takes bigger steps, so a large blur is a few presses away
+    const bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    const size_t rows = filterPanelRowCount();
+    if (IsKeyPressed(KEY_TAB))
+        previewRow_ = (previewRow_ + (shift ? rows - 1 : 1)) % rows;
+    const FilterSetting row = panelRow(*previewFilter_, previewRow_);
+    const float step = row.step * (shift ? 10.0f : 1.0f);
+    if (IsKeyPressed(KEY_RIGHT_BRACKET))
+        setFilterPreviewRow(previewRow_, row.value + step);
+    if (IsKeyPressed(KEY_LEFT_BRACKET))
+        setFilterPreviewRow(previewRow_, row.value - step);
+
+    // Sliders follow the mouse from a press on them until the button goes up
+    const Vector2 mouse = GetMousePosition();
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        for (size_t i = 0; i < rows; ++i) {
+            const Rectangle slider = filterPanelSlider(i);
+            if (CheckCollisionPointRec(mouse, Rectangle{slider.x - 4.0f, slider.y - 6.0f, slider.width + 8.0f, slider.height + 12.0f})) {
+                previewRow_ = i;
+                previewDragging_ = true;
+            }
+        }
+    }
+    if (previewDragging_ && !IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+        previewDragging_ = false;
+    if (previewDragging_) {
+        const FilterSetting dragged = panelRow(*previewFilter_, previewRow_);
+        const Rectangle slider = filterPanelSlider(previewRow_);
+        const float t = std::clamp((mouse.x - slider.x) / slider.width, 0.0f, 1.0f);
+        float value = dragged.minimum + t * (dragged.maximum - dragged.minimum);
+        if (dragged.step > 0.0f)
+            value = dragged.minimum + std::round((value - dragged.minimum) / dragged.step) * dragged.step;
+        setFilterPreviewRow(previewRow_, value);
+    }
+
+    if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_KP_ENTER))
+        commitFilterPreview();
+    else if (IsKeyPressed(KEY_ESCAPE))
+        cancelFilterPreview();
+}
+
+int Canvas::previewLevelForZoom() const
+{
+    // At 25% a quarter-size layer already has a pixel for every screen pixel
+    int level = 0;
+    while (level < 8 && zoomLevel_ * static_cast<float>(1 << (level + 1)) <= 1.0f)
+        ++level;
+    return level;
+}
+
+void Canvas::updateFilterPreview()
+{
+    if (!previewFilter_) return;
+
+    const DrawingLayer* layer = getLayer(previewLayer_);
+    if (!layer || !layer->texture || !(getSelectedLayerHandle() == previewLayer_)) {
+        cancelFilterPreview();   // The layer went away or another one was picked
+        return;
+    }
+
+    // A finished whole-layer result replaces the visible part, whatever the view does next
+    const bool tone = static_cast<bool>(previewFilter_->table);
+    if (previewRefinement_ && previewRefinement_->finished) {
+        const Image& result = previewRefinement_->result;
+        if (previewFullTexture_ && (**previewFullTexture_).width == result.width && (**previewFullTexture_).height == result.height)
+            UpdateTexture(**previewFullTexture_, result.data);
+        else
+            previewFullTexture_ = TextureResource::fromImage(result);
+        previewRefinement_.reset();
+        previewRefined_ = static_cast<bool>(previewFullTexture_);
+        previewTexture_.reset();
+    }
+    if (previewRefined_) return;
+
+    const int level = previewLevelForZoom();
+    if (level != previewLevel_) {
+        // Tone filters keep the full-size pixels for their background refinement
+        SharedPixels full = previewFullSource_;
+        if (!full) {
+            Image layerImage = layer->texture->readPixels();
+            if (layerImage.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+                ImageFormat(&layerImage, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            full = makeSharedPixels(layerImage);
+            if (tone)
+                previewFullSource_ = full;
+        }
+        previewSource_ = ImageResource(downscaleImage(*full, level));
+        if (tone)
+            previewHistogram_ = ToneLut::histogram(*previewSource_);
+        previewLevel_ = level;
+        previewDirty_ = true;
+    }
+
+    // The visible part went out last frame and the values have not moved since: do the rest
+    if (tone && !previewDirty_ && !previewRefinement_)
+        startFilterRefinement();
+    if (zoomLevel_ != previewZoom_ || panOffset_.x != previewPan_.x || panOffset_.y != previewPan_.y)
+        previewDirty_ = true;
+    if (!previewDirty_ || !previewSource_) return;
+
+    previewDirty_ = false;
+    previewZoom_ = zoomLevel_;
+    previewPan_ = panOffset_;
+
+    // Visible part of the image, in previewSource_ texture pixels
+    const Image& source = *previewSource_;
+    const Texture2D& layerTex = (**layer->texture).texture;
+    const float scaleX = static_cast<float>(layerTex.width) / static_cast<float>(source.width);
+    const float scaleY = static_cast<float>(layerTex.height) / static_cast<float>(source.height);
+    const Rectangle dest = calculateImageDestRect();
+    const float left = (std::max(dest.x, bounds_.x) - dest.x) / zoomLevel_;
+    const float top = (std::max(dest.y, bounds_.y) - dest.y) / zoomLevel_;
+    const float right = (std::min(dest.x + dest.width, bounds_.x + bounds_.width) - dest.x) / zoomLevel_;
+    const float bottom = (std::min(dest.y + dest.height, bounds_.y + bounds_.height) - dest.y) / zoomLevel_;
+    if (right <= left || bottom <= top) {
+        previewTexture_.reset();
+        return;
+    }
+    const bool mirrored = layer->flippedHorizontal != canvasFlippedHorizontal_;
+    const bool rowsReversed = layer->flippedVertical == canvasFlippedVertical_;
+    const float textureLeft = mirrored ? static_cast<float>(layerTex.width) - right : left;
+    const float textureTop = rowsReversed ? static_cast<float>(layerTex.height) - bottom : top;
+    const Rectangle area = expandRegion(Rectangle{textureLeft / scaleX, textureTop / scaleY,
+                                                  (right - left) / scaleX, (bottom - top) / scaleY},
+                                        0.0f, source.width, source.height);
+    if (area.width <= 0 || area.height <= 0) {
+        previewTexture_.reset();
+        return;
+    }
+
+    // Filter the visible part plus the margin the filter reads, at preview scale
+    const float amount = previewFilter_->amountIsDistance ? previewFilter_->amount / static_cast<float>(1 << previewLevel_)
+                                                          : previewFilter_->amount;
+    const float reach = previewFilter_->reach ? static_cast<float>(previewFilter_->reach(amount)) : 0.0f;
+    const Rectangle work = expandRegion(area, reach, source.width, source.height);
+    Image filtered = cropImage(source, work);
+    Filters::run(*previewFilter_, filtered, Rectangle{0, 0, work.width, work.height}, amount);
+
+    Image visible = cropImage(filtered, Rectangle{area.x - work.x, area.y - work.y, area.width, area.height});
+    UnloadImage(filtered);
+
+    // Unselected pixels keep their original colour, partly selected ones a mix
+    if (hasSelection_ && selectionMask_.getWidth() == layerTex.width && selectionMask_.getHeight() == layerTex.height) {
+        const auto* original = static_cast<const uint8_t*>(source.data);
+        auto* pixels = static_cast<uint8_t*>(visible.data);
+        for (int y = 0; y < visible.height; ++y) {
+            const int sourceY = static_cast<int>(area.y) + y;
+            const int maskY = layerTex.height - 1 - static_cast<int>(static_cast<float>(sourceY) * scaleY);
+            for (int x = 0; x < visible.width; ++x) {
+                const int sourceX = static_cast<int>(area.x) + x;
+                const int coverage = selectionMask_.at(static_cast<int>(static_cast<float>(sourceX) * scaleX), maskY);
+                if (coverage == 255) continue;
+                uint8_t* pixel = pixels + (static_cast<size_t>(y) * visible.width + x) * 4;
+                const uint8_t* before = original + (static_cast<size_t>(sourceY) * source.width + sourceX) * 4;
+                for (int ch = 0; ch < 4; ++ch)
+                    pixel[ch] = static_cast<uint8_t>(before[ch] + (pixel[ch] - before[ch]) * coverage / 255);
+            }
+        }
+    }
+
+    previewTexture_ = TextureResource::fromImage(visible);
+    previewArea_ = area;
+    UnloadImage(visible);
+}
+
+void Canvas::startFilterRefinement()
+{
+    if (!previewFilter_ || !previewFilter_->table || !previewFullSource_) return;
+
+    const SharedPixels source = previewFullSource_;
+    const ToneLut::Table table = previewFilter_->table(previewFilter_->amount, previewFilter_->settings);
+    const Rectangle selection = selectionRect_;
+    std::optional<SelectionMask> mask;   // The job keeps its own copy
+    if (hasSelection_ && selectionMask_.getWidth() == source->width && selectionMask_.getHeight() == source->height)
+        mask = selectionMask_;
+
+    auto refinement = std::make_shared<PreviewRefinement>();
+    previewRefinement_ = refinement;
+    JobSystem::shared().submit([refinement, source, table, mask, selection]() {
+        const Rectangle region = mask ? SelectionMask::toBottomUp(selection, source->height)
+                                      : Rectangle{0, 0, static_cast<float>(source->width), static_cast<float>(source->height)};
+        Image result = mask ? ImageCopy(*source) : GenImageColor(source->width, source->height, BLANK);
+
+        // A band at a time, so new values stop stale work early
+        const int top = std::max(0, static_cast<int>(std::floor(region.y)));
+        const int bottom = std::min(source->height, static_cast<int>(std::ceil(region.y + region.height)));
+        for (int y = top; y < bottom; y += REFINE_ROWS) {
+            if (refinement->cancelled) {
+                UnloadImage(result);
+                return;
+            }
+            ToneLut::map(*source, result, table, Rectangle{region.x, static_cast<float>(y), region.width,
+                                                           static_cast<float>(std::min(REFINE_ROWS, bottom - y))});
+        }
+        if (mask)
+            mask->restoreOutside(result, *source, selection, true);
+
+        refinement->result = result;
+        refinement->finished = true;
+    });
+}
+
+void Canvas::drawFilterPreview(Rectangle imageDestRect, bool mirrored, bool rowsReversed) const
+{
+    if (previewRefined_ && previewFullTexture_) {
+        // The whole layer, drawn the way the layer itself is
+        const Texture2D& texture = **previewFullTexture_;
+        const Rectangle sourceRect = {0, 0, mirrored ? -static_cast<float>(texture.width) : static_cast<float>(texture.width),
+                                      rowsReversed ? -static_cast<float>(texture.height) : static_cast<float>(texture.height)};
+        DrawTexturePro(texture, sourceRect, imageDestRect, Vector2{0, 0}, 0.0f, WHITE);
+        return;
+    }
+    if (!previewTexture_ || !previewSource_) return;
+
+    // previewArea_ back to image pixels, then to the screen, mirrored the way the layer is drawn
+    const Texture2D& texture = **previewTexture_;
+    const float layerWidth = static_cast<float>((*currentTexture_)->width);
+    const float layerHeight = static_cast<float>((*currentTexture_)->height);
+    const float scaleX = layerWidth / static_cast<float>(previewSource_->width);
+    const float scaleY = layerHeight / static_cast<float>(previewSource_->height);
+    const float width = previewArea_.width * scaleX;
+    const float height = previewArea_.height * scaleY;
+    const float imageX = mirrored ? layerWidth - previewArea_.x * scaleX - width : previewArea_.x * scaleX;
+    const float imageY = rowsReversed ? layerHeight - previewArea_.y * scaleY - height : previewArea_.y * scaleY;
+    const float zoomX = imageDestRect.width / layerWidth;
+    const float zoomY = imageDestRect.height / layerHeight;
+
+    const Rectangle sourceRect = {0, 0, mirrored ? -static_cast<float>(texture.width) : static_cast<float>(texture.width),
+                                  rowsReversed ? -static_cast<float>(texture.height) : static_cast<float>(texture.height)};
+    const Rectangle destRect = {imageDestRect.x + imageX * zoomX, imageDestRect.y + imageY * zoomY, width * zoomX, height * zoomY};
+    DrawTexturePro(texture, sourceRect, destRect, Vector2{0, 0}, 0.0f, WHITE);
+}
+
+size_t Canvas::filterPanelRowCount() const
+{
+    return previewFilter_ ? 1 + previewFilter_->settings.size() : 0;
+}
+
+Rectangle Canvas::filterPanelBounds() const
+{
+    const float histogram = previewFilter_ && previewFilter_->table ? PANEL_HISTOGRAM + 6.0f : 0.0f;
+    return Rectangle{bounds_.x + 10.0f, bounds_.y + 10.0f, PANEL_WIDTH,
+                     PANEL_HEADER + histogram + PANEL_ROW * static_cast<float>(filterPanelRowCount()) + PANEL_FOOTER};
+}
+
+Rectangle Canvas::filterPanelSlider(size_t row) const
+{
+    const Rectangle panel = filterPanelBounds();
+    const float histogram = previewFilter_ && previewFilter_->table ? PANEL_HISTOGRAM + 6.0f : 0.0f;
+    return Rectangle{panel.x + 8.0f + PANEL_LABEL, panel.y + PANEL_HEADER + histogram + PANEL_ROW * static_cast<float>(row) + 6.0f,
+                     PANEL_SLIDER, 8.0f};
+}
+
+void Canvas::drawFilterPreviewInfo() const
+{
+    if (!previewFilter_) return;
+
+    const LayerFilter& filter = *previewFilter_;
+    const Rectangle panel = filterPanelBounds();
+    const Font font = GetFontDefault();
+    DrawRectangleRec(panel, Color{0, 0, 0, 170});
+    DrawRectangleLinesEx(panel, 1.0f, LIGHTGRAY);
+    DrawTextEx(font, filter.name.c_str(), Vector2{panel.x + 8.0f, panel.y + 6.0f}, 12, 1, WHITE);
+    if (previewRefinement_)
+        DrawTextEx(font, "refining...", Vector2{panel.x + PANEL_WIDTH - 72.0f, panel.y + 6.0f}, 12, 1, GRAY);
+
+    if (filter.table) {
+        // Luminance histogram, with the table's curve over it
+        const Rectangle chart = {panel.x + (PANEL_WIDTH - 256.0f) / 2.0f, panel.y + PANEL_HEADER, 256.0f, PANEL_HISTOGRAM};
+        DrawRectangleRec(chart, Color{30, 30, 30, 255});
+        const uint32_t tallest = std::max(1u, *std::max_element(previewHistogram_.begin(), previewHistogram_.end()));
+        for (int v = 0; v < 256; ++v) {
+            const float height = chart.height * static_cast<float>(previewHistogram_[v]) / static_cast<float>(tallest);
+            DrawLineV(Vector2{chart.x + v + 0.5f, chart.y + chart.height}, Vector2{chart.x + v + 0.5f, chart.y + chart.height - height}, GRAY);
+        }
+        const ToneLut::Table table = filter.table(filter.amount, filter.settings);
+        for (int v = 1; v < 256; ++v) {
+            const auto curveY = [&](int x) { return chart.y + chart.height * (1.0f - table.channels[0][x] / 255.0f); };
+            DrawLineV(Vector2{chart.x + v - 0.5f, curveY(v - 1)}, Vector2{chart.x + v + 0.5f, curveY(v)}, SKYBLUE);
+        }
+    }
+
+    char text[64];
+    for (size_t i = 0; i < filterPanelRowCount(); ++i) {
+        const FilterSetting row = panelRow(filter, i);
+        const Rectangle slider = filterPanelSlider(i);
+        const Color labelColor = i == previewRow_ ? YELLOW : WHITE;
+        DrawTextEx(font, row.name.c_str(), Vector2{panel.x + 8.0f, slider.y - 2.0f}, 12, 1, labelColor);
+
+        const float t = row.maximum > row.minimum ? (row.value - row.minimum) / (row.maximum - row.minimum) : 0.0f;
+        DrawRectangleRec(slider, DARKGRAY);
+        DrawRectangleRec(Rectangle{slider.x, slider.y, slider.width * t, slider.height}, i == previewRow_ ? SKYBLUE : LIGHTGRAY);
+        DrawRectangleRec(Rectangle{slider.x + slider.width * t - 2.0f, slider.y - 3.0f, 4.0f, slider.height + 6.0f}, WHITE);
+
+        snprintf(text, sizeof(text), row.step >= 1.0f ? "%.0f" : "%.2f", row.value);
+        DrawTextEx(font, text, Vector2{slider.x + slider.width + 10.0f, slider.y - 2.0f}, 12, 1, labelColor);
+    }
+
+    DrawTextEx(font, "Tab next   [ ] or drag adjust   Enter apply   Esc cancel",
+               Vector2{panel.x + 8.0f, panel.y + panel.height - PANEL_FOOTER + 4.0f}, 10, 1, LIGHTGRAY);
+}
+
+} // namespace EpiGimp
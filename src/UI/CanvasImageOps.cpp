@@ -2,30 +2,76 @@
 #include "../../include/UI/Canvas.hpp"
 #include <iostream>
 #include <algorithm>
-#include <filesystem>
 
 namespace EpiGimp {
 
 void Canvas::loadImage(const std::string& filePath)
 {
+    if (ProjectFile::isProjectPath(filePath)) {
+        openProject(filePath);
+        return;
+    }
+    
     auto texture = createTextureFromFile(filePath);
     if (!texture) {
         eventDispatcher_->emit<ErrorEvent>("Failed to load image: " + filePath);
         return;
     }
     
+    // A synchronous load wins over any async load still in flight
+    if (imageLoader_)
+        imageLoader_->cancel();
+    
+    applyLoadedTexture(std::move(*texture), filePath);
+}
+
+void Canvas::loadImageAsync(const std::string& filePath)
+{
+    // Projects are mapped and streamed tile by tile already
+    if (ProjectFile::isProjectPath(filePath)) {
+        openProject(filePath);
+        return;
+    }
+    
+    if (!imageLoader_)
+        imageLoader_ = std::make_unique<AsyncImageLoader>(eventDispatcher_);
+    
+    imageLoader_->requestLoad(filePath, static_cast<int>(bounds_.width), static_cast<int>(bounds_.height));
+}
+
+void Canvas::updateImageLoading()
+{
+    if (!imageLoader_)
+        return;
+    
+    auto result = imageLoader_->update();
+    if (!result)
+        return;
+    
+    if (!result->texture) {
+        eventDispatcher_->emit<ErrorEvent>(result->error);
+        return;
+    }
+    
+    applyLoadedTexture(std::move(*result->texture), result->filePath);
+}
+
+float Canvas::getImageLoadProgress() const
+{
+    if (projectStreamer_)
+        return projectStreamer_->getProgress();
+    return imageLoader_ ? imageLoader_->getProgress() : 0.0f;
+}
+
+void Canvas::applyLoadedTexture(TextureResource texture, const std::string& filePath)
+{
+    projectStreamer_.reset();
     currentTexture_ = std::move(texture);
+    backgroundPixels_.reset();
     currentImagePath_ = filePath;
     
     std::cout << "Canvas: Loaded texture " << (*currentTexture_)->width << "x" << (*currentTexture_)->height << std::endl;
     
-    Image testImage = LoadImageFromTexture(**currentTexture_);
-    std::cout << "Canvas: Extracted test image: " << testImage.width << "x" << testImage.height << " format=" << testImage.format << std::endl;
-    ExportImage(testImage, "/tmp/debug_loaded_texture.png");
-    std::cout << "Canvas: Saved debug texture to /tmp/debug_loaded_texture.png" << std::endl;
-    UnloadImage(testImage);
-    
-    // Update layer manager size and load image into background layer
     // Initialize drawing texture for the new image
     if (currentTexture_)
         initializeDrawingTexture();
@@ -42,7 +88,9 @@ void Canvas::createBlankCanvas(int width, int height, Color backgroundColor)
 {
     Image blankImage = GenImageColor(width, height, backgroundColor);
     
+    projectStreamer_.reset();
     currentTexture_ = TextureResource::fromImage(blankImage);
+    backgroundPixels_.reset();
     currentImagePath_ = ""; // No file path for blank canvas
     
     std::cout << "Canvas: Created blank canvas " << width << "x" << height << std::endl;
@@ -73,118 +121,123 @@ bool Canvas::saveImage(const std::string& filePath)
         return false;
     }
     
-    try {
-        std::filesystem::path parentPath = std::filesystem::path(filePath).parent_path();
-        if (!parentPath.empty() && !std::filesystem::exists(parentPath))
-            std::filesystem::create_directories(parentPath);
-    } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << "Failed to create directories: " << e.what() << std::endl;
-        // Continue anyway - the save operation might still work
+    if (ProjectFile::isProjectPath(filePath))
+        return saveProject(filePath);
+    
+    // Only the GPU readback of changed layers happens here, compositing and encoding run on the saver thread
+    DocumentSnapshot snapshot = captureSnapshot();
+    if (!snapshot.hasVisibleContent()) {
+        eventDispatcher_->emit<ErrorEvent>("No visible layers to save");
+        return false;
     }
     
-    Image compositeImage;
+    if (!imageSaver_)
+        imageSaver_ = std::make_unique<BackgroundSaver>(eventDispatcher_);
     
-    if (backgroundVisible_ && currentTexture_) {
-        compositeImage = LoadImageFromTexture(**currentTexture_);
-        
-        // Blend all visible drawing layers on top
-        for (const auto& layer : drawingLayers_) {
-            if (layer.visible && layer.texture) {
-                Image layerImage = LoadImageFromTexture((**layer.texture).texture);
-                ImageFlipVertical(&layerImage); // Fix texture orientation
-                
-                // Simple blend the layer onto the composite
-                for (int y = 0; y < compositeImage.height && y < layerImage.height; y++) {
-                    for (int x = 0; x < compositeImage.width && x < layerImage.width; x++) {
-                        Color layerPixel = GetImageColor(layerImage, x, y);
-                        if (layerPixel.a > 0) { // If layer pixel is not transparent
-                            ImageDrawPixel(&compositeImage, x, y, layerPixel);
-                        }
-                    }
-                }
-                
-                UnloadImage(layerImage);
-            }
-        }
-    } else if (!drawingLayers_.empty()) {
-        // Only drawing layers are visible - create composite from layers
-        bool hasVisibleLayer = false;
+    imageSaver_->submit(std::move(snapshot), filePath, BackgroundSaver::flattenedWriter(exportOptions_));
+    return true;
+}
+
+void Canvas::setPngCompressionLevel(int level)
+{
+    exportOptions_.pngCompressionLevel = std::clamp(level, 0, 9);
+    std::cout << "Canvas: PNG compression level set to " << exportOptions_.pngCompressionLevel << std::endl;
+}
+
+void Canvas::setRawTileRle(bool enabled)
+{
+    exportOptions_.rawTileRle = enabled;
+    std::cout << "Canvas: Raw tile RLE " << (enabled ? "enabled" : "disabled") << std::endl;
+}
+
+void Canvas::waitForPendingSaves()
+{
+    if (!imageSaver_)
+        return;
+    
+    imageSaver_->waitForIdle();
+    imageSaver_->update();
+}
+
+DocumentSnapshot Canvas::captureSnapshot(bool includeHidden)
+{
+    // A half-streamed project would be saved with holes
+    finishProjectStreaming();
+    
+    int width = 0;
+    int height = 0;
+    if (currentTexture_) {
+        width = (*currentTexture_)->width;
+        height = (*currentTexture_)->height;
+    } else {
         for (const auto& layer : drawingLayers_) {
-            if (layer.visible && layer.texture) {
-                if (!hasVisibleLayer) {
-                    // First visible layer becomes the base
-                    compositeImage = LoadImageFromTexture((**layer.texture).texture);
-                    ImageFlipVertical(&compositeImage);
-                    hasVisibleLayer = true;
-                } else {
-                    // Blend subsequent layers
-                    Image layerImage = LoadImageFromTexture((**layer.texture).texture);
-                    ImageFlipVertical(&layerImage);
-                    
-                    for (int y = 0; y < compositeImage.height && y < layerImage.height; y++) {
-                        for (int x = 0; x < compositeImage.width && x < layerImage.width; x++) {
-                            Color layerPixel = GetImageColor(layerImage, x, y);
-                            if (layerPixel.a > 0) {
-                                ImageDrawPixel(&compositeImage, x, y, layerPixel);
-                            }
-                        }
-                    }
-                    
-                    UnloadImage(layerImage);
-                }
+            if (layer.texture) {
+                width = (**layer.texture).texture.width;
+                height = (**layer.texture).texture.height;
+                break;
             }
         }
-        
-        if (!hasVisibleLayer) {
-            eventDispatcher_->emit<ErrorEvent>("No visible layers to save");
-            return false;
-        }
-    } else {
-        eventDispatcher_->emit<ErrorEvent>("No visible layers to save");
-        return false;
     }
     
-    ImageResource compositeRes(compositeImage);
+    DocumentSnapshot snapshot(width, height);
     
-    std::string actualPath;
-    const bool success = compositeRes.exportToFile(filePath, actualPath);
-    
-    if (success && actualPath != filePath)
-        std::cout << "Note: File extension was auto-corrected to: " << actualPath << std::endl;
-    
-    eventDispatcher_->emit<ImageSavedEvent>(actualPath, success);
+    if ((backgroundVisible_ || includeHidden) && currentTexture_) {
+        // The background texture is never drawn into, one readback per loaded image is enough
+        if (!backgroundPixels_) {
+            Image background = LoadImageFromTexture(**currentTexture_);
+            if (background.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+                ImageFormat(&background, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            backgroundPixels_ = makeSharedPixels(background);
+        }
+        snapshot.setBackground(backgroundPixels_, backgroundVisible_);
+    }
     
-    if (success) {
-        std::cout << "Image saved successfully: " << actualPath << std::endl;
-    } else {
-        eventDispatcher_->emit<ErrorEvent>("Failed to save image: " + filePath);
+    // Layer 0 is drawn on top, so walk the stack from the bottom up
+    for (int i = static_cast<int>(drawingLayers_.size()) - 1; i >= 0; --i) {
+        DrawingLayer& layer = drawingLayers_[i];
+        if ((!layer.visible && !includeHidden) || !layer.texture)
+            continue;
+        
+        LayerSnapshot layerSnapshot;
+        layerSnapshot.pixels = snapshotLayerPixels(layer);
+        layerSnapshot.flippedVertical = layer.flippedVertical;
+        layerSnapshot.flippedHorizontal = layer.flippedHorizontal;
+        layerSnapshot.visible = layer.visible;
+        layerSnapshot.name = layer.name;
+        layerSnapshot.id = (static_cast<uint64_t>(layer.handle.generation) << 32) | layer.handle.index;
+        snapshot.addLayer(std::move(layerSnapshot));
     }
     
-    return success;
+    return snapshot;
+}
+
+SharedPixels Canvas::snapshotLayerPixels(DrawingLayer& layer)
+{
+    const uint64_t revision = layer.texture->getRevision();
+    if (layer.snapshotPixels && layer.snapshotRevision == revision)
+        return layer.snapshotPixels;
+    
+    // Older snapshots keep the previous buffer alive, it is never written again
+    Image pixels = layer.texture->readPixels();
+    ImageFlipVertical(&pixels); // Render textures are stored bottom-up
+    if (pixels.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&pixels, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    
+    layer.snapshotPixels = makeSharedPixels(pixels);
+    layer.snapshotRevision = revision;
+    return layer.snapshotPixels;
 }
 
 std::optional<TextureResource> Canvas::createTextureFromFile(const std::string& filePath)
 {
-    auto imageRes = ImageResource::fromFile(filePath);
-    if (!imageRes)
+    // Fitted while decoding, so a huge PNG never needs a full-size copy in memory
+    ImageResource imageRes(ImageResource::loadFile(filePath, static_cast<int>(bounds_.width),
+                                                   static_cast<int>(bounds_.height)));
+    if (!imageRes.isValid())
         return std::nullopt;
     
-    const auto maxWidth = static_cast<int>(bounds_.width);
-    const auto maxHeight = static_cast<int>(bounds_.height);
-    
-    if (imageRes->get()->width > maxWidth || imageRes->get()->height > maxHeight) {
-        const float widthRatio = static_cast<float>(maxWidth) / imageRes->get()->width;
-        const float heightRatio = static_cast<float>(maxHeight) / imageRes->get()->height;
-        const float scale = std::min(widthRatio, heightRatio);
-        
-        const int newWidth = static_cast<int>(imageRes->get()->width * scale);
-        const int newHeight = static_cast<int>(imageRes->get()->height * scale);
-        
-        imageRes->resize(newWidth, newHeight);
-        std::cout << "Image resized to: " << newWidth << "x" << newHeight << std::endl;
-    }
-    
-    return TextureResource::fromImage(*imageRes->get());
+    std::cout << "Image loaded at: " << imageRes.get()->width << "x" << imageRes.get()->height << std::endl;
+    return TextureResource::fromImage(*imageRes.get());
 }
 
 void Canvas::drawImage() const
@@ -245,7 +298,10 @@ void Canvas::drawImage() const
                 float globalFlippedHeight = canvasFlippedVertical_ ? -layerSourceHeight : layerSourceHeight;
                 
                 Rectangle sourceRect = {0, 0, globalFlippedWidth, globalFlippedHeight};
-                DrawTexturePro(layerTex, sourceRect, imageDestRect, Vector2{0, 0}, 0.0f, WHITE);
+                if (i == selectedLayerIndex_ && (previewTexture_ || previewRefined_))
+                    drawFilterPreview(imageDestRect, globalFlippedWidth < 0, globalFlippedHeight < 0);
+                else
+                    DrawTexturePro(layerTex, sourceRect, imageDestRect, Vector2{0, 0}, 0.0f, WHITE);
             }
         }
     }
@@ -361,7 +417,7 @@ Color Canvas::pickColorAtScreenPosition(Vector2 screenPos) const
     for (int i = static_cast<int>(drawingLayers_.size()) - 1; i >= 0; --i) {
         const auto& layer = drawingLayers_[i];
         if (layer.visible && layer.texture) {
-            Image layerImage = LoadImageFromTexture((**layer.texture).texture);
+            Image layerImage = layer.texture->readPixels();
             ImageFlipVertical(&layerImage); // Fix texture orientation
             
             if (!hasComposite) {
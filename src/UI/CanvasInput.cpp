@@ -1,5 +1,8 @@
 //Canvas input handling functionality
 #include "../../include/UI/Canvas.hpp"
+#include "../../include/Commands/DrawCommand.hpp"
+#include "../../include/Core/HistoryManager.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace EpiGimp {
@@ -8,8 +11,19 @@ void Canvas::handleInput()
 {
     handleZoom();
     handlePanning();
+    if (previewFilter_) {
+        handleFilterPreview();   // Tools wait until the filter is applied or cancelled
+        return;
+    }
     handleGlobalKeyboard();
     handleEyedropper();
+    handleBucketFill();
+    handleMagicWand();
+}
+
+bool Canvas::usesEscape() const
+{
+    return previewFilter_.has_value() || !freeformPoints_.empty() || hasSelection_;
 }
 
 void Canvas::handleGlobalKeyboard()
@@ -23,9 +37,9 @@ void Canvas::handleGlobalKeyboard()
         }
     }
     
-    // Ctrl+A for select all (only if using selection tool)
+    // Ctrl+A for select all (only if using a selection tool)
     if (IsKeyPressed(KEY_A) && (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL))) {
-        if (currentTool_ == DrawingTool::Select) {
+        if (isSelectionTool()) {
             selectAll();
         }
     }
@@ -40,7 +54,7 @@ void Canvas::handleGlobalKeyboard()
     
     // T key to toggle transform mode
     if (IsKeyPressed(KEY_T)) {
-        if (hasSelection_ && currentTool_ == DrawingTool::Select) {
+        if (hasSelection_ && selectionIsRectangle_ && currentTool_ == DrawingTool::Select) {
             if (isTransformMode_) {
                 exitTransformMode();
             } else {
@@ -51,14 +65,14 @@ void Canvas::handleGlobalKeyboard()
     
     // V key to flip selection vertically
     if (IsKeyPressed(KEY_V)) {
-        if (hasSelection_ && currentTool_ == DrawingTool::Select) {
+        if (hasSelection_ && isSelectionTool()) {
             flipSelectionVertical();
         }
     }
     
     // H key to flip selection horizontally
     if (IsKeyPressed(KEY_H)) {
-        if (hasSelection_ && currentTool_ == DrawingTool::Select) {
+        if (hasSelection_ && isSelectionTool()) {
             flipSelectionHorizontal();
         }
     }
@@ -69,14 +83,36 @@ void Canvas::handleGlobalKeyboard()
         std::cout << "Mirror mode " << (mirrorModeEnabled_ ? "enabled" : "disabled") << std::endl;
     }
     
+    // Ctrl+I inverts the selection
+    const bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    if (IsKeyPressed(KEY_I) && control) {
+        invertSelection();
+    }
+    
     // I key to select eyedropper tool
-    if (IsKeyPressed(KEY_I)) {
+    if (IsKeyPressed(KEY_I) && !control) {
         if (eventDispatcher_) {
             eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Eyedropper);
             std::cout << "Eyedropper tool selected" << std::endl;
         }
     }
     
+    // L key to select lasso tool
+    if (IsKeyPressed(KEY_L)) {
+        if (eventDispatcher_) {
+            eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::Lasso);
+            std::cout << "Lasso tool selected" << std::endl;
+        }
+    }
+    
+    // U key to select magic wand tool
+    if (IsKeyPressed(KEY_U)) {
+        if (eventDispatcher_) {
+            eventDispatcher_->emit<ToolSelectedEvent>(DrawingTool::MagicWand);
+            std::cout << "Magic wand tool selected" << std::endl;
+        }
+    }
+    
     // Zoom keyboard shortcuts
     if (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) {
         // Ctrl+0: Fit to screen / Reset zoom
@@ -195,4 +231,61 @@ void Canvas::handleEyedropper()
     }
 }
 
-} // namespace EpiGimp
\ No newline at end of file
+void Canvas::handleBucketFill()
+{
+    if (!hasImage() || currentTool_ != DrawingTool::Fill) return;
+    
+    // [ and ] change the tolerance (by 16 with Shift), A toggles edge smoothing, S sample merged
+    const bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    const int step = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT) ? 16 : 4;
+    if (IsKeyPressed(KEY_LEFT_BRACKET))
+        setFillTolerance(std::max(0, getFillTolerance() - step));
+    if (IsKeyPressed(KEY_RIGHT_BRACKET))
+        setFillTolerance(std::min(255, getFillTolerance() + step));
+    if (IsKeyPressed(KEY_A) && !control)
+        setFillAntialias(!isFillAntialiased());
+    if (IsKeyPressed(KEY_S) && !control)
+        setFillSampleMerged(!isFillSampleMerged());
+    
+    const Vector2 mousePos = GetMousePosition();
+    if (!CheckCollisionPointRec(mousePos, calculateImageDestRect())) return;
+    
+    // Left click fills with the primary color, right click with the secondary
+    const bool primary = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+    if (!primary && !IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) return;
+    
+    std::unique_ptr<DrawCommand> command = historyManager_ ? createDrawCommand(this, "Bucket Fill") : nullptr;
+    if (!fillAt(screenToImageCoords(mousePos), primary ? primaryColor_ : secondaryColor_))
+        return;
+    
+    if (command) {
+        command->captureAfterState();
+        historyManager_->executeCommand(std::move(command));
+    }
+}
+
+void Canvas::handleMagicWand()
+{
+    if (!hasImage() || currentTool_ != DrawingTool::MagicWand) return;
+    
+    // [ and ] change the tolerance (by 16 with Shift), C toggles contiguous, S sample merged
+    const bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    const int step = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT) ? 16 : 4;
+    if (IsKeyPressed(KEY_LEFT_BRACKET))
+        setWandTolerance(std::max(0, getWandTolerance() - step));
+    if (IsKeyPressed(KEY_RIGHT_BRACKET))
+        setWandTolerance(std::min(255, getWandTolerance() + step));
+    if (IsKeyPressed(KEY_C) && !control)
+        setWandContiguous(!isWandContiguous());
+    if (IsKeyPressed(KEY_S) && !control)
+        setWandSampleMerged(!isWandSampleMerged());
+    
+    const Vector2 mousePos = GetMousePosition();
+    if (!CheckCollisionPointRec(mousePos, calculateImageDestRect())) return;
+    if (!IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) return;
+    
+    // Same modifiers as the rectangle tool: Shift adds, Ctrl subtracts, both intersect
+    selectByColorAt(screenToImageCoords(mousePos), selectionModeFromKeys());
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,210 @@
+//Canvas project (.epg) open and save
+#include "../../include/UI/Canvas.hpp"
+#include "rlgl.h"  // For the blend factors used when streaming tiles into layers
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace EpiGimp {
+
+bool Canvas::openProject(const std::string& filePath)
+{
+    std::string error;
+    std::shared_ptr<const ProjectReader> reader = ProjectReader::open(filePath, &error);
+    if (!reader) {
+        eventDispatcher_->emit<ErrorEvent>(error);
+        return false;
+    }
+
+    if (imageLoader_)
+        imageLoader_->cancel();
+    projectStreamer_.reset();
+
+    const int width = reader->getWidth();
+    const int height = reader->getHeight();
+
+    // The background starts uninitialised on the GPU, every one of its tiles is streamed
+    int backgroundLayer = -1;
+    for (size_t i = 0; i < reader->getLayerCount(); ++i) {
+        if (reader->getLayerInfo(i).isBackground) {
+            backgroundLayer = static_cast<int>(i);
+            break;
+        }
+    }
+
+    if (backgroundLayer >= 0) {
+        Texture2D background{};
+        background.id = rlLoadTexture(nullptr, width, height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+        background.width = width;
+        background.height = height;
+        background.mipmaps = 1;
+        background.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        if (background.id == 0) {
+            eventDispatcher_->emit<ErrorEvent>("Failed to create texture for project: " + filePath);
+            return false;
+        }
+        currentTexture_ = TextureResource(background);
+        backgroundVisible_ = reader->getLayerInfo(backgroundLayer).visible;
+    } else {
+        Image blank = GenImageColor(width, height, BLANK);
+        currentTexture_ = TextureResource::fromImage(blank);
+        UnloadImage(blank);
+        backgroundVisible_ = false;
+    }
+    backgroundPixels_.reset();
+    currentImagePath_ = filePath;
+
+    // File layers run bottom to top, the canvas keeps the top layer at index 0
+    drawingLayers_.clear();
+    layerSlots_.clear();
+    projectTargets_.assign(reader->getLayerCount(), LayerHandle{});
+    for (int i = static_cast<int>(reader->getLayerCount()) - 1; i >= 0; --i) {
+        const ProjectReader::LayerInfo& info = reader->getLayerInfo(i);
+        if (info.isBackground)
+            continue;
+
+        drawingLayers_.emplace_back(info.name);
+        DrawingLayer& layer = drawingLayers_.back();
+        layer.handle = layerSlots_.insert(drawingLayers_.size() - 1);
+        layer.visible = info.visible;
+        layer.flippedVertical = info.flippedVertical;
+        layer.flippedHorizontal = info.flippedHorizontal;
+        layer.texture = RenderTextureResource(width, height);
+        layer.texture->clear(Color{0, 0, 0, 0});
+        projectTargets_[i] = layer.handle;
+    }
+    selectedLayerIndex_ = drawingLayers_.empty() ? -1 : 0;
+
+    clearSelection();
+    resetViewTransform();
+
+    // Stream what is on screen first, nearest to the view centre
+    const Rectangle view = calculateImageDestRect();
+    const Vector2 viewCenter = screenToImageCoords(Vector2{bounds_.x + bounds_.width / 2, bounds_.y + bounds_.height / 2});
+    const Vector2 visibleMin = screenToImageCoords(Vector2{std::max(view.x, bounds_.x), std::max(view.y, bounds_.y)});
+    const Vector2 visibleMax = screenToImageCoords(Vector2{std::min(view.x + view.width, bounds_.x + bounds_.width),
+                                                           std::min(view.y + view.height, bounds_.y + bounds_.height)});
+
+    struct TilePosition { int x; int y; bool visible; float distance; };
+    std::vector<TilePosition> positions;
+    for (int ty = 0; ty < reader->getTilesY(); ++ty) {
+        for (int tx = 0; tx < reader->getTilesX(); ++tx) {
+            const Rectangle rect = reader->getTileRect(tx, ty);
+            const bool visible = rect.x < visibleMax.x && rect.x + rect.width > visibleMin.x &&
+                                 rect.y < visibleMax.y && rect.y + rect.height > visibleMin.y;
+            const float dx = rect.x + rect.width / 2 - viewCenter.x;
+            const float dy = rect.y + rect.height / 2 - viewCenter.y;
+            positions.push_back(TilePosition{tx, ty, visible, std::sqrt(dx * dx + dy * dy)});
+        }
+    }
+    std::stable_sort(positions.begin(), positions.end(), [](const TilePosition& a, const TilePosition& b) {
+        if (a.visible != b.visible)
+            return a.visible;
+        return a.distance < b.distance;
+    });
+
+    std::vector<ProjectTileStreamer::TileRequest> order;
+    for (const auto& position : positions) {
+        for (size_t layer = 0; layer < reader->getLayerCount(); ++layer) {
+            // Layers were cleared on creation, only the background needs its empty tiles
+            if (static_cast<int>(layer) != backgroundLayer && reader->isTileEmpty(layer, position.x, position.y))
+                continue;
+            order.push_back(ProjectTileStreamer::TileRequest{layer, position.x, position.y});
+        }
+    }
+
+    projectStreamer_ = std::make_unique<ProjectTileStreamer>(reader, std::move(order));
+    std::cout << "Canvas: Opened project " << filePath << ", streaming " << projectStreamer_->getTotalTiles() << " tiles" << std::endl;
+
+    eventDispatcher_->emit<ImageLoadedEvent>(filePath);
+    return true;
+}
+
+bool Canvas::saveProject(const std::string& filePath)
+{
+    if (!hasImage()) {
+        eventDispatcher_->emit<ErrorEvent>("No image to save");
+        return false;
+    }
+
+    DocumentSnapshot snapshot = captureSnapshot(true);
+
+    if (!imageSaver_)
+        imageSaver_ = std::make_unique<BackgroundSaver>(eventDispatcher_);
+
+    imageSaver_->submit(std::move(snapshot), filePath,
+        [](const DocumentSnapshot& document, const std::string& path, std::string& actualPath) {
+            actualPath = path;
+            return ProjectFile::write(document, path);
+        });
+    return true;
+}
+
+void Canvas::updateProjectStreaming()
+{
+    if (!projectStreamer_)
+        return;
+
+    for (const auto& tile : projectStreamer_->takeReady(PROJECT_UPLOAD_BUDGET))
+        uploadProjectTile(tile);
+
+    if (projectStreamer_->isFinished()) {
+        std::cout << "Canvas: Project fully loaded" << std::endl;
+        projectStreamer_.reset();
+    }
+}
+
+void Canvas::finishProjectStreaming()
+{
+    if (!projectStreamer_)
+        return;
+
+    for (const auto& tile : projectStreamer_->takeAll())
+        uploadProjectTile(tile);
+    projectStreamer_.reset();
+}
+
+void Canvas::uploadProjectTile(const ProjectTileStreamer::DecodedTile& tile)
+{
+    const ProjectReader& reader = projectStreamer_->getReader();
+    if (!tile.valid) {
+        std::cerr << "Canvas: Skipping corrupt tile " << tile.request.tileX << "," << tile.request.tileY
+                  << " of layer " << tile.request.layer << std::endl;
+        return;
+    }
+
+    // The background texture is never drawn into, tiles can go straight to the GPU
+    if (reader.getLayerInfo(tile.request.layer).isBackground) {
+        if (currentTexture_)
+            UpdateTextureRec(**currentTexture_, tile.rect, tile.pixels.data());
+        return;
+    }
+
+    DrawingLayer* layer = getLayer(projectTargets_[tile.request.layer]);
+    if (!layer || !layer->texture)
+        return; // Layer was deleted while the project was streaming
+
+    const int tileSize = reader.getTileSize();
+    if (!tileStaging_ || (*tileStaging_)->width < tileSize || (*tileStaging_)->height < tileSize) {
+        Texture2D staging{};
+        staging.id = rlLoadTexture(nullptr, tileSize, tileSize, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+        staging.width = tileSize;
+        staging.height = tileSize;
+        staging.mipmaps = 1;
+        staging.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        tileStaging_ = TextureResource(staging);
+    }
+
+    const Rectangle source = {0, 0, tile.rect.width, tile.rect.height};
+    UpdateTextureRec(**tileStaging_, source, tile.pixels.data());
+
+    // Composite the tile under whatever was painted since the project opened (destination-over)
+    layer->texture->beginDrawing();
+    rlSetBlendFactors(RL_ONE_MINUS_DST_ALPHA, RL_ONE, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM);
+    DrawTextureRec(**tileStaging_, source, Vector2{tile.rect.x, tile.rect.y}, WHITE);
+    EndBlendMode();
+    layer->texture->endDrawing();
+}
+
+} // namespace EpiGimp
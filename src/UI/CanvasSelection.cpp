@@ -1,5 +1,6 @@
 //Canvas selection functionality
 #include "../../include/UI/Canvas.hpp"
+#include "../../include/Utils/PolygonRasterizer.hpp"
 #include <iostream>
 #include <cmath>
 #include "raymath.h"
@@ -8,6 +9,11 @@ namespace EpiGimp {
 
 void Canvas::handleSelection()
 {
+    if (currentTool_ == DrawingTool::Lasso || currentTool_ == DrawingTool::Polygon) {
+        handleFreeformSelection();
+        return;
+    }
+    freeformPoints_.clear();   // An outline left over from another tool is dropped
     if (currentTool_ != DrawingTool::Select) return;
     
     const Vector2 mousePos = GetMousePosition();
@@ -18,7 +24,7 @@ void Canvas::handleSelection()
     // Handle selection input
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
         // Check if clicking on a resize handle first
-        if (hasSelection_) {
+        if (hasSelection_ && selectionIsRectangle_) {
             ResizeHandle handle = getResizeHandleAt(mousePos);
             if (handle != ResizeHandle::None) {
                 if (isTransformMode_) {
@@ -46,7 +52,8 @@ void Canvas::handleSelection()
         selectionStart_ = mousePos;
         selectionEnd_ = mousePos;
         isSelecting_ = true;
-        hasSelection_ = false; // Clear existing selection while dragging
+        if (selectionModeFromKeys() == SelectionMode::Replace)
+            hasSelection_ = false; // Clear existing selection while dragging
         
         std::cout << "Started selection at (" << mousePos.x << "," << mousePos.y << ")" << std::endl;
     }
@@ -76,6 +83,7 @@ void Canvas::handleSelection()
             // Finish resizing
             isResizingSelection_ = false;
             resizeHandle_ = ResizeHandle::None;
+            setRectangleSelection(selectionRect_);
             std::cout << "Finished resizing selection: (" << selectionRect_.x << "," << selectionRect_.y 
                       << ") " << selectionRect_.width << "x" << selectionRect_.height << std::endl;
         }
@@ -88,25 +96,127 @@ void Canvas::handleSelection()
             const Vector2 imageEnd = screenToImageCoords(selectionEnd_);
             
             // Create normalized rectangle
-            selectionRect_ = normalizeRect(imageStart, imageEnd);
+            const Rectangle rect = normalizeRect(imageStart, imageEnd);
+            const SelectionMode mode = selectionModeFromKeys();
             
             // Only create selection if it has meaningful size
-            if (selectionRect_.width > 1.0f && selectionRect_.height > 1.0f) {
-                hasSelection_ = true;
+            if (rect.width <= 1.0f || rect.height <= 1.0f) {
+                if (mode == SelectionMode::Replace)
+                    clearSelection();
+                std::cout << "Selection too small, ignored" << std::endl;
+            } else if (mode == SelectionMode::Replace) {
+                setRectangleSelection(rect);
                 std::cout << "Selection created: (" << selectionRect_.x << "," << selectionRect_.y 
                           << ") " << selectionRect_.width << "x" << selectionRect_.height << std::endl;
             } else {
-                hasSelection_ = false;
-                std::cout << "Selection too small, ignored" << std::endl;
+                const Vector2 size = getImageSize();
+                selectShape(SelectionMask::fromRect(static_cast<int>(size.x), static_cast<int>(size.y), rect), mode);
             }
         }
     }
 }
 
+void Canvas::handleFreeformSelection()
+{
+    if (!hasImage()) return;
+    
+    const Vector2 mousePos = GetMousePosition();
+    const bool pressedInside = IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mousePos, bounds_);
+    
+    // Lasso: the outline follows the mouse while the button is held and closes on release
+    if (currentTool_ == DrawingTool::Lasso) {
+        if (pressedInside) {
+            freeformPoints_.assign(1, screenToImageCoords(mousePos));
+        } else if (!freeformPoints_.empty() && IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+            // A point per screen pixel moved is as fine as the outline can be seen
+            if (Vector2Distance(imageToScreenCoords(freeformPoints_.back()), mousePos) >= 1.0f)
+                freeformPoints_.push_back(screenToImageCoords(mousePos));
+        }
+        if (!freeformPoints_.empty() && IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+            finishFreeformSelection();
+        return;
+    }
+    
+    // Polygon: each click places a vertex; clicking the first one again or Enter closes it
+    if (freeformPoints_.empty() && !pressedInside) return;
+    if (IsKeyPressed(KEY_ESCAPE)) {
+        freeformPoints_.clear();
+        return;
+    }
+    if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_KP_ENTER)) {
+        finishFreeformSelection();
+        return;
+    }
+    if (!pressedInside) return;
+    
+    const float closeDistance = 6.0f;   // Screen pixels
+    if (freeformPoints_.size() >= 3 &&
+        Vector2Distance(imageToScreenCoords(freeformPoints_.front()), mousePos) <= closeDistance) {
+        finishFreeformSelection();
+        return;
+    }
+    freeformPoints_.push_back(screenToImageCoords(mousePos));
+}
+
+void Canvas::finishFreeformSelection()
+{
+    std::vector<Vector2> points;
+    points.swap(freeformPoints_);
+    const SelectionMode mode = selectionModeFromKeys();
+    
+    if (points.size() < 3) {
+        if (mode == SelectionMode::Replace)
+            clearSelection();
+        std::cout << "Outline too small, ignored" << std::endl;
+        return;
+    }
+    
+    const Vector2 size = getImageSize();
+    selectShape(PolygonRasterizer::rasterize(points, static_cast<int>(size.x), static_cast<int>(size.y)), mode);
+    std::cout << (currentTool_ == DrawingTool::Lasso ? "Lasso" : "Polygon") << " selection closed with "
+              << points.size() << " points" << std::endl;
+}
+
+bool Canvas::isSelectionTool() const
+{
+    return currentTool_ == DrawingTool::Select || currentTool_ == DrawingTool::MagicWand ||
+           currentTool_ == DrawingTool::Lasso || currentTool_ == DrawingTool::Polygon;
+}
+
+void Canvas::drawFreeformPath() const
+{
+    for (size_t i = 1; i < freeformPoints_.size(); ++i)
+        DrawLineV(imageToScreenCoords(freeformPoints_[i - 1]), imageToScreenCoords(freeformPoints_[i]), BLACK);
+    
+    // Closing edge: back to the start for a lasso, to the mouse while a polygon is being placed
+    const Vector2 last = imageToScreenCoords(freeformPoints_.back());
+    const Vector2 first = imageToScreenCoords(freeformPoints_.front());
+    if (currentTool_ == DrawingTool::Polygon) {
+        DrawLineV(last, GetMousePosition(), GRAY);
+        DrawRectangleLinesEx(Rectangle{first.x - 4.0f, first.y - 4.0f, 8.0f, 8.0f}, 1.0f, BLACK);
+    } else {
+        DrawLineV(last, first, GRAY);
+    }
+}
+
 void Canvas::drawSelection() const
 {
     if (!hasImage()) return;
     
+    // Any shape other than a plain rectangle: marching ants along the mask's outline
+    if (!isSelecting_ && hasSelection_ && !selectionIsRectangle_) {
+        const float dashLength = 4.0f;
+        const float animOffset = selectionAnimTime_ * 8.0f;
+        const std::vector<Vector2>& outline = selectionMask_.getOutline();
+        for (size_t i = 0; i + 1 < outline.size(); i += 2) {
+            const Vector2 from = imageToScreenCoords(outline[i]);
+            const Vector2 to = imageToScreenCoords(outline[i + 1]);
+            const int dash = static_cast<int>(std::floor((from.x + from.y + animOffset) / dashLength));
+            DrawLineV(from, to, dash % 2 == 0 ? BLACK : WHITE);
+        }
+        return;
+    }
+    
     Rectangle screenRect;
     
     if (isSelecting_) {
@@ -199,7 +309,7 @@ void Canvas::drawDashedLine(Vector2 start, Vector2 end, Color color, float dashL
 
 ResizeHandle Canvas::getResizeHandleAt(Vector2 mousePos) const
 {
-    if (!hasSelection_) return ResizeHandle::None;
+    if (!hasSelection_ || !selectionIsRectangle_) return ResizeHandle::None;
     
     const float handleSize = 8.0f; // Size of resize handles in pixels
     
@@ -385,4 +495,98 @@ void Canvas::updateSelectionResize(Vector2 mousePos)
     selectionRect_ = newRect;
 }
 
+void Canvas::setRectangleSelection(Rectangle rect)
+{
+    const Vector2 size = getImageSize();
+    selectionMask_ = SelectionMask::fromRect(static_cast<int>(size.x), static_cast<int>(size.y), rect);
+    selectionRect_ = rect;
+    hasSelection_ = !selectionMask_.isEmpty();
+    selectionIsRectangle_ = hasSelection_;
+}
+
+void Canvas::setSelectionMask(SelectionMask mask)
+{
+    selectionMask_ = std::move(mask);
+    hasSelection_ = !selectionMask_.isEmpty();
+    selectionRect_ = hasSelection_ ? selectionMask_.getBounds() : Rectangle{0, 0, 0, 0};
+    selectionIsRectangle_ = hasSelection_ && selectionMask_.isRectangle();
+    isSelecting_ = false;
+}
+
+void Canvas::selectShape(const SelectionMask& shape, SelectionMode mode)
+{
+    // Without a selection, subtracting or intersecting leaves nothing and adding is replacing
+    SelectionMask result = hasSelection_ ? selectionMask_ : SelectionMask(shape.getWidth(), shape.getHeight());
+    result.combine(shape, mode);
+    setSelectionMask(std::move(result));
+    
+    std::cout << "Selection combined (mode " << static_cast<int>(mode) << "): (" << selectionRect_.x << ","
+              << selectionRect_.y << ") " << selectionRect_.width << "x" << selectionRect_.height << std::endl;
+}
+
+void Canvas::invertSelection()
+{
+    if (!hasImage()) return;
+    
+    SelectionMask inverted = hasSelection_ ? selectionMask_ : SelectionMask(static_cast<int>(getImageSize().x), static_cast<int>(getImageSize().y));
+    inverted.invert();
+    setSelectionMask(std::move(inverted));
+    std::cout << "Selection inverted" << std::endl;
+}
+
+bool Canvas::selectByColorAt(Vector2 imagePos, SelectionMode mode)
+{
+    if (!hasDrawingTexture()) return false;
+    
+    Image layerImage = drawingLayers_[selectedLayerIndex_].texture->readPixels();
+    const int width = layerImage.width;
+    const int height = layerImage.height;
+    
+    // Seed in texture order, as for the bucket fill
+    int x = static_cast<int>(std::floor(imagePos.x));
+    int y = static_cast<int>(std::floor(imagePos.y));
+    if (canvasFlippedHorizontal_) x = width - 1 - x;
+    if (!canvasFlippedVertical_) y = height - 1 - y;
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        UnloadImage(layerImage);
+        return false;
+    }
+    
+    // The composite is already top-down, so it is matched as is rather than flipped
+    Image source = layerImage;
+    bool bottomUp = true;
+    if (wandSampleMerged_) {
+        Image merged = captureSnapshot().composite();
+        if (merged.data && merged.width == width && merged.height == height) {
+            UnloadImage(layerImage);
+            source = merged;
+            bottomUp = false;
+            y = height - 1 - y;
+        } else if (merged.data) {
+            UnloadImage(merged);
+        }
+    }
+    if (source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    
+    SelectionMask shape = wandContiguous_ ? FloodFill::selectRegion(source, x, y, wandTolerance_, bottomUp)
+                                          : FloodFill::selectSimilar(source, x, y, wandTolerance_, bottomUp);
+    UnloadImage(source);
+    
+    std::cout << "Magic wand at (" << x << "," << y << "), tolerance " << wandTolerance_
+              << (wandContiguous_ ? ", contiguous" : ", global") << std::endl;
+    selectShape(shape, mode);
+    return true;
+}
+
+SelectionMode Canvas::selectionModeFromKeys() const
+{
+    const bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    const bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    if (shift && control) return SelectionMode::Intersect;
+    if (shift) return SelectionMode::Add;
+    if (control) return SelectionMode::Subtract;
+    return SelectionMode::Replace;
+}
+
 } // namespace EpiGimp
\ No newline at end of file
@@ -9,9 +9,7 @@ LayerPanel::LayerPanel(Rectangle bounds, LayerManager* layerManager, EventDispat
     , layerManager_(layerManager)
     , eventDispatcher_(dispatcher)
     , scrollOffset_(0)
-    , selectedLayerIndex_(0)
     , isDragging_(false)
-    , dragStartIndex_(-1)
     , dragOffset_{0, 0}
 {
     
@@ -21,27 +19,27 @@ LayerPanel::LayerPanel(Rectangle bounds, LayerManager* layerManager, EventDispat
     if (!dispatcher)
         throw std::invalid_argument("EventDispatcher cannot be null");
     
-    dispatcher->subscribe<LayerCreatedEvent>([this](const LayerCreatedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<LayerCreatedEvent>([this](const LayerCreatedEvent& event) {
         onLayerCreated(event);
-    });
+    }));
     
-    dispatcher->subscribe<LayerDeletedEvent>([this](const LayerDeletedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<LayerDeletedEvent>([this](const LayerDeletedEvent& event) {
         onLayerDeleted(event);
-    });
+    }));
     
-    dispatcher->subscribe<ActiveLayerChangedEvent>([this](const ActiveLayerChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<ActiveLayerChangedEvent>([this](const ActiveLayerChangedEvent& event) {
         onActiveLayerChanged(event);
-    });
+    }));
     
-    dispatcher->subscribe<LayerVisibilityChangedEvent>([this](const LayerVisibilityChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<LayerVisibilityChangedEvent>([this](const LayerVisibilityChangedEvent& event) {
         onLayerVisibilityChanged(event);
-    });
+    }));
     
-    dispatcher->subscribe<LayerReorderedEvent>([this](const LayerReorderedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<LayerReorderedEvent>([this](const LayerReorderedEvent& event) {
         onLayerReordered(event);
-    });
+    }));
     
-    selectedLayerIndex_ = layerManager_->getActiveLayerIndex();
+    selectedLayer_ = layerManager_->getActiveLayerHandle();
 }
 
 void LayerPanel::update(float /*deltaTime*/)
@@ -74,7 +72,7 @@ void LayerPanel::draw() const
 
 void LayerPanel::refreshLayerList()
 {
-    selectedLayerIndex_ = layerManager_->getActiveLayerIndex();
+    selectedLayer_ = layerManager_->getActiveLayerHandle();
     
     const int layerCount = static_cast<int>(layerManager_->getLayerCount());
     const int maxVisibleLayers = static_cast<int>((bounds_.height - 60) / LAYER_ITEM_HEIGHT);
@@ -135,7 +133,7 @@ void LayerPanel::handleLayerItemClick(int layerIndex, Vector2 mousePos)
         // Select layer
         layerManager_->setActiveLayer(layerIndex);
         isDragging_ = true;
-        dragStartIndex_ = layerIndex;
+        draggedLayer_ = layerManager_->getLayerHandle(layerIndex);
         dragOffset_ = {mousePos.x - itemRect.x, mousePos.y - itemRect.y};
     }
 }
@@ -146,7 +144,7 @@ void LayerPanel::handleLayerDrag()
         Vector2 mousePos = GetMousePosition();
         int targetIndex = getLayerIndexAtPosition(mousePos);
         
-        if (targetIndex >= 0 && targetIndex != dragStartIndex_) {
+        if (targetIndex >= 0 && targetIndex != layerManager_->getLayerIndex(draggedLayer_)) {
             // Visual feedback for drag operation
             // This would be implemented with more sophisticated UI feedback
         }
@@ -156,11 +154,13 @@ void LayerPanel::handleLayerDrag()
         Vector2 mousePos = GetMousePosition();
         int targetIndex = getLayerIndexAtPosition(mousePos);
         
-        if (targetIndex >= 0 && targetIndex != dragStartIndex_)
-            layerManager_->moveLayer(dragStartIndex_, targetIndex);
+        // Resolve the dragged layer now, its position may have changed since the drag started
+        int dragStartIndex = layerManager_->getLayerIndex(draggedLayer_);
+        if (targetIndex >= 0 && dragStartIndex >= 0 && targetIndex != dragStartIndex)
+            layerManager_->moveLayer(dragStartIndex, targetIndex);
         
         isDragging_ = false;
-        dragStartIndex_ = -1;
+        draggedLayer_ = LayerHandle{};
     }
 }
 
@@ -326,7 +326,7 @@ void LayerPanel::onLayerDeleted(const LayerDeletedEvent& /*event*/)
 
 void LayerPanel::onActiveLayerChanged(const ActiveLayerChangedEvent& event)
 {
-    selectedLayerIndex_ = event.newIndex;
+    selectedLayer_ = event.newHandle;
     scrollToLayer(event.newIndex);
 }
 
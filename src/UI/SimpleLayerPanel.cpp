@@ -9,7 +9,7 @@ SimpleLayerPanel::SimpleLayerPanel(Rectangle bounds, Canvas* canvas, EventDispat
     : bounds_(bounds), canvas_(canvas), eventDispatcher_(dispatcher),
       backgroundHovered_(false), addButtonHovered_(false), deleteButtonHovered_(false), 
       clearButtonHovered_(false), flipButtonHovered_(false), flipHButtonHovered_(false), scrollOffset_(0.0f),
-      isDragging_(false), dragStartIndex_(-1), dragOffset_{0, 0}, dragStartPos_{0, 0}
+      isDragging_(false), dragOffset_{0, 0}, dragStartPos_{0, 0}
 {
     if (!canvas_)
         throw std::invalid_argument("Canvas cannot be null");
@@ -196,7 +196,7 @@ void SimpleLayerPanel::handleInput()
                         
                         // Start dragging
                         isDragging_ = true;
-                        dragStartIndex_ = i;
+                        draggedLayer_ = canvas_->getLayerHandle(i);
                         dragStartPos_ = mousePos;
                         dragOffset_ = {mousePos.x - layerRect.x, mousePos.y - layerRect.y};
                     }
@@ -244,7 +244,7 @@ void SimpleLayerPanel::handleInput()
 
 void SimpleLayerPanel::drawLayerItem(const char* name, bool visible, bool hovered, bool selected, Rectangle itemRect, int layerIndex) const
 {
-    bool isBeingDragged = (isDragging_ && layerIndex == dragStartIndex_);
+    bool isBeingDragged = (isDragging_ && layerIndex >= 0 && canvas_->getLayerHandle(layerIndex) == draggedLayer_);
     
     Color bgColor = selected ? Color{80, 120, 80, 255} : (hovered ? Color{60, 60, 60, 255} : Color{50, 50, 50, 255});
     
@@ -474,13 +474,14 @@ void SimpleLayerPanel::handleLayerDrag()
             }
         }
         
-        if (targetIndex >= 0 && targetIndex != dragStartIndex_) {
-            canvas_->moveLayer(dragStartIndex_, targetIndex);
-            std::cout << "Moved layer from " << dragStartIndex_ << " to " << targetIndex << std::endl;
+        int dragStartIndex = canvas_->getLayerIndex(draggedLayer_);
+        if (targetIndex >= 0 && dragStartIndex >= 0 && targetIndex != dragStartIndex) {
+            canvas_->moveLayer(dragStartIndex, targetIndex);
+            std::cout << "Moved layer from " << dragStartIndex << " to " << targetIndex << std::endl;
         }
         
         isDragging_ = false;
-        dragStartIndex_ = -1;
+        draggedLayer_ = LayerHandle{};
     }
 }
 
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cstdio>
+#include <cmath>
 
 namespace EpiGimp {
 
@@ -21,7 +22,7 @@ ColorPalette::ColorPalette(Rectangle bounds, EventDispatcher* dispatcher)
     rgbInputActive_[0] = rgbInputActive_[1] = rgbInputActive_[2] = false;
     
     // Subscribe to color change events (e.g., from eyedropper)
-    dispatcher->subscribe<PrimaryColorChangedEvent>([this](const PrimaryColorChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<PrimaryColorChangedEvent>([this](const PrimaryColorChangedEvent& event) {
         primaryColor_ = event.primaryColor;
         // Update RGB input if showing
         if (showRgbInput_) {
@@ -33,15 +34,15 @@ ColorPalette::ColorPalette(Rectangle bounds, EventDispatcher* dispatcher)
                   << static_cast<int>(primaryColor_.r) << "," 
                   << static_cast<int>(primaryColor_.g) << "," 
                   << static_cast<int>(primaryColor_.b) << ")" << std::endl;
-    });
+    }));
     
-    dispatcher->subscribe<SecondaryColorChangedEvent>([this](const SecondaryColorChangedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<SecondaryColorChangedEvent>([this](const SecondaryColorChangedEvent& event) {
         secondaryColor_ = event.secondaryColor;
         std::cout << "ColorPalette: Secondary color updated to RGB(" 
                   << static_cast<int>(secondaryColor_.r) << "," 
                   << static_cast<int>(secondaryColor_.g) << "," 
                   << static_cast<int>(secondaryColor_.b) << ")" << std::endl;
-    });
+    }));
     
     initializePalette();
 }
@@ -95,12 +96,32 @@ void ColorPalette::update(float /*deltaTime*/)
     const Vector2 mousePos = GetMousePosition();
     
     Rectangle rgbToggleButton = {bounds_.x + bounds_.width - 25, bounds_.y + bounds_.height - 20, 20, 15};
+    Rectangle hsvToggleButton = {bounds_.x + bounds_.width - 50, bounds_.y + bounds_.height - 20, 20, 15};
     
     if (CheckCollisionPointRec(mousePos, rgbToggleButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        showHsvPicker_ = false;
         toggleRgbInput();
         return; // Don't process anything else this frame when toggling
     }
     
+    if (CheckCollisionPointRec(mousePos, hsvToggleButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        showRgbInput_ = false;
+        toggleHsvPicker();
+        return;
+    }
+    
+    if (showHsvPicker_) {
+        updateHsvPicker();
+        
+        if (showHsvPicker_ && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) &&
+            !CheckCollisionPointRec(mousePos, hsvWindow_) &&
+            !CheckCollisionPointRec(mousePos, hsvToggleButton)) {
+            showHsvPicker_ = false;
+        }
+        
+        return; // Same as the RGB panel: swatches wait until it closes
+    }
+    
     if (showRgbInput_) {
         updateRgbInput();
         
@@ -134,10 +155,10 @@ void ColorPalette::update(float /*deltaTime*/)
                 sprintf(rgbInput_[2], "%d", primaryColor_.b);
             }
             
-            // Emit primary color changed event
-            eventDispatcher_->emit<PrimaryColorChangedEvent>(PrimaryColorChangedEvent(primaryColor_));
+            // Queued: delivered with the frame's other events, repeated clicks coalesce
+            eventDispatcher_->post(PrimaryColorChangedEvent(primaryColor_));
             // Keep old event for backward compatibility
-            eventDispatcher_->emit<ColorChangedEvent>(ColorChangedEvent(primaryColor_));
+            eventDispatcher_->post(ColorChangedEvent(primaryColor_));
             
             std::cout << "Primary color selected: RGB(" << static_cast<int>(primaryColor_.r) 
                       << "," << static_cast<int>(primaryColor_.g) 
@@ -150,7 +171,7 @@ void ColorPalette::update(float /*deltaTime*/)
             secondaryIndex_ = static_cast<int>(i);
             
             // Emit secondary color changed event
-            eventDispatcher_->emit<SecondaryColorChangedEvent>(SecondaryColorChangedEvent(secondaryColor_));
+            eventDispatcher_->post(SecondaryColorChangedEvent(secondaryColor_));
             
             std::cout << "Secondary color selected: RGB(" << static_cast<int>(secondaryColor_.r) 
                       << "," << static_cast<int>(secondaryColor_.g) 
@@ -228,8 +249,15 @@ void ColorPalette::draw() const
     DrawRectangleLinesEx(rgbToggleButton, 1, BLACK);
     DrawText("RGB", static_cast<int>(rgbToggleButton.x + 1), static_cast<int>(rgbToggleButton.y + 2), 8, WHITE);
     
+    Rectangle hsvToggleButton = {bounds_.x + bounds_.width - 50, bounds_.y + bounds_.height - 20, 20, 15};
+    DrawRectangleRec(hsvToggleButton, showHsvPicker_ ? BLUE : DARKGRAY);
+    DrawRectangleLinesEx(hsvToggleButton, 1, BLACK);
+    DrawText("HSV", static_cast<int>(hsvToggleButton.x + 1), static_cast<int>(hsvToggleButton.y + 2), 8, WHITE);
+    
     if (showRgbInput_)
         drawRgbInput();
+    if (showHsvPicker_)
+        drawHsvPicker();
 }
 
 void ColorPalette::setSelectedColor(Color color)
@@ -392,8 +420,8 @@ void ColorPalette::updateRgbInput()
                 selectedIndex_ = -1;
                 
                 // Emit color changed events to apply the color
-                eventDispatcher_->emit<PrimaryColorChangedEvent>(PrimaryColorChangedEvent(primaryColor_));
-                eventDispatcher_->emit<ColorChangedEvent>(ColorChangedEvent(selectedColor_));
+                eventDispatcher_->post(PrimaryColorChangedEvent(primaryColor_));
+                eventDispatcher_->post(ColorChangedEvent(selectedColor_));
                 
                 rgbInputActive_[i] = false;
                 showRgbInput_ = false; // Close the window after applying
@@ -456,4 +484,167 @@ void ColorPalette::drawRgbInput() const
     DrawText("• Press ESCAPE or click X to cancel", static_cast<int>(rgbWindow_.x + 20), static_cast<int>(instructionY + 30), 10, LIGHTGRAY);
 }
 
-} // namespace EpiGimp
\ No newline at end of file
+void ColorPalette::toggleHsvPicker()
+{
+    showHsvPicker_ = !showHsvPicker_;
+    pickerDrag_ = 0;
+    
+    if (showHsvPicker_) {
+        pickerHsv_ = ColorSpace::toHsv(primaryColor_);
+        
+        float windowWidth = 360;
+        float windowHeight = 260;
+        float windowX = (GetScreenWidth() - windowWidth) / 2;
+        float windowY = (GetScreenHeight() - windowHeight) / 2;
+        
+        hsvWindow_ = {windowX, windowY, windowWidth, windowHeight};
+        hsvSquareRect_ = {windowX + 20, windowY + 45, 160, 160};
+        hsvHueRect_ = {windowX + 195, windowY + 45, 20, 160};
+        hsvPreviewRect_ = {windowX + 250, windowY + 65, 80, 60};
+        hsvApplyButton_ = {windowX + 250, windowY + 175, 80, 30};
+        hsvCloseButton_ = {windowX + windowWidth - 35, windowY + 5, 25, 25};
+        
+        refreshHsvTextures();
+    }
+}
+
+void ColorPalette::refreshHsvTextures()
+{
+    constexpr int SIZE = HSV_SQUARE_TEXELS;
+    
+    // Hue bar: once, top to bottom through the whole circle
+    if (!pickerHueBar_) {
+        std::vector<float> hue(SIZE), full(SIZE, 1.0f);
+        for (int y = 0; y < SIZE; ++y)
+            hue[y] = 360.0f * static_cast<float>(y) / SIZE;
+        Image bar = GenImageColor(1, SIZE, BLACK);
+        ColorSpace::hsvToRgb(hue.data(), full.data(), full.data(), SIZE, static_cast<uint8_t*>(bar.data));
+        pickerHueBar_ = TextureResource::fromImage(bar);
+        UnloadImage(bar);
+    }
+    
+    if (pickerSquare_ && pickerSquareHue_ == pickerHsv_.h)
+        return;
+    
+    // Saturation grows to the right, value towards the top
+    const size_t count = static_cast<size_t>(SIZE) * SIZE;
+    std::vector<float> hue(count, pickerHsv_.h), saturation(count), value(count);
+    for (int y = 0; y < SIZE; ++y) {
+        for (int x = 0; x < SIZE; ++x) {
+            saturation[y * SIZE + x] = static_cast<float>(x) / (SIZE - 1);
+            value[y * SIZE + x] = 1.0f - static_cast<float>(y) / (SIZE - 1);
+        }
+    }
+    Image square = GenImageColor(SIZE, SIZE, BLACK);   // Alpha is left as it is
+    ColorSpace::hsvToRgb(hue.data(), saturation.data(), value.data(), count, static_cast<uint8_t*>(square.data));
+    if (pickerSquare_)
+        UpdateTexture(**pickerSquare_, square.data);
+    else
+        pickerSquare_ = TextureResource::fromImage(square);
+    UnloadImage(square);
+    pickerSquareHue_ = pickerHsv_.h;
+}
+
+void ColorPalette::updateHsvPicker()
+{
+    const Vector2 mousePos = GetMousePosition();
+    
+    if (CheckCollisionPointRec(mousePos, hsvCloseButton_) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        showHsvPicker_ = false;
+        return;
+    }
+    if (IsKeyPressed(KEY_ESCAPE)) {
+        showHsvPicker_ = false;
+        return;
+    }
+    
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (CheckCollisionPointRec(mousePos, hsvSquareRect_))
+            pickerDrag_ = 1;
+        else if (CheckCollisionPointRec(mousePos, hsvHueRect_))
+            pickerDrag_ = 2;
+    }
+    if (!IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+        pickerDrag_ = 0;
+    
+    if (pickerDrag_ == 1) {
+        pickerHsv_.s = std::clamp((mousePos.x - hsvSquareRect_.x) / hsvSquareRect_.width, 0.0f, 1.0f);
+        pickerHsv_.v = std::clamp(1.0f - (mousePos.y - hsvSquareRect_.y) / hsvSquareRect_.height, 0.0f, 1.0f);
+    } else if (pickerDrag_ == 2) {
+        const float t = std::clamp((mousePos.y - hsvHueRect_.y) / hsvHueRect_.height, 0.0f, 1.0f);
+        pickerHsv_.h = std::fmod(360.0f * t, 360.0f);
+        refreshHsvTextures();
+    }
+    
+    const bool applyClicked = CheckCollisionPointRec(mousePos, hsvApplyButton_) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    if (applyClicked || IsKeyPressed(KEY_ENTER)) {
+        selectedColor_ = ColorSpace::fromHsv(pickerHsv_);
+        primaryColor_ = selectedColor_;
+        
+        // Reset palette selection indices since this is a custom color
+        primaryIndex_ = -1;
+        selectedIndex_ = -1;
+        
+        eventDispatcher_->post(PrimaryColorChangedEvent(primaryColor_));
+        eventDispatcher_->post(ColorChangedEvent(selectedColor_));
+        
+        showHsvPicker_ = false;
+    }
+}
+
+void ColorPalette::drawHsvPicker() const
+{
+    DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), Color{0, 0, 0, 100});
+    
+    DrawRectangleRec(hsvWindow_, Color{50, 50, 50, 255});
+    DrawRectangleLinesEx(hsvWindow_, 3, WHITE);
+    
+    DrawText("HSV Color Picker", static_cast<int>(hsvWindow_.x + 20), static_cast<int>(hsvWindow_.y + 15), 16, WHITE);
+    
+    DrawRectangleRec(hsvCloseButton_, Color{200, 50, 50, 255});
+    DrawRectangleLinesEx(hsvCloseButton_, 1, WHITE);
+    DrawText("X", static_cast<int>(hsvCloseButton_.x + 8), static_cast<int>(hsvCloseButton_.y + 5), 14, WHITE);
+    
+    if (pickerSquare_) {
+        const Texture2D& square = **pickerSquare_;
+        DrawTexturePro(square, Rectangle{0, 0, static_cast<float>(square.width), static_cast<float>(square.height)},
+                       hsvSquareRect_, Vector2{0, 0}, 0.0f, WHITE);
+    }
+    if (pickerHueBar_) {
+        const Texture2D& bar = **pickerHueBar_;
+        DrawTexturePro(bar, Rectangle{0, 0, static_cast<float>(bar.width), static_cast<float>(bar.height)},
+                       hsvHueRect_, Vector2{0, 0}, 0.0f, WHITE);
+    }
+    DrawRectangleLinesEx(hsvSquareRect_, 2, WHITE);
+    DrawRectangleLinesEx(hsvHueRect_, 2, WHITE);
+    
+    // Markers: a ring on the square, a bar across the hue strip
+    const Vector2 marker = {hsvSquareRect_.x + pickerHsv_.s * hsvSquareRect_.width,
+                            hsvSquareRect_.y + (1.0f - pickerHsv_.v) * hsvSquareRect_.height};
+    DrawCircleLines(static_cast<int>(marker.x), static_cast<int>(marker.y), 5, pickerHsv_.v > 0.5f ? BLACK : WHITE);
+    const float hueY = hsvHueRect_.y + pickerHsv_.h / 360.0f * hsvHueRect_.height;
+    DrawRectangleLinesEx(Rectangle{hsvHueRect_.x - 3, hueY - 2, hsvHueRect_.width + 6, 4}, 2, WHITE);
+    
+    const Color color = ColorSpace::fromHsv(pickerHsv_);
+    DrawRectangleRec(hsvPreviewRect_, color);
+    DrawRectangleLinesEx(hsvPreviewRect_, 3, WHITE);
+    DrawText("Preview", static_cast<int>(hsvPreviewRect_.x + 10), static_cast<int>(hsvPreviewRect_.y - 20), 12, WHITE);
+    
+    char hsvText[50];
+    sprintf(hsvText, "HSV(%d, %d%%, %d%%)", static_cast<int>(std::lround(pickerHsv_.h)) % 360,
+            static_cast<int>(std::lround(pickerHsv_.s * 100.0f)), static_cast<int>(std::lround(pickerHsv_.v * 100.0f)));
+    DrawText(hsvText, static_cast<int>(hsvPreviewRect_.x - 5), static_cast<int>(hsvPreviewRect_.y + hsvPreviewRect_.height + 10), 10, WHITE);
+    char rgbText[50];
+    sprintf(rgbText, "RGB(%d, %d, %d)", color.r, color.g, color.b);
+    DrawText(rgbText, static_cast<int>(hsvPreviewRect_.x - 5), static_cast<int>(hsvPreviewRect_.y + hsvPreviewRect_.height + 25), 10, WHITE);
+    
+    DrawRectangleRec(hsvApplyButton_, Color{50, 150, 50, 255});
+    DrawRectangleLinesEx(hsvApplyButton_, 1, WHITE);
+    DrawText("Apply", static_cast<int>(hsvApplyButton_.x + 22), static_cast<int>(hsvApplyButton_.y + 9), 12, WHITE);
+    
+    float instructionY = hsvWindow_.y + hsvWindow_.height - 40;
+    DrawText("• Drag in the square for saturation and value, on the strip for hue", static_cast<int>(hsvWindow_.x + 20), static_cast<int>(instructionY), 10, LIGHTGRAY);
+    DrawText("• ENTER or Apply to use the color, ESCAPE or X to cancel", static_cast<int>(hsvWindow_.x + 20), static_cast<int>(instructionY + 15), 10, LIGHTGRAY);
+}
+
+} // namespace EpiGimp
@@ -12,9 +12,9 @@ Toolbar::Toolbar(Rectangle bounds, EventDispatcher* dispatcher)
         throw std::invalid_argument("EventDispatcher cannot be null");
 
     // Subscribe to tool selection events
-    dispatcher->subscribe<ToolSelectedEvent>([this](const ToolSelectedEvent& event) {
+    subscriptions_.push_back(dispatcher->subscribeScoped<ToolSelectedEvent>([this](const ToolSelectedEvent& event) {
         setSelectedTool(event.toolType);
-    });
+    }));
 
     const float paletteWidth = 8 * (20 + 2) + 2 * 5; // 8 colors per row + padding = 186 pixels
     const float paletteHeight = bounds.height - 10; // Leave some padding
@@ -146,6 +146,14 @@ void Toolbar::setSelectedTool(DrawingTool tool)
             button->isSelected = (tool == DrawingTool::Mirror);
         } else if (button->text == "Eyedropper") {
             button->isSelected = (tool == DrawingTool::Eyedropper);
+        } else if (button->text == "Fill") {
+            button->isSelected = (tool == DrawingTool::Fill);
+        } else if (button->text == "Magic Wand") {
+            button->isSelected = (tool == DrawingTool::MagicWand);
+        } else if (button->text == "Lasso") {
+            button->isSelected = (tool == DrawingTool::Lasso);
+        } else if (button->text == "Polygon Select") {
+            button->isSelected = (tool == DrawingTool::Polygon);
         } else if (button->text == "Blur") {
             button->isSelected = (tool == DrawingTool::Blur);
         } else if (button->text == "Burn") {
@@ -165,6 +173,10 @@ void Toolbar::setSelectedTool(DrawingTool tool)
     else if (tool == DrawingTool::Select) toolName = "Select";
     else if (tool == DrawingTool::Mirror) toolName = "Mirror";
     else if (tool == DrawingTool::Eyedropper) toolName = "Eyedropper";
+    else if (tool == DrawingTool::Fill) toolName = "Fill";
+    else if (tool == DrawingTool::MagicWand) toolName = "Magic Wand";
+    else if (tool == DrawingTool::Lasso) toolName = "Lasso";
+    else if (tool == DrawingTool::Polygon) toolName = "Polygon Select";
     else if (tool == DrawingTool::Blur) toolName = "Blur";
     else if (tool == DrawingTool::Burn) toolName = "Burn";
     else if (tool == DrawingTool::Dodge) toolName = "Dodge";
@@ -0,0 +1,309 @@
+//Background image decoding with incremental texture upload
+#include "../../include/Utils/AsyncImageLoader.hpp"
+#include "../../include/Utils/StreamingDecoder.hpp"
+#include "rlgl.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace EpiGimp {
+
+namespace {
+
+enum LoadStage {
+    STAGE_IDLE = 0,
+    STAGE_DECODING,
+    STAGE_CONVERTING,
+    STAGE_RESIZING,
+    STAGE_UPLOADING
+};
+
+// Share of the progress bar given to the worker side, the rest is the upload
+constexpr float DECODE_SHARE = 0.7f;
+
+const char* stageName(int stage)
+{
+    switch (stage) {
+        case STAGE_DECODING: return "Decoding";
+        case STAGE_CONVERTING: return "Converting";
+        case STAGE_RESIZING: return "Resizing";
+        case STAGE_UPLOADING: return "Uploading";
+        default: return "Idle";
+    }
+}
+
+} // namespace
+
+AsyncImageLoader::AsyncImageLoader(EventDispatcher* dispatcher, size_t uploadBudget)
+    : eventDispatcher_(dispatcher), uploadBudget_(uploadBudget > 0 ? uploadBudget : 1), stopping_(false),
+      latestRequestId_(0), progressRequestId_(0), decodeProgress_(0.0f), decodeStage_(STAGE_IDLE),
+      progress_(0.0f), lastPublishedStage_(STAGE_IDLE), lastPublishedPercent_(-1)
+{
+    if (!dispatcher)
+        throw std::invalid_argument("EventDispatcher cannot be null");
+
+    worker_ = std::thread(&AsyncImageLoader::workerLoop, this);
+}
+
+AsyncImageLoader::~AsyncImageLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        latestRequestId_++;
+    }
+    wakeWorker_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+
+    if (decoded_ && decoded_->image.data)
+        UnloadImage(decoded_->image);
+    discardUpload();
+}
+
+void AsyncImageLoader::requestLoad(const std::string& filePath, int maxWidth, int maxHeight)
+{
+    discardUpload();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint64_t id = ++latestRequestId_;
+        pendingRequest_ = Request{id, filePath, maxWidth, maxHeight};
+    }
+    wakeWorker_.notify_one();
+
+    currentPath_ = filePath;
+    progress_ = 0.0f;
+    lastPublishedStage_ = STAGE_IDLE;
+    lastPublishedPercent_ = -1;
+    publishProgress(STAGE_DECODING, 0.0f);
+
+    std::cout << "AsyncImageLoader: Queued " << filePath << std::endl;
+}
+
+void AsyncImageLoader::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latestRequestId_++;
+        pendingRequest_.reset();
+    }
+    discardUpload();
+    currentPath_.clear();
+    progress_ = 0.0f;
+}
+
+bool AsyncImageLoader::isBusy() const
+{
+    return !currentPath_.empty();
+}
+
+std::optional<AsyncImageLoader::LoadResult> AsyncImageLoader::update()
+{
+    if (!isBusy())
+        return std::nullopt;
+
+    if (!upload_) {
+        std::optional<DecodeResult> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result.swap(decoded_);
+        }
+
+        if (!result) {
+            // Still decoding: forward the worker's progress
+            if (progressRequestId_.load() == latestRequestId_.load())
+                publishProgress(decodeStage_.load(), decodeProgress_.load() * DECODE_SHARE);
+            return std::nullopt;
+        }
+
+        if (isStale(result->id)) {
+            if (result->image.data)
+                UnloadImage(result->image);
+            return std::nullopt;
+        }
+
+        if (!result->error.empty()) {
+            LoadResult failed{result->filePath, std::nullopt, result->error};
+            currentPath_.clear();
+            progress_ = 0.0f;
+            return failed;
+        }
+
+        std::string filePath = result->filePath;
+        if (!beginUpload(std::move(*result))) {
+            currentPath_.clear();
+            progress_ = 0.0f;
+            return LoadResult{filePath, std::nullopt, "Failed to create texture for: " + filePath};
+        }
+    }
+
+    if (!continueUpload())
+        return std::nullopt;
+
+    // Upload finished: hand the texture over to the caller
+    LoadResult done{upload_->filePath, TextureResource(upload_->texture), ""};
+    UnloadImage(upload_->image);
+    upload_.reset();
+    currentPath_.clear();
+    progress_ = 1.0f;
+    return done;
+}
+
+void AsyncImageLoader::workerLoop()
+{
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeWorker_.wait(lock, [this] { return stopping_ || pendingRequest_.has_value(); });
+            if (stopping_)
+                return;
+            request = std::move(*pendingRequest_);
+            pendingRequest_.reset();
+        }
+
+        DecodeResult result = decode(request);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (isStale(result.id) || stopping_) {
+            if (result.image.data)
+                UnloadImage(result.image);
+            continue;
+        }
+        if (decoded_ && decoded_->image.data)
+            UnloadImage(decoded_->image);
+        decoded_ = std::move(result);
+    }
+}
+
+AsyncImageLoader::DecodeResult AsyncImageLoader::decode(const Request& request)
+{
+    DecodeResult result{request.id, request.filePath, Image{}, ""};
+
+    reportDecodeProgress(request.id, STAGE_DECODING, 0.0f);
+
+    // PNG and BMP rows are averaged down while they are decoded, so a huge file never
+    // exists at full size in memory
+    if (auto streaming = StreamingDecoder::open(request.filePath)) {
+        result.image = StreamingDecoder::decode(*streaming, request.maxWidth, request.maxHeight,
+            [this, &request](float progress) {
+                reportDecodeProgress(request.id, STAGE_DECODING, progress);
+                return !isStale(request.id);
+            });
+        if (!result.image.data && !isStale(request.id))
+            result.error = "Failed to load image: " + request.filePath;
+        return result;
+    }
+
+    Image image = ImageResource::loadFile(request.filePath);
+    if (!image.data) {
+        result.error = "Failed to load image: " + request.filePath;
+        return result;
+    }
+
+    // Bail out between stages if a newer request came in
+    if (isStale(request.id)) {
+        UnloadImage(image);
+        return result;
+    }
+
+    reportDecodeProgress(request.id, STAGE_CONVERTING, 0.6f);
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    if (isStale(request.id)) {
+        UnloadImage(image);
+        return result;
+    }
+
+    if (request.maxWidth > 0 && request.maxHeight > 0 &&
+        (image.width > request.maxWidth || image.height > request.maxHeight)) {
+        reportDecodeProgress(request.id, STAGE_RESIZING, 0.8f);
+
+        const float widthRatio = static_cast<float>(request.maxWidth) / image.width;
+        const float heightRatio = static_cast<float>(request.maxHeight) / image.height;
+        const float scale = std::min(widthRatio, heightRatio);
+
+        const int newWidth = std::max(1, static_cast<int>(image.width * scale));
+        const int newHeight = std::max(1, static_cast<int>(image.height * scale));
+        ImageResize(&image, newWidth, newHeight);
+        std::cout << "AsyncImageLoader: Image resized to: " << newWidth << "x" << newHeight << std::endl;
+    }
+
+    reportDecodeProgress(request.id, STAGE_RESIZING, 1.0f);
+    result.image = image;
+    return result;
+}
+
+void AsyncImageLoader::reportDecodeProgress(uint64_t requestId, int stage, float progress)
+{
+    decodeStage_.store(stage);
+    decodeProgress_.store(progress);
+    progressRequestId_.store(requestId);
+}
+
+void AsyncImageLoader::publishProgress(int stage, float progress)
+{
+    progress_ = progress;
+
+    // Only publish whole-percent changes to keep the event traffic low
+    const int percent = static_cast<int>(progress * 100.0f);
+    if (stage == lastPublishedStage_ && percent == lastPublishedPercent_)
+        return;
+
+    lastPublishedStage_ = stage;
+    lastPublishedPercent_ = percent;
+    eventDispatcher_->emit<ImageLoadProgressEvent>(currentPath_, stageName(stage), progress);
+}
+
+bool AsyncImageLoader::beginUpload(DecodeResult&& result)
+{
+    Texture2D texture{};
+    texture.id = rlLoadTexture(nullptr, result.image.width, result.image.height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    if (texture.id == 0) {
+        UnloadImage(result.image);
+        return false;
+    }
+
+    texture.width = result.image.width;
+    texture.height = result.image.height;
+    texture.mipmaps = 1;
+    texture.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+    upload_ = Upload{result.id, std::move(result.filePath), result.image, texture, 0};
+    std::cout << "AsyncImageLoader: Uploading " << texture.width << "x" << texture.height
+              << " in bands of up to " << uploadBudget_ << " bytes per frame" << std::endl;
+    return true;
+}
+
+bool AsyncImageLoader::continueUpload()
+{
+    Upload& upload = *upload_;
+    const int width = upload.image.width;
+    const int height = upload.image.height;
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const int rowsPerFrame = std::max(1, static_cast<int>(uploadBudget_ / rowBytes));
+
+    const int rows = std::min(rowsPerFrame, height - upload.nextRow);
+    const unsigned char* pixels = static_cast<const unsigned char*>(upload.image.data) + upload.nextRow * rowBytes;
+    UpdateTextureRec(upload.texture,
+                     Rectangle{0, static_cast<float>(upload.nextRow), static_cast<float>(width), static_cast<float>(rows)},
+                     pixels);
+    upload.nextRow += rows;
+
+    publishProgress(STAGE_UPLOADING, DECODE_SHARE + (1.0f - DECODE_SHARE) * upload.nextRow / height);
+    return upload.nextRow >= height;
+}
+
+void AsyncImageLoader::discardUpload()
+{
+    if (!upload_)
+        return;
+
+    UnloadTexture(upload_->texture);
+    UnloadImage(upload_->image);
+    upload_.reset();
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,751 @@
+//Periodic autosave: full checkpoints plus a journal of dirty tiles
+#include "../../include/Utils/Autosaver.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr uint32_t RECORD_MAGIC = 0x524A5045;  // "EPJR"
+
+enum RecordType : uint32_t {
+    RECORD_BASE = 1,        // Layer ids of the checkpoint, in file order
+    RECORD_STRUCTURE = 2,   // Layer list after a delta: order, flags and names
+    RECORD_TILE = 3,        // One replaced tile
+    RECORD_COMMIT = 4       // Everything since the previous commit is complete
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t size;
+    uint32_t checksum;
+};
+
+constexpr uint64_t BACKGROUND_ID = 0;
+
+// One layer as the journal sees it, background first then bottom to top like project files
+struct LayerEntry {
+    uint64_t id;
+    uint32_t flags;
+    std::string name;
+    const Image* pixels;
+};
+
+std::vector<LayerEntry> describeLayers(const DocumentSnapshot& snapshot)
+{
+    std::vector<LayerEntry> entries;
+    if (snapshot.getBackground()) {
+        uint32_t flags = ProjectFile::LAYER_BACKGROUND;
+        if (snapshot.isBackgroundVisible())
+            flags |= ProjectFile::LAYER_VISIBLE;
+        entries.push_back(LayerEntry{BACKGROUND_ID, flags, "Background", snapshot.getBackground().get()});
+    }
+
+    uint64_t ordinal = 0;
+    for (const auto& layer : snapshot.getLayers()) {
+        uint32_t flags = 0;
+        if (layer.visible) flags |= ProjectFile::LAYER_VISIBLE;
+        if (layer.flippedVertical) flags |= ProjectFile::LAYER_FLIPPED_VERTICAL;
+        if (layer.flippedHorizontal) flags |= ProjectFile::LAYER_FLIPPED_HORIZONTAL;
+        // Layers without an identity are told apart by position only
+        const uint64_t id = layer.id != 0 ? layer.id : ((1ull << 63) | ordinal);
+        entries.push_back(LayerEntry{id, flags, layer.name, layer.pixels.get()});
+        ordinal++;
+    }
+    return entries;
+}
+
+bool sameStructure(const std::vector<LayerEntry>& a, const std::vector<LayerEntry>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].id != b[i].id || a[i].flags != b[i].flags || a[i].name != b[i].name)
+            return false;
+    }
+    return true;
+}
+
+// Flush a file or directory to disk; directories so that new entries in them survive too
+bool syncPath(const std::string& path)
+{
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    const bool ok = fsync(descriptor) == 0;
+    close(descriptor);
+    return ok;
+}
+
+template<typename T>
+void put(std::vector<uint8_t>& buffer, const T& value)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+bool get(const std::vector<uint8_t>& buffer, size_t& cursor, T& value)
+{
+    if (cursor + sizeof(T) > buffer.size())
+        return false;
+    std::memcpy(&value, buffer.data() + cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+std::vector<uint8_t> encodeStructure(const DocumentSnapshot& snapshot, int tileSize, const std::vector<LayerEntry>& entries)
+{
+    std::vector<uint8_t> payload;
+    put(payload, static_cast<uint32_t>(snapshot.getWidth()));
+    put(payload, static_cast<uint32_t>(snapshot.getHeight()));
+    put(payload, static_cast<uint32_t>(tileSize));
+    put(payload, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        put(payload, entry.id);
+        put(payload, entry.flags);
+        put(payload, static_cast<uint32_t>(entry.name.size()));
+        payload.insert(payload.end(), entry.name.begin(), entry.name.end());
+    }
+    return payload;
+}
+
+// Copy a tile out of a top-down RGBA8 image; pixels outside the image are transparent
+void extractTile(const Image* image, const Rectangle& rect, std::vector<uint8_t>& tile)
+{
+    const int width = static_cast<int>(rect.width);
+    const int height = static_cast<int>(rect.height);
+    const int x0 = static_cast<int>(rect.x);
+    const int y0 = static_cast<int>(rect.y);
+    tile.assign(static_cast<size_t>(width) * height * 4, 0);
+    if (!image || !image->data)
+        return;
+
+    const int copyWidth = std::max(0, std::min(width, image->width - x0));
+    const int copyHeight = std::max(0, std::min(height, image->height - y0));
+    const auto* source = static_cast<const uint8_t*>(image->data);
+    for (int y = 0; y < copyHeight; ++y) {
+        std::memcpy(tile.data() + static_cast<size_t>(y) * width * 4,
+                    source + (static_cast<size_t>(y0 + y) * image->width + x0) * 4,
+                    static_cast<size_t>(copyWidth) * 4);
+    }
+}
+
+// Compare a tile in place; a missing image counts as fully transparent
+bool tileDiffers(const Image* before, const Image* after, const Rectangle& rect)
+{
+    if (!after || !after->data)
+        return before && before->data;
+
+    const int x0 = static_cast<int>(rect.x);
+    const int y0 = static_cast<int>(rect.y);
+    const size_t rowBytes = static_cast<size_t>(rect.width) * 4;
+    const auto* afterPixels = static_cast<const uint8_t*>(after->data);
+    const auto* beforePixels = before && before->data ? static_cast<const uint8_t*>(before->data) : nullptr;
+
+    for (int y = y0; y < y0 + static_cast<int>(rect.height); ++y) {
+        const size_t offset = (static_cast<size_t>(y) * after->width + x0) * 4;
+        if (beforePixels) {
+            if (std::memcmp(beforePixels + offset, afterPixels + offset, rowBytes) != 0)
+                return true;
+        } else {
+            for (size_t i = 3; i < rowBytes; i += 4) {
+                if (afterPixels[offset + i] != 0)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool isTransparent(const std::vector<uint8_t>& tile)
+{
+    for (size_t i = 3; i < tile.size(); i += 4) {
+        if (tile[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+Rectangle tileRect(int tileX, int tileY, int tileSize, int width, int height)
+{
+    const int x0 = tileX * tileSize;
+    const int y0 = tileY * tileSize;
+    return Rectangle{static_cast<float>(x0), static_cast<float>(y0),
+                     static_cast<float>(std::min(tileSize, width - x0)),
+                     static_cast<float>(std::min(tileSize, height - y0))};
+}
+
+// Mutable document rebuilt during recovery
+struct RecoveredLayer {
+    uint64_t id;
+    uint32_t flags;
+    std::string name;
+    Image pixels;
+};
+
+struct RecoveredDocument {
+    int width = 0;
+    int height = 0;
+    int tileSize = ProjectFile::DEFAULT_TILE_SIZE;
+    std::vector<RecoveredLayer> layers;
+
+    ~RecoveredDocument() {
+        for (auto& layer : layers) {
+            if (layer.pixels.data)
+                UnloadImage(layer.pixels);
+        }
+    }
+
+    RecoveredLayer* find(uint64_t id) {
+        for (auto& layer : layers) {
+            if (layer.id == id)
+                return &layer;
+        }
+        return nullptr;
+    }
+
+    bool applyStructure(const std::vector<uint8_t>& payload, bool assignIds) {
+        size_t cursor = 0;
+        uint32_t width = 0, height = 0, tileSize = 0, count = 0;
+        if (!get(payload, cursor, width) || !get(payload, cursor, height) ||
+            !get(payload, cursor, tileSize) || !get(payload, cursor, count))
+            return false;
+        if (static_cast<int>(width) != this->width || static_cast<int>(height) != this->height || tileSize == 0)
+            return false;
+        this->tileSize = static_cast<int>(tileSize);
+
+        std::vector<RecoveredLayer> next;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint64_t id = 0;
+            uint32_t flags = 0, nameLength = 0;
+            if (!get(payload, cursor, id) || !get(payload, cursor, flags) || !get(payload, cursor, nameLength) ||
+                cursor + nameLength > payload.size())
+                return false;
+            std::string name(reinterpret_cast<const char*>(payload.data() + cursor), nameLength);
+            cursor += nameLength;
+
+            RecoveredLayer layer{id, flags, std::move(name), Image{}};
+            // The base record names the checkpoint layers in file order
+            RecoveredLayer* existing = assignIds ? (i < layers.size() ? &layers[i] : nullptr) : find(id);
+            if (existing) {
+                layer.pixels = existing->pixels;
+                existing->pixels = Image{};
+            } else {
+                layer.pixels = GenImageColor(this->width, this->height, BLANK);
+            }
+            next.push_back(std::move(layer));
+        }
+
+        for (auto& layer : layers) {
+            if (layer.pixels.data)
+                UnloadImage(layer.pixels);
+        }
+        layers = std::move(next);
+        return true;
+    }
+
+    bool applyTile(const std::vector<uint8_t>& payload) {
+        size_t cursor = 0;
+        uint64_t id = 0;
+        uint32_t tileX = 0, tileY = 0, dataSize = 0;
+        if (!get(payload, cursor, id) || !get(payload, cursor, tileX) || !get(payload, cursor, tileY) ||
+            !get(payload, cursor, dataSize) || cursor + dataSize > payload.size())
+            return false;
+
+        RecoveredLayer* layer = find(id);
+        if (!layer)
+            return false;
+
+        const Rectangle rect = tileRect(static_cast<int>(tileX), static_cast<int>(tileY), tileSize, width, height);
+        if (rect.width <= 0 || rect.height <= 0)
+            return false;
+        const size_t rowBytes = static_cast<size_t>(rect.width) * 4;
+        std::vector<uint8_t> tile(rowBytes * static_cast<size_t>(rect.height), 0);
+        if (dataSize > 0 && !ProjectFile::decompressTile(payload.data() + cursor, dataSize, tile.size(), tile))
+            return false;
+
+        auto* target = static_cast<uint8_t*>(layer->pixels.data);
+        for (int y = 0; y < static_cast<int>(rect.height); ++y) {
+            std::memcpy(target + ((static_cast<size_t>(rect.y) + y) * width + static_cast<size_t>(rect.x)) * 4,
+                        tile.data() + y * rowBytes, rowBytes);
+        }
+        return true;
+    }
+
+    DocumentSnapshot toSnapshot() {
+        DocumentSnapshot snapshot(width, height);
+        for (auto& layer : layers) {
+            const bool visible = (layer.flags & ProjectFile::LAYER_VISIBLE) != 0;
+            if (layer.flags & ProjectFile::LAYER_BACKGROUND) {
+                snapshot.setBackground(makeSharedPixels(layer.pixels), visible);
+            } else {
+                LayerSnapshot result(makeSharedPixels(layer.pixels));
+                result.visible = visible;
+                result.flippedVertical = (layer.flags & ProjectFile::LAYER_FLIPPED_VERTICAL) != 0;
+                result.flippedHorizontal = (layer.flags & ProjectFile::LAYER_FLIPPED_HORIZONTAL) != 0;
+                result.name = layer.name;
+                result.id = layer.id;
+                snapshot.addLayer(std::move(result));
+            }
+            layer.pixels = Image{};  // Now owned by the snapshot
+        }
+        return snapshot;
+    }
+};
+
+} // namespace
+
+Autosaver::RateLimiter::RateLimiter(size_t bytesPerSecond)
+    : bytesPerSecond_(bytesPerSecond), tokens_(static_cast<double>(bytesPerSecond)),
+      lastRefill_(std::chrono::steady_clock::now())
+{
+}
+
+void Autosaver::RateLimiter::consume(size_t bytes)
+{
+    if (bytesPerSecond_ == 0)
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - lastRefill_).count();
+    lastRefill_ = now;
+    tokens_ = std::min(static_cast<double>(bytesPerSecond_), tokens_ + elapsed * bytesPerSecond_);
+
+    tokens_ -= static_cast<double>(bytes);
+    if (tokens_ < 0) {
+        // Pay the debt now so a burst cannot exceed the rate
+        std::this_thread::sleep_for(std::chrono::duration<double>(-tokens_ / bytesPerSecond_));
+        tokens_ = 0;
+        lastRefill_ = std::chrono::steady_clock::now();
+    }
+}
+
+Autosaver::Autosaver(SnapshotProvider provider, AutosaveSettings settings)
+    : provider_(std::move(provider)), settings_(std::move(settings)), elapsed_(0.0f),
+      stopping_(false), saving_(false), rateLimiter_(settings_.maxBytesPerSecond),
+      generation_(0), checkpointBytes_(0), journalBytes_(0), sequence_(0), journal_(nullptr)
+{
+    if (!provider_)
+        throw std::invalid_argument("Snapshot provider cannot be empty");
+
+    std::error_code error;
+    std::filesystem::create_directories(settings_.directory, error);
+    if (error)
+        std::cerr << "Autosaver: Cannot create " << settings_.directory << ": " << error.message() << std::endl;
+
+    // Never reuse the number of files left behind by an earlier session
+    generation_ = latestGeneration(settings_.directory).value_or(0);
+
+    worker_ = std::thread(&Autosaver::workerLoop, this);
+}
+
+Autosaver::~Autosaver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeWorker_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+    closeJournal();
+}
+
+void Autosaver::update(float deltaTime)
+{
+    if (settings_.intervalSeconds <= 0.0f)
+        return;
+
+    elapsed_ += deltaTime;
+    if (elapsed_ < settings_.intervalSeconds)
+        return;
+
+    elapsed_ = 0.0f;
+    saveNow();
+}
+
+void Autosaver::saveNow()
+{
+    // Do not pile up snapshots behind a slow, throttled write
+    if (isBusy())
+        return;
+
+    DocumentSnapshot snapshot = provider_();
+    if (snapshot.isEmpty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::move(snapshot);
+    }
+    wakeWorker_.notify_one();
+}
+
+void Autosaver::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return !saving_ && !pending_; });
+}
+
+bool Autosaver::isBusy() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return saving_ || pending_.has_value();
+}
+
+Autosaver::Stats Autosaver::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void Autosaver::discard()
+{
+    waitForIdle();
+    closeJournal();
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(settings_.directory, error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("checkpoint-", 0) == 0 || name.rfind("journal-", 0) == 0)
+            std::filesystem::remove(entry.path(), error);
+    }
+    lastSaved_.reset();
+    std::cout << "Autosaver: Discarded autosave state" << std::endl;
+}
+
+void Autosaver::workerLoop()
+{
+    while (true) {
+        DocumentSnapshot snapshot;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeWorker_.wait(lock, [this] { return stopping_ || pending_.has_value(); });
+            if (stopping_)
+                return;
+            snapshot = std::move(*pending_);
+            pending_.reset();
+            saving_ = true;
+        }
+
+        persist(snapshot);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            saving_ = false;
+        }
+        idle_.notify_all();
+    }
+}
+
+void Autosaver::persist(const DocumentSnapshot& snapshot)
+{
+    const bool sizeChanged = lastSaved_ &&
+        (lastSaved_->getWidth() != snapshot.getWidth() || lastSaved_->getHeight() != snapshot.getHeight());
+    const bool journalTooLarge = journalBytes_ > static_cast<uint64_t>(checkpointBytes_ * settings_.checkpointRatio);
+
+    size_t tilesWritten = 0;
+    const uint64_t previousSequence = sequence_;
+    bool checkpoint = !lastSaved_ || !journal_ || sizeChanged || journalTooLarge;
+    if (!checkpoint && !writeDelta(snapshot, tilesWritten))
+        checkpoint = true;
+
+    if (checkpoint && !writeCheckpoint(snapshot)) {
+        std::cerr << "Autosaver: Checkpoint failed, keeping previous autosave" << std::endl;
+        return;
+    }
+
+    lastSaved_ = snapshot;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (checkpoint) {
+        stats_.checkpoints++;
+        stats_.lastTilesWritten = 0;
+    } else if (sequence_ != previousSequence) {
+        stats_.deltas++;
+        stats_.lastTilesWritten = tilesWritten;
+    }
+}
+
+bool Autosaver::writeCheckpoint(const DocumentSnapshot& snapshot)
+{
+    const uint64_t previousGeneration = generation_;
+    const uint64_t generation = generation_ + 1;
+    const std::string checkpoint = checkpointPath(settings_.directory, generation);
+
+    uint64_t written = 0;
+    const bool ok = ProjectFile::write(snapshot, checkpoint, settings_.tileSize, [&](size_t bytes) {
+        rateLimiter_.consume(bytes);
+        written += bytes;
+    });
+    if (!ok)
+        return false;
+
+    closeJournal();
+    journal_ = std::fopen(journalPath(settings_.directory, generation).c_str(), "wb");
+    generation_ = generation;
+    journalBytes_ = 0;
+    std::error_code error;
+    checkpointBytes_ = std::filesystem::file_size(checkpoint, error);
+
+    bool durable = syncPath(checkpoint);
+    if (journal_ && appendRecord(RECORD_BASE, encodeStructure(snapshot, settings_.tileSize, describeLayers(snapshot)))) {
+        std::fflush(journal_);
+        durable = fsync(fileno(journal_)) == 0 && durable;
+    } else {
+        durable = false;
+    }
+    durable = syncPath(settings_.directory) && durable;
+
+    // The old generation is the only one recovery can trust until the new one is on disk
+    if (previousGeneration > 0 && durable)
+        removeGeneration(previousGeneration);
+    else if (previousGeneration > 0)
+        std::cerr << "Autosaver: Could not sync checkpoint " << generation << ", keeping generation " << previousGeneration << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.bytesWritten += written;
+    }
+    std::cout << "Autosaver: Checkpoint " << generation << " written (" << checkpointBytes_ << " bytes)" << std::endl;
+    return true;
+}
+
+bool Autosaver::writeDelta(const DocumentSnapshot& snapshot, size_t& tilesWritten)
+{
+    const std::vector<LayerEntry> previous = describeLayers(*lastSaved_);
+    const std::vector<LayerEntry> current = describeLayers(snapshot);
+    const int width = snapshot.getWidth();
+    const int height = snapshot.getHeight();
+    const int tileSize = settings_.tileSize;
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+
+    bool wroteSomething = false;
+    if (!sameStructure(previous, current)) {
+        if (!appendRecord(RECORD_STRUCTURE, encodeStructure(snapshot, tileSize, current)))
+            return false;
+        wroteSomething = true;
+    }
+
+    struct BandTile {
+        bool changed = false;
+        bool ok = true;
+        std::vector<uint8_t> compressed;
+    };
+    std::vector<BandTile> band(static_cast<size_t>(tilesX));
+    std::vector<uint8_t> payload;
+
+    for (const auto& entry : current) {
+        auto match = std::find_if(previous.begin(), previous.end(), [&](const LayerEntry& old) { return old.id == entry.id; });
+        const Image* oldPixels = match != previous.end() ? match->pixels : nullptr;
+
+        // Copy-on-write snapshots share untouched layers, nothing to compare
+        if (match != previous.end() && oldPixels == entry.pixels)
+            continue;
+
+        for (int ty = 0; ty < tilesY; ++ty) {
+            // Compare and compress a row of tiles on the job system, then append them in order
+            JobSystem::shared().parallelFor(band.size(), [&](size_t begin, size_t end) {
+                std::vector<uint8_t> newTile;
+                for (size_t tx = begin; tx < end; ++tx) {
+                    BandTile& tile = band[tx];
+                    const Rectangle rect = tileRect(static_cast<int>(tx), ty, tileSize, width, height);
+                    tile.compressed.clear();
+                    tile.changed = tileDiffers(oldPixels, entry.pixels, rect);
+                    if (!tile.changed)
+                        continue;
+                    extractTile(entry.pixels, rect, newTile);
+                    tile.ok = isTransparent(newTile) || ProjectFile::compressTile(newTile, tile.compressed);
+                }
+            });
+
+            for (int tx = 0; tx < tilesX; ++tx) {
+                const BandTile& tile = band[static_cast<size_t>(tx)];
+                if (!tile.changed)
+                    continue;
+                if (!tile.ok)
+                    return false;
+                const std::vector<uint8_t>& compressed = tile.compressed;
+
+                payload.clear();
+                put(payload, entry.id);
+                put(payload, static_cast<uint32_t>(tx));
+                put(payload, static_cast<uint32_t>(ty));
+                put(payload, static_cast<uint32_t>(compressed.size()));
+                payload.insert(payload.end(), compressed.begin(), compressed.end());
+                if (!appendRecord(RECORD_TILE, payload))
+                    return false;
+                tilesWritten++;
+                wroteSomething = true;
+            }
+        }
+    }
+
+    if (!wroteSomething)
+        return true;
+
+    payload.clear();
+    put(payload, ++sequence_);
+    if (!appendRecord(RECORD_COMMIT, payload))
+        return false;
+
+    // A commit is only a promise once it is on disk
+    std::fflush(journal_);
+    fsync(fileno(journal_));
+    return true;
+}
+
+bool Autosaver::appendRecord(uint32_t type, const std::vector<uint8_t>& payload)
+{
+    if (!journal_)
+        return false;
+
+    RecordHeader header{RECORD_MAGIC, type, static_cast<uint32_t>(payload.size()),
+                        static_cast<uint32_t>(crc32(0L, payload.data(), static_cast<uInt>(payload.size())))};
+
+    const size_t bytes = sizeof(header) + payload.size();
+    rateLimiter_.consume(bytes);
+    if (std::fwrite(&header, sizeof(header), 1, journal_) != 1 ||
+        (!payload.empty() && std::fwrite(payload.data(), payload.size(), 1, journal_) != 1))
+        return false;
+
+    journalBytes_ += bytes;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytesWritten += bytes;
+    return true;
+}
+
+void Autosaver::closeJournal()
+{
+    if (!journal_)
+        return;
+    std::fclose(journal_);
+    journal_ = nullptr;
+}
+
+void Autosaver::removeGeneration(uint64_t generation)
+{
+    std::error_code error;
+    std::filesystem::remove(checkpointPath(settings_.directory, generation), error);
+    std::filesystem::remove(journalPath(settings_.directory, generation), error);
+}
+
+std::string Autosaver::checkpointPath(const std::string& directory, uint64_t generation)
+{
+    return (std::filesystem::path(directory) / ("checkpoint-" + std::to_string(generation) + ProjectFile::EXTENSION)).string();
+}
+
+std::string Autosaver::journalPath(const std::string& directory, uint64_t generation)
+{
+    return (std::filesystem::path(directory) / ("journal-" + std::to_string(generation) + ".epj")).string();
+}
+
+std::optional<uint64_t> Autosaver::latestGeneration(const std::string& directory)
+{
+    std::optional<uint64_t> latest;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        const std::string name = entry.path().filename().string();
+        const std::string prefix = "checkpoint-";
+        if (name.rfind(prefix, 0) != 0 || entry.path().extension() != ProjectFile::EXTENSION)
+            continue;
+
+        try {
+            const uint64_t generation = std::stoull(name.substr(prefix.size()));
+            if (!latest || generation > *latest)
+                latest = generation;
+        } catch (const std::exception&) {
+            // Not one of ours
+        }
+    }
+    return latest;
+}
+
+bool Autosaver::hasRecoverableState(const std::string& directory)
+{
+    return latestGeneration(directory).has_value();
+}
+
+std::optional<DocumentSnapshot> Autosaver::recover(const std::string& directory)
+{
+    const auto generation = latestGeneration(directory);
+    if (!generation)
+        return std::nullopt;
+
+    std::string error;
+    auto reader = ProjectReader::open(checkpointPath(directory, *generation), &error);
+    if (!reader) {
+        std::cerr << "Autosaver: " << error << std::endl;
+        return std::nullopt;
+    }
+
+    RecoveredDocument document;
+    document.width = reader->getWidth();
+    document.height = reader->getHeight();
+    document.tileSize = reader->getTileSize();
+    for (size_t i = 0; i < reader->getLayerCount(); ++i) {
+        const ProjectReader::LayerInfo& info = reader->getLayerInfo(i);
+        uint32_t flags = 0;
+        if (info.visible) flags |= ProjectFile::LAYER_VISIBLE;
+        if (info.flippedVertical) flags |= ProjectFile::LAYER_FLIPPED_VERTICAL;
+        if (info.flippedHorizontal) flags |= ProjectFile::LAYER_FLIPPED_HORIZONTAL;
+        if (info.isBackground) flags |= ProjectFile::LAYER_BACKGROUND;
+
+        Image pixels = reader->decodeLayer(i);
+        if (!pixels.data)
+            return std::nullopt;
+        document.layers.push_back(RecoveredLayer{info.isBackground ? BACKGROUND_ID : (1ull << 63) | i, flags, info.name, pixels});
+    }
+
+    size_t commits = 0;
+    std::FILE* journal = std::fopen(journalPath(directory, *generation).c_str(), "rb");
+    if (journal) {
+        // Records are applied a commit at a time; a torn or corrupt tail is dropped
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> uncommitted;
+        RecordHeader header{};
+        while (std::fread(&header, sizeof(header), 1, journal) == 1) {
+            if (header.magic != RECORD_MAGIC)
+                break;
+            std::vector<uint8_t> payload(header.size);
+            if (header.size > 0 && std::fread(payload.data(), header.size, 1, journal) != 1)
+                break;
+            if (crc32(0L, payload.data(), static_cast<uInt>(payload.size())) != header.checksum)
+                break;
+
+            if (header.type == RECORD_BASE) {
+                if (!document.applyStructure(payload, true))
+                    break;
+            } else if (header.type == RECORD_COMMIT) {
+                bool applied = true;
+                for (const auto& record : uncommitted) {
+                    applied = record.first == RECORD_STRUCTURE ? document.applyStructure(record.second, false)
+                                                               : document.applyTile(record.second);
+                    if (!applied)
+                        break;
+                }
+                uncommitted.clear();
+                if (!applied)
+                    break;
+                commits++;
+            } else {
+                uncommitted.emplace_back(header.type, std::move(payload));
+            }
+        }
+        std::fclose(journal);
+    }
+
+    std::cout << "Autosaver: Recovered checkpoint " << *generation << " plus " << commits << " deltas" << std::endl;
+    return document.toSnapshot();
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,132 @@
+//Composites and encodes document snapshots on a worker thread
+#include "../../include/Utils/BackgroundSaver.hpp"
+#include "../../include/Core/RaylibWrappers.hpp"
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace EpiGimp {
+
+BackgroundSaver::BackgroundSaver(EventDispatcher* dispatcher)
+    : eventDispatcher_(dispatcher), stopping_(false), saving_(false)
+{
+    if (!dispatcher)
+        throw std::invalid_argument("EventDispatcher cannot be null");
+
+    worker_ = std::thread(&BackgroundSaver::workerLoop, this);
+}
+
+BackgroundSaver::~BackgroundSaver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeWorker_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void BackgroundSaver::submit(DocumentSnapshot snapshot, const std::string& filePath, Writer writer)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(Job{std::move(snapshot), filePath, std::move(writer)});
+    }
+    wakeWorker_.notify_one();
+    std::cout << "BackgroundSaver: Queued save to " << filePath << std::endl;
+}
+
+void BackgroundSaver::update()
+{
+    std::vector<Completion> completed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed.swap(completed_);
+    }
+
+    for (const auto& result : completed) {
+        eventDispatcher_->emit<ImageSavedEvent>(result.actualPath, result.success);
+
+        if (result.success) {
+            if (result.actualPath != result.requestedPath)
+                std::cout << "Note: File extension was auto-corrected to: " << result.actualPath << std::endl;
+            std::cout << "Image saved successfully: " << result.actualPath << std::endl;
+        } else {
+            eventDispatcher_->emit<ErrorEvent>("Failed to save image: " + result.requestedPath);
+        }
+    }
+}
+
+bool BackgroundSaver::isBusy() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return saving_ || !jobs_.empty();
+}
+
+void BackgroundSaver::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return !saving_ && jobs_.empty(); });
+}
+
+void BackgroundSaver::workerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Drain the queue before honouring a stop request so no save is lost
+            wakeWorker_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            saving_ = true;
+        }
+
+        Completion result = save(job);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_.push_back(std::move(result));
+            saving_ = false;
+        }
+        idle_.notify_all();
+    }
+}
+
+BackgroundSaver::Completion BackgroundSaver::save(const Job& job)
+{
+    Completion result{job.filePath, job.filePath, false};
+
+    try {
+        std::filesystem::path parentPath = std::filesystem::path(job.filePath).parent_path();
+        if (!parentPath.empty() && !std::filesystem::exists(parentPath))
+            std::filesystem::create_directories(parentPath);
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "Failed to create directories: " << e.what() << std::endl;
+        // Continue anyway - the save operation might still work
+    }
+
+    result.success = job.writer(job.snapshot, job.filePath, result.actualPath);
+    return result;
+}
+
+bool BackgroundSaver::exportFlattened(const DocumentSnapshot& snapshot, const std::string& filePath, std::string& actualPath)
+{
+    return flattenedWriter(ExportOptions{})(snapshot, filePath, actualPath);
+}
+
+BackgroundSaver::Writer BackgroundSaver::flattenedWriter(const ExportOptions& options)
+{
+    return [options](const DocumentSnapshot& snapshot, const std::string& filePath, std::string& actualPath) {
+        ImageResource composite(snapshot.composite());
+        if (!composite.isValid())
+            return false;
+
+        return composite.exportToFile(filePath, actualPath, options);
+    };
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,484 @@
+//Headless batch processing: scripted image operations over many files
+#include "../../include/Utils/BatchProcessor.hpp"
+#include "../../include/Utils/Filters.hpp"
+#include "../../include/Utils/ProjectFile.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+namespace EpiGimp {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::string lowercase(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+Rectangle wholeImage(const Image& image)
+{
+    return Rectangle{0, 0, static_cast<float>(image.width), static_cast<float>(image.height)};
+}
+
+int rounded(float value)
+{
+    return static_cast<int>(std::lround(value));
+}
+
+void flatten(Image& image, Color background)
+{
+    auto* pixels = static_cast<uint8_t*>(image.data);
+    const size_t count = static_cast<size_t>(image.width) * image.height;
+    const uint8_t under[3] = {background.r, background.g, background.b};
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* p = pixels + i * 4;
+        const int alpha = p[3];
+        for (int c = 0; c < 3; ++c)
+            p[c] = static_cast<uint8_t>((p[c] * alpha + under[c] * (255 - alpha) + 127) / 255);
+        p[3] = 255;
+    }
+}
+
+bool readFloat(std::istringstream& in, float& value)
+{
+    std::string token;
+    if (!(in >> token))
+        return false;
+    try {
+        size_t used = 0;
+        value = std::stof(token, &used);
+        return used == token.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// A CSV field in quotes, with quotes inside it doubled (RFC 4180)
+std::string csvField(const std::string& text)
+{
+    std::string field = "\"";
+    for (char c : text) {
+        if (c == '"')
+            field += '"';
+        field += c;
+    }
+    return field + '"';
+}
+
+// The whole token must be a number; std::stoi alone stops at the first stray character
+bool parseInt(const std::string& token, int& value)
+{
+    try {
+        size_t used = 0;
+        value = std::stoi(token, &used);
+        return used == token.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+std::optional<BatchScript> BatchScript::parse(const std::string& text, std::string* error)
+{
+    BatchScript script;
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+
+    auto fail = [&](const std::string& message) -> std::optional<BatchScript> {
+        if (error)
+            *error = "line " + std::to_string(lineNumber) + ": " + message;
+        return std::nullopt;
+    };
+
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream in(line);
+        std::string command;
+        if (!(in >> command))
+            continue;
+        command = lowercase(command);
+
+        BatchOperation op{};
+        if (command == "resize") {
+            op.type = BatchOperation::Type::Resize;
+            std::string first;
+            in >> first;
+            if (!first.empty() && first.back() == '%') {
+                try {
+                    size_t used = 0;
+                    op.percent = std::stof(first, &used);
+                    if (used != first.size() - 1)
+                        return fail("invalid percentage '" + first + "'");
+                } catch (const std::exception&) {
+                    return fail("invalid percentage '" + first + "'");
+                }
+                if (op.percent <= 0.0f)
+                    return fail("percentage must be positive");
+            } else {
+                if (!parseInt(first, op.width))
+                    return fail("resize expects a width or a percentage");
+                std::string second;
+                if (in >> second && !parseInt(second, op.height))   // Optional, 0 keeps the aspect ratio
+                    return fail("invalid resize height '" + second + "'");
+                if (op.width <= 0 || op.height < 0)
+                    return fail("resize sizes must be positive");
+            }
+        } else if (command == "flip") {
+            op.type = BatchOperation::Type::Flip;
+            std::string axis;
+            in >> axis;
+            axis = lowercase(axis);
+            if (axis != "horizontal" && axis != "vertical")
+                return fail("flip expects horizontal or vertical");
+            op.horizontal = axis == "horizontal";
+        } else if (command == "blur") {
+            op.type = BatchOperation::Type::Blur;
+            if (!readFloat(in, op.radius) || op.radius < 0.0f)
+                return fail("blur expects a non-negative radius");
+        } else if (command == "levels") {
+            op.type = BatchOperation::Type::Levels;
+            if (!readFloat(in, op.inBlack) || !readFloat(in, op.inWhite) || !readFloat(in, op.gamma))
+                return fail("levels expects inBlack inWhite gamma [outBlack outWhite]");
+            if (readFloat(in, op.outBlack) && !readFloat(in, op.outWhite))
+                return fail("levels output range needs both outBlack and outWhite");
+            if (op.inWhite <= op.inBlack || op.gamma <= 0.0f)
+                return fail("levels needs inWhite > inBlack and a positive gamma");
+        } else if (command == "flatten") {
+            op.type = BatchOperation::Type::Flatten;
+            float r, g, b;
+            if (readFloat(in, r)) {
+                if (!readFloat(in, g) || !readFloat(in, b))
+                    return fail("flatten expects a full r g b colour");
+                op.background = Color{static_cast<unsigned char>(std::clamp(r, 0.0f, 255.0f)),
+                                      static_cast<unsigned char>(std::clamp(g, 0.0f, 255.0f)),
+                                      static_cast<unsigned char>(std::clamp(b, 0.0f, 255.0f)), 255};
+            }
+        } else if (command == "export") {
+            std::string format;
+            in >> format;
+            format = lowercase(format);
+            static const std::vector<std::string> formats = {"png", "qoi", "ert", "jpg", "jpeg", "bmp", "tga"};
+            if (std::find(formats.begin(), formats.end(), format) == formats.end())
+                return fail("unknown export format '" + format + "'");
+            script.extension_ = "." + format;
+
+            std::string option;
+            while (in >> option) {
+                option = lowercase(option);
+                if (option == "level") {
+                    float level;
+                    if (!readFloat(in, level) || level < 0.0f || level > 9.0f)
+                        return fail("level expects 0-9");
+                    script.exportOptions_.pngCompressionLevel = static_cast<int>(level);
+                } else if (option == "norle") {
+                    script.exportOptions_.rawTileRle = false;
+                } else {
+                    return fail("unknown export option '" + option + "'");
+                }
+            }
+            continue;
+        } else {
+            return fail("unknown operation '" + command + "'");
+        }
+
+        std::string extra;
+        if (in >> extra)
+            return fail("unexpected '" + extra + "'");
+        script.operations_.push_back(op);
+    }
+
+    return script;
+}
+
+std::optional<BatchScript> BatchScript::load(const std::string& filePath, std::string* error)
+{
+    std::ifstream file(filePath);
+    if (!file) {
+        if (error)
+            *error = "cannot open " + filePath;
+        return std::nullopt;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), error);
+}
+
+void BatchScript::apply(Image& image) const
+{
+    for (const auto& op : operations_) {
+        switch (op.type) {
+        case BatchOperation::Type::Resize: {
+            int width = op.width;
+            int height = op.height;
+            if (op.percent > 0.0f) {
+                width = std::max(1, static_cast<int>(std::lround(image.width * op.percent / 100.0f)));
+                height = std::max(1, static_cast<int>(std::lround(image.height * op.percent / 100.0f)));
+            } else if (height == 0) {
+                height = std::max(1, static_cast<int>(std::lround(static_cast<double>(image.height) * width / image.width)));
+            }
+            if (width != image.width || height != image.height)
+                ImageResize(&image, width, height);
+            break;
+        }
+        case BatchOperation::Type::Flip:
+            if (op.horizontal)
+                ImageFlipHorizontal(&image);
+            else
+                ImageFlipVertical(&image);
+            break;
+        case BatchOperation::Type::Blur:
+            Filters::run(Filters::gaussianBlur(op.radius), image, wholeImage(image), op.radius);
+            break;
+        case BatchOperation::Type::Levels: {
+            const LayerFilter levels = Filters::levels(rounded(op.inBlack), rounded(op.inWhite), op.gamma,
+                                                       rounded(op.outBlack), rounded(op.outWhite));
+            Filters::run(levels, image, wholeImage(image), levels.amount);
+            break;
+        }
+        case BatchOperation::Type::Flatten:
+            flatten(image, op.background);
+            break;
+        }
+    }
+}
+
+void BatchSummary::print(std::ostream& out) const
+{
+    double load = 0.0, process = 0.0, save = 0.0;
+    for (const auto& file : files) {
+        load += file.loadMs;
+        process += file.processMs;
+        save += file.saveMs;
+        if (!file.success)
+            out << "FAILED " << file.inputPath << ": " << file.error << std::endl;
+    }
+
+    const double count = files.empty() ? 1.0 : static_cast<double>(files.size());
+    out << std::fixed << std::setprecision(2)
+        << "Batch: " << succeeded << " succeeded, " << failed << " failed, " << files.size() << " files in "
+        << wallSeconds << " s on " << workers << " workers ("
+        << (wallSeconds > 0.0 ? files.size() / wallSeconds : 0.0) << " files/s)" << std::endl
+        << "Batch: average per file: load " << load / count << " ms, process " << process / count
+        << " ms, save " << save / count << " ms" << std::endl;
+}
+
+bool BatchSummary::writeCsv(const std::string& filePath) const
+{
+    std::ofstream out(filePath);
+    if (!out)
+        return false;
+
+    out << "input,output,status,load_ms,process_ms,save_ms,error\n" << std::fixed << std::setprecision(3);
+    for (const auto& file : files) {
+        out << csvField(file.inputPath) << ',' << csvField(file.outputPath) << ',' << (file.success ? "ok" : "failed") << ','
+            << file.loadMs << ',' << file.processMs << ',' << file.saveMs << ',' << csvField(file.error) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+BatchRunner::BatchRunner(BatchScript script, std::string outputDirectory, unsigned workers)
+    : script_(std::move(script)), outputDirectory_(std::move(outputDirectory)),
+      workers_(workers ? workers : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+Image BatchRunner::loadInput(const std::string& filePath)
+{
+    if (!ProjectFile::isProjectPath(filePath))
+        return ImageResource::loadFile(filePath);
+
+    // Projects are flattened the way an export from the GUI would be
+    auto reader = ProjectReader::open(filePath);
+    return reader ? reader->composite() : Image{};
+}
+
+std::vector<std::string> BatchRunner::outputPaths(const std::vector<std::string>& inputs) const
+{
+    std::vector<std::string> paths;
+    paths.reserve(inputs.size());
+    std::unordered_set<std::string> used;
+    for (const auto& input : inputs) {
+        const std::string stem = std::filesystem::path(input).stem().string();
+        std::string name = stem + script_.getExtension();
+        for (int suffix = 2; !used.insert(name).second; ++suffix)
+            name = stem + "-" + std::to_string(suffix) + script_.getExtension();
+        if (name != stem + script_.getExtension())
+            std::cout << "Batch: " << input << " shares its name with an earlier input, writing " << name << std::endl;
+        paths.push_back((std::filesystem::path(outputDirectory_) / name).string());
+    }
+    return paths;
+}
+
+BatchFileResult BatchRunner::processFile(const std::string& inputPath, const std::string& outputPath) const
+{
+    BatchFileResult result;
+    result.inputPath = inputPath;
+    result.outputPath = outputPath;
+
+    auto start = Clock::now();
+    ImageResource image(loadInput(inputPath));
+    result.loadMs = millisecondsSince(start);
+    if (!image.isValid()) {
+        result.error = "cannot load input";
+        return result;
+    }
+
+    start = Clock::now();
+    if (image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(image.getMutable(), PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    script_.apply(*image.getMutable());
+    result.processMs = millisecondsSince(start);
+
+    start = Clock::now();
+    std::string actualPath;
+    result.success = image.exportToFile(result.outputPath, actualPath, script_.getExportOptions());
+    result.saveMs = millisecondsSince(start);
+    if (!actualPath.empty())
+        result.outputPath = actualPath;
+    if (!result.success)
+        result.error = "cannot write " + result.outputPath;
+    return result;
+}
+
+BatchSummary BatchRunner::run(const std::vector<std::string>& inputs) const
+{
+    BatchSummary summary;
+    summary.files.resize(inputs.size());
+    summary.workers = static_cast<unsigned>(std::min<size_t>(workers_, std::max<size_t>(1, inputs.size())));
+
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory_, error);
+    const std::vector<std::string> outputs = outputPaths(inputs);
+
+    const auto start = Clock::now();
+    // Encoders called from processFile share the same pool, so the cores stay busy
+    // both with many small files and with a few huge ones
+    std::atomic<size_t> done{0};
+    JobSystem::shared().parallelFor(inputs.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            summary.files[i] = processFile(inputs[i], outputs[i]);
+            const size_t finished = ++done;
+            if (finished % 100 == 0)
+                std::cout << "Batch: " << finished << "/" << inputs.size() << " files done" << std::endl;
+        }
+    }, 1, summary.workers);
+    summary.wallSeconds = millisecondsSince(start) / 1000.0;
+
+    for (const auto& file : summary.files)
+        (file.success ? summary.succeeded : summary.failed)++;
+    return summary;
+}
+
+int runBatchCommand(const std::vector<std::string>& args)
+{
+    std::string scriptPath;
+    std::string outputDirectory;
+    std::string listPath;
+    unsigned jobs = 0;
+    std::vector<std::string> inputs;
+
+    auto usage = [](const std::string& message) {
+        std::cerr << "Batch: " << message << std::endl
+                  << "Usage: EpiGimp --batch --script ops.txt --output DIR [--jobs N] [--inputs list.txt] [files...]" << std::endl;
+        return 2;
+    };
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        auto value = [&]() -> std::optional<std::string> {
+            if (i + 1 >= args.size())
+                return std::nullopt;
+            return args[++i];
+        };
+
+        if (arg == "--batch") {
+            continue;
+        } else if (arg == "--script" || arg == "--output" || arg == "--inputs" || arg == "--jobs") {
+            auto next = value();
+            if (!next)
+                return usage(arg + " needs a value");
+            if (arg == "--script") scriptPath = *next;
+            else if (arg == "--output") outputDirectory = *next;
+            else if (arg == "--inputs") listPath = *next;
+            else {
+                try {
+                    jobs = static_cast<unsigned>(std::stoul(*next));
+                } catch (const std::exception&) {
+                    return usage("--jobs expects a number");
+                }
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            return usage("unknown option " + arg);
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (scriptPath.empty() || outputDirectory.empty())
+        return usage("--script and --output are required");
+
+    // Thousands of files do not fit on a command line
+    if (!listPath.empty()) {
+        std::ifstream list(listPath);
+        if (!list)
+            return usage("cannot open input list " + listPath);
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty() && line[0] != '#')
+                inputs.push_back(line);
+        }
+    }
+    if (inputs.empty())
+        return usage("no input files");
+
+    std::string error;
+    auto script = BatchScript::load(scriptPath, &error);
+    if (!script) {
+        std::cerr << "Batch: " << scriptPath << ": " << error << std::endl;
+        return 2;
+    }
+
+    // raylib's own logging would interleave across workers
+    SetTraceLogLevel(LOG_WARNING);
+
+    BatchRunner runner(std::move(*script), outputDirectory, jobs);
+    BatchSummary summary = runner.run(inputs);
+    summary.print(std::cout);
+
+    const std::string csvPath = (std::filesystem::path(outputDirectory) / "batch_summary.csv").string();
+    if (summary.writeCsv(csvPath))
+        std::cout << "Batch: Timings written to " << csvPath << std::endl;
+    else
+        std::cerr << "Batch: Cannot write " << csvPath << std::endl;
+
+    return summary.failed == 0 ? 0 : 1;
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,590 @@
+//Conversions between RGB and the HSV, HSL and CIELAB colour spaces
+#include "../../include/Utils/ColorSpace.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace EpiGimp {
+
+namespace ColorSpace {
+
+namespace {
+
+constexpr int BAND_ROWS = 16;                        // Rows per job in adjustHsl
+constexpr float BYTE_SCALE = 1.0f / 255.0f;
+
+// CIE constants: (6/29)^3 and (29/3)^3, and the D65 white sRGB is relative to
+constexpr float LAB_EPSILON = 216.0f / 24389.0f;
+constexpr float LAB_KAPPA = 24389.0f / 27.0f;
+constexpr float WHITE_X = 0.95047f;
+constexpr float WHITE_Z = 1.08883f;
+
+struct Tables {
+    float decode[256];                               // sRGB byte to linear
+    uint8_t encode[ENCODE_TABLE_SIZE];               // Linear, in even steps, to sRGB byte
+
+    Tables() {
+        for (int v = 0; v < 256; ++v) {
+            const double c = v / 255.0;
+            decode[v] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i < ENCODE_TABLE_SIZE; ++i) {
+            const double l = static_cast<double>(i) / (ENCODE_TABLE_SIZE - 1);
+            const double c = l <= 0.0031308 ? 12.92 * l : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+            encode[i] = static_cast<uint8_t>(std::clamp(std::lround(c * 255.0), 0L, 255L));
+        }
+    }
+};
+
+const Tables& tables()
+{
+    static const Tables shared;
+    return shared;
+}
+
+// Single-float lanes: one colour at a time, and the tail of every batch
+template <typename L> L laneSet(float v);
+template <> float laneSet<float>(float v) { return v; }
+float laneAdd(float a, float b) { return a + b; }
+float laneSub(float a, float b) { return a - b; }
+float laneMul(float a, float b) { return a * b; }
+float laneDiv(float a, float b) { return a / b; }
+float laneMin(float a, float b) { return std::min(a, b); }
+float laneMax(float a, float b) { return std::max(a, b); }
+float laneAbs(float a) { return std::fabs(a); }
+float laneFloor(float a) { return std::floor(a); }
+float laneCbrt(float a) { return std::cbrt(a); }
+bool laneGreater(float a, float b) { return a > b; }
+bool laneLess(float a, float b) { return a < b; }
+bool laneEqual(float a, float b) { return a == b; }
+bool laneAndNot(bool a, bool b) { return !a && b; }
+float laneSelect(bool mask, float a, float b) { return mask ? a : b; }
+
+void laneLoadRgb(const uint8_t* rgba, float& r, float& g, float& b)
+{
+    r = rgba[0] * BYTE_SCALE;
+    g = rgba[1] * BYTE_SCALE;
+    b = rgba[2] * BYTE_SCALE;
+}
+
+void laneStoreRgb(uint8_t* rgba, float r, float g, float b)
+{
+    const auto toByte = [](float x) { return static_cast<uint8_t>(std::nearbyint(std::clamp(x * 255.0f, 0.0f, 255.0f))); };
+    rgba[0] = toByte(r);
+    rgba[1] = toByte(g);
+    rgba[2] = toByte(b);
+}
+
+void laneDecode(const Tables& table, const uint8_t* rgba, float& r, float& g, float& b)
+{
+    r = table.decode[rgba[0]];
+    g = table.decode[rgba[1]];
+    b = table.decode[rgba[2]];
+}
+
+int encodeIndex(float linear)
+{
+    return static_cast<int>(std::nearbyint(std::clamp(linear, 0.0f, 1.0f) * static_cast<float>(ENCODE_TABLE_SIZE - 1)));
+}
+
+void laneEncode(const Tables& table, uint8_t* rgba, float r, float g, float b)
+{
+    rgba[0] = table.encode[encodeIndex(r)];
+    rgba[1] = table.encode[encodeIndex(g)];
+    rgba[2] = table.encode[encodeIndex(b)];
+}
+
+#if defined(__SSE2__)
+// Four pixels per lane; under AVX only the helpers below the arithmetic are used, by the 8-lane halves
+#if !defined(__AVX__)
+template <> __m128 laneSet<__m128>(float v) { return _mm_set1_ps(v); }
+__m128 laneAdd(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+__m128 laneSub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+__m128 laneMul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+__m128 laneDiv(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+__m128 laneMin(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+__m128 laneMax(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+__m128 laneAbs(__m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+__m128 laneGreater(__m128 a, __m128 b) { return _mm_cmpgt_ps(a, b); }
+__m128 laneLess(__m128 a, __m128 b) { return _mm_cmplt_ps(a, b); }
+__m128 laneEqual(__m128 a, __m128 b) { return _mm_cmpeq_ps(a, b); }
+__m128 laneAndNot(__m128 a, __m128 b) { return _mm_andnot_ps(a, b); }
+__m128 laneSelect(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+__m128 laneFloor(__m128 a)
+{
+    // Truncation rounds negative values up; take one off those
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.0f)));
+}
+#endif
+
+__m128 laneCbrt(__m128 a)
+{
+    // A third of the bit pattern roughly takes a third of the exponent; Newton does the rest
+    const __m128 bits = _mm_cvtepi32_ps(_mm_castps_si128(a));
+    __m128 y = _mm_castsi128_ps(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(bits, _mm_set1_ps(1.0f / 3.0f)), _mm_set1_ps(709958130.0f))));
+    const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+    for (int i = 0; i < 3; ++i)
+        y = _mm_mul_ps(third, _mm_add_ps(_mm_add_ps(y, y), _mm_div_ps(a, _mm_mul_ps(y, y))));
+    return y;
+}
+
+void laneLoadRgb(const uint8_t* rgba, __m128& r, __m128& g, __m128& b)
+{
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba));
+    const __m128i low = _mm_set1_epi32(0xFF);
+    const __m128 scale = _mm_set1_ps(BYTE_SCALE);
+    r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(pixels, low)), scale);
+    g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), low)), scale);
+    b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), low)), scale);
+}
+
+void laneStoreRgb(uint8_t* rgba, __m128 r, __m128 g, __m128 b)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 top = _mm_set1_ps(255.0f);
+    const auto toByte = [&](__m128 x) { return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(x, top), zero), top)); };
+    const __m128i alpha = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba)),
+                                        _mm_set1_epi32(static_cast<int>(0xFF000000u)));
+    const __m128i colour = _mm_or_si128(_mm_or_si128(toByte(r), _mm_slli_epi32(toByte(g), 8)), _mm_slli_epi32(toByte(b), 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba), _mm_or_si128(colour, alpha));
+}
+
+void laneDecode(const Tables& table, const uint8_t* rgba, __m128& r, __m128& g, __m128& b)
+{
+    const float* t = table.decode;
+    r = _mm_setr_ps(t[rgba[0]], t[rgba[4]], t[rgba[8]], t[rgba[12]]);
+    g = _mm_setr_ps(t[rgba[1]], t[rgba[5]], t[rgba[9]], t[rgba[13]]);
+    b = _mm_setr_ps(t[rgba[2]], t[rgba[6]], t[rgba[10]], t[rgba[14]]);
+}
+
+void laneEncode(const Tables& table, uint8_t* rgba, __m128 r, __m128 g, __m128 b)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 steps = _mm_set1_ps(static_cast<float>(ENCODE_TABLE_SIZE - 1));
+    alignas(16) int32_t index[3][4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(index[0]), _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), steps)));
+    _mm_store_si128(reinterpret_cast<__m128i*>(index[1]), _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), steps)));
+    _mm_store_si128(reinterpret_cast<__m128i*>(index[2]), _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, zero), one), steps)));
+    for (int i = 0; i < 4; ++i)
+        for (int ch = 0; ch < 3; ++ch)
+            rgba[i * 4 + ch] = table.encode[index[ch][i]];
+}
+#endif
+
+#if defined(__AVX__)
+// Eight pixels per lane; integer work goes through two SSE halves, AVX has no 256-bit integer ops
+template <> __m256 laneSet<__m256>(float v) { return _mm256_set1_ps(v); }
+__m256 laneAdd(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+__m256 laneSub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+__m256 laneMul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+__m256 laneDiv(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+__m256 laneMin(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+__m256 laneMax(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+__m256 laneAbs(__m256 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+__m256 laneFloor(__m256 a) { return _mm256_floor_ps(a); }
+__m256 laneGreater(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+__m256 laneLess(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+__m256 laneEqual(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+__m256 laneAndNot(__m256 a, __m256 b) { return _mm256_andnot_ps(a, b); }
+__m256 laneSelect(__m256 mask, __m256 a, __m256 b) { return _mm256_blendv_ps(b, a, mask); }
+
+__m256 combine(__m128 low, __m128 high) { return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1); }
+__m128 lowHalf(__m256 a) { return _mm256_castps256_ps128(a); }
+__m128 highHalf(__m256 a) { return _mm256_extractf128_ps(a, 1); }
+
+__m256 laneCbrt(__m256 a) { return combine(laneCbrt(lowHalf(a)), laneCbrt(highHalf(a))); }
+
+void laneLoadRgb(const uint8_t* rgba, __m256& r, __m256& g, __m256& b)
+{
+    __m128 r0, g0, b0, r1, g1, b1;
+    laneLoadRgb(rgba, r0, g0, b0);
+    laneLoadRgb(rgba + 16, r1, g1, b1);
+    r = combine(r0, r1);
+    g = combine(g0, g1);
+    b = combine(b0, b1);
+}
+
+void laneStoreRgb(uint8_t* rgba, __m256 r, __m256 g, __m256 b)
+{
+    laneStoreRgb(rgba, lowHalf(r), lowHalf(g), lowHalf(b));
+    laneStoreRgb(rgba + 16, highHalf(r), highHalf(g), highHalf(b));
+}
+
+void laneDecode(const Tables& table, const uint8_t* rgba, __m256& r, __m256& g, __m256& b)
+{
+    __m128 r0, g0, b0, r1, g1, b1;
+    laneDecode(table, rgba, r0, g0, b0);
+    laneDecode(table, rgba + 16, r1, g1, b1);
+    r = combine(r0, r1);
+    g = combine(g0, g1);
+    b = combine(b0, b1);
+}
+
+void laneEncode(const Tables& table, uint8_t* rgba, __m256 r, __m256 g, __m256 b)
+{
+    laneEncode(table, rgba, lowHalf(r), lowHalf(g), lowHalf(b));
+    laneEncode(table, rgba + 16, highHalf(r), highHalf(g), highHalf(b));
+}
+#endif
+
+#if defined(__AVX__)
+using Lane = __m256;
+constexpr size_t WIDTH = 8;
+__m256 laneLoad(const float* p) { return _mm256_loadu_ps(p); }
+void laneStore(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+#elif defined(__SSE2__)
+using Lane = __m128;
+constexpr size_t WIDTH = 4;
+__m128 laneLoad(const float* p) { return _mm_loadu_ps(p); }
+void laneStore(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+#endif
+
+// x mod m, into [0, m)
+template <typename L>
+L laneWrap(L x, float m)
+{
+    return laneSub(x, laneMul(laneSet<L>(m), laneFloor(laneMul(x, laneSet<L>(1.0f / m)))));
+}
+
+// Hue in degrees of a colour whose largest component is largest and whose range is chroma
+template <typename L>
+L hueOf(L r, L g, L b, L largest, L chroma)
+{
+    const L zero = laneSet<L>(0.0f);
+    const auto chromatic = laneGreater(chroma, zero);
+    const L inverse = laneDiv(laneSet<L>(1.0f), laneSelect(chromatic, chroma, laneSet<L>(1.0f)));
+    const L fromRed = laneMul(laneSub(g, b), inverse);
+    const L fromGreen = laneAdd(laneMul(laneSub(b, r), inverse), laneSet<L>(2.0f));
+    const L fromBlue = laneAdd(laneMul(laneSub(r, g), inverse), laneSet<L>(4.0f));
+
+    // Ties go to red, then green, the same in every lane width
+    const auto redLargest = laneEqual(largest, r);
+    const auto greenLargest = laneAndNot(redLargest, laneEqual(largest, g));
+    L sector = laneSelect(redLargest, fromRed, laneSelect(greenLargest, fromGreen, fromBlue));
+    sector = laneSelect(laneLess(sector, zero), laneAdd(sector, laneSet<L>(6.0f)), sector);
+    const L degrees = laneMul(sector, laneSet<L>(60.0f));
+    return laneSelect(chromatic, laneSelect(laneLess(degrees, laneSet<L>(360.0f)), degrees, zero), zero);
+}
+
+template <typename L>
+void hsvFromRgb(L r, L g, L b, L& h, L& s, L& v)
+{
+    const L largest = laneMax(r, laneMax(g, b));
+    const L chroma = laneSub(largest, laneMin(r, laneMin(g, b)));
+    const L zero = laneSet<L>(0.0f);
+    const auto lit = laneGreater(largest, zero);
+    h = hueOf(r, g, b, largest, chroma);
+    s = laneDiv(chroma, laneSelect(lit, largest, laneSet<L>(1.0f)));
+    v = largest;
+}
+
+// One component of an HSV colour: v minus the part of the chroma its position on the hue wheel removes
+template <typename L>
+L hsvComponent(float offset, L sectors, L v, L chroma)
+{
+    const L k = laneWrap(laneAdd(sectors, laneSet<L>(offset)), 6.0f);
+    const L ramp = laneMax(laneSet<L>(0.0f), laneMin(laneMin(k, laneSub(laneSet<L>(4.0f), k)), laneSet<L>(1.0f)));
+    return laneSub(v, laneMul(chroma, ramp));
+}
+
+template <typename L>
+void rgbFromHsv(L h, L s, L v, L& r, L& g, L& b)
+{
+    const L sectors = laneMul(h, laneSet<L>(1.0f / 60.0f));
+    const L chroma = laneMul(v, s);
+    r = hsvComponent(5.0f, sectors, v, chroma);
+    g = hsvComponent(3.0f, sectors, v, chroma);
+    b = hsvComponent(1.0f, sectors, v, chroma);
+}
+
+template <typename L>
+void hslFromRgb(L r, L g, L b, L& h, L& s, L& l)
+{
+    const L largest = laneMax(r, laneMax(g, b));
+    const L smallest = laneMin(r, laneMin(g, b));
+    const L chroma = laneSub(largest, smallest);
+    const L one = laneSet<L>(1.0f);
+    h = hueOf(r, g, b, largest, chroma);
+    l = laneMul(laneAdd(largest, smallest), laneSet<L>(0.5f));
+
+    // 1 - |2l - 1| is only zero for black and white, which have no chroma either
+    const L spread = laneSub(one, laneAbs(laneSub(laneAdd(l, l), one)));
+    const auto chromatic = laneGreater(chroma, laneSet<L>(0.0f));
+    s = laneSelect(chromatic, laneMin(laneDiv(chroma, laneSelect(chromatic, spread, one)), one), laneSet<L>(0.0f));
+}
+
+template <typename L>
+L hslComponent(float offset, L twelfths, L l, L reach)
+{
+    const L k = laneWrap(laneAdd(twelfths, laneSet<L>(offset)), 12.0f);
+    const L ramp = laneMax(laneSet<L>(-1.0f), laneMin(laneMin(laneSub(k, laneSet<L>(3.0f)), laneSub(laneSet<L>(9.0f), k)),
+                                                     laneSet<L>(1.0f)));
+    return laneSub(l, laneMul(reach, ramp));
+}
+
+template <typename L>
+void rgbFromHsl(L h, L s, L l, L& r, L& g, L& b)
+{
+    const L twelfths = laneMul(h, laneSet<L>(1.0f / 30.0f));
+    const L reach = laneMul(s, laneMin(l, laneSub(laneSet<L>(1.0f), l)));
+    r = hslComponent(0.0f, twelfths, l, reach);
+    g = hslComponent(8.0f, twelfths, l, reach);
+    b = hslComponent(4.0f, twelfths, l, reach);
+}
+
+template <typename L>
+L labCurve(L t)
+{
+    const L linearPart = laneMul(laneAdd(laneMul(t, laneSet<L>(LAB_KAPPA)), laneSet<L>(16.0f)), laneSet<L>(1.0f / 116.0f));
+    return laneSelect(laneGreater(t, laneSet<L>(LAB_EPSILON)), laneCbrt(t), linearPart);
+}
+
+template <typename L>
+L labCurveInverse(L f)
+{
+    const L cube = laneMul(f, laneMul(f, f));
+    const L linearPart = laneMul(laneSub(laneMul(f, laneSet<L>(116.0f)), laneSet<L>(16.0f)), laneSet<L>(1.0f / LAB_KAPPA));
+    return laneSelect(laneGreater(cube, laneSet<L>(LAB_EPSILON)), cube, linearPart);
+}
+
+// Linear sRGB to Lab; the white point is folded into the first and last rows of the matrix
+template <typename L>
+void labFromLinear(L r, L g, L b, L& lightness, L& a, L& bb)
+{
+    const auto dot = [](L r, L g, L b, float x, float y, float z) {
+        return laneAdd(laneAdd(laneMul(r, laneSet<L>(x)), laneMul(g, laneSet<L>(y))), laneMul(b, laneSet<L>(z)));
+    };
+    const L fx = labCurve(dot(r, g, b, 0.4124564f / WHITE_X, 0.3575761f / WHITE_X, 0.1804375f / WHITE_X));
+    const L fy = labCurve(dot(r, g, b, 0.2126729f, 0.7151522f, 0.0721750f));
+    const L fz = labCurve(dot(r, g, b, 0.0193339f / WHITE_Z, 0.1191920f / WHITE_Z, 0.9503041f / WHITE_Z));
+    lightness = laneSub(laneMul(fy, laneSet<L>(116.0f)), laneSet<L>(16.0f));
+    a = laneMul(laneSub(fx, fy), laneSet<L>(500.0f));
+    bb = laneMul(laneSub(fy, fz), laneSet<L>(200.0f));
+}
+
+template <typename L>
+void linearFromLab(L lightness, L a, L bb, L& r, L& g, L& b)
+{
+    const L fy = laneMul(laneAdd(lightness, laneSet<L>(16.0f)), laneSet<L>(1.0f / 116.0f));
+    const L x = laneMul(labCurveInverse(laneAdd(fy, laneMul(a, laneSet<L>(1.0f / 500.0f)))), laneSet<L>(WHITE_X));
+    const L y = labCurveInverse(fy);
+    const L z = laneMul(labCurveInverse(laneSub(fy, laneMul(bb, laneSet<L>(1.0f / 200.0f)))), laneSet<L>(WHITE_Z));
+    const auto dot = [&](float p, float q, float s) {
+        return laneAdd(laneAdd(laneMul(x, laneSet<L>(p)), laneMul(y, laneSet<L>(q))), laneMul(z, laneSet<L>(s)));
+    };
+    r = dot(3.2404542f, -1.5371385f, -0.4985314f);
+    g = dot(-0.9692660f, 1.8760108f, 0.0415560f);
+    b = dot(0.0556434f, -0.2040259f, 1.0572252f);
+}
+
+// Pixels to planes: whole lanes first, the rest one at a time. LINEAR decodes sRGB first.
+template <bool LINEAR, typename Convert>
+void fromPixels(const uint8_t* rgba, size_t count, float* x, float* y, float* z, Convert convert)
+{
+    const Tables& table = tables();
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Lane r, g, b, cx, cy, cz;
+        if (LINEAR)
+            laneDecode(table, rgba + i * 4, r, g, b);
+        else
+            laneLoadRgb(rgba + i * 4, r, g, b);
+        convert(r, g, b, cx, cy, cz);
+        laneStore(x + i, cx);
+        laneStore(y + i, cy);
+        laneStore(z + i, cz);
+    }
+#endif
+    for (; i < count; ++i) {
+        float r, g, b;
+        if (LINEAR)
+            laneDecode(table, rgba + i * 4, r, g, b);
+        else
+            laneLoadRgb(rgba + i * 4, r, g, b);
+        convert(r, g, b, x[i], y[i], z[i]);
+    }
+}
+
+template <bool LINEAR, typename Convert>
+void toPixels(const float* x, const float* y, const float* z, size_t count, uint8_t* rgba, Convert convert)
+{
+    const Tables& table = tables();
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + WIDTH <= count; i += WIDTH) {
+        Lane r, g, b;
+        convert(laneLoad(x + i), laneLoad(y + i), laneLoad(z + i), r, g, b);
+        if (LINEAR)
+            laneEncode(table, rgba + i * 4, r, g, b);
+        else
+            laneStoreRgb(rgba + i * 4, r, g, b);
+    }
+#endif
+    for (; i < count; ++i) {
+        float r, g, b;
+        convert(x[i], y[i], z[i], r, g, b);
+        if (LINEAR)
+            laneEncode(table, rgba + i * 4, r, g, b);
+        else
+            laneStoreRgb(rgba + i * 4, r, g, b);
+    }
+}
+
+} // namespace
+
+float toLinear(uint8_t value)
+{
+    return tables().decode[value];
+}
+
+uint8_t fromLinear(float linear)
+{
+    return tables().encode[encodeIndex(linear)];
+}
+
+Hsv toHsv(Color color)
+{
+    const uint8_t pixel[4] = {color.r, color.g, color.b, color.a};
+    Hsv hsv;
+    rgbToHsv(pixel, 1, &hsv.h, &hsv.s, &hsv.v);
+    return hsv;
+}
+
+Color fromHsv(Hsv hsv, unsigned char alpha)
+{
+    uint8_t pixel[4] = {0, 0, 0, alpha};
+    hsvToRgb(&hsv.h, &hsv.s, &hsv.v, 1, pixel);
+    return Color{pixel[0], pixel[1], pixel[2], pixel[3]};
+}
+
+Hsl toHsl(Color color)
+{
+    const uint8_t pixel[4] = {color.r, color.g, color.b, color.a};
+    Hsl hsl;
+    rgbToHsl(pixel, 1, &hsl.h, &hsl.s, &hsl.l);
+    return hsl;
+}
+
+Color fromHsl(Hsl hsl, unsigned char alpha)
+{
+    uint8_t pixel[4] = {0, 0, 0, alpha};
+    hslToRgb(&hsl.h, &hsl.s, &hsl.l, 1, pixel);
+    return Color{pixel[0], pixel[1], pixel[2], pixel[3]};
+}
+
+Lab toLab(Color color)
+{
+    const uint8_t pixel[4] = {color.r, color.g, color.b, color.a};
+    Lab lab;
+    rgbToLab(pixel, 1, &lab.l, &lab.a, &lab.b);
+    return lab;
+}
+
+Color fromLab(Lab lab, unsigned char alpha)
+{
+    uint8_t pixel[4] = {0, 0, 0, alpha};
+    labToRgb(&lab.l, &lab.a, &lab.b, 1, pixel);
+    return Color{pixel[0], pixel[1], pixel[2], pixel[3]};
+}
+
+void rgbToHsv(const uint8_t* rgba, size_t count, float* h, float* s, float* v)
+{
+    fromPixels<false>(rgba, count, h, s, v, [](auto r, auto g, auto b, auto& x, auto& y, auto& z) { hsvFromRgb(r, g, b, x, y, z); });
+}
+
+void hsvToRgb(const float* h, const float* s, const float* v, size_t count, uint8_t* rgba)
+{
+    toPixels<false>(h, s, v, count, rgba, [](auto x, auto y, auto z, auto& r, auto& g, auto& b) { rgbFromHsv(x, y, z, r, g, b); });
+}
+
+void rgbToHsl(const uint8_t* rgba, size_t count, float* h, float* s, float* l)
+{
+    fromPixels<false>(rgba, count, h, s, l, [](auto r, auto g, auto b, auto& x, auto& y, auto& z) { hslFromRgb(r, g, b, x, y, z); });
+}
+
+void hslToRgb(const float* h, const float* s, const float* l, size_t count, uint8_t* rgba)
+{
+    toPixels<false>(h, s, l, count, rgba, [](auto x, auto y, auto z, auto& r, auto& g, auto& b) { rgbFromHsl(x, y, z, r, g, b); });
+}
+
+void rgbToLab(const uint8_t* rgba, size_t count, float* l, float* a, float* b)
+{
+    fromPixels<true>(rgba, count, l, a, b, [](auto r, auto g, auto b, auto& x, auto& y, auto& z) { labFromLinear(r, g, b, x, y, z); });
+}
+
+void labToRgb(const float* l, const float* a, const float* b, size_t count, uint8_t* rgba)
+{
+    toPixels<true>(l, a, b, count, rgba, [](auto x, auto y, auto z, auto& r, auto& g, auto& b) { linearFromLab(x, y, z, r, g, b); });
+}
+
+void adjustHsl(Image& image, const HslShift& shift, Rectangle region)
+{
+    if (!image.data || shift.isIdentity())
+        return;
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "ColorSpace: Image must be RGBA8" << std::endl;
+        return;
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(region.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(region.y)));
+    const int x1 = std::min(image.width, static_cast<int>(std::ceil(region.x + region.width)));
+    const int y1 = std::min(image.height, static_cast<int>(std::ceil(region.y + region.height)));
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    // Saturation scales, lightness blends towards black or white
+    const float hue = shift.hue;
+    const float saturation = 1.0f + std::clamp(shift.saturation, -1.0f, 1.0f);
+    const float lightness = std::clamp(shift.lightness, -1.0f, 1.0f);
+    const float lightScale = lightness > 0.0f ? 1.0f - lightness : 1.0f + lightness;
+    const float lightOffset = std::max(lightness, 0.0f);
+    const auto adjust = [=](auto& r, auto& g, auto& b) {
+        using L = std::decay_t<decltype(r)>;
+        L h, s, l;
+        hslFromRgb(r, g, b, h, s, l);
+        s = laneMin(laneMul(s, laneSet<L>(saturation)), laneSet<L>(1.0f));
+        l = laneAdd(laneMul(l, laneSet<L>(lightScale)), laneSet<L>(lightOffset));
+        rgbFromHsl(laneAdd(h, laneSet<L>(hue)), s, l, r, g, b);
+    };
+
+    auto* pixels = static_cast<uint8_t*>(image.data);
+    const size_t width = static_cast<size_t>(x1 - x0);
+    JobSystem::shared().parallelFor(static_cast<size_t>(y1 - y0), [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            uint8_t* row = pixels + ((y0 + y) * static_cast<size_t>(image.width) + x0) * 4;
+            size_t i = 0;
+#if defined(__SSE2__)
+            for (; i + WIDTH <= width; i += WIDTH) {
+                Lane r, g, b;
+                laneLoadRgb(row + i * 4, r, g, b);
+                adjust(r, g, b);
+                laneStoreRgb(row + i * 4, r, g, b);
+            }
+#endif
+            for (; i < width; ++i) {
+                float r, g, b;
+                laneLoadRgb(row + i * 4, r, g, b);
+                adjust(r, g, b);
+                laneStoreRgb(row + i * 4, r, g, b);
+            }
+        }
+    }, BAND_ROWS);
+}
+
+} // namespace ColorSpace
+
+} // namespace EpiGimp
@@ -0,0 +1,524 @@
+//Local JSON-RPC control socket for driving a running instance
+#include "../../include/Utils/ControlServer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr size_t READ_CHUNK = 64 * 1024;
+constexpr size_t PAUSE_READING_BYTES = 4 * 1024 * 1024;   // Outbox size at which a client's requests wait
+constexpr size_t REMOTE_PIPELINE_DEPTH = 256;
+
+bool makeAddress(const std::string& socketPath, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+        return false;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    return true;
+}
+
+bool writeAll(int fd, const std::string& data)
+{
+    size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t result = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return false;
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+JsonValue errorResponse(const JsonValue& id, int code, const std::string& message)
+{
+    JsonValue error = JsonValue::object();
+    error.set("code", code).set("message", message);
+    JsonValue response = JsonValue::object();
+    response.set("jsonrpc", "2.0").set("id", id).set("error", std::move(error));
+    return response;
+}
+
+} // namespace
+
+ControlServer::ControlServer(std::string socketPath)
+    : socketPath_(std::move(socketPath)), listenFd_(-1), wakePipe_{-1, -1}, stopping_(false), processedCount_(0)
+{
+}
+
+ControlServer::~ControlServer()
+{
+    stop();
+}
+
+void ControlServer::registerMethod(const std::string& name, Handler handler)
+{
+    handlers_[name] = std::move(handler);
+}
+
+bool ControlServer::start()
+{
+    if (isRunning())
+        return true;
+
+    sockaddr_un address;
+    if (!makeAddress(socketPath_, address)) {
+        std::cerr << "ControlServer: Invalid socket path '" << socketPath_ << "'" << std::endl;
+        return false;
+    }
+
+    // Only replace a socket nobody is listening on
+    ControlClient probe;
+    if (probe.connect(socketPath_)) {
+        std::cerr << "ControlServer: " << socketPath_ << " is already served by another instance" << std::endl;
+        return false;
+    }
+    ::unlink(socketPath_.c_str());
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "ControlServer: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Nobody can connect before listen(), so tightening the mode in between leaves no window;
+    // umask would do it too, but it is process-wide and other threads are creating files
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::chmod(socketPath_.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        ::listen(listenFd_, 16) != 0 || ::pipe2(wakePipe_, O_CLOEXEC | O_NONBLOCK) != 0) {
+        std::cerr << "ControlServer: Cannot listen on " << socketPath_ << ": " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    stopping_ = false;
+    ioThread_ = std::thread(&ControlServer::ioLoop, this);
+    std::cout << "ControlServer: Listening on " << socketPath_ << std::endl;
+    return true;
+}
+
+void ControlServer::stop()
+{
+    if (ioThread_.joinable()) {
+        stopping_ = true;
+        wake();
+        ioThread_.join();
+    }
+
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+        ::unlink(socketPath_.c_str());
+    }
+    for (int& fd : wakePipe_) {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+}
+
+void ControlServer::wake()
+{
+    if (wakePipe_[1] >= 0) {
+        const char byte = 1;
+        [[maybe_unused]] const ssize_t ignored = ::write(wakePipe_[1], &byte, 1);
+    }
+}
+
+size_t ControlServer::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void ControlServer::ioLoop()
+{
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> fds;
+
+    while (!stopping_) {
+        bool accepting;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            accepting = pending_.size() < MAX_PENDING;
+        }
+
+        fds.clear();
+        fds.push_back({wakePipe_[0], POLLIN, 0});
+        fds.push_back({listenFd_, POLLIN, 0});
+        for (const auto& connection : connections) {
+            short events = 0;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                if (!connection->outbox.empty())
+                    events |= POLLOUT;
+                if (accepting && connection->outbox.size() < PAUSE_READING_BYTES)
+                    events |= POLLIN;
+            }
+            fds.push_back({connection->fd, events, 0});
+        }
+
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "ControlServer: poll() failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (::read(wakePipe_[0], drain, sizeof(drain)) > 0) {}
+        }
+
+        if (fds[1].revents & POLLIN) {
+            // Non-blocking, so a client that stops reading cannot stall the frame loop
+            const int clientFd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (clientFd >= 0)
+                connections.push_back(std::make_shared<Connection>(clientFd));
+        }
+
+        std::vector<std::shared_ptr<Connection>> closed;
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (fds[i].revents & POLLOUT) {
+                Connection& connection = *connections[i - 2];
+                std::lock_guard<std::mutex> lock(connection.mutex);
+                if (connection.fd >= 0 && !flushOutbox(connection))
+                    ::shutdown(connection.fd, SHUT_RDWR);
+            }
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                readFrom(connections[i - 2], closed);
+        }
+        for (const auto& connection : closed) {
+            closeConnection(*connection);
+            connections.erase(std::remove(connections.begin(), connections.end(), connection), connections.end());
+        }
+    }
+
+    for (const auto& connection : connections)
+        closeConnection(*connection);
+}
+
+void ControlServer::readFrom(const std::shared_ptr<Connection>& connection,
+                             std::vector<std::shared_ptr<Connection>>& closed)
+{
+    char buffer[READ_CHUNK];
+    const ssize_t received = ::recv(connection->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return;
+    if (received <= 0) {
+        closed.push_back(connection);
+        return;
+    }
+
+    connection->inbox.append(buffer, static_cast<size_t>(received));
+    size_t start = 0;
+    for (size_t newline = connection->inbox.find('\n'); newline != std::string::npos;
+         newline = connection->inbox.find('\n', start)) {
+        std::string message = connection->inbox.substr(start, newline - start);
+        start = newline + 1;
+        if (!message.empty() && message.back() == '\r')
+            message.pop_back();
+        if (message.find_first_not_of(" \t") != std::string::npos)
+            queueMessage(connection, message);
+    }
+    connection->inbox.erase(0, start);
+
+    if (connection->inbox.size() > MAX_MESSAGE_BYTES) {
+        sendMessage(*connection, errorResponse(JsonValue(), RpcError::INVALID_REQUEST, "message too large").dump());
+        closed.push_back(connection);
+    }
+}
+
+void ControlServer::queueMessage(const std::shared_ptr<Connection>& connection, const std::string& message)
+{
+    Request request{connection, JsonValue(), false, "", JsonValue(), 0, ""};
+
+    // Parsing happens here so the main thread only runs handlers
+    std::string error;
+    auto parsed = JsonValue::parse(message, &error);
+    if (!parsed) {
+        request.errorCode = RpcError::PARSE_ERROR;
+        request.errorMessage = error;
+    } else if (!parsed->isObject() || !(*parsed)["method"].isString() ||
+               (parsed->has("jsonrpc") && (*parsed)["jsonrpc"].asString() != "2.0") ||
+               (parsed->has("params") && !(*parsed)["params"].isObject() && !(*parsed)["params"].isArray())) {
+        request.id = (*parsed)["id"];
+        request.errorCode = RpcError::INVALID_REQUEST;
+        request.errorMessage = "not a JSON-RPC 2.0 request";
+    } else {
+        request.notification = !parsed->has("id");
+        request.id = (*parsed)["id"];
+        request.method = (*parsed)["method"].asString();
+        request.params = parsed->has("params") ? (*parsed)["params"] : JsonValue::object();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(request));
+}
+
+size_t ControlServer::processPending(double budgetMs)
+{
+    const auto start = std::chrono::steady_clock::now();
+    size_t handled = 0;
+
+    while (true) {
+        Request request;
+        bool resumeReading;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty())
+                break;
+            resumeReading = pending_.size() == MAX_PENDING;
+            request = std::move(pending_.front());
+            pending_.pop_front();
+        }
+        if (resumeReading)
+            wake();
+
+        JsonValue response = dispatch(request);
+        if (!request.notification)
+            sendMessage(*request.connection, response.dump());
+        handled++;
+        processedCount_++;
+
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMs)
+            break;
+    }
+    return handled;
+}
+
+JsonValue ControlServer::dispatch(const Request& request)
+{
+    if (request.errorCode != 0)
+        return errorResponse(request.id, request.errorCode, request.errorMessage);
+
+    auto handler = handlers_.find(request.method);
+    if (handler == handlers_.end())
+        return errorResponse(request.id, RpcError::METHOD_NOT_FOUND, "unknown method '" + request.method + "'");
+
+    try {
+        JsonValue response = JsonValue::object();
+        response.set("jsonrpc", "2.0").set("id", request.id).set("result", handler->second(request.params));
+        return response;
+    } catch (const ControlError& e) {
+        return errorResponse(request.id, e.getCode(), e.what());
+    } catch (const std::exception& e) {
+        return errorResponse(request.id, RpcError::SERVER_ERROR, e.what());
+    }
+}
+
+void ControlServer::sendMessage(Connection& connection, const std::string& message)
+{
+    bool backedUp;
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        if (connection.fd < 0)
+            return;
+        const bool wasEmpty = connection.outbox.empty();
+        connection.outbox += message;
+        connection.outbox += '\n';
+        if (connection.outbox.size() > MAX_OUTBOX_BYTES) {
+            std::cerr << "ControlServer: Dropping a client that stopped reading its responses" << std::endl;
+            connection.outbox.clear();
+            ::shutdown(connection.fd, SHUT_RDWR);   // The I/O thread notices and drops the connection
+            return;
+        }
+        if (!flushOutbox(connection)) {
+            ::shutdown(connection.fd, SHUT_RDWR);
+            return;
+        }
+        backedUp = wasEmpty && !connection.outbox.empty();
+    }
+    // The I/O thread starts waiting for room on this socket
+    if (backedUp)
+        wake();
+}
+
+bool ControlServer::flushOutbox(Connection& connection)
+{
+    size_t sent = 0;
+    while (sent < connection.outbox.size()) {
+        const ssize_t result = ::send(connection.fd, connection.outbox.data() + sent, connection.outbox.size() - sent,
+                                      MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (result <= 0)
+            return false;
+        sent += static_cast<size_t>(result);
+    }
+    connection.outbox.erase(0, sent);
+    return true;
+}
+
+void ControlServer::closeConnection(Connection& connection)
+{
+    std::lock_guard<std::mutex> lock(connection.mutex);
+    if (connection.fd >= 0) {
+        ::close(connection.fd);
+        connection.fd = -1;
+    }
+}
+
+bool ControlClient::connect(const std::string& socketPath)
+{
+    close();
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address))
+        return false;
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+        return false;
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ControlClient::close()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    inbox_.clear();
+}
+
+int64_t ControlClient::send(const std::string& method, JsonValue params)
+{
+    const int64_t id = nextId_++;
+    JsonValue request = JsonValue::object();
+    request.set("jsonrpc", "2.0").set("id", id).set("method", method).set("params", std::move(params));
+    if (fd_ < 0 || !writeAll(fd_, request.dump() + "\n"))
+        throw ControlError(RpcError::SERVER_ERROR, "connection lost");
+    return id;
+}
+
+JsonValue ControlClient::receive()
+{
+    while (true) {
+        const size_t newline = inbox_.find('\n');
+        if (newline != std::string::npos) {
+            const std::string message = inbox_.substr(0, newline);
+            inbox_.erase(0, newline + 1);
+            std::string error;
+            auto parsed = JsonValue::parse(message, &error);
+            if (!parsed)
+                throw ControlError(RpcError::PARSE_ERROR, "bad response: " + error);
+            return *parsed;
+        }
+
+        char buffer[READ_CHUNK];
+        const ssize_t received = fd_ >= 0 ? ::recv(fd_, buffer, sizeof(buffer), 0) : 0;
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            throw ControlError(RpcError::SERVER_ERROR, "connection lost");
+        inbox_.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+JsonValue ControlClient::call(const std::string& method, JsonValue params)
+{
+    const int64_t id = send(method, std::move(params));
+    while (true) {
+        JsonValue response = receive();
+        if (response["id"].asNumber(-1) != static_cast<double>(id))
+            continue;
+        if (response.has("error"))
+            throw ControlError(response["error"]["code"].asInt(RpcError::SERVER_ERROR), response["error"]["message"].asString());
+        return response["result"];
+    }
+}
+
+int runRemoteCommand(const std::vector<std::string>& args)
+{
+    std::vector<std::string> positional;
+    size_t repeat = 0;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--remote")
+            continue;
+        if (args[i] == "--repeat" && i + 1 < args.size()) {
+            try {
+                repeat = std::stoul(args[++i]);
+            } catch (const std::exception&) {
+                repeat = 0;
+            }
+            continue;
+        }
+        positional.push_back(args[i]);
+    }
+
+    if (positional.size() < 2 || positional.size() > 3) {
+        std::cerr << "Usage: EpiGimp --remote SOCKET METHOD [PARAMS_JSON] [--repeat N]" << std::endl;
+        return 2;
+    }
+
+    JsonValue params = JsonValue::object();
+    if (positional.size() == 3) {
+        std::string error;
+        auto parsed = JsonValue::parse(positional[2], &error);
+        if (!parsed || (!parsed->isObject() && !parsed->isArray())) {
+            std::cerr << "Remote: Params must be a JSON object or array" << (error.empty() ? "" : ": " + error) << std::endl;
+            return 2;
+        }
+        params = *parsed;
+    }
+
+    ControlClient client;
+    if (!client.connect(positional[0])) {
+        std::cerr << "Remote: Cannot connect to " << positional[0] << std::endl;
+        return 1;
+    }
+
+    try {
+        if (repeat == 0) {
+            std::cout << client.call(positional[1], params).dump() << std::endl;
+            return 0;
+        }
+
+        // Keep a bounded number of requests in flight so neither side blocks on a full buffer
+        const auto start = std::chrono::steady_clock::now();
+        size_t sent = 0, received = 0, failed = 0;
+        while (received < repeat) {
+            while (sent < repeat && sent - received < REMOTE_PIPELINE_DEPTH) {
+                client.send(positional[1], params);
+                sent++;
+            }
+            if (client.receive().has("error"))
+                failed++;
+            received++;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::fixed << std::setprecision(1) << "Remote: " << repeat << " x " << positional[1] << " in "
+                  << seconds * 1000.0 << " ms (" << (seconds > 0.0 ? repeat / seconds : 0.0) << " requests/s, "
+                  << failed << " failed)" << std::endl;
+        return failed == 0 ? 0 : 1;
+    } catch (const ControlError& e) {
+        std::cerr << "Remote: " << e.what() << " (" << e.getCode() << ")" << std::endl;
+        return 1;
+    }
+}
+
+} // namespace EpiGimp
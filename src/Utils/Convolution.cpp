@@ -0,0 +1,360 @@
+//Square-kernel convolution for whole layers
+#include "../../include/Utils/Convolution.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace EpiGimp {
+
+namespace Convolution {
+
+namespace {
+
+constexpr int WEIGHT_BITS = 14;              // Finest fixed-point scale a weight gets
+constexpr int MID_BITS = 7;                  // Fractional bits between the row and column passes
+constexpr double SUM_LIMIT = 1 << 30;        // Largest weighted sum, leaving room for bias and rounding
+
+// One weighted input row: the pass adds weight * source[e] for every element e
+struct Tap {
+    const int16_t* source;
+    int16_t weight;
+};
+
+// Fixed-point weights and the shift that brings their sum back to pixel units
+struct FixedWeights {
+    std::vector<int16_t> values;
+    int shift = 0;
+};
+
+// Largest scale with every weight inside int16 and the weighted sum of largestInput under SUM_LIMIT
+FixedWeights quantize(const std::vector<float>& weights, double largestInput)
+{
+    double largest = 0.0, total = 0.0, sum = 0.0;
+    size_t largestIndex = 0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        const double magnitude = std::fabs(weights[i]);
+        if (magnitude > largest) {
+            largest = magnitude;
+            largestIndex = i;
+        }
+        total += magnitude;
+        sum += weights[i];
+    }
+
+    FixedWeights fixed;
+    fixed.shift = WEIGHT_BITS;
+    while (fixed.shift > 0 && (largest * (1 << fixed.shift) > 32767.0 || total * largestInput * (1 << fixed.shift) > SUM_LIMIT))
+        --fixed.shift;
+
+    // Rounding error goes to the largest weight, so a flat area keeps its value exactly
+    const double scale = static_cast<double>(1 << fixed.shift);
+    long rounded = 0;
+    for (float weight : weights) {
+        fixed.values.push_back(static_cast<int16_t>(std::lround(weight * scale)));
+        rounded += fixed.values.back();
+    }
+    const long correction = std::lround(sum * scale) - rounded;
+    fixed.values[largestIndex] = static_cast<int16_t>(std::clamp<long>(fixed.values[largestIndex] + correction, -32768, 32767));
+    return fixed;
+}
+
+// sums[e] = sum of weight * source[e] over the taps, for count elements (a multiple of 8)
+void weightedSum(std::vector<Tap>& taps, int count, int32_t* sums)
+{
+    if (taps.size() % 2)
+        taps.push_back({taps.front().source, 0});   // Taps go in pairs
+
+#if defined(__SSE2__)
+    // Interleave two taps' elements, multiply by their packed weights and add the pair in one pmaddwd
+    int32_t weights[MAX_SIZE * MAX_SIZE / 2 + 1];
+    for (size_t t = 0; t < taps.size(); t += 2) {
+        const uint32_t packed = static_cast<uint16_t>(taps[t].weight) | (static_cast<uint32_t>(static_cast<uint16_t>(taps[t + 1].weight)) << 16);
+        weights[t / 2] = static_cast<int32_t>(packed);
+    }
+    for (int e = 0; e < count; e += 8) {
+        __m128i low = _mm_setzero_si128();
+        __m128i high = _mm_setzero_si128();
+        for (size_t t = 0; t < taps.size(); t += 2) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[t].source + e));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[t + 1].source + e));
+            const __m128i pair = _mm_set1_epi32(weights[t / 2]);
+            low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pair));
+            high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pair));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + e), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + e + 4), high);
+    }
+#else
+    std::fill(sums, sums + count, 0);
+    for (const Tap& tap : taps)
+        for (int e = 0; e < count; ++e)
+            sums[e] += tap.weight * tap.source[e];
+#endif
+}
+
+// Row-pass output: sums scaled down to MID_BITS fractional bits
+void toMid(const int32_t* sums, int count, int shift, int16_t* target)
+{
+#if defined(__SSE2__)
+    const __m128i rounding = _mm_set1_epi32(shift > 0 ? 1 << (shift - 1) : 0);
+    const __m128i bits = _mm_cvtsi32_si128(shift);
+    for (int e = 0; e < count; e += 8) {
+        const __m128i low = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + e)), rounding), bits);
+        const __m128i high = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + e + 4)), rounding), bits);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + e), _mm_packs_epi32(low, high));
+    }
+#else
+    const int32_t rounding = shift > 0 ? 1 << (shift - 1) : 0;
+    for (int e = 0; e < count; ++e)
+        target[e] = static_cast<int16_t>(std::clamp((sums[e] + rounding) >> shift, -32768, 32767));
+#endif
+}
+
+// Final output: sums plus bias scaled to bytes, alpha taken from original
+void toPixels(const int32_t* sums, int pixels, int shift, int32_t bias, const uint8_t* original, uint8_t* target)
+{
+    const int32_t offset = bias + (shift > 0 ? 1 << (shift - 1) : 0);
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i rounding = _mm_set1_epi32(offset);
+    const __m128i bits = _mm_cvtsi32_si128(shift);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int32_t>(0xFF000000u));
+    for (; x + 4 <= pixels; x += 4) {
+        __m128i quarters[4];
+        for (int q = 0; q < 4; ++q)
+            quarters[q] = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x * 4 + q * 4)), rounding), bits);
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(quarters[0], quarters[1]), _mm_packs_epi32(quarters[2], quarters[3]));
+        const __m128i kept = _mm_and_si128(alpha, _mm_loadu_si128(reinterpret_cast<const __m128i*>(original + x * 4)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + x * 4), _mm_or_si128(_mm_andnot_si128(alpha, bytes), kept));
+    }
+#endif
+    for (; x < pixels; ++x) {
+        for (int ch = 0; ch < 3; ++ch)
+            target[x * 4 + ch] = static_cast<uint8_t>(std::clamp((sums[x * 4 + ch] + offset) >> shift, 0, 255));
+        target[x * 4 + 3] = original[x * 4 + 3];
+    }
+}
+
+void widen(const uint8_t* source, int count, int16_t* target)
+{
+    int e = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; e + 16 <= count; e += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + e));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + e), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + e + 8), _mm_unpackhi_epi8(bytes, zero));
+    }
+#endif
+    for (; e < count; ++e)
+        target[e] = source[e];
+}
+
+int roundUp8(int value)
+{
+    return (value + 7) & ~7;
+}
+
+} // namespace
+
+bool Kernel::isValid() const
+{
+    return size >= 1 && size <= MAX_SIZE && size % 2 == 1 && weights.size() == static_cast<size_t>(size) * size;
+}
+
+Kernel identity()
+{
+    return Kernel{1, {1.0f}, 0.0f};
+}
+
+Kernel sharpen(float amount)
+{
+    const float a = amount;
+    return Kernel{3, {0.0f, -a, 0.0f,
+                      -a, 1.0f + 4.0f * a, -a,
+                      0.0f, -a, 0.0f}, 0.0f};
+}
+
+Kernel emboss(float depth)
+{
+    const float d = depth;
+    return Kernel{3, {-d, -d, 0.0f,
+                      -d, 0.0f, d,
+                      0.0f, d, d}, 128.0f};
+}
+
+Kernel edgeDetect(float strength)
+{
+    const float s = strength;
+    return Kernel{3, {-s, -s, -s,
+                      -s, 8.0f * s, -s,
+                      -s, -s, -s}, 0.0f};
+}
+
+Kernel boxBlur(int radius)
+{
+    const int size = 2 * std::clamp(radius, 0, MAX_SIZE / 2) + 1;
+    return Kernel{size, std::vector<float>(static_cast<size_t>(size) * size, 1.0f / static_cast<float>(size * size)), 0.0f};
+}
+
+bool separate(const Kernel& kernel, std::vector<float>& column, std::vector<float>& row)
+{
+    if (!kernel.isValid())
+        return false;
+
+    // Pivot on the largest weight: its row and column fix the pair, every other weight must follow
+    const int n = kernel.size;
+    size_t pivot = 0;
+    for (size_t i = 1; i < kernel.weights.size(); ++i)
+        if (std::fabs(kernel.weights[i]) > std::fabs(kernel.weights[pivot]))
+            pivot = i;
+    const float largest = kernel.weights[pivot];
+    if (largest == 0.0f)
+        return false;
+    const int pivotRow = static_cast<int>(pivot) / n;
+    const int pivotColumn = static_cast<int>(pivot) % n;
+
+    column.assign(n, 0.0f);
+    row.assign(n, 0.0f);
+    for (int i = 0; i < n; ++i) {
+        column[i] = kernel.weights[i * n + pivotColumn] / largest;
+        row[i] = kernel.weights[pivotRow * n + i];
+    }
+    const float tolerance = 1e-5f * std::fabs(largest);
+    for (int y = 0; y < n; ++y)
+        for (int x = 0; x < n; ++x)
+            if (std::fabs(column[y] * row[x] - kernel.weights[y * n + x]) > tolerance)
+                return false;
+
+    // Row weights summing to one in magnitude keep the row pass inside 16 bits
+    float total = 0.0f;
+    for (float weight : row)
+        total += std::fabs(weight);
+    for (float& weight : row)
+        weight /= total;
+    for (float& weight : column)
+        weight *= total;
+    return true;
+}
+
+void apply(Image& image, const Kernel& kernel, Rectangle region, bool bottomUp)
+{
+    if (!image.data)
+        return;
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "Convolution: Image must be RGBA8" << std::endl;
+        return;
+    }
+    if (!kernel.isValid()) {
+        std::cerr << "Convolution: Kernel must be odd, at most " << MAX_SIZE << " wide, with size * size weights" << std::endl;
+        return;
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(region.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(region.y)));
+    const int x1 = std::min(image.width, static_cast<int>(std::ceil(region.x + region.width)));
+    const int y1 = std::min(image.height, static_cast<int>(std::ceil(region.y + region.height)));
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    // Texture-order rows run upwards, so the kernel is turned over to keep its meaning
+    const int n = kernel.size;
+    const int radius = n / 2;
+    std::vector<float> weights = kernel.weights;
+    if (bottomUp)
+        for (int y = 0; y < n / 2; ++y)
+            std::swap_ranges(weights.begin() + y * n, weights.begin() + (y + 1) * n, weights.begin() + (n - 1 - y) * n);
+
+    std::vector<float> column, row;
+    const bool separable = n > 1 && separate(Kernel{n, weights, kernel.bias}, column, row);
+    const FixedWeights full = separable ? FixedWeights{} : quantize(weights, 255.0);
+    const FixedWeights rowWeights = separable ? quantize(row, 255.0) : FixedWeights{};
+    const FixedWeights columnWeights = separable ? quantize(column, 32767.0) : FixedWeights{};
+    const int outputShift = separable ? columnWeights.shift + MID_BITS : full.shift;
+    const int midShift = std::max(0, rowWeights.shift - MID_BITS);
+    const int32_t bias = static_cast<int32_t>(std::lround(static_cast<double>(kernel.bias) * (1 << outputShift)));
+
+    // Copy of the region and its halo, edge pixels repeated, read by every tile
+    const int width = x1 - x0;
+    const int height = y1 - y0;
+    const int paddedWidth = width + 2 * radius;
+    const int paddedHeight = height + 2 * radius;
+    const size_t paddedStride = static_cast<size_t>(paddedWidth) * 4;
+    std::vector<uint8_t> padded(paddedStride * paddedHeight);
+    auto* pixels = static_cast<uint8_t*>(image.data);
+    const size_t imageStride = static_cast<size_t>(image.width) * 4;
+    for (int py = 0; py < paddedHeight; ++py) {
+        const int sy = std::clamp(y0 - radius + py, 0, image.height - 1);
+        const uint8_t* source = pixels + sy * imageStride;
+        uint8_t* target = padded.data() + py * paddedStride;
+        for (int px = 0; px < paddedWidth; ++px) {
+            const int sx = std::clamp(x0 - radius + px, 0, image.width - 1);
+            std::memcpy(target + px * 4, source + sx * 4, 4);
+        }
+    }
+
+    const int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    JobSystem::shared().parallelFor(static_cast<size_t>(tilesX) * tilesY, [&](size_t begin, size_t end) {
+        // Widened input rows, with slack so 8-element steps may read past the last pixel
+        const int wideStride = (TILE_SIZE + 2 * radius) * 4 + 8;
+        const int outStride = roundUp8(TILE_SIZE * 4);
+        std::vector<int16_t> wide(static_cast<size_t>(wideStride) * (TILE_SIZE + 2 * radius), 0);
+        std::vector<int16_t> mid(separable ? static_cast<size_t>(outStride) * (TILE_SIZE + 2 * radius) : 0, 0);
+        std::vector<int32_t> sums(outStride);
+        std::vector<uint8_t> out(static_cast<size_t>(TILE_SIZE) * 4);
+        std::vector<Tap> taps;
+
+        for (size_t t = begin; t < end; ++t) {
+            const int tx = static_cast<int>(t % tilesX) * TILE_SIZE;
+            const int ty = static_cast<int>(t / tilesX) * TILE_SIZE;
+            const int tileWidth = std::min(TILE_SIZE, width - tx);
+            const int tileHeight = std::min(TILE_SIZE, height - ty);
+            const int count = roundUp8(tileWidth * 4);
+            const int inputRows = tileHeight + 2 * radius;
+            const int inputElements = (tileWidth + 2 * radius) * 4;
+
+            for (int r = 0; r < inputRows; ++r)
+                widen(padded.data() + (ty + r) * paddedStride + tx * 4, inputElements, wide.data() + static_cast<size_t>(r) * wideStride);
+
+            if (separable) {
+                for (int r = 0; r < inputRows; ++r) {
+                    taps.clear();
+                    for (int i = 0; i < n; ++i)
+                        taps.push_back({wide.data() + static_cast<size_t>(r) * wideStride + i * 4, rowWeights.values[i]});
+                    weightedSum(taps, count, sums.data());
+                    toMid(sums.data(), count, midShift, mid.data() + static_cast<size_t>(r) * outStride);
+                }
+            }
+
+            for (int y = 0; y < tileHeight; ++y) {
+                taps.clear();
+                if (separable) {
+                    for (int j = 0; j < n; ++j)
+                        taps.push_back({mid.data() + static_cast<size_t>(y + j) * outStride, columnWeights.values[j]});
+                } else {
+                    for (int j = 0; j < n; ++j)
+                        for (int i = 0; i < n; ++i)
+                            taps.push_back({wide.data() + static_cast<size_t>(y + j) * wideStride + i * 4, full.values[j * n + i]});
+                }
+                weightedSum(taps, count, sums.data());
+
+                const uint8_t* original = padded.data() + (ty + y + radius) * paddedStride + (tx + radius) * 4;
+                toPixels(sums.data(), tileWidth, outputShift, bias, original, out.data());
+                std::memcpy(pixels + (y0 + ty + y) * imageStride + static_cast<size_t>(x0 + tx) * 4, out.data(),
+                            static_cast<size_t>(tileWidth) * 4);
+            }
+        }
+    }, 4);
+}
+
+} // namespace Convolution
+
+} // namespace EpiGimp
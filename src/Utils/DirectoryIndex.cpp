@@ -0,0 +1,392 @@
+//Background directory listings cached in memory and kept fresh with inotify
+#include "../../include/Utils/DirectoryIndex.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+bool isWordStart(const std::string& text, size_t i)
+{
+    if (i == 0)
+        return true;
+    const char previous = text[i - 1];
+    if (previous == ' ' || previous == '_' || previous == '-' || previous == '.')
+        return true;
+    return std::isupper(static_cast<unsigned char>(text[i])) && std::islower(static_cast<unsigned char>(previous));
+}
+
+// Greedy match of pattern starting at text[start], which must match pattern[0]
+int scoreFrom(const std::string& pattern, const std::string& text, size_t start)
+{
+    int score = -static_cast<int>(std::min<size_t>(start, 3));
+    size_t previous = start;
+    size_t t = start;
+    for (size_t p = 0; p < pattern.size(); ++p, ++t) {
+        while (t < text.size() && std::tolower(static_cast<unsigned char>(text[t])) != pattern[p])
+            ++t;
+        if (t == text.size())
+            return -1000000;
+
+        score += 1;
+        if (p > 0 && t == previous + 1)
+            score += 8;
+        else if (isWordStart(text, t))
+            score += 6;
+        previous = t;
+    }
+    return score;
+}
+
+} // namespace
+
+DirectoryIndex::DirectoryIndex(size_t maxCached)
+    : maxCached_(std::max<size_t>(maxCached, 1)), useClock_(0), nextJobId_(0), stopping_(false), cancelBelow_(0)
+{
+    inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+        std::cerr << "DirectoryIndex: inotify unavailable, listings are refreshed on every visit" << std::endl;
+
+    worker_ = std::thread(&DirectoryIndex::workerLoop, this);
+}
+
+DirectoryIndex::~DirectoryIndex()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cancelBelow_ = nextJobId_ + 1;
+    wakeWorker_.notify_all();
+    worker_.join();
+
+    if (inotifyFd_ >= 0)
+        ::close(inotifyFd_);
+}
+
+void DirectoryIndex::request(const std::string& path)
+{
+    current_ = path;
+    auto [it, inserted] = states_.try_emplace(path);
+    State& state = it->second;
+    state.lastUsed = ++useClock_;
+
+    // Watch before listing, so changes made while the listing runs are not missed
+    if (inserted && inotifyFd_ >= 0) {
+        const int watch = ::inotify_add_watch(inotifyFd_, path.c_str(), WATCH_MASK);
+        // The kernel hands out one descriptor per inode, so symlinked or respelled paths share it
+        if (watch >= 0) {
+            state.watch = watch;
+            watches_[watch].push_back(path);
+        }
+    }
+
+    // Without a watch nothing tells us about changes, so list again on every visit
+    const bool fresh = state.listing.complete && !state.listing.stale && state.watch >= 0;
+    const bool cancelled = state.busy && state.jobId < cancelBelow_.load();
+    if ((!fresh && !state.busy) || cancelled)
+        startListing(path, state);
+
+    evict();
+}
+
+bool DirectoryIndex::update()
+{
+    readEvents();
+
+    std::vector<Batch> batches;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batches.swap(batches_);
+    }
+
+    bool changed = false;
+    for (auto& batch : batches) {
+        auto it = states_.find(batch.path);
+        if (it == states_.end() || it->second.jobId != batch.jobId)
+            continue;
+
+        State& state = it->second;
+        Listing& listing = state.listing;
+        if (batch.cancelled) {
+            // Whatever streamed in so far stays visible; the next visit lists it again
+            state.busy = false;
+            state.incoming.clear();
+            listing.stale = true;
+            continue;
+        }
+
+        // A refresh keeps the old entries on screen until the new listing is complete
+        const bool buffered = listing.complete;
+        auto& target = buffered ? state.incoming : listing.entries;
+        target.insert(target.end(), std::make_move_iterator(batch.entries.begin()),
+                      std::make_move_iterator(batch.entries.end()));
+
+        if (batch.done) {
+            if (buffered) {
+                listing.entries.swap(state.incoming);
+                state.incoming.clear();
+            }
+            listing.complete = true;
+            listing.error = batch.error;
+            state.busy = false;
+            listing.generation++;
+            changed = true;
+        } else if (!buffered && !batch.entries.empty()) {
+            listing.generation++;
+            changed = true;
+        }
+    }
+
+    // Relist the current directory once a burst of changes has settled a little
+    auto current = states_.find(current_);
+    if (current != states_.end()) {
+        State& state = current->second;
+        if (state.listing.stale && !state.busy &&
+            std::chrono::steady_clock::now() - state.lastStarted >= REFRESH_INTERVAL)
+            startListing(current_, state);
+    }
+
+    return changed;
+}
+
+const DirectoryIndex::Listing* DirectoryIndex::find(const std::string& path) const
+{
+    auto it = states_.find(path);
+    return it == states_.end() ? nullptr : &it->second.listing;
+}
+
+void DirectoryIndex::invalidate(const std::string& path)
+{
+    auto it = states_.find(path);
+    if (it != states_.end())
+        it->second.listing.stale = true;
+}
+
+bool DirectoryIndex::isBusy() const
+{
+    return std::any_of(states_.begin(), states_.end(), [](const auto& state) { return state.second.busy; });
+}
+
+void DirectoryIndex::startListing(const std::string& path, State& state)
+{
+    state.jobId = ++nextJobId_;
+    state.busy = true;
+    state.listing.stale = false;
+    state.lastStarted = std::chrono::steady_clock::now();
+    state.incoming.clear();
+    if (!state.listing.complete && !state.listing.entries.empty()) {
+        state.listing.entries.clear();
+        state.listing.generation++;
+    }
+
+    // Only the newest listing matters; anything older still running stops early
+    cancelBelow_ = state.jobId;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back({state.jobId, path});
+    }
+    wakeWorker_.notify_one();
+}
+
+bool DirectoryIndex::readEvents()
+{
+    if (inotifyFd_ < 0)
+        return false;
+
+    bool any = false;
+    alignas(inotify_event) char buffer[16384];
+    while (true) {
+        const ssize_t length = ::read(inotifyFd_, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (char* p = buffer; p < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            // Events were lost, so any cached listing may be out of date
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (auto& state : states_)
+                    state.second.listing.stale = true;
+                any = true;
+                continue;
+            }
+
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end())
+                continue;
+
+            for (const auto& path : watch->second) {
+                auto state = states_.find(path);
+                if (state == states_.end())
+                    continue;
+                state->second.listing.stale = true;
+                if (event->mask & IN_IGNORED)
+                    state->second.watch = -1;
+            }
+            if (event->mask & IN_IGNORED)
+                watches_.erase(watch);
+            any = true;
+        }
+    }
+    return any;
+}
+
+void DirectoryIndex::evict()
+{
+    while (states_.size() > maxCached_) {
+        auto oldest = states_.end();
+        for (auto it = states_.begin(); it != states_.end(); ++it) {
+            if (it->first == current_ || it->second.busy)
+                continue;
+            if (oldest == states_.end() || it->second.lastUsed < oldest->second.lastUsed)
+                oldest = it;
+        }
+        if (oldest == states_.end())
+            return;
+
+        // Only drop the kernel watch once no other cached path uses it
+        auto watch = watches_.find(oldest->second.watch);
+        if (watch != watches_.end()) {
+            auto& paths = watch->second;
+            paths.erase(std::remove(paths.begin(), paths.end(), oldest->first), paths.end());
+            if (paths.empty()) {
+                ::inotify_rm_watch(inotifyFd_, watch->first);
+                watches_.erase(watch);
+            }
+        }
+        states_.erase(oldest);
+    }
+}
+
+void DirectoryIndex::workerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeWorker_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (stopping_)
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        list(job);
+    }
+}
+
+void DirectoryIndex::list(const Job& job)
+{
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+
+    Batch batch{job.id, job.path, {}, false, false, ""};
+    if (job.id < cancelBelow_.load()) {
+        batch.done = batch.cancelled = true;
+        post(std::move(batch));
+        return;
+    }
+
+    std::error_code ec;
+    fs::directory_iterator it(job.path, fs::directory_options::skip_permission_denied, ec);
+    auto lastFlush = Clock::now();
+    for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        if (job.id < cancelBelow_.load()) {
+            batch.done = batch.cancelled = true;
+            post(std::move(batch));
+            return;
+        }
+
+        // Stat failures only lose the size or date, never the entry
+        const fs::directory_entry& entry = *it;
+        std::error_code entryError;
+        FileEntry file{entry.path().filename().string(), entry.path().string(), entry.is_directory(entryError), 0, 0};
+        if (!file.isDirectory) {
+            const auto size = entry.file_size(entryError);
+            if (!entryError)
+                file.size = static_cast<size_t>(size);
+            const auto writeTime = entry.last_write_time(entryError);
+            if (!entryError)
+                file.modified = static_cast<int64_t>(writeTime.time_since_epoch().count());
+        }
+        batch.entries.push_back(std::move(file));
+
+        if (batch.entries.size() >= BATCH_SIZE || Clock::now() - lastFlush >= BATCH_INTERVAL) {
+            post(std::move(batch));
+            batch = Batch{job.id, job.path, {}, false, false, ""};
+            lastFlush = Clock::now();
+        }
+    }
+
+    if (ec)
+        batch.error = ec.message();
+    batch.done = true;
+    post(std::move(batch));
+}
+
+void DirectoryIndex::post(Batch batch)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    batches_.push_back(std::move(batch));
+}
+
+std::optional<int> DirectoryIndex::fuzzyScore(const std::string& pattern, const std::string& text)
+{
+    if (pattern.empty())
+        return 0;
+
+    std::string lowered(pattern.size(), '\0');
+    std::transform(pattern.begin(), pattern.end(), lowered.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    // Try every place the first character matches and keep the tightest match
+    std::optional<int> best;
+    for (size_t start = 0; start < text.size(); ++start) {
+        if (std::tolower(static_cast<unsigned char>(text[start])) != lowered[0])
+            continue;
+        const int score = scoreFrom(lowered, text, start);
+        if (score > -1000000 && (!best || score > *best))
+            best = score;
+        else if (score <= -1000000)
+            break; // Later starts cannot match either
+    }
+    return best;
+}
+
+std::vector<size_t> DirectoryIndex::fuzzyFilter(const std::string& pattern, const std::vector<FileEntry>& entries)
+{
+    std::vector<std::pair<int, size_t>> matches;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (auto score = fuzzyScore(pattern, entries[i].name))
+            matches.emplace_back(*score, i);
+    }
+
+    // Best score first, then shorter names, then alphabetical
+    std::sort(matches.begin(), matches.end(), [&entries](const auto& a, const auto& b) {
+        if (a.first != b.first)
+            return a.first > b.first;
+        const std::string& left = entries[a.second].name;
+        const std::string& right = entries[b.second].name;
+        if (left.size() != right.size())
+            return left.size() < right.size();
+        return left < right;
+    });
+
+    std::vector<size_t> indices;
+    indices.reserve(matches.size());
+    for (const auto& match : matches)
+        indices.push_back(match.second);
+    return indices;
+}
+
+} // namespace EpiGimp
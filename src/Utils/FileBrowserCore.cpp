@@ -1,5 +1,6 @@
 //FileBrowser core functionality
 #include "../../include/Utils/FileBrowser.hpp"
+#include "../../include/Utils/ThumbnailCache.hpp"
 #include "raylib.h"
 #include <algorithm>
 #include <iostream>
@@ -7,13 +8,16 @@
 namespace EpiGimp {
 
 FileBrowser::FileBrowser() 
-    : selectedIndex_(-1), showHidden_(false), cancelled_(false), lastNavigationTime_(0.0), lastBackspaceTime_(0.0)
+    : viewGeneration_(0), selectedIndex_(-1), showHidden_(false), cancelled_(false), scrollOffset_(0),
+      lastNavigationTime_(0.0), lastBackspaceTime_(0.0)
 {
     currentPath_ = std::filesystem::current_path().string();
-    setSupportedExtensions({".png", ".jpg", ".jpeg", ".bmp", ".tga"});
+    setSupportedExtensions({".png", ".jpg", ".jpeg", ".bmp", ".tga", ".qoi", ".ert", ".epg"});
     loadDirectory();
 }
 
+FileBrowser::~FileBrowser() = default;
+
 void FileBrowser::setSupportedExtensions(const std::vector<std::string>& extensions)
 {
     supportedExtensions_ = extensions;
@@ -25,17 +29,18 @@ void FileBrowser::setShowAllFiles(bool showAll)
         // Temporarily clear extensions to show all files
         tempExtensions_ = supportedExtensions_;
         supportedExtensions_.clear();
-        loadDirectory(); // Reload to show all files
+        loadDirectory(); // Re-filter the cached listing to show all files
     } else {
         // Restore original extensions
         supportedExtensions_ = tempExtensions_;
-        loadDirectory(); // Reload with filtering
+        loadDirectory(); // Re-filter with the extensions
     }
 }
 
 void FileBrowser::setShowHidden(bool show)
 {
     showHidden_ = show;
+    rebuildView();
 }
 
 bool FileBrowser::hasValidExtension(const std::string& filename) const
@@ -68,6 +73,20 @@ bool FileBrowser::canProcessBackspace() const
     return (currentTime - lastBackspaceTime_) > BACKSPACE_DELAY_THRESHOLD;
 }
 
+void FileBrowser::scrollList(int visibleItems)
+{
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f)
+        scrollOffset_ -= static_cast<int>(wheel * 3);
+    if (IsKeyPressed(KEY_PAGE_DOWN))
+        scrollOffset_ += visibleItems;
+    if (IsKeyPressed(KEY_PAGE_UP))
+        scrollOffset_ -= visibleItems;
+
+    int maxOffset = std::max(0, static_cast<int>(entries_.size()) - visibleItems);
+    scrollOffset_ = std::clamp(scrollOffset_, 0, maxOffset);
+}
+
 std::optional<std::string> FileBrowser::getSelectedFile() const
 {
     if (selectedIndex_ >= 0 && selectedIndex_ < static_cast<int>(entries_.size())) {
@@ -87,6 +106,18 @@ std::string FileBrowser::getSaveFileName() const
     return fullPath.string();
 }
 
+void FileBrowser::setDefaultSaveFileName(const std::string& name)
+{
+    if (inputBuffer_.empty())
+        inputBuffer_ = name;
+}
+
+void FileBrowser::setSaveExtension(const std::string& extension)
+{
+    std::filesystem::path name(inputBuffer_.empty() ? "untitled" : inputBuffer_);
+    inputBuffer_ = name.replace_extension(extension).string();
+}
+
 void FileBrowser::reset()
 {
     selectedIndex_ = -1;
@@ -1,6 +1,10 @@
 //FileBrowser dialog rendering functionality
 #include "../../include/Utils/FileBrowser.hpp"
+#include "../../include/Utils/ThumbnailCache.hpp"
 #include "raylib.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
 #include <iostream>
 
 namespace EpiGimp {
@@ -49,38 +53,100 @@ bool FileBrowser::renderOpenDialog(float x, float y, float width, float height)
     float buttonHeight = 30;
     float listHeight = height - 120;
     
+    syncListing();
+    
+    // Type-ahead: typing narrows the list to fuzzy matches of the cached listing
+    std::string filter = filterText_;
+    int key = GetCharPressed();
+    while (key > 0) {
+        if (key >= 32 && key <= 125 && filter.size() < 64)
+            filter += (char)key;
+        key = GetCharPressed();
+    }
+    if (IsKeyPressed(KEY_BACKSPACE) && !filter.empty() && canProcessBackspace()) {
+        filter.pop_back();
+        lastBackspaceTime_ = GetTime();
+    }
+    bool clearFilter = IsKeyPressed(KEY_ESCAPE) && !filter.empty();
+    setFilter(clearFilter ? "" : filter);
+    
     DrawText(currentPath_.c_str(), (int)(x + padding), (int)(y + 35), 12, DARKGRAY);
     
+    std::string status;
+    if (const DirectoryIndex::Listing* listing = index_.find(currentPath_); listing && !listing->error.empty())
+        status = "Cannot read folder: " + listing->error;
+    else if (isLoading())
+        status = "Listing... " + std::to_string(entries_.size()) + " entries";
+    else if (!filterText_.empty())
+        status = "Filter: " + filterText_ + "  (" + std::to_string(entries_.size()) + " matches)";
+    else
+        status = "Type to filter";
+    DrawText(status.c_str(), (int)(x + width - 380), (int)(y + 12), 12, filterText_.empty() ? GRAY : DARKBLUE);
+    
     Rectangle upButton = {x + width - 80, y + 30, 70, 25};
     if (drawButton(upButton, "Up") && canProcessClicks())
         goUp();
     
-    float itemHeight = 25;
-    float listY = y + 65;
-    int visibleItems = (int)(listHeight / itemHeight);
+    if (!thumbnails_)
+        thumbnails_ = std::make_unique<ThumbnailCache>();
+    thumbnails_->update();
     
-    for (int i = 0; i < (int)entries_.size() && i < visibleItems; i++) {
-        Rectangle itemRect = {x + padding, listY + i * itemHeight, width - 2*padding, itemHeight - 2};
+    float itemHeight = 56;
+    float thumbSize = itemHeight - 8;
+    float listY = y + 65;
+    int visibleItems = std::max(1, (int)(listHeight / itemHeight));
+    scrollList(visibleItems);
+    
+    // Only rows on screen ask for thumbnails, so a large folder costs no more than a small one
+    int lastVisible = std::min((int)entries_.size(), scrollOffset_ + visibleItems);
+    for (int i = scrollOffset_; i < lastVisible; i++) {
+        const FileEntry& entry = entries_[i];
+        float rowY = listY + (i - scrollOffset_) * itemHeight;
+        Rectangle itemRect = {x + padding, rowY, width - 2*padding - 8, itemHeight - 2};
         
         bool isSelected = (selectedIndex_ == i);
+        bool clicked = drawButton(itemRect, "", isSelected);
+        
+        Rectangle thumbRect = {itemRect.x + 4, itemRect.y + 3, thumbSize, thumbSize};
+        const Texture2D* thumbnail = entry.isDirectory ? nullptr
+                                                       : thumbnails_->request(entry.fullPath, entry.size, entry.modified);
+        if (thumbnail) {
+            float scale = thumbSize / std::max(thumbnail->width, thumbnail->height);
+            Rectangle dest = {thumbRect.x + (thumbSize - thumbnail->width * scale) / 2,
+                              thumbRect.y + (thumbSize - thumbnail->height * scale) / 2,
+                              thumbnail->width * scale, thumbnail->height * scale};
+            DrawTexturePro(*thumbnail, Rectangle{0, 0, (float)thumbnail->width, (float)thumbnail->height},
+                           dest, Vector2{0, 0}, 0.0f, WHITE);
+        } else {
+            DrawRectangleRec(thumbRect, entry.isDirectory ? Color{200, 210, 230, 255} : Color{220, 220, 220, 255});
+            DrawText(entry.isDirectory ? "DIR" : "...", (int)(thumbRect.x + 12), (int)(thumbRect.y + 18), 12, DARKGRAY);
+        }
         
-        // Draw item with proper selection and hover
-        std::string displayText = entries_[i].isDirectory ? 
-            "[DIR] " + entries_[i].name : entries_[i].name;
-            
-        if (drawButton(itemRect, displayText.c_str(), isSelected) && canProcessClicks()) {
-            if (entries_[i].isDirectory) {
-                if (entries_[i].name == "..") {
+        Color textColor = isSelected ? WHITE : BLACK;
+        DrawText(entry.name.c_str(), (int)(thumbRect.x + thumbSize + 10), (int)(rowY + (itemHeight - 14) / 2), 14, textColor);
+        
+        if (clicked && canProcessClicks()) {
+            if (entry.isDirectory) {
+                if (entry.name == "..") {
                     goUp();
                 } else {
-                    enterDirectory(entries_[i].name);
+                    enterDirectory(entry.name);
                 }
-            } else {
-                selectedIndex_ = i;
+                break; // entries_ was reloaded
             }
+            selectedIndex_ = i;
         }
     }
     
+    // Scroll bar
+    if ((int)entries_.size() > visibleItems) {
+        float trackHeight = visibleItems * itemHeight;
+        float thumbHeight = std::max(20.0f, trackHeight * visibleItems / entries_.size());
+        float thumbY = listY + (trackHeight - thumbHeight) * scrollOffset_ / (entries_.size() - visibleItems);
+        DrawRectangle((int)(x + width - padding - 6), (int)listY, 6, (int)trackHeight, LIGHTGRAY);
+        DrawRectangle((int)(x + width - padding - 6), (int)thumbY, 6, (int)thumbHeight, GRAY);
+    }
+    
     float buttonY = y + height - 40;
     Rectangle openBtn = {x + padding, buttonY, 80, buttonHeight};
     Rectangle cancelBtn = {x + width - 90, buttonY, 80, buttonHeight};
@@ -93,7 +159,7 @@ bool FileBrowser::renderOpenDialog(float x, float y, float width, float height)
         return true; // File selected
     }
     
-    if (cancelClicked || IsKeyPressed(KEY_ESCAPE)) {
+    if (cancelClicked || (IsKeyPressed(KEY_ESCAPE) && !clearFilter)) {
         selectedIndex_ = -1;
         cancelled_ = true;
         return false; // Cancelled
@@ -114,6 +180,8 @@ bool FileBrowser::renderSaveDialog(float x, float y, float width, float height)
     float buttonHeight = 30;
     float listHeight = height - 160; // Leave more space for filename input
     
+    syncListing();
+    
     DrawText(currentPath_.c_str(), (int)(x + padding), (int)(y + 35), 12, DARKGRAY);
     
     Rectangle upButton = {x + width - 80, y + 30, 70, 25};
@@ -174,8 +242,21 @@ bool FileBrowser::renderSaveDialog(float x, float y, float width, float height)
     
     DrawText(inputBuffer_.c_str(), (int)(inputRect.x + 5), (int)(inputRect.y + 8), 14, BLACK);
     
+    // Format shortcuts: PNG for sharing, QOI and raw tiles for fast scratch saves
+    static const char* formatLabels[] = {"PNG", "QOI", "RAW"};
+    static const char* formatExtensions[] = {".png", ".qoi", ".ert"};
+    std::string currentExtension = std::filesystem::path(inputBuffer_).extension().string();
+    std::transform(currentExtension.begin(), currentExtension.end(), currentExtension.begin(), ::tolower);
+    for (int i = 0; i < 3; i++) {
+        Rectangle formatBtn = {inputRect.x + inputRect.width + 10 + i * 63.0f, inputY, 58, 30};
+        if (drawButton(formatBtn, formatLabels[i], currentExtension == formatExtensions[i]) && canProcessClicks()) {
+            setSaveExtension(formatExtensions[i]);
+            lastNavigationTime_ = GetTime();
+        }
+    }
+    
     float helpY = inputY + 35;
-    std::string helpText = "Supported formats: .png, .jpg, .jpeg, .bmp, .tga (auto-adds .png if missing)";
+    std::string helpText = "Supported formats: .png, .jpg, .jpeg, .bmp, .tga, .qoi/.ert fast scratch, .epg project (auto-adds .png if missing)";
     DrawText(helpText.c_str(), (int)(x + padding), (int)(helpY), 12, DARKGRAY);
     
     float buttonY = y + height - 40;
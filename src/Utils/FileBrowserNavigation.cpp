@@ -3,6 +3,7 @@
 #include "raylib.h"
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 
 namespace EpiGimp {
 
@@ -11,6 +12,7 @@ void FileBrowser::setPath(const std::string& path)
     if (std::filesystem::exists(path) && std::filesystem::is_directory(path)) {
         currentPath_ = path;
         selectedIndex_ = -1;
+        filterText_.clear();
         lastNavigationTime_ = GetTime(); // Set delay after navigation
         loadDirectory();
     }
@@ -34,58 +36,85 @@ void FileBrowser::enterDirectory(const std::string& dirname)
 
 void FileBrowser::loadDirectory()
 {
+    // Returns at once; a cached listing shows immediately, a new one streams in
+    index_.request(currentPath_);
+    scrollOffset_ = 0;
+    rebuildView();
+}
+
+void FileBrowser::syncListing()
+{
+    index_.update();
+    const DirectoryIndex::Listing* listing = index_.find(currentPath_);
+    if (!listing || listing->generation != viewGeneration_)
+        rebuildView();
+}
+
+void FileBrowser::rebuildView()
+{
+    std::string selectedName = isValidSelection() ? entries_[selectedIndex_].name : "";
     entries_.clear();
-    
-    try {
-        // Add parent directory entry if not at root
-        std::filesystem::path currentDir(currentPath_);
-        if (currentDir.has_parent_path())
-            entries_.push_back({"..", currentDir.parent_path().string(), true, 0});
-        
-        // Load directory contents
-        for (const auto& entry : std::filesystem::directory_iterator(currentPath_)) {
-            std::string filename = entry.path().filename().string();
-            
-            // Skip hidden files unless requested
-            if (!showHidden_ && filename[0] == '.')
-                continue;
-            
-            bool isDir = entry.is_directory();
-            size_t size = 0;
-            
-            if (!isDir) {
-                // For files, check if it's a supported type (unless showing all files)
-                if (!supportedExtensions_.empty() && !hasValidExtension(filename))
-                    continue;
-                
-                try {
-                    size = entry.file_size();
-                } catch (...) {
-                    size = 0;
-                }
-            }
-            
-            entries_.push_back({
-                filename,
-                entry.path().string(),
-                isDir,
-                size
-            });
-        }
-        
+    selectedIndex_ = -1;
+
+    const DirectoryIndex::Listing* listing = index_.find(currentPath_);
+    viewGeneration_ = listing ? listing->generation : 0;
+
+    // Add parent directory entry if not at root (and not while filtering)
+    std::filesystem::path currentDir(currentPath_);
+    if (currentDir.has_parent_path() && filterText_.empty())
+        entries_.push_back({"..", currentDir.parent_path().string(), true, 0, 0});
+    if (!listing)
+        return;
+
+    std::vector<FileEntry> visible;
+    visible.reserve(listing->entries.size());
+    for (const auto& entry : listing->entries) {
+        // Skip hidden files unless requested
+        if (!showHidden_ && !entry.name.empty() && entry.name[0] == '.')
+            continue;
+        // For files, check if it's a supported type (unless showing all files)
+        if (!entry.isDirectory && !hasValidExtension(entry.name))
+            continue;
+        visible.push_back(entry);
+    }
+
+    if (filterText_.empty()) {
         // Sort entries: directories first, then files
-        std::sort(entries_.begin(), entries_.end(), [](const FileEntry& a, const FileEntry& b) {
-            if (a.name == "..") return true;
-            if (b.name == "..") return false;
-            if (a.isDirectory != b.isDirectory) {
+        std::sort(visible.begin(), visible.end(), [](const FileEntry& a, const FileEntry& b) {
+            if (a.isDirectory != b.isDirectory)
                 return a.isDirectory;
-            }
             return a.name < b.name;
         });
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading directory: " << e.what() << std::endl;
+        entries_.insert(entries_.end(), std::make_move_iterator(visible.begin()), std::make_move_iterator(visible.end()));
+    } else {
+        for (size_t index : DirectoryIndex::fuzzyFilter(filterText_, visible))
+            entries_.push_back(std::move(visible[index]));
+    }
+
+    // Entries stream in and get re-sorted; keep the selection on the same file
+    if (!selectedName.empty()) {
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            if (entries_[i].name == selectedName) {
+                selectedIndex_ = static_cast<int>(i);
+                break;
+            }
+        }
     }
 }
 
+void FileBrowser::setFilter(const std::string& filter)
+{
+    if (filter == filterText_)
+        return;
+    filterText_ = filter;
+    scrollOffset_ = 0;
+    rebuildView();
+}
+
+bool FileBrowser::isLoading() const
+{
+    const DirectoryIndex::Listing* listing = index_.find(currentPath_);
+    return !listing || !listing->complete;
+}
+
 } // namespace EpiGimp
\ No newline at end of file
@@ -39,7 +39,8 @@ std::optional<std::string> showOpenDialog(const std::string& filter)
             if (filter.find("png") != std::string::npos || 
                 filter.find("jpg") != std::string::npos || 
                 filter.find("bmp") != std::string::npos) {
-                cmd += " --file-filter=\"Image files (*.png *.jpg *.jpeg *.bmp *.gif *.tga *.tiff)|*.png *.jpg *.jpeg *.bmp *.gif *.tga *.tiff\"";
+                cmd += " --file-filter=\"Image files (*.png *.jpg *.jpeg *.bmp *.gif *.tga *.tiff *.qoi *.ert)|*.png *.jpg *.jpeg *.bmp *.gif *.tga *.tiff *.qoi *.ert\"";
+                cmd += " --file-filter=\"EpiGimp projects (*.epg)|*.epg\"";
                 cmd += " --file-filter=\"All files|*\"";
             }
         }
@@ -70,6 +71,9 @@ std::optional<std::string> showSaveDialog(const std::string& filter, const std::
         if (!filter.empty()) {
             if (filter.find("png") != std::string::npos) {
                 cmd += " --file-filter=\"PNG files (*.png)|*.png\"";
+                cmd += " --file-filter=\"QOI fast scratch (*.qoi)|*.qoi\"";
+                cmd += " --file-filter=\"Raw tile dump (*.ert)|*.ert\"";
+                cmd += " --file-filter=\"EpiGimp projects (*.epg)|*.epg\"";
                 cmd += " --file-filter=\"All files|*\"";
             }
         }
@@ -81,7 +85,10 @@ std::optional<std::string> showSaveDialog(const std::string& filter, const std::
         
         if (result.find(".png") == std::string::npos && 
             result.find(".jpg") == std::string::npos && 
-            result.find(".bmp") == std::string::npos) {
+            result.find(".bmp") == std::string::npos &&
+            result.find(".qoi") == std::string::npos &&
+            result.find(".ert") == std::string::npos &&
+            result.find(".epg") == std::string::npos) {
             result += ".png";
         }
         
@@ -0,0 +1,154 @@
+//Whole-layer filters offered in the Filters menu
+#include "../../include/Utils/Filters.hpp"
+#include "../../include/Utils/ColorSpace.hpp"
+#include "../../include/Utils/Convolution.hpp"
+#include "../../include/Utils/GaussianBlur.hpp"
+#include <cmath>
+
+namespace EpiGimp {
+
+namespace Filters {
+
+namespace {
+
+// A 3x3 kernel whose weights scale with the amount; pixels arrive in texture order
+LayerFilter kernelFilter(const std::string& name, float amount, Convolution::Kernel (*makeKernel)(float))
+{
+    LayerFilter filter;
+    filter.name = name;
+    filter.amount = amount;
+    filter.minimum = 0.1f;
+    filter.maximum = 10.0f;
+    filter.step = 0.1f;
+    filter.apply = [makeKernel](Image& pixels, Rectangle region, float value, const std::vector<FilterSetting>&) {
+        Convolution::apply(pixels, makeKernel(value), region, true);
+    };
+    filter.reach = [](float) { return 1; };
+    return filter;
+}
+
+// A lookup table filter; tables ignore neighbours, so nothing outside region is read
+LayerFilter toneFilter(const std::string& name, const std::string& amountName, float amount, float minimum, float maximum, float step)
+{
+    LayerFilter filter;
+    filter.name = name;
+    filter.amountName = amountName;
+    filter.amount = amount;
+    filter.minimum = minimum;
+    filter.maximum = maximum;
+    filter.step = step;
+    filter.reach = [](float) { return 0; };
+    return filter;
+}
+
+int rounded(float value)
+{
+    return static_cast<int>(std::lround(value));
+}
+
+} // namespace
+
+LayerFilter gaussianBlur(float sigma)
+{
+    LayerFilter filter;
+    filter.name = "Gaussian Blur";
+    filter.amount = sigma;
+    filter.minimum = GaussianBlur::MIN_SIGMA;
+    filter.maximum = GaussianBlur::MAX_SIGMA;
+    filter.step = 1.0f;
+    filter.amountIsDistance = true;
+    filter.apply = [](Image& pixels, Rectangle region, float amount, const std::vector<FilterSetting>&) {
+        GaussianBlur::blur(pixels, amount, region);
+    };
+    filter.reach = [](float amount) { return static_cast<int>(std::ceil(3.0f * amount)); };
+    return filter;
+}
+
+LayerFilter sharpen(float amount)
+{
+    return kernelFilter("Sharpen", amount, Convolution::sharpen);
+}
+
+LayerFilter emboss(float depth)
+{
+    return kernelFilter("Emboss", depth, Convolution::emboss);
+}
+
+LayerFilter edgeDetect(float strength)
+{
+    return kernelFilter("Edge Detect", strength, Convolution::edgeDetect);
+}
+
+LayerFilter levels(int black, int white, float gamma, int outBlack, int outWhite)
+{
+    LayerFilter filter = toneFilter("Levels", "Gamma", gamma, 0.1f, 10.0f, 0.05f);
+    filter.settings = {FilterSetting{"Black", static_cast<float>(black), 0.0f, 254.0f, 1.0f},
+                       FilterSetting{"White", static_cast<float>(white), 1.0f, 255.0f, 1.0f},
+                       FilterSetting{"Out Black", static_cast<float>(outBlack), 0.0f, 255.0f, 1.0f},
+                       FilterSetting{"Out White", static_cast<float>(outWhite), 0.0f, 255.0f, 1.0f}};
+    filter.table = [](float amount, const std::vector<FilterSetting>& settings) {
+        return ToneLut::levels(rounded(settings[0].value), rounded(settings[1].value), amount,
+                               rounded(settings[2].value), rounded(settings[3].value));
+    };
+    return filter;
+}
+
+LayerFilter curves(float contrast)
+{
+    LayerFilter filter = toneFilter("Curves", "Contrast", contrast, -64.0f, 64.0f, 4.0f);
+    filter.table = [](float amount, const std::vector<FilterSetting>&) {
+        return ToneLut::curves({Vector2{0, 0}, Vector2{64, 64 - amount}, Vector2{192, 192 + amount}, Vector2{255, 255}});
+    };
+    return filter;
+}
+
+LayerFilter invert()
+{
+    LayerFilter filter = toneFilter("Invert", "", 0.0f, 0.0f, 0.0f, 0.0f);
+    filter.table = [](float, const std::vector<FilterSetting>&) { return ToneLut::invert(); };
+    return filter;
+}
+
+LayerFilter posterize(int levels)
+{
+    LayerFilter filter = toneFilter("Posterize", "Levels", static_cast<float>(levels), 2.0f, 64.0f, 1.0f);
+    filter.table = [](float amount, const std::vector<FilterSetting>&) { return ToneLut::posterize(rounded(amount)); };
+    return filter;
+}
+
+LayerFilter threshold(int level)
+{
+    LayerFilter filter = toneFilter("Threshold", "Level", static_cast<float>(level), 0.0f, 255.0f, 1.0f);
+    filter.table = [](float amount, const std::vector<FilterSetting>&) { return ToneLut::threshold(rounded(amount)); };
+    return filter;
+}
+
+LayerFilter hueSaturation(float hue, float saturation, float lightness)
+{
+    LayerFilter filter;
+    filter.name = "Hue-Saturation";
+    filter.amountName = "Hue";
+    filter.amount = hue;
+    filter.minimum = -180.0f;
+    filter.maximum = 180.0f;
+    filter.step = 1.0f;
+    filter.settings = {FilterSetting{"Saturation", saturation, -100.0f, 100.0f, 1.0f},
+                       FilterSetting{"Lightness", lightness, -100.0f, 100.0f, 1.0f}};
+    filter.apply = [](Image& pixels, Rectangle region, float amount, const std::vector<FilterSetting>& settings) {
+        ColorSpace::adjustHsl(pixels, ColorSpace::HslShift{amount, settings[0].value / 100.0f, settings[1].value / 100.0f}, region);
+    };
+    filter.reach = [](float) { return 0; };
+    return filter;
+}
+
+void run(const LayerFilter& filter, Image& pixels, Rectangle region, float amount)
+{
+    if (filter.table)
+        ToneLut::apply(pixels, filter.table(amount, filter.settings), region);
+    else if (filter.apply)
+        filter.apply(pixels, region, amount, filter.settings);
+}
+
+} // namespace Filters
+
+} // namespace EpiGimp
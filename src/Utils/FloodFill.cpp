@@ -0,0 +1,364 @@
+//Scanline flood fill for the bucket tool
+#include "../../include/Utils/FloodFill.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace EpiGimp {
+
+namespace FloodFill {
+
+namespace {
+
+constexpr size_t RIM_ROWS_PER_JOB = 64;
+
+struct Seed {
+    int y;
+    int x0;
+    int x1;
+};
+
+// Colour test against the seed pixel; pixels are RGBA8 read as one 32-bit word
+class Matcher {
+private:
+    uint32_t seed_;
+    int tolerance_;
+#if defined(__SSE2__)
+    __m128i seedVector_;
+    __m128i toleranceVector_;
+
+    // All ones in lane i when pixel i of the four matches
+    __m128i matchLanes(const uint32_t* pixels) const {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        const __m128i difference = _mm_or_si128(_mm_subs_epu8(value, seedVector_), _mm_subs_epu8(seedVector_, value));
+        const __m128i excess = _mm_subs_epu8(difference, toleranceVector_);
+        return _mm_cmpeq_epi32(excess, _mm_setzero_si128());
+    }
+
+    // Bit i set when pixel i of the four matches
+    int matchBits(const uint32_t* pixels) const {
+        return _mm_movemask_ps(_mm_castsi128_ps(matchLanes(pixels)));
+    }
+#endif
+
+public:
+    Matcher(uint32_t seed, int tolerance) : seed_(seed), tolerance_(std::clamp(tolerance, 0, 255)) {
+#if defined(__SSE2__)
+        seedVector_ = _mm_set1_epi32(static_cast<int>(seed));
+        toleranceVector_ = _mm_set1_epi8(static_cast<char>(tolerance_));
+#endif
+    }
+
+    bool matches(uint32_t pixel) const {
+        for (int shift = 0; shift < 32; shift += 8) {
+            const int a = static_cast<int>((pixel >> shift) & 0xFF);
+            const int b = static_cast<int>((seed_ >> shift) & 0xFF);
+            if (std::abs(a - b) > tolerance_)
+                return false;
+        }
+        return true;
+    }
+
+    // First column >= x in [x, limit] that matches, limit + 1 if none does
+    int nextMatch(const uint32_t* row, int x, int limit) const {
+#if defined(__SSE2__)
+        for (; x + 4 <= limit + 1; x += 4) {
+            if (const int bits = matchBits(row + x))
+                return x + __builtin_ctz(static_cast<unsigned>(bits));
+        }
+#endif
+        for (; x <= limit; ++x) {
+            if (matches(row[x]))
+                return x;
+        }
+        return limit + 1;
+    }
+
+    // First column >= x that does not match, width if the run reaches the edge
+    int runEnd(const uint32_t* row, int x, int width) const {
+#if defined(__SSE2__)
+        for (; x + 4 <= width; x += 4) {
+            const int bits = matchBits(row + x);
+            if (bits != 0xF)
+                return x + __builtin_ctz(static_cast<unsigned>(~bits & 0xF));
+        }
+#endif
+        while (x < width && matches(row[x]))
+            ++x;
+        return x;
+    }
+
+    // 255 for every matching pixel of row[0, count), 0 otherwise
+    void matchRow(const uint32_t* row, int count, uint8_t* out) const {
+        int x = 0;
+#if defined(__SSE2__)
+        // Lanes are 0 or -1, so signed packing narrows them to bytes without changing them
+        for (; x + 16 <= count; x += 16) {
+            const __m128i low = _mm_packs_epi32(matchLanes(row + x), matchLanes(row + x + 4));
+            const __m128i high = _mm_packs_epi32(matchLanes(row + x + 8), matchLanes(row + x + 12));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packs_epi16(low, high));
+        }
+#endif
+        for (; x < count; ++x)
+            out[x] = matches(row[x]) ? 255 : 0;
+    }
+
+    // Leftmost column of the matching run that contains x
+    int runStart(const uint32_t* row, int x) const {
+#if defined(__SSE2__)
+        while (x >= 4) {
+            const int bits = matchBits(row + x - 4);
+            if (bits != 0xF) {
+                int highest = 3;
+                while ((bits >> highest) & 1)
+                    --highest;
+                return x - 4 + highest + 1;
+            }
+            x -= 4;
+        }
+#endif
+        while (x > 0 && matches(row[x - 1]))
+            --x;
+        return x;
+    }
+};
+
+bool isVisited(const std::vector<uint64_t>& visited, size_t index)
+{
+    return (visited[index >> 6] >> (index & 63)) & 1;
+}
+
+void markVisited(std::vector<uint64_t>& visited, size_t index, size_t count)
+{
+    while (count > 0) {
+        const size_t bit = index & 63;
+        const size_t bits = std::min<size_t>(64 - bit, count);
+        const uint64_t mask = bits == 64 ? ~uint64_t(0) : ((uint64_t(1) << bits) - 1) << bit;
+        visited[index >> 6] |= mask;
+        index += bits;
+        count -= bits;
+    }
+}
+
+// First unvisited index in [index, end), end if there is none; 64 pixels per step
+size_t nextUnvisited(const std::vector<uint64_t>& visited, size_t index, size_t end)
+{
+    while (index < end) {
+        const uint64_t free = ~visited[index >> 6] >> (index & 63);
+        if (free)
+            return std::min(end, index + __builtin_ctzll(free));
+        index = (index | 63) + 1;
+    }
+    return end;
+}
+
+// Outside pixels touching the region get the share of their 3x3 neighbourhood inside it.
+// Only 255 counts as inside, and each pass writes rows of one parity while reading the
+// other, so rows can run in parallel without seeing each other's partial values.
+void antialiasRim(std::vector<uint8_t>& mask, int width, int height, int x0, int y0, int x1, int y1)
+{
+    for (int parity = 0; parity < 2; ++parity) {
+        const int first = y0 + ((y0 & 1) != parity ? 1 : 0);
+        if (first > y1)
+            continue;
+        const size_t rows = static_cast<size_t>((y1 - first) / 2 + 1);
+        JobSystem::shared().parallelFor(rows, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r) {
+                const int y = first + static_cast<int>(r) * 2;
+                uint8_t* row = mask.data() + static_cast<size_t>(y) * width;
+                for (int x = x0; x <= x1; ++x) {
+                    if (row[x])
+                        continue;
+                    int inside = 0;
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        if (y + dy < 0 || y + dy >= height)
+                            continue;
+                        const uint8_t* neighbours = mask.data() + static_cast<size_t>(y + dy) * width;
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            if (x + dx >= 0 && x + dx < width && neighbours[x + dx] == 255)
+                                inside++;
+                        }
+                    }
+                    if (inside)
+                        row[x] = static_cast<uint8_t>(inside * 255 / 9);
+                }
+            }
+        }, RIM_ROWS_PER_JOB);
+    }
+}
+
+} // namespace
+
+bool withinTolerance(Color a, Color b, int tolerance)
+{
+    return std::abs(a.r - b.r) <= tolerance && std::abs(a.g - b.g) <= tolerance &&
+           std::abs(a.b - b.b) <= tolerance && std::abs(a.a - b.a) <= tolerance;
+}
+
+size_t forEachSpan(const Image& source, int x, int y, int tolerance, const SpanCallback& span)
+{
+    if (!source.data || x < 0 || y < 0 || x >= source.width || y >= source.height)
+        return 0;
+    if (source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "FloodFill: Source must be RGBA8" << std::endl;
+        return 0;
+    }
+
+    const int width = source.width;
+    const int height = source.height;
+    const auto* pixels = static_cast<const uint32_t*>(source.data);
+    const Matcher matcher(pixels[static_cast<size_t>(y) * width + x], tolerance);
+
+    std::vector<uint64_t> visited((static_cast<size_t>(width) * height + 63) / 64, 0);
+    std::vector<Seed> stack{{y, x, x}};
+    size_t filled = 0;
+
+    while (!stack.empty()) {
+        const Seed seed = stack.back();
+        stack.pop_back();
+        const uint32_t* row = pixels + static_cast<size_t>(seed.y) * width;
+        const size_t rowStart = static_cast<size_t>(seed.y) * width;
+
+        int cx = seed.x0;
+        while (cx <= seed.x1) {
+            // A visited pixel means its whole run is done: skip it on the bitset alone
+            if (isVisited(visited, rowStart + cx)) {
+                cx = static_cast<int>(nextUnvisited(visited, rowStart + cx, rowStart + seed.x1 + 1) - rowStart);
+                continue;
+            }
+            cx = matcher.nextMatch(row, cx, seed.x1);
+            if (cx > seed.x1)
+                break;
+            if (isVisited(visited, rowStart + cx))
+                continue;
+
+            // Left of a match past x0 is a mismatch, so only a match at x0 can extend left
+            const int start = cx == seed.x0 ? matcher.runStart(row, cx) : cx;
+            const int end = matcher.runEnd(row, cx, width) - 1;
+            markVisited(visited, rowStart + start, static_cast<size_t>(end - start + 1));
+            span(seed.y, start, end);
+            filled += static_cast<size_t>(end - start + 1);
+
+            if (seed.y > 0)
+                stack.push_back({seed.y - 1, start, end});
+            if (seed.y + 1 < height)
+                stack.push_back({seed.y + 1, start, end});
+            cx = end + 2;   // end + 1 does not match
+        }
+    }
+    return filled;
+}
+
+std::vector<uint8_t> regionMask(const Image& source, int x, int y, const Options& options, Rectangle* bounds)
+{
+    if (!source.data || x < 0 || y < 0 || x >= source.width || y >= source.height)
+        return {};
+
+    const int width = source.width;
+    const int height = source.height;
+    std::vector<uint8_t> mask(static_cast<size_t>(width) * height, 0);
+    int minX = width, minY = height, maxX = -1, maxY = -1;
+
+    const size_t filled = forEachSpan(source, x, y, options.tolerance, [&](int row, int x0, int x1) {
+        std::memset(mask.data() + static_cast<size_t>(row) * width + x0, 255, static_cast<size_t>(x1 - x0 + 1));
+        minX = std::min(minX, x0);
+        maxX = std::max(maxX, x1);
+        minY = std::min(minY, row);
+        maxY = std::max(maxY, row);
+    });
+    if (filled == 0)
+        return {};
+
+    if (options.antialias) {
+        minX = std::max(0, minX - 1);
+        minY = std::max(0, minY - 1);
+        maxX = std::min(width - 1, maxX + 1);
+        maxY = std::min(height - 1, maxY + 1);
+        antialiasRim(mask, width, height, minX, minY, maxX, maxY);
+    }
+
+    if (bounds) {
+        *bounds = Rectangle{static_cast<float>(minX), static_cast<float>(minY),
+                            static_cast<float>(maxX - minX + 1), static_cast<float>(maxY - minY + 1)};
+    }
+    return mask;
+}
+
+SelectionMask selectRegion(const Image& source, int x, int y, int tolerance, bool bottomUp)
+{
+    SelectionMask mask(source.width, source.height);
+    const int height = source.height;
+    forEachSpan(source, x, y, tolerance, [&](int row, int x0, int x1) {
+        mask.setSpan(bottomUp ? height - 1 - row : row, x0, x1, 255);
+    });
+    mask.compact();
+    return mask;
+}
+
+SelectionMask selectSimilar(const Image& source, int x, int y, int tolerance, bool bottomUp)
+{
+    if (!source.data || x < 0 || y < 0 || x >= source.width || y >= source.height)
+        return SelectionMask(source.width, source.height);
+    if (source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "FloodFill: Source must be RGBA8" << std::endl;
+        return SelectionMask(source.width, source.height);
+    }
+
+    const int width = source.width;
+    const int height = source.height;
+    const auto* pixels = static_cast<const uint32_t*>(source.data);
+    const Matcher matcher(pixels[static_cast<size_t>(y) * width + x], tolerance);
+
+    return SelectionMask::fromTiles(width, height, [&](int x0, int y0, int tileWidth, int tileHeight, uint8_t* values) {
+        for (int row = 0; row < tileHeight; ++row) {
+            const int sourceRow = bottomUp ? height - 1 - (y0 + row) : y0 + row;
+            matcher.matchRow(pixels + static_cast<size_t>(sourceRow) * width + x0, tileWidth,
+                             values + static_cast<size_t>(row) * SelectionMask::TILE_SIZE);
+        }
+    });
+}
+
+void fillMask(Image& target, const std::vector<uint8_t>& mask, Color color, Rectangle bounds)
+{
+    if (!target.data || target.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 ||
+        mask.size() != static_cast<size_t>(target.width) * target.height)
+        return;
+
+    const int x0 = std::max(0, static_cast<int>(bounds.x));
+    const int y0 = std::max(0, static_cast<int>(bounds.y));
+    const int x1 = std::min(target.width, static_cast<int>(bounds.x + bounds.width));
+    const int y1 = std::min(target.height, static_cast<int>(bounds.y + bounds.height));
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    auto* pixels = static_cast<uint8_t*>(target.data);
+    const unsigned source[3] = {color.r, color.g, color.b};
+    JobSystem::shared().parallelFor(static_cast<size_t>(y1 - y0), [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const size_t rowIndex = static_cast<size_t>(y0 + static_cast<int>(r)) * target.width;
+            for (int x = x0; x < x1; ++x) {
+                const unsigned alpha = (mask[rowIndex + x] * color.a + 127) / 255;
+                if (alpha == 0)
+                    continue;
+
+                // Straight-alpha "over"
+                uint8_t* pixel = pixels + (rowIndex + x) * 4;
+                const unsigned below = pixel[3] * (255 - alpha);
+                const unsigned outAlpha = alpha * 255 + below;   // Scaled by 255
+                for (int c = 0; c < 3; ++c)
+                    pixel[c] = static_cast<uint8_t>((source[c] * alpha * 255 + pixel[c] * below + outAlpha / 2) / outAlpha);
+                pixel[3] = static_cast<uint8_t>((outAlpha + 127) / 255);
+            }
+        }
+    }, RIM_ROWS_PER_JOB);
+}
+
+} // namespace FloodFill
+
+} // namespace EpiGimp
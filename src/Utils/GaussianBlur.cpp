@@ -0,0 +1,277 @@
+//Recursive Gaussian blur for whole layers
+#include "../../include/Utils/GaussianBlur.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace EpiGimp {
+
+namespace GaussianBlur {
+
+namespace {
+
+constexpr int ROW_BATCH = 4;                            // Rows filtered side by side, interleaved pixel by pixel
+constexpr int ROW_FLOATS = ROW_BATCH * 4;
+constexpr int STRIP_COLUMNS = 16;                       // Columns filtered side by side: a cache line of each row
+constexpr int STRIP_FLOATS = STRIP_COLUMNS * 4;
+
+// Poles of the third-order filter at its reference scale (Young, van Vliet and van Ginkel)
+const std::complex<double> PAIR_POLE(1.40098, 1.00236);
+constexpr double REAL_POLE = 1.85132;
+
+// Variance of the forward-backward filter with its poles scaled by 1/q
+double variance(double q)
+{
+    const std::complex<double> pair = std::pow(PAIR_POLE, 1.0 / q);
+    const double real = std::pow(REAL_POLE, 1.0 / q);
+    const std::complex<double> pairTerm = pair / ((pair - 1.0) * (pair - 1.0));
+    return 2.0 * (2.0 * pairTerm.real() + real / ((real - 1.0) * (real - 1.0)));
+}
+
+#if defined(__AVX__)
+using Lane = __m256;
+constexpr int LANE_FLOATS = 8;
+Lane laneLoad(const float* p) { return _mm256_loadu_ps(p); }
+void laneStore(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+Lane laneSet(float v) { return _mm256_set1_ps(v); }
+Lane laneAdd(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+Lane laneMul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+#elif defined(__SSE2__)
+using Lane = __m128;
+constexpr int LANE_FLOATS = 4;
+Lane laneLoad(const float* p) { return _mm_loadu_ps(p); }
+void laneStore(float* p, Lane v) { _mm_storeu_ps(p, v); }
+Lane laneSet(float v) { return _mm_set1_ps(v); }
+Lane laneAdd(Lane a, Lane b) { return _mm_add_ps(a, b); }
+Lane laneMul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+#else
+using Lane = float;
+constexpr int LANE_FLOATS = 1;
+Lane laneLoad(const float* p) { return *p; }
+void laneStore(float* p, Lane v) { *p = v; }
+Lane laneSet(float v) { return v; }
+Lane laneAdd(Lane a, Lane b) { return a + b; }
+Lane laneMul(Lane a, Lane b) { return a * b; }
+#endif
+
+// Both sections, forward then backward, over count samples of WIDTH floats each, stored one
+// after the other. Each lane is its own recursion, so the lanes of a sample hide each
+// other's latency; every state starts at the edge sample, as if it carried on
+template <int WIDTH>
+void filterLine(float* data, int count, const Coefficients& c)
+{
+    constexpr int LANES = WIDTH / LANE_FLOATS;
+    const Lane real = laneSet(c.real), realGain = laneSet(c.realGain);
+    const Lane c1 = laneSet(c.c1), c2 = laneSet(c.c2), pairGain = laneSet(c.pairGain);
+    Lane r[LANES], u1[LANES], u2[LANES];
+
+    const auto run = [&](float* first, std::ptrdiff_t step) {
+        for (int l = 0; l < LANES; ++l)
+            r[l] = u1[l] = u2[l] = laneLoad(first + l * LANE_FLOATS);
+        float* sample = first;
+        for (int i = 0; i < count; ++i, sample += step) {
+            for (int l = 0; l < LANES; ++l) {
+                r[l] = laneAdd(laneMul(realGain, laneLoad(sample + l * LANE_FLOATS)), laneMul(real, r[l]));
+                const Lane u = laneAdd(laneMul(pairGain, r[l]), laneAdd(laneMul(c1, u1[l]), laneMul(c2, u2[l])));
+                u2[l] = u1[l];
+                u1[l] = u;
+                laneStore(sample + l * LANE_FLOATS, u);
+            }
+        }
+    };
+    run(data, WIDTH);
+    run(data + static_cast<size_t>(count - 1) * WIDTH, -WIDTH);
+}
+
+// One RGBA pixel as four floats, going in and out of the 8-bit image
+#if defined(__SSE2__)
+using Pixel = __m128;
+
+Pixel loadPixel(const uint8_t* source)
+{
+    int32_t packed;
+    std::memcpy(&packed, source, 4);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(packed);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+// Rounds, and saturates to 0..255 in the packs
+void storePixel(uint8_t* target, Pixel pixel)
+{
+    const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(pixel), _mm_setzero_si128());
+    const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+    std::memcpy(target, &packed, 4);
+}
+
+Pixel loadFloats(const float* source) { return _mm_loadu_ps(source); }
+void storeFloats(float* target, Pixel pixel) { _mm_storeu_ps(target, pixel); }
+
+// Colour scaled by alpha / 255 (or its inverse), alpha itself by 1
+Pixel premultiply(Pixel pixel)
+{
+    const __m128 alpha = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128 weight = _mm_add_ps(_mm_mul_ps(alpha, _mm_setr_ps(1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 0.0f)),
+                                     _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+    return _mm_mul_ps(pixel, weight);
+}
+
+Pixel unpremultiply(Pixel pixel)
+{
+    const __m128 alpha = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128 visible = _mm_cmpge_ps(alpha, _mm_set1_ps(0.5f));    // Alpha that rounds to 1 or more
+    const __m128 inverse = _mm_and_ps(visible, _mm_div_ps(_mm_set1_ps(255.0f), alpha));
+    const __m128 weight = _mm_add_ps(_mm_mul_ps(inverse, _mm_setr_ps(1.0f, 1.0f, 1.0f, 0.0f)),
+                                     _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+    return _mm_mul_ps(pixel, weight);
+}
+#else
+struct Pixel {
+    float channels[4];
+};
+
+Pixel loadPixel(const uint8_t* source)
+{
+    return Pixel{{static_cast<float>(source[0]), static_cast<float>(source[1]),
+                  static_cast<float>(source[2]), static_cast<float>(source[3])}};
+}
+
+void storePixel(uint8_t* target, Pixel pixel)
+{
+    for (int ch = 0; ch < 4; ++ch)
+        target[ch] = static_cast<uint8_t>(std::clamp(pixel.channels[ch] + 0.5f, 0.0f, 255.0f));
+}
+
+Pixel loadFloats(const float* source)
+{
+    return Pixel{{source[0], source[1], source[2], source[3]}};
+}
+
+void storeFloats(float* target, Pixel pixel)
+{
+    std::memcpy(target, pixel.channels, sizeof(pixel.channels));
+}
+
+Pixel premultiply(Pixel pixel)
+{
+    for (int ch = 0; ch < 3; ++ch)
+        pixel.channels[ch] *= pixel.channels[3] / 255.0f;
+    return pixel;
+}
+
+Pixel unpremultiply(Pixel pixel)
+{
+    const float inverse = pixel.channels[3] >= 0.5f ? 255.0f / pixel.channels[3] : 0.0f;
+    for (int ch = 0; ch < 3; ++ch)
+        pixel.channels[ch] *= inverse;
+    return pixel;
+}
+#endif
+
+} // namespace
+
+Coefficients coefficients(float sigma)
+{
+    const double target = static_cast<double>(std::clamp(sigma, MIN_SIGMA, MAX_SIGMA));
+
+    // Variance grows with q: bisect for the scale that gives sigma
+    double low = 0.01, high = 4.0 * target + 10.0;
+    for (int i = 0; i < 100; ++i) {
+        const double middle = 0.5 * (low + high);
+        (variance(middle) < target * target ? low : high) = middle;
+    }
+    const double q = 0.5 * (low + high);
+
+    // Poles inside the unit circle, each section normalised to unit gain at DC
+    const std::complex<double> pair = 1.0 / std::pow(PAIR_POLE, 1.0 / q);
+    const double real = 1.0 / std::pow(REAL_POLE, 1.0 / q);
+    const double c1 = 2.0 * pair.real();
+    const double c2 = -std::norm(pair);
+    return Coefficients{static_cast<float>(real), static_cast<float>(1.0 - real),
+                        static_cast<float>(c1), static_cast<float>(c2), static_cast<float>(1.0 - c1 - c2)};
+}
+
+void blur(Image& image, float sigma, Rectangle region)
+{
+    if (!image.data || sigma < MIN_SIGMA)
+        return;
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        std::cerr << "GaussianBlur: Image must be RGBA8" << std::endl;
+        return;
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(region.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(region.y)));
+    const int x1 = std::min(image.width, static_cast<int>(std::ceil(region.x + region.width)));
+    const int y1 = std::min(image.height, static_cast<int>(std::ceil(region.y + region.height)));
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    const Coefficients c = coefficients(sigma);
+    const int width = x1 - x0;
+    const int height = y1 - y0;
+    auto* pixels = static_cast<uint8_t*>(image.data);
+    const size_t rowBytes = static_cast<size_t>(image.width) * 4;
+
+    // Rows, a batch at a time: straight colour in, premultiplied out
+    const size_t batches = (static_cast<size_t>(height) + ROW_BATCH - 1) / ROW_BATCH;
+    JobSystem::shared().parallelFor(batches, [&](size_t begin, size_t end) {
+        std::vector<float> line(static_cast<size_t>(width) * ROW_FLOATS, 0.0f);
+        for (size_t b = begin; b < end; ++b) {
+            const int rowStart = y0 + static_cast<int>(b) * ROW_BATCH;
+            const int rows = std::min(ROW_BATCH, y1 - rowStart);
+            for (int k = 0; k < rows; ++k) {
+                const uint8_t* source = pixels + (rowStart + k) * rowBytes + static_cast<size_t>(x0) * 4;
+                for (int x = 0; x < width; ++x)
+                    storeFloats(line.data() + static_cast<size_t>(x) * ROW_FLOATS + k * 4, premultiply(loadPixel(source + x * 4)));
+            }
+            filterLine<ROW_FLOATS>(line.data(), width, c);
+            for (int k = 0; k < rows; ++k) {
+                uint8_t* target = pixels + (rowStart + k) * rowBytes + static_cast<size_t>(x0) * 4;
+                for (int x = 0; x < width; ++x)
+                    storePixel(target + x * 4, loadFloats(line.data() + static_cast<size_t>(x) * ROW_FLOATS + k * 4));
+            }
+        }
+    });
+
+    // Columns, a strip at a time: premultiplied in, straight colour out
+    const size_t strips = (static_cast<size_t>(width) + STRIP_COLUMNS - 1) / STRIP_COLUMNS;
+    JobSystem::shared().parallelFor(strips, [&](size_t begin, size_t end) {
+        std::vector<float> strip(static_cast<size_t>(height) * STRIP_FLOATS, 0.0f);
+        for (size_t s = begin; s < end; ++s) {
+            const int columnStart = x0 + static_cast<int>(s) * STRIP_COLUMNS;
+            const int columns = std::min(STRIP_COLUMNS, x1 - columnStart);
+            for (int y = 0; y < height; ++y) {
+                const uint8_t* source = pixels + (y0 + y) * rowBytes + static_cast<size_t>(columnStart) * 4;
+                for (int x = 0; x < columns; ++x)
+                    storeFloats(strip.data() + static_cast<size_t>(y) * STRIP_FLOATS + x * 4, loadPixel(source + x * 4));
+            }
+            filterLine<STRIP_FLOATS>(strip.data(), height, c);
+            for (int y = 0; y < height; ++y) {
+                uint8_t* target = pixels + (y0 + y) * rowBytes + static_cast<size_t>(columnStart) * 4;
+                for (int x = 0; x < columns; ++x)
+                    storePixel(target + x * 4, unpremultiply(loadFloats(strip.data() + static_cast<size_t>(y) * STRIP_FLOATS + x * 4)));
+            }
+        }
+    });
+}
+
+void blur(Image& image, float sigma)
+{
+    blur(image, sigma, Rectangle{0, 0, static_cast<float>(image.width), static_cast<float>(image.height)});
+}
+
+} // namespace GaussianBlur
+
+} // namespace EpiGimp
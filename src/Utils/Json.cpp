@@ -0,0 +1,402 @@
+//Minimal JSON value with a parser and a compact writer
+#include "../../include/Utils/Json.hpp"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr int MAX_DEPTH = 64;
+
+const JsonValue& nullValue()
+{
+    static const JsonValue value;
+    return value;
+}
+
+class Parser {
+private:
+    const std::string& text_;
+    size_t pos_ = 0;
+    std::string error_;
+
+public:
+    explicit Parser(const std::string& text) : text_(text) {}
+
+    const std::string& getError() const { return error_; }
+
+    bool parseDocument(JsonValue& value)
+    {
+        if (!parseValue(value, 0))
+            return false;
+        skipWhitespace();
+        if (pos_ != text_.size())
+            return fail("trailing characters");
+        return true;
+    }
+
+private:
+    bool fail(const std::string& message)
+    {
+        if (error_.empty())
+            error_ = message + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+            pos_++;
+    }
+
+    bool consume(const char* literal)
+    {
+        const size_t length = std::strlen(literal);
+        if (text_.compare(pos_, length, literal) != 0)
+            return false;
+        pos_ += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if (depth > MAX_DEPTH)
+            return fail("nesting too deep");
+
+        skipWhitespace();
+        if (pos_ >= text_.size())
+            return fail("unexpected end of input");
+
+        const char c = text_[pos_];
+        if (c == '{')
+            return parseObject(value, depth);
+        if (c == '[')
+            return parseArray(value, depth);
+        if (c == '"') {
+            std::string text;
+            if (!parseString(text))
+                return false;
+            value = JsonValue(std::move(text));
+            return true;
+        }
+        if (consume("true")) { value = JsonValue(true); return true; }
+        if (consume("false")) { value = JsonValue(false); return true; }
+        if (consume("null")) { value = JsonValue(); return true; }
+        return parseNumber(value);
+    }
+
+    bool parseNumber(JsonValue& value)
+    {
+        const size_t start = pos_;
+        if (pos_ < text_.size() && text_[pos_] == '-')
+            pos_++;
+        while (pos_ < text_.size() && (std::isdigit(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '.' ||
+                                       text_[pos_] == 'e' || text_[pos_] == 'E' || text_[pos_] == '+' || text_[pos_] == '-'))
+            pos_++;
+        if (pos_ == start)
+            return fail("unexpected character");
+
+        const std::string token = text_.substr(start, pos_ - start);
+        char* end = nullptr;
+        const double number = std::strtod(token.c_str(), &end);
+        if (end != token.c_str() + token.size() || !std::isfinite(number))
+            return fail("invalid number");
+        value = JsonValue(number);
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t codepoint)
+    {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(uint32_t& codepoint)
+    {
+        if (pos_ + 4 > text_.size())
+            return fail("truncated escape");
+        codepoint = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = text_[pos_++];
+            codepoint <<= 4;
+            if (c >= '0' && c <= '9') codepoint |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') codepoint |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') codepoint |= static_cast<uint32_t>(c - 'A' + 10);
+            else return fail("invalid escape");
+        }
+        return true;
+    }
+
+    bool parseString(std::string& out)
+    {
+        pos_++;   // Opening quote
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_++];
+            if (c == '"')
+                return true;
+            if (static_cast<unsigned char>(c) < 0x20)
+                return fail("control character in string");
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+
+            if (pos_ >= text_.size())
+                break;
+            const char escape = text_[pos_++];
+            switch (escape) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t codepoint;
+                if (!parseHex4(codepoint))
+                    return false;
+                // Surrogate pair
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF && consume("\\u")) {
+                    uint32_t low;
+                    if (!parseHex4(low))
+                        return false;
+                    if (low >= 0xDC00 && low <= 0xDFFF)
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, codepoint);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool parseArray(JsonValue& value, int depth)
+    {
+        pos_++;
+        value = JsonValue::array();
+        skipWhitespace();
+        if (consume("]"))
+            return true;
+
+        while (true) {
+            JsonValue element;
+            if (!parseValue(element, depth + 1))
+                return false;
+            value.push(std::move(element));
+            skipWhitespace();
+            if (consume(","))
+                continue;
+            if (consume("]"))
+                return true;
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth)
+    {
+        pos_++;
+        value = JsonValue::object();
+        skipWhitespace();
+        if (consume("}"))
+            return true;
+
+        while (true) {
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '"')
+                return fail("expected a key");
+            std::string key;
+            if (!parseString(key))
+                return false;
+            skipWhitespace();
+            if (!consume(":"))
+                return fail("expected ':'");
+            JsonValue member;
+            if (!parseValue(member, depth + 1))
+                return false;
+            value.set(key, std::move(member));
+            skipWhitespace();
+            if (consume(","))
+                continue;
+            if (consume("}"))
+                return true;
+            return fail("expected ',' or '}'");
+        }
+    }
+};
+
+void dumpString(const std::string& text, std::string& out)
+{
+    out += '"';
+    for (const char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+                out += escape;
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+std::optional<JsonValue> JsonValue::parse(const std::string& text, std::string* error)
+{
+    Parser parser(text);
+    JsonValue value;
+    if (!parser.parseDocument(value)) {
+        if (error)
+            *error = parser.getError();
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::string JsonValue::dump() const
+{
+    std::string out;
+    dumpTo(out);
+    return out;
+}
+
+void JsonValue::dumpTo(std::string& out) const
+{
+    switch (type_) {
+    case Type::Null:
+        out += "null";
+        break;
+    case Type::Bool:
+        out += bool_ ? "true" : "false";
+        break;
+    case Type::Number: {
+        char buffer[32];
+        if (number_ == std::floor(number_) && std::fabs(number_) < 1e15)
+            std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(number_));
+        else
+            std::snprintf(buffer, sizeof(buffer), "%.17g", number_);
+        out += buffer;
+        break;
+    }
+    case Type::String:
+        dumpString(string_, out);
+        break;
+    case Type::Array:
+        out += '[';
+        for (size_t i = 0; i < array_.size(); ++i) {
+            if (i)
+                out += ',';
+            array_[i].dumpTo(out);
+        }
+        out += ']';
+        break;
+    case Type::Object: {
+        out += '{';
+        bool first = true;
+        for (const auto& [key, member] : object_) {
+            if (!first)
+                out += ',';
+            first = false;
+            dumpString(key, out);
+            out += ':';
+            member.dumpTo(out);
+        }
+        out += '}';
+        break;
+    }
+    }
+}
+
+const std::string& JsonValue::asString() const
+{
+    static const std::string empty;
+    return isString() ? string_ : empty;
+}
+
+const JsonValue::Array& JsonValue::asArray() const
+{
+    static const Array empty;
+    return isArray() ? array_ : empty;
+}
+
+const JsonValue::Object& JsonValue::asObject() const
+{
+    static const Object empty;
+    return isObject() ? object_ : empty;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const
+{
+    if (!isObject())
+        return nullValue();
+    auto it = object_.find(key);
+    return it != object_.end() ? it->second : nullValue();
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    return isArray() && index < array_.size() ? array_[index] : nullValue();
+}
+
+JsonValue& JsonValue::set(const std::string& key, JsonValue value)
+{
+    if (isNull())
+        type_ = Type::Object;
+    object_[key] = std::move(value);
+    return *this;
+}
+
+JsonValue& JsonValue::push(JsonValue value)
+{
+    if (isNull())
+        type_ = Type::Array;
+    array_.push_back(std::move(value));
+    return *this;
+}
+
+bool JsonValue::operator==(const JsonValue& other) const
+{
+    if (type_ != other.type_)
+        return false;
+    switch (type_) {
+    case Type::Null: return true;
+    case Type::Bool: return bool_ == other.bool_;
+    case Type::Number: return number_ == other.number_;
+    case Type::String: return string_ == other.string_;
+    case Type::Array: return array_ == other.array_;
+    case Type::Object: return object_ == other.object_;
+    }
+    return false;
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,272 @@
+//Multi-threaded PNG encoder for large exports
+#include "../../include/Utils/PngWriter.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <zlib.h>
+
+namespace EpiGimp {
+namespace PngWriter {
+
+namespace {
+
+constexpr size_t BYTES_PER_PIXEL = 4;
+constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+
+enum FilterType : uint8_t { FILTER_NONE = 0, FILTER_SUB, FILTER_UP, FILTER_AVERAGE, FILTER_PAETH };
+
+struct Chunk {
+    int firstRow;
+    int rowCount;
+    std::vector<uint8_t> deflated;
+    uLong adler;
+    size_t filteredSize;
+    bool ok;
+};
+
+uint8_t paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    if (pb <= pc) return static_cast<uint8_t>(b);
+    return static_cast<uint8_t>(c);
+}
+
+// Filter one scanline with each filter and keep the one with the smallest sum of absolute
+// values (the usual libpng heuristic); out receives the filter byte and the filtered row
+void filterRow(const uint8_t* row, const uint8_t* previous, size_t rowBytes, std::vector<uint8_t> candidates[5], uint8_t* out)
+{
+    thread_local std::vector<uint8_t> zeroRow;
+    if (!previous) {
+        zeroRow.assign(rowBytes, 0);
+        previous = zeroRow.data();
+    }
+
+    for (int filter = 0; filter < 5; ++filter)
+        candidates[filter].resize(rowBytes);
+    uint8_t* sub = candidates[FILTER_SUB].data();
+    uint8_t* up = candidates[FILTER_UP].data();
+    uint8_t* average = candidates[FILTER_AVERAGE].data();
+    uint8_t* paethRow = candidates[FILTER_PAETH].data();
+
+    // The first pixel has no left neighbour
+    const size_t head = std::min(BYTES_PER_PIXEL, rowBytes);
+    for (size_t i = 0; i < head; ++i) {
+        sub[i] = row[i];
+        up[i] = static_cast<uint8_t>(row[i] - previous[i]);
+        average[i] = static_cast<uint8_t>(row[i] - (previous[i] >> 1));
+        paethRow[i] = static_cast<uint8_t>(row[i] - previous[i]);
+    }
+    for (size_t i = head; i < rowBytes; ++i) {
+        const int left = row[i - BYTES_PER_PIXEL];
+        const int above = previous[i];
+        const int upLeft = previous[i - BYTES_PER_PIXEL];
+        sub[i] = static_cast<uint8_t>(row[i] - left);
+        up[i] = static_cast<uint8_t>(row[i] - above);
+        average[i] = static_cast<uint8_t>(row[i] - ((left + above) >> 1));
+        paethRow[i] = static_cast<uint8_t>(row[i] - paeth(left, above, upLeft));
+    }
+
+    uint64_t best = UINT64_MAX;
+    int bestFilter = FILTER_NONE;
+    for (int filter = FILTER_NONE; filter <= FILTER_PAETH; ++filter) {
+        const uint8_t* values = filter == FILTER_NONE ? row : candidates[filter].data();
+        uint64_t sum = 0;
+        for (size_t i = 0; i < rowBytes; ++i)
+            sum += static_cast<uint64_t>(std::abs(static_cast<int8_t>(values[i])));
+        if (sum < best) {
+            best = sum;
+            bestFilter = filter;
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(bestFilter);
+    std::memcpy(out + 1, bestFilter == FILTER_NONE ? row : candidates[bestFilter].data(), rowBytes);
+}
+
+void filterRows(const Image& image, int firstRow, int rowCount, std::vector<uint8_t>& filtered)
+{
+    const size_t rowBytes = static_cast<size_t>(image.width) * BYTES_PER_PIXEL;
+    const auto* pixels = static_cast<const uint8_t*>(image.data);
+    std::vector<uint8_t> candidates[5];
+
+    filtered.resize(static_cast<size_t>(rowCount) * (rowBytes + 1));
+    for (int i = 0; i < rowCount; ++i) {
+        const int y = firstRow + i;
+        const uint8_t* previous = y > 0 ? pixels + static_cast<size_t>(y - 1) * rowBytes : nullptr;
+        filterRow(pixels + static_cast<size_t>(y) * rowBytes, previous, rowBytes, candidates,
+                  filtered.data() + static_cast<size_t>(i) * (rowBytes + 1));
+    }
+}
+
+void compressChunk(const Image& image, const Chunk* previousChunk, bool last, int level, Chunk& chunk)
+{
+    std::vector<uint8_t> filtered;
+    filterRows(image, chunk.firstRow, chunk.rowCount, filtered);
+    chunk.filteredSize = filtered.size();
+    chunk.adler = adler32(adler32(0L, Z_NULL, 0), filtered.data(), static_cast<uInt>(filtered.size()));
+
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        chunk.ok = false;
+        return;
+    }
+
+    // Refilter the tail of the previous chunk so matches can reach back across the seam
+    if (previousChunk) {
+        const size_t filteredRowBytes = static_cast<size_t>(image.width) * BYTES_PER_PIXEL + 1;
+        const int rows = std::min(previousChunk->rowCount, static_cast<int>(DICTIONARY_SIZE / filteredRowBytes) + 1);
+        std::vector<uint8_t> dictionary;
+        filterRows(image, previousChunk->firstRow + previousChunk->rowCount - rows, rows, dictionary);
+        const size_t size = std::min(dictionary.size(), DICTIONARY_SIZE);
+        deflateSetDictionary(&stream, dictionary.data() + dictionary.size() - size, static_cast<uInt>(size));
+    }
+
+    chunk.deflated.resize(deflateBound(&stream, static_cast<uLong>(filtered.size())) + 16);
+    stream.next_in = filtered.data();
+    stream.avail_in = static_cast<uInt>(filtered.size());
+    stream.next_out = chunk.deflated.data();
+    stream.avail_out = static_cast<uInt>(chunk.deflated.size());
+
+    // A sync flush ends on a byte boundary without a final block, so chunks concatenate
+    const int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    chunk.ok = last ? result == Z_STREAM_END : result == Z_OK;
+    chunk.deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size)
+{
+    putBigEndian(out, static_cast<uint32_t>(size));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size > 0)
+        out.insert(out.end(), data, data + size);
+    putBigEndian(out, static_cast<uint32_t>(crc32(0L, out.data() + start, static_cast<uInt>(size + 4))));
+}
+
+// zlib stream header advertising the level range, with FCHECK making it a multiple of 31
+void zlibHeader(int level, uint8_t header[2])
+{
+    const int levelFlag = level <= 1 ? 0 : level <= 5 ? 1 : level == 6 ? 2 : 3;
+    header[0] = 0x78;
+    header[1] = static_cast<uint8_t>(levelFlag << 6);
+    header[1] = static_cast<uint8_t>(header[1] + (31 - (header[0] * 256 + header[1]) % 31));
+}
+
+} // namespace
+
+bool isPngPath(const std::string& filePath)
+{
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".png";
+}
+
+bool encode(const Image& image, std::vector<uint8_t>& png, const Options& options)
+{
+    if (!image.data || image.width <= 0 || image.height <= 0)
+        return false;
+
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        Image converted = ImageCopy(image);
+        ImageFormat(&converted, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        const bool ok = converted.data && encode(converted, png, options);
+        UnloadImage(converted);
+        return ok;
+    }
+
+    const int level = std::clamp(options.compressionLevel, 0, 9);
+    const size_t rowBytes = static_cast<size_t>(image.width) * BYTES_PER_PIXEL;
+    const int rowsPerChunk = static_cast<int>(std::max<size_t>(1, options.chunkBytes / rowBytes));
+
+    std::vector<Chunk> chunks;
+    for (int row = 0; row < image.height; row += rowsPerChunk)
+        chunks.push_back(Chunk{row, std::min(rowsPerChunk, image.height - row), {}, 0, 0, false});
+
+    JobSystem::shared().parallelFor(chunks.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            compressChunk(image, i > 0 ? &chunks[i - 1] : nullptr, i + 1 == chunks.size(), level, chunks[i]);
+    }, 1, options.threads);
+
+    uLong adler = adler32(0L, Z_NULL, 0);
+    size_t idatSize = 6;
+    for (const auto& chunk : chunks) {
+        if (!chunk.ok)
+            return false;
+        adler = adler32_combine(adler, chunk.adler, static_cast<z_off_t>(chunk.filteredSize));
+        idatSize += chunk.deflated.size();
+    }
+
+    png.clear();
+    png.reserve(idatSize + 64 + chunks.size() * 12);
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    png.insert(png.end(), signature, signature + 8);
+
+    std::vector<uint8_t> header;
+    putBigEndian(header, static_cast<uint32_t>(image.width));
+    putBigEndian(header, static_cast<uint32_t>(image.height));
+    header.insert(header.end(), {8, 6, 0, 0, 0});  // 8-bit RGBA, deflate, adaptive filtering, no interlace
+    putChunk(png, "IHDR", header.data(), header.size());
+
+    // One IDAT per deflate chunk; the zlib header goes in the first, the checksum in the last
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        data.clear();
+        if (i == 0) {
+            uint8_t zlib[2];
+            zlibHeader(level, zlib);
+            data.insert(data.end(), zlib, zlib + 2);
+        }
+        data.insert(data.end(), chunks[i].deflated.begin(), chunks[i].deflated.end());
+        if (i + 1 == chunks.size())
+            putBigEndian(data, static_cast<uint32_t>(adler));
+        putChunk(png, "IDAT", data.data(), data.size());
+    }
+
+    putChunk(png, "IEND", nullptr, 0);
+    return true;
+}
+
+bool write(const Image& image, const std::string& filePath, const Options& options)
+{
+    std::vector<uint8_t> png;
+    if (!encode(image, png, options))
+        return false;
+
+    std::FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "PngWriter: Cannot open " << filePath << " for writing" << std::endl;
+        return false;
+    }
+
+    const bool ok = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!ok || !closed) {
+        std::cerr << "PngWriter: Failed to write " << filePath << std::endl;
+        return false;
+    }
+
+    std::cout << "PngWriter: Wrote " << image.width << "x" << image.height << " PNG to " << filePath
+              << " (" << png.size() << " bytes)" << std::endl;
+    return true;
+}
+
+} // namespace PngWriter
+} // namespace EpiGimp
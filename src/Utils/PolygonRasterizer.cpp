@@ -0,0 +1,175 @@
+//Scanline polygon fill for the lasso and polygon selection tools
+#include "../../include/Utils/PolygonRasterizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace EpiGimp {
+
+namespace PolygonRasterizer {
+
+namespace {
+
+// Non-horizontal edge; covers sample lines with yTop <= y < yBottom
+struct Edge {
+    float yTop;
+    float yBottom;
+    float xTop;
+    float slope;    // dx/dy
+};
+
+// A change in a row's coverage at one column: partial only counts there, interior from there on
+struct Event {
+    int column;
+    float partial;
+    int interior;
+};
+
+// Exact coverage of [xa, xb) on one sample line
+void addSpan(float xa, float xb, std::vector<Event>& events)
+{
+    const int first = static_cast<int>(xa);
+    const int last = static_cast<int>(xb);
+    if (first == last) {
+        events.push_back({first, xb - xa, 0});
+        return;
+    }
+    events.push_back({first, static_cast<float>(first + 1) - xa, 0});
+    events.push_back({first + 1, 0.0f, 1});
+    events.push_back({last, xb - static_cast<float>(last), -1});
+}
+
+// Pixels whose centre lies in [xa, xb)
+void addCentres(float xa, float xb, std::vector<Event>& events)
+{
+    const int first = static_cast<int>(std::ceil(xa - 0.5f));
+    const int end = static_cast<int>(std::ceil(xb - 0.5f));
+    if (first >= end)
+        return;
+    events.push_back({first, 0.0f, 1});
+    events.push_back({end, 0.0f, -1});
+}
+
+// Turn a row's events into coverage: constant stretches between events are one memset
+void writeRow(std::vector<Event>& events, uint8_t* row, int width, float scale)
+{
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.column < b.column; });
+    const auto coverage = [scale](float value) {
+        return static_cast<uint8_t>(std::min(255.0f, value * scale + 0.5f));
+    };
+
+    int inside = 0;
+    int x = 0;
+    for (size_t i = 0; i < events.size();) {
+        const int column = events[i].column;
+        if (inside > 0 && column > x)
+            std::memset(row + x, coverage(static_cast<float>(inside)), static_cast<size_t>(std::min(column, width) - x));
+        float partial = 0.0f;
+        for (; i < events.size() && events[i].column == column; ++i) {
+            inside += events[i].interior;
+            partial += events[i].partial;
+        }
+        x = column;
+        if (partial > 0.0f && column < width) {
+            row[column] = coverage(static_cast<float>(inside) + partial);
+            x = column + 1;
+        }
+    }
+}
+
+} // namespace
+
+SelectionMask rasterize(const std::vector<Vector2>& points, int width, int height, bool antialias)
+{
+    SelectionMask mask(width, height);
+    if (points.size() < 3 || width <= 0 || height <= 0)
+        return mask;
+
+    // Edge table, sorted by top
+    std::vector<Edge> edges;
+    edges.reserve(points.size());
+    float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest();
+    float minY = minX, maxY = maxX;
+    for (size_t i = 0; i < points.size(); ++i) {
+        const Vector2 a = points[i];
+        const Vector2 b = points[(i + 1) % points.size()];
+        minX = std::min(minX, a.x);
+        maxX = std::max(maxX, a.x);
+        minY = std::min(minY, a.y);
+        maxY = std::max(maxY, a.y);
+        if (a.y == b.y)
+            continue;
+        const Vector2 top = a.y < b.y ? a : b;
+        const Vector2 bottom = a.y < b.y ? b : a;
+        edges.push_back({top.y, bottom.y, top.x, (bottom.x - top.x) / (bottom.y - top.y)});
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.yTop < b.yTop; });
+
+    const int x0 = std::clamp(static_cast<int>(std::floor(minX)), 0, width);
+    const int x1 = std::clamp(static_cast<int>(std::ceil(maxX)), 0, width);
+    const int y0 = std::clamp(static_cast<int>(std::floor(minY)), 0, height);
+    const int y1 = std::clamp(static_cast<int>(std::ceil(maxY)), 0, height);
+    if (edges.empty() || x0 >= x1 || y0 >= y1)
+        return mask;
+
+    constexpr int T = SelectionMask::TILE_SIZE;
+    const int spanWidth = x1 - x0;
+    const int samples = antialias ? SUBSAMPLES : 1;
+    const float scale = 255.0f / static_cast<float>(samples);
+    std::vector<Event> events;
+    std::vector<uint8_t> band(static_cast<size_t>(spanWidth) * T);
+    std::vector<const Edge*> active;
+    std::vector<float> crossings;
+    size_t nextEdge = 0;
+
+    for (int bandY = (y0 / T) * T; bandY < y1; bandY += T) {
+        std::fill(band.begin(), band.end(), 0);
+        bool bandCovered = false;
+
+        for (int y = std::max(y0, bandY); y < std::min(y1, bandY + T); ++y) {
+            events.clear();
+
+            for (int s = 0; s < samples; ++s) {
+                const float sampleY = static_cast<float>(y) + (static_cast<float>(s) + 0.5f) / static_cast<float>(samples);
+                while (nextEdge < edges.size() && edges[nextEdge].yTop <= sampleY)
+                    active.push_back(&edges[nextEdge++]);
+                active.erase(std::remove_if(active.begin(), active.end(),
+                                            [sampleY](const Edge* edge) { return edge->yBottom <= sampleY; }),
+                             active.end());
+
+                crossings.clear();
+                for (const Edge* edge : active)
+                    crossings.push_back(edge->xTop + (sampleY - edge->yTop) * edge->slope - static_cast<float>(x0));
+                std::sort(crossings.begin(), crossings.end());
+
+                // Even-odd: inside between the first and second crossing, third and fourth...
+                for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+                    const float xa = std::clamp(crossings[i], 0.0f, static_cast<float>(spanWidth));
+                    const float xb = std::clamp(crossings[i + 1], 0.0f, static_cast<float>(spanWidth));
+                    if (xa >= xb)
+                        continue;
+                    if (antialias)
+                        addSpan(xa, xb, events);
+                    else
+                        addCentres(xa, xb, events);
+                }
+            }
+            if (events.empty())
+                continue;
+
+            writeRow(events, band.data() + static_cast<size_t>(y - bandY) * spanWidth, spanWidth, scale);
+            bandCovered = true;
+        }
+
+        if (bandCovered) {
+            mask.setRegion(Rectangle{static_cast<float>(x0), static_cast<float>(bandY), static_cast<float>(spanWidth), static_cast<float>(T)},
+                           band.data(), spanWidth);
+        }
+    }
+    return mask;
+}
+
+} // namespace PolygonRasterizer
+
+} // namespace EpiGimp
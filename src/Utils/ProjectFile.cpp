@@ -0,0 +1,412 @@
+//Native .epg project format: tiled, compressed layers with an offset index
+#include "../../include/Utils/ProjectFile.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <zlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr char MAGIC[4] = {'E', 'P', 'G', 'P'};
+constexpr int MAX_TILE_SIZE = 4096;
+constexpr uint32_t MAX_DIMENSION = 1 << 20;   // Keeps sizes and tile counts well inside int
+constexpr uint64_t MAX_PIXELS = 1ull << 28;    // 1 GiB per decoded RGBA8 layer
+
+// offset + length lies within size, without the sum wrapping
+bool fits(uint64_t offset, uint64_t length, uint64_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+static_assert(sizeof(ProjectFile::FileHeader) == 40, "FileHeader layout is part of the file format");
+static_assert(sizeof(ProjectFile::TileEntry) == 16, "TileEntry layout is part of the file format");
+
+struct LayerRecord {
+    const Image* pixels;      // May be null for an empty layer
+    uint32_t flags;
+    std::string name;
+};
+
+int tileCount(int size, int tileSize)
+{
+    return (size + tileSize - 1) / tileSize;
+}
+
+// Copy one tile out of a top-down RGBA8 image, returns false if every pixel is transparent
+bool extractTile(const Image* image, int x0, int y0, int width, int height, std::vector<uint8_t>& tile)
+{
+    tile.assign(static_cast<size_t>(width) * height * 4, 0);
+    if (!image || !image->data)
+        return false;
+
+    const auto* source = static_cast<const uint8_t*>(image->data);
+    const int copyWidth = std::max(0, std::min(width, image->width - x0));
+    const int copyHeight = std::max(0, std::min(height, image->height - y0));
+    bool opaque = false;
+
+    for (int y = 0; y < copyHeight; ++y) {
+        const uint8_t* srcRow = source + (static_cast<size_t>(y0 + y) * image->width + x0) * 4;
+        uint8_t* dstRow = tile.data() + static_cast<size_t>(y) * width * 4;
+        std::memcpy(dstRow, srcRow, static_cast<size_t>(copyWidth) * 4);
+        for (int x = 0; x < copyWidth && !opaque; ++x)
+            opaque = dstRow[x * 4 + 3] != 0;
+    }
+    return opaque;
+}
+
+template<typename T>
+void writeValue(std::ofstream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+namespace ProjectFile {
+
+bool isProjectPath(const std::string& filePath)
+{
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == EXTENSION;
+}
+
+bool compressTile(const std::vector<uint8_t>& pixels, std::vector<uint8_t>& compressed)
+{
+    compressed.resize(compressBound(static_cast<uLong>(pixels.size())));
+    uLongf compressedSize = static_cast<uLongf>(compressed.size());
+    if (compress2(compressed.data(), &compressedSize, pixels.data(), static_cast<uLong>(pixels.size()), Z_BEST_SPEED) != Z_OK)
+        return false;
+    compressed.resize(compressedSize);
+    return true;
+}
+
+bool decompressTile(const uint8_t* data, size_t size, size_t expectedSize, std::vector<uint8_t>& pixels)
+{
+    pixels.assign(expectedSize, 0);
+    uLongf decodedSize = static_cast<uLongf>(expectedSize);
+    const int status = uncompress(pixels.data(), &decodedSize, data, static_cast<uLong>(size));
+    return status == Z_OK && decodedSize == expectedSize;
+}
+
+bool write(const DocumentSnapshot& snapshot, const std::string& filePath, int tileSize,
+           const std::function<void(size_t)>& onBytesWritten)
+{
+    if (snapshot.getWidth() <= 0 || snapshot.getHeight() <= 0 || tileSize <= 0 || tileSize > MAX_TILE_SIZE)
+        return false;
+
+    std::vector<LayerRecord> records;
+    if (snapshot.getBackground()) {
+        uint32_t flags = LAYER_BACKGROUND;
+        if (snapshot.isBackgroundVisible())
+            flags |= LAYER_VISIBLE;
+        records.push_back(LayerRecord{snapshot.getBackground().get(), flags, "Background"});
+    }
+    for (const auto& layer : snapshot.getLayers()) {
+        uint32_t flags = 0;
+        if (layer.visible) flags |= LAYER_VISIBLE;
+        if (layer.flippedVertical) flags |= LAYER_FLIPPED_VERTICAL;
+        if (layer.flippedHorizontal) flags |= LAYER_FLIPPED_HORIZONTAL;
+        records.push_back(LayerRecord{layer.pixels.get(), flags, layer.name});
+    }
+
+    const std::string tempPath = filePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "ProjectFile: Cannot open " << tempPath << " for writing" << std::endl;
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = static_cast<uint32_t>(snapshot.getWidth());
+    header.height = static_cast<uint32_t>(snapshot.getHeight());
+    header.tileSize = static_cast<uint32_t>(tileSize);
+    header.layerCount = static_cast<uint32_t>(records.size());
+    writeValue(out, header);  // Placeholder, rewritten once the offsets are known
+
+    const int tilesX = tileCount(snapshot.getWidth(), tileSize);
+    const int tilesY = tileCount(snapshot.getHeight(), tileSize);
+    std::vector<TileEntry> index;
+    index.reserve(records.size() * tilesX * tilesY);
+
+    struct BandTile {
+        bool present = false;
+        bool ok = true;
+        std::vector<uint8_t> compressed;
+    };
+    std::vector<BandTile> band(static_cast<size_t>(tilesX));
+    uint64_t offset = sizeof(FileHeader);
+
+    for (const auto& record : records) {
+        for (int ty = 0; ty < tilesY; ++ty) {
+            // One row of tiles is compressed on the job system at a time and written in order
+            JobSystem::shared().parallelFor(band.size(), [&](size_t begin, size_t end) {
+                std::vector<uint8_t> tile;
+                for (size_t tx = begin; tx < end; ++tx) {
+                    const int x0 = static_cast<int>(tx) * tileSize;
+                    const int y0 = ty * tileSize;
+                    const int width = std::min(tileSize, snapshot.getWidth() - x0);
+                    const int height = std::min(tileSize, snapshot.getHeight() - y0);
+                    band[tx].present = extractTile(record.pixels, x0, y0, width, height, tile);
+                    band[tx].ok = !band[tx].present || compressTile(tile, band[tx].compressed);
+                }
+            });
+
+            for (int tx = 0; tx < tilesX; ++tx) {
+                const BandTile& bandTile = band[static_cast<size_t>(tx)];
+                const std::vector<uint8_t>& compressed = bandTile.compressed;
+
+                TileEntry entry{offset, 0, 0};
+                if (bandTile.present) {
+                    if (!bandTile.ok) {
+                        out.close();
+                        std::remove(tempPath.c_str());
+                        return false;
+                    }
+                    out.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+                    entry.size = static_cast<uint32_t>(compressed.size());
+                    offset += compressed.size();
+                    if (onBytesWritten)
+                        onBytesWritten(compressed.size());
+                }
+                index.push_back(entry);
+            }
+        }
+    }
+
+    header.layerTableOffset = offset;
+    for (const auto& record : records) {
+        const uint32_t nameLength = static_cast<uint32_t>(record.name.size());
+        writeValue(out, record.flags);
+        writeValue(out, nameLength);
+        out.write(record.name.data(), nameLength);
+        offset += sizeof(uint32_t) * 2 + nameLength;
+    }
+
+    // Keep the index 8-byte aligned so the reader can use it straight from the mapping
+    while (offset % alignof(TileEntry) != 0) {
+        out.put('\0');
+        offset++;
+    }
+    header.tileIndexOffset = offset;
+    out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(TileEntry)));
+
+    out.seekp(0);
+    writeValue(out, header);
+    out.close();
+    if (!out) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        std::cerr << "ProjectFile: Failed to move project into place: " << error.message() << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::cout << "ProjectFile: Wrote " << records.size() << " layers (" << index.size() << " tiles) to " << filePath << std::endl;
+    return true;
+}
+
+} // namespace ProjectFile
+
+ProjectReader::ProjectReader()
+    : fileDescriptor_(-1), mapping_(nullptr), mappedSize_(0), header_{}, tilesX_(0), tilesY_(0), tileIndex_(nullptr)
+{
+}
+
+ProjectReader::~ProjectReader()
+{
+    if (mapping_)
+        munmap(const_cast<uint8_t*>(mapping_), mappedSize_);
+    if (fileDescriptor_ >= 0)
+        close(fileDescriptor_);
+}
+
+std::unique_ptr<ProjectReader> ProjectReader::open(const std::string& filePath, std::string* error)
+{
+    auto fail = [&](const std::string& message) -> std::unique_ptr<ProjectReader> {
+        if (error)
+            *error = message + ": " + filePath;
+        return nullptr;
+    };
+
+    std::unique_ptr<ProjectReader> reader(new ProjectReader());
+    reader->fileDescriptor_ = ::open(filePath.c_str(), O_RDONLY);
+    if (reader->fileDescriptor_ < 0)
+        return fail("Cannot open project");
+
+    struct stat info{};
+    if (fstat(reader->fileDescriptor_, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ProjectFile::FileHeader))
+        return fail("Not a project file");
+
+    reader->mappedSize_ = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, reader->mappedSize_, PROT_READ, MAP_PRIVATE, reader->fileDescriptor_, 0);
+    if (mapping == MAP_FAILED)
+        return fail("Cannot map project");
+    reader->mapping_ = static_cast<const uint8_t*>(mapping);
+    madvise(mapping, reader->mappedSize_, MADV_RANDOM);  // Tiles are read in view order, not file order
+
+    ProjectFile::FileHeader& header = reader->header_;
+    std::memcpy(&header, reader->mapping_, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        return fail("Not a project file");
+    if (header.version != ProjectFile::VERSION)
+        return fail("Unsupported project version " + std::to_string(header.version));
+    if (header.width == 0 || header.height == 0 || header.width > MAX_DIMENSION || header.height > MAX_DIMENSION ||
+        header.tileSize == 0 || header.tileSize > MAX_TILE_SIZE)
+        return fail("Corrupt project header");
+    if (static_cast<uint64_t>(header.width) * header.height > MAX_PIXELS)
+        return fail("Project too large");
+
+    reader->tilesX_ = tileCount(static_cast<int>(header.width), static_cast<int>(header.tileSize));
+    reader->tilesY_ = tileCount(static_cast<int>(header.height), static_cast<int>(header.tileSize));
+
+    // Layer table
+    uint64_t cursor = header.layerTableOffset;
+    for (uint32_t i = 0; i < header.layerCount; ++i) {
+        uint32_t flags = 0;
+        uint32_t nameLength = 0;
+        if (!fits(cursor, sizeof(uint32_t) * 2, reader->mappedSize_))
+            return fail("Corrupt layer table");
+        std::memcpy(&flags, reader->mapping_ + cursor, sizeof(flags));
+        std::memcpy(&nameLength, reader->mapping_ + cursor + sizeof(flags), sizeof(nameLength));
+        cursor += sizeof(uint32_t) * 2;
+        if (!fits(cursor, nameLength, reader->mappedSize_))
+            return fail("Corrupt layer table");
+
+        LayerInfo layer;
+        layer.name.assign(reinterpret_cast<const char*>(reader->mapping_ + cursor), nameLength);
+        layer.visible = (flags & ProjectFile::LAYER_VISIBLE) != 0;
+        layer.flippedVertical = (flags & ProjectFile::LAYER_FLIPPED_VERTICAL) != 0;
+        layer.flippedHorizontal = (flags & ProjectFile::LAYER_FLIPPED_HORIZONTAL) != 0;
+        layer.isBackground = (flags & ProjectFile::LAYER_BACKGROUND) != 0;
+        reader->layers_.push_back(std::move(layer));
+        cursor += nameLength;
+    }
+
+    // Tile index
+    const uint64_t tilesPerLayer = static_cast<uint64_t>(reader->tilesX_) * reader->tilesY_;
+    if (header.layerCount > reader->mappedSize_ / sizeof(ProjectFile::TileEntry) / tilesPerLayer)
+        return fail("Corrupt tile index");
+    const uint64_t indexSize = header.layerCount * tilesPerLayer * sizeof(ProjectFile::TileEntry);
+    if (header.tileIndexOffset % alignof(ProjectFile::TileEntry) != 0 ||
+        !fits(header.tileIndexOffset, indexSize, reader->mappedSize_))
+        return fail("Corrupt tile index");
+    reader->tileIndex_ = reinterpret_cast<const ProjectFile::TileEntry*>(reader->mapping_ + header.tileIndexOffset);
+
+    std::cout << "ProjectReader: Opened " << filePath << " (" << header.width << "x" << header.height
+              << ", " << header.layerCount << " layers, " << reader->mappedSize_ << " bytes)" << std::endl;
+    return reader;
+}
+
+const ProjectFile::TileEntry& ProjectReader::tileEntry(size_t layer, int tileX, int tileY) const
+{
+    return tileIndex_[(layer * tilesY_ + tileY) * tilesX_ + tileX];
+}
+
+Rectangle ProjectReader::getTileRect(int tileX, int tileY) const
+{
+    const int tileSize = getTileSize();
+    const int x0 = tileX * tileSize;
+    const int y0 = tileY * tileSize;
+    return Rectangle{static_cast<float>(x0), static_cast<float>(y0),
+                     static_cast<float>(std::min(tileSize, getWidth() - x0)),
+                     static_cast<float>(std::min(tileSize, getHeight() - y0))};
+}
+
+bool ProjectReader::isTileEmpty(size_t layer, int tileX, int tileY) const
+{
+    return tileEntry(layer, tileX, tileY).size == 0;
+}
+
+bool ProjectReader::decodeTile(size_t layer, int tileX, int tileY, std::vector<uint8_t>& pixels) const
+{
+    if (layer >= layers_.size() || tileX < 0 || tileY < 0 || tileX >= tilesX_ || tileY >= tilesY_)
+        return false;
+
+    const Rectangle rect = getTileRect(tileX, tileY);
+    const size_t expectedSize = static_cast<size_t>(rect.width) * static_cast<size_t>(rect.height) * 4;
+    pixels.assign(expectedSize, 0);
+
+    const ProjectFile::TileEntry& entry = tileEntry(layer, tileX, tileY);
+    if (entry.size == 0)
+        return true;
+    if (!fits(entry.offset, entry.size, mappedSize_))
+        return false;
+
+    return ProjectFile::decompressTile(mapping_ + entry.offset, entry.size, expectedSize, pixels);
+}
+
+Image ProjectReader::decodeLayer(size_t layer) const
+{
+    if (layer >= layers_.size())
+        return Image{};
+
+    Image image = GenImageColor(getWidth(), getHeight(), BLANK);
+    if (!image.data) {
+        std::cerr << "ProjectReader: Cannot allocate a " << getWidth() << "x" << getHeight() << " layer" << std::endl;
+        return Image{};
+    }
+    auto* target = static_cast<uint8_t*>(image.data);
+    std::vector<uint8_t> tile;
+
+    for (int ty = 0; ty < tilesY_; ++ty) {
+        for (int tx = 0; tx < tilesX_; ++tx) {
+            if (isTileEmpty(layer, tx, ty))
+                continue;
+            if (!decodeTile(layer, tx, ty, tile)) {
+                UnloadImage(image);
+                return Image{};
+            }
+
+            const Rectangle rect = getTileRect(tx, ty);
+            const size_t rowBytes = static_cast<size_t>(rect.width) * 4;
+            for (int y = 0; y < static_cast<int>(rect.height); ++y) {
+                std::memcpy(target + ((static_cast<size_t>(rect.y) + y) * getWidth() + static_cast<size_t>(rect.x)) * 4,
+                            tile.data() + y * rowBytes, rowBytes);
+            }
+        }
+    }
+    return image;
+}
+
+Image ProjectReader::composite() const
+{
+    DocumentSnapshot snapshot(getWidth(), getHeight());
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        const LayerInfo& info = layers_[i];
+        if (!info.visible)
+            continue;
+        Image pixels = decodeLayer(i);
+        if (!pixels.data)
+            return Image{};
+        if (info.isBackground) {
+            snapshot.setBackground(makeSharedPixels(pixels));
+        } else {
+            LayerSnapshot layer(makeSharedPixels(pixels));
+            layer.flippedVertical = info.flippedVertical;
+            layer.flippedHorizontal = info.flippedHorizontal;
+            snapshot.addLayer(std::move(layer));
+        }
+    }
+    return snapshot.composite();
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,81 @@
+//Decodes project tiles on a worker thread for incremental upload
+#include "../../include/Utils/ProjectTileStreamer.hpp"
+
+namespace EpiGimp {
+
+ProjectTileStreamer::ProjectTileStreamer(std::shared_ptr<const ProjectReader> reader, std::vector<TileRequest> order,
+                                         size_t maxQueuedBytes)
+    : reader_(std::move(reader)), order_(std::move(order)), maxQueuedBytes_(maxQueuedBytes),
+      stopping_(false), queuedBytes_(0), delivered_(0)
+{
+    worker_ = std::thread(&ProjectTileStreamer::workerLoop, this);
+}
+
+ProjectTileStreamer::~ProjectTileStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    spaceAvailable_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+std::vector<ProjectTileStreamer::DecodedTile> ProjectTileStreamer::takeReady(size_t byteBudget)
+{
+    std::vector<DecodedTile> tiles;
+    size_t taken = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!ready_.empty() && (tiles.empty() || taken + ready_.front().pixels.size() <= byteBudget)) {
+            taken += ready_.front().pixels.size();
+            tiles.push_back(std::move(ready_.front()));
+            ready_.pop_front();
+        }
+        queuedBytes_ -= taken;
+    }
+
+    delivered_ += tiles.size();
+    spaceAvailable_.notify_one();
+    return tiles;
+}
+
+std::vector<ProjectTileStreamer::DecodedTile> ProjectTileStreamer::takeAll()
+{
+    std::vector<DecodedTile> tiles;
+    while (!isFinished()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Lift the queue limit so the worker never waits on us
+            maxQueuedBytes_ = SIZE_MAX;
+        }
+        spaceAvailable_.notify_one();
+
+        auto batch = takeReady(SIZE_MAX);
+        if (batch.empty())
+            std::this_thread::yield();
+        for (auto& tile : batch)
+            tiles.push_back(std::move(tile));
+    }
+    return tiles;
+}
+
+void ProjectTileStreamer::workerLoop()
+{
+    for (const TileRequest& request : order_) {
+        DecodedTile tile;
+        tile.request = request;
+        tile.rect = reader_->getTileRect(request.tileX, request.tileY);
+        tile.valid = reader_->decodeTile(request.layer, request.tileX, request.tileY, tile.pixels);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        spaceAvailable_.wait(lock, [this] { return stopping_ || queuedBytes_ < maxQueuedBytes_; });
+        if (stopping_)
+            return;
+        queuedBytes_ += tile.pixels.size();
+        ready_.push_back(std::move(tile));
+    }
+}
+
+} // namespace EpiGimp
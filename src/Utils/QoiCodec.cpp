@@ -0,0 +1,283 @@
+//QOI ("Quite OK Image") encoder and decoder for fast scratch saves
+#include "../../include/Utils/QoiCodec.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace EpiGimp {
+namespace QoiCodec {
+
+namespace {
+
+constexpr uint8_t OP_INDEX = 0x00;
+constexpr uint8_t OP_DIFF = 0x40;
+constexpr uint8_t OP_LUMA = 0x80;
+constexpr uint8_t OP_RUN = 0xC0;
+constexpr uint8_t OP_RGB = 0xFE;
+constexpr uint8_t OP_RGBA = 0xFF;
+constexpr uint8_t MASK_2 = 0xC0;
+
+constexpr size_t HEADER_SIZE = 14;
+constexpr uint8_t END_MARKER[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+constexpr size_t STRIPE_PIXELS = 256 * 1024;     // Fixed, so the output does not depend on the thread count
+constexpr uint32_t MAX_PIXELS = 400000000;       // Limit from the reference implementation
+
+struct Pixel {
+    uint8_t r, g, b, a;
+    bool operator==(const Pixel& other) const { return r == other.r && g == other.g && b == other.b && a == other.a; }
+    bool operator!=(const Pixel& other) const { return !(*this == other); }
+};
+
+inline int hashOf(const Pixel& p)
+{
+    return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64;
+}
+
+void encodeStripe(const Pixel* pixels, size_t first, size_t count, std::vector<uint8_t>& out)
+{
+    Pixel index[64] = {};
+    bool known[64] = {};
+    Pixel previous = first > 0 ? pixels[first - 1] : Pixel{0, 0, 0, 255};
+    int run = 0;
+
+    out.reserve(count * 2);
+    for (size_t i = first; i < first + count; ++i) {
+        const Pixel pixel = pixels[i];
+        if (pixel == previous) {
+            if (++run == 62) {
+                out.push_back(static_cast<uint8_t>(OP_RUN | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(OP_RUN | (run - 1)));
+            run = 0;
+        }
+
+        const int slot = hashOf(pixel);
+        if (known[slot] && index[slot] == pixel) {
+            out.push_back(static_cast<uint8_t>(OP_INDEX | slot));
+        } else {
+            index[slot] = pixel;
+            known[slot] = true;
+
+            if (pixel.a == previous.a) {
+                const int dr = static_cast<int8_t>(pixel.r - previous.r);
+                const int dg = static_cast<int8_t>(pixel.g - previous.g);
+                const int db = static_cast<int8_t>(pixel.b - previous.b);
+                const int drg = dr - dg;
+                const int dbg = db - dg;
+                if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                    out.push_back(static_cast<uint8_t>(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                } else if (drg > -9 && drg < 8 && dg > -33 && dg < 32 && dbg > -9 && dbg < 8) {
+                    out.push_back(static_cast<uint8_t>(OP_LUMA | (dg + 32)));
+                    out.push_back(static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8)));
+                } else {
+                    out.insert(out.end(), {OP_RGB, pixel.r, pixel.g, pixel.b});
+                }
+            } else {
+                out.insert(out.end(), {OP_RGBA, pixel.r, pixel.g, pixel.b, pixel.a});
+            }
+        }
+        previous = pixel;
+    }
+
+    if (run > 0)
+        out.push_back(static_cast<uint8_t>(OP_RUN | (run - 1)));
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t getBigEndian(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 |
+           static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+} // namespace
+
+bool isQoiPath(const std::string& filePath)
+{
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == EXTENSION;
+}
+
+bool encode(const Image& image, std::vector<uint8_t>& qoi, unsigned threads)
+{
+    if (!image.data || image.width <= 0 || image.height <= 0 ||
+        static_cast<uint64_t>(image.width) * image.height > MAX_PIXELS)
+        return false;
+
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        Image converted = ImageCopy(image);
+        ImageFormat(&converted, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        const bool ok = converted.data && encode(converted, qoi, threads);
+        UnloadImage(converted);
+        return ok;
+    }
+
+    const auto* pixels = static_cast<const Pixel*>(image.data);
+    const size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    const size_t stripeCount = (pixelCount + STRIPE_PIXELS - 1) / STRIPE_PIXELS;
+    std::vector<std::vector<uint8_t>> stripes(stripeCount);
+
+    JobSystem::shared().parallelFor(stripeCount, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t first = i * STRIPE_PIXELS;
+            encodeStripe(pixels, first, std::min(STRIPE_PIXELS, pixelCount - first), stripes[i]);
+        }
+    }, 1, threads);
+
+    size_t total = HEADER_SIZE + sizeof(END_MARKER);
+    for (const auto& stripe : stripes)
+        total += stripe.size();
+
+    qoi.clear();
+    qoi.reserve(total);
+    qoi.insert(qoi.end(), {'q', 'o', 'i', 'f'});
+    putBigEndian(qoi, static_cast<uint32_t>(image.width));
+    putBigEndian(qoi, static_cast<uint32_t>(image.height));
+    qoi.push_back(4);   // RGBA
+    qoi.push_back(0);   // sRGB with linear alpha
+    for (const auto& stripe : stripes)
+        qoi.insert(qoi.end(), stripe.begin(), stripe.end());
+    qoi.insert(qoi.end(), END_MARKER, END_MARKER + sizeof(END_MARKER));
+    return true;
+}
+
+Image decode(const uint8_t* data, size_t size)
+{
+    if (!data || size < HEADER_SIZE + sizeof(END_MARKER) || std::memcmp(data, "qoif", 4) != 0)
+        return Image{};
+
+    const uint32_t width = getBigEndian(data + 4);
+    const uint32_t height = getBigEndian(data + 8);
+    const uint8_t channels = data[12];
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4) ||
+        static_cast<uint64_t>(width) * height > MAX_PIXELS)
+        return Image{};
+
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    auto* pixels = static_cast<Pixel*>(std::malloc(pixelCount * sizeof(Pixel)));
+    if (!pixels)
+        return Image{};
+
+    Pixel index[64] = {};
+    Pixel pixel{0, 0, 0, 255};
+    const size_t end = size - sizeof(END_MARKER);
+    size_t cursor = HEADER_SIZE;
+    int run = 0;
+    bool truncated = false;
+
+    for (size_t i = 0; i < pixelCount && !truncated; ++i) {
+        if (run > 0) {
+            run--;
+        } else if (cursor < end) {
+            const uint8_t op = data[cursor++];
+            if (op == OP_RGB) {
+                if (cursor + 3 > end) { truncated = true; break; }
+                pixel.r = data[cursor];
+                pixel.g = data[cursor + 1];
+                pixel.b = data[cursor + 2];
+                cursor += 3;
+            } else if (op == OP_RGBA) {
+                if (cursor + 4 > end) { truncated = true; break; }
+                pixel = Pixel{data[cursor], data[cursor + 1], data[cursor + 2], data[cursor + 3]};
+                cursor += 4;
+            } else if ((op & MASK_2) == OP_INDEX) {
+                pixel = index[op];
+            } else if ((op & MASK_2) == OP_DIFF) {
+                pixel.r = static_cast<uint8_t>(pixel.r + ((op >> 4) & 0x03) - 2);
+                pixel.g = static_cast<uint8_t>(pixel.g + ((op >> 2) & 0x03) - 2);
+                pixel.b = static_cast<uint8_t>(pixel.b + (op & 0x03) - 2);
+            } else if ((op & MASK_2) == OP_LUMA) {
+                if (cursor + 1 > end) { truncated = true; break; }
+                const uint8_t next = data[cursor++];
+                const int dg = (op & 0x3F) - 32;
+                pixel.r = static_cast<uint8_t>(pixel.r + dg - 8 + ((next >> 4) & 0x0F));
+                pixel.g = static_cast<uint8_t>(pixel.g + dg);
+                pixel.b = static_cast<uint8_t>(pixel.b + dg - 8 + (next & 0x0F));
+            } else {
+                run = op & 0x3F;
+            }
+            index[hashOf(pixel)] = pixel;
+        }
+        pixels[i] = pixel;
+    }
+    if (truncated) {
+        // The rest of the buffer was never written
+        std::cerr << "QoiCodec: Truncated data" << std::endl;
+        std::free(pixels);
+        return Image{};
+    }
+
+    Image image{};
+    image.data = pixels;
+    image.width = static_cast<int>(width);
+    image.height = static_cast<int>(height);
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+bool write(const Image& image, const std::string& filePath, unsigned threads)
+{
+    std::vector<uint8_t> qoi;
+    if (!encode(image, qoi, threads))
+        return false;
+
+    std::FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "QoiCodec: Cannot open " << filePath << " for writing" << std::endl;
+        return false;
+    }
+
+    const bool ok = std::fwrite(qoi.data(), 1, qoi.size(), file) == qoi.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!ok || !closed) {
+        std::cerr << "QoiCodec: Failed to write " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Image read(const std::string& filePath)
+{
+    std::FILE* file = std::fopen(filePath.c_str(), "rb");
+    if (!file)
+        return Image{};
+
+    std::vector<uint8_t> data;
+    if (std::fseek(file, 0, SEEK_END) == 0) {
+        const long size = std::ftell(file);
+        if (size > 0) {
+            data.resize(static_cast<size_t>(size));
+            std::rewind(file);
+            if (std::fread(data.data(), 1, data.size(), file) != data.size())
+                data.clear();
+        }
+    }
+    std::fclose(file);
+
+    Image image = decode(data.data(), data.size());
+    if (!image.data)
+        std::cerr << "QoiCodec: " << filePath << " is not a valid QOI file" << std::endl;
+    return image;
+}
+
+} // namespace QoiCodec
+} // namespace EpiGimp
@@ -0,0 +1,289 @@
+//Raw tiled image dump (.ert) for fast scratch saves
+#include "../../include/Utils/RawTileFile.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace EpiGimp {
+namespace RawTileFile {
+
+namespace {
+
+constexpr size_t BYTES_PER_PIXEL = 4;
+constexpr int MAX_PACKET = 128;
+constexpr uint32_t MAX_SIDE = 65535;   // Image sides and tile size; keeps tile arithmetic inside int
+
+struct TileLayout {
+    int tilesX;
+    int tilesY;
+    int tileSize;
+    int width;
+    int height;
+
+    size_t count() const { return static_cast<size_t>(tilesX) * tilesY; }
+
+    void rect(size_t tile, int& x, int& y, int& w, int& h) const {
+        x = static_cast<int>(tile % tilesX) * tileSize;
+        y = static_cast<int>(tile / tilesX) * tileSize;
+        w = std::min(tileSize, width - x);
+        h = std::min(tileSize, height - y);
+    }
+};
+
+template<typename Job>
+void runParallel(size_t count, unsigned threads, const Job& job)
+{
+    JobSystem::shared().parallelFor(count, [&job](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            job(i);
+    }, 1, threads);
+}
+
+// Gather a tile into contiguous rows
+void copyTileOut(const uint8_t* pixels, const TileLayout& layout, size_t tile, std::vector<uint8_t>& out)
+{
+    int x, y, w, h;
+    layout.rect(tile, x, y, w, h);
+    const size_t rowBytes = static_cast<size_t>(w) * BYTES_PER_PIXEL;
+    out.resize(rowBytes * h);
+    for (int row = 0; row < h; ++row) {
+        std::memcpy(out.data() + row * rowBytes,
+                    pixels + (static_cast<size_t>(y + row) * layout.width + x) * BYTES_PER_PIXEL, rowBytes);
+    }
+}
+
+void encodeRle(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out)
+{
+    const auto* pixels = reinterpret_cast<const uint32_t*>(raw.data());
+    const size_t count = raw.size() / BYTES_PER_PIXEL;
+    out.clear();
+    out.reserve(raw.size() / 4);
+
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < MAX_PACKET && pixels[i + run] == pixels[i])
+            run++;
+
+        if (run >= 2) {
+            out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+            out.insert(out.end(), raw.data() + i * BYTES_PER_PIXEL, raw.data() + (i + 1) * BYTES_PER_PIXEL);
+            i += run;
+            continue;
+        }
+
+        // Literal packet up to the next run of two
+        size_t literal = 1;
+        while (i + literal < count && literal < MAX_PACKET &&
+               !(i + literal + 1 < count && pixels[i + literal] == pixels[i + literal + 1]))
+            literal++;
+        out.push_back(static_cast<uint8_t>(literal - 1));
+        out.insert(out.end(), raw.data() + i * BYTES_PER_PIXEL, raw.data() + (i + literal) * BYTES_PER_PIXEL);
+        i += literal;
+    }
+}
+
+bool decodeRle(const uint8_t* data, size_t size, uint8_t* out, size_t pixelCount)
+{
+    size_t cursor = 0;
+    size_t written = 0;
+    while (written < pixelCount) {
+        if (cursor >= size)
+            return false;
+        const uint8_t header = data[cursor++];
+        const size_t count = (header & 0x7F) + 1u;
+        if (written + count > pixelCount)
+            return false;
+
+        if (header & 0x80) {
+            if (cursor + BYTES_PER_PIXEL > size)
+                return false;
+            uint32_t pixel;
+            std::memcpy(&pixel, data + cursor, BYTES_PER_PIXEL);
+            cursor += BYTES_PER_PIXEL;
+            for (size_t i = 0; i < count; ++i)
+                std::memcpy(out + (written + i) * BYTES_PER_PIXEL, &pixel, BYTES_PER_PIXEL);
+        } else {
+            if (cursor + count * BYTES_PER_PIXEL > size)
+                return false;
+            std::memcpy(out + written * BYTES_PER_PIXEL, data + cursor, count * BYTES_PER_PIXEL);
+            cursor += count * BYTES_PER_PIXEL;
+        }
+        written += count;
+    }
+    return cursor == size;
+}
+
+} // namespace
+
+bool isRawTilePath(const std::string& filePath)
+{
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == EXTENSION;
+}
+
+bool write(const Image& image, const std::string& filePath, const Options& options)
+{
+    if (!image.data || image.width <= 0 || image.height <= 0 || options.tileSize <= 0 ||
+        static_cast<uint32_t>(image.width) > MAX_SIDE || static_cast<uint32_t>(image.height) > MAX_SIDE ||
+        static_cast<uint32_t>(options.tileSize) > MAX_SIDE)
+        return false;
+
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        Image converted = ImageCopy(image);
+        ImageFormat(&converted, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        const bool ok = converted.data && write(converted, filePath, options);
+        UnloadImage(converted);
+        return ok;
+    }
+
+    const TileLayout layout{(image.width + options.tileSize - 1) / options.tileSize,
+                            (image.height + options.tileSize - 1) / options.tileSize,
+                            options.tileSize, image.width, image.height};
+    const auto* pixels = static_cast<const uint8_t*>(image.data);
+
+    std::vector<std::vector<uint8_t>> tiles(layout.count());
+    std::vector<TileEntry> index(layout.count());
+    runParallel(layout.count(), options.threads, [&](size_t tile) {
+        copyTileOut(pixels, layout, tile, tiles[tile]);
+        index[tile].encoding = TILE_RAW;
+        if (options.rle) {
+            std::vector<uint8_t> encoded;
+            encodeRle(tiles[tile], encoded);
+            if (encoded.size() < tiles[tile].size()) {
+                tiles[tile].swap(encoded);
+                index[tile].encoding = TILE_RLE;
+            }
+        }
+        index[tile].size = static_cast<uint32_t>(tiles[tile].size());
+    });
+
+    uint64_t offset = sizeof(FileHeader) + index.size() * sizeof(TileEntry);
+    for (auto& entry : index) {
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    FileHeader header{{'E', 'P', 'R', 'T'}, VERSION, static_cast<uint32_t>(image.width),
+                      static_cast<uint32_t>(image.height), static_cast<uint32_t>(options.tileSize), 0};
+
+    std::FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "RawTileFile: Cannot open " << filePath << " for writing" << std::endl;
+        return false;
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(index.data(), sizeof(TileEntry), index.size(), file) == index.size();
+    for (size_t i = 0; ok && i < tiles.size(); ++i)
+        ok = std::fwrite(tiles[i].data(), 1, tiles[i].size(), file) == tiles[i].size();
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok)
+        std::cerr << "RawTileFile: Failed to write " << filePath << std::endl;
+    return ok;
+}
+
+Image read(const std::string& filePath, unsigned threads)
+{
+    std::FILE* file = std::fopen(filePath.c_str(), "rb");
+    if (!file)
+        return Image{};
+
+    std::vector<uint8_t> data;
+    if (std::fseek(file, 0, SEEK_END) == 0) {
+        const long size = std::ftell(file);
+        if (size > 0) {
+            data.resize(static_cast<size_t>(size));
+            std::rewind(file);
+            if (std::fread(data.data(), 1, data.size(), file) != data.size())
+                data.clear();
+        }
+    }
+    std::fclose(file);
+
+    FileHeader header{};
+    if (data.size() < sizeof(header)) {
+        std::cerr << "RawTileFile: " << filePath << " is too small" << std::endl;
+        return Image{};
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, "EPRT", 4) != 0 || header.version != VERSION ||
+        header.width == 0 || header.height == 0 || header.tileSize == 0 ||
+        header.width > MAX_SIDE || header.height > MAX_SIDE || header.tileSize > MAX_SIDE) {
+        std::cerr << "RawTileFile: " << filePath << " is not a raw tile dump" << std::endl;
+        return Image{};
+    }
+
+    const TileLayout layout{static_cast<int>((header.width + header.tileSize - 1) / header.tileSize),
+                            static_cast<int>((header.height + header.tileSize - 1) / header.tileSize),
+                            static_cast<int>(header.tileSize), static_cast<int>(header.width),
+                            static_cast<int>(header.height)};
+    if (data.size() < sizeof(header) + layout.count() * sizeof(TileEntry)) {
+        std::cerr << "RawTileFile: " << filePath << " is truncated" << std::endl;
+        return Image{};
+    }
+    std::vector<TileEntry> index(layout.count());
+    std::memcpy(index.data(), data.data() + sizeof(header), index.size() * sizeof(TileEntry));
+
+    const size_t imageBytes = static_cast<size_t>(header.width) * header.height * BYTES_PER_PIXEL;
+    auto* pixels = static_cast<uint8_t*>(std::malloc(imageBytes));
+    if (!pixels)
+        return Image{};
+
+    std::atomic<bool> valid{true};
+    runParallel(layout.count(), threads, [&](size_t tile) {
+        const TileEntry& entry = index[tile];
+        if (entry.offset > data.size() || entry.size > data.size() - entry.offset) {
+            valid = false;
+            return;
+        }
+
+        int x, y, w, h;
+        layout.rect(tile, x, y, w, h);
+        const size_t rowBytes = static_cast<size_t>(w) * BYTES_PER_PIXEL;
+        const uint8_t* source = data.data() + entry.offset;
+        std::vector<uint8_t> decoded;
+        if (entry.encoding == TILE_RLE) {
+            decoded.resize(rowBytes * h);
+            if (!decodeRle(source, entry.size, decoded.data(), static_cast<size_t>(w) * h)) {
+                valid = false;
+                return;
+            }
+            source = decoded.data();
+        } else if (entry.encoding != TILE_RAW || entry.size != rowBytes * h) {
+            valid = false;
+            return;
+        }
+
+        for (int row = 0; row < h; ++row) {
+            std::memcpy(pixels + (static_cast<size_t>(y + row) * header.width + x) * BYTES_PER_PIXEL,
+                        source + row * rowBytes, rowBytes);
+        }
+    });
+
+    if (!valid) {
+        std::cerr << "RawTileFile: " << filePath << " has corrupt tiles" << std::endl;
+        std::free(pixels);
+        return Image{};
+    }
+
+    Image image{};
+    image.data = pixels;
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+} // namespace RawTileFile
+} // namespace EpiGimp
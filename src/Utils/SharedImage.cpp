@@ -0,0 +1,365 @@
+//Images in POSIX shared memory or memfd buffers for zero-copy exchange between processes
+#include "../../include/Utils/SharedImage.hpp"
+#include "../../include/Core/RaylibWrappers.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr size_t BYTES_PER_PIXEL = 4;
+
+size_t dataOffset()
+{
+    const size_t alignment = SharedImageBuffer::DATA_ALIGNMENT;
+    return (sizeof(SharedImageHeader) + alignment - 1) / alignment * alignment;
+}
+
+bool setError(std::string* error, const std::string& message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+
+// POSIX shared memory names are a single "/component"
+bool isShmName(const std::string& name)
+{
+    return name.size() > 1 && name[0] == '/' && name.find('/', 1) == std::string::npos;
+}
+
+uint8_t* mapFd(int fd, size_t size, bool writable)
+{
+    void* mapping = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    return mapping == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mapping);
+}
+
+// Size the fd, map it and write the header of a new buffer
+uint8_t* initialise(int fd, int width, int height, size_t& size, SharedImageHeader& header, std::string* error)
+{
+    const size_t stride = static_cast<size_t>(width) * BYTES_PER_PIXEL;
+    size = dataOffset() + stride * height;
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        setError(error, std::string("cannot size buffer: ") + std::strerror(errno));
+        return nullptr;
+    }
+
+    uint8_t* mapping = mapFd(fd, size, true);
+    if (!mapping) {
+        setError(error, std::string("mmap failed: ") + std::strerror(errno));
+        return nullptr;
+    }
+
+    header = SharedImageHeader{{'E', 'P', 'S', 'H'}, SharedImageBuffer::VERSION, static_cast<uint32_t>(width),
+                               static_cast<uint32_t>(height), static_cast<uint32_t>(stride), SHARED_FORMAT_RGBA8,
+                               dataOffset(), 0};
+    std::memcpy(mapping, &header, sizeof(header));
+    return mapping;
+}
+
+// Never trust a mapped header: the pixels it describes must lie inside the mapping
+bool validHeader(const SharedImageHeader& header, size_t size)
+{
+    return std::memcmp(header.magic, "EPSH", 4) == 0 && header.version == SharedImageBuffer::VERSION &&
+           header.format == SHARED_FORMAT_RGBA8 && header.width > 0 && header.height > 0 &&
+           header.stride >= static_cast<uint64_t>(header.width) * BYTES_PER_PIXEL &&
+           header.dataOffset >= sizeof(SharedImageHeader) && header.dataOffset <= size &&
+           static_cast<uint64_t>(header.stride) * header.height <= size - header.dataOffset;
+}
+
+bool validSize(int width, int height, std::string* error)
+{
+    if (width <= 0 || height <= 0 || width > 65535 || height > 65535)
+        return setError(error, "invalid image size");
+    return true;
+}
+
+} // namespace
+
+SharedImageBuffer::~SharedImageBuffer()
+{
+    if (mapping_)
+        ::munmap(mapping_, size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+std::unique_ptr<SharedImageBuffer> SharedImageBuffer::create(const std::string& name, int width, int height,
+                                                             std::string* error)
+{
+    if (!isShmName(name)) {
+        setError(error, "shared memory names look like /name");
+        return nullptr;
+    }
+    if (!validSize(width, height, error))
+        return nullptr;
+
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        setError(error, "cannot create " + name + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    size_t size = 0;
+    SharedImageHeader header;
+    uint8_t* mapping = initialise(fd, width, height, size, header, error);
+    if (!mapping) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return nullptr;
+    }
+    return std::unique_ptr<SharedImageBuffer>(new SharedImageBuffer(name, fd, mapping, size, true, header));
+}
+
+std::unique_ptr<SharedImageBuffer> SharedImageBuffer::createAnonymous(int width, int height, std::string* error)
+{
+    if (!validSize(width, height, error))
+        return nullptr;
+
+    const int fd = ::memfd_create("epigimp-image", MFD_CLOEXEC);
+    if (fd < 0) {
+        setError(error, std::string("memfd_create failed: ") + std::strerror(errno));
+        return nullptr;
+    }
+
+    size_t size = 0;
+    SharedImageHeader header;
+    uint8_t* mapping = initialise(fd, width, height, size, header, error);
+    if (!mapping) {
+        ::close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<SharedImageBuffer>(new SharedImageBuffer("", fd, mapping, size, true, header));
+}
+
+std::unique_ptr<SharedImageBuffer> SharedImageBuffer::open(const std::string& name, bool writable, std::string* error)
+{
+    const int flags = (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC;
+    const int fd = isShmName(name) ? ::shm_open(name.c_str(), flags, 0) : ::open(name.c_str(), flags);
+    if (fd < 0) {
+        setError(error, "cannot open " + name + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedImageHeader)) {
+        ::close(fd);
+        setError(error, name + " is not a shared image");
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(info.st_size);
+    uint8_t* mapping = mapFd(fd, size, writable);
+    if (!mapping) {
+        ::close(fd);
+        setError(error, std::string("mmap failed: ") + std::strerror(errno));
+        return nullptr;
+    }
+
+    SharedImageHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (!validHeader(header, size)) {
+        ::munmap(mapping, size);
+        ::close(fd);
+        setError(error, name + " has an invalid shared image header");
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedImageBuffer>(new SharedImageBuffer(name, fd, mapping, size, writable, header));
+}
+
+bool SharedImageBuffer::unlink(const std::string& name)
+{
+    return isShmName(name) && ::shm_unlink(name.c_str()) == 0;
+}
+
+std::string SharedImageBuffer::getProcPath() const
+{
+    return "/proc/" + std::to_string(::getpid()) + "/fd/" + std::to_string(fd_);
+}
+
+uint64_t SharedImageBuffer::liveGeneration() const
+{
+    const auto* shared = reinterpret_cast<const SharedImageHeader*>(mapping_);
+    return __atomic_load_n(&shared->generation, __ATOMIC_ACQUIRE);
+}
+
+bool SharedImageBuffer::refresh(std::string* error)
+{
+    if (liveGeneration() == header_.generation)
+        return true;
+
+    SharedImageHeader header;
+    std::memcpy(&header, mapping_, sizeof(header));
+    if (!validHeader(header, size_))
+        return setError(error, name_ + " has an invalid shared image header");
+    header_ = header;
+    return true;
+}
+
+Image SharedImageBuffer::view() const
+{
+    if (getStride() != static_cast<size_t>(getWidth()) * BYTES_PER_PIXEL)
+        return Image{};
+
+    Image image{};
+    image.data = const_cast<uint8_t*>(pixels());
+    image.width = getWidth();
+    image.height = getHeight();
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+bool SharedImageBuffer::write(const Image& image)
+{
+    if (!writable_ || !image.data || image.width != getWidth() || image.height != getHeight())
+        return false;
+
+    if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        Image converted = ImageCopy(image);
+        ImageFormat(&converted, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        const bool ok = converted.data && write(converted);
+        UnloadImage(converted);
+        return ok;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(image.width) * BYTES_PER_PIXEL;
+    const auto* source = static_cast<const uint8_t*>(image.data);
+    uint8_t* target = mutablePixels();
+    if (getStride() == rowBytes) {
+        std::memcpy(target, source, rowBytes * image.height);
+    } else {
+        for (int y = 0; y < image.height; ++y)
+            std::memcpy(target + y * getStride(), source + y * rowBytes, rowBytes);
+    }
+
+    // Pixels first, then the generation readers poll
+    std::atomic_thread_fence(std::memory_order_release);
+    header_.generation = __atomic_add_fetch(&reinterpret_cast<SharedImageHeader*>(mapping_)->generation, 1,
+                                            __ATOMIC_RELAXED);
+    return true;
+}
+
+Image SharedImageBuffer::copy() const
+{
+    const size_t rowBytes = static_cast<size_t>(getWidth()) * BYTES_PER_PIXEL;
+    auto* data = static_cast<uint8_t*>(std::malloc(rowBytes * getHeight()));
+    if (!data)
+        return Image{};
+    for (int y = 0; y < getHeight(); ++y)
+        std::memcpy(data + y * rowBytes, pixels() + y * getStride(), rowBytes);
+
+    Image image{};
+    image.data = data;
+    image.width = getWidth();
+    image.height = getHeight();
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+namespace SharedImage {
+
+std::unique_ptr<SharedImageBuffer> publish(const std::string& name, const Image& image, std::string* error)
+{
+    if (!image.data) {
+        setError(error, "no image");
+        return nullptr;
+    }
+
+    SharedImageBuffer::unlink(name);
+    auto buffer = SharedImageBuffer::create(name, image.width, image.height, error);
+    if (buffer && !buffer->write(image)) {
+        setError(error, "cannot convert image");
+        SharedImageBuffer::unlink(name);
+        return nullptr;
+    }
+    return buffer;
+}
+
+int runCommand(const std::vector<std::string>& args)
+{
+    std::vector<std::string> positional;
+    for (const auto& arg : args) {
+        if (arg != "--shm")
+            positional.push_back(arg);
+    }
+
+    auto usage = []() {
+        std::cerr << "Usage: EpiGimp --shm put NAME FILE | get NAME FILE | info NAME | remove NAME" << std::endl;
+        return 2;
+    };
+    if (positional.size() < 2)
+        return usage();
+
+    const std::string& action = positional[0];
+    const std::string& name = positional[1];
+    std::string error;
+
+    if (action == "put" && positional.size() == 3) {
+        ImageResource image(ImageResource::loadFile(positional[2]));
+        if (!image.isValid()) {
+            std::cerr << "SharedImage: Cannot load " << positional[2] << std::endl;
+            return 1;
+        }
+        auto buffer = publish(name, *image, &error);
+        if (!buffer) {
+            std::cerr << "SharedImage: " << error << std::endl;
+            return 1;
+        }
+        std::cout << name << " " << buffer->getWidth() << "x" << buffer->getHeight() << " ("
+                  << buffer->getMappedSize() << " bytes)" << std::endl;
+        return 0;
+    }
+
+    if (action == "get" && positional.size() == 3) {
+        auto buffer = SharedImageBuffer::open(name, false, &error);
+        if (!buffer) {
+            std::cerr << "SharedImage: " << error << std::endl;
+            return 1;
+        }
+        ImageResource image(buffer->copy());
+        std::string actualPath;
+        if (!image.isValid() || !image.exportToFile(positional[2], actualPath)) {
+            std::cerr << "SharedImage: Cannot write " << positional[2] << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << actualPath << std::endl;
+        return 0;
+    }
+
+    if (action == "info" && positional.size() == 2) {
+        auto buffer = SharedImageBuffer::open(name, false, &error);
+        if (!buffer) {
+            std::cerr << "SharedImage: " << error << std::endl;
+            return 1;
+        }
+        const SharedImageHeader& header = buffer->header();
+        std::cout << name << ": " << header.width << "x" << header.height << " RGBA8, stride " << header.stride
+                  << ", data at " << header.dataOffset << ", generation " << header.generation << std::endl;
+        return 0;
+    }
+
+    if (action == "remove" && positional.size() == 2) {
+        if (!SharedImageBuffer::unlink(name)) {
+            std::cerr << "SharedImage: Cannot remove " << name << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    return usage();
+}
+
+} // namespace SharedImage
+
+} // namespace EpiGimp
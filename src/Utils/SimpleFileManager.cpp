@@ -24,11 +24,12 @@ std::optional<std::string> SimpleFileManager::showOpenDialog(const std::string&
 }
 
 std::optional<std::string> SimpleFileManager::showSaveDialog(const std::string& /*filter*/, 
-                                        const std::string& /*defaultName*/)
+                                        const std::string& defaultName)
 {
     showingSaveDialog_ = true;
     saveBrowser_->reset();
     saveBrowser_->setShowAllFiles(true); // Show all files for context in save dialog
+    saveBrowser_->setDefaultSaveFileName(defaultName);
     return std::nullopt; // Will be handled in update loop
 }
 
@@ -0,0 +1,656 @@
+//Row-by-row PNG and BMP decoding without a full-size intermediate image
+#include "../../include/Utils/StreamingDecoder.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace EpiGimp {
+
+namespace {
+
+constexpr int MAX_DIMENSION = 1 << 20;
+constexpr size_t BAND_BYTES = 1024 * 1024;     // Rows decoded per readRows() call in decode()
+
+bool setError(std::string* error, const std::string& message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+
+uint32_t readBE32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+uint16_t readLE16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLE32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+// Sample x of a row packed at depth 1, 2, 4 or 8 bits, most significant bits first
+unsigned packedSample(const uint8_t* row, int x, int depth)
+{
+    const size_t bit = static_cast<size_t>(x) * depth;
+    const int shift = 8 - depth - static_cast<int>(bit % 8);
+    return (row[bit / 8] >> shift) & ((1u << depth) - 1);
+}
+
+std::string lowerExtension(const std::string& filePath)
+{
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+// --- PNG -----------------------------------------------------------------------------
+
+class PngRowDecoder : public StreamingDecoder {
+private:
+    std::FILE* file_ = nullptr;
+    z_stream zstream_{};
+    bool zstreamReady_ = false;
+    std::vector<uint8_t> input_;
+    uint32_t idatRemaining_ = 0;
+
+    int colorType_ = 0;
+    int bitDepth_ = 0;
+    size_t bytesPerPixel_ = 1;       // For filtering, at least one
+    size_t stride_ = 0;              // Bytes per scanline without the filter byte
+    std::vector<uint8_t> current_;
+    std::vector<uint8_t> previous_;
+
+    uint8_t palette_[256][4] = {};
+    bool hasKey_ = false;
+    uint16_t key_[3] = {};
+
+public:
+    ~PngRowDecoder() override
+    {
+        if (zstreamReady_)
+            inflateEnd(&zstream_);
+        if (file_)
+            std::fclose(file_);
+    }
+
+    bool open(const std::string& filePath, std::string* error)
+    {
+        file_ = std::fopen(filePath.c_str(), "rb");
+        if (!file_)
+            return setError(error, "cannot open " + filePath);
+        std::setvbuf(file_, nullptr, _IOFBF, 256 * 1024);
+
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        uint8_t header[8];
+        if (std::fread(header, 1, 8, file_) != 8 || std::memcmp(header, signature, 8) != 0)
+            return setError(error, "not a PNG file");
+
+        bool haveHeader = false;
+        bool havePalette = false;
+        while (true) {
+            uint8_t chunk[8];
+            if (std::fread(chunk, 1, 8, file_) != 8)
+                return setError(error, "truncated PNG");
+            const uint32_t length = readBE32(chunk);
+            const std::string type(reinterpret_cast<const char*>(chunk + 4), 4);
+
+            if (type == "IDAT") {
+                if (!haveHeader || (colorType_ == 3 && !havePalette))
+                    return setError(error, "PNG data before header or palette");
+                idatRemaining_ = length;
+                break;
+            }
+            if (type == "IEND" || length > (1u << 30))
+                return setError(error, "PNG has no image data");
+
+            std::vector<uint8_t> data(length);
+            if (length > 0 && std::fread(data.data(), 1, length, file_) != length)
+                return setError(error, "truncated PNG");
+            std::fseek(file_, 4, SEEK_CUR);   // CRC
+
+            if (type == "IHDR") {
+                if (length != 13 || !readHeader(data.data(), error))
+                    return setError(error, error && !error->empty() ? *error : "bad PNG header");
+                haveHeader = true;
+            } else if (type == "PLTE") {
+                if (length % 3 != 0 || length > 768)
+                    return setError(error, "bad PNG palette");
+                for (uint32_t i = 0; i < length / 3; ++i) {
+                    palette_[i][0] = data[i * 3];
+                    palette_[i][1] = data[i * 3 + 1];
+                    palette_[i][2] = data[i * 3 + 2];
+                    palette_[i][3] = 255;
+                }
+                havePalette = true;
+            } else if (type == "tRNS") {
+                readTransparency(data);
+            }
+        }
+
+        if (inflateInit(&zstream_) != Z_OK)
+            return setError(error, "zlib initialisation failed");
+        zstreamReady_ = true;
+        input_.resize(64 * 1024);
+        current_.assign(stride_ + 1, 0);
+        previous_.assign(stride_ + 1, 0);
+        return true;
+    }
+
+protected:
+    bool readRow(uint8_t* rgba) override
+    {
+        if (!inflateBytes(current_.data(), current_.size()) || !unfilter())
+            return false;
+        convert(current_.data() + 1, rgba);
+        current_.swap(previous_);
+        return true;
+    }
+
+private:
+    bool readHeader(const uint8_t* data, std::string* error)
+    {
+        const uint32_t width = readBE32(data);
+        const uint32_t height = readBE32(data + 4);
+        bitDepth_ = data[8];
+        colorType_ = data[9];
+        if (width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION)
+            return setError(error, "unsupported PNG size");
+        if (data[10] != 0 || data[11] != 0)
+            return setError(error, "unknown PNG compression or filter method");
+        if (data[12] != 0)
+            return setError(error, "interlaced PNG");
+
+        int channels = 0;
+        bool validDepth = false;
+        switch (colorType_) {
+            case 0: channels = 1; validDepth = bitDepth_ == 1 || bitDepth_ == 2 || bitDepth_ == 4 || bitDepth_ == 8 || bitDepth_ == 16; break;
+            case 2: channels = 3; validDepth = bitDepth_ == 8 || bitDepth_ == 16; break;
+            case 3: channels = 1; validDepth = bitDepth_ == 1 || bitDepth_ == 2 || bitDepth_ == 4 || bitDepth_ == 8; break;
+            case 4: channels = 2; validDepth = bitDepth_ == 8 || bitDepth_ == 16; break;
+            case 6: channels = 4; validDepth = bitDepth_ == 8 || bitDepth_ == 16; break;
+            default: break;
+        }
+        if (!validDepth)
+            return setError(error, "invalid PNG colour type or bit depth");
+
+        width_ = static_cast<int>(width);
+        height_ = static_cast<int>(height);
+        const size_t bitsPerPixel = static_cast<size_t>(channels) * bitDepth_;
+        bytesPerPixel_ = std::max<size_t>(1, bitsPerPixel / 8);
+        stride_ = (static_cast<size_t>(width) * bitsPerPixel + 7) / 8;
+        return true;
+    }
+
+    void readTransparency(const std::vector<uint8_t>& data)
+    {
+        if (colorType_ == 3) {
+            for (size_t i = 0; i < data.size() && i < 256; ++i)
+                palette_[i][3] = data[i];
+        } else if (colorType_ == 0 && data.size() >= 2) {
+            hasKey_ = true;
+            key_[0] = static_cast<uint16_t>((data[0] << 8) | data[1]);
+        } else if (colorType_ == 2 && data.size() >= 6) {
+            hasKey_ = true;
+            for (int i = 0; i < 3; ++i)
+                key_[i] = static_cast<uint16_t>((data[i * 2] << 8) | data[i * 2 + 1]);
+        }
+    }
+
+    // Refill the zlib input from the current IDAT chunk, moving on to the next one
+    bool fillInput()
+    {
+        while (idatRemaining_ == 0) {
+            uint8_t chunk[12];
+            if (std::fread(chunk, 1, 12, file_) != 12)   // CRC of the previous chunk, then the next header
+                return false;
+            if (std::memcmp(chunk + 8, "IDAT", 4) != 0)
+                return false;
+            idatRemaining_ = readBE32(chunk + 4);
+        }
+
+        const size_t wanted = std::min<size_t>(idatRemaining_, input_.size());
+        const size_t got = std::fread(input_.data(), 1, wanted, file_);
+        if (got == 0)
+            return false;
+        idatRemaining_ -= static_cast<uint32_t>(got);
+        zstream_.next_in = input_.data();
+        zstream_.avail_in = static_cast<uInt>(got);
+        return true;
+    }
+
+    bool inflateBytes(uint8_t* out, size_t count)
+    {
+        zstream_.next_out = out;
+        zstream_.avail_out = static_cast<uInt>(count);
+        while (zstream_.avail_out > 0) {
+            if (zstream_.avail_in == 0 && !fillInput())
+                return false;
+            const int result = inflate(&zstream_, Z_NO_FLUSH);
+            if (result == Z_STREAM_END)
+                return zstream_.avail_out == 0;
+            if (result != Z_OK && !(result == Z_BUF_ERROR && zstream_.avail_in == 0))
+                return false;
+        }
+        return true;
+    }
+
+    bool unfilter()
+    {
+        uint8_t* row = current_.data() + 1;
+        const uint8_t* prior = previous_.data() + 1;
+        const size_t bpp = bytesPerPixel_;
+
+        switch (current_[0]) {
+            case 0:
+                break;
+            case 1:
+                for (size_t i = bpp; i < stride_; ++i)
+                    row[i] = static_cast<uint8_t>(row[i] + row[i - bpp]);
+                break;
+            case 2:
+                for (size_t i = 0; i < stride_; ++i)
+                    row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+                break;
+            case 3:
+                for (size_t i = 0; i < stride_; ++i) {
+                    const int left = i >= bpp ? row[i - bpp] : 0;
+                    row[i] = static_cast<uint8_t>(row[i] + ((left + prior[i]) >> 1));
+                }
+                break;
+            case 4:
+                for (size_t i = 0; i < stride_; ++i) {
+                    const int a = i >= bpp ? row[i - bpp] : 0;
+                    const int b = prior[i];
+                    const int c = i >= bpp ? prior[i - bpp] : 0;
+                    const int p = a + b - c;
+                    const int pa = std::abs(p - a);
+                    const int pb = std::abs(p - b);
+                    const int pc = std::abs(p - c);
+                    const int predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                    row[i] = static_cast<uint8_t>(row[i] + predictor);
+                }
+                break;
+            default:
+                return false;
+        }
+        return true;
+    }
+
+    void convert(const uint8_t* row, uint8_t* out) const
+    {
+        const bool wide = bitDepth_ == 16;
+        auto sample16 = [row](size_t index) { return static_cast<uint16_t>((row[index * 2] << 8) | row[index * 2 + 1]); };
+
+        for (int x = 0; x < width_; ++x, out += 4) {
+            switch (colorType_) {
+                case 0: {
+                    unsigned value;
+                    uint8_t gray;
+                    if (wide) {
+                        value = sample16(x);
+                        gray = static_cast<uint8_t>(value >> 8);
+                    } else if (bitDepth_ == 8) {
+                        value = row[x];
+                        gray = static_cast<uint8_t>(value);
+                    } else {
+                        value = packedSample(row, x, bitDepth_);
+                        gray = static_cast<uint8_t>(value * 255 / ((1u << bitDepth_) - 1));
+                    }
+                    out[0] = out[1] = out[2] = gray;
+                    out[3] = (hasKey_ && value == key_[0]) ? 0 : 255;
+                    break;
+                }
+                case 2: {
+                    uint16_t rgb[3];
+                    for (int c = 0; c < 3; ++c) {
+                        rgb[c] = wide ? sample16(static_cast<size_t>(x) * 3 + c) : row[static_cast<size_t>(x) * 3 + c];
+                        out[c] = static_cast<uint8_t>(wide ? rgb[c] >> 8 : rgb[c]);
+                    }
+                    const bool transparent = hasKey_ && rgb[0] == key_[0] && rgb[1] == key_[1] && rgb[2] == key_[2];
+                    out[3] = transparent ? 0 : 255;
+                    break;
+                }
+                case 3: {
+                    const unsigned index = bitDepth_ == 8 ? row[x] : packedSample(row, x, bitDepth_);
+                    std::memcpy(out, palette_[index], 4);
+                    break;
+                }
+                case 4:
+                    out[0] = out[1] = out[2] = wide ? row[x * 4] : row[x * 2];
+                    out[3] = wide ? row[x * 4 + 2] : row[x * 2 + 1];
+                    break;
+                default:
+                    if (wide) {
+                        for (int c = 0; c < 4; ++c)
+                            out[c] = row[x * 8 + c * 2];
+                    } else {
+                        std::memcpy(out, row + x * 4, 4);
+                    }
+                    break;
+            }
+        }
+    }
+};
+
+// --- BMP -----------------------------------------------------------------------------
+
+class BmpRowDecoder : public StreamingDecoder {
+private:
+    struct Channel {
+        uint32_t mask = 0;
+        int shift = 0;
+        int bits = 0;
+    };
+
+    int fd_ = -1;
+    uint64_t dataOffset_ = 0;
+    size_t rowStride_ = 0;
+    bool topDown_ = false;
+    int bitsPerPixel_ = 0;
+    Channel channels_[4];            // R, G, B, A (A.mask == 0: opaque)
+    uint8_t palette_[256][4] = {};
+    std::vector<uint8_t> row_;
+
+public:
+    ~BmpRowDecoder() override
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    bool open(const std::string& filePath, std::string* error)
+    {
+        fd_ = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0)
+            return setError(error, "cannot open " + filePath);
+
+        uint8_t header[14 + 124] = {};
+        const ssize_t got = ::pread(fd_, header, sizeof(header), 0);
+        if (got < 14 + 40 || header[0] != 'B' || header[1] != 'M')
+            return setError(error, "not a BMP file");
+
+        dataOffset_ = readLE32(header + 10);
+        const uint32_t infoSize = readLE32(header + 14);
+        if (infoSize < 40 || infoSize > 124 || got < static_cast<ssize_t>(14 + infoSize))
+            return setError(error, "unsupported BMP header");
+
+        const uint8_t* info = header + 14;
+        const int32_t width = static_cast<int32_t>(readLE32(info + 4));
+        const int32_t height = static_cast<int32_t>(readLE32(info + 8));
+        const uint16_t planes = readLE16(info + 12);
+        bitsPerPixel_ = readLE16(info + 14);
+        const uint32_t compression = readLE32(info + 16);
+        const uint32_t colorsUsed = readLE32(info + 32);
+
+        if (planes != 1 || width <= 0 || height == 0 || height == INT32_MIN || width > MAX_DIMENSION ||
+            std::abs(height) > MAX_DIMENSION)
+            return setError(error, "unsupported BMP size");
+        width_ = width;
+        height_ = std::abs(height);
+        topDown_ = height < 0;
+        rowStride_ = (static_cast<size_t>(width) * bitsPerPixel_ + 31) / 32 * 4;
+
+        constexpr uint32_t BI_RGB = 0;
+        constexpr uint32_t BI_BITFIELDS = 3;
+        constexpr uint32_t BI_ALPHABITFIELDS = 6;
+
+        if (compression == BI_RGB) {
+            switch (bitsPerPixel_) {
+                case 1: case 4: case 8:
+                    if (!readPalette(14 + infoSize, colorsUsed))
+                        return setError(error, "truncated BMP palette");
+                    break;
+                case 16:
+                    setMasks(0x7C00, 0x03E0, 0x001F, 0);
+                    break;
+                case 24:
+                    break;
+                case 32:
+                    // The fourth byte is reserved in plain BI_RGB files, so they are opaque
+                    setMasks(0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+                    break;
+                default:
+                    return setError(error, "unsupported BMP bit depth");
+            }
+        } else if ((compression == BI_BITFIELDS || compression == BI_ALPHABITFIELDS) &&
+                   (bitsPerPixel_ == 16 || bitsPerPixel_ == 32)) {
+            // Masks live in the V4/V5 header, or right after a plain 40-byte one
+            uint8_t masks[16] = {};
+            if (infoSize >= 52) {
+                std::memcpy(masks, info + 40, infoSize >= 56 ? 16 : 12);
+            } else if (::pread(fd_, masks, compression == BI_ALPHABITFIELDS ? 16 : 12, 14 + infoSize) < 12) {
+                return setError(error, "truncated BMP masks");
+            }
+            const uint32_t alpha = (infoSize >= 56 || compression == BI_ALPHABITFIELDS) ? readLE32(masks + 12) : 0;
+            setMasks(readLE32(masks), readLE32(masks + 4), readLE32(masks + 8), alpha);
+        } else {
+            return setError(error, "compressed BMP");
+        }
+
+        row_.resize(rowStride_);
+        return true;
+    }
+
+protected:
+    bool readRow(uint8_t* rgba) override
+    {
+        const int fileRow = topDown_ ? rowsRead_ : height_ - 1 - rowsRead_;
+        const uint64_t offset = dataOffset_ + static_cast<uint64_t>(fileRow) * rowStride_;
+        if (::pread(fd_, row_.data(), rowStride_, static_cast<off_t>(offset)) != static_cast<ssize_t>(rowStride_))
+            return false;
+
+        const uint8_t* in = row_.data();
+        for (int x = 0; x < width_; ++x, rgba += 4) {
+            if (bitsPerPixel_ <= 8) {
+                const unsigned index = bitsPerPixel_ == 8 ? in[x] : packedSample(in, x, bitsPerPixel_);
+                std::memcpy(rgba, palette_[index], 4);
+            } else if (bitsPerPixel_ == 24) {
+                rgba[0] = in[x * 3 + 2];
+                rgba[1] = in[x * 3 + 1];
+                rgba[2] = in[x * 3];
+                rgba[3] = 255;
+            } else {
+                const uint32_t value = bitsPerPixel_ == 16 ? readLE16(in + x * 2) : readLE32(in + x * 4);
+                for (int c = 0; c < 3; ++c)
+                    rgba[c] = extract(value, channels_[c]);
+                rgba[3] = channels_[3].mask ? extract(value, channels_[3]) : 255;
+            }
+        }
+        return true;
+    }
+
+private:
+    bool readPalette(uint64_t offset, uint32_t colorsUsed)
+    {
+        const uint32_t entries = std::min<uint32_t>(colorsUsed ? colorsUsed : 1u << bitsPerPixel_, 256);
+        uint8_t data[256 * 4];
+        if (::pread(fd_, data, entries * 4, static_cast<off_t>(offset)) != static_cast<ssize_t>(entries * 4))
+            return false;
+        for (uint32_t i = 0; i < entries; ++i) {
+            palette_[i][0] = data[i * 4 + 2];
+            palette_[i][1] = data[i * 4 + 1];
+            palette_[i][2] = data[i * 4];
+            palette_[i][3] = 255;
+        }
+        return true;
+    }
+
+    void setMasks(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+    {
+        const uint32_t masks[4] = {red, green, blue, alpha};
+        for (int c = 0; c < 4; ++c) {
+            Channel& channel = channels_[c];
+            channel.mask = masks[c];
+            channel.shift = 0;
+            channel.bits = 0;
+            if (!channel.mask)
+                continue;
+            while (!((channel.mask >> channel.shift) & 1))
+                channel.shift++;
+            while (channel.shift + channel.bits < 32 && ((channel.mask >> (channel.shift + channel.bits)) & 1))
+                channel.bits++;
+        }
+    }
+
+    static uint8_t extract(uint32_t value, const Channel& channel)
+    {
+        if (!channel.mask)
+            return 0;
+        const uint32_t raw = (value & channel.mask) >> channel.shift;
+        if (channel.bits >= 8)
+            return static_cast<uint8_t>(raw >> (channel.bits - 8));
+        return static_cast<uint8_t>(raw * 255 / ((1u << channel.bits) - 1));
+    }
+};
+
+} // namespace
+
+bool StreamingDecoder::canStream(const std::string& filePath)
+{
+    const std::string extension = lowerExtension(filePath);
+    return extension == ".png" || extension == ".bmp";
+}
+
+std::unique_ptr<StreamingDecoder> StreamingDecoder::open(const std::string& filePath, std::string* error)
+{
+    const std::string extension = lowerExtension(filePath);
+    if (extension == ".png") {
+        auto decoder = std::make_unique<PngRowDecoder>();
+        if (decoder->open(filePath, error))
+            return decoder;
+    } else if (extension == ".bmp") {
+        auto decoder = std::make_unique<BmpRowDecoder>();
+        if (decoder->open(filePath, error))
+            return decoder;
+    } else {
+        setError(error, "not a PNG or BMP file");
+    }
+    return nullptr;
+}
+
+bool StreamingDecoder::readRows(uint8_t* rgba, int count)
+{
+    if (count < 0 || rowsRead_ + count > height_)
+        return false;
+
+    const size_t rowBytes = static_cast<size_t>(width_) * 4;
+    for (int i = 0; i < count; ++i) {
+        if (!readRow(rgba + i * rowBytes))
+            return false;
+        rowsRead_++;
+    }
+    return true;
+}
+
+Image StreamingDecoder::decode(StreamingDecoder& decoder, int maxWidth, int maxHeight, const ProgressCallback& onProgress)
+{
+    const int width = decoder.getWidth();
+    const int height = decoder.getHeight();
+    if (decoder.getRowsRead() != 0 || width <= 0 || height <= 0)
+        return Image{};
+
+    int targetWidth = width;
+    int targetHeight = height;
+    if (maxWidth > 0 && maxHeight > 0 && (width > maxWidth || height > maxHeight)) {
+        const float scale = std::min(static_cast<float>(maxWidth) / width, static_cast<float>(maxHeight) / height);
+        targetWidth = std::clamp(static_cast<int>(width * scale), 1, width);
+        targetHeight = std::clamp(static_cast<int>(height * scale), 1, height);
+    }
+
+    // The only full-size allocation is the result itself
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    auto* data = static_cast<uint8_t*>(std::malloc(static_cast<size_t>(targetWidth) * targetHeight * 4));
+    if (!data)
+        return Image{};
+
+    const int bandRows = static_cast<int>(std::max<size_t>(1, BAND_BYTES / rowBytes));
+    const bool scaled = targetWidth != width || targetHeight != height;
+    std::vector<uint8_t> band(scaled ? bandRows * rowBytes : 0);
+    RowDownscaler scaler(width, height, targetWidth, targetHeight, data);
+
+    for (int y = 0; y < height; y += bandRows) {
+        const int rows = std::min(bandRows, height - y);
+        uint8_t* target = scaled ? band.data() : data + y * rowBytes;
+        if (!decoder.readRows(target, rows) || (onProgress && !onProgress(static_cast<float>(y + rows) / height))) {
+            std::free(data);
+            return Image{};
+        }
+        if (scaled)
+            scaler.push(target, rows);
+    }
+
+    Image image{};
+    image.data = data;
+    image.width = targetWidth;
+    image.height = targetHeight;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+RowDownscaler::RowDownscaler(int sourceWidth, int sourceHeight, int targetWidth, int targetHeight, uint8_t* output)
+    : sourceWidth_(sourceWidth), sourceHeight_(sourceHeight), targetWidth_(std::min(targetWidth, sourceWidth)),
+      targetHeight_(std::min(targetHeight, sourceHeight)), output_(output), targetColumn_(sourceWidth),
+      columnCount_(targetWidth_, 0), sums_(static_cast<size_t>(targetWidth_) * 4, 0), sourceRow_(0), targetRow_(0),
+      rowsInBox_(0)
+{
+    for (int x = 0; x < sourceWidth_; ++x) {
+        targetColumn_[x] = static_cast<int>(static_cast<int64_t>(x) * targetWidth_ / sourceWidth_);
+        columnCount_[targetColumn_[x]]++;
+    }
+    rowEnd_ = static_cast<int>((static_cast<int64_t>(sourceHeight_) + targetHeight_ - 1) / targetHeight_);
+}
+
+void RowDownscaler::push(const uint8_t* rows, int count)
+{
+    for (int r = 0; r < count && sourceRow_ < sourceHeight_; ++r) {
+        const uint8_t* p = rows + static_cast<size_t>(r) * sourceWidth_ * 4;
+        for (int x = 0; x < sourceWidth_; ++x, p += 4) {
+            uint64_t* sum = &sums_[static_cast<size_t>(targetColumn_[x]) * 4];
+            sum[0] += p[0] * p[3];
+            sum[1] += p[1] * p[3];
+            sum[2] += p[2] * p[3];
+            sum[3] += p[3];
+        }
+        sourceRow_++;
+        rowsInBox_++;
+        if (sourceRow_ == rowEnd_ || sourceRow_ == sourceHeight_)
+            emitRow();
+    }
+}
+
+void RowDownscaler::emitRow()
+{
+    uint8_t* out = output_ + static_cast<size_t>(targetRow_) * targetWidth_ * 4;
+    for (int tx = 0; tx < targetWidth_; ++tx, out += 4) {
+        uint64_t* sum = &sums_[static_cast<size_t>(tx) * 4];
+        const uint64_t count = static_cast<uint64_t>(columnCount_[tx]) * rowsInBox_;
+        const uint64_t alpha = sum[3];
+        if (alpha == 0 || count == 0) {
+            std::memset(out, 0, 4);
+        } else {
+            out[0] = static_cast<uint8_t>((sum[0] + alpha / 2) / alpha);
+            out[1] = static_cast<uint8_t>((sum[1] + alpha / 2) / alpha);
+            out[2] = static_cast<uint8_t>((sum[2] + alpha / 2) / alpha);
+            out[3] = static_cast<uint8_t>((alpha + count / 2) / count);
+        }
+        sum[0] = sum[1] = sum[2] = sum[3] = 0;
+    }
+
+    targetRow_++;
+    rowsInBox_ = 0;
+    // Source row y belongs to target row y * targetHeight / sourceHeight
+    rowEnd_ = static_cast<int>((static_cast<int64_t>(targetRow_ + 1) * sourceHeight_ + targetHeight_ - 1) / targetHeight_);
+}
+
+} // namespace EpiGimp
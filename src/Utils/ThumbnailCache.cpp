@@ -0,0 +1,360 @@
+//Background-decoded image thumbnails with an on-disk cache
+#include "../../include/Utils/ThumbnailCache.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include "../../include/Utils/ProjectFile.hpp"
+#include "../../include/Utils/QoiCodec.hpp"
+#include "../../include/Utils/StreamingDecoder.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace EpiGimp {
+
+ThumbnailCache::ThumbnailCache(std::string cacheDirectory, int size, unsigned workers, size_t capacity,
+                               uint64_t diskLimit)
+    : directory_(cacheDirectory.empty() ? defaultDirectory() : std::move(cacheDirectory)),
+      size_(std::max(size, 1)), capacity_(capacity), diskLimit_(diskLimit),
+      maxDecoders_(workers ? workers : std::max(1u, JobSystem::shared().getWorkerCount() / 2)), stopping_(false),
+      decoders_(0), frame_(0), diskBytes_(0), diskMeasured_(false), trimming_(false), textureCount_(0)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        std::cerr << "ThumbnailCache: Cannot create " << directory_ << ": " << ec.message()
+                  << ", thumbnails will not be kept" << std::endl;
+        directory_.clear();
+    }
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    {
+        // Decode jobs already submitted still run, see stopping_ and return at once
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        decodersDone_.wait(lock, [this]() { return decoders_ == 0; });
+    }
+
+    for (auto& result : results_)
+        UnloadImage(result.image);
+    for (auto& result : uploads_)
+        UnloadImage(result.image);
+}
+
+const Texture2D* ThumbnailCache::request(const std::string& path, uint64_t fileSize, int64_t modified)
+{
+    const std::string key = cacheKey(path, fileSize, modified);
+    const uint64_t frame = frame_.load();
+
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        Entry& entry = it->second;
+        entry.lastRequested = frame;
+        if (entry.state == State::Ready)
+            return entry.texture->get();
+        if (entry.state == State::Failed)
+            return nullptr;
+
+        // Still queued: keep it wanted so the workers do not drop it
+        std::lock_guard<std::mutex> lock(mutex_);
+        wanted_[key] = frame;
+        return nullptr;
+    }
+
+    entries_.emplace(key, Entry{State::Queued, frame, std::nullopt});
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wanted_[key] = frame;
+        queue_.push_back({key, path});
+        startDecoders();
+    }
+    return nullptr;
+}
+
+void ThumbnailCache::update(int uploadBudget)
+{
+    frame_++;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& result : results_) {
+            if (result.dropped)
+                entries_.erase(result.key); // Requested again once it is back on screen
+            else
+                uploads_.push_back(std::move(result));
+        }
+        results_.clear();
+    }
+
+    for (int i = 0; i < uploadBudget && !uploads_.empty(); ++i) {
+        Result result = std::move(uploads_.front());
+        uploads_.pop_front();
+
+        auto it = entries_.find(result.key);
+        if (it != entries_.end()) {
+            Entry& entry = it->second;
+            if (result.image.data)
+                entry.texture = TextureResource::fromImage(result.image);
+            if (entry.texture) {
+                entry.state = State::Ready;
+                textureCount_++;
+            } else {
+                entry.state = State::Failed;
+            }
+        }
+        UnloadImage(result.image);
+    }
+
+    evict();
+}
+
+bool ThumbnailCache::isIdle()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.empty() && decoders_ == 0 && results_.empty() && uploads_.empty();
+}
+
+bool ThumbnailCache::hasFailed(const std::string& path, uint64_t fileSize, int64_t modified) const
+{
+    auto it = entries_.find(cacheKey(path, fileSize, modified));
+    return it != entries_.end() && it->second.state == State::Failed;
+}
+
+std::string ThumbnailCache::cacheKey(const std::string& path, uint64_t fileSize, int64_t modified)
+{
+    // FNV-1a over the path and the raw size and timestamp
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t length) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(path.data(), path.size());
+    mix(&fileSize, sizeof(fileSize));
+    mix(&modified, sizeof(modified));
+
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+std::string ThumbnailCache::defaultDirectory()
+{
+    if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+        return (std::filesystem::path(cache) / "epigimp" / "thumbnails").string();
+    if (const char* home = std::getenv("HOME"); home && *home)
+        return (std::filesystem::path(home) / ".cache" / "epigimp" / "thumbnails").string();
+
+    std::error_code ec;
+    return (std::filesystem::temp_directory_path(ec) / "epigimp-thumbnails").string();
+}
+
+Image ThumbnailCache::downscale(const Image& source, int maxSize)
+{
+    if (!source.data || source.width <= 0 || source.height <= 0 ||
+        source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        return Image{};
+
+    if (source.width <= maxSize && source.height <= maxSize)
+        return ImageCopy(source);
+
+    const float scale = static_cast<float>(maxSize) / std::max(source.width, source.height);
+    const int width = std::max(1, static_cast<int>(source.width * scale + 0.5f));
+    const int height = std::max(1, static_cast<int>(source.height * scale + 0.5f));
+
+    auto* data = static_cast<uint8_t*>(std::malloc(static_cast<size_t>(width) * height * 4));
+    if (!data)
+        return Image{};
+
+    RowDownscaler scaler(source.width, source.height, width, height, data);
+    scaler.push(static_cast<const uint8_t*>(source.data), source.height);
+
+    Image image{};
+    image.data = data;
+    image.width = width;
+    image.height = height;
+    image.mipmaps = 1;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+void ThumbnailCache::startDecoders()
+{
+    while (decoders_ < maxDecoders_ && decoders_ < queue_.size()) {
+        decoders_++;
+        JobSystem::shared().submit([this]() { decodeQueued(); });
+    }
+}
+
+void ThumbnailCache::decodeQueued()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t decoded = 0;
+    while (!stopping_ && !queue_.empty()) {
+        // Give the worker back after a batch; the follow-up job keeps this decoder's slot
+        if (decoded == DECODE_BATCH) {
+            JobSystem::shared().submit([this]() { decodeQueued(); });
+            return;
+        }
+
+        // Newest first: the rows the user is looking at right now
+        Job job = std::move(queue_.back());
+        queue_.pop_back();
+
+        auto wanted = wanted_.find(job.key);
+        const bool stale = wanted == wanted_.end() || wanted->second + 1 < frame_.load();
+        if (stale) {
+            wanted_.erase(job.key);
+            results_.push_back({job.key, Image{}, true});
+            continue;
+        }
+
+        lock.unlock();
+        Image image = decode(job);
+        decoded++;
+        lock.lock();
+        wanted_.erase(job.key);
+        results_.push_back({job.key, image, false});
+    }
+
+    decoders_--;
+    decodersDone_.notify_all();
+}
+
+Image ThumbnailCache::decode(const Job& job)
+{
+    const std::string cachePath = directory_.empty() ? "" : (std::filesystem::path(directory_) / (job.key + ".qoi")).string();
+    if (!cachePath.empty() && std::filesystem::exists(cachePath)) {
+        Image cached = QoiCodec::read(cachePath);
+        if (cached.data) {
+            // Recently used: trimDisk() removes the oldest files first
+            std::error_code ec;
+            std::filesystem::last_write_time(cachePath, std::filesystem::file_time_type::clock::now(), ec);
+            return cached;
+        }
+    }
+
+    // PNG and BMP are averaged down while decoding; nothing full-size is ever held
+    if (auto streaming = StreamingDecoder::open(job.path)) {
+        Image thumbnail = StreamingDecoder::decode(*streaming, size_, size_);
+        if (thumbnail.data) {
+            store(thumbnail, cachePath);
+            return thumbnail;
+        }
+    }
+
+    Image source;
+    if (ProjectFile::isProjectPath(job.path)) {
+        auto reader = ProjectReader::open(job.path);
+        source = reader ? reader->composite() : Image{};
+    } else {
+        source = ImageResource::loadFile(job.path);
+    }
+    if (!source.data)
+        return Image{};
+
+    if (source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    Image thumbnail = downscale(source, size_);
+    UnloadImage(source);
+    store(thumbnail, cachePath);
+    return thumbnail;
+}
+
+void ThumbnailCache::store(const Image& thumbnail, const std::string& cachePath)
+{
+    if (!thumbnail.data || cachePath.empty())
+        return;
+
+    // Write under a per-thread name and rename, so readers never see a partial file
+    const std::string partial = cachePath + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    std::error_code ec;
+    if (QoiCodec::write(thumbnail, partial, 1))
+        std::filesystem::rename(partial, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(partial, ec);
+        return;
+    }
+
+    const uint64_t bytes = std::filesystem::file_size(cachePath, ec);
+    const uint64_t total = diskBytes_ += ec ? 0 : bytes;
+    if (!diskMeasured_.exchange(true) || total > diskLimit_)
+        trimDisk();
+}
+
+void ThumbnailCache::trimDisk()
+{
+    // One decode job trims at a time; the others keep decoding
+    if (trimming_.exchange(true))
+        return;
+
+    struct CachedFile {
+        std::filesystem::file_time_type used;
+        uint64_t bytes;
+        std::filesystem::path path;
+    };
+    std::vector<CachedFile> files;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".qoi")
+            continue;
+        std::error_code fileError;
+        const uint64_t bytes = it->file_size(fileError);
+        const auto used = it->last_write_time(fileError);
+        if (fileError)
+            continue;
+        files.push_back({used, bytes, it->path()});
+        total += bytes;
+    }
+
+    // Trim to three quarters of the limit so the next trim is not one thumbnail away
+    if (total > diskLimit_) {
+        std::sort(files.begin(), files.end(),
+                  [](const CachedFile& a, const CachedFile& b) { return a.used < b.used; });
+        const uint64_t target = diskLimit_ / 4 * 3;
+        size_t removed = 0;
+        for (const auto& file : files) {
+            if (total <= target)
+                break;
+            if (std::filesystem::remove(file.path, ec)) {
+                total -= file.bytes;
+                removed++;
+            }
+        }
+        std::cout << "ThumbnailCache: Removed " << removed << " old thumbnails from " << directory_ << std::endl;
+    }
+
+    diskBytes_ = total;
+    trimming_ = false;
+}
+
+void ThumbnailCache::evict()
+{
+    if (textureCount_ <= capacity_)
+        return;
+
+    // Least recently shown first; never what is on screen this frame or the last
+    const uint64_t frame = frame_.load();
+    std::vector<std::pair<uint64_t, std::string>> candidates;
+    for (const auto& [key, entry] : entries_) {
+        if (entry.state == State::Ready && entry.lastRequested + 1 < frame)
+            candidates.emplace_back(entry.lastRequested, key);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& candidate : candidates) {
+        if (textureCount_ <= capacity_)
+            break;
+        entries_.erase(candidate.second);
+        textureCount_--;
+    }
+}
+
+} // namespace EpiGimp
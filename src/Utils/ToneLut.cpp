@@ -0,0 +1,257 @@
+//Per-channel lookup tables for tone adjustments
+#include "../../include/Utils/ToneLut.hpp"
+#include "../../include/Core/JobSystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace EpiGimp {
+
+namespace ToneLut {
+
+namespace {
+
+uint8_t toByte(double value)
+{
+    return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+}
+
+// The same table on red, green and blue; alpha passes through
+Table colourTable(const std::array<uint8_t, 256>& values)
+{
+    Table table = identity();
+    for (int ch = 0; ch < 3; ++ch)
+        table.channels[ch] = values;
+    return table;
+}
+
+// Look up count RGBA8 pixels; in and out may be the same
+void lookUp(const uint8_t* in, uint8_t* out, size_t count, const Table& table)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    // Each channel's table widened to words holding the result in its own byte lane
+    alignas(32) uint32_t wide[4 * 256];
+    for (int ch = 0; ch < 4; ++ch)
+        for (int v = 0; v < 256; ++v)
+            wide[ch * 256 + v] = static_cast<uint32_t>(table.channels[ch][v]) << (8 * ch);
+
+    const __m256i low = _mm256_set1_epi32(0xFF);
+    const auto* base = reinterpret_cast<const int*>(wide);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i * 4));
+        const __m256i r = _mm256_i32gather_epi32(base, _mm256_and_si256(pixels, low), 4);
+        const __m256i g = _mm256_i32gather_epi32(base + 256, _mm256_and_si256(_mm256_srli_epi32(pixels, 8), low), 4);
+        const __m256i b = _mm256_i32gather_epi32(base + 512, _mm256_and_si256(_mm256_srli_epi32(pixels, 16), low), 4);
+        const __m256i a = _mm256_i32gather_epi32(base + 768, _mm256_srli_epi32(pixels, 24), 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4),
+                            _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a)));
+    }
+#endif
+    const uint8_t* red = table.channels[0].data();
+    const uint8_t* green = table.channels[1].data();
+    const uint8_t* blue = table.channels[2].data();
+    const uint8_t* alpha = table.channels[3].data();
+    for (; i < count; ++i) {
+        const uint8_t* pixel = in + i * 4;
+        uint8_t* result = out + i * 4;
+        const uint8_t r = red[pixel[0]], g = green[pixel[1]], b = blue[pixel[2]], a = alpha[pixel[3]];
+        result[0] = r;
+        result[1] = g;
+        result[2] = b;
+        result[3] = a;
+    }
+}
+
+} // namespace
+
+bool Table::isIdentity() const
+{
+    for (const auto& channel : channels)
+        for (int v = 0; v < 256; ++v)
+            if (channel[v] != v)
+                return false;
+    return true;
+}
+
+Table identity()
+{
+    Table table;
+    for (auto& channel : table.channels)
+        for (int v = 0; v < 256; ++v)
+            channel[v] = static_cast<uint8_t>(v);
+    return table;
+}
+
+Table levels(int black, int white, float gamma, int outBlack, int outWhite)
+{
+    black = std::clamp(black, 0, 254);
+    white = std::clamp(white, black + 1, 255);
+    const double exponent = 1.0 / std::max(0.01, static_cast<double>(gamma));
+
+    std::array<uint8_t, 256> values;
+    for (int v = 0; v < 256; ++v) {
+        const double t = std::clamp(static_cast<double>(v - black) / (white - black), 0.0, 1.0);
+        values[v] = toByte(outBlack + (outWhite - outBlack) * std::pow(t, exponent));
+    }
+    return colourTable(values);
+}
+
+Table curves(std::vector<Vector2> points)
+{
+    std::sort(points.begin(), points.end(), [](const Vector2& a, const Vector2& b) { return a.x < b.x; });
+    points.erase(std::unique(points.begin(), points.end(), [](const Vector2& a, const Vector2& b) { return a.x == b.x; }),
+                 points.end());
+    if (points.size() < 2)
+        return identity();
+
+    // Fritsch-Carlson: secant slopes, tangents averaged, then limited so no segment overshoots
+    const size_t n = points.size();
+    std::vector<double> secant(n - 1), tangent(n);
+    for (size_t i = 0; i + 1 < n; ++i)
+        secant[i] = (points[i + 1].y - points[i].y) / (points[i + 1].x - points[i].x);
+    tangent[0] = secant[0];
+    tangent[n - 1] = secant[n - 2];
+    for (size_t i = 1; i + 1 < n; ++i)
+        tangent[i] = secant[i - 1] * secant[i] <= 0.0 ? 0.0 : (secant[i - 1] + secant[i]) / 2.0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        if (secant[i] == 0.0) {
+            tangent[i] = tangent[i + 1] = 0.0;
+            continue;
+        }
+        const double a = tangent[i] / secant[i];
+        const double b = tangent[i + 1] / secant[i];
+        const double length = a * a + b * b;
+        if (length > 9.0) {
+            const double scale = 3.0 / std::sqrt(length);
+            tangent[i] = scale * a * secant[i];
+            tangent[i + 1] = scale * b * secant[i];
+        }
+    }
+
+    std::array<uint8_t, 256> values;
+    size_t segment = 0;
+    for (int v = 0; v < 256; ++v) {
+        if (v <= points.front().x) {
+            values[v] = toByte(points.front().y);
+            continue;
+        }
+        if (v >= points.back().x) {
+            values[v] = toByte(points.back().y);
+            continue;
+        }
+        while (points[segment + 1].x < v)
+            ++segment;
+        const double h = points[segment + 1].x - points[segment].x;
+        const double t = (v - points[segment].x) / h;
+        const double t2 = t * t, t3 = t2 * t;
+        values[v] = toByte((2 * t3 - 3 * t2 + 1) * points[segment].y + (t3 - 2 * t2 + t) * h * tangent[segment] +
+                           (-2 * t3 + 3 * t2) * points[segment + 1].y + (t3 - t2) * h * tangent[segment + 1]);
+    }
+    return colourTable(values);
+}
+
+Table invert()
+{
+    std::array<uint8_t, 256> values;
+    for (int v = 0; v < 256; ++v)
+        values[v] = static_cast<uint8_t>(255 - v);
+    return colourTable(values);
+}
+
+Table posterize(int levels)
+{
+    levels = std::clamp(levels, 2, 255);
+    std::array<uint8_t, 256> values;
+    for (int v = 0; v < 256; ++v) {
+        const long step = std::lround(v * (levels - 1) / 255.0);
+        values[v] = toByte(step * 255.0 / (levels - 1));
+    }
+    return colourTable(values);
+}
+
+Table threshold(int level)
+{
+    std::array<uint8_t, 256> values;
+    for (int v = 0; v < 256; ++v)
+        values[v] = v >= level ? 255 : 0;
+    return colourTable(values);
+}
+
+Table then(const Table& first, const Table& second)
+{
+    Table table;
+    for (int ch = 0; ch < 4; ++ch)
+        for (int v = 0; v < 256; ++v)
+            table.channels[ch][v] = second.channels[ch][first.channels[ch][v]];
+    return table;
+}
+
+void apply(Image& image, const Table& table, Rectangle region)
+{
+    map(image, image, table, region);
+}
+
+void map(const Image& source, Image& destination, const Table& table, Rectangle region)
+{
+    if (!source.data || !destination.data)
+        return;
+    if (source.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || destination.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 ||
+        source.width != destination.width || source.height != destination.height) {
+        std::cerr << "ToneLut: Images must be RGBA8 and the same size" << std::endl;
+        return;
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(region.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(region.y)));
+    const int x1 = std::min(source.width, static_cast<int>(std::ceil(region.x + region.width)));
+    const int y1 = std::min(source.height, static_cast<int>(std::ceil(region.y + region.height)));
+    if (x1 <= x0 || y1 <= y0)
+        return;
+
+    const auto* in = static_cast<const uint8_t*>(source.data);
+    auto* out = static_cast<uint8_t*>(destination.data);
+    const size_t stride = static_cast<size_t>(source.width) * 4;
+    const bool wholeRows = x0 == 0 && x1 == source.width;
+    JobSystem::shared().parallelFor(static_cast<size_t>(y1 - y0), [&](size_t begin, size_t end) {
+        const size_t offset = (y0 + begin) * stride + static_cast<size_t>(x0) * 4;
+        if (wholeRows) {
+            // Contiguous rows run as one span
+            lookUp(in + offset, out + offset, (end - begin) * source.width, table);
+            return;
+        }
+        for (size_t y = begin; y < end; ++y)
+            lookUp(in + offset + (y - begin) * stride, out + offset + (y - begin) * stride, static_cast<size_t>(x1 - x0), table);
+    }, BAND_ROWS);
+}
+
+std::array<uint32_t, 256> histogram(const Image& image)
+{
+    std::array<uint32_t, 256> counts{};
+    if (!image.data || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        return counts;
+
+    std::mutex mutex;
+    const auto* pixels = static_cast<const uint8_t*>(image.data);
+    JobSystem::shared().parallelFor(static_cast<size_t>(image.height), [&](size_t begin, size_t end) {
+        std::array<uint32_t, 256> local{};
+        const uint8_t* pixel = pixels + begin * image.width * 4;
+        const uint8_t* last = pixels + end * image.width * 4;
+        for (; pixel < last; pixel += 4)
+            ++local[(77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8];   // Rec. 601 weights out of 256
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int v = 0; v < 256; ++v)
+            counts[v] += local[v];
+    }, BAND_ROWS);
+    return counts;
+}
+
+} // namespace ToneLut
+
+} // namespace EpiGimp
@@ -3,23 +3,67 @@
 #include <iostream>
 #include <exception>
 #include <string>
+#include <vector>
 #include "../include/Core/Application.hpp"
+#include "../include/Utils/BatchProcessor.hpp"
+#include "../include/Utils/ControlServer.hpp"
+#include "../include/Utils/SharedImage.hpp"
 
 int main(int argc, char** argv) try {
     using namespace EpiGimp;
     
+    // Batch mode, the remote client and the shared memory helper never open a window
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    for (const auto& arg : args) {
+        if (arg == "--batch")
+            return runBatchCommand(args);
+        if (arg == "--remote")
+            return runRemoteCommand(args);
+        if (arg == "--shm")
+            return SharedImage::runCommand(args);
+    }
+    
     AppConfig config;
     config.windowWidth = 1920;
     config.windowHeight = 1080;
     config.windowTitle = "EpiGimp - Paint Interface";
     config.targetFPS = 60;
     
-    if (argc >= 2) {
-        config.initialImagePath = argv[1];
+    auto usage = [](const std::string& message) {
+        std::cerr << message << std::endl
+                  << "Usage: EpiGimp [--save-format=png|qoi|ert] [--no-rle] [--control-socket=PATH] [IMAGE]" << std::endl
+                  << "       EpiGimp --batch ... | --remote ... | --shm ..." << std::endl;
+        return 2;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--save-format=", 0) == 0) {
+            // png, qoi (fast lossless) or ert (raw tile dump)
+            const std::string format = arg.substr(std::string("--save-format=").size());
+            if (format != "png" && format != "qoi" && format != "ert") {
+                std::cerr << "Unknown save format '" << format << "', expected png, qoi or ert" << std::endl;
+                return 1;
+            }
+            config.saveExtension = "." + format;
+        } else if (arg == "--no-rle") {
+            config.rawTileRle = false;
+        } else if (arg.rfind("--control-socket=", 0) == 0) {
+            // Accept JSON-RPC commands from scripts on a local socket
+            config.controlSocketPath = arg.substr(std::string("--control-socket=").size());
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            return usage("Unknown option '" + arg + "'");
+        } else if (config.initialImagePath.empty()) {
+            config.initialImagePath = arg;
+        } else {
+            return usage("Only one image can be opened at start, got '" + arg + "'");
+        }
+    }
+    
+    if (!config.initialImagePath.empty())
         std::cout << "Starting with initial image: " << config.initialImagePath << std::endl;
-    } else {
+    else
         std::cout << "Starting without initial image" << std::endl;
-    }
     
     Application app(config);
     
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <Utils/AsyncImageLoader.hpp>
+#include <UI/Canvas.hpp>
+#include <Core/EventSystem.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class AsyncImageLoaderTest : public ::testing::Test {
+protected:
+    std::unique_ptr<EventDispatcher> dispatcher_;
+    std::vector<ImageLoadProgressEvent> progressEvents_;
+    std::string testImagePath_ = "/tmp/test_async_loader.png";
+
+    void SetUp() override {
+        dispatcher_ = std::make_unique<EventDispatcher>();
+        dispatcher_->subscribe<ImageLoadProgressEvent>([this](const ImageLoadProgressEvent& event) {
+            progressEvents_.push_back(event);
+        });
+
+        Image image = GenImageColor(300, 200, RED);
+        ExportImage(image, testImagePath_.c_str());
+        UnloadImage(image);
+    }
+
+    // Pump the loader like the main loop would, with a timeout
+    std::optional<AsyncImageLoader::LoadResult> pump(AsyncImageLoader& loader, int* frames = nullptr) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        int count = 0;
+        while (std::chrono::steady_clock::now() < deadline) {
+            auto result = loader.update();
+            ++count;
+            if (result) {
+                if (frames) *frames = count;
+                return result;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return std::nullopt;
+    }
+};
+
+TEST_F(AsyncImageLoaderTest, NullDispatcherThrows) {
+    EXPECT_THROW(AsyncImageLoader(nullptr), std::invalid_argument);
+}
+
+TEST_F(AsyncImageLoaderTest, LoadsImage) {
+    AsyncImageLoader loader(dispatcher_.get());
+    loader.requestLoad(testImagePath_);
+    EXPECT_TRUE(loader.isBusy());
+
+    auto result = pump(loader);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->texture.has_value());
+    EXPECT_TRUE(result->texture->isValid());
+    EXPECT_EQ((*result->texture)->width, 300);
+    EXPECT_EQ((*result->texture)->height, 200);
+    EXPECT_EQ(result->filePath, testImagePath_);
+    EXPECT_FALSE(loader.isBusy());
+
+    // Pixels made it to the GPU intact
+    Image readBack = LoadImageFromTexture(**result->texture);
+    Color pixel = GetImageColor(readBack, 150, 100);
+    const Color expected = RED;
+    EXPECT_EQ(pixel.r, expected.r);
+    EXPECT_EQ(pixel.g, expected.g);
+    EXPECT_EQ(pixel.b, expected.b);
+    UnloadImage(readBack);
+}
+
+TEST_F(AsyncImageLoaderTest, UploadIsSpreadAcrossFrames) {
+    // 10 rows per frame -> at least 20 frames for 200 rows
+    AsyncImageLoader loader(dispatcher_.get(), 300 * 4 * 10);
+    loader.requestLoad(testImagePath_);
+
+    int frames = 0;
+    auto result = pump(loader, &frames);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->texture.has_value());
+    EXPECT_GE(frames, 20);
+}
+
+TEST_F(AsyncImageLoaderTest, ProgressEventsAreMonotonic) {
+    AsyncImageLoader loader(dispatcher_.get(), 300 * 4 * 10);
+    loader.requestLoad(testImagePath_);
+    ASSERT_TRUE(pump(loader).has_value());
+
+    ASSERT_FALSE(progressEvents_.empty());
+    for (size_t i = 1; i < progressEvents_.size(); ++i)
+        EXPECT_GE(progressEvents_[i].progress, progressEvents_[i - 1].progress);
+    EXPECT_EQ(progressEvents_.back().stage, "Uploading");
+    EXPECT_FLOAT_EQ(progressEvents_.back().progress, 1.0f);
+}
+
+TEST_F(AsyncImageLoaderTest, FitsIntoBounds) {
+    AsyncImageLoader loader(dispatcher_.get());
+    loader.requestLoad(testImagePath_, 150, 150);
+
+    auto result = pump(loader);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->texture.has_value());
+    EXPECT_EQ((*result->texture)->width, 150);
+    EXPECT_EQ((*result->texture)->height, 100);
+}
+
+TEST_F(AsyncImageLoaderTest, MissingFileReportsError) {
+    AsyncImageLoader loader(dispatcher_.get());
+    loader.requestLoad("/tmp/does_not_exist_async_loader.png");
+
+    auto result = pump(loader);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_FALSE(result->texture.has_value());
+    EXPECT_FALSE(result->error.empty());
+    EXPECT_FALSE(loader.isBusy());
+}
+
+TEST_F(AsyncImageLoaderTest, NewerRequestSupersedesOlder) {
+    Image other = GenImageColor(64, 32, BLUE);
+    ExportImage(other, "/tmp/test_async_loader_other.png");
+    UnloadImage(other);
+
+    AsyncImageLoader loader(dispatcher_.get());
+    loader.requestLoad(testImagePath_);
+    loader.requestLoad("/tmp/test_async_loader_other.png");
+
+    auto result = pump(loader);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->texture.has_value());
+    EXPECT_EQ(result->filePath, "/tmp/test_async_loader_other.png");
+    EXPECT_EQ((*result->texture)->width, 64);
+
+    // Nothing else is delivered afterwards
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_FALSE(loader.update().has_value());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST_F(AsyncImageLoaderTest, CanvasLoadsAsynchronously) {
+    Canvas canvas(Rectangle{0, 0, 800.0f, 600.0f}, dispatcher_.get(), nullptr, false);
+
+    std::string loadedPath;
+    dispatcher_->subscribe<ImageLoadedEvent>([&](const ImageLoadedEvent& event) {
+        loadedPath = event.filePath;
+    });
+
+    canvas.loadImageAsync(testImagePath_);
+    EXPECT_TRUE(canvas.isLoadingImage());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (canvas.isLoadingImage() && std::chrono::steady_clock::now() < deadline) {
+        canvas.update(1.0f / 60.0f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_FALSE(canvas.isLoadingImage());
+    EXPECT_TRUE(canvas.hasImage());
+    EXPECT_EQ(loadedPath, testImagePath_);
+}
+
+} // namespace EpiGimp
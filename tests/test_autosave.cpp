@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <Utils/Autosaver.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class AutosaveTest : public ::testing::Test {
+protected:
+    std::string directory_ = "/tmp/test_autosave";
+    DocumentSnapshot current_;
+
+    void SetUp() override {
+        std::filesystem::remove_all(directory_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory_);
+    }
+
+    AutosaveSettings settings(size_t maxBytesPerSecond = 0) {
+        AutosaveSettings result;
+        result.directory = directory_;
+        result.intervalSeconds = 0.0f;
+        result.maxBytesPerSecond = maxBytesPerSecond;
+        result.tileSize = 64;
+        return result;
+    }
+
+    // Background plus one named layer; the layer keeps id 1 across snapshots
+    DocumentSnapshot makeSnapshot(int width, int height) {
+        DocumentSnapshot snapshot(width, height);
+        snapshot.setBackground(makeSharedPixels(GenImageColor(width, height, Color{255, 255, 255, 255})));
+        LayerSnapshot ink{makeSharedPixels(GenImageColor(width, height, Color{0, 0, 0, 0}))};
+        ink.name = "Ink";
+        ink.id = 1;
+        snapshot.addLayer(ink);
+        return snapshot;
+    }
+
+    // Copy of the snapshot with one rectangle painted on a layer; other layers stay shared
+    DocumentSnapshot paint(const DocumentSnapshot& source, size_t layer, int x, int y, Color color) {
+        DocumentSnapshot result(source.getWidth(), source.getHeight());
+        result.setBackground(source.getBackground(), source.isBackgroundVisible());
+        for (size_t i = 0; i < source.getLayers().size(); ++i) {
+            LayerSnapshot copy = source.getLayers()[i];
+            if (i == layer) {
+                Image pixels = ImageCopy(*copy.pixels);
+                ImageDrawRectangle(&pixels, x, y, 8, 8, color);
+                copy.pixels = makeSharedPixels(pixels);
+            }
+            result.addLayer(copy);
+        }
+        return result;
+    }
+
+    Color layerPixel(const DocumentSnapshot& snapshot, size_t layer, int x, int y) {
+        return GetImageColor(*snapshot.getLayers()[layer].pixels, x, y);
+    }
+};
+
+TEST_F(AutosaveTest, FirstSaveWritesCheckpoint) {
+    current_ = makeSnapshot(256, 256);
+    Autosaver autosaver([this] { return current_; }, settings());
+    EXPECT_FALSE(Autosaver::hasRecoverableState(directory_));
+
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+
+    EXPECT_EQ(autosaver.getStats().checkpoints, 1u);
+    EXPECT_TRUE(Autosaver::hasRecoverableState(directory_));
+}
+
+TEST_F(AutosaveTest, DeltaWritesOnlyDirtyTiles) {
+    current_ = makeSnapshot(256, 256);
+    Autosaver autosaver([this] { return current_; }, settings());
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+
+    // 8x8 rectangle inside a single 64px tile
+    current_ = paint(current_, 0, 70, 70, Color{0, 0, 255, 255});
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+
+    Autosaver::Stats stats = autosaver.getStats();
+    EXPECT_EQ(stats.checkpoints, 1u);
+    EXPECT_EQ(stats.deltas, 1u);
+    EXPECT_EQ(stats.lastTilesWritten, 1u);
+}
+
+TEST_F(AutosaveTest, UnchangedDocumentWritesNothing) {
+    current_ = makeSnapshot(128, 128);
+    Autosaver autosaver([this] { return current_; }, settings());
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+    const uint64_t bytes = autosaver.getStats().bytesWritten;
+
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+
+    EXPECT_EQ(autosaver.getStats().deltas, 0u);
+    EXPECT_EQ(autosaver.getStats().bytesWritten, bytes);
+}
+
+TEST_F(AutosaveTest, RecoverReplaysCommittedDeltas) {
+    current_ = makeSnapshot(200, 150);
+    {
+        Autosaver autosaver([this] { return current_; }, settings());
+        autosaver.saveNow();
+        autosaver.waitForIdle();
+
+        current_ = paint(current_, 0, 10, 10, Color{255, 0, 0, 255});
+        autosaver.saveNow();
+        autosaver.waitForIdle();
+
+        // Structural changes: a new layer on top, the old one renamed and hidden
+        LayerSnapshot sketch{makeSharedPixels(GenImageColor(200, 150, Color{0, 0, 0, 0}))};
+        sketch.name = "Sketch";
+        sketch.id = 2;
+        current_.addLayer(sketch);
+        current_ = paint(current_, 1, 190, 140, Color{0, 255, 0, 255});
+        DocumentSnapshot restructured(200, 150);
+        restructured.setBackground(current_.getBackground());
+        LayerSnapshot renamed = current_.getLayers()[0];
+        renamed.name = "Inked";
+        renamed.visible = false;
+        restructured.addLayer(renamed);
+        restructured.addLayer(current_.getLayers()[1]);
+        current_ = restructured;
+        autosaver.saveNow();
+        autosaver.waitForIdle();
+        EXPECT_EQ(autosaver.getStats().checkpoints, 1u);
+        // Destroyed without discard(), as after a crash
+    }
+
+    auto recovered = Autosaver::recover(directory_);
+    ASSERT_TRUE(recovered.has_value());
+    EXPECT_EQ(recovered->getWidth(), 200);
+    EXPECT_EQ(recovered->getHeight(), 150);
+    ASSERT_NE(recovered->getBackground(), nullptr);
+    ASSERT_EQ(recovered->getLayers().size(), 2u);
+
+    EXPECT_EQ(recovered->getLayers()[0].name, "Inked");
+    EXPECT_FALSE(recovered->getLayers()[0].visible);
+    EXPECT_EQ(recovered->getLayers()[1].name, "Sketch");
+    EXPECT_EQ(layerPixel(*recovered, 0, 12, 12).r, 255);
+    EXPECT_EQ(layerPixel(*recovered, 0, 100, 100).a, 0);
+    EXPECT_EQ(layerPixel(*recovered, 1, 195, 145).g, 255);
+}
+
+TEST_F(AutosaveTest, TornJournalTailIsIgnored) {
+    current_ = makeSnapshot(128, 128);
+    {
+        Autosaver autosaver([this] { return current_; }, settings());
+        autosaver.saveNow();
+        autosaver.waitForIdle();
+        current_ = paint(current_, 0, 0, 0, Color{255, 0, 0, 255});
+        autosaver.saveNow();
+        autosaver.waitForIdle();
+        current_ = paint(current_, 0, 100, 100, Color{0, 0, 255, 255});
+        autosaver.saveNow();
+        autosaver.waitForIdle();
+    }
+
+    // Cut into the last delta, as if the process died mid-write
+    const std::string journal = Autosaver::journalPath(directory_, 1);
+    ASSERT_TRUE(std::filesystem::exists(journal));
+    std::filesystem::resize_file(journal, std::filesystem::file_size(journal) - 10);
+
+    auto recovered = Autosaver::recover(directory_);
+    ASSERT_TRUE(recovered.has_value());
+    EXPECT_EQ(layerPixel(*recovered, 0, 2, 2).r, 255);
+    EXPECT_EQ(layerPixel(*recovered, 0, 102, 102).a, 0);
+}
+
+TEST_F(AutosaveTest, DiscardRemovesState) {
+    current_ = makeSnapshot(64, 64);
+    Autosaver autosaver([this] { return current_; }, settings());
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+    ASSERT_TRUE(Autosaver::hasRecoverableState(directory_));
+
+    autosaver.discard();
+    EXPECT_FALSE(Autosaver::hasRecoverableState(directory_));
+    EXPECT_FALSE(Autosaver::recover(directory_).has_value());
+}
+
+TEST_F(AutosaveTest, IntervalTriggersSave) {
+    current_ = makeSnapshot(64, 64);
+    AutosaveSettings timed = settings();
+    timed.intervalSeconds = 1.0f;
+    Autosaver autosaver([this] { return current_; }, timed);
+
+    autosaver.update(0.5f);
+    autosaver.waitForIdle();
+    EXPECT_EQ(autosaver.getStats().checkpoints, 0u);
+
+    autosaver.update(0.6f);
+    autosaver.waitForIdle();
+    EXPECT_EQ(autosaver.getStats().checkpoints, 1u);
+}
+
+TEST_F(AutosaveTest, RateLimitThrottlesWrites) {
+    // Noise does not compress, so the checkpoint is roughly the raw size: 256 KiB
+    DocumentSnapshot snapshot(256, 256);
+    Image noise = GenImageWhiteNoise(256, 256, 0.5f);
+    ImageFormat(&noise, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    snapshot.addLayer(LayerSnapshot{makeSharedPixels(noise)});
+    current_ = snapshot;
+
+    // The first 128 KiB are covered by the initial burst, the rest waits
+    Autosaver autosaver([this] { return current_; }, settings(128 * 1024));
+    auto start = std::chrono::steady_clock::now();
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(autosaver.getStats().checkpoints, 1u);
+    EXPECT_GE(elapsed.count(), 500);
+}
+
+// A small edit on a large document costs one tile, not a full rewrite
+TEST_F(AutosaveTest, DeltaPerformance) {
+    current_ = makeSnapshot(4096, 4096);
+    Autosaver autosaver([this] { return current_; }, settings());
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+    const uint64_t checkpointBytes = autosaver.getStats().bytesWritten;
+
+    current_ = paint(current_, 0, 2000, 2000, Color{0, 0, 255, 255});
+    auto start = std::chrono::high_resolution_clock::now();
+    autosaver.saveNow();
+    autosaver.waitForIdle();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+    EXPECT_EQ(autosaver.getStats().lastTilesWritten, 1u);
+    EXPECT_LT(autosaver.getStats().bytesWritten - checkpointBytes, 4096u);
+    EXPECT_LT(duration.count(), 500);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <Core/DocumentSnapshot.hpp>
+#include <Core/EventSystem.hpp>
+#include <UI/Canvas.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+// Compositing is pure CPU work and does not need the GL context
+TEST(DocumentSnapshotTest, EmptySnapshotHasNoComposite) {
+    DocumentSnapshot snapshot(4, 4);
+    EXPECT_TRUE(snapshot.isEmpty());
+    Image result = snapshot.composite();
+    EXPECT_EQ(result.data, nullptr);
+}
+
+TEST(DocumentSnapshotTest, CompositeBlendsSourceOver) {
+    DocumentSnapshot snapshot(4, 4);
+    snapshot.setBackground(makeSharedPixels(GenImageColor(4, 4, Color{255, 255, 255, 255})));
+    snapshot.addLayer(LayerSnapshot{makeSharedPixels(GenImageColor(4, 4, Color{255, 0, 0, 128}))});
+
+    Image result = snapshot.composite();
+    ASSERT_NE(result.data, nullptr);
+    Color pixel = GetImageColor(result, 2, 2);
+    EXPECT_EQ(pixel.r, 255);
+    EXPECT_NEAR(pixel.g, 127, 1);
+    EXPECT_NEAR(pixel.b, 127, 1);
+    EXPECT_EQ(pixel.a, 255);
+    UnloadImage(result);
+}
+
+TEST(DocumentSnapshotTest, LaterLayersAreOnTop) {
+    DocumentSnapshot snapshot(2, 2);
+    snapshot.addLayer(LayerSnapshot{makeSharedPixels(GenImageColor(2, 2, Color{255, 0, 0, 255}))});
+    snapshot.addLayer(LayerSnapshot{makeSharedPixels(GenImageColor(2, 2, Color{0, 0, 255, 255}))});
+
+    Image result = snapshot.composite();
+    Color pixel = GetImageColor(result, 0, 0);
+    EXPECT_EQ(pixel.r, 0);
+    EXPECT_EQ(pixel.b, 255);
+    UnloadImage(result);
+}
+
+TEST(DocumentSnapshotTest, TransparentBaseKeepsLayerAlpha) {
+    DocumentSnapshot snapshot(2, 2);
+    snapshot.addLayer(LayerSnapshot{makeSharedPixels(GenImageColor(2, 2, Color{0, 255, 0, 100}))});
+
+    Image result = snapshot.composite();
+    Color pixel = GetImageColor(result, 1, 1);
+    EXPECT_EQ(pixel.g, 255);
+    EXPECT_EQ(pixel.a, 100);
+    UnloadImage(result);
+}
+
+TEST(DocumentSnapshotTest, CompositeHonoursLayerFlips) {
+    Image layer = GenImageColor(2, 1, Color{0, 0, 0, 0});
+    ImageDrawPixel(&layer, 0, 0, Color{255, 0, 0, 255});
+
+    DocumentSnapshot snapshot(2, 1);
+    LayerSnapshot flipped{makeSharedPixels(layer)};
+    flipped.flippedHorizontal = true;
+    snapshot.addLayer(flipped);
+
+    Image result = snapshot.composite();
+    EXPECT_EQ(GetImageColor(result, 0, 0).a, 0);
+    EXPECT_EQ(GetImageColor(result, 1, 0).r, 255);
+    UnloadImage(result);
+}
+
+class BackgroundSaveTest : public ::testing::Test {
+protected:
+    std::unique_ptr<EventDispatcher> dispatcher_;
+    std::unique_ptr<Canvas> canvas_;
+    std::string savePath_ = "/tmp/test_background_save.png";
+    int savedEvents_ = 0;
+    bool lastSaveSucceeded_ = false;
+
+    void SetUp() override {
+        dispatcher_ = std::make_unique<EventDispatcher>();
+        dispatcher_->subscribe<ImageSavedEvent>([this](const ImageSavedEvent& event) {
+            savedEvents_++;
+            lastSaveSucceeded_ = event.success;
+        });
+
+        canvas_ = std::make_unique<Canvas>(Rectangle{0, 0, 200.0f, 150.0f}, dispatcher_.get(), nullptr, false);
+        canvas_->createBlankCanvas(200, 150, WHITE);
+        std::filesystem::remove(savePath_);
+    }
+
+    void paintLayer(int index, Color color) {
+        DrawingLayer* layer = canvas_->getLayer(index);
+        ASSERT_NE(layer, nullptr);
+        layer->texture->beginDrawing();
+        DrawRectangle(0, 0, 200, 150, color);
+        layer->texture->endDrawing();
+    }
+};
+
+TEST_F(BackgroundSaveTest, UnchangedLayersShareSnapshotPixels) {
+    canvas_->addNewDrawingLayer("Second");
+
+    DocumentSnapshot first = canvas_->captureSnapshot();
+    DocumentSnapshot second = canvas_->captureSnapshot();
+    ASSERT_EQ(first.getLayers().size(), 2u);
+    EXPECT_EQ(first.getBackground(), second.getBackground());
+    EXPECT_EQ(first.getLayers()[0].pixels, second.getLayers()[0].pixels);
+    EXPECT_EQ(first.getLayers()[1].pixels, second.getLayers()[1].pixels);
+
+    // Painting only copies the layer that changed
+    paintLayer(1, RED);
+    DocumentSnapshot third = canvas_->captureSnapshot();
+    EXPECT_NE(first.getLayers()[0].pixels, third.getLayers()[0].pixels);
+    EXPECT_EQ(first.getLayers()[1].pixels, third.getLayers()[1].pixels);
+
+    // The earlier snapshot still sees the old pixels
+    EXPECT_EQ(GetImageColor(*first.getLayers()[0].pixels, 10, 10).a, 0);
+    EXPECT_EQ(GetImageColor(*third.getLayers()[0].pixels, 10, 10).a, 255);
+}
+
+TEST_F(BackgroundSaveTest, SaveCompletesThroughEvent) {
+    ASSERT_TRUE(canvas_->saveImage(savePath_));
+    canvas_->waitForPendingSaves();
+
+    EXPECT_EQ(savedEvents_, 1);
+    EXPECT_TRUE(lastSaveSucceeded_);
+    EXPECT_TRUE(std::filesystem::exists(savePath_));
+    EXPECT_FALSE(canvas_->isSavingImage());
+}
+
+TEST_F(BackgroundSaveTest, DrawingDuringSaveDoesNotReachFile) {
+    ASSERT_TRUE(canvas_->saveImage(savePath_));
+    paintLayer(0, RED);
+    canvas_->waitForPendingSaves();
+    ASSERT_TRUE(lastSaveSucceeded_);
+
+    Image saved = LoadImage(savePath_.c_str());
+    ASSERT_NE(saved.data, nullptr);
+    Color pixel = GetImageColor(saved, 100, 75);
+    EXPECT_EQ(pixel.r, 255);
+    EXPECT_EQ(pixel.g, 255);
+    EXPECT_EQ(pixel.b, 255);
+    UnloadImage(saved);
+}
+
+TEST_F(BackgroundSaveTest, NothingVisibleReportsError) {
+    std::string error;
+    dispatcher_->subscribe<ErrorEvent>([&](const ErrorEvent& event) { error = event.message; });
+
+    canvas_->setBackgroundVisible(false);
+    canvas_->setLayerVisible(0, false);
+    EXPECT_FALSE(canvas_->saveImage(savePath_));
+    EXPECT_FALSE(error.empty());
+}
+
+// Once layers are cached, queuing a save only reads back what changed
+TEST_F(BackgroundSaveTest, SaveSubmitPerformance) {
+    const int NUM_LAYERS = 20;
+    canvas_ = std::make_unique<Canvas>(Rectangle{0, 0, 1024.0f, 1024.0f}, dispatcher_.get(), nullptr, false);
+    canvas_->createBlankCanvas(1024, 1024, WHITE);
+    for (int i = 1; i < NUM_LAYERS; ++i)
+        canvas_->addNewDrawingLayer();
+
+    ASSERT_TRUE(canvas_->saveImage(savePath_));
+    canvas_->waitForPendingSaves();
+
+    DrawingLayer* layer = canvas_->getLayer(0);
+    layer->texture->beginDrawing();
+    DrawCircle(512, 512, 100, BLUE);
+    layer->texture->endDrawing();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(canvas_->saveImage(savePath_));
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+    canvas_->waitForPendingSaves();
+    EXPECT_TRUE(lastSaveSucceeded_);
+    EXPECT_LT(duration.count(), 100);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,282 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <Utils/BatchProcessor.hpp>
+#include <Utils/Filters.hpp>
+#include <Utils/QoiCodec.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class BatchProcessorTest : public ::testing::Test {
+protected:
+    std::string inputDir_ = "/tmp/test_batch_inputs";
+    std::string outputDir_ = "/tmp/test_batch_outputs";
+
+    void SetUp() override {
+        std::filesystem::create_directories(inputDir_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(inputDir_);
+        std::filesystem::remove_all(outputDir_);
+    }
+
+    static BatchScript parseOrFail(const std::string& text) {
+        std::string error;
+        auto script = BatchScript::parse(text, &error);
+        EXPECT_TRUE(script.has_value()) << error;
+        return script ? *script : BatchScript{};
+    }
+
+    static const unsigned char* pixel(const Image& image, int x, int y) {
+        return static_cast<const unsigned char*>(image.data) + (static_cast<size_t>(y) * image.width + x) * 4;
+    }
+
+    std::string writeInput(const std::string& name, Color color, int width = 64, int height = 48) {
+        Image image = GenImageColor(width, height, color);
+        const std::string path = inputDir_ + "/" + name;
+        EXPECT_TRUE(QoiCodec::write(image, path));
+        UnloadImage(image);
+        return path;
+    }
+};
+
+TEST_F(BatchProcessorTest, ParsesEveryOperation) {
+    BatchScript script = parseOrFail(
+        "# thumbnails\n"
+        "resize 50%\n"
+        "resize 320\n"
+        "resize 320 200\n"
+        "flip horizontal\n"
+        "blur 1.5   # soften\n"
+        "levels 10 240 1.2 5 250\n"
+        "flatten 255 0 0\n"
+        "export qoi\n");
+
+    const auto& ops = script.getOperations();
+    ASSERT_EQ(ops.size(), 7u);
+    EXPECT_FLOAT_EQ(ops[0].percent, 50.0f);
+    EXPECT_EQ(ops[1].width, 320);
+    EXPECT_EQ(ops[1].height, 0);
+    EXPECT_EQ(ops[2].height, 200);
+    EXPECT_TRUE(ops[3].horizontal);
+    EXPECT_FLOAT_EQ(ops[4].radius, 1.5f);
+    EXPECT_FLOAT_EQ(ops[5].outWhite, 250.0f);
+    EXPECT_EQ(ops[6].background.r, 255);
+    EXPECT_EQ(ops[6].background.g, 0);
+    EXPECT_EQ(script.getExtension(), ".qoi");
+}
+
+TEST_F(BatchProcessorTest, ExportOptionsAreParsed) {
+    BatchScript png = parseOrFail("export png level 1\n");
+    EXPECT_EQ(png.getExportOptions().pngCompressionLevel, 1);
+
+    BatchScript raw = parseOrFail("export ert norle\n");
+    EXPECT_EQ(raw.getExtension(), ".ert");
+    EXPECT_FALSE(raw.getExportOptions().rawTileRle);
+
+    EXPECT_EQ(BatchScript().getExtension(), ".png");
+}
+
+TEST_F(BatchProcessorTest, RejectsInvalidScripts) {
+    const std::vector<std::string> invalid = {
+        "sharpen 2\n",
+        "resize\n",
+        "resize -5 10\n",
+        "resize 320 tall\n",
+        "resize 320x200\n",
+        "resize 320 200px\n",
+        "resize 5x0%\n",
+        "flip diagonal\n",
+        "blur soft\n",
+        "levels 200 100 1\n",
+        "flatten 10 20\n",
+        "export gif\n",
+        "export png level 12\n",
+        "blur 2 3\n"
+    };
+    for (const auto& text : invalid) {
+        std::string error;
+        EXPECT_FALSE(BatchScript::parse(text, &error).has_value()) << text;
+        EXPECT_NE(error.find("line 1"), std::string::npos) << text;
+    }
+
+    std::string error;
+    EXPECT_FALSE(BatchScript::parse("flip vertical\n\nbogus\n", &error).has_value());
+    EXPECT_NE(error.find("line 3"), std::string::npos);
+}
+
+TEST_F(BatchProcessorTest, AppliesFlipLevelsAndFlatten) {
+    Image image = GenImageColor(4, 2, Color{0, 0, 0, 0});
+    auto* pixels = static_cast<unsigned char*>(image.data);
+    pixels[0] = 100; pixels[1] = 100; pixels[2] = 100; pixels[3] = 255;
+
+    parseOrFail("flip horizontal\n").apply(image);
+    EXPECT_EQ(pixel(image, 3, 0)[0], 100);
+    EXPECT_EQ(pixel(image, 0, 0)[3], 0);
+
+    // Inverting output levels maps 100 to 155
+    parseOrFail("levels 0 255 1 255 0\n").apply(image);
+    EXPECT_EQ(pixel(image, 3, 0)[0], 155);
+
+    parseOrFail("flatten 0 0 255\n").apply(image);
+    EXPECT_EQ(pixel(image, 3, 0)[0], 155);
+    EXPECT_EQ(pixel(image, 0, 0)[2], 255);
+    EXPECT_EQ(pixel(image, 0, 0)[3], 255);
+    UnloadImage(image);
+}
+
+TEST_F(BatchProcessorTest, ResizeKeepsAspectRatio) {
+    Image image = GenImageColor(200, 100, RED);
+    parseOrFail("resize 50%\n").apply(image);
+    EXPECT_EQ(image.width, 100);
+    EXPECT_EQ(image.height, 50);
+
+    parseOrFail("resize 40\n").apply(image);
+    EXPECT_EQ(image.width, 40);
+    EXPECT_EQ(image.height, 20);
+    UnloadImage(image);
+}
+
+TEST_F(BatchProcessorTest, BlurSpreadsEdgesAndKeepsFlatAreas) {
+    Image image = GenImageColor(64, 64, Color{40, 80, 120, 255});
+    parseOrFail("blur 3\n").apply(image);
+    EXPECT_EQ(pixel(image, 0, 0)[0], 40);
+    EXPECT_EQ(pixel(image, 32, 32)[2], 120);
+
+    // A hard edge becomes a ramp
+    auto* pixels = static_cast<unsigned char*>(image.data);
+    for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x)
+            pixels[(y * 64 + x) * 4] = x < 32 ? 0 : 255;
+    parseOrFail("blur 3\n").apply(image);
+    EXPECT_GT(pixel(image, 31, 10)[0], 0);
+    EXPECT_LT(pixel(image, 32, 10)[0], 255);
+    EXPECT_LT(pixel(image, 28, 10)[0], pixel(image, 35, 10)[0]);
+    UnloadImage(image);
+}
+
+TEST_F(BatchProcessorTest, BlurAndLevelsMatchTheEditorFilters) {
+    Image batch = GenImageColor(48, 40, Color{0, 0, 0, 0});
+    auto* pixels = static_cast<unsigned char*>(batch.data);
+    for (int i = 0; i < 48 * 40 * 4; ++i)
+        pixels[i] = static_cast<unsigned char>((i * 37) ^ (i >> 5));
+    Image editor = ImageCopy(batch);
+
+    parseOrFail("blur 2.5\nlevels 10 240 1.3 5 250\n").apply(batch);
+    const Rectangle whole = {0, 0, 48, 40};
+    Filters::run(Filters::gaussianBlur(2.5f), editor, whole, 2.5f);
+    Filters::run(Filters::levels(10, 240, 1.3f, 5, 250), editor, whole, 1.3f);
+    EXPECT_EQ(std::memcmp(batch.data, editor.data, 48 * 40 * 4), 0);
+    UnloadImage(batch);
+    UnloadImage(editor);
+}
+
+TEST_F(BatchProcessorTest, RunsEveryInputAndWritesTimings) {
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 6; ++i)
+        inputs.push_back(writeInput("image" + std::to_string(i) + ".qoi", Color{static_cast<unsigned char>(i * 40), 10, 20, 255}));
+    inputs.push_back(inputDir_ + "/missing.qoi");
+
+    BatchRunner runner(parseOrFail("resize 50%\nflip vertical\nexport qoi\n"), outputDir_, 3);
+    BatchSummary summary = runner.run(inputs);
+
+    ASSERT_EQ(summary.files.size(), inputs.size());
+    EXPECT_EQ(summary.succeeded, 6u);
+    EXPECT_EQ(summary.failed, 1u);
+    EXPECT_EQ(summary.workers, 3u);
+    EXPECT_FALSE(summary.files.back().success);
+
+    for (int i = 0; i < 6; ++i) {
+        const auto& result = summary.files[i];
+        EXPECT_TRUE(result.success) << result.error;
+        EXPECT_EQ(result.outputPath, outputDir_ + "/image" + std::to_string(i) + ".qoi");
+
+        Image output = QoiCodec::read(result.outputPath);
+        ASSERT_NE(output.data, nullptr);
+        EXPECT_EQ(output.width, 32);
+        EXPECT_EQ(output.height, 24);
+        EXPECT_EQ(pixel(output, 5, 5)[0], i * 40);
+        UnloadImage(output);
+    }
+
+    const std::string csvPath = outputDir_ + "/summary.csv";
+    ASSERT_TRUE(summary.writeCsv(csvPath));
+    std::ifstream csv(csvPath);
+    std::string line;
+    int lines = 0;
+    while (std::getline(csv, line))
+        lines++;
+    EXPECT_EQ(lines, 1 + static_cast<int>(inputs.size()));
+}
+
+TEST_F(BatchProcessorTest, InputsSharingAStemGetDistinctOutputs) {
+    std::filesystem::create_directories(inputDir_ + "/a");
+    std::filesystem::create_directories(inputDir_ + "/b");
+    const std::vector<std::string> inputs = {writeInput("a/x.qoi", RED), writeInput("b/x.qoi", BLUE),
+                                             writeInput("x-2.qoi", GREEN), writeInput("y.qoi", WHITE)};
+
+    BatchRunner runner(parseOrFail("export qoi\n"), outputDir_, 2);
+    const std::vector<std::string> outputs = runner.outputPaths(inputs);
+    ASSERT_EQ(outputs.size(), 4u);
+    EXPECT_EQ(outputs[0], outputDir_ + "/x.qoi");
+    EXPECT_EQ(outputs[1], outputDir_ + "/x-2.qoi");
+    EXPECT_EQ(outputs[2], outputDir_ + "/x-2-2.qoi");
+    EXPECT_EQ(outputs[3], outputDir_ + "/y.qoi");
+
+    BatchSummary summary = runner.run(inputs);
+    EXPECT_EQ(summary.succeeded, 4u);
+    Image first = QoiCodec::read(outputDir_ + "/x.qoi");
+    Image second = QoiCodec::read(outputDir_ + "/x-2.qoi");
+    ASSERT_NE(first.data, nullptr);
+    ASSERT_NE(second.data, nullptr);
+    const Color red = RED, blue = BLUE;
+    EXPECT_EQ(pixel(first, 0, 0)[0], red.r);
+    EXPECT_EQ(pixel(second, 0, 0)[2], blue.b);
+    UnloadImage(first);
+    UnloadImage(second);
+}
+
+TEST_F(BatchProcessorTest, CsvQuotesPaths) {
+    BatchSummary summary;
+    BatchFileResult result;
+    result.inputPath = "in/say \"cheese\", please.png";
+    result.outputPath = "out/plain.png";
+    result.error = "cannot write \"out\"";
+    summary.files.push_back(result);
+
+    std::filesystem::create_directories(outputDir_);
+    const std::string csvPath = outputDir_ + "/summary.csv";
+    ASSERT_TRUE(summary.writeCsv(csvPath));
+    std::ifstream csv(csvPath);
+    std::string header, line;
+    std::getline(csv, header);
+    std::getline(csv, line);
+    EXPECT_EQ(line, "\"in/say \"\"cheese\"\", please.png\",\"out/plain.png\",failed,0.000,0.000,0.000,\"cannot write \"\"out\"\"\"");
+}
+
+TEST_F(BatchProcessorTest, CommandReportsUsageErrors) {
+    EXPECT_EQ(runBatchCommand({"--batch"}), 2);
+    EXPECT_EQ(runBatchCommand({"--batch", "--script"}), 2);
+    EXPECT_EQ(runBatchCommand({"--batch", "--script", "/tmp/none.txt", "--output", outputDir_}), 2);
+}
+
+TEST_F(BatchProcessorTest, CommandReadsInputList) {
+    const std::string scriptPath = inputDir_ + "/ops.txt";
+    std::ofstream(scriptPath) << "flip vertical\nexport qoi\n";
+    const std::string listPath = inputDir_ + "/inputs.txt";
+    std::ofstream(listPath) << writeInput("a.qoi", RED) << "\n# skipped\n" << writeInput("b.qoi", BLUE) << "\n";
+
+    EXPECT_EQ(runBatchCommand({"--batch", "--script", scriptPath, "--output", outputDir_,
+                               "--jobs", "2", "--inputs", listPath}), 0);
+    EXPECT_TRUE(std::filesystem::exists(outputDir_ + "/a.qoi"));
+    EXPECT_TRUE(std::filesystem::exists(outputDir_ + "/b.qoi"));
+    EXPECT_TRUE(std::filesystem::exists(outputDir_ + "/batch_summary.csv"));
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <Utils/ColorSpace.hpp>
+#include <Utils/Filters.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class ColorSpaceTest : public ImageTest {
+protected:
+    static Color at(const Image& image, int x, int y) { return static_cast<const Color*>(image.data)[y * image.width + x]; }
+
+    // Every RGB byte combination in steps of 15, plus the greys between
+    static std::vector<uint8_t> sweep() {
+        std::vector<uint8_t> pixels;
+        for (int r = 0; r < 256; r += 15)
+            for (int g = 0; g < 256; g += 15)
+                for (int b = 0; b < 256; b += 15)
+                    pixels.insert(pixels.end(), {static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b), 77});
+        for (int v = 0; v < 256; ++v)
+            pixels.insert(pixels.end(), {static_cast<uint8_t>(v), static_cast<uint8_t>(v), static_cast<uint8_t>(v), 77});
+        return pixels;
+    }
+};
+
+TEST_F(ColorSpaceTest, KnownValues) {
+    const ColorSpace::Hsv red = ColorSpace::toHsv(Color{255, 0, 0, 255});
+    EXPECT_NEAR(red.h, 0.0f, 1e-4f);
+    EXPECT_NEAR(red.s, 1.0f, 1e-6f);
+    EXPECT_NEAR(red.v, 1.0f, 1e-6f);
+
+    const ColorSpace::Hsl teal = ColorSpace::toHsl(Color{0, 128, 128, 255});
+    EXPECT_NEAR(teal.h, 180.0f, 1e-3f);
+    EXPECT_NEAR(teal.s, 1.0f, 1e-6f);
+    EXPECT_NEAR(teal.l, 128.0f / 510.0f, 1e-6f);
+
+    const ColorSpace::Lab white = ColorSpace::toLab(Color{255, 255, 255, 255});
+    EXPECT_NEAR(white.l, 100.0f, 0.01f);
+    EXPECT_NEAR(white.a, 0.0f, 0.01f);
+    EXPECT_NEAR(white.b, 0.0f, 0.01f);
+
+    const ColorSpace::Lab redLab = ColorSpace::toLab(Color{255, 0, 0, 255});
+    EXPECT_NEAR(redLab.l, 53.24f, 0.05f);
+    EXPECT_NEAR(redLab.a, 80.09f, 0.05f);
+    EXPECT_NEAR(redLab.b, 67.20f, 0.05f);
+
+    // Greys have no hue or saturation to speak of
+    const ColorSpace::Hsv grey = ColorSpace::toHsv(Color{90, 90, 90, 255});
+    EXPECT_EQ(grey.h, 0.0f);
+    EXPECT_EQ(grey.s, 0.0f);
+
+    EXPECT_EQ(ColorSpace::fromHsv(ColorSpace::Hsv{120.0f, 1.0f, 1.0f}, 9).g, 255);
+    EXPECT_EQ(ColorSpace::fromHsv(ColorSpace::Hsv{120.0f, 1.0f, 1.0f}, 9).a, 9);
+    EXPECT_EQ(ColorSpace::fromHsl(ColorSpace::Hsl{240.0f, 1.0f, 0.5f}).b, 255);
+    EXPECT_EQ(ColorSpace::fromHsl(ColorSpace::Hsl{240.0f, 1.0f, 0.5f}).r, 0);
+}
+
+TEST_F(ColorSpaceTest, SrgbTables) {
+    EXPECT_EQ(ColorSpace::toLinear(0), 0.0f);
+    EXPECT_EQ(ColorSpace::toLinear(255), 1.0f);
+    EXPECT_NEAR(ColorSpace::toLinear(128), 0.2158605f, 1e-6f);
+    for (int v = 0; v < 256; ++v)
+        ASSERT_EQ(ColorSpace::fromLinear(ColorSpace::toLinear(static_cast<uint8_t>(v))), v) << v;
+    EXPECT_EQ(ColorSpace::fromLinear(-1.0f), 0);
+    EXPECT_EQ(ColorSpace::fromLinear(2.0f), 255);
+}
+
+TEST_F(ColorSpaceTest, BytesSurviveRoundTrips) {
+    const std::vector<uint8_t> pixels = sweep();
+    const size_t count = pixels.size() / 4;
+    std::vector<float> x(count), y(count), z(count);
+    std::vector<uint8_t> back(pixels.size(), 0);
+
+    ColorSpace::rgbToHsv(pixels.data(), count, x.data(), y.data(), z.data());
+    ColorSpace::hsvToRgb(x.data(), y.data(), z.data(), count, back.data());
+    for (size_t i = 0; i < count; ++i)
+        for (int ch = 0; ch < 3; ++ch)
+            ASSERT_EQ(back[i * 4 + ch], pixels[i * 4 + ch]) << "HSV " << i;
+    EXPECT_EQ(back[3], 0);   // Alpha is neither read nor written
+
+    ColorSpace::rgbToHsl(pixels.data(), count, x.data(), y.data(), z.data());
+    ColorSpace::hslToRgb(x.data(), y.data(), z.data(), count, back.data());
+    for (size_t i = 0; i < count; ++i)
+        for (int ch = 0; ch < 3; ++ch)
+            ASSERT_EQ(back[i * 4 + ch], pixels[i * 4 + ch]) << "HSL " << i;
+
+    // Lab goes through linear light and cube roots; a step either way is allowed
+    ColorSpace::rgbToLab(pixels.data(), count, x.data(), y.data(), z.data());
+    ColorSpace::labToRgb(x.data(), y.data(), z.data(), count, back.data());
+    for (size_t i = 0; i < count; ++i)
+        for (int ch = 0; ch < 3; ++ch)
+            ASSERT_LE(std::abs(back[i * 4 + ch] - pixels[i * 4 + ch]), 1) << "Lab " << i;
+}
+
+TEST_F(ColorSpaceTest, BatchMatchesSingleColours) {
+    // Odd counts leave a tail after the vector lanes
+    const std::vector<uint8_t> pixels = sweep();
+    for (size_t count : {1u, 3u, 7u, 13u, 4913u}) {
+        std::vector<float> h(count), s(count), v(count), l(count), a(count), b(count), hl(count), sl(count), ll(count);
+        ColorSpace::rgbToHsv(pixels.data(), count, h.data(), s.data(), v.data());
+        ColorSpace::rgbToHsl(pixels.data(), count, hl.data(), sl.data(), ll.data());
+        ColorSpace::rgbToLab(pixels.data(), count, l.data(), a.data(), b.data());
+        for (size_t i = 0; i < count; ++i) {
+            const Color color = {pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2], 255};
+            const ColorSpace::Hsv hsv = ColorSpace::toHsv(color);
+            ASSERT_NEAR(h[i], hsv.h, 1e-3f) << i;
+            ASSERT_NEAR(s[i], hsv.s, 1e-5f) << i;
+            ASSERT_NEAR(v[i], hsv.v, 1e-6f) << i;
+            const ColorSpace::Hsl hsl = ColorSpace::toHsl(color);
+            ASSERT_NEAR(hl[i], hsl.h, 1e-3f) << i;
+            ASSERT_NEAR(sl[i], hsl.s, 1e-5f) << i;
+            ASSERT_NEAR(ll[i], hsl.l, 1e-6f) << i;
+            const ColorSpace::Lab lab = ColorSpace::toLab(color);
+            ASSERT_NEAR(l[i], lab.l, 1e-3f) << i;
+            ASSERT_NEAR(a[i], lab.a, 1e-3f) << i;
+            ASSERT_NEAR(b[i], lab.b, 1e-3f) << i;
+        }
+    }
+}
+
+TEST_F(ColorSpaceTest, AdjustHsl) {
+    // No shift leaves every byte alone
+    Image& image = noise(37, 23, 1);
+    Image& original = noise(37, 23, 1);
+    ColorSpace::adjustHsl(image, ColorSpace::HslShift{}, Rectangle{0, 0, 37, 23});
+    EXPECT_EQ(std::memcmp(image.data, original.data, 37 * 23 * 4), 0);
+
+    Image& red = make(9, 9, Color{255, 0, 0, 40});
+    ColorSpace::adjustHsl(red, ColorSpace::HslShift{120.0f, 0.0f, 0.0f}, Rectangle{0, 0, 9, 9});
+    EXPECT_EQ(at(red, 4, 4).r, 0);
+    EXPECT_EQ(at(red, 4, 4).g, 255);
+    EXPECT_EQ(at(red, 4, 4).b, 0);
+    EXPECT_EQ(at(red, 4, 4).a, 40);
+
+    ColorSpace::adjustHsl(red, ColorSpace::HslShift{0.0f, -1.0f, 0.0f}, Rectangle{0, 0, 9, 9});
+    EXPECT_EQ(at(red, 0, 0).r, at(red, 0, 0).g);
+    EXPECT_EQ(at(red, 0, 0).g, at(red, 0, 0).b);
+
+    ColorSpace::adjustHsl(red, ColorSpace::HslShift{0.0f, 0.0f, 1.0f}, Rectangle{0, 0, 9, 9});
+    EXPECT_EQ(at(red, 8, 8).r, 255);
+    EXPECT_EQ(at(red, 8, 8).b, 255);
+    ColorSpace::adjustHsl(red, ColorSpace::HslShift{0.0f, 0.0f, -1.0f}, Rectangle{0, 0, 9, 9});
+    EXPECT_EQ(at(red, 8, 8).g, 0);
+    EXPECT_EQ(at(red, 8, 8).a, 40);
+
+    // Only the region moves, including when it starts and ends mid-row
+    Image& blue = make(37, 23, Color{0, 0, 200, 255});
+    ColorSpace::adjustHsl(blue, ColorSpace::HslShift{-120.0f, 0.0f, 0.0f}, Rectangle{3.5f, 2, 29, 18});
+    for (int y = 0; y < 23; ++y) {
+        for (int x = 0; x < 37; ++x) {
+            const bool inside = x >= 3 && x < 33 && y >= 2 && y < 20;
+            ASSERT_EQ(at(blue, x, y).g, inside ? 200 : 0) << x << "," << y;
+            ASSERT_EQ(at(blue, x, y).b, inside ? 0 : 200) << x << "," << y;
+        }
+    }
+}
+
+TEST_F(ColorSpaceTest, HueSaturationFilter) {
+    LayerFilter filter = Filters::hueSaturation();
+    ASSERT_TRUE(filter.isValid());
+    ASSERT_EQ(filter.settings.size(), 2u);
+    EXPECT_EQ(filter.reach(filter.amount), 0);
+
+    Image& image = make(8, 8, Color{255, 0, 0, 255});
+    Filters::run(filter, image, Rectangle{0, 0, 8, 8}, 240.0f);
+    EXPECT_EQ(at(image, 0, 0).b, 255);
+    EXPECT_EQ(at(image, 0, 0).r, 0);
+
+    filter.settings[0].value = -100.0f;   // Saturation, in percent
+    Filters::run(filter, image, Rectangle{0, 0, 8, 8}, 0.0f);
+    EXPECT_EQ(at(image, 7, 7).r, at(image, 7, 7).b);
+}
+
+TEST_F(ColorSpaceTest, LargeLayer) {
+    constexpr int SIZE = 4096;
+    const ColorSpace::HslShift shift{35.0f, 0.2f, -0.1f};
+    Image& image = noise(SIZE, SIZE, 2);
+    const Image& source = copy(image);
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    ColorSpace::adjustHsl(image, shift, Rectangle{0, 0, SIZE, SIZE});
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "hue/saturation over " << SIZE << "x" << SIZE << ": " << ms << " ms ("
+              << SIZE * static_cast<double>(SIZE) / ms / 1000.0 << " MP/s)" << std::endl;
+
+    // A lone pixel only ever takes the scalar tail, so samples from the vector lanes can be checked against it
+    Image& single = make(1, 1, BLANK);
+    for (int i = 0; i < SIZE * SIZE; i += 997) {
+        const int x = i % SIZE, y = i / SIZE;
+        static_cast<Color*>(single.data)[0] = at(source, x, y);
+        ColorSpace::adjustHsl(single, shift, Rectangle{0, 0, 1, 1});
+        const Color expected = at(single, 0, 0), actual = at(image, x, y);
+        ASSERT_LE(std::abs(actual.r - expected.r), 1) << x << "," << y;
+        ASSERT_LE(std::abs(actual.g - expected.g), 1) << x << "," << y;
+        ASSERT_LE(std::abs(actual.b - expected.b), 1) << x << "," << y;
+        ASSERT_EQ(actual.a, expected.a) << x << "," << y;
+    }
+}
+
+} // namespace EpiGimp
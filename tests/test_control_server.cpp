@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <Utils/ControlServer.hpp>
+#include <Utils/Json.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+TEST(JsonTest, ParsesAndDumpsRoundTrip) {
+    const std::string text = R"({"id":7,"method":"load","params":{"path":"a \"b\".png","layers":[1,2.5,true,null]}})";
+    std::string error;
+    auto value = JsonValue::parse(text, &error);
+    ASSERT_TRUE(value.has_value()) << error;
+    EXPECT_EQ((*value)["id"].asInt(), 7);
+    EXPECT_EQ((*value)["params"]["path"].asString(), "a \"b\".png");
+    EXPECT_DOUBLE_EQ((*value)["params"]["layers"][1].asNumber(), 2.5);
+    EXPECT_TRUE((*value)["params"]["layers"][3].isNull());
+    EXPECT_TRUE((*value)["missing"]["deeper"].isNull());
+
+    auto again = JsonValue::parse(value->dump());
+    ASSERT_TRUE(again.has_value());
+    EXPECT_EQ(*again, *value);
+}
+
+TEST(JsonTest, HandlesEscapes) {
+    auto value = JsonValue::parse(R"(["line\nbreak", "é😀", "tab\t"])");
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ((*value)[0].asString(), "line\nbreak");
+    EXPECT_EQ((*value)[1].asString(), "\xC3\xA9\xF0\x9F\x98\x80");
+    EXPECT_EQ(value->dump().find('\n'), std::string::npos);
+}
+
+TEST(JsonTest, RejectsMalformedInput) {
+    for (const char* text : {"", "{", "[1,]", "{\"a\" 1}", "tru", "\"open", "1 2", "{1:2}", "nan"}) {
+        std::string error;
+        EXPECT_FALSE(JsonValue::parse(text, &error).has_value()) << text;
+        EXPECT_FALSE(error.empty()) << text;
+    }
+    EXPECT_FALSE(JsonValue::parse(std::string(200, '[') + std::string(200, ']')).has_value());
+}
+
+class ControlServerTest : public ::testing::Test {
+protected:
+    std::string socketPath_ = "/tmp/test_epigimp_control.sock";
+    std::unique_ptr<ControlServer> server_;
+    std::thread frameLoop_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> counter_{0};
+
+    void SetUp() override {
+        server_ = std::make_unique<ControlServer>(socketPath_);
+        server_->registerMethod("echo", [](const JsonValue& params) { return params; });
+        server_->registerMethod("increment", [this](const JsonValue& params) {
+            counter_ += params["by"].asInt(1);
+            return JsonValue(counter_.load());
+        });
+        server_->registerMethod("fail", [](const JsonValue&) -> JsonValue {
+            throw ControlError(RpcError::INVALID_PARAMS, "bad things");
+        });
+        ASSERT_TRUE(server_->start());
+
+        // Stand-in for Application::update()
+        running_ = true;
+        frameLoop_ = std::thread([this]() {
+            while (running_) {
+                server_->processPending();
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+
+    void TearDown() override {
+        running_ = false;
+        if (frameLoop_.joinable())
+            frameLoop_.join();
+        server_.reset();
+    }
+};
+
+TEST_F(ControlServerTest, CallsReturnResults) {
+    ControlClient client;
+    ASSERT_TRUE(client.connect(socketPath_));
+
+    JsonValue params = JsonValue::object();
+    params.set("path", "/tmp/x.png").set("size", 3);
+    EXPECT_EQ(client.call("echo", params), params);
+    EXPECT_EQ(client.call("increment", JsonValue::object().set("by", 5)).asInt(), 5);
+    EXPECT_EQ(client.call("increment").asInt(), 6);
+}
+
+TEST_F(ControlServerTest, ErrorsUseJsonRpcCodes) {
+    ControlClient client;
+    ASSERT_TRUE(client.connect(socketPath_));
+
+    try {
+        client.call("nope");
+        FAIL() << "unknown method accepted";
+    } catch (const ControlError& e) {
+        EXPECT_EQ(e.getCode(), RpcError::METHOD_NOT_FOUND);
+    }
+
+    try {
+        client.call("fail");
+        FAIL() << "handler error swallowed";
+    } catch (const ControlError& e) {
+        EXPECT_EQ(e.getCode(), RpcError::INVALID_PARAMS);
+        EXPECT_STREQ(e.what(), "bad things");
+    }
+
+    // The connection survives errors
+    EXPECT_EQ(client.call("increment").asInt(), 1);
+}
+
+TEST_F(ControlServerTest, MalformedMessagesGetParseErrors) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath_.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+    // Garbage, a notification (no reply) and a request without a method, in one write
+    const std::string batch = "{oops\n{\"jsonrpc\":\"2.0\",\"method\":\"increment\"}\n{\"jsonrpc\":\"2.0\",\"id\":4}\n";
+    ASSERT_EQ(::write(fd, batch.data(), batch.size()), static_cast<ssize_t>(batch.size()));
+
+    std::string received;
+    char buffer[1024];
+    while (std::count(received.begin(), received.end(), '\n') < 2) {
+        const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        ASSERT_GT(n, 0);
+        received.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+
+    const size_t newline = received.find('\n');
+    auto first = JsonValue::parse(received.substr(0, newline));
+    auto second = JsonValue::parse(received.substr(newline + 1, received.find('\n', newline + 1) - newline - 1));
+    ASSERT_TRUE(first && second);
+    EXPECT_EQ((*first)["error"]["code"].asInt(), RpcError::PARSE_ERROR);
+    EXPECT_EQ((*second)["error"]["code"].asInt(), RpcError::INVALID_REQUEST);
+    EXPECT_EQ((*second)["id"].asInt(), 4);
+    EXPECT_EQ(counter_.load(), 1);
+}
+
+TEST_F(ControlServerTest, PipelinedResponsesKeepOrder) {
+    ControlClient client;
+    ASSERT_TRUE(client.connect(socketPath_));
+
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 200; ++i)
+        ids.push_back(client.send("increment"));
+    for (int i = 0; i < 200; ++i) {
+        JsonValue response = client.receive();
+        EXPECT_EQ(response["id"].asNumber(), static_cast<double>(ids[i]));
+        EXPECT_EQ(response["result"].asInt(), i + 1);
+    }
+}
+
+TEST_F(ControlServerTest, ClientThatStopsReadingDoesNotStallFrames) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath_.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+    // Echoes far larger than the socket buffers, and nobody reading them
+    constexpr int REQUESTS = 16;
+    const std::string request = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"echo\",\"params\":{\"pad\":\"" +
+                                std::string(128 * 1024, 'x') + "\"}}\n";
+    std::thread writer([&]() {
+        for (int i = 0; i < REQUESTS; ++i)
+            if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()))
+                return;
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    while (server_->getProcessedCount() < REQUESTS &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(3))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(server_->getProcessedCount(), static_cast<uint64_t>(REQUESTS));
+
+    // Other clients are still served meanwhile
+    ControlClient client;
+    ASSERT_TRUE(client.connect(socketPath_));
+    EXPECT_EQ(client.call("increment").asInt(), 1);
+
+    ::shutdown(fd, SHUT_RDWR);
+    writer.join();
+    ::close(fd);
+}
+
+TEST_F(ControlServerTest, ServesSeveralClients) {
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 4; ++c) {
+        clients.emplace_back([this]() {
+            ControlClient client;
+            ASSERT_TRUE(client.connect(socketPath_));
+            for (int i = 0; i < 50; ++i)
+                client.call("increment");
+        });
+    }
+    for (auto& thread : clients)
+        thread.join();
+    EXPECT_EQ(counter_.load(), 200);
+}
+
+TEST_F(ControlServerTest, RefusesSecondServerOnSameSocket) {
+    ControlServer second(socketPath_);
+    EXPECT_FALSE(second.start());
+
+    // The first server is still reachable
+    ControlClient client;
+    ASSERT_TRUE(client.connect(socketPath_));
+    EXPECT_EQ(client.call("increment").asInt(), 1);
+}
+
+TEST_F(ControlServerTest, RemoteCommandLine) {
+    EXPECT_EQ(runRemoteCommand({"--remote", socketPath_, "increment", "{\"by\":2}"}), 0);
+    EXPECT_EQ(runRemoteCommand({"--remote", socketPath_, "increment", "{}", "--repeat", "100"}), 0);
+    EXPECT_EQ(counter_.load(), 102);
+
+    EXPECT_EQ(runRemoteCommand({"--remote", socketPath_, "fail"}), 1);
+    EXPECT_EQ(runRemoteCommand({"--remote", socketPath_, "echo", "not json"}), 2);
+    EXPECT_EQ(runRemoteCommand({"--remote", "/tmp/no_such_epigimp.sock", "echo"}), 1);
+}
+
+// A warm instance should turn requests around far faster than a process start
+TEST_F(ControlServerTest, PipelinedThroughput) {
+    ControlClient client;
+    ASSERT_TRUE(client.connect(socketPath_));
+
+    const int requests = 20000;
+    const int depth = 256;
+    JsonValue params = JsonValue::object().set("path", "/tmp/image.png");
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int sent = 0;
+    int received = 0;
+    while (received < requests) {
+        while (sent < requests && sent - received < depth) {
+            client.send("echo", params);
+            sent++;
+        }
+        ASSERT_FALSE(client.receive().has("error"));
+        received++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << requests << " pipelined requests in " << elapsed * 1000.0 << " ms ("
+              << static_cast<int>(requests / elapsed) << " requests/s)" << std::endl;
+    EXPECT_GT(requests / elapsed, 5000.0);
+}
+
+} // namespace EpiGimp
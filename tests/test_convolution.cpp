@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <Utils/Convolution.hpp>
+#include <Commands/FilterCommand.hpp>
+#include <UI/Canvas.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class ConvolutionTest : public ImageTest {
+protected:
+    static Color at(const Image& image, int x, int y) {
+        return static_cast<const Color*>(image.data)[y * image.width + x];
+    }
+
+    // Straightforward float convolution with clamped edges, colour channels only
+    static float reference(const Image& image, const Convolution::Kernel& kernel, int x, int y, int channel) {
+        const int radius = kernel.size / 2;
+        float sum = kernel.bias;
+        for (int j = 0; j < kernel.size; ++j) {
+            for (int i = 0; i < kernel.size; ++i) {
+                const int sx = std::clamp(x + i - radius, 0, image.width - 1);
+                const int sy = std::clamp(y + j - radius, 0, image.height - 1);
+                sum += kernel.weights[j * kernel.size + i] * static_cast<const uint8_t*>(image.data)[(sy * image.width + sx) * 4 + channel];
+            }
+        }
+        return std::clamp(sum, 0.0f, 255.0f);
+    }
+
+    void expectMatchesReference(const Image& source, const Convolution::Kernel& kernel, float tolerance) {
+        Image& result = copy(source);
+        Convolution::apply(result, kernel, Rectangle{0, 0, static_cast<float>(source.width), static_cast<float>(source.height)});
+        float worst = 0.0f;
+        for (int y = 0; y < source.height; ++y) {
+            for (int x = 0; x < source.width; ++x) {
+                const auto* pixel = static_cast<const uint8_t*>(result.data) + (y * source.width + x) * 4;
+                for (int ch = 0; ch < 3; ++ch)
+                    worst = std::max(worst, std::fabs(pixel[ch] - reference(source, kernel, x, y, ch)));
+                ASSERT_EQ(pixel[3], at(source, x, y).a);
+            }
+        }
+        EXPECT_LE(worst, tolerance);
+    }
+};
+
+TEST_F(ConvolutionTest, DetectsSeparableKernels) {
+    std::vector<float> column, row;
+    EXPECT_TRUE(Convolution::separate(Convolution::boxBlur(3), column, row));
+    EXPECT_EQ(column.size(), 7u);
+
+    // Sobel is a smoothing column times a difference row
+    const Convolution::Kernel sobel{3, {-1, 0, 1, -2, 0, 2, -1, 0, 1}, 0.0f};
+    ASSERT_TRUE(Convolution::separate(sobel, column, row));
+    for (int y = 0; y < 3; ++y)
+        for (int x = 0; x < 3; ++x)
+            EXPECT_NEAR(column[y] * row[x], sobel.weights[y * 3 + x], 1e-6f);
+
+    EXPECT_FALSE(Convolution::separate(Convolution::sharpen(1.0f), column, row));
+    EXPECT_FALSE(Convolution::separate(Convolution::emboss(1.0f), column, row));
+    EXPECT_FALSE(Convolution::separate(Convolution::edgeDetect(1.0f), column, row));
+}
+
+TEST_F(ConvolutionTest, IdentityAndFlatAreasAreExact) {
+    Image& source = noise(70, 45, 1);
+    Image& result = copy(source);
+    Convolution::apply(result, Convolution::identity(), Rectangle{0, 0, 70, 45});
+    EXPECT_EQ(std::memcmp(source.data, result.data, 70 * 45 * 4), 0);
+
+    // Weights summing to one leave a flat image alone, whatever the fixed-point rounding
+    for (const Convolution::Kernel& kernel : {Convolution::sharpen(2.5f), Convolution::boxBlur(7), Convolution::boxBlur(1)}) {
+        Image& flat = make(67, 67, Color{201, 37, 140, 255});
+        Convolution::apply(flat, kernel, Rectangle{0, 0, 67, 67});
+        for (int y = 0; y < 67; ++y)
+            for (int x = 0; x < 67; ++x)
+                ASSERT_EQ(at(flat, x, y).g, 37) << x << "," << y;
+    }
+}
+
+TEST_F(ConvolutionTest, MatchesFloatReference) {
+    // Sizes that split into several tiles with partial ones at the edges
+    Image& source = noise(150, 131, 2);
+    expectMatchesReference(source, Convolution::sharpen(1.0f), 1.0f);
+    expectMatchesReference(source, Convolution::emboss(2.0f), 1.0f);
+    expectMatchesReference(source, Convolution::edgeDetect(1.0f), 1.0f);
+    expectMatchesReference(source, Convolution::boxBlur(2), 1.0f);
+    expectMatchesReference(source, Convolution::boxBlur(7), 1.0f);
+
+    // A random non-separable 5x5 and a separable Sobel
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> weight(-0.3f, 0.3f);
+    Convolution::Kernel random{5, std::vector<float>(25), 20.0f};
+    for (float& w : random.weights)
+        w = weight(rng);
+    expectMatchesReference(source, random, 1.0f);
+    expectMatchesReference(source, Convolution::Kernel{3, {-1, 0, 1, -2, 0, 2, -1, 0, 1}, 128.0f}, 1.0f);
+}
+
+TEST_F(ConvolutionTest, RegionAndOrientation) {
+    Image& source = noise(100, 100, 3);
+    Image& result = copy(source);
+    Convolution::apply(result, Convolution::edgeDetect(1.0f), Rectangle{10, 20, 30, 40});
+    for (int y = 0; y < 100; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            if (x >= 10 && x < 40 && y >= 20 && y < 60)
+                continue;
+            ASSERT_EQ(at(result, x, y).r, at(source, x, y).r) << x << "," << y;
+        }
+    }
+    // Inside, pixels near the region edge still see their real neighbours
+    EXPECT_NEAR(at(result, 10, 20).r, reference(source, Convolution::edgeDetect(1.0f), 10, 20, 0), 1.0f);
+
+    // A bottom-up image filtered bottom-up matches the top-down result, turned over
+    Image& topDown = copy(source);
+    Image& bottomUp = copy(source);
+    ImageFlipVertical(&bottomUp);
+    Convolution::apply(topDown, Convolution::emboss(1.0f), Rectangle{0, 0, 100, 100});
+    Convolution::apply(bottomUp, Convolution::emboss(1.0f), Rectangle{0, 0, 100, 100}, true);
+    ImageFlipVertical(&bottomUp);
+    EXPECT_EQ(std::memcmp(topDown.data, bottomUp.data, 100 * 100 * 4), 0);
+}
+
+TEST_F(ConvolutionTest, RejectsBadInput) {
+    Image& image = make(8, 8, Color{9, 9, 9, 255});
+    Convolution::apply(image, Convolution::Kernel{4, std::vector<float>(16, 1.0f), 0.0f}, Rectangle{0, 0, 8, 8});
+    Convolution::apply(image, Convolution::Kernel{3, {1.0f}, 0.0f}, Rectangle{0, 0, 8, 8});
+    Convolution::apply(image, Convolution::boxBlur(1), Rectangle{20, 20, 5, 5});
+    EXPECT_EQ(at(image, 0, 0).r, 9);
+}
+
+TEST_F(ConvolutionTest, FilterCommandKeepsChangedTiles) {
+    EventDispatcher dispatcher;
+    Canvas canvas(Rectangle{0, 0, 800, 600}, &dispatcher);
+
+    // Change a few pixels in two tiles of a 300x200 layer
+    Image& before = noise(300, 200, 4);
+    Image& after = copy(before);
+    static_cast<Color*>(after.data)[5 * 300 + 5].r ^= 1;
+    static_cast<Color*>(after.data)[130 * 300 + 250].g ^= 1;
+
+    FilterCommand command(&canvas, canvas.getSelectedLayerHandle(), "Test Filter");
+    command.recordChanges(before, after, Rectangle{0, 0, 300, 200});
+    EXPECT_EQ(command.getTileCount(), 2u);
+    EXPECT_EQ(command.getStoredBytes(), 2u * 2u * (64 * 64 * 4));
+
+    // Changes outside the recorded region are not looked at
+    command.recordChanges(before, after, Rectangle{0, 0, 100, 100});
+    EXPECT_EQ(command.getTileCount(), 1u);
+
+    // Nothing changed, nothing kept
+    command.recordChanges(before, before, Rectangle{0, 0, 300, 200});
+    EXPECT_EQ(command.getTileCount(), 0u);
+    EXPECT_EQ(command.getStoredBytes(), 0u);
+}
+
+TEST_F(ConvolutionTest, LargeLayer) {
+    constexpr int SIZE = 2048;
+    Image& image = noise(SIZE, SIZE, 6);
+    const Rectangle all{0, 0, SIZE, SIZE};
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Convolution::apply(image, Convolution::sharpen(1.0f), all);
+    const double sharpenMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    Convolution::apply(image, Convolution::boxBlur(7), all);
+    const double blurMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << SIZE << "x" << SIZE << ": 3x3 sharpen " << sharpenMs << " ms, separable 15x15 box " << blurMs << " ms" << std::endl;
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <Utils/DirectoryIndex.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class DirectoryIndexTest : public ::testing::Test {
+protected:
+    std::string root_ = "/tmp/test_directory_index";
+
+    void SetUp() override {
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_ + "/a");
+        std::filesystem::create_directories(root_ + "/b");
+        std::filesystem::create_directories(root_ + "/c");
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root_);
+    }
+
+    static void touch(const std::string& path, size_t bytes = 0) {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(bytes, 'x');
+    }
+
+    // Stand-in for the dialog's frame loop
+    template <typename Predicate>
+    static bool pumpUntil(DirectoryIndex& index, Predicate done) {
+        for (int frame = 0; frame < 1000; ++frame) {
+            index.update();
+            if (done())
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return false;
+    }
+
+    static bool contains(const DirectoryIndex::Listing* listing, const std::string& name) {
+        return listing && std::any_of(listing->entries.begin(), listing->entries.end(),
+                                      [&name](const FileEntry& entry) { return entry.name == name; });
+    }
+};
+
+TEST_F(DirectoryIndexTest, FuzzyScoreMatchesSubsequences) {
+    EXPECT_TRUE(DirectoryIndex::fuzzyScore("hol", "Holiday_2023.png").has_value());
+    EXPECT_TRUE(DirectoryIndex::fuzzyScore("h23", "Holiday_2023.png").has_value());
+    EXPECT_TRUE(DirectoryIndex::fuzzyScore("", "anything").has_value());
+    EXPECT_FALSE(DirectoryIndex::fuzzyScore("xyz", "Holiday_2023.png").has_value());
+    EXPECT_FALSE(DirectoryIndex::fuzzyScore("png.", "Holiday.png").has_value());
+
+    // Consecutive characters and word starts beat scattered matches
+    EXPECT_GT(*DirectoryIndex::fuzzyScore("cat", "cat.png"), *DirectoryIndex::fuzzyScore("cat", "c_a_t.png"));
+    EXPECT_GT(*DirectoryIndex::fuzzyScore("sp", "summer_photo.png"), *DirectoryIndex::fuzzyScore("sp", "wasp.png"));
+    // The best start is found even when an earlier one also matches
+    EXPECT_GT(*DirectoryIndex::fuzzyScore("ab", "xaxxab"), *DirectoryIndex::fuzzyScore("ab", "xaxxaxb"));
+}
+
+TEST_F(DirectoryIndexTest, FuzzyFilterRanksMatches) {
+    std::vector<FileEntry> entries = {
+        {"notes.txt", "", false, 0, 0},
+        {"cat_sketch.png", "", false, 0, 0},
+        {"cat.png", "", false, 0, 0},
+        {"scatter.png", "", false, 0, 0},
+    };
+    std::vector<size_t> order = DirectoryIndex::fuzzyFilter("cat", entries);
+    ASSERT_EQ(order.size(), 3u);
+    EXPECT_EQ(entries[order[0]].name, "cat.png");
+    EXPECT_EQ(entries[order[1]].name, "cat_sketch.png");
+    EXPECT_EQ(entries[order[2]].name, "scatter.png");
+}
+
+TEST_F(DirectoryIndexTest, ListsInBackground) {
+    for (int i = 0; i < 600; ++i)
+        touch(root_ + "/a/file" + std::to_string(i) + ".png", static_cast<size_t>(i % 7));
+    std::filesystem::create_directories(root_ + "/a/sub");
+
+    DirectoryIndex index;
+    auto start = std::chrono::high_resolution_clock::now();
+    index.request(root_ + "/a");
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    EXPECT_LT(elapsed, 50.0);
+
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/a")->complete; }));
+    const DirectoryIndex::Listing* listing = index.find(root_ + "/a");
+    EXPECT_EQ(listing->entries.size(), 601u);
+    EXPECT_TRUE(listing->error.empty());
+    EXPECT_FALSE(index.isBusy());
+
+    for (const auto& entry : listing->entries) {
+        if (entry.name == "file13.png") {
+            EXPECT_EQ(entry.size, 6u);
+            EXPECT_NE(entry.modified, 0);
+            EXPECT_FALSE(entry.isDirectory);
+        }
+        if (entry.name == "sub") {
+            EXPECT_TRUE(entry.isDirectory);
+        }
+    }
+}
+
+TEST_F(DirectoryIndexTest, MissingDirectoryReportsError) {
+    DirectoryIndex index;
+    index.request(root_ + "/missing");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/missing")->complete; }));
+    EXPECT_FALSE(index.find(root_ + "/missing")->error.empty());
+    EXPECT_TRUE(index.find(root_ + "/missing")->entries.empty());
+}
+
+TEST_F(DirectoryIndexTest, ChangesOnDiskRefreshTheListing) {
+    touch(root_ + "/a/one.png");
+    DirectoryIndex index;
+    if (!index.isWatching())
+        GTEST_SKIP() << "inotify unavailable";
+
+    index.request(root_ + "/a");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/a")->complete; }));
+    EXPECT_TRUE(contains(index.find(root_ + "/a"), "one.png"));
+
+    touch(root_ + "/a/two.png");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return contains(index.find(root_ + "/a"), "two.png"); }));
+
+    std::filesystem::remove(root_ + "/a/one.png");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return !contains(index.find(root_ + "/a"), "one.png"); }));
+    EXPECT_TRUE(index.find(root_ + "/a")->complete);
+}
+
+TEST_F(DirectoryIndexTest, RevisitsAreServedFromCache) {
+    touch(root_ + "/a/one.png");
+    DirectoryIndex index;
+    if (!index.isWatching())
+        GTEST_SKIP() << "inotify unavailable";
+
+    index.request(root_ + "/a");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/a")->complete; }));
+    index.request(root_ + "/b");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/b")->complete; }));
+
+    // Back to a: complete at once, nothing listed again
+    const uint64_t generation = index.find(root_ + "/a")->generation;
+    index.request(root_ + "/a");
+    EXPECT_FALSE(index.isBusy());
+    EXPECT_TRUE(index.find(root_ + "/a")->complete);
+    EXPECT_EQ(index.find(root_ + "/a")->generation, generation);
+}
+
+TEST_F(DirectoryIndexTest, EvictsLeastRecentlyUsed) {
+    DirectoryIndex index(2);
+    for (const char* name : {"/a", "/b", "/c"}) {
+        index.request(root_ + name);
+        ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + name)->complete; }));
+    }
+    EXPECT_EQ(index.getCachedCount(), 2u);
+    EXPECT_EQ(index.find(root_ + "/a"), nullptr);
+    EXPECT_NE(index.find(root_ + "/c"), nullptr);
+}
+
+TEST_F(DirectoryIndexTest, EvictingOnePathKeepsASharedWatch) {
+    std::filesystem::create_directory_symlink(root_ + "/a", root_ + "/link");
+    DirectoryIndex index(2);
+    if (!index.isWatching())
+        GTEST_SKIP() << "inotify unavailable";
+
+    // Both paths are the same inode and get the same watch descriptor
+    for (const char* name : {"/link", "/a", "/b"}) {
+        index.request(root_ + name);
+        ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + name)->complete; }));
+    }
+    ASSERT_EQ(index.find(root_ + "/link"), nullptr);
+
+    // The evicted symlink must not have taken a's watch with it
+    index.request(root_ + "/a");
+    EXPECT_FALSE(index.isBusy());
+    touch(root_ + "/a/late.png");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return contains(index.find(root_ + "/a"), "late.png"); }));
+}
+
+TEST_F(DirectoryIndexTest, NavigatingAwayCancelsSlowListing) {
+    for (int i = 0; i < 3000; ++i)
+        touch(root_ + "/a/f" + std::to_string(i));
+
+    DirectoryIndex index;
+    index.request(root_ + "/a");
+    index.request(root_ + "/b");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/b")->complete && !index.isBusy(); }));
+
+    // Going back lists a again from scratch and completes
+    index.request(root_ + "/a");
+    ASSERT_TRUE(pumpUntil(index, [&]() { return index.find(root_ + "/a")->complete; }));
+    EXPECT_EQ(index.find(root_ + "/a")->entries.size(), 3000u);
+}
+
+} // namespace EpiGimp
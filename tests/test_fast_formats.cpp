@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <Utils/QoiCodec.hpp>
+#include <Utils/RawTileFile.hpp>
+#include <Core/RaylibWrappers.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class FastFormatsTest : public ::testing::Test {
+protected:
+    std::string qoiPath_ = "/tmp/test_fast_format.qoi";
+    std::string rawPath_ = "/tmp/test_fast_format.ert";
+
+    void TearDown() override {
+        std::filesystem::remove(qoiPath_);
+        std::filesystem::remove(rawPath_);
+    }
+
+    // Flat areas, gradients, speckles and alpha changes exercise every QOI op and RLE packet kind
+    Image makeImage(int width, int height) {
+        Image image = GenImageColor(width, height, Color{0, 0, 0, 0});
+        auto* pixels = static_cast<unsigned char*>(image.data);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                unsigned char* pixel = pixels + (static_cast<size_t>(y) * width + x) * 4;
+                if (x < width / 3) {
+                    pixel[0] = 200; pixel[1] = 40; pixel[2] = 40; pixel[3] = 255;
+                } else {
+                    pixel[0] = static_cast<unsigned char>(x);
+                    pixel[1] = static_cast<unsigned char>((x * 7 + y * 13) % 11 == 0 ? 255 - y : y);
+                    pixel[2] = static_cast<unsigned char>(x ^ y);
+                    pixel[3] = static_cast<unsigned char>((y / 16) % 2 ? 255 : 128 + (x % 64));
+                }
+            }
+        }
+        return image;
+    }
+
+    void expectSamePixels(const Image& expected, const Image& actual) {
+        ASSERT_NE(actual.data, nullptr);
+        ASSERT_EQ(actual.width, expected.width);
+        ASSERT_EQ(actual.height, expected.height);
+        ASSERT_EQ(actual.format, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        EXPECT_EQ(std::memcmp(actual.data, expected.data, static_cast<size_t>(expected.width) * expected.height * 4), 0);
+    }
+};
+
+TEST_F(FastFormatsTest, QoiRoundTripAcrossStripes) {
+    // More pixels than one encoder stripe, so seams land inside the image
+    Image source = makeImage(700, 500);
+    std::vector<uint8_t> qoi;
+    ASSERT_TRUE(QoiCodec::encode(source, qoi, 4));
+
+    Image decoded = QoiCodec::decode(qoi.data(), qoi.size());
+    expectSamePixels(source, decoded);
+    UnloadImage(decoded);
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, QoiOutputDoesNotDependOnThreadCount) {
+    Image source = makeImage(700, 500);
+    std::vector<uint8_t> single;
+    std::vector<uint8_t> parallel;
+    ASSERT_TRUE(QoiCodec::encode(source, single, 1));
+    ASSERT_TRUE(QoiCodec::encode(source, parallel, 8));
+    EXPECT_EQ(single, parallel);
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, QoiIsReadableByRaylib) {
+    Image source = makeImage(700, 500);
+    std::vector<uint8_t> qoi;
+    ASSERT_TRUE(QoiCodec::encode(source, qoi));
+
+    Image decoded = LoadImageFromMemory(".qoi", qoi.data(), static_cast<int>(qoi.size()));
+    ASSERT_NE(decoded.data, nullptr);
+    ImageFormat(&decoded, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    expectSamePixels(source, decoded);
+    UnloadImage(decoded);
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, QoiRejectsInvalidData) {
+    const uint8_t garbage[32] = {'n', 'o', 'p', 'e'};
+    EXPECT_EQ(QoiCodec::decode(garbage, sizeof(garbage)).data, nullptr);
+    EXPECT_EQ(QoiCodec::decode(nullptr, 0).data, nullptr);
+    EXPECT_EQ(QoiCodec::read("/tmp/does_not_exist.qoi").data, nullptr);
+
+    // Cut inside an op: the rest of the pixels were never decoded
+    Image source = makeImage(64, 64);
+    std::vector<uint8_t> qoi;
+    ASSERT_TRUE(QoiCodec::encode(source, qoi, 1));
+    std::vector<uint8_t> truncated(qoi.begin(), qoi.begin() + 14);
+    truncated.push_back(0xFF);   // OP_RGBA with no bytes after it
+    truncated.insert(truncated.end(), qoi.end() - 8, qoi.end());
+    EXPECT_EQ(QoiCodec::decode(truncated.data(), truncated.size()).data, nullptr);
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, RawTilesRoundTrip) {
+    // Edge tiles are partial in both directions
+    Image source = makeImage(300, 200);
+    for (bool rle : {false, true}) {
+        RawTileFile::Options options;
+        options.rle = rle;
+        options.tileSize = 64;
+        ASSERT_TRUE(RawTileFile::write(source, rawPath_, options));
+
+        Image decoded = RawTileFile::read(rawPath_);
+        expectSamePixels(source, decoded);
+        UnloadImage(decoded);
+    }
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, RawTileRleShrinksFlatTiles) {
+    Image source = GenImageColor(512, 512, Color{10, 20, 30, 255});
+    RawTileFile::Options options;
+    options.rle = false;
+    ASSERT_TRUE(RawTileFile::write(source, rawPath_, options));
+    const auto rawSize = std::filesystem::file_size(rawPath_);
+
+    options.rle = true;
+    ASSERT_TRUE(RawTileFile::write(source, rawPath_, options));
+    const auto rleSize = std::filesystem::file_size(rawPath_);
+
+    EXPECT_GE(rawSize, 512u * 512u * 4u);
+    EXPECT_LT(rleSize, rawSize / 50);
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, RawTilesRejectCorruptFiles) {
+    Image source = makeImage(128, 128);
+    ASSERT_TRUE(RawTileFile::write(source, rawPath_));
+    std::filesystem::resize_file(rawPath_, std::filesystem::file_size(rawPath_) - 16);
+    EXPECT_EQ(RawTileFile::read(rawPath_).data, nullptr);
+    EXPECT_EQ(RawTileFile::read("/tmp/does_not_exist.ert").data, nullptr);
+
+    // A tile size that would wrap the tile count to zero
+    ASSERT_TRUE(RawTileFile::write(source, rawPath_));
+    {
+        std::fstream file(rawPath_, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t tileSize = 0xFFFFFFF0u;
+        file.seekp(offsetof(RawTileFile::FileHeader, tileSize));
+        file.write(reinterpret_cast<const char*>(&tileSize), sizeof(tileSize));
+    }
+    EXPECT_EQ(RawTileFile::read(rawPath_).data, nullptr);
+    UnloadImage(source);
+}
+
+TEST_F(FastFormatsTest, ImageResourceRoutesByExtension) {
+    ImageResource image(makeImage(96, 64));
+    std::string actualPath;
+
+    ASSERT_TRUE(image.exportToFile(qoiPath_, actualPath));
+    EXPECT_EQ(actualPath, qoiPath_);
+    auto qoi = ImageResource::fromFile(qoiPath_);
+    ASSERT_TRUE(qoi.has_value());
+    expectSamePixels(*image, **qoi);
+
+    ASSERT_TRUE(image.exportToFile(rawPath_, actualPath));
+    EXPECT_EQ(actualPath, rawPath_);
+    auto raw = ImageResource::fromFile(rawPath_);
+    ASSERT_TRUE(raw.has_value());
+    expectSamePixels(*image, **raw);
+}
+
+// Scratch saves should cost little more than a copy of the pixels
+TEST_F(FastFormatsTest, Performance4k) {
+    Image source = makeImage(4096, 4096);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(QoiCodec::write(source, qoiPath_));
+    Image qoi = QoiCodec::read(qoiPath_);
+    auto qoiTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+
+    start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(RawTileFile::write(source, rawPath_));
+    Image raw = RawTileFile::read(rawPath_);
+    auto rawTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+
+    std::cout << "4096x4096 write+read: QOI " << qoiTime.count() << " ms (" << std::filesystem::file_size(qoiPath_)
+              << " bytes), raw tiles " << rawTime.count() << " ms (" << std::filesystem::file_size(rawPath_)
+              << " bytes)" << std::endl;
+
+    expectSamePixels(source, qoi);
+    expectSamePixels(source, raw);
+    EXPECT_LT(qoiTime.count(), 2000);
+    EXPECT_LT(rawTime.count(), 1000);
+
+    UnloadImage(qoi);
+    UnloadImage(raw);
+    UnloadImage(source);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,308 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <Utils/FloodFill.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class FloodFillTest : public ImageTest {
+protected:
+    static void setPixel(Image& image, int x, int y, Color color) {
+        auto* pixel = static_cast<unsigned char*>(image.data) + (static_cast<size_t>(y) * image.width + x) * 4;
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        pixel[3] = color.a;
+    }
+
+    static Color getPixel(const Image& image, int x, int y) {
+        const auto* pixel = static_cast<const unsigned char*>(image.data) + (static_cast<size_t>(y) * image.width + x) * 4;
+        return Color{pixel[0], pixel[1], pixel[2], pixel[3]};
+    }
+
+    // Per-pixel 4-connected reference fill with an explicit stack
+    static std::vector<uint8_t> referenceFill(const Image& image, int x, int y, int tolerance) {
+        std::vector<uint8_t> inside(static_cast<size_t>(image.width) * image.height, 0);
+        const Color seed = getPixel(image, x, y);
+        std::vector<std::pair<int, int>> stack{{x, y}};
+        while (!stack.empty()) {
+            auto [px, py] = stack.back();
+            stack.pop_back();
+            if (px < 0 || py < 0 || px >= image.width || py >= image.height)
+                continue;
+            uint8_t& cell = inside[static_cast<size_t>(py) * image.width + px];
+            if (cell || !FloodFill::withinTolerance(getPixel(image, px, py), seed, tolerance))
+                continue;
+            cell = 255;
+            stack.push_back({px + 1, py});
+            stack.push_back({px - 1, py});
+            stack.push_back({px, py + 1});
+            stack.push_back({px, py - 1});
+        }
+        return inside;
+    }
+
+    static std::vector<uint8_t> spanFill(const Image& image, int x, int y, int tolerance, size_t& visits) {
+        std::vector<uint8_t> inside(static_cast<size_t>(image.width) * image.height, 0);
+        visits = 0;
+        FloodFill::forEachSpan(image, x, y, tolerance, [&](int row, int x0, int x1) {
+            for (int px = x0; px <= x1; ++px) {
+                inside[static_cast<size_t>(row) * image.width + px]++;
+                visits++;
+            }
+        });
+        for (auto& cell : inside)
+            cell = cell ? 255 : 0;
+        return inside;
+    }
+};
+
+TEST_F(FloodFillTest, FillsInsideARingOnly) {
+    // A 1-pixel ring with a gap-free border; the seed is inside
+    Image& image = make(40, 30, WHITE);
+    for (int x = 5; x <= 30; ++x) {
+        setPixel(image, x, 4, BLACK);
+        setPixel(image, x, 20, BLACK);
+    }
+    for (int y = 4; y <= 20; ++y) {
+        setPixel(image, 5, y, BLACK);
+        setPixel(image, 30, y, BLACK);
+    }
+
+    size_t visits = 0;
+    const auto inside = spanFill(image, 10, 10, 0, visits);
+    EXPECT_EQ(visits, static_cast<size_t>(24 * 15));
+    EXPECT_EQ(inside[10 * 40 + 10], 255);
+    EXPECT_EQ(inside[4 * 40 + 10], 0);    // Ring
+    EXPECT_EQ(inside[2 * 40 + 2], 0);     // Outside
+    EXPECT_EQ(inside[19 * 40 + 29], 255);
+
+    // The outside wraps around the ring
+    EXPECT_EQ(FloodFill::forEachSpan(image, 0, 0, 0, [](int, int, int) {}), static_cast<size_t>(40 * 30 - 26 * 17));
+}
+
+TEST_F(FloodFillTest, MatchesPerPixelReferenceOnNoise) {
+    // Odd widths exercise the vector tails; a maze-like noise exercises left extension and revisits
+    std::mt19937 rng(7);
+    for (int width : {1, 3, 5, 17, 64, 131}) {
+        Image& image = make(width, 57, WHITE);
+        for (int y = 0; y < image.height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const unsigned char shade = (rng() % 3 == 0) ? 0 : static_cast<unsigned char>(200 + rng() % 40);
+                setPixel(image, x, y, Color{shade, shade, shade, 255});
+            }
+        }
+
+        for (int tolerance : {0, 20, 60}) {
+            for (int trial = 0; trial < 5; ++trial) {
+                const int x = static_cast<int>(rng() % width);
+                const int y = static_cast<int>(rng() % image.height);
+                size_t visits = 0;
+                const auto spans = spanFill(image, x, y, tolerance, visits);
+                const auto expected = referenceFill(image, x, y, tolerance);
+                EXPECT_EQ(spans, expected) << "width " << width << " tolerance " << tolerance;
+
+                size_t area = 0;
+                for (auto cell : expected)
+                    area += cell ? 1 : 0;
+                EXPECT_EQ(visits, area) << "pixels visited more than once";
+            }
+        }
+    }
+}
+
+TEST_F(FloodFillTest, ToleranceCoversEveryChannel) {
+    // A horizontal ramp in red: tolerance decides how far the fill runs
+    Image& image = make(64, 4, BLACK);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 64; ++x)
+            setPixel(image, x, y, Color{static_cast<unsigned char>(x * 4), 0, 0, 255});
+    }
+    EXPECT_EQ(FloodFill::forEachSpan(image, 0, 0, 0, [](int, int, int) {}), 4u);
+    EXPECT_EQ(FloodFill::forEachSpan(image, 0, 0, 40, [](int, int, int) {}), 44u);
+    EXPECT_EQ(FloodFill::forEachSpan(image, 63, 0, 255, [](int, int, int) {}), 256u);
+
+    // Alpha counts too: a transparent column stops a fill on opaque pixels
+    for (int y = 0; y < 4; ++y)
+        setPixel(image, 5, y, Color{20, 0, 0, 0});
+    EXPECT_EQ(FloodFill::forEachSpan(image, 0, 0, 40, [](int, int, int) {}), 20u);
+
+    EXPECT_TRUE(FloodFill::withinTolerance(Color{10, 20, 30, 40}, Color{15, 15, 35, 35}, 5));
+    EXPECT_FALSE(FloodFill::withinTolerance(Color{10, 20, 30, 40}, Color{10, 20, 30, 46}, 5));
+}
+
+TEST_F(FloodFillTest, AntialiasedRimSitsOutsideTheRegion) {
+    Image& image = make(20, 20, WHITE);
+    for (int y = 5; y < 15; ++y) {
+        for (int x = 5; x < 15; ++x)
+            setPixel(image, x, y, BLUE);
+    }
+
+    Rectangle bounds{};
+    FloodFill::Options options;
+    options.tolerance = 0;
+    options.antialias = false;
+    const auto hard = FloodFill::regionMask(image, 8, 8, options, &bounds);
+    EXPECT_EQ(bounds.x, 5.0f);
+    EXPECT_EQ(bounds.width, 10.0f);
+    EXPECT_EQ(hard[4 * 20 + 8], 0);
+
+    options.antialias = true;
+    const auto soft = FloodFill::regionMask(image, 8, 8, options, &bounds);
+    EXPECT_EQ(bounds.x, 4.0f);
+    EXPECT_EQ(bounds.width, 12.0f);
+    for (size_t i = 0; i < soft.size(); ++i) {
+        if (hard[i]) {
+            EXPECT_EQ(soft[i], 255);   // The region itself stays fully covered
+        }
+    }
+    EXPECT_EQ(soft[4 * 20 + 8], 3 * 255 / 9);    // Edge
+    EXPECT_EQ(soft[4 * 20 + 4], 1 * 255 / 9);    // Corner
+    EXPECT_EQ(soft[3 * 20 + 8], 0);
+}
+
+TEST_F(FloodFillTest, FillMaskBlendsByCoverage) {
+    Image& target = make(4, 1, Color{0, 0, 0, 0});
+    setPixel(target, 2, 0, Color{0, 0, 255, 255});
+    setPixel(target, 3, 0, Color{0, 0, 255, 255});
+    const std::vector<uint8_t> mask{255, 128, 255, 128};
+
+    FloodFill::fillMask(target, mask, Color{255, 0, 0, 255}, Rectangle{0, 0, 4, 1});
+    const Color full = getPixel(target, 0, 0);
+    const Color halfOnClear = getPixel(target, 1, 0);
+    const Color overBlue = getPixel(target, 2, 0);
+    const Color halfOverBlue = getPixel(target, 3, 0);
+
+    EXPECT_EQ(full.r, 255);
+    EXPECT_EQ(full.a, 255);
+    EXPECT_EQ(halfOnClear.r, 255);     // Straight alpha: the colour stays, coverage goes to alpha
+    EXPECT_EQ(halfOnClear.a, 128);
+    EXPECT_EQ(overBlue.r, 255);
+    EXPECT_EQ(overBlue.b, 0);
+    EXPECT_NEAR(halfOverBlue.r, 128, 1);
+    EXPECT_NEAR(halfOverBlue.b, 127, 1);
+    EXPECT_EQ(halfOverBlue.a, 255);
+
+    // Outside bounds nothing changes
+    Image& untouched = make(4, 1, Color{0, 0, 0, 0});
+    FloodFill::fillMask(untouched, mask, RED, Rectangle{0, 0, 1, 1});
+    EXPECT_EQ(getPixel(untouched, 1, 0).a, 0);
+}
+
+TEST_F(FloodFillTest, SeedOutsideTheImageFillsNothing) {
+    Image& image = make(8, 8, WHITE);
+    bool called = false;
+    EXPECT_EQ(FloodFill::forEachSpan(image, -1, 0, 0, [&called](int, int, int) { called = true; }), 0u);
+    EXPECT_EQ(FloodFill::forEachSpan(image, 0, 8, 0, [&called](int, int, int) { called = true; }), 0u);
+    EXPECT_FALSE(called);
+    EXPECT_TRUE(FloodFill::regionMask(image, 8, 0, FloodFill::Options{}).empty());
+}
+
+TEST_F(FloodFillTest, LargeRegionFill) {
+    constexpr int SIZE = 4096;
+    Image& image = make(SIZE, SIZE, WHITE);
+    // A few walls with gaps so the fill has to turn around them
+    for (int x = 0; x < SIZE - 64; ++x) {
+        setPixel(image, x, SIZE / 3, BLACK);
+        setPixel(image, SIZE - 1 - x, 2 * SIZE / 3, BLACK);
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    Rectangle bounds{};
+    const auto mask = FloodFill::regionMask(image, 0, 0, FloodFill::Options{}, &bounds);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    EXPECT_EQ(bounds.width, static_cast<float>(SIZE));
+    EXPECT_EQ(bounds.height, static_cast<float>(SIZE));
+    EXPECT_EQ(mask[static_cast<size_t>(SIZE - 1) * SIZE], 255);
+    std::cout << "fill of a " << SIZE << "x" << SIZE << " region: " << ms << " ms" << std::endl;
+}
+
+TEST_F(FloodFillTest, MagicWandSelectsTheFilledRegion) {
+    std::mt19937 rng(11);
+    Image& image = make(131, 77, WHITE);
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            const unsigned char shade = (rng() % 3 == 0) ? 0 : static_cast<unsigned char>(200 + rng() % 40);
+            setPixel(image, x, y, Color{shade, shade, shade, 255});
+        }
+    }
+
+    for (int trial = 0; trial < 5; ++trial) {
+        const int x = static_cast<int>(rng() % image.width);
+        const int y = static_cast<int>(rng() % image.height);
+        const auto expected = referenceFill(image, x, y, 30);
+        const SelectionMask topDown = FloodFill::selectRegion(image, x, y, 30, false);
+        const SelectionMask bottomUp = FloodFill::selectRegion(image, x, y, 30, true);
+        for (int py = 0; py < image.height; ++py) {
+            for (int px = 0; px < image.width; ++px) {
+                const uint8_t cell = expected[static_cast<size_t>(py) * image.width + px];
+                ASSERT_EQ(topDown.at(px, py), cell) << px << "," << py;
+                ASSERT_EQ(bottomUp.at(px, image.height - 1 - py), cell) << px << "," << py;
+            }
+        }
+    }
+
+    EXPECT_TRUE(FloodFill::selectRegion(image, -1, 0, 30, false).isEmpty());
+}
+
+TEST_F(FloodFillTest, MagicWandGlobalSelectsEveryMatch) {
+    // Odd sizes leave partial tiles and vector tails
+    std::mt19937 rng(5);
+    Image& image = make(203, 97, WHITE);
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x)
+            setPixel(image, x, y, Color{static_cast<unsigned char>(rng() % 256), 128, 64, static_cast<unsigned char>(200 + rng() % 56)});
+    }
+
+    const Color seed = getPixel(image, 10, 20);
+    const SelectionMask topDown = FloodFill::selectSimilar(image, 10, 20, 40, false);
+    const SelectionMask bottomUp = FloodFill::selectSimilar(image, 10, 20, 40, true);
+    size_t selected = 0;
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            const uint8_t expected = FloodFill::withinTolerance(getPixel(image, x, y), seed, 40) ? 255 : 0;
+            ASSERT_EQ(topDown.at(x, y), expected) << x << "," << y;
+            ASSERT_EQ(bottomUp.at(x, image.height - 1 - y), expected) << x << "," << y;
+            selected += expected ? 1 : 0;
+        }
+    }
+    EXPECT_GT(selected, 1000u);
+    EXPECT_TRUE(FloodFill::selectSimilar(image, 0, image.height, 40, false).isEmpty());
+
+    // A flat image is one uniform value per tile
+    Image& flat = make(300, 200, WHITE);
+    const SelectionMask all = FloodFill::selectSimilar(flat, 0, 0, 0, false);
+    EXPECT_EQ(all.getStoredTileCount(), 0u);
+    EXPECT_TRUE(all.isRectangle());
+}
+
+TEST_F(FloodFillTest, MagicWandOnLargeImage) {
+    constexpr int SIZE = 8192;
+    Image& image = make(SIZE, SIZE, WHITE);
+    for (int x = 0; x < SIZE - 64; ++x) {
+        setPixel(image, x, SIZE / 3, BLACK);
+        setPixel(image, SIZE - 1 - x, 2 * SIZE / 3, BLACK);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    const SelectionMask region = FloodFill::selectRegion(image, 0, 0, 32, true);
+    const double regionMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    const SelectionMask similar = FloodFill::selectSimilar(image, 0, 0, 32, true);
+    const double similarMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    EXPECT_EQ(region.at(5, 5), 255);
+    EXPECT_EQ(region.at(5, SIZE - 1 - SIZE / 3), 0);
+    EXPECT_EQ(similar.at(5, SIZE - 1 - SIZE / 3), 0);
+    EXPECT_LT(similar.getStoredTileCount(), 1000u);
+    std::cout << "magic wand on " << SIZE << "x" << SIZE << ": contiguous " << regionMs << " ms, global "
+              << similarMs << " ms" << std::endl;
+}
+
+} // namespace EpiGimp
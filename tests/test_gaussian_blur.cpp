@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <Utils/Filters.hpp>
+#include <Utils/GaussianBlur.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class GaussianBlurTest : public ImageTest {
+protected:
+    static Color* pixels(Image& image) { return static_cast<Color*>(image.data); }
+};
+
+TEST_F(GaussianBlurTest, CoefficientsHaveUnitGain) {
+    for (float sigma : {0.5f, 2.0f, 30.0f, 200.0f}) {
+        const GaussianBlur::Coefficients c = GaussianBlur::coefficients(sigma);
+        EXPECT_NEAR(c.realGain / (1.0f - c.real), 1.0f, 1e-3f);
+        EXPECT_NEAR(c.pairGain / (1.0f - c.c1 - c.c2), 1.0f, 1e-3f);
+        EXPECT_LT(c.real, 1.0f);
+    }
+}
+
+TEST_F(GaussianBlurTest, ConstantImageStaysConstant) {
+    Image& image = make(97, 61, Color{200, 120, 40, 255});
+    GaussianBlur::blur(image, 12.0f);
+    for (int i = 0; i < 97 * 61; ++i) {
+        ASSERT_EQ(pixels(image)[i].r, 200) << i;
+        ASSERT_EQ(pixels(image)[i].g, 120) << i;
+        ASSERT_EQ(pixels(image)[i].b, 40) << i;
+        ASSERT_EQ(pixels(image)[i].a, 255) << i;
+    }
+}
+
+TEST_F(GaussianBlurTest, ImpulseSpreadMatchesSigma) {
+    // A bright line across a dark image: the blurred profile has the requested spread
+    constexpr int SIZE = 301;
+    for (float sigma : {3.0f, 10.0f, 25.0f}) {
+        Image& image = make(SIZE, 9, Color{0, 0, 0, 255});
+        for (int y = 0; y < 9; ++y)
+            pixels(image)[y * SIZE + SIZE / 2] = Color{255, 255, 255, 255};
+        GaussianBlur::blur(image, sigma);
+
+        double sum = 0.0, variance = 0.0;
+        for (int x = 0; x < SIZE; ++x) {
+            const double value = pixels(image)[4 * SIZE + x].r;
+            sum += value;
+            variance += value * (x - SIZE / 2) * (x - SIZE / 2);
+        }
+        EXPECT_NEAR(sum, 255.0, 255.0 * 0.08) << sigma;
+        EXPECT_NEAR(std::sqrt(variance / sum), sigma, sigma * 0.1) << sigma;
+    }
+}
+
+TEST_F(GaussianBlurTest, TransparentPixelsDoNotDarken) {
+    // Red next to transparent black: the red fades out but never turns dark
+    Image& image = make(64, 16, Color{0, 0, 0, 0});
+    for (int y = 0; y < 16; ++y)
+        for (int x = 0; x < 32; ++x)
+            pixels(image)[y * 64 + x] = Color{255, 0, 0, 255};
+    GaussianBlur::blur(image, 4.0f);
+
+    for (int x = 20; x < 44; ++x) {
+        const Color c = pixels(image)[8 * 64 + x];
+        if (c.a > 8) {
+            EXPECT_GE(c.r, 250) << x;
+        }
+    }
+    EXPECT_GT(pixels(image)[8 * 64 + 34].a, 0);
+    EXPECT_LT(pixels(image)[8 * 64 + 34].a, 255);
+}
+
+TEST_F(GaussianBlurTest, RegionLeavesTheRestAlone) {
+    Image& image = make(80, 80, Color{0, 0, 0, 255});
+    for (int y = 0; y < 80; ++y)
+        for (int x = 0; x < 80; ++x)
+            pixels(image)[y * 80 + x] = ((x / 4 + y / 4) % 2) ? Color{255, 255, 255, 255} : Color{0, 0, 0, 255};
+    Image original = ImageCopy(image);
+
+    GaussianBlur::blur(image, 5.0f, Rectangle{20, 30, 40, 20});
+    for (int y = 0; y < 80; ++y) {
+        for (int x = 0; x < 80; ++x) {
+            const bool inside = x >= 20 && x < 60 && y >= 30 && y < 50;
+            const Color before = static_cast<Color*>(original.data)[y * 80 + x];
+            const Color after = pixels(image)[y * 80 + x];
+            if (!inside) {
+                ASSERT_EQ(before.r, after.r) << x << "," << y;
+            }
+        }
+    }
+    // The checkerboard is smoothed to grey inside
+    EXPECT_NEAR(pixels(image)[40 * 80 + 40].r, 128, 16);
+    UnloadImage(original);
+
+    // Regions off the image, and tiny sigmas, do nothing
+    Image& untouched = make(8, 8, Color{1, 2, 3, 255});
+    GaussianBlur::blur(untouched, 5.0f, Rectangle{20, 20, 10, 10});
+    GaussianBlur::blur(untouched, 0.1f);
+    EXPECT_EQ(pixels(untouched)[0].g, 2);
+}
+
+TEST_F(GaussianBlurTest, LargeSigmaFollowsTheErrorFunction) {
+    // A step blurred with sigma 200 should follow erf, without the drift of an unfactored filter
+    constexpr int WIDTH = 4000;
+    constexpr float SIGMA = 200.0f;
+    Image& image = make(WIDTH, 4, Color{0, 0, 0, 255});
+    for (int y = 0; y < 4; ++y)
+        for (int x = WIDTH / 2; x < WIDTH; ++x)
+            pixels(image)[y * WIDTH + x] = Color{255, 255, 255, 255};
+    GaussianBlur::blur(image, SIGMA);
+
+    for (int offset = -600; offset <= 600; offset += 50) {
+        const int x = WIDTH / 2 + offset;
+        const double expected = 127.5 * (1.0 + std::erf((offset + 0.5 - 0.5) / (SIGMA * std::sqrt(2.0))));
+        EXPECT_NEAR(pixels(image)[2 * WIDTH + x].r, expected, 6.0) << offset;
+    }
+}
+
+TEST_F(GaussianBlurTest, LargeLayer) {
+    // Cost per pixel does not depend on sigma
+    constexpr int SIZE = 2048;
+    Image& image = make(SIZE, SIZE, Color{0, 0, 0, 255});
+    for (int y = 0; y < SIZE; ++y)
+        for (int x = 0; x < SIZE; ++x)
+            pixels(image)[y * SIZE + x] = Color{static_cast<unsigned char>(x), static_cast<unsigned char>(y), 90, 255};
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    GaussianBlur::blur(image, 200.0f);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    EXPECT_EQ(pixels(image)[SIZE * SIZE / 2].b, 90);
+    std::cout << "blurred " << SIZE << "x" << SIZE << " at sigma 200: " << ms << " ms" << std::endl;
+}
+
+TEST_F(GaussianBlurTest, MenuFilterWrapsTheBlur) {
+    const LayerFilter filter = Filters::gaussianBlur(4.0f);
+    EXPECT_EQ(filter.name, "Gaussian Blur");
+    EXPECT_TRUE(filter.amountIsDistance);
+    EXPECT_EQ(filter.reach(4.0f), 12);
+
+    Image& image = make(32, 32, Color{0, 0, 0, 255});
+    pixels(image)[16 * 32 + 16] = Color{255, 255, 255, 255};
+    Filters::run(filter, image, Rectangle{0, 0, 32, 32}, filter.amount);
+    EXPECT_LT(pixels(image)[16 * 32 + 16].r, 40);
+    EXPECT_GT(pixels(image)[16 * 32 + 19].r, 0);
+}
+
+} // namespace EpiGimp
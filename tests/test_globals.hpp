@@ -2,6 +2,9 @@
 
 #include <gtest/gtest.h>
 #include <raylib.h>
+#include <cstdint>
+#include <deque>
+#include <random>
 
 namespace EpiGimp {
 
@@ -18,4 +21,36 @@ public:
     }
 };
 
+// Fixture for tests that work on RGBA8 images; every image it hands out is unloaded after the test
+class ImageTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (Image& image : images_)
+            UnloadImage(image);
+        images_.clear();
+    }
+
+    Image& make(int width, int height, Color fill) {
+        images_.push_back(GenImageColor(width, height, fill));
+        return images_.back();
+    }
+
+    Image& noise(int width, int height, unsigned seed) {
+        Image& image = make(width, height, BLANK);
+        std::mt19937 rng(seed);
+        auto* bytes = static_cast<uint8_t*>(image.data);
+        for (int i = 0; i < width * height * 4; ++i)
+            bytes[i] = static_cast<uint8_t>(rng());
+        return image;
+    }
+
+    Image& copy(const Image& image) {
+        images_.push_back(ImageCopy(image));
+        return images_.back();
+    }
+
+private:
+    std::deque<Image> images_;   // A deque, so references handed out stay valid as it grows
+};
+
 } // namespace EpiGimp
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Core/JobSystem.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class JobSystemTest : public ::testing::Test {
+protected:
+    // Enough floating point work per index that scheduling overhead does not dominate
+    static double kernel(size_t i) {
+        double value = static_cast<double>(i);
+        for (int k = 0; k < 2000; ++k)
+            value = std::sqrt(value + k);
+        return value;
+    }
+};
+
+TEST_F(JobSystemTest, SubmittedJobsRunAndCanBeWaitedFor) {
+    JobSystem jobs(2);
+    std::atomic<int> counter{0};
+    std::vector<JobSystem::Handle> handles;
+    for (int i = 0; i < 100; ++i)
+        handles.push_back(jobs.submit([&counter]() { counter++; }));
+    for (const auto& handle : handles)
+        jobs.wait(handle);
+
+    EXPECT_EQ(counter.load(), 100);
+    EXPECT_TRUE(handles.front().isDone());
+    EXPECT_TRUE(JobSystem::Handle().isDone());
+    jobs.wait(JobSystem::Handle());   // Empty handles are already done
+}
+
+TEST_F(JobSystemTest, DependenciesRunFirst) {
+    JobSystem jobs(3);
+    std::mutex mutex;
+    std::vector<char> order;
+    auto record = [&](char name) {
+        return [&, name]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(name == 'a' ? 20 : 1));
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+    };
+
+    // Diamond: a before b and c, both before d
+    auto a = jobs.submit(record('a'));
+    auto b = jobs.submit(record('b'), {a});
+    auto c = jobs.submit(record('c'), {a});
+    auto d = jobs.submit(record('d'), {b, c});
+    jobs.wait(d);
+
+    ASSERT_EQ(order.size(), 4u);
+    EXPECT_EQ(order.front(), 'a');
+    EXPECT_EQ(order.back(), 'd');
+    EXPECT_TRUE(b.isDone());
+    EXPECT_TRUE(c.isDone());
+
+    // A dependency that already finished does not hold anything up
+    auto e = jobs.submit(record('e'), {a});
+    jobs.wait(e);
+    EXPECT_EQ(order.back(), 'e');
+}
+
+TEST_F(JobSystemTest, ParallelForCoversEveryIndexOnce) {
+    JobSystem jobs(3);
+    for (size_t count : {1u, 7u, 1000u, 4097u}) {
+        for (size_t grain : {1u, 3u, 64u}) {
+            std::vector<std::atomic<int>> hits(count);
+            jobs.parallelFor(count, [&hits](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    hits[i]++;
+            }, grain);
+            for (size_t i = 0; i < count; ++i)
+                ASSERT_EQ(hits[i].load(), 1) << "count " << count << " grain " << grain << " index " << i;
+        }
+    }
+
+    // One thread means the caller does everything itself
+    std::set<std::thread::id> threads;
+    jobs.parallelFor(100, [&threads](size_t, size_t) { threads.insert(std::this_thread::get_id()); }, 1, 1);
+    EXPECT_EQ(threads, std::set<std::thread::id>{std::this_thread::get_id()});
+
+    jobs.parallelFor(0, [](size_t, size_t) { FAIL() << "nothing to do"; });
+}
+
+TEST_F(JobSystemTest, ParallelForRethrowsAfterEveryChunkFinished) {
+    JobSystem jobs(3);
+    for (size_t thrower : {0u, 37u, 99u}) {
+        std::atomic<int> running{0};
+        std::atomic<bool> overlapped{false};
+        try {
+            jobs.parallelFor(100, [&](size_t begin, size_t) {
+                running++;
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                if (begin == thrower) {
+                    running--;
+                    throw std::runtime_error("chunk " + std::to_string(begin));
+                }
+                running--;
+            });
+            ADD_FAILURE() << "no exception";
+        } catch (const std::runtime_error& error) {
+            EXPECT_EQ(std::string(error.what()), "chunk " + std::to_string(thrower));
+            // Nothing may still be inside body (whose captures are about to go away)
+            overlapped = running.load() != 0;
+        }
+        EXPECT_FALSE(overlapped.load()) << "thrower " << thrower;
+    }
+
+    // The pool is still usable afterwards
+    std::atomic<size_t> total{0};
+    jobs.parallelFor(64, [&total](size_t begin, size_t end) { total += end - begin; });
+    EXPECT_EQ(total.load(), 64u);
+}
+
+TEST_F(JobSystemTest, NestedParallelForDoesNotDeadlock) {
+    // More outer jobs than workers, each waiting on an inner loop: waiting workers help out
+    JobSystem jobs(2);
+    std::atomic<size_t> total{0};
+    std::vector<JobSystem::Handle> handles;
+    for (int outer = 0; outer < 8; ++outer) {
+        handles.push_back(jobs.submit([&jobs, &total]() {
+            jobs.parallelFor(64, [&total](size_t begin, size_t end) { total += end - begin; });
+        }));
+    }
+    jobs.parallelFor(16, [&jobs, &total](size_t, size_t) {
+        jobs.parallelFor(8, [&total](size_t begin, size_t end) { total += end - begin; });
+    });
+    for (const auto& handle : handles)
+        jobs.wait(handle);
+
+    EXPECT_EQ(total.load(), 8u * 64u + 16u * 8u);
+}
+
+TEST_F(JobSystemTest, IdleWorkersStealQueuedJobs) {
+    JobSystem jobs(4);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    // Every job is pushed onto one worker's own deque; the others have to steal them
+    auto spawner = jobs.submit([&]() {
+        std::vector<JobSystem::Handle> children;
+        for (int i = 0; i < 64; ++i) {
+            children.push_back(jobs.submit([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }));
+        }
+        for (const auto& child : children)
+            jobs.wait(child);
+    });
+    jobs.wait(spawner);
+
+    EXPECT_GT(threads.size(), 1u);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+}
+
+TEST_F(JobSystemTest, MainThreadQueueRunsOnlyWhenPumped) {
+    JobSystem jobs(2);
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<int> ranOnMain{0};
+
+    std::vector<JobSystem::Handle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(jobs.submit([&]() {
+            jobs.postToMain([&]() {
+                if (std::this_thread::get_id() == mainThread)
+                    ranOnMain++;
+            });
+        }));
+    }
+    for (const auto& handle : handles)
+        jobs.wait(handle);
+
+    EXPECT_EQ(ranOnMain.load(), 0);
+    EXPECT_EQ(jobs.runMainThreadTasks(3), 3u);
+    EXPECT_EQ(ranOnMain.load(), 3);
+    EXPECT_EQ(jobs.runMainThreadTasks(), 2u);
+    EXPECT_EQ(jobs.runMainThreadTasks(), 0u);
+    EXPECT_EQ(ranOnMain.load(), 5);
+}
+
+TEST_F(JobSystemTest, ScalingFromOneToAllCores) {
+    JobSystem& jobs = JobSystem::shared();
+    const size_t count = 20000;
+    std::vector<double> reference(count);
+    for (size_t i = 0; i < count; ++i)
+        reference[i] = kernel(i);
+
+    double singleMs = 0.0;
+    for (unsigned threads = 1; threads <= jobs.getConcurrency(); threads = threads < 2 ? 2 : threads * 2) {
+        std::vector<double> results(count);
+        const auto start = std::chrono::high_resolution_clock::now();
+        jobs.parallelFor(count, [&results](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                results[i] = kernel(i);
+        }, 64, threads);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if (threads == 1)
+            singleMs = ms;
+
+        EXPECT_EQ(results, reference);
+        std::cout << "parallelFor on " << threads << " thread(s): " << ms << " ms (x"
+                  << (ms > 0.0 ? singleMs / ms : 0.0) << ")" << std::endl;
+    }
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <Core/SlotMap.hpp>
+#include <Core/LayerManager.hpp>
+#include <Core/HistoryManager.hpp>
+#include <Commands/LayerCommands.hpp>
+#include <Commands/DrawCommand.hpp>
+#include <UI/Canvas.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+struct TestTag {};
+using TestMap = SlotMap<int, TestTag>;
+
+// SlotMap basics
+TEST(SlotMapTest, InsertAndGet) {
+    TestMap map;
+    auto a = map.insert(1);
+    auto b = map.insert(2);
+
+    EXPECT_EQ(map.size(), 2u);
+    ASSERT_NE(map.get(a), nullptr);
+    ASSERT_NE(map.get(b), nullptr);
+    EXPECT_EQ(*map.get(a), 1);
+    EXPECT_EQ(*map.get(b), 2);
+    EXPECT_NE(a, b);
+}
+
+TEST(SlotMapTest, StaleHandleDetected) {
+    TestMap map;
+    auto a = map.insert(1);
+    EXPECT_TRUE(map.erase(a));
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_EQ(map.get(a), nullptr);
+    EXPECT_FALSE(map.erase(a));
+
+    // Slot is reused, but the old handle must not alias the new value
+    auto b = map.insert(2);
+    EXPECT_EQ(a.index, b.index);
+    EXPECT_NE(a.generation, b.generation);
+    EXPECT_EQ(map.get(a), nullptr);
+    ASSERT_NE(map.get(b), nullptr);
+    EXPECT_EQ(*map.get(b), 2);
+}
+
+TEST(SlotMapTest, NullHandle) {
+    TestMap map;
+    TestMap::Handle handle;
+    EXPECT_TRUE(handle.isNull());
+    EXPECT_FALSE(map.contains(handle));
+    EXPECT_EQ(map.get(handle), nullptr);
+}
+
+TEST(SlotMapTest, ClearInvalidatesHandles) {
+    TestMap map;
+    auto a = map.insert(1);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(a));
+}
+
+class LayerHandleTest : public ::testing::Test {
+protected:
+    std::unique_ptr<EventDispatcher> dispatcher_;
+    std::unique_ptr<LayerManager> layerManager_;
+    std::unique_ptr<HistoryManager> historyManager_;
+
+    void SetUp() override {
+        dispatcher_ = std::make_unique<EventDispatcher>();
+        layerManager_ = std::make_unique<LayerManager>(200, 150, dispatcher_.get());
+        historyManager_ = std::make_unique<HistoryManager>();
+    }
+};
+
+TEST_F(LayerHandleTest, HandleSurvivesReorder) {
+    layerManager_->createLayer("Layer 1");
+    layerManager_->createLayer("Layer 2");
+
+    LayerHandle handle = layerManager_->getLayerHandle(1);
+    ASSERT_FALSE(handle.isNull());
+    EXPECT_EQ(layerManager_->getLayerIndex(handle), 1);
+
+    EXPECT_TRUE(layerManager_->moveLayer(1, 2));
+    EXPECT_EQ(layerManager_->getLayerIndex(handle), 2);
+    ASSERT_NE(layerManager_->getLayer(handle), nullptr);
+    EXPECT_EQ(layerManager_->getLayer(handle)->getName(), "Layer 1");
+}
+
+TEST_F(LayerHandleTest, DeletedLayerHandleIsStale) {
+    layerManager_->createLayer("Layer 1");
+    LayerHandle handle = layerManager_->getLayerHandle(1);
+
+    EXPECT_TRUE(layerManager_->deleteLayer(1));
+    EXPECT_EQ(layerManager_->getLayer(handle), nullptr);
+    EXPECT_EQ(layerManager_->getLayerIndex(handle), -1);
+
+    // A new layer must not be reachable through the old handle
+    layerManager_->createLayer("Layer 2");
+    EXPECT_EQ(layerManager_->getLayer(handle), nullptr);
+}
+
+TEST_F(LayerHandleTest, EventsCarryHandles) {
+    LayerHandle created;
+    dispatcher_->subscribe<LayerCreatedEvent>([&](const LayerCreatedEvent& event) {
+        created = event.layerHandle;
+    });
+
+    size_t index = layerManager_->createLayer("Evented");
+    EXPECT_EQ(created, layerManager_->getLayerHandle(index));
+}
+
+TEST_F(LayerHandleTest, DeleteUndoRestoresSameLayer) {
+    layerManager_->createLayer("Keep Me");
+    LayerHandle handle = layerManager_->getLayerHandle(1);
+
+    ASSERT_TRUE(historyManager_->executeCommand(std::make_unique<DeleteLayerCommand>(layerManager_.get(), 1)));
+    EXPECT_EQ(layerManager_->getLayerCount(), 1u);
+    EXPECT_EQ(layerManager_->getLayer(handle), nullptr);
+
+    ASSERT_TRUE(historyManager_->undo());
+    EXPECT_EQ(layerManager_->getLayerCount(), 2u);
+    EXPECT_EQ(layerManager_->getLayerIndex(handle), 1);
+    ASSERT_NE(layerManager_->getLayer(handle), nullptr);
+    EXPECT_EQ(layerManager_->getLayer(handle)->getName(), "Keep Me");
+}
+
+TEST_F(LayerHandleTest, HistoryStaysValidAcrossReorder) {
+    layerManager_->createLayer("A");
+    layerManager_->createLayer("B");
+    LayerHandle a = layerManager_->getLayerHandle(1);
+
+    ASSERT_TRUE(historyManager_->executeCommand(std::make_unique<SetLayerOpacityCommand>(layerManager_.get(), 1, 0.25f)));
+    ASSERT_TRUE(historyManager_->executeCommand(std::make_unique<MoveLayerCommand>(layerManager_.get(), 1, 2)));
+    ASSERT_TRUE(historyManager_->executeCommand(std::make_unique<CreateLayerCommand>(layerManager_.get(), "C")));
+
+    EXPECT_FLOAT_EQ(layerManager_->getLayer(a)->getOpacity(), 0.25f);
+    EXPECT_EQ(layerManager_->getLayerIndex(a), 2);
+
+    ASSERT_TRUE(historyManager_->undo()); // Create
+    ASSERT_TRUE(historyManager_->undo()); // Move
+    EXPECT_EQ(layerManager_->getLayerIndex(a), 1);
+    ASSERT_TRUE(historyManager_->undo()); // Opacity
+    EXPECT_FLOAT_EQ(layerManager_->getLayer(a)->getOpacity(), 1.0f);
+
+    // Redo everything, the recreated layer keeps its handle
+    ASSERT_TRUE(historyManager_->redo());
+    ASSERT_TRUE(historyManager_->redo());
+    ASSERT_TRUE(historyManager_->redo());
+    EXPECT_EQ(layerManager_->getLayerCount(), 4u);
+    EXPECT_EQ(layerManager_->getLayerIndex(a), 2);
+    EXPECT_FLOAT_EQ(layerManager_->getLayer(a)->getOpacity(), 0.25f);
+}
+
+class CanvasLayerHandleTest : public ::testing::Test {
+protected:
+    std::unique_ptr<EventDispatcher> dispatcher_;
+    std::unique_ptr<HistoryManager> historyManager_;
+    std::unique_ptr<Canvas> canvas_;
+
+    void SetUp() override {
+        dispatcher_ = std::make_unique<EventDispatcher>();
+        historyManager_ = std::make_unique<HistoryManager>();
+        canvas_ = std::make_unique<Canvas>(Rectangle{0, 0, 200.0f, 150.0f}, dispatcher_.get(), historyManager_.get(), false);
+        canvas_->createBlankCanvas(200, 150, WHITE);
+    }
+};
+
+TEST_F(CanvasLayerHandleTest, HandlesFollowCanvasLayers) {
+    canvas_->addNewDrawingLayer("First");
+    canvas_->addNewDrawingLayer("Second");
+    int firstIndex = canvas_->getLayerCount() - 2;
+    LayerHandle first = canvas_->getLayerHandle(firstIndex);
+
+    canvas_->moveLayer(firstIndex, firstIndex + 1);
+    EXPECT_EQ(canvas_->getLayerIndex(first), firstIndex + 1);
+    ASSERT_NE(canvas_->getLayer(first), nullptr);
+    EXPECT_EQ(canvas_->getLayer(first)->name, "First");
+
+    canvas_->deleteLayer(firstIndex + 1);
+    EXPECT_EQ(canvas_->getLayer(first), nullptr);
+    EXPECT_EQ(canvas_->getLayerIndex(first), -1);
+}
+
+TEST_F(CanvasLayerHandleTest, DrawCommandUndoTargetsOriginalLayer) {
+    canvas_->addNewDrawingLayer("Target");
+    LayerHandle target = canvas_->getSelectedLayerHandle();
+
+    auto command = createDrawCommand(canvas_.get(), "Stroke");
+
+    // Paint into the layer as a stroke would
+    DrawingLayer* layer = canvas_->getLayer(target);
+    ASSERT_NE(layer, nullptr);
+    layer->texture->beginDrawing();
+    DrawRectangle(10, 10, 20, 20, RED);
+    layer->texture->endDrawing();
+    command->captureAfterState();
+
+    // Another layer on top changes every index before the undo
+    canvas_->addNewDrawingLayer("Other");
+    canvas_->moveLayer(canvas_->getLayerIndex(target), canvas_->getLayerCount() - 1);
+
+    ASSERT_TRUE(command->undo());
+    Image restored = canvas_->copyLayerImage(target);
+    ASSERT_NE(restored.data, nullptr);
+    EXPECT_EQ(GetImageColor(restored, 15, 15).a, 0);
+    UnloadImage(restored);
+
+    ASSERT_TRUE(command->execute());
+    Image redone = canvas_->copyLayerImage(target);
+    EXPECT_EQ(GetImageColor(redone, 15, 15).r, 255);
+    EXPECT_GT(GetImageColor(redone, 15, 15).a, 0);
+    UnloadImage(redone);
+}
+
+// Lookups must stay constant-time as the stack grows
+TEST_F(LayerHandleTest, HandleLookupPerformance) {
+    const int NUM_LAYERS = 200;
+    std::vector<LayerHandle> handles;
+    for (int i = 0; i < NUM_LAYERS; ++i)
+        handles.push_back(layerManager_->getLayerHandle(layerManager_->createLayer("Layer " + std::to_string(i))));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long sum = 0;
+    for (int round = 0; round < 1000; ++round) {
+        for (const LayerHandle& handle : handles)
+            sum += layerManager_->getLayerIndex(handle);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+    EXPECT_GT(sum, 0);
+    EXPECT_LT(duration.count(), 200);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <filesystem>
+#include <Utils/PngWriter.hpp>
+#include <Core/RaylibWrappers.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class PngWriterTest : public ::testing::Test {
+protected:
+    std::string pngPath_ = "/tmp/test_png_writer.png";
+
+    void TearDown() override {
+        std::filesystem::remove(pngPath_);
+    }
+
+    // Diagonal gradient with speckles: compressible, but not trivially
+    Image makeImage(int width, int height) {
+        Image image = GenImageColor(width, height, Color{0, 0, 0, 0});
+        auto* pixels = static_cast<unsigned char*>(image.data);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                unsigned char* pixel = pixels + (static_cast<size_t>(y) * width + x) * 4;
+                pixel[0] = static_cast<unsigned char>(x + y);
+                pixel[1] = static_cast<unsigned char>((x * 7 + y * 13) % 5 == 0 ? x * 31 : 0);
+                pixel[2] = static_cast<unsigned char>(255 - y);
+                pixel[3] = static_cast<unsigned char>(128 + (x % 128));
+            }
+        }
+        return image;
+    }
+
+    void expectSamePixels(const Image& expected, const Image& actual) {
+        ASSERT_EQ(actual.width, expected.width);
+        ASSERT_EQ(actual.height, expected.height);
+        for (int y = 0; y < expected.height; ++y) {
+            for (int x = 0; x < expected.width; ++x) {
+                const Color a = GetImageColor(expected, x, y);
+                const Color b = GetImageColor(actual, x, y);
+                ASSERT_TRUE(a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a) << "at " << x << "," << y;
+            }
+        }
+    }
+};
+
+TEST_F(PngWriterTest, RoundTripAcrossManyChunks) {
+    Image source = makeImage(300, 257);
+
+    // Tiny chunks put many seams, and their dictionaries, inside the image
+    PngWriter::Options options;
+    options.chunkBytes = 4096;
+    options.threads = 4;
+    std::vector<uint8_t> png;
+    ASSERT_TRUE(PngWriter::encode(source, png, options));
+
+    Image decoded = LoadImageFromMemory(".png", png.data(), static_cast<int>(png.size()));
+    ASSERT_NE(decoded.data, nullptr);
+    ImageFormat(&decoded, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    expectSamePixels(source, decoded);
+
+    UnloadImage(decoded);
+    UnloadImage(source);
+}
+
+TEST_F(PngWriterTest, EveryLevelDecodes) {
+    Image source = makeImage(128, 96);
+    size_t storedSize = 0;
+    for (int level : {0, 1, 6, 9}) {
+        PngWriter::Options options;
+        options.compressionLevel = level;
+        options.chunkBytes = 8192;
+        std::vector<uint8_t> png;
+        ASSERT_TRUE(PngWriter::encode(source, png, options));
+        if (level == 0)
+            storedSize = png.size();
+        else
+            EXPECT_LT(png.size(), storedSize);
+
+        Image decoded = LoadImageFromMemory(".png", png.data(), static_cast<int>(png.size()));
+        ASSERT_NE(decoded.data, nullptr) << "level " << level;
+        ImageFormat(&decoded, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        expectSamePixels(source, decoded);
+        UnloadImage(decoded);
+    }
+    UnloadImage(source);
+}
+
+TEST_F(PngWriterTest, OutputDoesNotDependOnThreadCount) {
+    Image source = makeImage(512, 300);
+    PngWriter::Options single;
+    single.threads = 1;
+    single.chunkBytes = 16 * 1024;
+    PngWriter::Options parallel = single;
+    parallel.threads = 8;
+
+    std::vector<uint8_t> a;
+    std::vector<uint8_t> b;
+    ASSERT_TRUE(PngWriter::encode(source, a, single));
+    ASSERT_TRUE(PngWriter::encode(source, b, parallel));
+    EXPECT_EQ(a, b);
+    UnloadImage(source);
+}
+
+TEST_F(PngWriterTest, ConvertsOtherFormats) {
+    Image source = GenImageColor(40, 30, Color{10, 20, 30, 255});
+    ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+    ASSERT_TRUE(PngWriter::write(source, pngPath_));
+
+    Image decoded = LoadImage(pngPath_.c_str());
+    ASSERT_NE(decoded.data, nullptr);
+    Color pixel = GetImageColor(decoded, 20, 15);
+    EXPECT_EQ(pixel.r, 10);
+    EXPECT_EQ(pixel.g, 20);
+    EXPECT_EQ(pixel.b, 30);
+    EXPECT_EQ(pixel.a, 255);
+    UnloadImage(decoded);
+    UnloadImage(source);
+}
+
+TEST_F(PngWriterTest, ImageResourceExportsThroughWriter) {
+    ImageResource image(makeImage(64, 64));
+    std::string actualPath;
+    ExportOptions options;
+    options.pngCompressionLevel = 9;
+    ASSERT_TRUE(image.exportToFile(pngPath_, actualPath, options));
+    EXPECT_EQ(actualPath, pngPath_);
+
+    Image decoded = LoadImage(pngPath_.c_str());
+    ASSERT_NE(decoded.data, nullptr);
+    ImageFormat(&decoded, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    expectSamePixels(*image, decoded);
+    UnloadImage(decoded);
+}
+
+namespace {
+
+void benchmarkExport(int size, const std::string& path)
+{
+    Image image = GenImageWhiteNoise(size, size, 0.1f);
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(ExportImage(image, path.c_str()));
+    auto raylibTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+    const auto raylibSize = std::filesystem::file_size(path);
+
+    start = std::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(PngWriter::write(image, path));
+    auto parallelTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+    const auto parallelSize = std::filesystem::file_size(path);
+
+    std::cout << size << "x" << size << " PNG export: ExportImage " << raylibTime.count() << " ms (" << raylibSize
+              << " bytes), PngWriter " << parallelTime.count() << " ms (" << parallelSize << " bytes) on "
+              << std::thread::hardware_concurrency() << " threads" << std::endl;
+
+    if (std::thread::hardware_concurrency() >= 2) {
+        EXPECT_LT(parallelTime.count(), raylibTime.count());
+    }
+    UnloadImage(image);
+}
+
+} // namespace
+
+TEST_F(PngWriterTest, Benchmark4k) {
+    benchmarkExport(4096, pngPath_);
+}
+
+// 1 GiB of pixels per copy; run with --gtest_also_run_disabled_tests
+TEST_F(PngWriterTest, DISABLED_Benchmark16k) {
+    benchmarkExport(16384, pngPath_);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <Utils/PolygonRasterizer.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class PolygonRasterizerTest : public ::testing::Test {
+protected:
+    // Even-odd crossing test, one point at a time
+    static bool contains(const std::vector<Vector2>& points, float x, float y) {
+        bool inside = false;
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+            const Vector2 a = points[i], b = points[j];
+            if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x)
+                inside = !inside;
+        }
+        return inside;
+    }
+
+    static double coveredArea(const SelectionMask& mask) {
+        double area = 0.0;
+        mask.forEachRun(Rectangle{0, 0, static_cast<float>(mask.getWidth()), static_cast<float>(mask.getHeight())}, true,
+                        [&area](int, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+            for (int x = x0; x <= x1; ++x)
+                area += (values ? values[x - x0] : uniform) / 255.0;
+        });
+        return area;
+    }
+
+    static std::vector<Vector2> circle(float cx, float cy, float radius, int count) {
+        std::vector<Vector2> points;
+        for (int i = 0; i < count; ++i) {
+            const float angle = 2.0f * PI * static_cast<float>(i) / static_cast<float>(count);
+            points.push_back({cx + radius * std::cos(angle), cy + radius * std::sin(angle)});
+        }
+        return points;
+    }
+};
+
+TEST_F(PolygonRasterizerTest, PixelAlignedRectangleIsExact) {
+    const std::vector<Vector2> square = {{10, 20}, {74, 20}, {74, 60}, {10, 60}};
+    for (bool antialias : {true, false}) {
+        const SelectionMask mask = PolygonRasterizer::rasterize(square, 100, 80, antialias);
+        EXPECT_TRUE(mask.isRectangle());
+        const Rectangle bounds = mask.getBounds();
+        EXPECT_EQ(bounds.x, 10.0f);
+        EXPECT_EQ(bounds.y, 20.0f);
+        EXPECT_EQ(bounds.width, 64.0f);
+        EXPECT_EQ(bounds.height, 40.0f);
+    }
+
+    // Clockwise or not makes no difference
+    const std::vector<Vector2> reversed(square.rbegin(), square.rend());
+    EXPECT_TRUE(PolygonRasterizer::rasterize(reversed, 100, 80).isRectangle());
+}
+
+TEST_F(PolygonRasterizerTest, EdgesGetPartialCoverage) {
+    // Half a pixel in on the left, a quarter on the top
+    const std::vector<Vector2> square = {{10.5f, 20.75f}, {30, 20.75f}, {30, 40}, {10.5f, 40}};
+    const SelectionMask mask = PolygonRasterizer::rasterize(square, 64, 64);
+    EXPECT_NEAR(mask.at(10, 30), 128, 1);
+    EXPECT_NEAR(mask.at(15, 20), 64, 1);
+    EXPECT_NEAR(mask.at(10, 20), 32, 1);
+    EXPECT_EQ(mask.at(15, 30), 255);
+    EXPECT_EQ(mask.at(9, 30), 0);
+
+    // Coverage adds up to the area, even along slanted edges
+    const std::vector<Vector2> triangle = {{3.3f, 5.1f}, {57.9f, 12.4f}, {21.6f, 49.8f}};
+    const double area = 0.5 * std::fabs((57.9 - 3.3) * (49.8 - 5.1) - (21.6 - 3.3) * (12.4 - 5.1));
+    EXPECT_NEAR(coveredArea(PolygonRasterizer::rasterize(triangle, 64, 64)), area, area * 0.005);
+}
+
+TEST_F(PolygonRasterizerTest, MatchesPointInPolygonAtPixelCentres) {
+    // Random self-intersecting polygons exercise crossings, even-odd pairing and clipping
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coordinate(-20.0f, 150.0f);
+    for (int trial = 0; trial < 20; ++trial) {
+        std::vector<Vector2> points;
+        for (int i = 0; i < 3 + trial; ++i)
+            points.push_back({coordinate(rng), coordinate(rng)});
+
+        const SelectionMask mask = PolygonRasterizer::rasterize(points, 131, 97, false);
+        size_t mismatches = 0;
+        for (int y = 0; y < 97; ++y) {
+            for (int x = 0; x < 131; ++x) {
+                const bool expected = contains(points, x + 0.5f, y + 0.5f);
+                mismatches += (mask.at(x, y) == 255) != expected ? 1 : 0;
+                EXPECT_TRUE(mask.at(x, y) == 0 || mask.at(x, y) == 255);
+            }
+        }
+        EXPECT_EQ(mismatches, 0u) << "trial " << trial;
+    }
+}
+
+TEST_F(PolygonRasterizerTest, SelfIntersectionsFollowEvenOdd) {
+    // Pentagram: the middle pentagon is crossed twice, so it stays out
+    std::vector<Vector2> star;
+    for (int i = 0; i < 5; ++i) {
+        const float angle = -PI / 2.0f + 4.0f * PI * static_cast<float>(i) / 5.0f;
+        star.push_back({50.0f + 40.0f * std::cos(angle), 50.0f + 40.0f * std::sin(angle)});
+    }
+    const SelectionMask mask = PolygonRasterizer::rasterize(star, 100, 100);
+    EXPECT_EQ(mask.at(50, 50), 0);
+    EXPECT_EQ(mask.at(50, 18), 255);
+}
+
+TEST_F(PolygonRasterizerTest, DegenerateInputSelectsNothing) {
+    EXPECT_TRUE(PolygonRasterizer::rasterize({{1, 1}, {5, 5}}, 10, 10).isEmpty());
+    EXPECT_TRUE(PolygonRasterizer::rasterize({{1, 1}, {5, 5}, {9, 9}}, 10, 10).isEmpty());
+    EXPECT_TRUE(PolygonRasterizer::rasterize({{1, 4}, {5, 4}, {9, 4}}, 10, 10).isEmpty());
+    EXPECT_TRUE(PolygonRasterizer::rasterize({{20, 20}, {30, 20}, {30, 30}}, 10, 10).isEmpty());
+    EXPECT_EQ(PolygonRasterizer::rasterize({{1, 1}, {5, 1}, {5, 5}}, 10, 10).getWidth(), 10);
+}
+
+TEST_F(PolygonRasterizerTest, LargeLasso) {
+    // A wobbly 10k-point lasso across most of an 8k image
+    constexpr int SIZE = 8192;
+    std::vector<Vector2> lasso = circle(4096.0f, 4096.0f, 3500.0f, 10000);
+    for (size_t i = 0; i < lasso.size(); ++i) {
+        const float wobble = 1.0f + 0.01f * std::sin(static_cast<float>(i) * 0.7f);
+        lasso[i] = {4096.0f + (lasso[i].x - 4096.0f) * wobble, 4096.0f + (lasso[i].y - 4096.0f) * wobble};
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    const SelectionMask mask = PolygonRasterizer::rasterize(lasso, SIZE, SIZE);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    EXPECT_EQ(mask.at(4096, 4096), 255);
+    EXPECT_EQ(mask.at(100, 100), 0);
+    EXPECT_LT(mask.getStoredTileCount(), 1000u);
+    std::cout << "rasterized a " << lasso.size() << "-point lasso on " << SIZE << "x" << SIZE << ": " << ms << " ms" << std::endl;
+
+    // Many vertices on a small circle: coverage still matches the area
+    const SelectionMask small = PolygonRasterizer::rasterize(circle(64.0f, 64.0f, 50.0f, 10000), 128, 128);
+    EXPECT_NEAR(coveredArea(small), PI * 50.0 * 50.0, PI * 50.0 * 50.0 * 0.005);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <filesystem>
+#include <Utils/ProjectFile.hpp>
+#include <Utils/ProjectTileStreamer.hpp>
+#include <UI/Canvas.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class ProjectFileTest : public ::testing::Test {
+protected:
+    std::string projectPath_ = "/tmp/test_project.epg";
+
+    void TearDown() override {
+        std::filesystem::remove(projectPath_);
+    }
+
+    // Background, a painted layer and a hidden, flipped, empty layer
+    DocumentSnapshot makeSnapshot(int width, int height) {
+        DocumentSnapshot snapshot(width, height);
+        snapshot.setBackground(makeSharedPixels(GenImageColor(width, height, Color{255, 255, 255, 255})), true);
+
+        Image painted = GenImageColor(width, height, Color{0, 0, 0, 0});
+        ImageDrawRectangle(&painted, 10, 20, 30, 40, Color{200, 10, 20, 255});
+        LayerSnapshot paintedLayer{makeSharedPixels(painted)};
+        paintedLayer.name = "Painted";
+        snapshot.addLayer(paintedLayer);
+
+        LayerSnapshot hiddenLayer{makeSharedPixels(GenImageColor(width, height, Color{0, 0, 0, 0}))};
+        hiddenLayer.name = "Hidden";
+        hiddenLayer.visible = false;
+        hiddenLayer.flippedHorizontal = true;
+        snapshot.addLayer(hiddenLayer);
+        return snapshot;
+    }
+};
+
+TEST_F(ProjectFileTest, RecognisesExtension) {
+    EXPECT_TRUE(ProjectFile::isProjectPath("/tmp/art.epg"));
+    EXPECT_TRUE(ProjectFile::isProjectPath("/tmp/ART.EPG"));
+    EXPECT_FALSE(ProjectFile::isProjectPath("/tmp/art.png"));
+    EXPECT_FALSE(ProjectFile::isProjectPath("/tmp/epg"));
+}
+
+TEST_F(ProjectFileTest, RoundTripKeepsLayers) {
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(300, 200), projectPath_, 64));
+
+    auto reader = ProjectReader::open(projectPath_);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->getWidth(), 300);
+    EXPECT_EQ(reader->getHeight(), 200);
+    EXPECT_EQ(reader->getTileSize(), 64);
+    EXPECT_EQ(reader->getTilesX(), 5);
+    EXPECT_EQ(reader->getTilesY(), 4);
+    ASSERT_EQ(reader->getLayerCount(), 3u);
+
+    EXPECT_TRUE(reader->getLayerInfo(0).isBackground);
+    EXPECT_TRUE(reader->getLayerInfo(0).visible);
+    EXPECT_EQ(reader->getLayerInfo(1).name, "Painted");
+    EXPECT_TRUE(reader->getLayerInfo(1).visible);
+    EXPECT_EQ(reader->getLayerInfo(2).name, "Hidden");
+    EXPECT_FALSE(reader->getLayerInfo(2).visible);
+    EXPECT_TRUE(reader->getLayerInfo(2).flippedHorizontal);
+    EXPECT_FALSE(reader->getLayerInfo(2).flippedVertical);
+
+    Image painted = reader->decodeLayer(1);
+    ASSERT_NE(painted.data, nullptr);
+    Color inside = GetImageColor(painted, 15, 25);
+    EXPECT_EQ(inside.r, 200);
+    EXPECT_EQ(inside.g, 10);
+    EXPECT_EQ(inside.a, 255);
+    EXPECT_EQ(GetImageColor(painted, 100, 100).a, 0);
+    UnloadImage(painted);
+
+    Image background = reader->decodeLayer(0);
+    EXPECT_EQ(GetImageColor(background, 299, 199).r, 255);
+    UnloadImage(background);
+}
+
+TEST_F(ProjectFileTest, TransparentTilesAreNotStored) {
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(256, 256), projectPath_, 64));
+    auto reader = ProjectReader::open(projectPath_);
+    ASSERT_NE(reader, nullptr);
+
+    // The painted rectangle lives in the first tile only
+    EXPECT_FALSE(reader->isTileEmpty(1, 0, 0));
+    EXPECT_TRUE(reader->isTileEmpty(1, 3, 3));
+    for (int ty = 0; ty < reader->getTilesY(); ++ty)
+        for (int tx = 0; tx < reader->getTilesX(); ++tx)
+            EXPECT_TRUE(reader->isTileEmpty(2, tx, ty));
+
+    std::vector<uint8_t> pixels;
+    ASSERT_TRUE(reader->decodeTile(2, 1, 1, pixels));
+    EXPECT_EQ(pixels.size(), 64u * 64u * 4u);
+    EXPECT_EQ(pixels[3], 0);
+}
+
+TEST_F(ProjectFileTest, RejectsInvalidFiles) {
+    std::string error;
+    EXPECT_EQ(ProjectReader::open("/tmp/does_not_exist.epg", &error), nullptr);
+    EXPECT_FALSE(error.empty());
+
+    {
+        std::ofstream out(projectPath_, std::ios::binary);
+        out << "definitely not a project file, but long enough for a header";
+    }
+    error.clear();
+    EXPECT_EQ(ProjectReader::open(projectPath_, &error), nullptr);
+    EXPECT_FALSE(error.empty());
+
+    // Truncating a valid project breaks the tables at the end of the file
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(128, 128), projectPath_, 64));
+    std::filesystem::resize_file(projectPath_, std::filesystem::file_size(projectPath_) - 8);
+    EXPECT_EQ(ProjectReader::open(projectPath_), nullptr);
+}
+
+TEST_F(ProjectFileTest, RejectsOffsetsThatWrap) {
+    const auto patch = [this](std::streamoff at, const void* bytes, size_t size) {
+        std::fstream file(projectPath_, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(at);
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+    };
+
+    // A tile index offset so large that offset + size wraps back under the file size
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(128, 128), projectPath_, 64));
+    const uint64_t wrapping = ~uint64_t{0} - 15;
+    patch(offsetof(ProjectFile::FileHeader, tileIndexOffset), &wrapping, sizeof(wrapping));
+    EXPECT_EQ(ProjectReader::open(projectPath_), nullptr);
+
+    // Dimensions that do not fit in an int
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(128, 128), projectPath_, 64));
+    const uint32_t huge = 0x80000000u;
+    patch(offsetof(ProjectFile::FileHeader, width), &huge, sizeof(huge));
+    EXPECT_EQ(ProjectReader::open(projectPath_), nullptr);
+
+    // Dimensions that fit on their own but would need terabytes once decoded
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(128, 128), projectPath_, 64));
+    const uint32_t side = 1u << 20;
+    patch(offsetof(ProjectFile::FileHeader, width), &side, sizeof(side));
+    patch(offsetof(ProjectFile::FileHeader, height), &side, sizeof(side));
+    std::string error;
+    EXPECT_EQ(ProjectReader::open(projectPath_, &error), nullptr);
+    EXPECT_EQ(error.rfind("Project too large", 0), 0u) << error;
+
+    // A tile entry pointing past the end, by way of the same wrap
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(128, 128), projectPath_, 64));
+    ProjectFile::FileHeader header;
+    {
+        std::ifstream in(projectPath_, std::ios::binary);
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    const uint64_t entryOffset = ~uint64_t{0} - 4;
+    patch(static_cast<std::streamoff>(header.tileIndexOffset + 4 * sizeof(ProjectFile::TileEntry)), &entryOffset, sizeof(entryOffset));
+    auto reader = ProjectReader::open(projectPath_);
+    ASSERT_NE(reader, nullptr);
+    std::vector<uint8_t> pixels;
+    EXPECT_FALSE(reader->decodeTile(1, 0, 0, pixels));
+}
+
+TEST_F(ProjectFileTest, StreamerDeliversEveryTileInOrder) {
+    ASSERT_TRUE(ProjectFile::write(makeSnapshot(256, 256), projectPath_, 64));
+    std::shared_ptr<const ProjectReader> reader = ProjectReader::open(projectPath_);
+    ASSERT_NE(reader, nullptr);
+
+    std::vector<ProjectTileStreamer::TileRequest> order;
+    for (int ty = reader->getTilesY() - 1; ty >= 0; --ty)
+        for (int tx = 0; tx < reader->getTilesX(); ++tx)
+            order.push_back({0, tx, ty});
+
+    // A queue of two tiles forces the worker to wait on the consumer
+    ProjectTileStreamer streamer(reader, order, 2 * 64 * 64 * 4);
+    std::vector<ProjectTileStreamer::DecodedTile> received;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!streamer.isFinished() && std::chrono::steady_clock::now() < deadline) {
+        for (auto& tile : streamer.takeReady(64 * 64 * 4))
+            received.push_back(std::move(tile));
+    }
+
+    ASSERT_EQ(received.size(), order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(received[i].request.tileX, order[i].tileX);
+        EXPECT_EQ(received[i].request.tileY, order[i].tileY);
+        EXPECT_TRUE(received[i].valid);
+    }
+    EXPECT_FLOAT_EQ(streamer.getProgress(), 1.0f);
+}
+
+TEST_F(ProjectFileTest, CanvasRoundTrip) {
+    EventDispatcher dispatcher;
+    bool saved = false;
+    dispatcher.subscribe<ImageSavedEvent>([&](const ImageSavedEvent& event) { saved = event.success; });
+
+    Canvas source(Rectangle{0, 0, 400.0f, 300.0f}, &dispatcher, nullptr, false);
+    source.createBlankCanvas(400, 300, WHITE);
+    source.addNewDrawingLayer("Ink");
+    DrawingLayer* ink = source.getLayer(1);
+    ink->texture->beginDrawing();
+    DrawRectangle(50, 60, 20, 20, BLUE);
+    ink->texture->endDrawing();
+    source.setLayerVisible(0, false);
+
+    ASSERT_TRUE(source.saveImage(projectPath_));
+    source.waitForPendingSaves();
+    ASSERT_TRUE(saved);
+
+    Canvas target(Rectangle{0, 0, 400.0f, 300.0f}, &dispatcher, nullptr, false);
+    ASSERT_TRUE(target.openProject(projectPath_));
+    EXPECT_TRUE(target.isStreamingProject());
+    target.finishProjectStreaming();
+    EXPECT_FALSE(target.isStreamingProject());
+
+    ASSERT_EQ(target.getLayerCount(), 2);
+    EXPECT_EQ(target.getLayerName(0), "Layer 1");
+    EXPECT_FALSE(target.isLayerVisible(0));
+    EXPECT_EQ(target.getLayerName(1), "Ink");
+    EXPECT_TRUE(target.isLayerVisible(1));
+
+    Image restored = target.copyLayerImage(target.getLayerHandle(1));
+    ASSERT_NE(restored.data, nullptr);
+    EXPECT_EQ(GetImageColor(restored, 55, 65).b, 255);
+    EXPECT_EQ(GetImageColor(restored, 5, 5).a, 0);
+    UnloadImage(restored);
+}
+
+// Opening only parses the header and tables, tile data is left on disk
+TEST_F(ProjectFileTest, OpenPerformance) {
+    const int SIZE = 2048;
+    DocumentSnapshot snapshot(SIZE, SIZE);
+    for (int i = 0; i < 8; ++i) {
+        Image noise = GenImageWhiteNoise(SIZE, SIZE, 0.5f);
+        ImageFormat(&noise, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        snapshot.addLayer(LayerSnapshot{makeSharedPixels(noise)});
+    }
+    ASSERT_TRUE(ProjectFile::write(snapshot, projectPath_));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto reader = ProjectReader::open(projectPath_);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->getLayerCount(), 8u);
+    EXPECT_LT(duration.count(), 50);
+}
+
+} // namespace EpiGimp
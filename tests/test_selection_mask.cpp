@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+#include <Core/SelectionMask.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class SelectionMaskTest : public ImageTest {
+protected:
+    // Disc with a soft one-pixel edge, so masks hold partial values too
+    static SelectionMask disc(int width, int height, float cx, float cy, float radius) {
+        SelectionMask mask(width, height);
+        std::vector<uint8_t> values(static_cast<size_t>(width) * height, 0);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const float distance = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+                const float coverage = std::clamp(radius - distance + 0.5f, 0.0f, 1.0f);
+                values[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(coverage * 255.0f);
+            }
+        }
+        mask.setRegion(Rectangle{0, 0, static_cast<float>(width), static_cast<float>(height)}, values.data(), width);
+        return mask;
+    }
+
+    static std::vector<uint8_t> dense(const SelectionMask& mask) {
+        std::vector<uint8_t> values;
+        for (int y = 0; y < mask.getHeight(); ++y) {
+            for (int x = 0; x < mask.getWidth(); ++x)
+                values.push_back(mask.at(x, y));
+        }
+        return values;
+    }
+};
+
+TEST_F(SelectionMaskTest, RectangleStoresOnlyItsEdgeTiles) {
+    const SelectionMask mask = SelectionMask::fromRect(1000, 700, Rectangle{100, 50, 500, 300});
+
+    EXPECT_EQ(mask.at(100, 50), 255);
+    EXPECT_EQ(mask.at(599, 349), 255);
+    EXPECT_EQ(mask.at(600, 349), 0);
+    EXPECT_EQ(mask.at(99, 200), 0);
+    EXPECT_EQ(mask.at(-1, 0), 0);
+
+    const Rectangle bounds = mask.getBounds();
+    EXPECT_EQ(bounds.x, 100.0f);
+    EXPECT_EQ(bounds.y, 50.0f);
+    EXPECT_EQ(bounds.width, 500.0f);
+    EXPECT_EQ(bounds.height, 300.0f);
+    EXPECT_TRUE(mask.isRectangle());
+
+    // Far fewer stored tiles than the 16 x 11 grid, and none at all once aligned
+    EXPECT_LT(mask.getStoredTileCount(), 40u);
+    EXPECT_EQ(SelectionMask::fromRect(1000, 700, Rectangle{64, 128, 512, 256}).getStoredTileCount(), 0u);
+
+    SelectionMask all(1000, 700);
+    all.fill(255);
+    EXPECT_EQ(all.getStoredTileCount(), 0u);
+    EXPECT_TRUE(all.isRectangle());
+    EXPECT_TRUE(SelectionMask(1000, 700).isEmpty());
+}
+
+TEST_F(SelectionMaskTest, BooleanOperationsMatchPerPixelReference) {
+    // Odd sizes leave partial edge tiles
+    const int width = 301, height = 197;
+    const SelectionMask a = disc(width, height, 120.0f, 90.0f, 70.0f);
+    const SelectionMask b = disc(width, height, 180.0f, 110.0f, 60.0f);
+    const std::vector<uint8_t> va = dense(a), vb = dense(b);
+
+    const std::pair<SelectionMode, uint8_t (*)(uint8_t, uint8_t)> cases[] = {
+        {SelectionMode::Add, [](uint8_t x, uint8_t y) { return std::max(x, y); }},
+        {SelectionMode::Intersect, [](uint8_t x, uint8_t y) { return std::min(x, y); }},
+        {SelectionMode::Subtract, [](uint8_t x, uint8_t y) { return static_cast<uint8_t>(x > y ? x - y : 0); }},
+        {SelectionMode::Replace, [](uint8_t, uint8_t y) { return y; }},
+    };
+    for (const auto& [mode, reference] : cases) {
+        SelectionMask result = a;
+        result.combine(b, mode);
+        const std::vector<uint8_t> actual = dense(result);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < actual.size(); ++i)
+            mismatches += actual[i] != reference(va[i], vb[i]) ? 1 : 0;
+        EXPECT_EQ(mismatches, 0u) << "mode " << static_cast<int>(mode);
+    }
+
+    SelectionMask inverted = a;
+    inverted.invert();
+    const std::vector<uint8_t> vi = dense(inverted);
+    for (size_t i = 0; i < vi.size(); ++i)
+        ASSERT_EQ(vi[i], 255 - va[i]);
+    inverted.invert();
+    EXPECT_EQ(dense(inverted), va);
+
+    // Masks of another size are refused and leave the target alone
+    SelectionMask untouched = a;
+    untouched.combine(SelectionMask(10, 10), SelectionMode::Replace);
+    EXPECT_EQ(untouched.getWidth(), width);
+}
+
+TEST_F(SelectionMaskTest, UniformTilesStayCompact) {
+    SelectionMask left = SelectionMask::fromRect(512, 512, Rectangle{0, 0, 256, 512});
+    const SelectionMask right = SelectionMask::fromRect(512, 512, Rectangle{256, 0, 256, 512});
+
+    left.combine(right, SelectionMode::Add);
+    EXPECT_EQ(left.getStoredTileCount(), 0u);
+    EXPECT_TRUE(left.isRectangle());
+
+    left.combine(right, SelectionMode::Subtract);
+    EXPECT_EQ(left.getBounds().width, 256.0f);
+    left.combine(right, SelectionMode::Intersect);
+    EXPECT_TRUE(left.isEmpty());
+    EXPECT_EQ(left.getStoredTileCount(), 0u);
+
+    // Spans then compact: tiles that ended up uniform give their storage back
+    SelectionMask spans(128, 128);
+    for (int y = 0; y < 64; ++y)
+        spans.setSpan(y, 0, 63, 255);
+    spans.setSpan(70, 3, 5, 255);
+    EXPECT_EQ(spans.getStoredTileCount(), 2u);
+    spans.compact();
+    EXPECT_EQ(spans.getStoredTileCount(), 1u);
+    EXPECT_FALSE(spans.isRectangle());
+}
+
+TEST_F(SelectionMaskTest, RunsSkipEmptyTilesAndCoverEveryPixel) {
+    SelectionMask mask = SelectionMask::fromRect(400, 300, Rectangle{10, 10, 100, 50});
+    mask.combine(disc(400, 300, 300.0f, 200.0f, 40.0f), SelectionMode::Add);
+
+    std::vector<int> visits(400 * 300, 0);
+    size_t selected = 0;
+    mask.forEachRun(Rectangle{0, 0, 400, 300}, true, [&](int y, int x0, int x1, const uint8_t* values, uint8_t uniform) {
+        for (int x = x0; x <= x1; ++x) {
+            visits[y * 400 + x]++;
+            EXPECT_EQ(values ? values[x - x0] : uniform, mask.at(x, y));
+            selected += mask.at(x, y) ? 1 : 0;
+        }
+    });
+    size_t expected = 0;
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 400; ++x) {
+            expected += mask.at(x, y) ? 1 : 0;
+            EXPECT_LE(visits[y * 400 + x], 1);
+            if (mask.at(x, y)) {
+                EXPECT_EQ(visits[y * 400 + x], 1);
+            }
+        }
+    }
+    EXPECT_EQ(selected, expected);
+
+    // Uniform neighbours merge: a full-width row of an empty mask is one call without skipping
+    int calls = 0;
+    SelectionMask(400, 300).forEachRun(Rectangle{0, 5, 400, 1}, false, [&calls](int, int x0, int x1, const uint8_t* values, uint8_t) {
+        calls++;
+        EXPECT_EQ(x0, 0);
+        EXPECT_EQ(x1, 399);
+        EXPECT_EQ(values, nullptr);
+    });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST_F(SelectionMaskTest, OutlineIsClosedAndCached) {
+    SelectionMask mask = SelectionMask::fromRect(200, 200, Rectangle{20, 30, 100, 60});
+    const std::vector<Vector2>& outline = mask.getOutline();
+    ASSERT_FALSE(outline.empty());
+    ASSERT_EQ(outline.size() % 2, 0u);
+
+    // Every endpoint is shared by exactly two segments
+    std::map<std::pair<float, float>, int> ends;
+    for (const auto& point : outline) {
+        ends[{point.x, point.y}]++;
+        EXPECT_GE(point.x, 19.5f);
+        EXPECT_LE(point.x, 120.5f);
+        EXPECT_GE(point.y, 29.5f);
+        EXPECT_LE(point.y, 90.5f);
+    }
+    for (const auto& [point, count] : ends)
+        EXPECT_EQ(count, 2) << point.first << "," << point.second;
+
+    // Same storage until the mask changes
+    EXPECT_EQ(&mask.getOutline(), &outline);
+    const size_t before = outline.size();
+    mask.combine(disc(200, 200, 160.0f, 160.0f, 20.0f), SelectionMode::Add);
+    EXPECT_GT(mask.getOutline().size(), before);
+
+    // A selection touching the image edge still closes along it
+    SelectionMask all(50, 40);
+    all.fill(255);
+    EXPECT_EQ(all.getOutline().size(), static_cast<size_t>(2 * 2 * (50 + 40)));
+}
+
+TEST_F(SelectionMaskTest, PixelClipping) {
+    const int width = 8, height = 4;
+    SelectionMask mask(width, height);
+    mask.fillRect(Rectangle{2, 1, 4, 2}, 255);
+    mask.setSpan(3, 0, 0, 128);
+
+    // Fill coverage clipped by the selection, rows in texture order
+    std::vector<uint8_t> coverage(width * height, 255);
+    mask.clipCoverage(coverage.data(), width, Rectangle{0, 0, 8, 4}, true);
+    EXPECT_EQ(coverage[(height - 1 - 1) * width + 2], 255);   // Image row 1
+    EXPECT_EQ(coverage[(height - 1 - 0) * width + 2], 0);     // Image row 0
+    EXPECT_EQ(coverage[0], 128);                              // Image row 3, half selected
+
+    // A stroke over everything keeps only its selected part
+    Image& original = make(width, height, Color{0, 0, 255, 255});
+    Image& edited = make(width, height, Color{255, 0, 0, 255});
+    mask.restoreOutside(edited, original, Rectangle{0, 0, 8, 4}, false);
+    const auto* pixels = static_cast<const unsigned char*>(edited.data);
+    EXPECT_EQ(pixels[(1 * width + 2) * 4 + 0], 255);   // Selected stays red
+    EXPECT_EQ(pixels[(0 * width + 0) * 4 + 2], 255);   // Outside back to blue
+    EXPECT_NEAR(pixels[(3 * width + 0) * 4 + 0], 128, 1);
+
+    // Deleting fades alpha by coverage
+    mask.clearCovered(original, false);
+    const auto* cleared = static_cast<const unsigned char*>(original.data);
+    EXPECT_EQ(cleared[(1 * width + 3) * 4 + 3], 0);
+    EXPECT_EQ(cleared[(0 * width + 3) * 4 + 3], 255);
+    EXPECT_NEAR(cleared[(3 * width + 0) * 4 + 3], 127, 1);
+
+    const Rectangle flipped = SelectionMask::toBottomUp(Rectangle{1, 0, 2, 1}, height);
+    EXPECT_EQ(flipped.y, 3.0f);
+}
+
+TEST_F(SelectionMaskTest, RegionRestoreMatchesWholeImageRestore) {
+    const int width = 300, height = 200;
+    SelectionMask mask(width, height);
+    mask.fillRect(Rectangle{40, 30, 150, 100}, 255);
+    for (int y = 60; y < 90; ++y)
+        mask.setSpan(y, 180, 220, static_cast<uint8_t>(y * 3));
+    mask.compact();
+
+    // The same stroke restored on the whole layer and on just its region, rows in texture order
+    const Rectangle region = {170, 50, 80, 60};
+    const Rectangle stored = SelectionMask::toBottomUp(region, height);
+    auto crop = [&](const Image& image) -> Image& {
+        Image& part = make(static_cast<int>(region.width), static_cast<int>(region.height), BLANK);
+        for (int y = 0; y < part.height; ++y)
+            std::memcpy(static_cast<unsigned char*>(part.data) + y * part.width * 4,
+                        static_cast<const unsigned char*>(image.data) + ((y + static_cast<int>(stored.y)) * width + static_cast<int>(stored.x)) * 4,
+                        part.width * 4);
+        return part;
+    };
+    Image& original = make(width, height, Color{0, 0, 255, 255});
+    Image& edited = make(width, height, Color{255, 0, 0, 255});
+    const Image& originalPart = crop(original);
+    Image& editedPart = crop(edited);
+    mask.restoreOutside(edited, original, region, true);
+    mask.restoreOutsideRegion(editedPart, originalPart, region, true);
+
+    const Image& expected = crop(edited);
+    EXPECT_EQ(std::memcmp(expected.data, editedPart.data, static_cast<size_t>(region.width * region.height * 4)), 0);
+
+    // Images that do not match the region are left alone
+    Image& wrong = make(10, 10, BLANK);
+    mask.restoreOutsideRegion(wrong, originalPart, region, true);
+    EXPECT_EQ(static_cast<const unsigned char*>(wrong.data)[3], 0);
+}
+
+TEST_F(SelectionMaskTest, LargeMaskOperations) {
+    constexpr int SIZE = 8192;
+    SelectionMask a = SelectionMask::fromRect(SIZE, SIZE, Rectangle{100, 100, 5000, 6000});
+    const SelectionMask b = SelectionMask::fromRect(SIZE, SIZE, Rectangle{3000, 2000, 5000, 6000});
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    a.combine(b, SelectionMode::Add);
+    a.invert();
+    a.combine(b, SelectionMode::Subtract);
+    const size_t segments = a.getOutline().size() / 2;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    EXPECT_GT(segments, 0u);
+    EXPECT_LT(a.getStoredTileCount(), 1000u);
+    std::cout << "union, invert, subtract and outline on " << SIZE << "x" << SIZE << ": " << ms << " ms, "
+              << a.getStoredTileCount() << " stored tiles" << std::endl;
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <Utils/SharedImage.hpp>
+#include <Utils/QoiCodec.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class SharedImageTest : public ::testing::Test {
+protected:
+    std::string name_ = "/epigimp_test_" + std::to_string(::getpid());
+
+    void TearDown() override {
+        SharedImageBuffer::unlink(name_);
+        std::filesystem::remove("/tmp/test_shared_image.qoi");
+    }
+
+    static void fillPattern(uint8_t* pixels, size_t count) {
+        auto* words = reinterpret_cast<uint32_t*>(pixels);
+        for (size_t i = 0; i < count; ++i)
+            words[i] = static_cast<uint32_t>(i * 2654435761u);
+    }
+
+    // Rewrite the shared header the way a misbehaving peer would, bypassing SharedImageBuffer
+    template <typename Patch>
+    void patchHeader(Patch patch) {
+        const int fd = ::open(("/dev/shm" + name_).c_str(), O_RDWR);
+        ASSERT_GE(fd, 0);
+        SharedImageHeader header;
+        ASSERT_EQ(::pread(fd, &header, sizeof(header), 0), static_cast<ssize_t>(sizeof(header)));
+        patch(header);
+        ASSERT_EQ(::pwrite(fd, &header, sizeof(header), 0), static_cast<ssize_t>(sizeof(header)));
+        ::close(fd);
+    }
+
+    static bool matchesPattern(const uint8_t* pixels, size_t count) {
+        const auto* words = reinterpret_cast<const uint32_t*>(pixels);
+        for (size_t i = 0; i < count; ++i) {
+            if (words[i] != static_cast<uint32_t>(i * 2654435761u))
+                return false;
+        }
+        return true;
+    }
+};
+
+TEST_F(SharedImageTest, NamedBufferIsVisibleToOtherMappings) {
+    std::string error;
+    auto writer = SharedImageBuffer::create(name_, 64, 32, &error);
+    ASSERT_NE(writer, nullptr) << error;
+    EXPECT_EQ(writer->getStride(), 64u * 4u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(writer->pixels()) % SharedImageBuffer::DATA_ALIGNMENT, 0u);
+
+    Image source = GenImageColor(64, 32, Color{1, 2, 3, 4});
+    ASSERT_TRUE(writer->write(source));
+
+    auto reader = SharedImageBuffer::open(name_, false, &error);
+    ASSERT_NE(reader, nullptr) << error;
+    EXPECT_EQ(reader->getWidth(), 64);
+    EXPECT_EQ(reader->getHeight(), 32);
+    EXPECT_EQ(reader->header().generation, 1u);
+    EXPECT_EQ(std::memcmp(reader->pixels(), source.data, 64 * 32 * 4), 0);
+    EXPECT_EQ(reader->mutablePixels(), nullptr);
+
+    // Same pages, different mapping: later writes show up without another copy
+    writer->mutablePixels()[0] = 200;
+    EXPECT_EQ(reader->pixels()[0], 200);
+    EXPECT_NE(reader->pixels(), writer->pixels());
+    UnloadImage(source);
+}
+
+TEST_F(SharedImageTest, CreateRefusesExistingNamesAndBadInput) {
+    auto first = SharedImageBuffer::create(name_, 8, 8);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(SharedImageBuffer::create(name_, 8, 8), nullptr);
+    EXPECT_EQ(SharedImageBuffer::create("no-slash", 8, 8), nullptr);
+    EXPECT_EQ(SharedImageBuffer::create("/bad", 0, 8), nullptr);
+    EXPECT_EQ(SharedImageBuffer::open("/epigimp_missing_buffer"), nullptr);
+
+    // publish() replaces an older object of the same name
+    Image image = GenImageColor(16, 4, RED);
+    auto published = SharedImage::publish(name_, image);
+    ASSERT_NE(published, nullptr);
+    EXPECT_EQ(SharedImageBuffer::open(name_)->getWidth(), 16);
+    UnloadImage(image);
+}
+
+TEST_F(SharedImageTest, RejectsCorruptHeaders) {
+    auto buffer = SharedImageBuffer::create(name_, 16, 16);
+    ASSERT_NE(buffer, nullptr);
+
+    // Claim more rows than the object holds
+    patchHeader([](SharedImageHeader& header) { header.height = 1000; });
+
+    std::string error;
+    EXPECT_EQ(SharedImageBuffer::open(name_, false, &error), nullptr);
+    EXPECT_NE(error.find("invalid"), std::string::npos);
+}
+
+TEST_F(SharedImageTest, HeaderRewrittenAfterOpenIsIgnored) {
+    auto buffer = SharedImageBuffer::create(name_, 16, 16);
+    ASSERT_NE(buffer, nullptr);
+    auto reader = SharedImageBuffer::open(name_);
+    ASSERT_NE(reader, nullptr);
+    const uint8_t* pixels = reader->pixels();
+
+    // A peer points the pixels past the end of the mapping
+    patchHeader([](SharedImageHeader& header) {
+        header.height = 1000;
+        header.dataOffset = 1 << 30;
+    });
+    EXPECT_EQ(reader->getHeight(), 16);
+    EXPECT_EQ(reader->pixels(), pixels);
+    Image copied = reader->copy();
+    EXPECT_EQ(copied.height, 16);
+    UnloadImage(copied);
+
+    // Only a generation change makes refresh() look again, and it keeps the old header if the new one is bad
+    EXPECT_TRUE(reader->refresh());
+    patchHeader([](SharedImageHeader& header) { header.generation = 7; });
+    std::string error;
+    EXPECT_FALSE(reader->refresh(&error));
+    EXPECT_NE(error.find("invalid"), std::string::npos);
+    EXPECT_EQ(reader->getHeight(), 16);
+    EXPECT_EQ(reader->pixels(), pixels);
+
+    // A valid rewrite is picked up
+    patchHeader([](SharedImageHeader& header) {
+        header.height = 8;
+        header.dataOffset = SharedImageBuffer::DATA_ALIGNMENT;
+        header.generation = 8;
+    });
+    EXPECT_EQ(reader->liveGeneration(), 8u);
+    EXPECT_TRUE(reader->refresh());
+    EXPECT_EQ(reader->getHeight(), 8);
+    EXPECT_EQ(reader->header().generation, 8u);
+}
+
+TEST_F(SharedImageTest, AnonymousBufferOpensThroughProc) {
+    auto buffer = SharedImageBuffer::createAnonymous(32, 32);
+    ASSERT_NE(buffer, nullptr);
+    fillPattern(buffer->mutablePixels(), 32 * 32);
+
+    auto reader = SharedImageBuffer::open(buffer->getProcPath());
+    ASSERT_NE(reader, nullptr);
+    EXPECT_TRUE(matchesPattern(reader->pixels(), 32 * 32));
+
+    Image view = reader->view();
+    EXPECT_EQ(view.data, reader->pixels());
+    EXPECT_EQ(view.format, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+}
+
+TEST_F(SharedImageTest, AnotherProcessReadsAndWritesInPlace) {
+    auto buffer = SharedImageBuffer::create(name_, 256, 256);
+    ASSERT_NE(buffer, nullptr);
+    fillPattern(buffer->mutablePixels(), 256 * 256);
+
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        auto mapped = SharedImageBuffer::open(name_, true);
+        const bool ok = mapped && matchesPattern(mapped->pixels(), 256 * 256);
+        if (ok)
+            mapped->mutablePixels()[0] = 42;
+        ::_exit(ok ? 0 : 1);
+    }
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(buffer->pixels()[0], 42);
+}
+
+// 5120 x 5120 RGBA8 is 100 MiB; nothing is encoded and nothing touches disk
+TEST_F(SharedImageTest, RoundTrip100MB) {
+    const int side = 5120;
+    const size_t pixels = static_cast<size_t>(side) * side;
+
+    Image source = GenImageColor(side, side, BLANK);
+    fillPattern(static_cast<uint8_t*>(source.data), pixels);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto published = SharedImage::publish(name_, source);
+    ASSERT_NE(published, nullptr);
+    auto reader = SharedImageBuffer::open(name_);
+    ASSERT_NE(reader, nullptr);
+    Image view = reader->view();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+
+    ASSERT_NE(view.data, nullptr);
+    EXPECT_EQ(view.width, side);
+    EXPECT_EQ(view.height, side);
+    EXPECT_EQ(std::memcmp(view.data, source.data, pixels * 4), 0);
+
+    std::cout << "100 MiB publish + map: " << elapsed.count() << " ms" << std::endl;
+    EXPECT_LT(elapsed.count(), 2000);
+    UnloadImage(source);
+}
+
+TEST_F(SharedImageTest, CommandLineHelper) {
+    Image image = GenImageColor(40, 30, Color{9, 8, 7, 255});
+    ASSERT_TRUE(QoiCodec::write(image, "/tmp/test_shared_image.qoi"));
+
+    EXPECT_EQ(SharedImage::runCommand({"--shm", "put", name_, "/tmp/test_shared_image.qoi"}), 0);
+    EXPECT_EQ(SharedImage::runCommand({"--shm", "info", name_}), 0);
+
+    auto buffer = SharedImageBuffer::open(name_);
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(std::memcmp(buffer->pixels(), image.data, 40 * 30 * 4), 0);
+
+    std::filesystem::remove("/tmp/test_shared_image.qoi");
+    EXPECT_EQ(SharedImage::runCommand({"--shm", "get", name_, "/tmp/test_shared_image.qoi"}), 0);
+    Image back = QoiCodec::read("/tmp/test_shared_image.qoi");
+    ASSERT_NE(back.data, nullptr);
+    EXPECT_EQ(std::memcmp(back.data, image.data, 40 * 30 * 4), 0);
+
+    EXPECT_EQ(SharedImage::runCommand({"--shm", "remove", name_}), 0);
+    EXPECT_EQ(SharedImageBuffer::open(name_), nullptr);
+    EXPECT_EQ(SharedImage::runCommand({"--shm", "bogus"}), 2);
+    UnloadImage(back);
+    UnloadImage(image);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,336 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include <Utils/StreamingDecoder.hpp>
+#include <Utils/PngWriter.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class StreamingDecoderTest : public ::testing::Test {
+protected:
+    std::string directory_ = "/tmp/test_streaming_decoder";
+
+    void SetUp() override {
+        std::filesystem::remove_all(directory_);
+        std::filesystem::create_directories(directory_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory_);
+    }
+
+    static void putBE32(std::vector<uint8_t>& out, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+
+    static void putLE(std::vector<uint8_t>& out, uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    static void chunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+        putBE32(png, static_cast<uint32_t>(data.size()));
+        const size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        putBE32(png, static_cast<uint32_t>(crc32(0, png.data() + start, static_cast<uInt>(png.size() - start))));
+    }
+
+    // Scanlines already carry their filter byte; the IDAT is split in two to cross a chunk boundary
+    static std::vector<uint8_t> buildPng(int width, int height, int depth, int colorType, const std::vector<uint8_t>& scanlines,
+                                         const std::vector<uint8_t>& palette = {}, const std::vector<uint8_t>& trns = {},
+                                         int interlace = 0) {
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        std::vector<uint8_t> header;
+        putBE32(header, static_cast<uint32_t>(width));
+        putBE32(header, static_cast<uint32_t>(height));
+        header.insert(header.end(), {static_cast<uint8_t>(depth), static_cast<uint8_t>(colorType), 0, 0,
+                                     static_cast<uint8_t>(interlace)});
+        chunk(png, "IHDR", header);
+        if (!palette.empty())
+            chunk(png, "PLTE", palette);
+        if (!trns.empty())
+            chunk(png, "tRNS", trns);
+
+        uLongf size = compressBound(static_cast<uLong>(scanlines.size()));
+        std::vector<uint8_t> compressed(size);
+        compress(compressed.data(), &size, scanlines.data(), static_cast<uLong>(scanlines.size()));
+        compressed.resize(size);
+        const size_t half = compressed.size() / 2;
+        chunk(png, "IDAT", std::vector<uint8_t>(compressed.begin(), compressed.begin() + half));
+        chunk(png, "IDAT", std::vector<uint8_t>(compressed.begin() + half, compressed.end()));
+        chunk(png, "IEND", {});
+        return png;
+    }
+
+    std::string save(const std::string& name, const std::vector<uint8_t>& bytes) const {
+        const std::string path = directory_ + "/" + name;
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+
+    static std::vector<uint8_t> decodeAll(const std::string& path, int maxWidth = 0, int maxHeight = 0) {
+        std::string error;
+        auto decoder = StreamingDecoder::open(path, &error);
+        EXPECT_NE(decoder, nullptr) << error;
+        if (!decoder)
+            return {};
+        Image image = StreamingDecoder::decode(*decoder, maxWidth, maxHeight);
+        EXPECT_NE(image.data, nullptr);
+        if (!image.data)
+            return {};
+        const auto* data = static_cast<const uint8_t*>(image.data);
+        std::vector<uint8_t> pixels(data, data + static_cast<size_t>(image.width) * image.height * 4);
+        UnloadImage(image);
+        return pixels;
+    }
+
+    static long peakResidentKb() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0)
+                return std::atol(line.c_str() + 6);
+        }
+        return -1;
+    }
+};
+
+TEST_F(StreamingDecoderTest, RoundTripsPngWriterOutput) {
+    const int width = 37, height = 23;
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint8_t>((i * 7 + i / 13) & 0xFF);
+    Image image{pixels.data(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    const std::string path = directory_ + "/roundtrip.png";
+    ASSERT_TRUE(PngWriter::write(image, path));
+
+    auto decoder = StreamingDecoder::open(path);
+    ASSERT_NE(decoder, nullptr);
+    EXPECT_EQ(decoder->getWidth(), width);
+    EXPECT_EQ(decoder->getHeight(), height);
+    EXPECT_EQ(decodeAll(path), pixels);
+}
+
+TEST_F(StreamingDecoderTest, DecodesEveryFilterType) {
+    // RGB8, 3 pixels per row, one filter type per row (None, Sub, Up, Average, Paeth)
+    const int width = 3, height = 5;
+    std::vector<uint8_t> raw(static_cast<size_t>(width) * 3 * height);
+    for (size_t i = 0; i < raw.size(); ++i)
+        raw[i] = static_cast<uint8_t>(i * 37 + 11);
+
+    const size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> scanlines;
+    for (int y = 0; y < height; ++y) {
+        scanlines.push_back(static_cast<uint8_t>(y));
+        for (size_t i = 0; i < stride; ++i) {
+            const int a = i >= 3 ? raw[y * stride + i - 3] : 0;
+            const int b = y > 0 ? raw[(y - 1) * stride + i] : 0;
+            const int c = (i >= 3 && y > 0) ? raw[(y - 1) * stride + i - 3] : 0;
+            int predictor = 0;
+            if (y == 1) predictor = a;
+            if (y == 2) predictor = b;
+            if (y == 3) predictor = (a + b) / 2;
+            if (y == 4) {
+                const int p = a + b - c;
+                const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            }
+            scanlines.push_back(static_cast<uint8_t>(raw[y * stride + i] - predictor));
+        }
+    }
+
+    std::vector<uint8_t> pixels = decodeAll(save("filters.png", buildPng(width, height, 8, 2, scanlines)));
+    ASSERT_EQ(pixels.size(), static_cast<size_t>(width) * height * 4);
+    for (int i = 0; i < width * height; ++i) {
+        EXPECT_EQ(pixels[i * 4], raw[i * 3]);
+        EXPECT_EQ(pixels[i * 4 + 1], raw[i * 3 + 1]);
+        EXPECT_EQ(pixels[i * 4 + 2], raw[i * 3 + 2]);
+        EXPECT_EQ(pixels[i * 4 + 3], 255);
+    }
+}
+
+TEST_F(StreamingDecoderTest, DecodesLowBitDepthsAndTransparency) {
+    // 1-bit gray: 10 pixels need two bytes per row
+    std::vector<uint8_t> gray = decodeAll(save("gray1.png", buildPng(10, 1, 1, 0, {0, 0b10100000, 0b01000000})));
+    ASSERT_EQ(gray.size(), 40u);
+    EXPECT_EQ(gray[0], 255);
+    EXPECT_EQ(gray[4], 0);
+    EXPECT_EQ(gray[8], 255);
+    EXPECT_EQ(gray[9 * 4], 255);
+    EXPECT_EQ(gray[9 * 4 + 3], 255);
+
+    // 4-bit palette with tRNS alpha on entry 1
+    std::vector<uint8_t> palette = {10, 20, 30, 200, 100, 50};
+    std::vector<uint8_t> paletted = decodeAll(save("palette4.png", buildPng(3, 1, 4, 3, {0, 0x01, 0x10}, palette, {255, 128})));
+    ASSERT_EQ(paletted.size(), 12u);
+    EXPECT_EQ(std::vector<uint8_t>(paletted.begin(), paletted.begin() + 4), (std::vector<uint8_t>{10, 20, 30, 255}));
+    EXPECT_EQ(std::vector<uint8_t>(paletted.begin() + 4, paletted.begin() + 8), (std::vector<uint8_t>{200, 100, 50, 128}));
+    EXPECT_EQ(paletted[8], 200);
+
+    // 16-bit RGB with a colour key: only the exact 16-bit value is transparent
+    std::vector<uint8_t> rgb16 = {0, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBD};
+    std::vector<uint8_t> keyed = decodeAll(save("rgb16.png", buildPng(2, 1, 16, 2, rgb16, {}, {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC})));
+    ASSERT_EQ(keyed.size(), 8u);
+    EXPECT_EQ(std::vector<uint8_t>(keyed.begin(), keyed.begin() + 4), (std::vector<uint8_t>{0x12, 0x56, 0x9A, 0}));
+    EXPECT_EQ(keyed[7], 255);
+
+    // 8-bit gray + alpha
+    std::vector<uint8_t> grayAlpha = decodeAll(save("ga.png", buildPng(1, 1, 8, 4, {0, 77, 99})));
+    EXPECT_EQ(grayAlpha, (std::vector<uint8_t>{77, 77, 77, 99}));
+}
+
+TEST_F(StreamingDecoderTest, DecodesBmpInBothRowOrders) {
+    // 24-bit bottom-up, 2x2: rows padded to 8 bytes
+    std::vector<uint8_t> bmp = {'B', 'M'};
+    putLE(bmp, 14 + 40 + 16, 4);
+    putLE(bmp, 0, 4);
+    putLE(bmp, 14 + 40, 4);
+    putLE(bmp, 40, 4);
+    putLE(bmp, 2, 4);
+    putLE(bmp, 2, 4);
+    putLE(bmp, 1, 2);
+    putLE(bmp, 24, 2);
+    for (int i = 0; i < 6; ++i)
+        putLE(bmp, 0, 4);
+    // Bottom row first: blue, green; then the top row: red, white
+    bmp.insert(bmp.end(), {255, 0, 0, 0, 255, 0, 0, 0});
+    bmp.insert(bmp.end(), {0, 0, 255, 255, 255, 255, 0, 0});
+    std::vector<uint8_t> pixels = decodeAll(save("bottomup.bmp", bmp));
+    EXPECT_EQ(pixels, (std::vector<uint8_t>{255, 0, 0, 255, 255, 255, 255, 255, 0, 0, 255, 255, 0, 255, 0, 255}));
+
+    // 32-bit top-down with alpha bitfields in a V4 header
+    std::vector<uint8_t> v4 = {'B', 'M'};
+    putLE(v4, 14 + 108 + 8, 4);
+    putLE(v4, 0, 4);
+    putLE(v4, 14 + 108, 4);
+    putLE(v4, 108, 4);
+    putLE(v4, 1, 4);
+    putLE(v4, static_cast<uint32_t>(-2), 4);
+    putLE(v4, 1, 2);
+    putLE(v4, 32, 2);
+    putLE(v4, 3, 4);
+    for (int i = 0; i < 5; ++i)
+        putLE(v4, 0, 4);
+    putLE(v4, 0x00FF0000, 4);
+    putLE(v4, 0x0000FF00, 4);
+    putLE(v4, 0x000000FF, 4);
+    putLE(v4, 0xFF000000, 4);
+    v4.resize(14 + 108, 0);
+    putLE(v4, 0x80102030, 4);
+    putLE(v4, 0x00405060, 4);
+    std::vector<uint8_t> masked = decodeAll(save("topdown.bmp", v4));
+    EXPECT_EQ(masked, (std::vector<uint8_t>{0x10, 0x20, 0x30, 0x80, 0x40, 0x50, 0x60, 0}));
+}
+
+TEST_F(StreamingDecoderTest, RejectsWhatItCannotStream) {
+    std::string error;
+    EXPECT_EQ(StreamingDecoder::open(save("interlaced.png", buildPng(1, 1, 8, 0, {0, 1}, {}, {}, 1)), &error), nullptr);
+    EXPECT_NE(error.find("interlaced"), std::string::npos);
+    EXPECT_EQ(StreamingDecoder::open(save("garbage.png", {1, 2, 3})), nullptr);
+    EXPECT_EQ(StreamingDecoder::open(directory_ + "/missing.bmp"), nullptr);
+    EXPECT_FALSE(StreamingDecoder::canStream("photo.jpg"));
+    EXPECT_TRUE(StreamingDecoder::canStream("photo.PNG"));
+
+    // Data ends early: the header opens, decoding fails
+    std::vector<uint8_t> truncated = buildPng(4, 4, 8, 0, std::vector<uint8_t>(2 * 5, 0));
+    auto decoder = StreamingDecoder::open(save("short.png", truncated));
+    ASSERT_NE(decoder, nullptr);
+    EXPECT_EQ(StreamingDecoder::decode(*decoder).data, nullptr);
+}
+
+TEST_F(StreamingDecoderTest, DownscalesWhileDecoding) {
+    // 4x2 -> 2x1: left box is opaque red and transparent, right box grey shades
+    std::vector<uint8_t> scanlines = {
+        0, 255, 0, 0, 255,  0, 0, 255, 0,  100, 100, 100, 255,  200, 200, 200, 255,
+        0, 255, 0, 0, 255,  9, 9, 9, 0,    100, 100, 100, 255,  200, 200, 200, 255,
+    };
+    const std::string path = save("scaled.png", buildPng(4, 2, 8, 6, scanlines));
+    auto decoder = StreamingDecoder::open(path);
+    ASSERT_NE(decoder, nullptr);
+
+    int calls = 0;
+    Image image = StreamingDecoder::decode(*decoder, 2, 2, [&calls](float) { calls++; return true; });
+    ASSERT_NE(image.data, nullptr);
+    EXPECT_EQ(image.width, 2);
+    EXPECT_EQ(image.height, 1);
+    EXPECT_GE(calls, 1);
+    const auto* data = static_cast<const uint8_t*>(image.data);
+    EXPECT_EQ(std::vector<uint8_t>(data, data + 8), (std::vector<uint8_t>{255, 0, 0, 128, 150, 150, 150, 255}));
+    UnloadImage(image);
+
+    // Aborting from the progress callback frees everything and returns nothing
+    auto again = StreamingDecoder::open(path);
+    EXPECT_EQ(StreamingDecoder::decode(*again, 0, 0, [](float) { return false; }).data, nullptr);
+}
+
+TEST_F(StreamingDecoderTest, LargeImageNeverExistsAtFullSize) {
+    // Written row by row with a streaming deflate, so the test itself stays small too
+    const int width = 6000, height = 6000;
+    const std::string path = directory_ + "/large.png";
+    {
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        std::vector<uint8_t> header;
+        putBE32(header, width);
+        putBE32(header, height);
+        header.insert(header.end(), {8, 6, 0, 0, 0});
+        chunk(png, "IHDR", header);
+
+        z_stream zs{};
+        ASSERT_EQ(deflateInit(&zs, 1), Z_OK);
+        std::vector<uint8_t> row(static_cast<size_t>(width) * 4 + 1, 0);
+        std::vector<uint8_t> out(1 << 20);
+        for (int y = 0; y <= height; ++y) {
+            for (int x = 0; x < width; ++x)
+                row[1 + x * 4] = static_cast<uint8_t>(x + y);
+            zs.next_in = row.data();
+            zs.avail_in = y < height ? static_cast<uInt>(row.size()) : 0;
+            const int flush = y < height ? Z_NO_FLUSH : Z_FINISH;
+            do {
+                zs.next_out = out.data();
+                zs.avail_out = static_cast<uInt>(out.size());
+                deflate(&zs, flush);
+                if (zs.avail_out != out.size())
+                    chunk(png, "IDAT", std::vector<uint8_t>(out.begin(), out.end() - zs.avail_out));
+            } while (zs.avail_out == 0);
+        }
+        deflateEnd(&zs);
+        chunk(png, "IEND", {});
+        save("large.png", png);
+    }
+
+    // Reset the high-water mark, where the kernel allows it
+    {
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+        if (!clearRefs || peakResidentKb() < 0)
+            GTEST_SKIP() << "peak RSS cannot be reset here";
+    }
+    const long before = peakResidentKb();
+
+    auto decoder = StreamingDecoder::open(path);
+    ASSERT_NE(decoder, nullptr);
+    Image image = StreamingDecoder::decode(*decoder, 1024, 1024);
+    ASSERT_NE(image.data, nullptr);
+    EXPECT_EQ(image.width, 1024);
+    EXPECT_EQ(image.height, 1024);
+    const long growthKb = peakResidentKb() - before;
+    UnloadImage(image);
+
+    // The full image would be 137 MiB; the fitted result is 4 MiB
+    const long fullKb = static_cast<long>(width) * height * 4 / 1024;
+    std::cout << "Peak RSS growth: " << growthKb << " KiB (full image " << fullKb << " KiB)" << std::endl;
+    EXPECT_LT(growthKb, fullKb / 8);
+}
+
+} // namespace EpiGimp
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+#include <raylib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Core/JobSystem.hpp>
+#include <Utils/ThumbnailCache.hpp>
+#include <Utils/QoiCodec.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class ThumbnailCacheTest : public ::testing::Test {
+protected:
+    std::string directory_ = "/tmp/test_thumbnail_cache";
+    std::string images_ = "/tmp/test_thumbnail_images";
+
+    void SetUp() override {
+        std::filesystem::remove_all(directory_);
+        std::filesystem::remove_all(images_);
+        std::filesystem::create_directories(images_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory_);
+        std::filesystem::remove_all(images_);
+    }
+
+    std::string writeImage(const std::string& name, int width, int height, Color color) {
+        Image image = GenImageColor(width, height, color);
+        const std::string path = images_ + "/" + name;
+        EXPECT_TRUE(QoiCodec::write(image, path));
+        UnloadImage(image);
+        return path;
+    }
+
+    // Stand-in for the dialog's frame loop: request the same rows until they are all settled
+    static bool waitForTextures(ThumbnailCache& cache, const std::vector<std::string>& paths) {
+        for (int frame = 0; frame < 2000; ++frame) {
+            cache.update(64);
+            bool done = true;
+            for (const auto& path : paths) {
+                if (!cache.request(path, 1, 1) && !cache.hasFailed(path, 1, 1))
+                    done = false;
+            }
+            if (done)
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return false;
+    }
+};
+
+TEST_F(ThumbnailCacheTest, DownscaleKeepsAspectAndAverages) {
+    // Left half red, right half blue, 400 x 100
+    Image source = GenImageColor(400, 100, Color{255, 0, 0, 255});
+    auto* pixels = static_cast<uint8_t*>(source.data);
+    for (int y = 0; y < 100; ++y) {
+        for (int x = 200; x < 400; ++x) {
+            uint8_t* p = pixels + (y * 400 + x) * 4;
+            p[0] = 0;
+            p[2] = 255;
+        }
+    }
+
+    Image small = ThumbnailCache::downscale(source, 96);
+    ASSERT_NE(small.data, nullptr);
+    EXPECT_EQ(small.width, 96);
+    EXPECT_EQ(small.height, 24);
+
+    Color left = GetImageColor(small, 0, 0);
+    Color right = GetImageColor(small, 95, 23);
+    EXPECT_EQ(left.r, 255);
+    EXPECT_EQ(left.b, 0);
+    EXPECT_EQ(right.r, 0);
+    EXPECT_EQ(right.b, 255);
+    EXPECT_EQ(right.a, 255);
+
+    // Already small enough: a plain copy
+    Image tiny = ThumbnailCache::downscale(small, 96);
+    EXPECT_EQ(tiny.width, 96);
+    EXPECT_NE(tiny.data, small.data);
+
+    UnloadImage(tiny);
+    UnloadImage(small);
+    UnloadImage(source);
+}
+
+TEST_F(ThumbnailCacheTest, DownscaleIgnoresColourOfTransparentPixels) {
+    Image source = GenImageColor(64, 64, Color{0, 0, 0, 0});
+    auto* pixels = static_cast<uint8_t*>(source.data);
+    for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 32; ++x) {
+            uint8_t* p = pixels + (y * 64 + x) * 4;
+            p[0] = 255;
+            p[3] = 255;
+        }
+    }
+
+    Image small = ThumbnailCache::downscale(source, 1);
+    ASSERT_NE(small.data, nullptr);
+    Color average = GetImageColor(small, 0, 0);
+    EXPECT_EQ(average.r, 255);
+    EXPECT_NEAR(average.a, 128, 1);
+    UnloadImage(small);
+    UnloadImage(source);
+}
+
+TEST_F(ThumbnailCacheTest, KeyChangesWithSizeAndTime) {
+    const std::string key = ThumbnailCache::cacheKey("/a.png", 100, 5);
+    EXPECT_EQ(key.size(), 16u);
+    EXPECT_EQ(key, ThumbnailCache::cacheKey("/a.png", 100, 5));
+    EXPECT_NE(key, ThumbnailCache::cacheKey("/a.png", 101, 5));
+    EXPECT_NE(key, ThumbnailCache::cacheKey("/a.png", 100, 6));
+    EXPECT_NE(key, ThumbnailCache::cacheKey("/b.png", 100, 5));
+}
+
+TEST_F(ThumbnailCacheTest, DecodesInBackgroundAndFillsDiskCache) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 6; ++i)
+        paths.push_back(writeImage("image" + std::to_string(i) + ".qoi", 300, 200, Color{10, 20, 30, 255}));
+
+    {
+        ThumbnailCache cache(directory_, 64, 2);
+        EXPECT_EQ(cache.request(paths[0], 1, 1), nullptr);
+        ASSERT_TRUE(waitForTextures(cache, paths));
+        EXPECT_EQ(cache.getTextureCount(), paths.size());
+
+        const Texture2D* texture = cache.request(paths[0], 1, 1);
+        ASSERT_NE(texture, nullptr);
+        EXPECT_EQ(texture->width, 64);
+        EXPECT_EQ(texture->height, 43);
+    }
+
+    const std::string cached = directory_ + "/" + ThumbnailCache::cacheKey(paths[0], 1, 1) + ".qoi";
+    ASSERT_TRUE(std::filesystem::exists(cached));
+
+    // A fresh cache (next session) reads the small file even when the original is gone
+    std::filesystem::remove_all(images_);
+    ThumbnailCache again(directory_, 64, 2);
+    ASSERT_TRUE(waitForTextures(again, paths));
+    EXPECT_FALSE(again.hasFailed(paths[0], 1, 1));
+    EXPECT_EQ(again.getTextureCount(), paths.size());
+}
+
+TEST_F(ThumbnailCacheTest, UndecodableFilesFail) {
+    const std::string path = images_ + "/broken.png";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("not a png", file);
+    std::fclose(file);
+
+    ThumbnailCache cache(directory_, 64, 1);
+    ASSERT_TRUE(waitForTextures(cache, {path}));
+    EXPECT_TRUE(cache.hasFailed(path, 1, 1));
+    EXPECT_EQ(cache.request(path, 1, 1), nullptr);
+    EXPECT_EQ(cache.getTextureCount(), 0u);
+}
+
+TEST_F(ThumbnailCacheTest, RowsScrolledAwayAreDropped) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 200; ++i)
+        paths.push_back(writeImage("row" + std::to_string(i) + ".qoi", 512, 512, BLUE));
+
+    // One frame asks for everything, then the list scrolls to the last row only
+    ThumbnailCache cache(directory_, 32, 1);
+    for (const auto& path : paths)
+        cache.request(path, 1, 1);
+    for (int frame = 0; frame < 2000 && !cache.isIdle(); ++frame) {
+        cache.update(64);
+        cache.request(paths.back(), 1, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_TRUE(cache.isIdle());
+    EXPECT_NE(cache.request(paths.back(), 1, 1), nullptr);
+    EXPECT_LT(cache.getTextureCount(), paths.size() / 2);
+    std::cout << "Decoded " << cache.getTextureCount() << " of " << paths.size() << " requested rows" << std::endl;
+}
+
+TEST_F(ThumbnailCacheTest, EvictsLeastRecentlyShown) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 8; ++i)
+        paths.push_back(writeImage("evict" + std::to_string(i) + ".qoi", 16, 16, GREEN));
+
+    ThumbnailCache cache(directory_, 16, 2, 4);
+    ASSERT_TRUE(waitForTextures(cache, {paths.begin(), paths.begin() + 4}));
+    EXPECT_EQ(cache.getTextureCount(), 4u);
+
+    // Scroll to the other half; the first four are no longer on screen and get evicted
+    ASSERT_TRUE(waitForTextures(cache, {paths.begin() + 4, paths.end()}));
+    cache.update();
+    cache.update();
+    EXPECT_EQ(cache.getTextureCount(), 4u);
+    for (int i = 4; i < 8; ++i)
+        EXPECT_NE(cache.request(paths[i], 1, 1), nullptr);
+}
+
+TEST_F(ThumbnailCacheTest, DiskCacheIsTrimmedOldestFirst) {
+    // Thumbnails left by earlier sessions, the first ones the oldest
+    std::filesystem::create_directories(directory_);
+    const auto now = std::filesystem::file_time_type::clock::now();
+    for (int i = 0; i < 20; ++i) {
+        const std::string old = directory_ + "/old" + std::to_string(i) + ".qoi";
+        std::FILE* file = std::fopen(old.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        std::fwrite(std::string(1000, 'x').data(), 1, 1000, file);
+        std::fclose(file);
+        std::filesystem::last_write_time(old, now - std::chrono::hours(100 - i));
+    }
+
+    const std::string path = writeImage("fresh.qoi", 64, 64, RED);
+    ThumbnailCache cache(directory_, 32, 1, ThumbnailCache::DEFAULT_CAPACITY, 8000);
+    ASSERT_TRUE(waitForTextures(cache, {path}));
+
+    uint64_t total = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_))
+        total += entry.file_size();
+    EXPECT_LE(total, 8000u);
+    EXPECT_TRUE(std::filesystem::exists(directory_ + "/" + ThumbnailCache::cacheKey(path, 1, 1) + ".qoi"));
+    EXPECT_FALSE(std::filesystem::exists(directory_ + "/old0.qoi"));
+    EXPECT_TRUE(std::filesystem::exists(directory_ + "/old19.qoi"));
+}
+
+TEST_F(ThumbnailCacheTest, DecodersLeaveWorkersForOtherJobs) {
+    ThumbnailCache cache(directory_);
+    EXPECT_GE(cache.getDecoderLimit(), 1u);
+    EXPECT_LE(cache.getDecoderLimit(), std::max(1u, JobSystem::shared().getWorkerCount() / 2));
+
+    // More rows than one decode batch still all finish
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < ThumbnailCache::DECODE_BATCH * 3; ++i)
+        paths.push_back(writeImage("batch" + std::to_string(i) + ".qoi", 32, 32, GREEN));
+    ASSERT_TRUE(waitForTextures(cache, paths));
+    EXPECT_EQ(cache.getTextureCount(), paths.size());
+}
+
+// Requests for a screenful of rows must stay far below a 60 fps frame, whatever the folder size
+TEST_F(ThumbnailCacheTest, FrameCostOfScrollingLargeFolder) {
+    ThumbnailCache cache(directory_, 64, 1);
+    const int entries = 5000;
+    const int visible = 12;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int top = 0; top + visible <= entries; top += 10) {
+        cache.update();
+        for (int row = top; row < top + visible; ++row)
+            cache.request(images_ + "/missing" + std::to_string(row) + ".png", 1, 1);
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    const double frames = entries / 10.0;
+
+    std::cout << "Average frame cost while scrolling: " << elapsed / frames * 1000.0 << " us" << std::endl;
+    EXPECT_LT(elapsed / frames, 2.0);
+}
+
+} // namespace EpiGimp
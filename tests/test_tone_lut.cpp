@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <Utils/Filters.hpp>
+#include <Utils/ToneLut.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class ToneLutTest : public ImageTest {
+protected:
+    static const uint8_t* bytes(const Image& image) { return static_cast<const uint8_t*>(image.data); }
+};
+
+TEST_F(ToneLutTest, LevelsStretchAndBend) {
+    EXPECT_TRUE(ToneLut::identity().isIdentity());
+    EXPECT_TRUE(ToneLut::levels(0, 255, 1.0f).isIdentity());
+
+    const ToneLut::Table stretched = ToneLut::levels(50, 150, 1.0f);
+    EXPECT_EQ(stretched.channels[0][0], 0);
+    EXPECT_EQ(stretched.channels[0][50], 0);
+    EXPECT_EQ(stretched.channels[1][100], 128);
+    EXPECT_EQ(stretched.channels[2][150], 255);
+    EXPECT_EQ(stretched.channels[2][200], 255);
+    EXPECT_EQ(stretched.channels[3][100], 100);   // Alpha passes through
+
+    EXPECT_GT(ToneLut::levels(0, 255, 2.0f).channels[0][64], 64);
+    EXPECT_LT(ToneLut::levels(0, 255, 0.5f).channels[0][64], 64);
+
+    // Output range, and inverted by swapping it
+    EXPECT_EQ(ToneLut::levels(0, 255, 1.0f, 20, 220).channels[0][0], 20);
+    EXPECT_EQ(ToneLut::levels(0, 255, 1.0f, 20, 220).channels[0][255], 220);
+    EXPECT_EQ(ToneLut::levels(0, 255, 1.0f, 255, 0).channels[0][100], 155);
+}
+
+TEST_F(ToneLutTest, CurvesAreSmoothAndMonotone) {
+    EXPECT_TRUE(ToneLut::curves({Vector2{0, 0}, Vector2{255, 255}}).isIdentity());
+    EXPECT_TRUE(ToneLut::curves({Vector2{0, 0}}).isIdentity());
+
+    // A steep S never turns back or leaves the range between its points
+    const ToneLut::Table s = ToneLut::curves({Vector2{255, 255}, Vector2{0, 0}, Vector2{100, 20}, Vector2{140, 240}});
+    EXPECT_EQ(s.channels[0][100], 20);
+    EXPECT_EQ(s.channels[0][140], 240);
+    for (int v = 1; v < 256; ++v)
+        ASSERT_GE(s.channels[0][v], s.channels[0][v - 1]) << v;
+
+    // Flat outside the end points
+    const ToneLut::Table clipped = ToneLut::curves({Vector2{40, 30}, Vector2{200, 220}});
+    EXPECT_EQ(clipped.channels[0][0], 30);
+    EXPECT_EQ(clipped.channels[0][255], 220);
+}
+
+TEST_F(ToneLutTest, InvertPosterizeThreshold) {
+    EXPECT_TRUE(ToneLut::then(ToneLut::invert(), ToneLut::invert()).isIdentity());
+    EXPECT_EQ(ToneLut::invert().channels[0][10], 245);
+
+    for (int levels : {2, 3, 4, 16}) {
+        const ToneLut::Table table = ToneLut::posterize(levels);
+        const std::set<uint8_t> values(table.channels[0].begin(), table.channels[0].end());
+        EXPECT_EQ(values.size(), static_cast<size_t>(levels));
+        EXPECT_EQ(*values.begin(), 0);
+        EXPECT_EQ(*values.rbegin(), 255);
+    }
+
+    const ToneLut::Table threshold = ToneLut::threshold(100);
+    EXPECT_EQ(threshold.channels[1][99], 0);
+    EXPECT_EQ(threshold.channels[1][100], 255);
+    EXPECT_EQ(threshold.channels[3][99], 99);
+}
+
+TEST_F(ToneLutTest, MapMatchesTableInEveryLane) {
+    // Distinct tables per channel, alpha included, catch bytes landing in the wrong lane
+    ToneLut::Table table;
+    for (int ch = 0; ch < 4; ++ch)
+        for (int v = 0; v < 256; ++v)
+            table.channels[ch][v] = static_cast<uint8_t>(v * (2 * ch + 3) + 17 * ch);
+
+    const Image& source = noise(37, 23, 1);
+    Image& result = make(37, 23, BLANK);
+    ToneLut::map(source, result, table, Rectangle{0, 0, 37, 23});
+    for (int i = 0; i < 37 * 23 * 4; ++i)
+        ASSERT_EQ(bytes(result)[i], table.channels[i % 4][bytes(source)[i]]) << i;
+
+    // In place, within a region that starts and ends mid-row
+    Image& image = noise(37, 23, 1);
+    ToneLut::apply(image, table, Rectangle{3.5f, 2, 29, 18});
+    for (int y = 0; y < 23; ++y) {
+        for (int x = 0; x < 37; ++x) {
+            const bool inside = x >= 3 && x < 33 && y >= 2 && y < 20;
+            for (int ch = 0; ch < 4; ++ch) {
+                const uint8_t before = bytes(source)[(y * 37 + x) * 4 + ch];
+                ASSERT_EQ(bytes(image)[(y * 37 + x) * 4 + ch], inside ? table.channels[ch][before] : before) << x << "," << y;
+            }
+        }
+    }
+
+    // Mismatched sizes and regions off the image do nothing
+    Image& small = make(4, 4, Color{1, 2, 3, 4});
+    ToneLut::map(source, small, table, Rectangle{0, 0, 4, 4});
+    ToneLut::apply(small, table, Rectangle{10, 10, 4, 4});
+    EXPECT_EQ(bytes(small)[0], 1);
+}
+
+TEST_F(ToneLutTest, Histogram) {
+    Image& image = make(50, 40, Color{100, 100, 100, 255});
+    for (int x = 0; x < 50; ++x)
+        static_cast<Color*>(image.data)[x] = Color{255, 255, 255, 255};
+    const std::array<uint32_t, 256> counts = ToneLut::histogram(image);
+    EXPECT_EQ(counts[100], 50u * 39u);
+    EXPECT_EQ(counts[255], 50u);
+}
+
+TEST_F(ToneLutTest, ToneFilters) {
+    LayerFilter levels = Filters::levels(0, 255, 1.0f);
+    ASSERT_TRUE(levels.isValid());
+    ASSERT_EQ(levels.settings.size(), 4u);
+    EXPECT_EQ(levels.reach(levels.amount), 0);
+
+    // The settings feed the table
+    levels.settings[0].value = 100.0f;
+    Image& image = make(8, 8, Color{90, 180, 255, 200});
+    Filters::run(levels, image, Rectangle{0, 0, 8, 8}, levels.amount);
+    EXPECT_EQ(bytes(image)[0], 0);
+    EXPECT_EQ(bytes(image)[1], 132);
+    EXPECT_EQ(bytes(image)[2], 255);
+    EXPECT_EQ(bytes(image)[3], 200);
+
+    Filters::run(Filters::invert(), image, Rectangle{0, 0, 8, 8}, 0.0f);
+    EXPECT_EQ(bytes(image)[0], 255);
+    Filters::run(Filters::threshold(), image, Rectangle{0, 0, 8, 8}, 128.0f);
+    EXPECT_EQ(bytes(image)[0], 255);
+    EXPECT_EQ(bytes(image)[1], 0);
+    Filters::run(Filters::posterize(), image, Rectangle{0, 0, 8, 8}, 2.0f);
+    EXPECT_EQ(bytes(image)[2], 0);
+    EXPECT_TRUE(Filters::curves(0.0f).table(0.0f, {}).isIdentity());
+}
+
+TEST_F(ToneLutTest, LargeLayer) {
+    constexpr int SIZE = 4096;
+    Image& image = noise(SIZE, SIZE, 2);
+    const Image& source = copy(image);
+    const ToneLut::Table table = ToneLut::then(ToneLut::levels(20, 230, 1.4f), ToneLut::curves({Vector2{0, 0}, Vector2{64, 40}, Vector2{192, 215}, Vector2{255, 255}}));
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    ToneLut::apply(image, table, Rectangle{0, 0, SIZE, SIZE});
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "levels and curves over " << SIZE << "x" << SIZE << ": " << ms << " ms ("
+              << SIZE * static_cast<double>(SIZE) / ms / 1000.0 << " MP/s)" << std::endl;
+
+    // The vector path must agree with a plain table lookup on every byte
+    size_t mismatches = 0;
+    for (size_t i = 0; i < static_cast<size_t>(SIZE) * SIZE * 4; ++i)
+        mismatches += bytes(image)[i] != table.channels[i % 4][bytes(source)[i]];
+    EXPECT_EQ(mismatches, 0u);
+}
+
+} // namespace EpiGimp
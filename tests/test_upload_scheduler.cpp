@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <Core/UploadScheduler.hpp>
+#include "test_globals.hpp"
+
+namespace EpiGimp {
+
+class UploadSchedulerTest : public ::testing::Test {
+protected:
+    // Only the id and size matter; UpdateTextureRec never sees a real GL texture here
+    static Texture2D fakeTexture(unsigned id, int width, int height) {
+        Texture2D texture{};
+        texture.id = id;
+        texture.width = width;
+        texture.height = height;
+        texture.mipmaps = 1;
+        texture.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        return texture;
+    }
+
+    static SharedPixels pixelsFor(const Texture2D& texture) {
+        return makeSharedPixels(GenImageColor(texture.width, texture.height, RED));
+    }
+
+    static size_t area(const std::vector<Rectangle>& rects) {
+        size_t total = 0;
+        for (const auto& rect : rects)
+            total += static_cast<size_t>(rect.width * rect.height);
+        return total;
+    }
+
+    // Every set tile covered exactly once, nothing else covered
+    static void expectExactCover(const std::vector<uint8_t>& dirty, int tilesX, int tilesY) {
+        std::vector<int> covered(dirty.size(), 0);
+        for (const auto& rect : UploadScheduler::mergeTiles(dirty, tilesX, tilesY)) {
+            for (int y = static_cast<int>(rect.y); y < static_cast<int>(rect.y + rect.height); ++y)
+                for (int x = static_cast<int>(rect.x); x < static_cast<int>(rect.x + rect.width); ++x)
+                    covered[static_cast<size_t>(y) * tilesX + x]++;
+        }
+        for (size_t i = 0; i < dirty.size(); ++i)
+            ASSERT_EQ(covered[i], dirty[i] ? 1 : 0) << "tile " << i;
+    }
+};
+
+TEST_F(UploadSchedulerTest, MergesAdjacentTilesIntoRectangles) {
+    // Everything dirty is one rect
+    std::vector<uint8_t> full(6 * 4, 1);
+    auto rects = UploadScheduler::mergeTiles(full, 6, 4);
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_EQ(rects[0].width, 6);
+    EXPECT_EQ(rects[0].height, 4);
+
+    // An L: a 3x2 block with a 1x2 leg below its left edge
+    std::vector<uint8_t> shape = {
+        1, 1, 1, 0,
+        1, 1, 1, 0,
+        1, 0, 0, 0,
+        1, 0, 0, 0,
+    };
+    rects = UploadScheduler::mergeTiles(shape, 4, 4);
+    EXPECT_EQ(rects.size(), 2u);
+    EXPECT_EQ(area(rects), 8u);
+    expectExactCover(shape, 4, 4);
+
+    // Disjoint islands stay apart
+    std::vector<uint8_t> islands = {
+        1, 0, 0, 1,
+        0, 0, 0, 0,
+        0, 1, 1, 0,
+    };
+    rects = UploadScheduler::mergeTiles(islands, 4, 3);
+    EXPECT_EQ(rects.size(), 3u);
+    expectExactCover(islands, 4, 3);
+
+    EXPECT_TRUE(UploadScheduler::mergeTiles(std::vector<uint8_t>(12, 0), 4, 3).empty());
+}
+
+TEST_F(UploadSchedulerTest, RandomMasksAreCoveredExactly) {
+    unsigned seed = 12345;
+    for (int round = 0; round < 50; ++round) {
+        const int tilesX = 1 + round % 9;
+        const int tilesY = 1 + round % 7;
+        std::vector<uint8_t> dirty(static_cast<size_t>(tilesX) * tilesY);
+        for (auto& flag : dirty) {
+            seed = seed * 1103515245u + 12345u;
+            flag = (seed >> 16) % 3 != 0;
+        }
+        expectExactCover(dirty, tilesX, tilesY);
+    }
+}
+
+TEST_F(UploadSchedulerTest, RepeatedSubmissionsCollapse) {
+    UploadScheduler scheduler;
+    const Texture2D texture = fakeTexture(7, 256, 256);
+    for (int i = 0; i < 10; ++i)
+        scheduler.submit(texture, pixelsFor(texture), Rectangle{10, 10, 20, 20});
+
+    EXPECT_TRUE(scheduler.hasPending(7));
+    EXPECT_EQ(scheduler.getPendingBytes(), 64u * 64u * 4u);   // One tile
+
+    const auto stats = scheduler.update(UploadScheduler::Budget{});
+    EXPECT_EQ(stats.uploads, 1u);
+    EXPECT_EQ(stats.bytes, 64u * 64u * 4u);
+    EXPECT_FALSE(scheduler.hasPending(7));
+    EXPECT_TRUE(scheduler.isIdle());
+}
+
+TEST_F(UploadSchedulerTest, LargeRegionsStreamInOverSeveralFrames) {
+    UploadScheduler scheduler;
+    const Texture2D texture = fakeTexture(3, 512, 512);
+    scheduler.submit(texture, pixelsFor(texture), Rectangle{0, 0, 512, 512});
+
+    // Two rows of tiles fit the budget per frame, 512 / 64 = 8 rows to go
+    UploadScheduler::Budget budget;
+    budget.bytes = 2 * 512 * 64 * 4;
+    budget.time = std::chrono::seconds(10);
+
+    int frames = 0;
+    while (scheduler.hasPending(3)) {
+        const auto stats = scheduler.update(budget);
+        EXPECT_EQ(stats.bytes, budget.bytes);
+        ASSERT_LT(++frames, 10);
+    }
+    EXPECT_EQ(frames, 4);
+
+    // A budget too small for anything still moves one band per frame
+    scheduler.submit(texture, pixelsFor(texture), Rectangle{0, 0, 512, 512});
+    budget.bytes = 1;
+    EXPECT_EQ(scheduler.update(budget).bytes, 512u * 64u * 4u);
+    EXPECT_TRUE(scheduler.hasPending(3));
+}
+
+TEST_F(UploadSchedulerTest, VisibleRegionsGoFirst) {
+    UploadScheduler scheduler;
+    UploadScheduler::Budget budget;
+    budget.bytes = 1;   // One rect per frame
+    budget.time = std::chrono::seconds(10);
+
+    // Ids run against the expected order so the id tie-break cannot explain it
+    const Texture2D far = fakeTexture(21, 1024, 1024);
+    const Texture2D near = fakeTexture(22, 1024, 1024);
+    const Texture2D onScreen = fakeTexture(23, 1024, 1024);
+    scheduler.submit(far, pixelsFor(far), Rectangle{960, 960, 32, 32});
+    scheduler.submit(near, pixelsFor(near), Rectangle{128, 0, 32, 32});
+    scheduler.submit(onScreen, pixelsFor(onScreen), Rectangle{0, 0, 32, 32});
+    const Rectangle view = {0, 0, 64, 64};
+    const std::unordered_map<unsigned, Rectangle> visible = {{21u, view}, {22u, view}, {23u, view}};
+
+    scheduler.update(budget, visible);
+    EXPECT_FALSE(scheduler.hasPending(23));
+    EXPECT_TRUE(scheduler.hasPending(22));
+    scheduler.update(budget, visible);
+    EXPECT_FALSE(scheduler.hasPending(22));
+    EXPECT_TRUE(scheduler.hasPending(21));
+    scheduler.update(budget, visible);
+    EXPECT_TRUE(scheduler.isIdle());
+}
+
+TEST_F(UploadSchedulerTest, FlushAndDiscard) {
+    UploadScheduler scheduler;
+    const Texture2D a = fakeTexture(1, 300, 200);
+    const Texture2D b = fakeTexture(2, 300, 200);
+    scheduler.submit(a, pixelsFor(a), Rectangle{250, 150, 100, 100});   // Clipped to the texture
+    scheduler.submit(b, pixelsFor(b), Rectangle{0, 0, 300, 200});
+
+    scheduler.flush(1);
+    EXPECT_FALSE(scheduler.hasPending(1));
+    EXPECT_TRUE(scheduler.hasPending(2));
+
+    scheduler.discard(2);
+    EXPECT_TRUE(scheduler.isIdle());
+    EXPECT_EQ(scheduler.update(UploadScheduler::Budget{}).uploads, 0u);
+
+    // Pixels that do not match the texture are refused
+    scheduler.submit(a, makeSharedPixels(GenImageColor(10, 10, RED)), Rectangle{0, 0, 10, 10});
+    scheduler.submit(fakeTexture(0, 300, 200), pixelsFor(a), Rectangle{0, 0, 10, 10});
+    EXPECT_TRUE(scheduler.isIdle());
+}
+
+TEST_F(UploadSchedulerTest, SubmitFromManyThreads) {
+    UploadScheduler scheduler;
+    const Texture2D texture = fakeTexture(5, 1024, 1024);
+    std::atomic<size_t> finished{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&scheduler, &texture, &finished, t]() {
+            auto pixels = pixelsFor(texture);
+            for (int i = 0; i < 64; ++i)
+                scheduler.submit(texture, pixels, Rectangle{static_cast<float>((i % 16) * 64), static_cast<float>(t * 256 + (i / 16) * 64), 64, 64});
+            finished++;
+        });
+    }
+    // The main thread keeps uploading while producers run
+    while (finished.load() < threads.size())
+        scheduler.update(UploadScheduler::Budget{});
+    for (auto& thread : threads)
+        thread.join();
+
+    scheduler.update(UploadScheduler::Budget{});
+    EXPECT_TRUE(scheduler.isIdle());
+}
+
+} // namespace EpiGimp